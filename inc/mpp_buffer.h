@@ -57,6 +57,10 @@
  *    mpp_buffer_inc_ref
  *    mpp_buffer_commit
  *    mpp_buffer_info_get
+ *    mpp_buffer_map
+ *    mpp_buffer_unmap
+ *    mpp_buffer_sync_begin
+ *    mpp_buffer_sync_end
  *
  * 2. user buffer working flow control abstraction.
  *    buffer should attach to certain group, and buffer mode control the buffer usage flow.
@@ -78,6 +82,8 @@
  */
 typedef void* MppBuffer;
 typedef void* MppBufferGroup;
+/* meta data handle attached on MppFrame / MppPacket */
+typedef void* MppMeta;
 
 /*
  * mpp buffer group support two work flow mode:
@@ -153,6 +159,17 @@ typedef enum {
     MPP_BUFFER_TYPE_BUTT,
 } MppBufferType;
 
+/*
+ * MppBufferType can be ORed with flags on mpp_buffer_group_get
+ *
+ * MPP_BUFFER_FLAGS_CACHABLE - ion / drm buffer is allocated with cacheable cpu mapping.
+ *                             cpu access must be bracketed by mpp_buffer_sync_begin /
+ *                             mpp_buffer_sync_end for cache maintenance.
+ */
+#define MPP_BUFFER_TYPE_MASK            (0x0000FFFF)
+#define MPP_BUFFER_FLAGS_MASK           (0xFFFF0000)
+#define MPP_BUFFER_FLAGS_CACHABLE       (0x00010000)
+
 /*
  * MppBufferInfo variable's meaning is different in different MppBufferType
  *
@@ -228,6 +245,51 @@ typedef struct MppBufferInfo_t {
 #define mpp_buffer_inc_ref(buffer) \
         mpp_buffer_inc_ref_with_caller(buffer, __FUNCTION__);
 
+/*
+ * mpp_buffer_map / mpp_buffer_unmap usage:
+ *
+ * Buffer allocated by mpp is only accessed by hardware in most cases. So ion / drm buffer
+ * is allocated without cpu mapping and it is mapped on the first mpp_buffer_get_ptr /
+ * mpp_buffer_read / mpp_buffer_write call. mpp_buffer_map creates the mapping in advance
+ * and mpp_buffer_unmap removes it when cpu access is finished. Normal buffer is always
+ * mapped and imported buffer keeps its mapping, unmap on them does nothing.
+ * NOTE: MppBufferInfo from mpp_buffer_info_get may have NULL ptr on unmapped buffer.
+ */
+#define mpp_buffer_map(buffer) \
+        mpp_buffer_map_with_caller(buffer, __FUNCTION__)
+
+#define mpp_buffer_unmap(buffer) \
+        mpp_buffer_unmap_with_caller(buffer, __FUNCTION__)
+
+/*
+ * mpp_buffer_sync_begin / mpp_buffer_sync_end usage:
+ *
+ * Cpu access to a buffer shared with hardware is bracketed by sync_begin and sync_end.
+ * sync_begin invalidates cpu cache for data written by hardware and sync_end flushes cpu
+ * writes out for hardware. ro variant is for read only access which skips the flush.
+ * partial variant only maintains [offset, offset + size) when the kernel supports it,
+ * otherwise the whole buffer is synced. size 0 means to the end of buffer.
+ * Normal buffer is always coherent and sync does nothing.
+ * mpp_buffer_read / mpp_buffer_write sync their own range on cacheable buffer.
+ */
+#define mpp_buffer_sync_begin(buffer) \
+        mpp_buffer_sync_begin_with_caller(buffer, 0, 0, 0, __FUNCTION__)
+
+#define mpp_buffer_sync_end(buffer) \
+        mpp_buffer_sync_end_with_caller(buffer, 0, 0, 0, __FUNCTION__)
+
+#define mpp_buffer_sync_ro_begin(buffer) \
+        mpp_buffer_sync_begin_with_caller(buffer, 1, 0, 0, __FUNCTION__)
+
+#define mpp_buffer_sync_ro_end(buffer) \
+        mpp_buffer_sync_end_with_caller(buffer, 1, 0, 0, __FUNCTION__)
+
+#define mpp_buffer_sync_partial_begin(buffer, ro, offset, size) \
+        mpp_buffer_sync_begin_with_caller(buffer, ro, offset, size, __FUNCTION__)
+
+#define mpp_buffer_sync_partial_end(buffer, ro, offset, size) \
+        mpp_buffer_sync_end_with_caller(buffer, ro, offset, size, __FUNCTION__)
+
 #define mpp_buffer_group_get_internal(group, type, ...) \
         mpp_buffer_group_get(group, type, MPP_BUFFER_INTERNAL, MODULE_TAG, __FUNCTION__)
 
@@ -253,6 +315,12 @@ MPP_RET mpp_buffer_get_with_tag(MppBufferGroup group, MppBuffer *buffer, size_t
                                 const char *tag, const char *caller);
 MPP_RET mpp_buffer_put_with_caller(MppBuffer buffer, const char *caller);
 MPP_RET mpp_buffer_inc_ref_with_caller(MppBuffer buffer, const char *caller);
+MPP_RET mpp_buffer_map_with_caller(MppBuffer buffer, const char *caller);
+MPP_RET mpp_buffer_unmap_with_caller(MppBuffer buffer, const char *caller);
+MPP_RET mpp_buffer_sync_begin_with_caller(MppBuffer buffer, RK_U32 ro, size_t offset,
+                                          size_t size, const char *caller);
+MPP_RET mpp_buffer_sync_end_with_caller(MppBuffer buffer, RK_U32 ro, size_t offset,
+                                        size_t size, const char *caller);
 
 MPP_RET mpp_buffer_info_get(MppBuffer buffer, MppBufferInfo *info);
 MPP_RET mpp_buffer_read(MppBuffer buffer, size_t offset, void *data, size_t size);
@@ -268,6 +336,8 @@ MPP_RET mpp_buffer_group_clear(MppBufferGroup group);
 RK_S32  mpp_buffer_group_unused(MppBufferGroup group);
 MppBufferMode mpp_buffer_group_mode(MppBufferGroup group);
 MppBufferType mpp_buffer_group_type(MppBufferGroup group);
+/* total size of buffers with and without cpu mapping in group */
+MPP_RET mpp_buffer_group_usage(MppBufferGroup group, size_t *mapped, size_t *unmapped);
 
 /*
  * size  : 0 - no limit, other - max buffer size
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_ENC_ROI_UTILS_H__
+#define __MPP_ENC_ROI_UTILS_H__
+
+#include "rk_mpi.h"
+
+/*
+ * software helper to generate MppEncROICfg qp_map for encoder input
+ *
+ * motion map:
+ * Each input luma plane is compared to the previous one on 2x2 averaged
+ * macroblocks. A macroblock with mean absolute difference over threshold is
+ * moving and stays active for hold frames after the motion stops. Active
+ * macroblocks and their neighbours get fg_qp_delta and the static background
+ * gets bg_qp_delta.
+ *
+ * mask map:
+ * A macroblock with a quarter or more of its pixels set in the saliency mask
+ * gets fg_qp_delta and the others get bg_qp_delta.
+ */
+typedef void* MppEncRoiMotion;
+
+typedef struct MppEncRoiMotionCfg_t {
+    RK_S32  width;
+    RK_S32  height;
+    RK_S32  hor_stride;
+    RK_S32  threshold;      /* mean absolute difference per pixel, 0 for default 3 */
+    RK_S32  hold;           /* frame count, 0 for default 8 */
+    RK_S32  fg_qp_delta;
+    RK_S32  bg_qp_delta;
+} MppEncRoiMotionCfg;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_enc_roi_motion_init(MppEncRoiMotion *ctx, MppEncRoiMotionCfg *cfg);
+MPP_RET mpp_enc_roi_motion_deinit(MppEncRoiMotion ctx);
+/* qp_map size is ((width + 15) / 16) * ((height + 15) / 16) */
+MPP_RET mpp_enc_roi_motion_proc(MppEncRoiMotion ctx, RK_U8 *luma, RK_S8 *qp_map);
+
+MPP_RET mpp_enc_roi_mask_to_map(RK_U8 *mask, RK_S32 width, RK_S32 height, RK_S32 stride,
+                                RK_S32 fg_qp_delta, RK_S32 bg_qp_delta, RK_S8 *qp_map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_ENC_ROI_UTILS_H__*/
@@ -223,6 +223,12 @@ void    mpp_frame_set_info_change(MppFrame frame, RK_U32 info_change);
 MppBuffer mpp_frame_get_buffer(const MppFrame frame);
 void    mpp_frame_set_buffer(MppFrame frame, MppBuffer buffer);
 
+/*
+ * meta data parameter
+ * NULL when no meta data is attached, released with the frame
+ */
+MppMeta mpp_frame_get_meta(const MppFrame frame);
+
 /*
  * color related parameter
  */
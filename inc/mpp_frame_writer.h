@@ -0,0 +1,84 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_FRAME_WRITER_H__
+#define __MPP_FRAME_WRITER_H__
+
+#include <stdio.h>
+
+#include "mpp_frame.h"
+
+/*
+ * raw frame writer for test tools
+ *
+ * Only the visible width x height of each plane is written, without stride
+ * and height padding, in the plane order of the MppFrameFormat. A plane with
+ * no padding in its rows goes out as one region. Regions are written with
+ * vectored writes where the os has them.
+ *
+ * hor_stride is in bytes as the decoders set it. For packed yuv and rgb a
+ * hor_stride below the row size is taken as pixels.
+ *
+ * The checksum modes hash the same bytes the raw mode writes and print one
+ * line per frame to the file when there is one, so a checksum matches the
+ * md5sum / crc32 of the frame in a raw dump.
+ *
+ * With async set the frames are written on a writer thread. Put takes a
+ * reference on the frame buffer and blocks when queue_depth frames are
+ * pending, so the decoder gets its buffers back at the writer speed.
+ */
+typedef void* MppFrameWriter;
+
+typedef enum MppFrameWriterMode_e {
+    MPP_FRAME_WRITER_RAW,
+    MPP_FRAME_WRITER_MD5,
+    MPP_FRAME_WRITER_CRC32,
+    MPP_FRAME_WRITER_BUTT,
+} MppFrameWriterMode;
+
+typedef struct MppFrameWriterCfg_t {
+    MppFrameWriterMode  mode;
+    FILE                *fp;            /* NULL only for checksum modes */
+    RK_U32              async;
+    RK_U32              queue_depth;    /* 0 for default 4 */
+} MppFrameWriterCfg;
+
+typedef struct MppFrameWriterStat_t {
+    RK_U32              frames;
+    RK_U64              bytes;
+    /* us spent in write or checksum */
+    RK_S64              time;
+} MppFrameWriterStat;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_frame_writer_init(MppFrameWriter *writer, MppFrameWriterCfg *cfg);
+/* flushes the pending frames */
+MPP_RET mpp_frame_writer_deinit(MppFrameWriter writer);
+/* frame without buffer is skipped */
+MPP_RET mpp_frame_writer_put(MppFrameWriter writer, MppFrame frame);
+MPP_RET mpp_frame_writer_get_stat(MppFrameWriter writer, MppFrameWriterStat *stat);
+
+/* one frame raw write in caller thread */
+MPP_RET mpp_frame_writer_dump(MppFrame frame, FILE *fp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_FRAME_WRITER_H__*/
@@ -66,10 +66,13 @@ typedef enum MppMetaKey_e {
     MPP_META_KEY_OUTPUT_BLOCK   = 'oblk',
     MPP_META_KEY_INPUT_IDR_REQ  = 'iidr',   /* input idr frame request flag */
     MPP_META_KEY_OUTPUT_INTRA   = 'oidr',   /* output intra frame indicator */
+    MPP_META_KEY_OUTPUT_SCENE   = 'oscn',   /* output MppEncSceneType of the input frame */
+    MPP_META_KEY_INPUT_ROI      = 'iroi',   /* input MppEncROICfg pointer for encoder */
+    MPP_META_KEY_OUTPUT_SEI     = 'osei',   /* output MppPacket of subscribed sei payload on decoder frame */
+    MPP_META_KEY_OUTPUT_NAL     = 'onal',   /* output MppPacket of MppEncNalInfo on encoder packet */
+    MPP_META_KEY_OUTPUT_NAL_FMT = 'onfm',   /* output MppEncNalFormat of encoder packet */
 } MppMetaKey;
 
-typedef void* MppMeta;
-
 #define mpp_meta_get(meta) mpp_meta_get_with_tag(meta, MODULE_TAG, __FUNCTION__)
 
 #ifdef __cplusplus
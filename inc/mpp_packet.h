@@ -68,9 +68,23 @@ MPP_RET mpp_packet_set_eos(MppPacket packet);
 RK_U32  mpp_packet_get_eos(MppPacket packet);
 MPP_RET mpp_packet_set_extra_data(MppPacket packet);
 
+/*
+ * encoder slice output, see MppEncSliceCfg
+ * partition    - packet holds part of a frame
+ * eoi          - packet holds the end of a frame
+ */
+RK_U32  mpp_packet_is_partition(const MppPacket packet);
+RK_U32  mpp_packet_is_eoi(const MppPacket packet);
+
 void        mpp_packet_set_buffer(MppPacket packet, MppBuffer buffer);
 MppBuffer   mpp_packet_get_buffer(const MppPacket packet);
 
+/*
+ * meta data parameter
+ * NULL when no meta data is attached, released with the packet
+ */
+MppMeta     mpp_packet_get_meta(const MppPacket packet);
+
 /*
  * data access interface
  */
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_STREAM_READER_H__
+#define __MPP_STREAM_READER_H__
+
+#include "rk_mpi.h"
+
+/*
+ * elementary stream reader for test tools
+ *
+ * The input file is mapped once and the packets point into the mapping, so
+ * no stream data is copied between file and decoder. A packet stays valid
+ * until the reader is deinit.
+ *
+ * Frame mode hands out one access unit per packet. The frame boundaries are
+ * indexed on a scan thread started by init and get_packet only waits when it
+ * runs ahead of the scan. Start code streams (h.264, h.265, mpeg2, mpeg4,
+ * h.263, avs) are split at the first unit of a new picture, vp8 and vp9 need
+ * an ivf file and mjpeg is split at each SOI after an EOI. Other codings fall
+ * back to chunk mode.
+ *
+ * Chunk mode cuts the file into chunk_size packets. Random mode cuts packets
+ * of 1 to chunk_size bytes from a seeded generator, so a parser failure seen
+ * with one seed can be replayed.
+ *
+ * The last packet has eos set. After it get_packet returns empty eos packets.
+ */
+typedef void* MppStreamReader;
+
+typedef enum MppStreamReaderMode_e {
+    MPP_STREAM_READER_CHUNK,
+    MPP_STREAM_READER_FRAME,
+    MPP_STREAM_READER_RANDOM,
+    MPP_STREAM_READER_BUTT,
+} MppStreamReaderMode;
+
+typedef struct MppStreamReaderCfg_t {
+    MppStreamReaderMode mode;
+    MppCodingType       coding;         /* for frame mode */
+    RK_U32              chunk_size;     /* 0 for default 64K */
+    RK_U32              seed;           /* for random mode */
+} MppStreamReaderCfg;
+
+typedef struct MppStreamReaderStat_t {
+    RK_U64              size;
+    /* frames indexed by frame mode, 0 in other modes */
+    RK_U32              frames;
+    /* us spent on the frame index scan */
+    RK_S64              index_time;
+    /* us get_packet waited for the scan */
+    RK_S64              wait_time;
+} MppStreamReaderStat;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_stream_reader_init(MppStreamReader *reader, const char *path,
+                               MppStreamReaderCfg *cfg);
+MPP_RET mpp_stream_reader_deinit(MppStreamReader reader);
+/* packet is new for each call and released by caller with mpp_packet_deinit */
+MPP_RET mpp_stream_reader_get_packet(MppStreamReader reader, MppPacket *packet);
+/* mode in use, frame mode falls back to chunk mode on unsupported stream */
+MppStreamReaderMode mpp_stream_reader_get_mode(MppStreamReader reader);
+/* restart from the file begin, random mode restarts its seed */
+MPP_RET mpp_stream_reader_rewind(MppStreamReader reader);
+/* waits for the frame index scan to finish */
+MPP_RET mpp_stream_reader_get_stat(MppStreamReader reader, MppStreamReaderStat *stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_STREAM_READER_H__*/
@@ -58,6 +58,19 @@ typedef enum {
     MPP_PORT_BUTT,
 } MppPortType;
 
+/*
+ * Port poll timeout for waiting a task on the port
+ *
+ * MPP_POLL_BLOCK       - wait until a task is ready
+ * MPP_POLL_NON_BLOCK   - only check task status
+ * positive value       - wait timeout in millisecond
+ */
+typedef enum {
+    MPP_POLL_BLOCK      = -1,
+    MPP_POLL_NON_BLOCK  = 0,
+    MPP_POLL_MAX        = 8000,
+} MppPollType;
+
 /*
  * Advance task work flow mode:
  ******************************************************************************
@@ -220,6 +233,8 @@ MPP_RET mpp_task_queue_deinit(MppTaskQueue queue);
 MppPort mpp_task_queue_get_port(MppTaskQueue queue, MppPortType type);
 
 MPP_RET mpp_port_can_dequeue(MppPort port);
+/* wait task ready on port, return MPP_OK when a task can be dequeued */
+MPP_RET mpp_port_poll(MppPort port, MppPollType timeout);
 MPP_RET mpp_port_dequeue(MppPort port, MppTask *task);
 MPP_RET mpp_port_enqueue(MppPort port, MppTask task);
 
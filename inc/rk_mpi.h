@@ -84,6 +84,7 @@ typedef enum {
     MPP_ENABLE_DEINTERLACE,
     MPP_SET_INPUT_BLOCK,
     MPP_SET_OUTPUT_BLOCK,
+    MPP_SET_THREAD_CFG,                 /* MppThreadCfg, need to setup before init */
     MPP_CMD_END,
 
     MPP_CODEC_CMD_BASE                  = CMD_MODULE_CODEC,
@@ -101,6 +102,9 @@ typedef enum {
     MPP_DEC_GET_VPUMEM_USED_COUNT,
     MPP_DEC_SET_VC1_EXTRA_DATA,
     MPP_DEC_SET_OUTPUT_FORMAT,
+    MPP_DEC_SET_FRAME_PREALLOC,         /* RK_U32 MppDecPreAlloc mode, need to setup before init */
+    MPP_DEC_SET_SKIP_MODE,              /* MppDecSkipCfg picture skip policy, can be changed on decoding */
+    MPP_DEC_SET_SEI_MASK,               /* RK_U32 MppDecSeiType mask of sei exported on frame, can be changed on decoding */
     MPP_DEC_CMD_END,
 
     MPP_ENC_CMD_BASE                    = CMD_MODULE_CODEC | CMD_CTX_ID_ENC,
@@ -110,6 +114,14 @@ typedef enum {
     MPP_ENC_GET_EXTRA_INFO,
     MPP_ENC_SET_FORMAT,
     MPP_ENC_SET_IDR_FRAME,
+    MPP_ENC_SET_RC_LOOKAHEAD,           /* RK_S32 lookahead depth in frame, need to setup before init */
+    MPP_ENC_SET_SCENE_CFG,              /* MppEncSceneCfg scene change detection and adaptive idr */
+    MPP_ENC_GET_SCENE_CFG,
+    MPP_ENC_GET_SCENE_INFO,             /* MppEncSceneInfo of the last encoded frame */
+    MPP_ENC_SET_NAL_CFG,                /* MppEncNalCfg nal unit index and format of output packet */
+    MPP_ENC_GET_NAL_CFG,
+    MPP_ENC_SET_SLICE_CFG,              /* MppEncSliceCfg, before init */
+    MPP_ENC_GET_SLICE_CFG,
     MPP_ENC_CMD_END,
 
     MPP_ISP_CMD_BASE                    = CMD_MODULE_CODEC | CMD_CTX_ID_ISP,
@@ -124,6 +136,215 @@ typedef enum {
 typedef void* MppCtx;
 typedef void* MppParam;
 
+/*
+ * decoder frame buffer pre-allocation mode
+ *
+ * Works on the internal frame buffer group only. When a new sequence header
+ * or a frame with new buffer size is found the frame buffers of the new size
+ * are allocated on a separate thread while the parser goes on.
+ *
+ * DISABLE      - frame buffer is allocated on first use in parser thread
+ * REPLACE      - unused buffers in the old size are released on size change
+ * KEEP         - buffers in the current and the previous size are both kept
+ *                so that adaptive streaming switching back and forth between
+ *                two resolutions does not allocate again
+ */
+typedef enum MppDecPreAlloc_e {
+    MPP_DEC_PREALLOC_DISABLE,
+    MPP_DEC_PREALLOC_REPLACE,
+    MPP_DEC_PREALLOC_KEEP,
+    MPP_DEC_PREALLOC_BUTT,
+} MppDecPreAlloc;
+
+/*
+ * decoder picture skip mode for thumbnail and fast scrubbing
+ *
+ * Skipped pictures are dropped by parser and never sent to hardware. Only the
+ * pictures that no decoded picture depends on are dropped. When a mode change
+ * may need a dropped reference picture decoder waits for next key picture.
+ *
+ * NONE         - decode all pictures
+ * NON_REF      - skip pictures which are not used for reference
+ * NON_KEY      - decode key pictures only, IDR / IRAP / I / key frame
+ * TEMPORAL     - decode pictures in temporal layer 0 ~ max_tid only
+ *
+ * Supported by H.264 / H.265 / VP9 / MPEG-2 decoder. H.264 / VP9 / MPEG-2
+ * have no temporal layer id in stream, reference pictures are taken as layer
+ * 0 and non-reference pictures as layer 1. VP9 inter frame is always taken as
+ * reference for its motion vector and probability context are used by next
+ * frame.
+ */
+typedef enum MppDecSkipMode_e {
+    MPP_DEC_SKIP_NONE,
+    MPP_DEC_SKIP_NON_REF,
+    MPP_DEC_SKIP_NON_KEY,
+    MPP_DEC_SKIP_TEMPORAL,
+    MPP_DEC_SKIP_BUTT,
+} MppDecSkipMode;
+
+/*
+ * decoder picture skip configure for MPP_DEC_SET_SKIP_MODE
+ *
+ * mode         - MppDecSkipMode
+ * key_interval - NON_KEY mode only, decode one of every key_interval key
+ *                pictures, 0 and 1 for all key pictures
+ * max_tid      - TEMPORAL mode only, max temporal layer id to decode. On
+ *                dyadic hierarchy with n layers one of every 2^(n - 1 - max_tid)
+ *                pictures is decoded
+ */
+typedef struct MppDecSkipCfg_t {
+    RK_U32          mode;
+    RK_U32          key_interval;
+    RK_U32          max_tid;
+} MppDecSkipCfg;
+
+/*
+ * decoder sei payload subscription for MPP_DEC_SET_SEI_MASK
+ *
+ * Payloads of the subscribed types are exported on the output frame as a
+ * MppPacket in frame meta with key MPP_META_KEY_OUTPUT_SEI. Sei messages of
+ * other types are skipped by payload size except the ones decoder itself
+ * needs. Nothing is exported by default.
+ *
+ * The packet data is the payloads of one picture back to back in bitstream
+ * order. Each one starts with a MppDecSeiHead followed by payload_size bytes
+ * of payload with emulation prevention bytes removed, then padded to 4 bytes.
+ *
+ * Supported by H.264 / H.265 decoder.
+ */
+typedef enum MppDecSeiType_e {
+    MPP_DEC_SEI_USER_DATA_REG           = (1 << 0),     /* user_data_registered_itu_t_t35, closed caption / hdr10+ */
+    MPP_DEC_SEI_USER_DATA_UNREG         = (1 << 1),     /* user_data_unregistered */
+    MPP_DEC_SEI_MASTERING_DISPLAY       = (1 << 2),     /* mastering_display_colour_volume */
+    MPP_DEC_SEI_CONTENT_LIGHT           = (1 << 3),     /* content_light_level_info */
+    MPP_DEC_SEI_ALL                     = (0x0000000f),
+} MppDecSeiType;
+
+typedef struct MppDecSeiHead_t {
+    RK_U32          payload_type;       /* sei payloadType in bitstream */
+    RK_U32          payload_size;
+} MppDecSeiHead;
+
+/*
+ * worker thread of mpp context
+ *
+ * CODEC        - decoder parser thread / encoder control thread
+ * HAL          - decoder hardware wait thread
+ * ALLOC        - decoder frame buffer pre-allocation thread
+ * LOOKAHEAD    - encoder rate control lookahead analysis thread
+ * BUTT         - all threads above
+ *
+ * Env mpp_thread_cpu_mask / mpp_thread_sched / mpp_thread_prio override the
+ * config of all mpp threads including the async log thread.
+ */
+typedef enum MppThreadId_e {
+    MPP_THREAD_CODEC,
+    MPP_THREAD_HAL,
+    MPP_THREAD_ALLOC,
+    MPP_THREAD_LOOKAHEAD,
+    MPP_THREAD_BUTT,
+} MppThreadId;
+
+typedef enum MppThreadSched_e {
+    MPP_THREAD_SCHED_DEFAULT,           /* inherit from the thread calling init */
+    MPP_THREAD_SCHED_NORMAL,            /* normal policy with priority as nice value -20 ~ 19 */
+    MPP_THREAD_SCHED_FIFO,              /* realtime fifo policy with priority 1 ~ 99 */
+    MPP_THREAD_SCHED_BUTT,
+} MppThreadSched;
+
+/*
+ * worker thread configure for MPP_SET_THREAD_CFG
+ *
+ * id           - MppThreadId
+ * cpu_mask     - bit n for cpu n, 0 keeps the inherited affinity
+ * sched        - MppThreadSched
+ * priority     - nice value or realtime priority depending on sched
+ * name         - thread name, empty keeps the default name
+ */
+typedef struct MppThreadCfg_t {
+    RK_U32          id;
+    RK_U32          cpu_mask;
+    RK_U32          sched;
+    RK_S32          priority;
+    char            name[16];
+} MppThreadCfg;
+
+/*
+ * decoder parser stall reason, parser thread waits for
+ *
+ * TASK         - idle hal task
+ * PACKET       - input packet from user
+ * PKT_SLOT     - unused packet slot
+ * PKT_BUF      - hardware stream buffer
+ * PREV_TASK    - previous hardware task done
+ * INFO_CHANGE  - info change ready from user
+ * FRAME_BUF    - unused frame buffer
+ */
+typedef enum MppStallReason_e {
+    MPP_STALL_TASK,
+    MPP_STALL_PACKET,
+    MPP_STALL_PKT_SLOT,
+    MPP_STALL_PKT_BUF,
+    MPP_STALL_PREV_TASK,
+    MPP_STALL_INFO_CHANGE,
+    MPP_STALL_FRAME_BUF,
+    MPP_STALL_BUTT,
+} MppStallReason;
+
+/*
+ * runtime statistic snapshot of one mpp context
+ *
+ * All values are maintained by atomic operation or single word store and
+ * read without taking any list / slot / buffer lock. Different values may
+ * come from slightly different moment.
+ * Slot / task / stall values are for decoder only.
+ */
+typedef struct MppStats_t {
+    /* data flow counter */
+    RK_U64          packet_put;         /* packets put by user */
+    RK_U64          packet_get;         /* packets taken by parser / got by user */
+    RK_U64          frame_put;          /* frames put to output list / by user */
+    RK_U64          frame_get;          /* frames got by user / taken by encoder */
+    RK_U64          stream_bytes;       /* input stream bytes consumed by parser */
+
+    /* current and peak node count of packet / frame list */
+    RK_S32          packet_depth;
+    RK_S32          packet_depth_peak;
+    RK_S32          frame_depth;
+    RK_S32          frame_depth_peak;
+
+    /* hal task count sent / finished and task count on each status */
+    RK_U64          task_put;
+    RK_U64          task_get;
+    RK_S32          task_idle;
+    RK_S32          task_processing;
+    RK_S32          task_done;
+
+    /* frame slot count and slot count on each status flag */
+    RK_S32          slot_count;
+    RK_S32          slot_on_used;
+    RK_S32          slot_not_ready;
+    RK_S32          slot_codec_use;
+    RK_S32          slot_hal_output;
+    RK_S32          slot_hal_input;
+    RK_S32          slot_queue_use;
+    RK_S32          slot_has_buffer;
+
+    /* frame buffer group */
+    RK_S32          buffer_count;
+    RK_S32          buffer_used;
+    RK_U64          buffer_size;
+
+    /* output frame event counter */
+    RK_U32          info_change_count;
+    RK_U32          error_count;
+    RK_U32          discard_count;
+
+    /* bit mask of MppStallReason parser is waiting and stall count of each reason */
+    RK_U32          stall_current;
+    RK_U64          stall_count[MPP_STALL_BUTT];
+} MppStats;
+
 /*
  * in decoder mode application need to specify the coding type first
  * send a stream header to mpi ctx using parameter data / size
@@ -186,6 +407,157 @@ typedef struct MppEncConfig_t {
     RK_S32  cabac_en;
 } MppEncConfig;
 
+/*
+ * scene change detection parameter
+ *
+ * enable       - 0 - disable
+ *                1 - detect scene cut and fade on input frame and insert idr
+ *                    frame on scene cut
+ * gop_min      - min frame distance from last intra frame to a scene cut idr
+ *                0 for no limit
+ * gop_max      - max frame distance between intra frames
+ *                0 for gop in MppEncConfig
+ * sensitivity  - scene cut detection sensitivity 1 ~ 100, higher value
+ *                detects more scene cut, 0 for default 50
+ */
+typedef struct MppEncSceneCfg_t {
+    RK_S32  enable;
+    RK_S32  gop_min;
+    RK_S32  gop_max;
+    RK_S32  sensitivity;
+} MppEncSceneCfg;
+
+typedef enum MppEncSceneType_e {
+    MPP_ENC_SCENE_NORMAL,
+    MPP_ENC_SCENE_CUT,
+    MPP_ENC_SCENE_FADE,
+    MPP_ENC_SCENE_BUTT,
+} MppEncSceneType;
+
+/*
+ * scene change detection result
+ *
+ * frame_count  - input frame count analyzed
+ * scene        - MppEncSceneType of the last frame
+ * is_intra     - last frame is encoded as intra frame
+ * idr_by_scene - last frame is encoded as idr frame for scene cut
+ * hist_diff    - luma histogram distance to previous frame 0 ~ 256
+ * sad          - luma compensated mean absolute difference in Q4
+ * luma_mean    - luma mean in Q4
+ * cut_count    - total scene cut detected
+ * fade_count   - total fade frame detected
+ */
+typedef struct MppEncSceneInfo_t {
+    RK_S32  frame_count;
+    RK_S32  scene;
+    RK_S32  is_intra;
+    RK_S32  idr_by_scene;
+    RK_S32  hist_diff;
+    RK_S32  sad;
+    RK_S32  luma_mean;
+    RK_S32  cut_count;
+    RK_S32  fade_count;
+} MppEncSceneInfo;
+
+/*
+ * region of interest config of one input frame
+ *
+ * The config is attached to the input task with MPP_META_KEY_INPUT_ROI and
+ * read when the frame is encoded. It needs to be kept valid until the task is
+ * returned from the input port.
+ *
+ * qp_map       - dense qp delta map, one RK_S8 for each 16x16 macroblock in
+ *                raster order, NULL for no map
+ * number       - region count
+ * regions      - region list applied over qp_map in order
+ *
+ * region position is in pixel and extended to macroblock boundary.
+ * intra        - force intra macroblock in region
+ * abs_qp_en    - 0 - qp is delta to frame qp
+ *                1 - qp is absolute qp
+ * qp           - region qp, delta qp 0 keeps the qp from qp_map
+ */
+typedef struct MppEncROIRegion_t {
+    RK_U16  x;
+    RK_U16  y;
+    RK_U16  w;
+    RK_U16  h;
+    RK_U16  intra;
+    RK_U16  abs_qp_en;
+    RK_S16  qp;
+} MppEncROIRegion;
+
+typedef struct MppEncROICfg_t {
+    RK_S8           *qp_map;
+    RK_U32          number;
+    MppEncROIRegion *regions;
+} MppEncROICfg;
+
+/*
+ * encoder output nal unit config
+ *
+ * index_en     - 0 - disable
+ *                1 - attach nal unit index to output packet meta with key
+ *                    MPP_META_KEY_OUTPUT_NAL
+ * format       - MppEncNalFormat of nal units in output packet
+ *
+ * The nal unit index is a MppPacket whose data is an array of MppEncNalInfo,
+ * one for each nal unit of the output packet in bitstream order. It is built
+ * from the nal unit layout known by encoder without scanning the stream and
+ * is released with the output packet.
+ *
+ * When avcc format is selected each output packet carries its actual format
+ * as MPP_META_KEY_OUTPUT_NAL_FMT. A packet which can not be converted stays
+ * in annexb format.
+ *
+ * The extra info from MPP_ENC_GET_EXTRA_INFO stays in annexb format.
+ */
+typedef enum MppEncNalFormat_e {
+    MPP_ENC_NAL_FORMAT_ANNEXB,          /* nal unit starts with start code */
+    MPP_ENC_NAL_FORMAT_AVCC,            /* nal unit starts with 4 bytes big endian length */
+    MPP_ENC_NAL_FORMAT_BUTT,
+} MppEncNalFormat;
+
+typedef struct MppEncNalCfg_t {
+    RK_U32  index_en;
+    RK_U32  format;
+} MppEncNalCfg;
+
+/*
+ * offset       - nal unit start in packet, start code or length included
+ * length       - nal unit size, start code or length included
+ * header       - start code or length size in bytes
+ * type         - nal_unit_type
+ * temporal_id  - temporal layer id, 0 for H.264
+ */
+typedef struct MppEncNalInfo_t {
+    RK_U32  offset;
+    RK_U32  length;
+    RK_U8   header;
+    RK_U8   type;
+    RK_U8   temporal_id;
+    RK_U8   reserved;
+} MppEncNalInfo;
+
+/*
+ * encoder slice config
+ *
+ * mb_rows      - macroblock rows in one slice, 0 for one slice per frame
+ * split_out    - 0 - output one packet per frame
+ *                1 - output each slice in its own packet as soon as hardware
+ *                    finishes it, the packets of one frame have partition
+ *                    flag and the last one has eoi flag
+ *
+ * Slice config should be set before init. In split_out mode one output task
+ * is taken for each slice packet and nal unit index / avcc format is not
+ * applied. Hardware without slice progress report delivers the whole frame
+ * as one eoi packet.
+ */
+typedef struct MppEncSliceCfg_t {
+    RK_U32  mb_rows;
+    RK_U32  split_out;
+} MppEncSliceCfg;
+
 /*
  * mpp main work function set
  * size     : MppApi structure size
@@ -246,6 +618,12 @@ typedef struct MppApi_t {
     MPP_RET (*reset)(MppCtx ctx);
     MPP_RET (*control)(MppCtx ctx, MpiCmd cmd, MppParam param);
 
+    // runtime statistic snapshot
+    MPP_RET (*stats)(MppCtx ctx, MppStats *stats);
+
+    // wait task ready on port for advance data flow interface
+    MPP_RET (*poll)(MppCtx ctx, MppPortType type, MppPollType timeout);
+
     RK_U32 reserv[16];
 } MppApi;
 
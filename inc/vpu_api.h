@@ -85,8 +85,40 @@ typedef enum VPU_API_CMD {
     VPU_API_DEC_GETFORMAT,
     VPU_API_SET_OUTPUT_BLOCK,
     VPU_API_DEC_GET_EOS_STATUS,
+
+    VPU_API_ENC_SET_INPUT_MODE,
+    VPU_API_ENC_SET_OUTPUT_MODE,
 } VPU_API_CMD;
 
+/*
+ * encoder buffer mode set by VPU_API_ENC_SET_INPUT_MODE / VPU_API_ENC_SET_OUTPUT_MODE
+ *
+ * input mode on EncInputStream_t:
+ * VPU_API_ENC_INPUT_COPY       - buf is cpu pointer and copied to internal buffer (default)
+ * VPU_API_ENC_INPUT_FD         - bufPhyAddr is dma-buf fd and used without copy
+ * VPU_API_ENC_INPUT_MPP_BUFFER - buf is a MppBuffer and used without copy
+ *
+ * output mode on EncoderOut_t:
+ * VPU_API_ENC_OUTPUT_COPY      - stream is copied to data (default)
+ * VPU_API_ENC_OUTPUT_BORROW    - data points to internal stream buffer without copy. The
+ *                                buffer is valid until next encode / encoder_getstream call.
+ *
+ * NOTE: encode with nonzero timeUs in EncoderOut_t still takes input fd and output fd /
+ * size from timeUs as before.
+ */
+typedef enum VPU_API_ENC_INPUT_MODE {
+    VPU_API_ENC_INPUT_COPY,
+    VPU_API_ENC_INPUT_FD,
+    VPU_API_ENC_INPUT_MPP_BUFFER,
+    VPU_API_ENC_INPUT_BUTT,
+} VPU_API_ENC_INPUT_MODE;
+
+typedef enum VPU_API_ENC_OUTPUT_MODE {
+    VPU_API_ENC_OUTPUT_COPY,
+    VPU_API_ENC_OUTPUT_BORROW,
+    VPU_API_ENC_OUTPUT_BUTT,
+} VPU_API_ENC_OUTPUT_MODE;
+
 typedef struct {
     RK_U32   TimeLow;
     RK_U32   TimeHigh;
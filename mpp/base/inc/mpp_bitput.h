@@ -39,6 +39,12 @@ extern "C" {
 RK_S32 mpp_set_bitput_ctx(BitputCtx_t *bp, RK_U64 *data, RK_U32 len);
 void mpp_put_bits(BitputCtx_t *bp, RK_U64 invalue, RK_S32 lbits);
 void mpp_put_align(BitputCtx_t *bp, RK_S32 align_bits, int flag);
+/*
+ * put a fixed packet layout in one call, bits[] is the static field width
+ * table (1 ~ 63 bits, 0 for skip) and vals[] the matching field values.
+ * output is bit exact to calling mpp_put_bits for each field in order.
+ */
+void mpp_put_fields(BitputCtx_t *bp, const RK_U8 *bits, const RK_U64 *vals, RK_U32 count);
 #ifdef  __cplusplus
 }
 #endif
@@ -131,6 +131,40 @@ RK_U32  mpp_buf_slot_is_changed(MppBufSlots slots);
 MPP_RET mpp_buf_slot_ready(MppBufSlots slots);
 size_t  mpp_buf_slot_get_size(MppBufSlots slots);
 RK_S32  mpp_buf_slot_get_used_size(MppBufSlots slots);
+
+/*
+ * frame buffer size hint for pre-allocation
+ *
+ * set_hint     - called by parser on new sequence header before any frame of
+ *                the sequence is set. frame carries the codec width / height /
+ *                stride / format, count is the buffer count required by the
+ *                sequence, 0 for unknown. frame set by SLOT_FRAME with a new
+ *                buffer size also updates the hint with unknown count.
+ * get_hint     - called by mpp to get the hal aligned buffer size and count,
+ *                return hint sequence number which increases on size change
+ */
+MPP_RET mpp_buf_slot_set_hint(MppBufSlots slots, MppFrame frame, RK_S32 count);
+RK_U32  mpp_buf_slot_get_hint(MppBufSlots slots, size_t *size, RK_S32 *count);
+
+/*
+ * slot usage statistic for runtime monitoring
+ *
+ * slot count on each status flag. It is maintained on every slot operation
+ * and read by get_stats without taking the slot lock.
+ */
+typedef struct MppBufSlotStats_t {
+    RK_S32  count;
+    RK_S32  on_used;
+    RK_S32  not_ready;
+    RK_S32  codec_use;
+    RK_S32  hal_output;
+    RK_S32  hal_use;
+    RK_S32  queue_use;
+    RK_S32  has_buffer;
+} MppBufSlotStats;
+
+MPP_RET mpp_buf_slot_get_stats(MppBufSlots slots, MppBufSlotStats *stats);
+
 /*
  * called by parser
  *
@@ -57,6 +57,8 @@ struct MppBufferImpl_t {
     // used flag is for used/unused list detection
     RK_U32              used;
     RK_U32              internal;
+    // cpu mapping is cached and cpu access needs sync
+    RK_U32              cacheable;
     RK_S32              ref_count;
     struct list_head    list_status;
 };
@@ -67,12 +69,16 @@ struct MppBufferGroupImpl_t {
     RK_U32              group_id;
     MppBufferMode       mode;
     MppBufferType       type;
+    // MPP_BUFFER_FLAGS_XXX from the type on group creation
+    RK_U32              flags;
     // used in limit mode only
     size_t              limit_size;
     RK_S32              limit_count;
     // status record
     size_t              limit;
     size_t              usage;
+    // size of buffers with cpu mapping, the rest is hardware only
+    size_t              usage_mapped;
     RK_S32              buffer_id;
     RK_S32              buffer_count;
     RK_S32              count_used;
@@ -86,6 +92,11 @@ struct MppBufferGroupImpl_t {
 
     // buffer force clear mode flag
     RK_U32              clear_on_exit;
+    // best_fit: 0 - first unused buffer large enough is taken, smaller unused
+    //               internal buffers found on the way are released
+    //           1 - smallest unused buffer large enough is taken, buffers in
+    //               other size are kept for later size switch
+    RK_U32              best_fit;
     // is_orphan: 0 - normal group 1 - orphan group
     RK_U32              is_orphan;
 
@@ -126,6 +137,17 @@ extern RK_U32 mpp_buffer_debug;
  *  mpp_buffer_ref_dec      : decrease buffer's reference counter. if the reference
  *                            reduce to zero buffer will be moved to unused list.
  *
+ *  mpp_buffer_mmap         : create cpu mapping of the buffer if it does not have one.
+ *                            internal buffer is allocated without mapping and it is
+ *                            mapped on the first cpu access.
+ *
+ *  mpp_buffer_munmap       : remove cpu mapping of an internal buffer. imported
+ *                            buffer keeps its mapping.
+ *
+ *  mpp_buffer_sync         : cpu cache maintenance on the range of the buffer with
+ *                            MPP_ALLOCATOR_SYNC_XXX flags. size 0 means to the end
+ *                            of the buffer.
+ *
  * normal call flow will be like this:
  *
  * mpp_buffer_create        - create a unused buffer
@@ -137,11 +159,30 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller, MppBufferGroupImp
 MPP_RET mpp_buffer_ref_inc(MppBufferImpl *buffer, const char* caller);
 MPP_RET mpp_buffer_ref_dec(MppBufferImpl *buffer, const char* caller);
 MppBufferImpl *mpp_buffer_get_unused(MppBufferGroupImpl *p, size_t size);
+MPP_RET mpp_buffer_mmap(MppBufferImpl *buffer, const char* caller);
+MPP_RET mpp_buffer_munmap(MppBufferImpl *buffer, const char* caller);
+MPP_RET mpp_buffer_sync(MppBufferImpl *buffer, RK_U32 flags, size_t offset, size_t size, const char* caller);
 
 MPP_RET mpp_buffer_group_init(MppBufferGroupImpl **group, const char *tag, const char *caller, MppBufferMode mode, MppBufferType type);
 MPP_RET mpp_buffer_group_deinit(MppBufferGroupImpl *p);
 MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p);
 MPP_RET mpp_buffer_group_set_listener(MppBufferGroupImpl *p, void *listener);
+/*
+ *  mpp_buffer_group_set_best_fit   : set unused buffer search mode of the group
+ *
+ *  mpp_buffer_group_size_count     : count buffers in the group with exactly the
+ *                                    size, both used and unused
+ *
+ *  mpp_buffer_group_trim           : release unused buffers with size other than
+ *                                    size0 and size1, 0 matches no buffer
+ *
+ *  mpp_buffer_group_get_usage      : get buffer count, used buffer count and
+ *                                    total buffer size without service lock
+ */
+MPP_RET mpp_buffer_group_set_best_fit(MppBufferGroupImpl *p, RK_U32 best_fit);
+RK_S32  mpp_buffer_group_size_count(MppBufferGroupImpl *p, size_t size);
+MPP_RET mpp_buffer_group_trim(MppBufferGroupImpl *p, size_t size0, size_t size1);
+MPP_RET mpp_buffer_group_get_usage(MppBufferGroupImpl *p, RK_S32 *count, RK_S32 *used, size_t *size);
 // mpp_buffer_group helper function
 void mpp_buffer_group_dump(MppBufferGroupImpl *p);
 void mpp_buffer_service_dump();
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_DEC_SEI_H__
+#define __MPP_DEC_SEI_H__
+
+#include "rk_mpi.h"
+
+/*
+ * decoder sei payload export shared by parsers
+ *
+ * Parser calls mpp_dec_sei_check with the payloadType of each sei message.
+ * The payload of a subscribed type is copied by parser into the space
+ * returned by mpp_dec_sei_add, other payloads are skipped by size. All the
+ * payloads of one picture are handed to its frame by mpp_dec_sei_attach.
+ * The context is only accessed by the parser thread.
+ *
+ * Parser which may see the sei of next picture before current picture is
+ * attached calls mpp_dec_sei_begin on the first slice of each picture. Then
+ * only the records added before begin go with current picture and the later
+ * ones are kept pending for the next picture.
+ *
+ * mask         - subscribed MppDecSeiType
+ * buf          - payload records of current picture, moved to frame on attach
+ * size         - buf size
+ * length       - used length of buf
+ * cur_len      - length of current picture records after begin
+ * split        - begin is used and records after cur_len are pending
+ * msg_count    - total sei message count checked
+ * export_count - total sei message count exported
+ */
+typedef struct MppDecSei_t {
+    RK_U32          mask;
+    RK_U8           *buf;
+    RK_U32          size;
+    RK_U32          length;
+    RK_U32          cur_len;
+    RK_U32          split;
+
+    RK_U32          msg_count;
+    RK_U32          export_count;
+} MppDecSei;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void    mpp_dec_sei_init(MppDecSei *sei);
+void    mpp_dec_sei_deinit(MppDecSei *sei);
+MPP_RET mpp_dec_sei_set(MppDecSei *sei, RK_U32 mask);
+
+/* return 1 when the payload of payload_type should be exported */
+RK_U32  mpp_dec_sei_check(MppDecSei *sei, RK_U32 payload_type);
+
+/*
+ * add a payload record to current picture
+ * return the space for payload_size bytes of payload, NULL on failure
+ */
+RK_U8  *mpp_dec_sei_add(MppDecSei *sei, RK_U32 payload_type, RK_U32 payload_size);
+
+/*
+ * mark the start of a new picture, the records added before go with it
+ * records of a previous picture which is never attached are dropped
+ */
+void    mpp_dec_sei_begin(MppDecSei *sei);
+
+/*
+ * move the records of current picture to frame meta as MPP_META_KEY_OUTPUT_SEI
+ * append is set for the second field which shares frame with the first one,
+ * otherwise the records replace the sei already in frame meta
+ */
+MPP_RET mpp_dec_sei_attach(MppDecSei *sei, MppFrame frame, RK_U32 append);
+
+/* drop all the records including the pending ones */
+void    mpp_dec_sei_clear(MppDecSei *sei);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_DEC_SEI_H__*/
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_DEC_SKIP_H__
+#define __MPP_DEC_SKIP_H__
+
+#include "rk_mpi.h"
+
+/*
+ * decoder picture skip decision shared by parsers
+ *
+ * Parser calls mpp_dec_skip_check once for each picture with the picture
+ * property found in its header and drops the picture before generating
+ * hardware task when it returns 1. The context is only accessed by the
+ * parser thread.
+ *
+ * cfg          - current MppDecSkipCfg
+ * ref_lost     - a reference picture has been skipped since last key picture
+ * wait_key     - skip all pictures until next key picture
+ * key_count    - key picture count for key_interval
+ * pic_count    - total picture count checked
+ * skip_count   - total picture count skipped
+ */
+typedef struct MppDecSkip_t {
+    MppDecSkipCfg   cfg;
+    RK_U32          ref_lost;
+    RK_U32          wait_key;
+    RK_U32          key_count;
+
+    RK_U32          pic_count;
+    RK_U32          skip_count;
+} MppDecSkip;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void    mpp_dec_skip_init(MppDecSkip *skip);
+MPP_RET mpp_dec_skip_set(MppDecSkip *skip, MppDecSkipCfg *cfg);
+void    mpp_dec_skip_reset(MppDecSkip *skip);
+
+/*
+ * is_key   - picture can be decoded without any other picture
+ * is_ref   - picture may be referenced by later picture
+ * tid      - temporal layer id of the picture
+ *
+ * return 1 when the picture should be skipped
+ */
+RK_U32  mpp_dec_skip_check(MppDecSkip *skip, RK_U32 is_key, RK_U32 is_ref, RK_U32 tid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_DEC_SKIP_H__*/
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_ENC_NAL_H__
+#define __MPP_ENC_NAL_H__
+
+#include "rk_mpi.h"
+
+#define MPP_ENC_NAL_MAX_COUNT           (256)
+
+/*
+ * encoder output nal unit index shared by controllers
+ *
+ * Controller adds the position of each nal unit it writes or gets from
+ * hardware feedback with mpp_enc_nal_add. mpp_enc_nal_finish reads the
+ * start code and nal header at these positions only. A range with unknown
+ * nal unit layout is added with mpp_enc_nal_add_rest and only this range is
+ * scanned for start codes. The index can then convert the packet to avcc
+ * format in place and be attached to the output packet.
+ *
+ * coding   - MppCodingType of the stream, selects nal header layout
+ * count    - nal unit count of current packet, 0 when index is invalid
+ * overflow - more nal units than MPP_ENC_NAL_MAX_COUNT are added
+ * scan     - last nal unit is a range to be split by start code scan
+ * nals     - nal units in bitstream order
+ */
+typedef struct MppEncNal_t {
+    MppCodingType   coding;
+    RK_U32          count;
+    RK_U32          overflow;
+    RK_U32          scan;
+    MppEncNalInfo   nals[MPP_ENC_NAL_MAX_COUNT];
+} MppEncNal;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void    mpp_enc_nal_reset(MppEncNal *nal, MppCodingType coding);
+MPP_RET mpp_enc_nal_add(MppEncNal *nal, RK_U32 offset, RK_U32 length);
+/* add a range of one or more nal units, it must be the last one added */
+MPP_RET mpp_enc_nal_add_rest(MppEncNal *nal, RK_U32 offset, RK_U32 length);
+
+/*
+ * check the nal units against packet data and fill start code size, type
+ * and temporal id. The index is dropped when any nal unit does not match.
+ */
+MPP_RET mpp_enc_nal_finish(MppEncNal *nal, RK_U8 *data, RK_U32 length);
+
+/* rebuild the index by scanning start codes of the whole packet */
+MPP_RET mpp_enc_nal_scan(MppEncNal *nal, RK_U8 *data, RK_U32 length);
+
+/*
+ * replace start code by 4 bytes big endian length in place
+ * 3 bytes start codes need one more byte each within capacity
+ * length is updated to the converted packet length
+ */
+MPP_RET mpp_enc_nal_to_avcc(MppEncNal *nal, RK_U8 *data, RK_U32 *length,
+                            RK_U32 capacity);
+
+/* copy the index to packet meta as MPP_META_KEY_OUTPUT_NAL */
+MPP_RET mpp_enc_nal_attach(MppEncNal *nal, MppPacket packet);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_ENC_NAL_H__*/
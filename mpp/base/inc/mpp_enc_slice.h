@@ -0,0 +1,65 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_ENC_SLICE_H__
+#define __MPP_ENC_SLICE_H__
+
+#include "mpp_task.h"
+
+/*
+ * encoder slice output
+ *
+ * The stream of one frame is sent to output task queue in pieces while the
+ * hardware is still encoding. Each piece is a packet referencing the frame
+ * packet buffer, the frame packet itself is sent as the last piece so that
+ * the packet given by user on input task comes back to user.
+ *
+ * port     - port to take output task from and send packet to
+ * packet   - packet of the whole frame
+ * intra    - MPP_META_KEY_OUTPUT_INTRA of the frame
+ * scene    - MPP_META_KEY_OUTPUT_SCENE of the frame
+ * pos      - stream length sent
+ * count    - packet count sent
+ * done     - the last piece is sent
+ */
+typedef struct MppEncSliceOut_t {
+    MppPort         port;
+    MppPacket       packet;
+    RK_S32          intra;
+    RK_S32          scene;
+
+    RK_U32          pos;
+    RK_U32          count;
+    RK_U32          done;
+} MppEncSliceOut;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void    mpp_enc_slice_start(MppEncSliceOut *out, MppPort port, MppPacket packet);
+
+/*
+ * send stream from last sent position to end, empty piece is only sent
+ * when it is the last one. Blocks when there is no output task.
+ */
+MPP_RET mpp_enc_slice_put(MppEncSliceOut *out, RK_U32 end, RK_U32 last);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_ENC_SLICE_H__*/
@@ -18,6 +18,7 @@
 #define __MPP_FRAME_IMPL_H__
 
 #include "mpp_frame.h"
+#include "mpp_mem_pool.h"
 
 typedef struct MppFrameImpl_t MppFrameImpl;
 
@@ -94,6 +95,12 @@ struct MppFrameImpl_t {
     MppBuffer       buffer;
     size_t          buf_size;
 
+    /*
+     * meta data owned by the frame, it is not copied by mpp_frame_copy
+     * and is moved to output frame by mpp_frame_move_meta
+     */
+    MppMeta         meta;
+
     /*
      * pointer for multiple frame output at one time
      */
@@ -101,13 +108,26 @@ struct MppFrameImpl_t {
 };
 
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 size_t  mpp_frame_get_buf_size(const MppFrame frame);
 void    mpp_frame_set_buf_size(MppFrame frame, size_t buf_size);
 
 MPP_RET mpp_frame_set_next(MppFrame frame, MppFrame next);
+void    mpp_frame_set_meta(MppFrame frame, MppMeta meta);
+void    mpp_frame_move_meta(MppFrame dst, MppFrame src);
 MPP_RET mpp_frame_copy(MppFrame frame, MppFrame next);
 MPP_RET mpp_frame_info_cmp(MppFrame frame0, MppFrame frame1);
 
 MPP_RET check_is_mpp_frame(void *pointer);
 
+/* frame descriptor pool statistic */
+MPP_RET mpp_frame_pool_info(MppMemPoolInfo *info);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /*__MPP_FRAME_IMPL_H__*/
@@ -17,12 +17,15 @@
 #ifndef __MPP_IMPL_H__
 #define __MPP_IMPL_H__
 
-#include "mpp_buffer.h"
+#include "mpp_packet.h"
+#include "mpp_mem_pool.h"
 
 #define MPP_PACKET_FLAG_EOS             (0x00000001)
 #define MPP_PACKET_FLAG_EXTRA_DATA      (0x00000002)
 #define MPP_PACKET_FLAG_INTERNAL        (0x00000004)
 #define MPP_PACKET_FLAG_INTRA           (0x00000008)
+#define MPP_PACKET_FLAG_PARTITION       (0x00000010)
+#define MPP_PACKET_FLAG_EOI             (0x00000020)
 
 /*
  * mpp_packet_imp structure
@@ -33,6 +36,7 @@
  * length   : valid data length
  * pts      : packet pts
  * dts      : packet dts
+ * meta     : meta data, released with packet
  */
 typedef struct MppPacketImpl_t {
     const char  *name;
@@ -48,8 +52,13 @@ typedef struct MppPacketImpl_t {
     RK_U32      flag;
 
     MppBuffer   buffer;
+    MppMeta     meta;
 } MppPacketImpl;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /*
  * mpp_packet_reset is only used internelly and should NOT be used outside
  */
@@ -58,4 +67,14 @@ MPP_RET mpp_packet_reset(MppPacketImpl *packet);
 /* pointer check function */
 MPP_RET check_is_mpp_packet(void *ptr);
 
+/* meta is owned by packet after set */
+void    mpp_packet_set_meta(MppPacket packet, MppMeta meta);
+
+/* packet descriptor pool statistic */
+MPP_RET mpp_packet_pool_info(MppMemPoolInfo *info);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /*__MPP_IMPL_H__*/
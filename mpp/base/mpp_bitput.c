@@ -49,6 +49,39 @@ void mpp_put_bits(BitputCtx_t *bp, RK_U64 invalue, RK_S32 lbits)
     // mpp_log("bp->index = %d bp->bitpos = %d lbits = %d invalue 0x%x bp->hvalue 0x%x  bp->lvalue 0x%x",bp->index,bp->bitpos,lbits, (RK_U32)invalue,(RK_U32)(bp->bvalue >> 32),(RK_U32)bp->bvalue);
 }
 
+void mpp_put_fields(BitputCtx_t *bp, const RK_U8 *bits, const RK_U64 *vals, RK_U32 count)
+{
+    RK_U32 i = 0;
+    RK_U32 index = bp->index;
+    RK_U32 bitpos = bp->bitpos;
+    RK_U64 bvalue = bp->bvalue;
+
+    for (i = 0; i < count; i++) {
+        RK_U32 lbits = bits[i];
+        RK_U64 invalue = 0;
+
+        if (!lbits)
+            continue;
+
+        if (index >= bp->buflen)
+            break;
+
+        invalue = vals[i] & ((1ULL << lbits) - 1);
+        bvalue |= invalue << bitpos;
+        if ((bitpos + lbits) >= 64) {
+            bp->pbuf[index++] = bvalue;
+            bvalue = invalue >> (64 - bitpos);
+        }
+        bitpos = (bitpos + lbits) & 63;
+    }
+    if (index < bp->buflen)
+        bp->pbuf[index] = bvalue;
+
+    bp->index  = index;
+    bp->bitpos = bitpos;
+    bp->bvalue = bvalue;
+}
+
 void mpp_put_align(BitputCtx_t *bp, RK_S32 align_bits, int flag)
 {
     RK_U32 word_offset = 0,  len = 0;
@@ -117,6 +117,32 @@ MPP_RET mpp_skip_bits(BitReadCtx_t *bitctx, RK_S32 num_bits)
     while (bitctx->num_remaining_bits_in_curr_byte_ < bits_left) {
         // Take all that's left in current byte, shift to make space for the rest.
         bits_left -= bitctx->num_remaining_bits_in_curr_byte_;
+        // Whole bytes before the last one are passed without loading them,
+        // only the emulation prevention detection state is kept.
+        if (bits_left > 8) {
+            const RK_U8 *data = bitctx->data_;
+            const RK_U8 *end = data + bitctx->bytes_left_;
+            RK_U32 prev = (RK_U32)bitctx->prev_two_bytes_;
+            RK_S32 skip = (bits_left - 1) >> 3;
+
+            while (skip && data < end) {
+                if (bitctx->need_prevention_detection && *data == 0x03 && !(prev & 0xffff)) {
+                    ++bitctx->emulation_prevention_bytes_;
+                    prev = 0xffff;
+                } else {
+                    prev = (prev << 8) | *data;
+                    skip--;
+                }
+                data++;
+            }
+            if (skip)
+                return  MPP_ERR_READ_BIT;
+
+            bitctx->prev_two_bytes_ = prev;
+            bitctx->bytes_left_ -= (RK_S32)(data - bitctx->data_);
+            bitctx->data_ = (RK_U8 *)data;
+            bits_left -= (bits_left - 1) & ~7;
+        }
         if (update_curbyte(bitctx)) {
             return  MPP_ERR_READ_BIT;
         }
@@ -214,6 +214,15 @@ struct MppBufSlotsImpl_t {
     MppFrame            info;
     MppFrame            info_set;
 
+    // buffer size and count predicted for frame buffer pre-allocation
+    // hint_seq increases on each hint with a different buffer size
+    size_t              hint_size;
+    RK_S32              hint_count;
+    RK_U32              hint_seq;
+
+    // slot count on each status flag updated by atomic operation
+    MppBufSlotStats     stats;
+
     // list for display
     struct list_head    queue[QUEUE_BUTT];
 
@@ -228,7 +237,8 @@ static RK_U32 default_align_16(RK_U32 val)
     return MPP_ALIGN(val, 16);
 }
 
-static void generate_info_set(MppBufSlotsImpl *impl, MppFrame frame, RK_U32 force_default_align)
+static RK_U32 get_hal_buf_size(MppBufSlotsImpl *impl, MppFrame frame, RK_U32 force_default_align,
+                               RK_U32 *hor_stride, RK_U32 *ver_stride)
 {
     RK_U32 width  = mpp_frame_get_width(frame);
     RK_U32 height = mpp_frame_get_height(frame);
@@ -249,6 +259,34 @@ static void generate_info_set(MppBufSlotsImpl *impl, MppFrame frame, RK_U32 forc
     size /= impl->denominator;
     size = impl->hal_len_align ? impl->hal_len_align(hal_hor_stride * hal_ver_stride) : size;
 
+    if (hor_stride)
+        *hor_stride = hal_hor_stride;
+    if (ver_stride)
+        *ver_stride = hal_ver_stride;
+    return size;
+}
+
+static void update_hint(MppBufSlotsImpl *impl, size_t size, RK_S32 count)
+{
+    if (size != impl->hint_size) {
+        buf_slot_dbg(BUF_SLOT_DBG_SETUP, "slot %p hint size %d -> %d count %d\n",
+                     impl, impl->hint_size, size, count);
+        impl->hint_size = size;
+        impl->hint_seq++;
+    }
+    if (count)
+        impl->hint_count = count;
+}
+
+static void generate_info_set(MppBufSlotsImpl *impl, MppFrame frame, RK_U32 force_default_align)
+{
+    RK_U32 width  = mpp_frame_get_width(frame);
+    RK_U32 height = mpp_frame_get_height(frame);
+    RK_U32 hal_hor_stride = 0;
+    RK_U32 hal_ver_stride = 0;
+    RK_U32 size = get_hal_buf_size(impl, frame, force_default_align,
+                                   &hal_hor_stride, &hal_ver_stride);
+
     mpp_frame_set_width(impl->info_set, width);
     mpp_frame_set_height(impl->info_set, height);
     mpp_frame_set_fmt(impl->info_set, mpp_frame_get_fmt(frame));
@@ -316,6 +354,46 @@ static void add_slot_log(mpp_list *logs, RK_S32 index, MppBufSlotOps op, SlotSta
     }
 }
 
+static void stats_diff(RK_S32 *cnt, RK_U32 before, RK_U32 after)
+{
+    if (!before != !after)
+        __atomic_fetch_add(cnt, (after) ? (1) : (-1), __ATOMIC_RELAXED);
+}
+
+static void slot_stats_update(MppBufSlotStats *stats, SlotStatus before, SlotStatus after)
+{
+    stats_diff(&stats->on_used,     before.on_used,     after.on_used);
+    stats_diff(&stats->not_ready,   before.not_ready,   after.not_ready);
+    stats_diff(&stats->codec_use,   before.codec_use,   after.codec_use);
+    stats_diff(&stats->hal_output,  before.hal_output,  after.hal_output);
+    stats_diff(&stats->hal_use,     before.hal_use,     after.hal_use);
+    stats_diff(&stats->queue_use,   before.queue_use,   after.queue_use);
+    stats_diff(&stats->has_buffer,  before.has_buffer,  after.has_buffer);
+}
+
+/* recount statistic after slot array is initialized or reallocated */
+static void slot_stats_reset(MppBufSlotsImpl *impl, RK_S32 count)
+{
+    MppBufSlotStats stats;
+    MppBufSlotEntry *slot = impl->slots;
+    SlotStatus none;
+    RK_S32 i;
+
+    memset(&stats, 0, sizeof(stats));
+    none.val = 0;
+    for (i = 0; i < count; i++, slot++)
+        slot_stats_update(&stats, none, slot->status);
+
+    __atomic_store_n(&impl->stats.count,      count,            __ATOMIC_RELAXED);
+    __atomic_store_n(&impl->stats.on_used,    stats.on_used,    __ATOMIC_RELAXED);
+    __atomic_store_n(&impl->stats.not_ready,  stats.not_ready,  __ATOMIC_RELAXED);
+    __atomic_store_n(&impl->stats.codec_use,  stats.codec_use,  __ATOMIC_RELAXED);
+    __atomic_store_n(&impl->stats.hal_output, stats.hal_output, __ATOMIC_RELAXED);
+    __atomic_store_n(&impl->stats.hal_use,    stats.hal_use,    __ATOMIC_RELAXED);
+    __atomic_store_n(&impl->stats.queue_use,  stats.queue_use,  __ATOMIC_RELAXED);
+    __atomic_store_n(&impl->stats.has_buffer, stats.has_buffer, __ATOMIC_RELAXED);
+}
+
 static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppBufSlotOps op, void *arg)
 {
     RK_U32 error = 0;
@@ -407,6 +485,9 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
         error = 1;
     } break;
     }
+    // status before init can be garbage so init is counted by slot_stats_reset
+    if (op != SLOT_INIT)
+        slot_stats_update(&impl->stats, before, status);
     slot->status = status;
     buf_slot_dbg(BUF_SLOT_DBG_OPS_RUNTIME, "slot %3d index %2d op: %s arg %p status in %08x out %08x",
                  impl->slots_idx, index, op_string[op], arg, before.val, status.val);
@@ -425,6 +506,7 @@ static void init_slot_entry(MppBufSlotsImpl *impl, RK_S32 pos, RK_S32 count)
         slot->frame = NULL;
         slot_ops_with_log(impl, slot, SLOT_INIT, NULL);
     }
+    slot_stats_reset(impl, pos + count);
 }
 
 /*
@@ -655,6 +737,35 @@ RK_S32 mpp_buf_slot_get_used_size(MppBufSlots slots)
     return used_size;
 }
 
+MPP_RET mpp_buf_slot_set_hint(MppBufSlots slots, MppFrame frame, RK_S32 count)
+{
+    if (NULL == slots || NULL == frame) {
+        mpp_err_f("found NULL input slots %p frame %p\n", slots, frame);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
+    AutoMutex auto_lock(impl->lock);
+    update_hint(impl, get_hal_buf_size(impl, frame, 0, NULL, NULL), count);
+    return MPP_OK;
+}
+
+RK_U32 mpp_buf_slot_get_hint(MppBufSlots slots, size_t *size, RK_S32 *count)
+{
+    if (NULL == slots) {
+        mpp_err_f("found NULL input\n");
+        return 0;
+    }
+
+    MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
+    AutoMutex auto_lock(impl->lock);
+    if (size)
+        *size = impl->hint_size;
+    if (count)
+        *count = impl->hint_count;
+    return impl->hint_seq;
+}
+
 MPP_RET mpp_buf_slot_get_unused(MppBufSlots slots, RK_S32 *index)
 {
     if (NULL == slots || NULL == index) {
@@ -791,6 +902,8 @@ MPP_RET mpp_buf_slot_set_prop(MppBufSlots slots, RK_S32 index, SlotPropType type
         MppFrameImpl *src = (MppFrameImpl *)frame;
         MppFrameImpl *dst = (MppFrameImpl *)slot->frame;
         mpp_frame_copy(dst, src);
+        // new picture in slot, meta left by an undisplayed picture is stale
+        mpp_frame_set_meta(slot->frame, NULL);
         // NOTE: stride from codec need to be change to hal stride
         //       hor_stride and ver_stride can not be zero
         //       they are the stride required by codec
@@ -811,6 +924,8 @@ MPP_RET mpp_buf_slot_set_prop(MppBufSlots slots, RK_S32 index, SlotPropType type
          *    only display info change is need
          */
         generate_info_set(impl, frame, 0);
+        // frame of a codec without sequence hint still triggers pre-allocation
+        update_hint(impl, impl->buf_size, 0);
 #if 0
         if (mpp_frame_info_cmp(impl->info, impl->info_set)) {
             impl->info_changed = 1;
@@ -994,3 +1109,24 @@ MPP_RET mpp_buf_slot_reset(MppBufSlots slots, RK_S32 index)
     return MPP_OK;
 }
 
+
+MPP_RET mpp_buf_slot_get_stats(MppBufSlots slots, MppBufSlotStats *stats)
+{
+    if (NULL == slots || NULL == stats) {
+        mpp_err_f("found NULL input slots %p stats %p\n", slots, stats);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
+    MppBufSlotStats *src = &impl->stats;
+
+    stats->count      = __atomic_load_n(&src->count,      __ATOMIC_RELAXED);
+    stats->on_used    = __atomic_load_n(&src->on_used,    __ATOMIC_RELAXED);
+    stats->not_ready  = __atomic_load_n(&src->not_ready,  __ATOMIC_RELAXED);
+    stats->codec_use  = __atomic_load_n(&src->codec_use,  __ATOMIC_RELAXED);
+    stats->hal_output = __atomic_load_n(&src->hal_output, __ATOMIC_RELAXED);
+    stats->hal_use    = __atomic_load_n(&src->hal_use,    __ATOMIC_RELAXED);
+    stats->queue_use  = __atomic_load_n(&src->queue_use,  __ATOMIC_RELAXED);
+    stats->has_buffer = __atomic_load_n(&src->has_buffer, __ATOMIC_RELAXED);
+    return MPP_OK;
+}
@@ -114,6 +114,57 @@ MPP_RET mpp_buffer_inc_ref_with_caller(MppBuffer buffer, const char *caller)
     return mpp_buffer_ref_inc((MppBufferImpl*)buffer, caller);
 }
 
+MPP_RET mpp_buffer_map_with_caller(MppBuffer buffer, const char *caller)
+{
+    if (NULL == buffer) {
+        mpp_err("mpp_buffer_map invalid input: buffer %p\n", buffer);
+        return MPP_ERR_UNKNOW;
+    }
+
+    MppBufferImpl *p = (MppBufferImpl*)buffer;
+    if (p->info.ptr)
+        return MPP_OK;
+
+    return mpp_buffer_mmap(p, caller);
+}
+
+MPP_RET mpp_buffer_unmap_with_caller(MppBuffer buffer, const char *caller)
+{
+    if (NULL == buffer) {
+        mpp_err("mpp_buffer_unmap invalid input: buffer %p\n", buffer);
+        return MPP_ERR_UNKNOW;
+    }
+
+    return mpp_buffer_munmap((MppBufferImpl*)buffer, caller);
+}
+
+MPP_RET mpp_buffer_sync_begin_with_caller(MppBuffer buffer, RK_U32 ro, size_t offset,
+                                          size_t size, const char *caller)
+{
+    if (NULL == buffer) {
+        mpp_err("mpp_buffer_sync_begin invalid input: buffer %p\n", buffer);
+        return MPP_ERR_UNKNOW;
+    }
+
+    RK_U32 flags = (ro) ? (MPP_ALLOCATOR_SYNC_READ) : (MPP_ALLOCATOR_SYNC_RW);
+
+    return mpp_buffer_sync((MppBufferImpl*)buffer, flags, offset, size, caller);
+}
+
+MPP_RET mpp_buffer_sync_end_with_caller(MppBuffer buffer, RK_U32 ro, size_t offset,
+                                        size_t size, const char *caller)
+{
+    if (NULL == buffer) {
+        mpp_err("mpp_buffer_sync_end invalid input: buffer %p\n", buffer);
+        return MPP_ERR_UNKNOW;
+    }
+
+    RK_U32 flags = (ro) ? (MPP_ALLOCATOR_SYNC_READ) : (MPP_ALLOCATOR_SYNC_RW);
+
+    return mpp_buffer_sync((MppBufferImpl*)buffer, flags | MPP_ALLOCATOR_SYNC_END,
+                           offset, size, caller);
+}
+
 MPP_RET mpp_buffer_read(MppBuffer buffer, size_t offset, void *data, size_t size)
 {
     if (NULL == buffer || NULL == data) {
@@ -125,9 +176,17 @@ MPP_RET mpp_buffer_read(MppBuffer buffer, size_t offset, void *data, size_t size
         return MPP_OK;
 
     MppBufferImpl *p = (MppBufferImpl*)buffer;
+    if (NULL == p->info.ptr)
+        mpp_buffer_mmap(p, __FUNCTION__);
+
     void *src = p->info.ptr;
     mpp_assert(src != NULL);
+    if (p->cacheable)
+        mpp_buffer_sync(p, MPP_ALLOCATOR_SYNC_READ, offset, size, __FUNCTION__);
     memcpy(data, (char*)src + offset, size);
+    if (p->cacheable)
+        mpp_buffer_sync(p, MPP_ALLOCATOR_SYNC_READ | MPP_ALLOCATOR_SYNC_END,
+                        offset, size, __FUNCTION__);
     return MPP_OK;
 }
 
@@ -142,9 +201,17 @@ MPP_RET mpp_buffer_write(MppBuffer buffer, size_t offset, void *data, size_t siz
         return MPP_OK;
 
     MppBufferImpl *p = (MppBufferImpl*)buffer;
+    if (NULL == p->info.ptr)
+        mpp_buffer_mmap(p, __FUNCTION__);
+
     void *dst = p->info.ptr;
     mpp_assert(dst != NULL);
+    if (p->cacheable)
+        mpp_buffer_sync(p, MPP_ALLOCATOR_SYNC_WRITE, offset, size, __FUNCTION__);
     memcpy((char*)dst + offset, data, size);
+    if (p->cacheable)
+        mpp_buffer_sync(p, MPP_ALLOCATOR_SYNC_WRITE | MPP_ALLOCATOR_SYNC_END,
+                        offset, size, __FUNCTION__);
     return MPP_OK;
 }
 
@@ -156,6 +223,9 @@ void *mpp_buffer_get_ptr(MppBuffer buffer)
     }
 
     MppBufferImpl *p = (MppBufferImpl*)buffer;
+    if (NULL == p->info.ptr)
+        mpp_buffer_mmap(p, __FUNCTION__);
+
     void *ptr = p->info.ptr;
     mpp_assert(ptr != NULL);
     return ptr;
@@ -205,7 +275,7 @@ MPP_RET mpp_buffer_group_get(MppBufferGroup *group, MppBufferType type, MppBuffe
 {
     if (NULL == group ||
         mode >= MPP_BUFFER_MODE_BUTT ||
-        type >= MPP_BUFFER_TYPE_BUTT) {
+        (type & MPP_BUFFER_TYPE_MASK) >= MPP_BUFFER_TYPE_BUTT) {
         mpp_err_f("input invalid group %p mode %d type %d\n",
                   group, mode, type);
         return MPP_ERR_UNKNOW;
@@ -267,6 +337,21 @@ MppBufferType mpp_buffer_group_type(MppBufferGroup group)
     return p->type;
 }
 
+MPP_RET mpp_buffer_group_usage(MppBufferGroup group, size_t *mapped, size_t *unmapped)
+{
+    if (NULL == group) {
+        mpp_err_f("input invalid group %p\n", group);
+        return MPP_NOK;
+    }
+
+    MppBufferGroupImpl *p = (MppBufferGroupImpl *)group;
+    if (mapped)
+        *mapped = p->usage_mapped;
+    if (unmapped)
+        *unmapped = p->usage - p->usage_mapped;
+    return MPP_OK;
+}
+
 MPP_RET mpp_buffer_group_limit_config(MppBufferGroup group, size_t size, RK_S32 count)
 {
     if (NULL == group) {
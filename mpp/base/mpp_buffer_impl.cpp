@@ -41,6 +41,8 @@ typedef enum MppBufOps_e {
     BUF_REF_INC,
     BUF_REF_DEC,
     BUF_DESTROY,
+    BUF_MMAP,
+    BUF_MUNMAP,
     BUF_OPS_BUTT,
 } MppBufOps;
 
@@ -116,6 +118,8 @@ static const char *ops2str[BUF_OPS_BUTT] = {
     "buf ref inc",
     "buf ref dec",
     "buf destroy",
+    "buf mmap   ",
+    "buf munmap ",
 };
 
 RK_U32 mpp_buffer_debug = 0;
@@ -183,6 +187,8 @@ MPP_RET deinit_buffer_no_lock(MppBufferImpl *buffer, const char *caller)
     BufferOp func = (group->mode == MPP_BUFFER_INTERNAL) ?
                     (group->alloc_api->free) :
                     (group->alloc_api->release);
+    if (buffer->info.ptr)
+        group->usage_mapped -= buffer->info.size;
     func(group->allocator, &buffer->info);
     group->usage -= buffer->info.size;
     group->buffer_count--;
@@ -223,8 +229,8 @@ static MPP_RET inc_buffer_ref_no_lock(MppBufferImpl *buffer, const char *caller)
 
 static void dump_buffer_info(MppBufferImpl *buffer)
 {
-    mpp_log("buffer %p fd %4d size %10d ref_count %3d discard %d caller %s\n",
-            buffer, buffer->info.fd, buffer->info.size,
+    mpp_log("buffer %p fd %4d size %10d ptr %p ref_count %3d discard %d caller %s\n",
+            buffer, buffer->info.fd, buffer->info.size, buffer->info.ptr,
             buffer->ref_count, buffer->discard, buffer->caller);
 }
 
@@ -276,6 +282,7 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
 
     p->info = *info;
     p->mode = group->mode;
+    p->cacheable = (group->flags & MPP_BUFFER_FLAGS_CACHABLE) ? (1) : (0);
 
     if (NULL == tag)
         tag = group->tag;
@@ -289,6 +296,8 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
 
     group->buffer_id++;
     group->usage += info->size;
+    if (p->info.ptr)
+        group->usage_mapped += info->size;
     group->buffer_count++;
     group->count_unused++;
 
@@ -365,7 +374,23 @@ MppBufferImpl *mpp_buffer_get_unused(MppBufferGroupImpl *p, size_t size)
 
     MppBufferImpl *buffer = NULL;
 
-    if (!list_empty(&p->list_unused)) {
+    if (!list_empty(&p->list_unused) && p->best_fit) {
+        MppBufferImpl *pos, *n;
+
+        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
+            mpp_buf_dbg(MPP_BUF_DBG_CHECK_SIZE, "request size %d on buf idx %d size %d\n",
+                        size, pos->buffer_id, pos->info.size);
+            if (pos->info.size >= size &&
+                (NULL == buffer || pos->info.size < buffer->info.size)) {
+                buffer = pos;
+                if (pos->info.size == size)
+                    break;
+            }
+        }
+
+        if (buffer)
+            inc_buffer_ref_no_lock(buffer, __FUNCTION__);
+    } else if (!list_empty(&p->list_unused)) {
         MppBufferImpl *pos, *n;
         RK_S32 found = 0;
         RK_S32 search_count = 0;
@@ -395,6 +420,115 @@ MppBufferImpl *mpp_buffer_get_unused(MppBufferGroupImpl *p, size_t size)
     return buffer;
 }
 
+MPP_RET mpp_buffer_mmap(MppBufferImpl *buffer, const char* caller)
+{
+    AutoMutex auto_lock(MppBufferService::get_lock());
+    MPP_BUF_FUNCTION_ENTER();
+
+    MPP_RET ret = MPP_OK;
+    MppBufferGroupImpl *group = NULL;
+
+    // check again under lock for another thread may have mapped it
+    if (buffer->info.ptr)
+        goto RET;
+
+    group = SEARCH_GROUP_BY_ID(buffer->group_id);
+    if (NULL == group) {
+        mpp_err_f("buffer %d without group\n", buffer->buffer_id);
+        ret = MPP_NOK;
+        goto RET;
+    }
+
+    ret = group->alloc_api->mmap(group->allocator, &buffer->info);
+    if (MPP_OK != ret || NULL == buffer->info.ptr) {
+        mpp_err_f("failed to map buffer %d fd %d size %d caller %s\n",
+                  buffer->buffer_id, buffer->info.fd, buffer->info.size, caller);
+        ret = MPP_NOK;
+        goto RET;
+    }
+
+    group->usage_mapped += buffer->info.size;
+    buffer_group_add_log(group, buffer, BUF_MMAP, caller);
+RET:
+    MPP_BUF_FUNCTION_LEAVE();
+    return ret;
+}
+
+MPP_RET mpp_buffer_munmap(MppBufferImpl *buffer, const char* caller)
+{
+    AutoMutex auto_lock(MppBufferService::get_lock());
+    MPP_BUF_FUNCTION_ENTER();
+
+    MPP_RET ret = MPP_OK;
+    MppBufferGroupImpl *group = NULL;
+
+    // imported buffer mapping belongs to its importer
+    if (NULL == buffer->info.ptr || buffer->mode != MPP_BUFFER_INTERNAL)
+        goto RET;
+
+    group = SEARCH_GROUP_BY_ID(buffer->group_id);
+    if (NULL == group) {
+        mpp_err_f("buffer %d without group\n", buffer->buffer_id);
+        ret = MPP_NOK;
+        goto RET;
+    }
+
+    ret = group->alloc_api->munmap(group->allocator, &buffer->info);
+    // normal buffer can not be unmapped and keeps its pointer
+    if (MPP_OK == ret && NULL == buffer->info.ptr) {
+        group->usage_mapped -= buffer->info.size;
+        buffer_group_add_log(group, buffer, BUF_MUNMAP, caller);
+    }
+RET:
+    MPP_BUF_FUNCTION_LEAVE();
+    return ret;
+}
+
+MPP_RET mpp_buffer_sync(MppBufferImpl *buffer, RK_U32 flags, size_t offset, size_t size, const char* caller)
+{
+    MPP_BUF_FUNCTION_ENTER();
+
+    MPP_RET ret = MPP_OK;
+    MppBufferGroupImpl *group = NULL;
+    MppAllocator allocator = NULL;
+    MppAllocatorApi *alloc_api = NULL;
+
+    if (offset > buffer->info.size || size > buffer->info.size - offset) {
+        mpp_err_f("invalid range offset %d size %d buffer size %d caller %s\n",
+                  offset, size, buffer->info.size, caller);
+        ret = MPP_ERR_VALUE;
+        goto RET;
+    }
+
+    {
+        AutoMutex auto_lock(MppBufferService::get_lock());
+
+        group = SEARCH_GROUP_BY_ID(buffer->group_id);
+        if (NULL == group) {
+            mpp_err_f("buffer %d without group\n", buffer->buffer_id);
+            ret = MPP_NOK;
+            goto RET;
+        }
+
+        allocator = group->allocator;
+        alloc_api = group->alloc_api;
+    }
+
+    // the cache operation may take long time so it is done without lock
+    if (alloc_api->sync) {
+        if (size == 0 && offset)
+            size = buffer->info.size - offset;
+
+        ret = alloc_api->sync(allocator, &buffer->info, flags, offset, size);
+        if (ret)
+            mpp_err_f("failed to sync buffer %d fd %d caller %s\n",
+                      buffer->buffer_id, buffer->info.fd, caller);
+    }
+RET:
+    MPP_BUF_FUNCTION_LEAVE();
+    return ret;
+}
+
 MPP_RET mpp_buffer_group_init(MppBufferGroupImpl **group, const char *tag, const char *caller,
                               MppBufferMode mode, MppBufferType type)
 {
@@ -472,12 +606,88 @@ MPP_RET mpp_buffer_group_set_listener(MppBufferGroupImpl *p, void *listener)
     return MPP_OK;
 }
 
+MPP_RET mpp_buffer_group_set_best_fit(MppBufferGroupImpl *p, RK_U32 best_fit)
+{
+    AutoMutex auto_lock(MppBufferService::get_lock());
+    if (NULL == p) {
+        mpp_err_f("found NULL pointer\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p->best_fit = best_fit;
+    return MPP_OK;
+}
+
+RK_S32 mpp_buffer_group_size_count(MppBufferGroupImpl *p, size_t size)
+{
+    AutoMutex auto_lock(MppBufferService::get_lock());
+    if (NULL == p) {
+        mpp_err_f("found NULL pointer\n");
+        return 0;
+    }
+
+    MppBufferImpl *pos, *n;
+    RK_S32 count = 0;
+
+    list_for_each_entry_safe(pos, n, &p->list_used, MppBufferImpl, list_status) {
+        if (pos->info.size == size && !pos->discard)
+            count++;
+    }
+    list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
+        if (pos->info.size == size)
+            count++;
+    }
+    return count;
+}
+
+MPP_RET mpp_buffer_group_trim(MppBufferGroupImpl *p, size_t size0, size_t size1)
+{
+    AutoMutex auto_lock(MppBufferService::get_lock());
+    if (NULL == p) {
+        mpp_err_f("found NULL pointer\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MPP_BUF_FUNCTION_ENTER();
+
+    MppBufferImpl *pos, *n;
+    list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
+        if (pos->info.size != size0 && pos->info.size != size1) {
+            deinit_buffer_no_lock(pos, __FUNCTION__);
+            p->count_unused--;
+        }
+    }
+
+    MPP_BUF_FUNCTION_LEAVE();
+    return MPP_OK;
+}
+
+MPP_RET mpp_buffer_group_get_usage(MppBufferGroupImpl *p, RK_S32 *count, RK_S32 *used, size_t *size)
+{
+    if (NULL == p) {
+        mpp_err_f("found NULL pointer\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    // single word fields are loaded as a snapshot for monitoring only
+    if (count)
+        *count = __atomic_load_n(&p->buffer_count, __ATOMIC_RELAXED);
+    if (used)
+        *used = __atomic_load_n(&p->count_used, __ATOMIC_RELAXED);
+    if (size)
+        *size = __atomic_load_n(&p->usage, __ATOMIC_RELAXED);
+
+    return MPP_OK;
+}
+
 void mpp_buffer_group_dump(MppBufferGroupImpl *group)
 {
     mpp_log("\ndumping buffer group %p id %d\n", group, group->group_id);
     mpp_log("mode %s\n", mode2str[group->mode]);
     mpp_log("type %s\n", type2str[group->type]);
     mpp_log("limit size %d count %d\n", group->limit_size, group->limit_count);
+    mpp_log("usage %d mapped %d unmapped %d\n", group->usage, group->usage_mapped,
+            group->usage - group->usage_mapped);
 
     mpp_log("used buffer count %d\n", group->count_used);
 
@@ -591,7 +801,8 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
     }
     p->caller   = caller;
     p->mode     = mode;
-    p->type     = type;
+    p->type     = (MppBufferType)(type & MPP_BUFFER_TYPE_MASK);
+    p->flags    = type & MPP_BUFFER_FLAGS_MASK;
     p->limit    = BUFFER_GROUP_SIZE_DEFAULT;
     p->group_id = id;
     p->clear_on_exit = (mpp_buffer_debug & MPP_BUF_DBG_CLR_ON_EXIT) ? (1) : (0);
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dec_sei"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_meta.h"
+#include "mpp_frame_impl.h"
+#include "mpp_packet_impl.h"
+#include "mpp_dec_sei.h"
+
+#define SEI_BUF_SIZE_MIN                (256)
+
+/* sei payloadType shared by H.264 and H.265 */
+#define SEI_TYPE_USER_DATA_REG          (4)
+#define SEI_TYPE_USER_DATA_UNREG        (5)
+#define SEI_TYPE_MASTERING_DISPLAY      (137)
+#define SEI_TYPE_CONTENT_LIGHT          (144)
+
+static RK_U32 sei_type_to_mask(RK_U32 payload_type)
+{
+    switch (payload_type) {
+    case SEI_TYPE_USER_DATA_REG :       return MPP_DEC_SEI_USER_DATA_REG;
+    case SEI_TYPE_USER_DATA_UNREG :     return MPP_DEC_SEI_USER_DATA_UNREG;
+    case SEI_TYPE_MASTERING_DISPLAY :   return MPP_DEC_SEI_MASTERING_DISPLAY;
+    case SEI_TYPE_CONTENT_LIGHT :       return MPP_DEC_SEI_CONTENT_LIGHT;
+    default : break;
+    }
+    return 0;
+}
+
+void mpp_dec_sei_init(MppDecSei *sei)
+{
+    memset(sei, 0, sizeof(*sei));
+}
+
+void mpp_dec_sei_deinit(MppDecSei *sei)
+{
+    MPP_FREE(sei->buf);
+    sei->size = 0;
+    sei->length = 0;
+    sei->cur_len = 0;
+}
+
+MPP_RET mpp_dec_sei_set(MppDecSei *sei, RK_U32 mask)
+{
+    if (NULL == sei) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (mask & ~MPP_DEC_SEI_ALL) {
+        mpp_err_f("invalid sei mask %x\n", mask);
+        return MPP_ERR_VALUE;
+    }
+
+    sei->mask = mask;
+    return MPP_OK;
+}
+
+RK_U32 mpp_dec_sei_check(MppDecSei *sei, RK_U32 payload_type)
+{
+    sei->msg_count++;
+    return (sei->mask & sei_type_to_mask(payload_type)) ? 1 : 0;
+}
+
+RK_U8 *mpp_dec_sei_add(MppDecSei *sei, RK_U32 payload_type, RK_U32 payload_size)
+{
+    RK_U32 need = sizeof(MppDecSeiHead) + MPP_ALIGN(payload_size, 4);
+    MppDecSeiHead *head = NULL;
+    RK_U8 *data = NULL;
+
+    if (sei->length + need > sei->size) {
+        RK_U32 size = MPP_MAX(sei->size * 2, sei->length + need);
+        RK_U8 *buf = NULL;
+
+        size = MPP_MAX(size, SEI_BUF_SIZE_MIN);
+        buf = mpp_realloc(sei->buf, RK_U8, size);
+        if (NULL == buf) {
+            mpp_err_f("failed to realloc sei buffer size %d\n", size);
+            return NULL;
+        }
+        sei->buf = buf;
+        sei->size = size;
+    }
+
+    head = (MppDecSeiHead *)(sei->buf + sei->length);
+    head->payload_type = payload_type;
+    head->payload_size = payload_size;
+    data = (RK_U8 *)(head + 1);
+    memset(data + payload_size, 0, need - sizeof(MppDecSeiHead) - payload_size);
+
+    sei->length += need;
+    sei->export_count++;
+    return data;
+}
+
+/* drop the first len bytes of records */
+static void sei_drop(MppDecSei *sei, RK_U32 len)
+{
+    sei->length -= len;
+    if (sei->length)
+        memmove(sei->buf, sei->buf + len, sei->length);
+    sei->cur_len = 0;
+}
+
+void mpp_dec_sei_begin(MppDecSei *sei)
+{
+    if (sei->cur_len)
+        sei_drop(sei, sei->cur_len);
+
+    sei->cur_len = sei->length;
+    sei->split = 1;
+}
+
+MPP_RET mpp_dec_sei_attach(MppDecSei *sei, MppFrame frame, RK_U32 append)
+{
+    RK_U32 len = sei->split ? sei->cur_len : sei->length;
+    RK_U32 rest = sei->length - len;
+    MppMeta meta = mpp_frame_get_meta(frame);
+    MppPacket packet = NULL;
+    MppPacket prev = NULL;
+    size_t prev_len = 0;
+    RK_U8 *buf = NULL;
+
+    if (!len) {
+        if (!append && meta &&
+            MPP_OK == mpp_meta_get_packet(meta, MPP_META_KEY_OUTPUT_SEI, &prev))
+            mpp_packet_deinit(&prev);
+        return MPP_OK;
+    }
+
+    if (NULL == meta) {
+        if (mpp_meta_get(&meta)) {
+            sei_drop(sei, len);
+            return MPP_NOK;
+        }
+        mpp_frame_set_meta(frame, meta);
+    }
+
+    // only the second field of a pair appends its records to the first field
+    if (MPP_OK == mpp_meta_get_packet(meta, MPP_META_KEY_OUTPUT_SEI, &prev)) {
+        if (append)
+            prev_len = mpp_packet_get_length(prev);
+        else
+            mpp_packet_deinit(&prev);
+    }
+
+    if (prev || rest) {
+        buf = mpp_malloc(RK_U8, prev_len + len);
+        if (NULL == buf) {
+            mpp_err_f("failed to malloc sei buffer size %d\n", (RK_U32)prev_len + len);
+            if (prev)
+                mpp_packet_deinit(&prev);
+            sei_drop(sei, len);
+            return MPP_ERR_MALLOC;
+        }
+        if (prev) {
+            memcpy(buf, mpp_packet_get_data(prev), prev_len);
+            mpp_packet_deinit(&prev);
+        }
+        memcpy(buf + prev_len, sei->buf, len);
+        sei_drop(sei, len);
+    } else {
+        // the packet takes the record buffer, next picture allocates a new one
+        buf = sei->buf;
+        sei->buf = NULL;
+        sei->size = 0;
+        sei->length = 0;
+        sei->cur_len = 0;
+    }
+
+    if (mpp_packet_init(&packet, buf, prev_len + len)) {
+        mpp_free(buf);
+        return MPP_NOK;
+    }
+    ((MppPacketImpl *)packet)->flag |= MPP_PACKET_FLAG_INTERNAL;
+
+    return mpp_meta_set_packet(meta, MPP_META_KEY_OUTPUT_SEI, packet);
+}
+
+void mpp_dec_sei_clear(MppDecSei *sei)
+{
+    sei->length = 0;
+    sei->cur_len = 0;
+}
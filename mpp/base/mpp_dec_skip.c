@@ -0,0 +1,110 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dec_skip"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_dec_skip.h"
+
+/* whether pictures decoded in new mode are all decoded in old mode */
+static RK_U32 skip_cfg_is_subset(MppDecSkipCfg *old_cfg, MppDecSkipCfg *new_cfg)
+{
+    if (new_cfg->mode == MPP_DEC_SKIP_NON_KEY)
+        return 1;
+
+    if (new_cfg->mode == MPP_DEC_SKIP_TEMPORAL &&
+        old_cfg->mode == MPP_DEC_SKIP_TEMPORAL)
+        return new_cfg->max_tid <= old_cfg->max_tid;
+
+    return 0;
+}
+
+void mpp_dec_skip_init(MppDecSkip *skip)
+{
+    memset(skip, 0, sizeof(*skip));
+}
+
+MPP_RET mpp_dec_skip_set(MppDecSkip *skip, MppDecSkipCfg *cfg)
+{
+    if (NULL == skip || NULL == cfg) {
+        mpp_err_f("invalid input skip %p cfg %p\n", skip, cfg);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (cfg->mode >= MPP_DEC_SKIP_BUTT) {
+        mpp_err_f("invalid skip mode %d\n", cfg->mode);
+        return MPP_ERR_VALUE;
+    }
+
+    if (skip->ref_lost && !skip_cfg_is_subset(&skip->cfg, cfg))
+        skip->wait_key = 1;
+
+    skip->cfg = *cfg;
+    return MPP_OK;
+}
+
+void mpp_dec_skip_reset(MppDecSkip *skip)
+{
+    // decoder restarts from a key picture after reset
+    skip->ref_lost = 0;
+    skip->wait_key = 0;
+    skip->key_count = 0;
+}
+
+RK_U32 mpp_dec_skip_check(MppDecSkip *skip, RK_U32 is_key, RK_U32 is_ref, RK_U32 tid)
+{
+    MppDecSkipCfg *cfg = &skip->cfg;
+    RK_U32 skip_pic = 0;
+
+    skip->pic_count++;
+
+    if (is_key) {
+        skip->key_count++;
+        if (cfg->mode == MPP_DEC_SKIP_NON_KEY && cfg->key_interval > 1)
+            skip_pic = ((skip->key_count - 1) % cfg->key_interval) ? 1 : 0;
+
+        if (!skip_pic) {
+            skip->ref_lost = 0;
+            skip->wait_key = 0;
+        }
+    } else if (skip->wait_key) {
+        skip_pic = 1;
+    } else {
+        switch (cfg->mode) {
+        case MPP_DEC_SKIP_NON_REF : {
+            skip_pic = !is_ref;
+        } break;
+        case MPP_DEC_SKIP_NON_KEY : {
+            skip_pic = 1;
+        } break;
+        case MPP_DEC_SKIP_TEMPORAL : {
+            skip_pic = tid > cfg->max_tid;
+        } break;
+        default : {
+        } break;
+        }
+    }
+
+    if (skip_pic) {
+        skip->skip_count++;
+        if (is_ref)
+            skip->ref_lost = 1;
+    }
+
+    return skip_pic;
+}
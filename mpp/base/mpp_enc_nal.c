@@ -0,0 +1,271 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_enc_nal"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_meta.h"
+#include "mpp_packet_impl.h"
+#include "mpp_enc_nal.h"
+
+#define AVCC_LENGTH_SIZE                (4)
+
+void mpp_enc_nal_reset(MppEncNal *nal, MppCodingType coding)
+{
+    nal->coding = coding;
+    nal->count = 0;
+    nal->overflow = 0;
+    nal->scan = 0;
+}
+
+MPP_RET mpp_enc_nal_add(MppEncNal *nal, RK_U32 offset, RK_U32 length)
+{
+    MppEncNalInfo *info = NULL;
+
+    if (nal->count >= MPP_ENC_NAL_MAX_COUNT) {
+        nal->overflow = 1;
+        return MPP_NOK;
+    }
+
+    info = &nal->nals[nal->count++];
+    info->offset = offset;
+    info->length = length;
+    info->header = 0;
+    info->type = 0;
+    info->temporal_id = 0;
+    info->reserved = 0;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_enc_nal_add_rest(MppEncNal *nal, RK_U32 offset, RK_U32 length)
+{
+    MPP_RET ret = mpp_enc_nal_add(nal, offset, length);
+
+    if (MPP_OK == ret)
+        nal->scan = 1;
+
+    return ret;
+}
+
+static RK_U32 get_start_code_size(RK_U8 *p, RK_U32 length)
+{
+    if (length > 3 && !p[0] && !p[1] && p[2] == 1)
+        return 3;
+
+    if (length > 4 && !p[0] && !p[1] && !p[2] && p[3] == 1)
+        return 4;
+
+    return 0;
+}
+
+/*
+ * split [start, end) at each start code, the range begins with a start code.
+ * A zero byte before 00 00 01 belongs to a 4 bytes start code as a nal unit
+ * never ends with zero byte.
+ */
+static MPP_RET split_range(MppEncNal *nal, RK_U8 *data, RK_U32 start, RK_U32 end)
+{
+    RK_U32 pos = start;
+    RK_U32 i = start + 3;
+
+    while (i + 2 < end) {
+        if (data[i + 2] > 1) {
+            i += 3;
+        } else if (data[i + 2] == 1 && !data[i + 1] && !data[i]) {
+            RK_U32 next = (data[i - 1]) ? (i) : (i - 1);
+
+            if (mpp_enc_nal_add(nal, pos, next - pos))
+                return MPP_NOK;
+
+            pos = next;
+            i += 3;
+        } else {
+            i++;
+        }
+    }
+
+    return mpp_enc_nal_add(nal, pos, end - pos);
+}
+
+MPP_RET mpp_enc_nal_finish(MppEncNal *nal, RK_U8 *data, RK_U32 length)
+{
+    RK_U32 end = 0;
+    RK_U32 i;
+
+    if (nal->overflow || NULL == data)
+        goto __FAILED;
+
+    if (nal->scan && nal->count) {
+        MppEncNalInfo *rest = &nal->nals[nal->count - 1];
+        RK_U32 start = rest->offset;
+        RK_U32 size = rest->length;
+
+        if (start > length || size > length - start)
+            goto __FAILED;
+
+        nal->count--;
+        nal->scan = 0;
+        if (split_range(nal, data, start, start + size))
+            goto __FAILED;
+    }
+
+    for (i = 0; i < nal->count; i++) {
+        MppEncNalInfo *info = &nal->nals[i];
+        RK_U8 *p = data + info->offset;
+        RK_U32 header;
+
+        if (info->offset < end || info->offset > length ||
+            info->length > length - info->offset)
+            goto __FAILED;
+
+        header = get_start_code_size(p, info->length);
+        if (!header)
+            goto __FAILED;
+
+        if (nal->coding == MPP_VIDEO_CodingHEVC) {
+            RK_U32 tid_plus1;
+
+            if (info->length < header + 2)
+                goto __FAILED;
+
+            tid_plus1 = p[header + 1] & 0x7;
+            if (!tid_plus1)
+                goto __FAILED;
+
+            info->type = (p[header] >> 1) & 0x3f;
+            info->temporal_id = tid_plus1 - 1;
+        } else {
+            info->type = p[header] & 0x1f;
+            info->temporal_id = 0;
+        }
+        info->header = header;
+        end = info->offset + info->length;
+    }
+
+    return MPP_OK;
+__FAILED:
+    mpp_log_f("drop invalid nal index of %d nal units\n", nal->count);
+    nal->count = 0;
+    nal->scan = 0;
+    return MPP_NOK;
+}
+
+MPP_RET mpp_enc_nal_scan(MppEncNal *nal, RK_U8 *data, RK_U32 length)
+{
+    mpp_enc_nal_reset(nal, nal->coding);
+    if (NULL == data || !length)
+        return MPP_NOK;
+
+    mpp_enc_nal_add_rest(nal, 0, length);
+    return mpp_enc_nal_finish(nal, data, length);
+}
+
+MPP_RET mpp_enc_nal_to_avcc(MppEncNal *nal, RK_U8 *data, RK_U32 *length,
+                            RK_U32 capacity)
+{
+    RK_U32 grow = 0;
+    RK_U32 end = 0;
+    RK_U32 i;
+
+    if (!nal->count)
+        return MPP_NOK;
+
+    /* nal units must cover the whole packet without gap */
+    for (i = 0; i < nal->count; i++) {
+        MppEncNalInfo *info = &nal->nals[i];
+
+        if (info->offset != end)
+            return MPP_NOK;
+
+        end += info->length;
+        if (info->header == 3)
+            grow++;
+    }
+
+    if (end != *length || *length + grow > capacity)
+        return MPP_NOK;
+
+    /*
+     * from the last nal unit so that moved payload never overwrites the
+     * data not converted yet
+     */
+    for (i = nal->count; i > 0; i--) {
+        MppEncNalInfo *info = &nal->nals[i - 1];
+        RK_U32 src = info->offset + info->header;
+        RK_U32 size = info->length - info->header;
+        RK_U8 *p = NULL;
+
+        if (info->header == 3)
+            grow--;
+
+        info->offset += grow;
+        info->length = size + AVCC_LENGTH_SIZE;
+        info->header = AVCC_LENGTH_SIZE;
+
+        p = data + info->offset;
+        if (p + AVCC_LENGTH_SIZE != data + src)
+            memmove(p + AVCC_LENGTH_SIZE, data + src, size);
+
+        p[0] = (RK_U8)(size >> 24);
+        p[1] = (RK_U8)(size >> 16);
+        p[2] = (RK_U8)(size >> 8);
+        p[3] = (RK_U8)(size);
+    }
+
+    end = nal->nals[nal->count - 1].offset + nal->nals[nal->count - 1].length;
+    *length = end;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_enc_nal_attach(MppEncNal *nal, MppPacket packet)
+{
+    MppMeta meta = mpp_packet_get_meta(packet);
+    MppPacket index = NULL;
+    RK_U32 size = nal->count * sizeof(MppEncNalInfo);
+    void *buf = NULL;
+
+    // drop the index left by previous frame on a reused packet
+    if (meta && MPP_OK == mpp_meta_get_packet(meta, MPP_META_KEY_OUTPUT_NAL, &index))
+        mpp_packet_deinit(&index);
+
+    if (!nal->count)
+        return MPP_OK;
+
+    if (NULL == meta) {
+        if (mpp_meta_get(&meta))
+            return MPP_NOK;
+        mpp_packet_set_meta(packet, meta);
+    }
+
+    buf = mpp_malloc_size(void, size);
+    if (NULL == buf)
+        return MPP_ERR_MALLOC;
+
+    memcpy(buf, nal->nals, size);
+
+    if (mpp_packet_init(&index, buf, size)) {
+        mpp_free(buf);
+        return MPP_NOK;
+    }
+    ((MppPacketImpl *)index)->flag |= MPP_PACKET_FLAG_INTERNAL;
+
+    return mpp_meta_set_packet(meta, MPP_META_KEY_OUTPUT_NAL, index);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_enc_slice"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_packet_impl.h"
+#include "mpp_enc_slice.h"
+
+void mpp_enc_slice_start(MppEncSliceOut *out, MppPort port, MppPacket packet)
+{
+    MppPacketImpl *frm = (MppPacketImpl *)packet;
+
+    memset(out, 0, sizeof(*out));
+    out->port = port;
+    out->packet = packet;
+
+    // packet given by user may be reused from previous frame
+    frm->flag &= ~(MPP_PACKET_FLAG_PARTITION | MPP_PACKET_FLAG_EOI |
+                   MPP_PACKET_FLAG_INTRA);
+}
+
+MPP_RET mpp_enc_slice_put(MppEncSliceOut *out, RK_U32 end, RK_U32 last)
+{
+    MppPacketImpl *frm = (MppPacketImpl *)out->packet;
+    MppPacket packet = NULL;
+    MppTask task = NULL;
+    RK_U8 *data = NULL;
+    RK_U32 flag = MPP_PACKET_FLAG_PARTITION;
+
+    if (out->done || end < out->pos || end > frm->size) {
+        mpp_err_f("invalid slice end %d pos %d size %d done %d\n",
+                  end, out->pos, frm->size, out->done);
+        return MPP_NOK;
+    }
+
+    if (end == out->pos && !last)
+        return MPP_OK;
+
+    data = (RK_U8 *)frm->data + out->pos;
+    if (last) {
+        flag |= MPP_PACKET_FLAG_EOI;
+        packet = out->packet;
+        frm->pos = data;
+        frm->length = end - out->pos;
+    } else {
+        if (mpp_packet_init(&packet, data, end - out->pos))
+            return MPP_NOK;
+
+        mpp_packet_set_buffer(packet, frm->buffer);
+        mpp_packet_set_pts(packet, frm->pts);
+        mpp_packet_set_dts(packet, frm->dts);
+    }
+
+    if (out->intra)
+        flag |= MPP_PACKET_FLAG_INTRA;
+    ((MppPacketImpl *)packet)->flag |= flag;
+
+    // user may still hold the packets sent before
+    mpp_port_poll(out->port, MPP_POLL_BLOCK);
+    mpp_port_dequeue(out->port, &task);
+    if (NULL == task) {
+        mpp_err_f("failed to get output task\n");
+        if (packet != out->packet)
+            mpp_packet_deinit(&packet);
+        return MPP_NOK;
+    }
+
+    mpp_task_meta_set_packet(task, MPP_META_KEY_OUTPUT_PKT, packet);
+    mpp_task_meta_set_s32(task, MPP_META_KEY_OUTPUT_INTRA, out->intra);
+    mpp_task_meta_set_s32(task, MPP_META_KEY_OUTPUT_SCENE, out->scene);
+    mpp_port_enqueue(out->port, task);
+
+    out->pos = end;
+    out->count++;
+    out->done = last;
+
+    return MPP_OK;
+}
@@ -20,15 +20,38 @@
 
 #include "mpp_log.h"
 #include "mpp_mem.h"
+#include "mpp_mem_pool.h"
+#include "mpp_meta.h"
 #include "mpp_frame_impl.h"
 
 static const char *module_name = MODULE_TAG;
 
+/*
+ * frame descriptors are recycled in a pool shared by all contexts
+ * the pool is never released as frames can be freed on process exit
+ */
+static MppMemPool get_frame_pool(void)
+{
+    static MppMemPool pool = mpp_mem_pool_init(module_name, sizeof(MppFrameImpl));
+    return pool;
+}
+
 static void setup_mpp_frame_name(MppFrameImpl *frame)
 {
     frame->name = module_name;
 }
 
+/* packets in frame meta are owned by the frame until user takes them */
+static void release_frame_meta(MppMeta meta)
+{
+    MppPacket packet = NULL;
+
+    if (MPP_OK == mpp_meta_get_packet(meta, MPP_META_KEY_OUTPUT_SEI, &packet))
+        mpp_packet_deinit(&packet);
+
+    mpp_meta_put(meta);
+}
+
 MPP_RET check_is_mpp_frame(void *frame)
 {
     if (frame && ((MppFrameImpl*)frame)->name == module_name)
@@ -46,7 +69,7 @@ MPP_RET mpp_frame_init(MppFrame *frame)
         return MPP_ERR_NULL_PTR;
     }
 
-    MppFrameImpl *p = mpp_calloc(MppFrameImpl, 1);
+    MppFrameImpl *p = (MppFrameImpl *)mpp_mem_pool_get(get_frame_pool());
     if (NULL == p) {
         mpp_err_f("malloc failed\n");
         return MPP_ERR_NULL_PTR;
@@ -69,7 +92,11 @@ MPP_RET mpp_frame_deinit(MppFrame *frame)
     if (buffer)
         mpp_buffer_put(buffer);
 
-    mpp_free(*frame);
+    MppMeta meta = mpp_frame_get_meta(*frame);
+    if (meta)
+        release_frame_meta(meta);
+
+    mpp_mem_pool_put(get_frame_pool(), *frame);
     *frame = NULL;
     return MPP_OK;
 }
@@ -102,6 +129,41 @@ MppBuffer mpp_frame_get_buffer(MppFrame frame)
     return (MppFrame)p->buffer;
 }
 
+MppMeta mpp_frame_get_meta(const MppFrame frame)
+{
+    if (check_is_mpp_frame(frame))
+        return NULL;
+
+    MppFrameImpl *p = (MppFrameImpl *)frame;
+    return p->meta;
+}
+
+void mpp_frame_set_meta(MppFrame frame, MppMeta meta)
+{
+    if (check_is_mpp_frame(frame))
+        return ;
+
+    MppFrameImpl *p = (MppFrameImpl *)frame;
+    if (p->meta != meta) {
+        if (p->meta)
+            release_frame_meta(p->meta);
+
+        p->meta = meta;
+    }
+}
+
+void mpp_frame_move_meta(MppFrame dst, MppFrame src)
+{
+    if (check_is_mpp_frame(dst) || check_is_mpp_frame(src))
+        return ;
+
+    MppFrameImpl *s = (MppFrameImpl *)src;
+    if (s->meta) {
+        mpp_frame_set_meta(dst, s->meta);
+        s->meta = NULL;
+    }
+}
+
 void mpp_frame_set_buffer(MppFrame frame, MppBuffer buffer)
 {
     if (check_is_mpp_frame(frame))
@@ -126,7 +188,10 @@ MPP_RET mpp_frame_copy(MppFrame dst, MppFrame src)
         return MPP_ERR_UNKNOW;
     }
 
+    MppMeta meta = ((MppFrameImpl *)dst)->meta;
+
     memcpy(dst, src, sizeof(MppFrameImpl));
+    ((MppFrameImpl *)dst)->meta = meta;
     return MPP_OK;
 }
 
@@ -191,3 +256,8 @@ MPP_FRAME_ACCESSORS(MppFrameChromaLocation, chroma_location)
 MPP_FRAME_ACCESSORS(MppFrameFormat, fmt)
 MPP_FRAME_ACCESSORS(size_t, buf_size)
 MPP_FRAME_ACCESSORS(RK_U32, errinfo)
+
+MPP_RET mpp_frame_pool_info(MppMemPoolInfo *info)
+{
+    return mpp_mem_pool_info(get_frame_pool(), info);
+}
@@ -23,24 +23,35 @@
 #include "mpp_frame.h"
 #include "mpp_packet.h"
 #include "mpp_common.h"
+#include "mpp_mem_pool.h"
 
 #include "mpp_meta.h"
 
+/* compile-time index of each key, meta_defs is in the same order */
+typedef enum MppMetaIdx_e {
+    META_IDX_INPUT_FRM,
+    META_IDX_OUTPUT_FRM,
+    META_IDX_INPUT_PKT,
+    META_IDX_OUTPUT_PKT,
+    META_IDX_MOTION_INFO,
+
+    META_IDX_INPUT_BLOCK,
+    META_IDX_OUTPUT_BLOCK,
+    META_IDX_INPUT_IDR_REQ,
+    META_IDX_OUTPUT_INTRA,
+    META_IDX_OUTPUT_SCENE,
+    META_IDX_INPUT_ROI,
+    META_IDX_OUTPUT_SEI,
+    META_IDX_OUTPUT_NAL,
+    META_IDX_OUTPUT_NAL_FMT,
+    META_IDX_BUTT,
+} MppMetaIdx;
+
 typedef struct MppMetaDef_t {
     MppMetaKey          key;
     MppMetaType         type;
 } MppMetaDef;
 
-typedef struct MppMetaImpl_t {
-    char                tag[MPP_TAG_SIZE];
-    const char          *caller;
-    RK_S32              meta_id;
-
-    struct list_head    list_meta;
-    struct list_head    list_node;
-    RK_S32              node_count;
-} MppMetaImpl;
-
 typedef union MppMetaVal_u {
     RK_S32          val_s32;
     RK_S64          val_s64;
@@ -50,15 +61,15 @@ typedef union MppMetaVal_u {
     MppBuffer       buffer;
 } MppMetaVal;
 
-typedef struct MppMetaNode_t {
-    struct list_head    list_meta;
-    struct list_head    list_node;
-    MppMetaImpl         *meta;
-    RK_S32              node_id;
+typedef struct MppMetaImpl_t {
+    char                tag[MPP_TAG_SIZE];
+    const char          *caller;
+    RK_S32              meta_id;
 
-    RK_S32              type_id;
-    MppMetaVal          val;
-} MppMetaNode;
+    // bit mask of MppMetaIdx with valid value, accessed by atomic operation
+    RK_U32              val_mask;
+    MppMetaVal          vals[META_IDX_BUTT];
+} MppMetaImpl;
 
 static MppMetaDef meta_defs[] = {
     /* categorized by type */
@@ -71,8 +82,42 @@ static MppMetaDef meta_defs[] = {
 
     {   MPP_META_KEY_INPUT_BLOCK,       MPP_META_TYPE_S32,      },
     {   MPP_META_KEY_OUTPUT_BLOCK,      MPP_META_TYPE_S32,      },
+    {   MPP_META_KEY_INPUT_IDR_REQ,     MPP_META_TYPE_S32,      },
+    {   MPP_META_KEY_OUTPUT_INTRA,      MPP_META_TYPE_S32,      },
+    {   MPP_META_KEY_OUTPUT_SCENE,      MPP_META_TYPE_S32,      },
+    {   MPP_META_KEY_INPUT_ROI,         MPP_META_TYPE_PTR,      },
+    {   MPP_META_KEY_OUTPUT_SEI,        MPP_META_TYPE_PACKET,   },
+    {   MPP_META_KEY_OUTPUT_NAL,        MPP_META_TYPE_PACKET,   },
+    {   MPP_META_KEY_OUTPUT_NAL_FMT,    MPP_META_TYPE_S32,      },
 };
 
+static RK_S32 meta_key_to_index(MppMetaKey key)
+{
+    switch (key) {
+    case MPP_META_KEY_INPUT_FRM :       return META_IDX_INPUT_FRM;
+    case MPP_META_KEY_OUTPUT_FRM :      return META_IDX_OUTPUT_FRM;
+    case MPP_META_KEY_INPUT_PKT :       return META_IDX_INPUT_PKT;
+    case MPP_META_KEY_OUTPUT_PKT :      return META_IDX_OUTPUT_PKT;
+    case MPP_META_KEY_MOTION_INFO :     return META_IDX_MOTION_INFO;
+    case MPP_META_KEY_INPUT_BLOCK :     return META_IDX_INPUT_BLOCK;
+    case MPP_META_KEY_OUTPUT_BLOCK :    return META_IDX_OUTPUT_BLOCK;
+    case MPP_META_KEY_INPUT_IDR_REQ :   return META_IDX_INPUT_IDR_REQ;
+    case MPP_META_KEY_OUTPUT_INTRA :    return META_IDX_OUTPUT_INTRA;
+    case MPP_META_KEY_OUTPUT_SCENE :    return META_IDX_OUTPUT_SCENE;
+    case MPP_META_KEY_INPUT_ROI :       return META_IDX_INPUT_ROI;
+    case MPP_META_KEY_OUTPUT_SEI :      return META_IDX_OUTPUT_SEI;
+    case MPP_META_KEY_OUTPUT_NAL :      return META_IDX_OUTPUT_NAL;
+    case MPP_META_KEY_OUTPUT_NAL_FMT :  return META_IDX_OUTPUT_NAL_FMT;
+    default : break;
+    }
+    return -1;
+}
+
+/*
+ * Meta objects are taken from a mpp_mem_pool which keeps a small free object
+ * cache in each thread so get / put normally runs without any lock. Value
+ * set / get only touches the meta object itself.
+ */
 class MppMetaService
 {
 private:
@@ -82,12 +127,10 @@ private:
     MppMetaService(const MppMetaService &);
     MppMetaService &operator=(const MppMetaService &);
 
-    struct list_head    mlist_meta;
-    struct list_head    mlist_node;
+    MppMemPool          pool;
 
-    RK_U32              meta_id;
-    RK_U32              meta_count;
-    RK_U32              node_count;
+    RK_S32              meta_id;
+    RK_S32              meta_count;
 
 public:
     static MppMetaService *get_instance()
@@ -95,86 +138,49 @@ public:
         static MppMetaService instance;
         return &instance;
     }
-    static Mutex *get_lock()
-    {
-        static Mutex lock;
-        return &lock;
-    }
-
-    /*
-     * get_index_of_key does two things:
-     * 1. Check the key / type pair is correct or not.
-     *    If failed on check return negative value
-     * 2. Compare all exsisting meta data defines to find the non-negative index
-     */
-    RK_S32 get_index_of_key(MppMetaKey key, MppMetaType type);
 
     MppMetaImpl  *get_meta(const char *tag, const char *caller);
     void          put_meta(MppMetaImpl *meta);
-
-    MppMetaNode  *get_node(MppMetaImpl *meta, RK_S32 index);
-    void          put_node(MppMetaNode *node);
-    MppMetaNode  *find_node(MppMetaImpl *meta, RK_S32 index);
 };
 
 MppMetaService::MppMetaService()
-  : meta_id(0),
-    meta_count(0),
-    node_count(0)
+  : pool(NULL),
+    meta_id(0),
+    meta_count(0)
 {
-    INIT_LIST_HEAD(&mlist_meta);
-    INIT_LIST_HEAD(&mlist_node);
-}
-
-MppMetaService::~MppMetaService()
-{
-    mpp_assert(list_empty(&mlist_meta));
-    mpp_assert(list_empty(&mlist_node));
-
-    while (!list_empty(&mlist_meta)) {
-        MppMetaImpl *pos, *n;
-        list_for_each_entry_safe(pos, n, &mlist_meta, MppMetaImpl, list_meta) {
-            put_meta(pos);
-        }
-    }
+    RK_U32 i;
 
-    mpp_assert(list_empty(&mlist_node));
+    mpp_assert(MPP_ARRAY_ELEMS(meta_defs) == META_IDX_BUTT);
+    mpp_assert(META_IDX_BUTT <= 32);
+    for (i = 0; i < MPP_ARRAY_ELEMS(meta_defs); i++)
+        mpp_assert(meta_key_to_index(meta_defs[i].key) == (RK_S32)i);
 
-    while (!list_empty(&mlist_node)) {
-        MppMetaNode *pos, *n;
-        list_for_each_entry_safe(pos, n, &mlist_node, MppMetaNode, list_node) {
-            put_node(pos);
-        }
-    }
+    pool = mpp_mem_pool_init(MODULE_TAG, sizeof(MppMetaImpl));
+    if (NULL == pool)
+        mpp_err_f("failed to init meta pool\n");
 }
 
-RK_S32 MppMetaService::get_index_of_key(MppMetaKey key, MppMetaType type)
+MppMetaService::~MppMetaService()
 {
-    RK_S32 i = 0;
-    RK_S32 num = MPP_ARRAY_ELEMS(meta_defs);
+    mpp_assert(meta_count == 0);
+    if (meta_count)
+        mpp_err_f("found %d meta data not released\n", meta_count);
 
-    for (i = 0; i < num; i++) {
-        if ((meta_defs[i].key == key) && (meta_defs[i].type == type))
-            break;
-    }
-
-    return (i < num) ? (i) : (-1);
+    mpp_mem_pool_deinit(pool);
+    pool = NULL;
 }
 
 MppMetaImpl *MppMetaService::get_meta(const char *tag, const char *caller)
 {
-    MppMetaImpl *impl = mpp_malloc(MppMetaImpl, 1);
+    MppMetaImpl *impl = (MppMetaImpl *)mpp_mem_pool_get(pool);
+
     if (impl) {
         const char *tag_src = (tag) ? (tag) : (MODULE_TAG);
+
         strncpy(impl->tag, tag_src, sizeof(impl->tag));
         impl->caller = caller;
-        impl->meta_id = meta_id++;
-        INIT_LIST_HEAD(&impl->list_meta);
-        INIT_LIST_HEAD(&impl->list_node);
-        impl->node_count = 0;
-
-        list_add_tail(&impl->list_meta, &mlist_meta);
-        meta_count++;
+        impl->meta_id = __atomic_fetch_add(&meta_id, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&meta_count, 1, __ATOMIC_RELAXED);
     } else {
         mpp_err_f("failed to malloc meta data\n");
     }
@@ -183,80 +189,10 @@ MppMetaImpl *MppMetaService::get_meta(const char *tag, const char *caller)
 
 void MppMetaService::put_meta(MppMetaImpl *meta)
 {
-    while (!list_empty(&meta->list_node)) {
-        MppMetaNode *node = list_entry(meta->list_node.next, MppMetaNode, list_meta);
-        put_node(node);
-        meta->node_count--;
-    }
-    list_del_init(&meta->list_meta);
-    meta_count--;
-    mpp_free(meta);
-}
-
-MppMetaNode *MppMetaService::find_node(MppMetaImpl *meta, RK_S32 type_id)
-{
-    MppMetaNode *node = NULL;
-    if (meta->node_count) {
-        MppMetaNode *n, *pos;
-
-        list_for_each_entry_safe(pos, n, &meta->list_node, MppMetaNode, list_meta) {
-            if (pos->type_id == type_id) {
-                node = pos;
-                break;
-            }
-        }
-    }
-    return node;
-}
-
-MppMetaNode *MppMetaService::get_node(MppMetaImpl *meta, RK_S32 type_id)
-{
-    MppMetaNode *node = find_node(meta, type_id);
-
-    if (NULL == node) {
-        node = mpp_malloc(MppMetaNode, 1);
-        if (node) {
-            INIT_LIST_HEAD(&node->list_meta);
-            INIT_LIST_HEAD(&node->list_node);
-            node->meta = meta;
-            node->node_id = meta->meta_id++;
-            node->type_id = type_id;
-            memset(&node->val, 0, sizeof(node->val));
-
-            meta->node_count++;
-            list_add_tail(&node->list_meta, &meta->list_node);
-            list_add_tail(&node->list_node, &mlist_node);
-            node_count++;
-        } else {
-            mpp_err_f("failed to malloc meta data node\n");
-        }
-    }
-
-    return node;
-}
-
-void MppMetaService::put_node(MppMetaNode *node)
-{
-    MppMetaImpl *meta = node->meta;
-    list_del_init(&node->list_meta);
-    list_del_init(&node->list_node);
-    meta->node_count--;
-    node_count--;
     // TODO: may be we need to release MppFrame / MppPacket / MppBuffer here
-    switch (meta_defs[node->type_id].type) {
-    case MPP_META_TYPE_FRAME : {
-        // mpp_frame_deinit(&node->val.frame);
-    } break;
-    case MPP_META_TYPE_PACKET : {
-        // mpp_packet_deinit(&node->val.packet);
-    } break;
-    case MPP_META_TYPE_BUFFER : {
-        //mpp_buffer_put(node->val.buffer);
-    } break;
-    default : {
-    } break;
-    }
-    mpp_free(node);
+    meta->val_mask = 0;
+    __atomic_fetch_sub(&meta_count, 1, __ATOMIC_RELAXED);
+    mpp_mem_pool_put(pool, meta);
 }
 
 MPP_RET mpp_meta_get_with_tag(MppMeta *meta, const char *tag, const char *caller)
@@ -267,7 +203,6 @@ MPP_RET mpp_meta_get_with_tag(MppMeta *meta, const char *tag, const char *caller
     }
 
     MppMetaService *service = MppMetaService::get_instance();
-    AutoMutex auto_lock(service->get_lock());
     MppMetaImpl *impl = service->get_meta(tag, caller);
     *meta = (MppMeta) impl;
     return (impl) ? (MPP_OK) : (MPP_NOK);
@@ -281,45 +216,40 @@ MPP_RET mpp_meta_put(MppMeta meta)
     }
 
     MppMetaService *service = MppMetaService::get_instance();
-    AutoMutex auto_lock(service->get_lock());
     MppMetaImpl *impl = (MppMetaImpl *)meta;
     service->put_meta(impl);
     return MPP_OK;
 }
 
+/*
+ * The value is written before its bit is set and read before its bit is
+ * cleared, so a meta object passed between threads needs no lock here.
+ * Get consumes the value like the old node list does.
+ */
 static MPP_RET set_val_by_key(MppMetaImpl *meta, MppMetaKey key, MppMetaType type, MppMetaVal *val)
 {
-    MPP_RET ret = MPP_NOK;
-    MppMetaService *service = MppMetaService::get_instance();
-    AutoMutex auto_lock(service->get_lock());
-    RK_S32 index = service->get_index_of_key(key, type);
-    if (index < 0)
-        return ret;
-
-    MppMetaNode *node = service->get_node(meta, index);
-    if (node) {
-        node->val = *val;
-        ret = MPP_OK;
-    }
-    return ret;
+    RK_S32 index = meta_key_to_index(key);
+    if (index < 0 || meta_defs[index].type != type)
+        return MPP_NOK;
+
+    meta->vals[index] = *val;
+    __atomic_fetch_or(&meta->val_mask, 1U << index, __ATOMIC_RELEASE);
+    return MPP_OK;
 }
 
 static MPP_RET get_val_by_key(MppMetaImpl *meta, MppMetaKey key, MppMetaType type, MppMetaVal *val)
 {
-    MPP_RET ret = MPP_NOK;
-    MppMetaService *service = MppMetaService::get_instance();
-    AutoMutex auto_lock(service->get_lock());
-    RK_S32 index = service->get_index_of_key(key, type);
-    if (index < 0)
-        return ret;
-
-    MppMetaNode *node = service->find_node(meta, index);
-    if (node) {
-        *val = node->val;
-        service->put_node(node);
-        ret = MPP_OK;
-    }
-    return ret;
+    RK_S32 index = meta_key_to_index(key);
+    if (index < 0 || meta_defs[index].type != type)
+        return MPP_NOK;
+
+    RK_U32 bit = 1U << index;
+    if (!(__atomic_load_n(&meta->val_mask, __ATOMIC_ACQUIRE) & bit))
+        return MPP_NOK;
+
+    *val = meta->vals[index];
+    __atomic_fetch_and(&meta->val_mask, ~bit, __ATOMIC_RELEASE);
+    return MPP_OK;
 }
 
 MPP_RET mpp_meta_set_s32(MppMeta meta, MppMetaKey key, RK_S32 val)
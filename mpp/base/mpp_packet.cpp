@@ -20,11 +20,31 @@
 
 #include "mpp_log.h"
 #include "mpp_mem.h"
+#include "mpp_mem_pool.h"
+#include "mpp_meta.h"
 #include "mpp_packet.h"
 #include "mpp_packet_impl.h"
 
 static const char *module_name = MODULE_TAG;
 
+/* packets in packet meta are owned by the packet until user takes them */
+static void release_packet_meta(MppMeta meta)
+{
+    MppPacket packet = NULL;
+
+    if (MPP_OK == mpp_meta_get_packet(meta, MPP_META_KEY_OUTPUT_NAL, &packet))
+        mpp_packet_deinit(&packet);
+
+    mpp_meta_put(meta);
+}
+
+/* packet descriptor pool, never released as mpp_frame does */
+static MppMemPool get_packet_pool(void)
+{
+    static MppMemPool pool = mpp_mem_pool_init(module_name, sizeof(MppPacketImpl));
+    return pool;
+}
+
 #define setup_mpp_packet_name(packet) \
     ((MppPacketImpl*)packet)->name = module_name;
 
@@ -45,7 +65,7 @@ MPP_RET mpp_packet_new(MppPacket *packet)
         return MPP_ERR_NULL_PTR;
     }
 
-    MppPacketImpl *p = mpp_calloc(MppPacketImpl, 1);
+    MppPacketImpl *p = (MppPacketImpl *)mpp_mem_pool_get(get_packet_pool());
     *packet = p;
     if (NULL == p) {
         mpp_err_f("malloc failed\n");
@@ -113,7 +133,9 @@ MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
     if (src_impl->buffer) {
         /* if source packet has buffer just create a new reference to buffer */
         memcpy(pkt, src_impl, sizeof(*src_impl));
+        ((MppPacketImpl *)pkt)->meta = NULL;
         mpp_buffer_inc_ref(src_impl->buffer);
+        *packet = pkt;
         return MPP_OK;
     }
 
@@ -134,6 +156,7 @@ MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
     p->data = p->pos = data;
     p->size = p->length = size;
     p->flag |= MPP_PACKET_FLAG_INTERNAL;
+    p->meta = NULL;
     if (size) {
         memcpy(data, src_impl->data, size);
         /*
@@ -162,7 +185,10 @@ MPP_RET mpp_packet_deinit(MppPacket *packet)
         mpp_free(p->data);
     }
 
-    mpp_free(p);
+    if (p->meta)
+        release_packet_meta(p->meta);
+
+    mpp_mem_pool_put(get_packet_pool(), p);
     *packet = NULL;
     return MPP_OK;
 }
@@ -207,6 +233,24 @@ RK_U32 mpp_packet_get_eos(MppPacket packet)
     return (p->flag & MPP_PACKET_FLAG_EOS) ? (1) : (0);
 }
 
+RK_U32 mpp_packet_is_partition(const MppPacket packet)
+{
+    if (check_is_mpp_packet(packet))
+        return 0;
+
+    MppPacketImpl *p = (MppPacketImpl *)packet;
+    return (p->flag & MPP_PACKET_FLAG_PARTITION) ? (1) : (0);
+}
+
+RK_U32 mpp_packet_is_eoi(const MppPacket packet)
+{
+    if (check_is_mpp_packet(packet))
+        return 0;
+
+    MppPacketImpl *p = (MppPacketImpl *)packet;
+    return (p->flag & MPP_PACKET_FLAG_EOI) ? (1) : (0);
+}
+
 MPP_RET mpp_packet_set_extra_data(MppPacket packet)
 {
     if (check_is_mpp_packet(packet))
@@ -253,6 +297,29 @@ MppBuffer mpp_packet_get_buffer(const MppPacket packet)
     return p->buffer;
 }
 
+MppMeta mpp_packet_get_meta(const MppPacket packet)
+{
+    if (check_is_mpp_packet(packet))
+        return NULL;
+
+    MppPacketImpl *p = (MppPacketImpl *)packet;
+    return p->meta;
+}
+
+void mpp_packet_set_meta(MppPacket packet, MppMeta meta)
+{
+    if (check_is_mpp_packet(packet))
+        return ;
+
+    MppPacketImpl *p = (MppPacketImpl *)packet;
+    if (p->meta != meta) {
+        if (p->meta)
+            release_packet_meta(p->meta);
+
+        p->meta = meta;
+    }
+}
+
 MPP_RET mpp_packet_read(MppPacket packet, size_t offset, void *data, size_t size)
 {
     if (check_is_mpp_packet(packet) || NULL == data) {
@@ -307,3 +374,8 @@ MPP_PACKET_ACCESSORS(RK_S64, pts)
 MPP_PACKET_ACCESSORS(RK_S64, dts)
 MPP_PACKET_ACCESSORS(RK_U32, flag)
 
+
+MPP_RET mpp_packet_pool_info(MppMemPoolInfo *info)
+{
+    return mpp_mem_pool_info(get_packet_pool(), info);
+}
@@ -16,10 +16,12 @@
 
 #define MODULE_TAG "mpp_task_impl"
 
+#include <time.h>
 #include <string.h>
 
 #include "mpp_log.h"
 #include "mpp_mem.h"
+#include "mpp_thread.h"
 
 #include "mpp_task_impl.h"
 
@@ -33,6 +35,8 @@ typedef struct MppTaskStatusInfo_t {
 
 typedef struct MppTaskQueueImpl_t {
     Mutex               *lock;
+    // signaled when task is enqueued to either port
+    Condition           *cond;
     RK_S32              task_count;
 
     // two ports inside of task queue
@@ -119,6 +123,46 @@ MPP_RET mpp_port_can_dequeue(MppPort port)
     return MPP_NOK;
 }
 
+MPP_RET mpp_port_poll(MppPort port, MppPollType timeout)
+{
+    MppPortImpl *port_impl = (MppPortImpl *)port;
+    MppTaskQueueImpl *queue = port_impl->queue;
+
+    AutoMutex auto_lock(queue->lock);
+    MppTaskStatusInfo *curr = &queue->info[port_impl->status_curr];
+
+    if (curr->count || timeout == MPP_POLL_NON_BLOCK)
+        return (curr->count) ? (MPP_OK) : (MPP_NOK);
+
+    if (timeout < 0) {
+        while (!curr->count)
+            queue->cond->wait(*queue->lock);
+    } else {
+        struct timespec ts;
+        RK_S64 deadline;
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        deadline = (RK_S64)ts.tv_sec * 1000000000 + ts.tv_nsec +
+                   (RK_S64)timeout * 1000000;
+
+        while (!curr->count) {
+            RK_S64 now;
+
+            // Condition::timedwait takes absolute time with second in high 32 bits
+            queue->cond->timedwait(*queue->lock,
+                                   ((deadline / 1000000000) << 32) |
+                                   (deadline % 1000000000));
+
+            clock_gettime(CLOCK_REALTIME, &ts);
+            now = (RK_S64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+            if (now >= deadline)
+                break;
+        }
+    }
+
+    return (curr->count) ? (MPP_OK) : (MPP_NOK);
+}
+
 MPP_RET mpp_port_dequeue(MppPort port, MppTask *task)
 {
     MppPortImpl *port_impl = (MppPortImpl *)port;
@@ -169,6 +213,8 @@ MPP_RET mpp_port_enqueue(MppPort port, MppTask task)
     list_add_tail(&task_impl->list, &next->list);
     next->count++;
     task_impl->status = next->status;
+    // waiters of both ports share the condition so wake them all
+    queue->cond->broadcast();
 
     return MPP_OK;
 }
@@ -183,6 +229,7 @@ MPP_RET mpp_task_queue_init(MppTaskQueue *queue)
     MppTaskQueueImpl *p = NULL;
     MppTaskImpl *tasks = NULL;
     Mutex *lock = NULL;
+    Condition *cond = NULL;
 
     do {
         RK_S32 i;
@@ -197,6 +244,11 @@ MPP_RET mpp_task_queue_init(MppTaskQueue *queue)
             mpp_err_f("new lock failed\n");
             break;;
         }
+        cond = new Condition();
+        if (NULL == cond) {
+            mpp_err_f("new cond failed\n");
+            break;
+        }
 
         for (i = 0; i < MPP_TASK_STATUS_BUTT; i++) {
             INIT_LIST_HEAD(&p->info[i].list);
@@ -205,6 +257,7 @@ MPP_RET mpp_task_queue_init(MppTaskQueue *queue)
         }
 
         p->lock         = lock;
+        p->cond         = cond;
         p->tasks        = tasks;
 
         if (mpp_port_init(p, MPP_PORT_INPUT, &p->input))
@@ -223,6 +276,8 @@ MPP_RET mpp_task_queue_init(MppTaskQueue *queue)
         mpp_free(p);
     if (lock)
         delete lock;
+    if (cond)
+        delete cond;
     if (tasks)
         mpp_free(tasks);
 
@@ -290,6 +345,8 @@ MPP_RET mpp_task_queue_deinit(MppTaskQueue queue)
     }
     if (p->lock)
         delete p->lock;
+    if (p->cond)
+        delete p->cond;
     mpp_free(p);
     return MPP_OK;
 }
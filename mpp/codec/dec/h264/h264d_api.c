@@ -428,6 +428,9 @@ MPP_RET h264d_init(void *decoder, ParserCfg *init)
     FUN_CHECK(ret = init_cur_ctx(p_Dec->p_Cur));
     FUN_CHECK(ret = init_vid_ctx(p_Dec->p_Vid));
     FUN_CHECK(ret = init_dec_ctx(p_Dec));
+    mpp_dec_skip_init(&p_Dec->skip);
+    p_Dec->skip_structure = FRAME;
+    mpp_dec_sei_init(&p_Dec->sei);
 
     FunctionOut(p_Dec->logctx.parr[RUN_PARSE]);
 
@@ -458,6 +461,7 @@ MPP_RET h264d_deinit(void *decoder)
     free_vid_ctx(p_Dec->p_Vid);
     MPP_FREE(p_Dec->p_Vid);
     free_dec_ctx(p_Dec);
+    mpp_dec_sei_deinit(&p_Dec->sei);
 
     FunctionOut(p_Dec->logctx.parr[RUN_PARSE]);
     logctx_deinit(&p_Dec->logctx);
@@ -526,6 +530,9 @@ MPP_RET h264d_reset(void *decoder)
     p_Dec->dxva_ctx->strm_offset = 0;
     p_Dec->dxva_ctx->slice_count = 0;
     p_Dec->last_frame_slot_idx   = -1;
+    p_Dec->skip_structure        = FRAME;
+    mpp_dec_skip_reset(&p_Dec->skip);
+    mpp_dec_sei_clear(&p_Dec->sei);
     FunctionOut(p_Dec->logctx.parr[RUN_PARSE]);
 __RETURN:
     return ret = MPP_OK;
@@ -595,11 +602,20 @@ MPP_RET  h264d_control(void *decoder, RK_S32 cmd_type, void *param)
     INP_CHECK(ret, !decoder);
     FunctionIn(p_Dec->logctx.parr[RUN_PARSE]);
 
-    (void)cmd_type;
-    (void)param;
+    switch (cmd_type) {
+    case MPP_DEC_SET_SKIP_MODE : {
+        ret = mpp_dec_skip_set(&p_Dec->skip, (MppDecSkipCfg *)param);
+    } break;
+    case MPP_DEC_SET_SEI_MASK : {
+        ret = mpp_dec_sei_set(&p_Dec->sei, *((RK_U32 *)param));
+    } break;
+    default : {
+        ret = MPP_OK;
+    } break;
+    }
     FunctionOut(p_Dec->logctx.parr[RUN_PARSE]);
 __RETURN:
-    return ret = MPP_OK;
+    return ret;
 }
 
 /*!
@@ -715,8 +731,16 @@ MPP_RET h264d_parse(void *decoder, HalDecTask *in_task)
     FUN_CHECK(ret = parse_loop(p_Dec));
 
     if (p_Dec->is_parser_end) {
+        H264_StorePic_t *dec_pic = p_Dec->p_Vid->dec_pic;
+
         p_Dec->is_parser_end = 0;
         p_Dec->p_Vid->g_framecnt++;
+        //!< subscribed sei goes with the picture, both fields share one frame
+        if (dec_pic && dec_pic->mem_mark && dec_pic->mem_mark->slot_idx >= 0) {
+            MppFrame mframe = NULL;
+            mpp_buf_slot_get_prop(p_Dec->frame_slots, dec_pic->mem_mark->slot_idx, SLOT_FRAME_PTR, &mframe);
+            mpp_dec_sei_attach(&p_Dec->sei, mframe, dec_pic->combine_flag);
+        }
         ret = update_dpb(p_Dec);
         if (in_task->flags.eos) {
             h264d_flush(decoder);
@@ -730,6 +754,9 @@ MPP_RET h264d_parse(void *decoder, HalDecTask *in_task)
         in_task->syntax.data   = (void *)p_Dec->dxva_ctx->syn.buf;
         in_task->flags.used_for_ref = p_err->used_ref_flag;
         in_task->flags.had_error = (p_err->dpb_err_flag | p_err->cur_err_flag) ? 1 : 0;
+    } else if (in_task->flags.eos) {
+        //!< last picture is skipped, output the left pictures in dpb
+        h264d_flush(decoder);
     }
 __RETURN:
     FunctionOut(p_Dec->logctx.parr[RUN_PARSE]);
@@ -231,6 +231,24 @@ static RK_U32 is_long_term_reference(H264_FrameStore_t* fs)
     return 0;
 }
 
+static RK_S32 get_fs_sort_key(H264_FrameStore_t *fs, RK_U32 long_term)
+{
+    return long_term ? fs->long_term_frame_idx : fs->poc;
+}
+
+/* insert fs into list[0, size) kept in ascending poc or long_term_frame_idx order */
+static void insert_fs_sorted(H264_FrameStore_t **list, RK_U32 size, H264_FrameStore_t *fs, RK_U32 long_term)
+{
+    RK_S32 key = get_fs_sort_key(fs, long_term);
+    RK_U32 i = size;
+
+    while (i > 0 && get_fs_sort_key(list[i - 1], long_term) > key) {
+        list[i] = list[i - 1];
+        i--;
+    }
+    list[i] = fs;
+}
+
 static void unmark_for_long_term_reference(H264_FrameStore_t* fs)
 {
     if (fs->is_used & 1) {
@@ -1415,6 +1433,10 @@ void free_dpb(H264_DpbBuf_t *p_Dpb)
     }
     MPP_FREE(p_Dpb->fs_ref);
     MPP_FREE(p_Dpb->fs_ltref);
+    MPP_FREE(p_Dpb->fs_ref_poc);
+    MPP_FREE(p_Dpb->fs_ltref_idx);
+    MPP_FREE(p_Dpb->fs_list[0]);
+    MPP_FREE(p_Dpb->fs_list[1]);
     if (p_Dpb->fs_ilref) {
         for (i = 0; i < 1; i++) {
             free_frame_store(p_Vid->p_Dec, p_Dpb->fs_ilref[i]);
@@ -1443,6 +1465,7 @@ void update_ref_list(H264_DpbBuf_t *p_Dpb)
     RK_U8 i = 0, j = 0;
     for (i = 0, j = 0; i < p_Dpb->used_size; i++) {
         if (is_short_term_reference(p_Dpb->fs[i])) {
+            insert_fs_sorted(p_Dpb->fs_ref_poc, j, p_Dpb->fs[i], 0);
             p_Dpb->fs_ref[j++] = p_Dpb->fs[i];
         }
     }
@@ -1450,6 +1473,7 @@ void update_ref_list(H264_DpbBuf_t *p_Dpb)
     p_Dpb->ref_frames_in_buffer = j;
 
     while (j < p_Dpb->size) {
+        p_Dpb->fs_ref_poc[j] = NULL;
         p_Dpb->fs_ref[j++] = NULL;
     }
 }
@@ -1465,6 +1489,7 @@ void update_ltref_list(H264_DpbBuf_t *p_Dpb)
     RK_U8 i = 0, j = 0;
     for (i = 0, j = 0; i < p_Dpb->used_size; i++) {
         if (is_long_term_reference(p_Dpb->fs[i])) {
+            insert_fs_sorted(p_Dpb->fs_ltref_idx, j, p_Dpb->fs[i], 1);
             p_Dpb->fs_ltref[j++] = p_Dpb->fs[i];
         }
     }
@@ -1472,6 +1497,7 @@ void update_ltref_list(H264_DpbBuf_t *p_Dpb)
     p_Dpb->ltref_frames_in_buffer = j;
 
     while (j < p_Dpb->size) {
+        p_Dpb->fs_ltref_idx[j] = NULL;
         p_Dpb->fs_ltref[j++] = NULL;
     }
 }
@@ -1732,7 +1758,12 @@ MPP_RET init_dpb(H264dVideoCtx_t *p_Vid, H264_DpbBuf_t *p_Dpb, RK_S32 type)  //
     p_Dpb->fs_ref   = mpp_calloc(H264_FrameStore_t*, p_Dpb->size);
     p_Dpb->fs_ltref = mpp_calloc(H264_FrameStore_t*, p_Dpb->size);
     p_Dpb->fs_ilref = mpp_calloc(H264_FrameStore_t*, 1);  //!< inter-layer reference (for multi-layered codecs)
+    p_Dpb->fs_ref_poc   = mpp_calloc(H264_FrameStore_t*, p_Dpb->size);
+    p_Dpb->fs_ltref_idx = mpp_calloc(H264_FrameStore_t*, p_Dpb->size);
+    p_Dpb->fs_list[0]   = mpp_calloc(H264_FrameStore_t*, p_Dpb->size);
+    p_Dpb->fs_list[1]   = mpp_calloc(H264_FrameStore_t*, p_Dpb->size);
     MEM_CHECK(ret, p_Dpb->fs && p_Dpb->fs_ref && p_Dpb->fs_ltref && p_Dpb->fs_ilref);
+    MEM_CHECK(ret, p_Dpb->fs_ref_poc && p_Dpb->fs_ltref_idx && p_Dpb->fs_list[0] && p_Dpb->fs_list[1]);
     for (i = 0; i < p_Dpb->size; i++) {
         p_Dpb->fs[i] = alloc_frame_store();
         MEM_CHECK(ret, p_Dpb->fs[i]);
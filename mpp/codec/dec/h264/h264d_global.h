@@ -22,6 +22,9 @@
 #include "rk_type.h"
 #include "rk_mpi.h"
 
+#include "mpp_dec_skip.h"
+#include "mpp_dec_sei.h"
+
 #include "h264d_api.h"
 #include "h264d_log.h"
 #include "h264d_syntax.h"
@@ -313,6 +316,11 @@ typedef struct h264_dpb_buf_t {
     struct h264_frame_store_t  **fs_ref;
     struct h264_frame_store_t  **fs_ltref;
     struct h264_frame_store_t  **fs_ilref;   //!< inter-layer reference (for multi-layered codecs)
+    //!< fs_ref sorted by poc ascending and fs_ltref sorted by long_term_frame_idx ascending,
+    //!< kept in order on every marking operation for reference list initialization
+    struct h264_frame_store_t  **fs_ref_poc;
+    struct h264_frame_store_t  **fs_ltref_idx;
+    struct h264_frame_store_t  **fs_list[2]; //!< field list initialization scratch
     struct h264_frame_store_t   *last_picture;
 
     struct h264d_video_ctx_t   *p_Vid;
@@ -1055,6 +1063,14 @@ typedef struct h264_dec_ctx_t {
     HalDecTask                *in_task;
     RK_S32                     last_frame_slot_idx;
     struct h264_err_ctx_t      errctx;
+
+    //!< picture skip mode, the second field follows the first field
+    MppDecSkip                 skip;
+    RK_U32                     skip_pic;
+    RK_S32                     skip_structure;
+    RK_S32                     skip_frame_num;
+    //!< subscribed sei payload of current picture
+    MppDecSei                  sei;
 } H264_DecCtx_t;
 
 #endif /* __H264D_GLOBAL_H__ */
@@ -949,6 +949,27 @@ static RK_S32 compare_fs_by_poc_asc(const void *arg1, const void *arg2)
         return 0;
 }
 
+/*!
+***********************************************************************
+* \brief
+*    insertion sort for reference list initialization, the candidates are
+*    gathered from the ordered dpb lists so it is linear in normal streams
+***********************************************************************
+*/
+static void sort_ref_list(void **list, RK_S32 size, RK_S32 (*compare)(const void *, const void *))
+{
+    RK_S32 i = 0, j = 0;
+
+    for (i = 1; i < size; i++) {
+        void *cur = list[i];
+
+        for (j = i; j > 0 && compare(&list[j - 1], &cur) > 0; j--) {
+            list[j] = list[j - 1];
+        }
+        list[j] = cur;
+    }
+}
+
 static MPP_RET init_lists_p_slice_mvc(H264_SLICE_t *currSlice)
 {
     RK_U32 i = 0;
@@ -967,48 +988,44 @@ static MPP_RET init_lists_p_slice_mvc(H264_SLICE_t *currSlice)
     currSlice->listinterviewidx0 = 0;
     currSlice->listinterviewidx1 = 0;
 
+    //!< fs_ref is in decoding order, walk it backward to get PicNum nearly descending
     if (currSlice->structure == FRAME) {
-        for (i = 0; i < p_Dpb->ref_frames_in_buffer; i++) {
-            if (p_Dpb->fs_ref[i]->is_used == 3) {
-                if ((p_Dpb->fs_ref[i]->frame->used_for_reference) && (!p_Dpb->fs_ref[i]->frame->is_long_term)) {
-                    currSlice->listP[0][list0idx++] = p_Dpb->fs_ref[i]->frame;
+        for (i = p_Dpb->ref_frames_in_buffer; i > 0; i--) {
+            if (p_Dpb->fs_ref[i - 1]->is_used == 3) {
+                if ((p_Dpb->fs_ref[i - 1]->frame->used_for_reference) && (!p_Dpb->fs_ref[i - 1]->frame->is_long_term)) {
+                    currSlice->listP[0][list0idx++] = p_Dpb->fs_ref[i - 1]->frame;
                 }
             }
         }
         // order list 0 by PicNum
-        qsort((void *)currSlice->listP[0], list0idx, sizeof(H264_StorePic_t*), compare_pic_by_pic_num_desc);
+        sort_ref_list((void **)currSlice->listP[0], list0idx, compare_pic_by_pic_num_desc);
         currSlice->listXsizeP[0] = (RK_U8)list0idx;
         // long term handling
         for (i = 0; i < p_Dpb->ltref_frames_in_buffer; i++) {
-            if (p_Dpb->fs_ltref[i]->is_used == 3) {
-                if (p_Dpb->fs_ltref[i]->frame->is_long_term) {
-                    currSlice->listP[0][list0idx++] = p_Dpb->fs_ltref[i]->frame;
+            if (p_Dpb->fs_ltref_idx[i]->is_used == 3) {
+                if (p_Dpb->fs_ltref_idx[i]->frame->is_long_term) {
+                    currSlice->listP[0][list0idx++] = p_Dpb->fs_ltref_idx[i]->frame;
                 }
             }
         }
-        qsort((void *)&currSlice->listP[0][(RK_S16)currSlice->listXsizeP[0]],
-              list0idx - currSlice->listXsizeP[0], sizeof(H264_StorePic_t*), compare_pic_by_lt_pic_num_asc);
+        sort_ref_list((void **)&currSlice->listP[0][(RK_S16)currSlice->listXsizeP[0]],
+                      list0idx - currSlice->listXsizeP[0], compare_pic_by_lt_pic_num_asc);
         currSlice->listXsizeP[0] = (RK_U8)list0idx;
     } else {
-        fs_list0  = mpp_calloc(H264_FrameStore_t*, p_Dpb->size);
-        fs_listlt = mpp_calloc(H264_FrameStore_t*, p_Dpb->size);
-        MEM_CHECK(ret, fs_list0 && fs_listlt);
-        for (i = 0; i < p_Dpb->ref_frames_in_buffer; i++) {
-            if (p_Dpb->fs_ref[i]->is_reference) {
-                fs_list0[list0idx++] = p_Dpb->fs_ref[i];
+        fs_list0  = p_Dpb->fs_list[0];
+        fs_listlt = p_Dpb->fs_ltref_idx;
+        for (i = p_Dpb->ref_frames_in_buffer; i > 0; i--) {
+            if (p_Dpb->fs_ref[i - 1]->is_reference) {
+                fs_list0[list0idx++] = p_Dpb->fs_ref[i - 1];
             }
         }
-        qsort((void *)fs_list0, list0idx, sizeof(H264_FrameStore_t*), compare_fs_by_frame_num_desc);
+        sort_ref_list((void **)fs_list0, list0idx, compare_fs_by_frame_num_desc);
         currSlice->listXsizeP[0] = 0;
         gen_pic_list_from_frame_list(currSlice->structure, fs_list0, list0idx, currSlice->listP[0], &currSlice->listXsizeP[0], 0);
         // long term handling
-        for (i = 0; i < p_Dpb->ltref_frames_in_buffer; i++) {
-            fs_listlt[listltidx++] = p_Dpb->fs_ltref[i];
-        }
-        qsort((void *)fs_listlt, listltidx, sizeof(H264_FrameStore_t*), compare_fs_by_lt_pic_idx_asc);
+        listltidx = p_Dpb->ltref_frames_in_buffer;
+        sort_ref_list((void **)fs_listlt, listltidx, compare_fs_by_lt_pic_idx_asc);
         gen_pic_list_from_frame_list(currSlice->structure, fs_listlt, listltidx, currSlice->listP[0], &currSlice->listXsizeP[0], 1);
-        MPP_FREE(fs_list0);
-        MPP_FREE(fs_listlt);
     }
 
     currSlice->listXsizeP[1] = 0;
@@ -1042,8 +1059,6 @@ static MPP_RET init_lists_p_slice_mvc(H264_SLICE_t *currSlice)
 
     return ret = MPP_OK;
 __FAILED:
-    MPP_FREE(fs_list0);
-    MPP_FREE(fs_listlt);
     MPP_FREE(currSlice->fs_listinterview0);
 
     return ret;
@@ -1071,28 +1086,29 @@ static MPP_RET init_lists_b_slice_mvc(H264_SLICE_t *currSlice)
     currSlice->listinterviewidx0 = 0;
     currSlice->listinterviewidx1 = 0;
     // B-Slice
+    //!< fs_ref_poc is in poc ascending order, walk it backward for the descending part
     if (currSlice->structure == FRAME) {
-        for (i = 0; i < p_Dpb->ref_frames_in_buffer; i++) {
-            if (p_Dpb->fs_ref[i]->is_used == 3) {
-                if ((p_Dpb->fs_ref[i]->frame->used_for_reference) && (!p_Dpb->fs_ref[i]->frame->is_long_term)) {
-                    if (currSlice->framepoc >= p_Dpb->fs_ref[i]->frame->poc) {
-                        currSlice->listB[0][list0idx++] = p_Dpb->fs_ref[i]->frame;
+        for (i = p_Dpb->ref_frames_in_buffer; i > 0; i--) {
+            if (p_Dpb->fs_ref_poc[i - 1]->is_used == 3) {
+                if ((p_Dpb->fs_ref_poc[i - 1]->frame->used_for_reference) && (!p_Dpb->fs_ref_poc[i - 1]->frame->is_long_term)) {
+                    if (currSlice->framepoc >= p_Dpb->fs_ref_poc[i - 1]->frame->poc) {
+                        currSlice->listB[0][list0idx++] = p_Dpb->fs_ref_poc[i - 1]->frame;
                     }
                 }
             }
         }
-        qsort((void *)currSlice->listB[0], list0idx, sizeof(H264_StorePic_t*), compare_pic_by_poc_desc);
+        sort_ref_list((void **)currSlice->listB[0], list0idx, compare_pic_by_poc_desc);
         list0idx_1 = list0idx;
         for (i = 0; i < p_Dpb->ref_frames_in_buffer; i++) {
-            if (p_Dpb->fs_ref[i]->is_used == 3) {
-                if ((p_Dpb->fs_ref[i]->frame->used_for_reference) && (!p_Dpb->fs_ref[i]->frame->is_long_term)) {
-                    if (currSlice->framepoc < p_Dpb->fs_ref[i]->frame->poc) {
-                        currSlice->listB[0][list0idx++] = p_Dpb->fs_ref[i]->frame;
+            if (p_Dpb->fs_ref_poc[i]->is_used == 3) {
+                if ((p_Dpb->fs_ref_poc[i]->frame->used_for_reference) && (!p_Dpb->fs_ref_poc[i]->frame->is_long_term)) {
+                    if (currSlice->framepoc < p_Dpb->fs_ref_poc[i]->frame->poc) {
+                        currSlice->listB[0][list0idx++] = p_Dpb->fs_ref_poc[i]->frame;
                     }
                 }
             }
         }
-        qsort((void *)&currSlice->listB[0][list0idx_1], list0idx - list0idx_1, sizeof(H264_StorePic_t*), compare_pic_by_poc_asc);
+        sort_ref_list((void **)&currSlice->listB[0][list0idx_1], list0idx - list0idx_1, compare_pic_by_poc_asc);
 
         for (j = 0; j < list0idx_1; j++) {
             currSlice->listB[1][list0idx - list0idx_1 + j] = currSlice->listB[0][j];
@@ -1103,42 +1119,41 @@ static MPP_RET init_lists_b_slice_mvc(H264_SLICE_t *currSlice)
         currSlice->listXsizeB[0] = currSlice->listXsizeB[1] = (RK_U8)list0idx;
         // long term handling
         for (i = 0; i < p_Dpb->ltref_frames_in_buffer; i++) {
-            if (p_Dpb->fs_ltref[i]->is_used == 3) {
-                if (p_Dpb->fs_ltref[i]->frame->is_long_term) {
-                    currSlice->listB[0][list0idx] = p_Dpb->fs_ltref[i]->frame;
-                    currSlice->listB[1][list0idx++] = p_Dpb->fs_ltref[i]->frame;
+            if (p_Dpb->fs_ltref_idx[i]->is_used == 3) {
+                if (p_Dpb->fs_ltref_idx[i]->frame->is_long_term) {
+                    currSlice->listB[0][list0idx] = p_Dpb->fs_ltref_idx[i]->frame;
+                    currSlice->listB[1][list0idx++] = p_Dpb->fs_ltref_idx[i]->frame;
                 }
             }
         }
-        qsort((void *)&currSlice->listB[0][(RK_S16)currSlice->listXsizeB[0]],
-              list0idx - currSlice->listXsizeB[0], sizeof(H264_StorePic_t*), compare_pic_by_lt_pic_num_asc);
-        qsort((void *)&currSlice->listB[1][(RK_S16)currSlice->listXsizeB[0]],
-              list0idx - currSlice->listXsizeB[0], sizeof(H264_StorePic_t*), compare_pic_by_lt_pic_num_asc);
+        sort_ref_list((void **)&currSlice->listB[0][(RK_S16)currSlice->listXsizeB[0]],
+                      list0idx - currSlice->listXsizeB[0], compare_pic_by_lt_pic_num_asc);
+        sort_ref_list((void **)&currSlice->listB[1][(RK_S16)currSlice->listXsizeB[0]],
+                      list0idx - currSlice->listXsizeB[0], compare_pic_by_lt_pic_num_asc);
         currSlice->listXsizeB[0] = currSlice->listXsizeB[1] = (RK_U8)list0idx;
     } else {
-        fs_list0  = mpp_calloc(H264_FrameStore_t*, p_Dpb->size);
-        fs_list1  = mpp_calloc(H264_FrameStore_t*, p_Dpb->size);
-        fs_listlt = mpp_calloc(H264_FrameStore_t*, p_Dpb->size);
-        MEM_CHECK(ret, fs_list0 && fs_list1 && fs_listlt);
+        fs_list0  = p_Dpb->fs_list[0];
+        fs_list1  = p_Dpb->fs_list[1];
+        fs_listlt = p_Dpb->fs_ltref_idx;
         currSlice->listXsizeB[0] = 0;
         currSlice->listXsizeB[1] = 1;
-        for (i = 0; i < p_Dpb->ref_frames_in_buffer; i++) {
-            if (p_Dpb->fs_ref[i]->is_used) {
-                if (currSlice->ThisPOC >= p_Dpb->fs_ref[i]->poc) {
-                    fs_list0[list0idx++] = p_Dpb->fs_ref[i];
+        for (i = p_Dpb->ref_frames_in_buffer; i > 0; i--) {
+            if (p_Dpb->fs_ref_poc[i - 1]->is_used) {
+                if (currSlice->ThisPOC >= p_Dpb->fs_ref_poc[i - 1]->poc) {
+                    fs_list0[list0idx++] = p_Dpb->fs_ref_poc[i - 1];
                 }
             }
         }
-        qsort((void *)fs_list0, list0idx, sizeof(H264_FrameStore_t*), compare_fs_by_poc_desc);
+        sort_ref_list((void **)fs_list0, list0idx, compare_fs_by_poc_desc);
         list0idx_1 = list0idx;
         for (i = 0; i < p_Dpb->ref_frames_in_buffer; i++) {
-            if (p_Dpb->fs_ref[i]->is_used) {
-                if (currSlice->ThisPOC < p_Dpb->fs_ref[i]->poc) {
-                    fs_list0[list0idx++] = p_Dpb->fs_ref[i];
+            if (p_Dpb->fs_ref_poc[i]->is_used) {
+                if (currSlice->ThisPOC < p_Dpb->fs_ref_poc[i]->poc) {
+                    fs_list0[list0idx++] = p_Dpb->fs_ref_poc[i];
                 }
             }
         }
-        qsort((void *)&fs_list0[list0idx_1], list0idx - list0idx_1, sizeof(H264_FrameStore_t*), compare_fs_by_poc_asc);
+        sort_ref_list((void **)&fs_list0[list0idx_1], list0idx - list0idx_1, compare_fs_by_poc_asc);
 
         for (j = 0; j < list0idx_1; j++) {
             fs_list1[list0idx - list0idx_1 + j] = fs_list0[j];
@@ -1152,17 +1167,11 @@ static MPP_RET init_lists_b_slice_mvc(H264_SLICE_t *currSlice)
         gen_pic_list_from_frame_list(currSlice->structure, fs_list1, list0idx, currSlice->listB[1], &currSlice->listXsizeB[1], 0);
 
         // long term handling
-        for (i = 0; i < p_Dpb->ltref_frames_in_buffer; i++) {
-            fs_listlt[listltidx++] = p_Dpb->fs_ltref[i];
-        }
-        qsort((void *)fs_listlt, listltidx, sizeof(H264_FrameStore_t*), compare_fs_by_lt_pic_idx_asc);
+        listltidx = p_Dpb->ltref_frames_in_buffer;
+        sort_ref_list((void **)fs_listlt, listltidx, compare_fs_by_lt_pic_idx_asc);
 
         gen_pic_list_from_frame_list(currSlice->structure, fs_listlt, listltidx, currSlice->listB[0], &currSlice->listXsizeB[0], 1);
         gen_pic_list_from_frame_list(currSlice->structure, fs_listlt, listltidx, currSlice->listB[1], &currSlice->listXsizeB[1], 1);
-
-        MPP_FREE(fs_list0);
-        MPP_FREE(fs_list1);
-        MPP_FREE(fs_listlt);
     }
     if ((currSlice->listXsizeB[0] == currSlice->listXsizeB[1]) && (currSlice->listXsizeB[0] > 1)) {
         // check if lists are identical, if yes swap first two elements of currSlice->listX[1]
@@ -1224,9 +1233,6 @@ static MPP_RET init_lists_b_slice_mvc(H264_SLICE_t *currSlice)
 
     return ret = MPP_OK;
 __FAILED:
-    MPP_FREE(fs_list0);
-    MPP_FREE(fs_list1);
-    MPP_FREE(fs_listlt);
     MPP_FREE(currSlice->fs_listinterview0);
     MPP_FREE(currSlice->fs_listinterview1);
 
@@ -1961,6 +1967,37 @@ __FAILED:
     return ret;
 }
 
+/*!
+***********************************************************************
+* \brief
+*    picture dropped by skip mode, only poc state is kept
+***********************************************************************
+*/
+//extern "C"
+MPP_RET skip_picture(H264_SLICE_t *currSlice)
+{
+    MPP_RET ret = MPP_ERR_UNKNOW;
+    H264dVideoCtx_t *p_Vid = currSlice->p_Vid;
+    RK_S32 layer_id = currSlice->layer_id;
+
+    currSlice->toppoc    = p_Vid->last_toppoc[layer_id];
+    currSlice->bottompoc = p_Vid->last_bottompoc[layer_id];
+    currSlice->framepoc  = p_Vid->last_framepoc[layer_id];
+    currSlice->ThisPOC   = p_Vid->last_thispoc[layer_id];
+    FUN_CHECK(ret = decode_poc(p_Vid, currSlice));
+
+    p_Vid->last_toppoc[layer_id]    = currSlice->toppoc;
+    p_Vid->last_bottompoc[layer_id] = currSlice->bottompoc;
+    p_Vid->last_framepoc[layer_id]  = currSlice->framepoc;
+    p_Vid->last_thispoc[layer_id]   = currSlice->ThisPOC;
+    //!< memory management of skipped picture is not parsed
+    p_Vid->last_has_mmco_5 = 0;
+
+    return ret = MPP_OK;
+__FAILED:
+    return ret;
+}
+
 /*!
 ***********************************************************************
 * \brief
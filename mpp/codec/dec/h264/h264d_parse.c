@@ -251,7 +251,9 @@ static MPP_RET parser_one_nalu(H264_SLICE_t *currSlice)
         currSlice->p_Dec->nalu_ret = NALU_SubSPS;
         break;
     case NALU_TYPE_SEI:
-        //FUN_CHECK(ret = process_sei(currSlice));
+        //!< sei is only read for export, broken sei does not stop decoding
+        if (currSlice->p_Dec->sei.mask && process_sei(currSlice))
+            H264D_WARNNING("sei parse failed, the rest of sei nalu is dropped.\n");
         H264D_DBG(H264D_DBG_PARSE_NALU, "nalu_type=SEI");
         currSlice->p_Dec->nalu_ret = NALU_SEI;
         break;
@@ -886,6 +888,69 @@ __FAILED:
 
 
 
+/*!
+***********************************************************************
+* \brief
+*    check skip mode on the first slice of picture
+***********************************************************************
+*/
+static RK_U32 check_skip_picture(H264_DecCtx_t *p_Dec)
+{
+    H264_SLICE_t *currSlice = &p_Dec->p_Cur->slice;
+    RK_U32 is_key = 0;
+    RK_U32 is_ref = 0;
+
+    if (currSlice->layer_id)
+        return 0;
+
+    //!< second field follows the decision of the first field
+    if (currSlice->structure != FRAME
+        && p_Dec->skip_structure != FRAME
+        && currSlice->structure != p_Dec->skip_structure
+        && currSlice->frame_num == p_Dec->skip_frame_num) {
+        p_Dec->skip_structure = FRAME;
+        return p_Dec->skip_pic;
+    }
+
+    //!< no temporal id in avc, non-reference picture is taken as layer 1
+    is_key = currSlice->idr_flag || (I_SLICE == currSlice->slice_type);
+    is_ref = currSlice->nal_reference_idc ? 1 : 0;
+    p_Dec->skip_pic = mpp_dec_skip_check(&p_Dec->skip, is_key, is_ref, !is_ref);
+    p_Dec->skip_structure = currSlice->structure;
+    p_Dec->skip_frame_num = currSlice->frame_num;
+
+    return p_Dec->skip_pic;
+}
+
+/*!
+***********************************************************************
+* \brief
+*    read the sei left after the first slice, it goes with next picture
+***********************************************************************
+*/
+static void parse_rest_sei(H264_DecCtx_t *p_Dec, RK_U8 *p_curdata)
+{
+    H264dNaluHead_t *p_head = (H264dNaluHead_t *)p_curdata;
+    H264_Nalu_t *cur_nal = &p_Dec->p_Cur->nalu;
+    NALU_STATUS nalu_ret = p_Dec->nalu_ret;
+
+    if (!p_Dec->sei.mask)
+        return;
+
+    while (!p_head->is_frame_end) {
+        p_curdata += sizeof(H264dNaluHead_t);
+        if (p_head->nalu_type == NALU_TYPE_SEI) {
+            memset(cur_nal, 0, sizeof(H264_Nalu_t));
+            cur_nal->sodb_buf = p_curdata;
+            cur_nal->sodb_len = p_head->sodb_len;
+            parser_one_nalu(&p_Dec->p_Cur->slice);
+        }
+        p_curdata += p_head->sodb_len;
+        p_head = (H264dNaluHead_t *)p_curdata;
+    }
+    p_Dec->nalu_ret = nalu_ret;
+}
+
 /*!
 ***********************************************************************
 * \brief
@@ -944,6 +1009,17 @@ MPP_RET parse_loop(H264_DecCtx_t *p_Dec)
             break;
         case SliceSTATE_InitPicture:
             if (!p_Dec->p_Vid->iNumOfSlicesDecoded) {
+                //!< sei read from now on goes with next picture
+                mpp_dec_sei_begin(&p_Dec->sei);
+                if (check_skip_picture(p_Dec)) {
+                    H264D_DBG(H264D_DBG_LOOP_STATE, "SliceSTATE_InitPicture skip");
+                    FUN_CHECK(ret = skip_picture(&p_Dec->p_Cur->slice));
+                    parse_rest_sei(p_Dec, p_curdata);
+                    p_Dec->dxva_ctx->slice_count = 0;
+                    p_Dec->dxva_ctx->strm_offset = 0;
+                    while_loop_flag = 0;
+                    break;
+                }
                 FUN_CHECK(ret = init_picture(&p_Dec->p_Cur->slice));
                 p_Dec->is_parser_end = 1;
             }
@@ -966,6 +1042,7 @@ MPP_RET parse_loop(H264_DecCtx_t *p_Dec)
                 goto __FAILED;
             }
             commit_buffer(p_Dec->dxva_ctx);
+            parse_rest_sei(p_Dec, p_curdata);
             while_loop_flag = 0;
             p_Dec->next_state = SliceSTATE_ReadNalu;
             H264D_DBG(H264D_DBG_LOOP_STATE, "SliceSTATE_RegisterOneFrame");
@@ -524,6 +524,23 @@ __FAILED:
     return ret;
 }
 
+//!< frame buffer size hint for pre-allocation, same stride as dpb_mark_malloc
+static void set_frame_hint(H264dVideoCtx_t *p_Vid)
+{
+    MppFrame mframe = NULL;
+
+    mpp_frame_init(&mframe);
+    if (mframe) {
+        mpp_frame_set_hor_stride(mframe, ((p_Vid->width * p_Vid->bit_depth_luma + 127) & (~127)) / 8);
+        mpp_frame_set_ver_stride(mframe, p_Vid->height);
+        mpp_frame_set_width(mframe, p_Vid->width_after_crop);
+        mpp_frame_set_height(mframe, p_Vid->height_after_crop);
+        //!< one more buffer for the frame on output
+        mpp_buf_slot_set_hint(p_Vid->p_Dec->frame_slots, mframe, p_Vid->dpb_size[0] + 1);
+        mpp_frame_deinit(&mframe);
+    }
+}
+
 /*!
 ***********************************************************************
 * \brief
@@ -533,6 +550,7 @@ __FAILED:
 //extern "C"
 MPP_RET activate_sps(H264dVideoCtx_t *p_Vid, H264_SPS_t *sps, H264_subSPS_t *subset_sps)
 {
+    RK_U32 new_seq = 0;
     MPP_RET ret = MPP_ERR_UNKNOW;
     INP_CHECK(ret, !p_Vid && !sps && !subset_sps);
     if (p_Vid->dec_pic) {
@@ -566,12 +584,15 @@ MPP_RET activate_sps(H264dVideoCtx_t *p_Vid, H264_SPS_t *sps, H264_subSPS_t *sub
             update_last_video_pars(p_Vid, p_Vid->active_sps, 0);
             //!< init frame slots, store frame buffer size
             p_Vid->dpb_size[0] = p_Vid->p_Dpb_layer[0]->size;
+            new_seq = 1;
         }
         VAL_CHECK(ret, p_Vid->dpb_size[0] > 0);
     }
     H264D_DBG(H264D_DBG_DPB_INFO, "[DPB_size] dpb_size[0]=%d, mvc_flag=%d, dpb_size[1]=%d",
               p_Vid->dpb_size[0], p_Vid->active_mvc_sps_flag, p_Vid->dpb_size[1]);
     update_video_pars(p_Vid, p_Vid->active_sps);
+    if (new_seq)
+        set_frame_hint(p_Vid);
 __RETURN:
     return ret = MPP_OK;
 __FAILED:
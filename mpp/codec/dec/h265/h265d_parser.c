@@ -487,6 +487,24 @@ static RK_S32 set_sps(HEVCContext *s, const HEVCSPS *sps)
     s->h265dctx->sample_aspect_ratio = sps->vui.sar;
     mpp_buf_slot_setup(s->slots, 25);
 
+    /* frame buffer size hint for pre-allocation, same stride as in refs */
+    if (s->sps != sps) {
+        MppFrame frame = NULL;
+
+        mpp_frame_init(&frame);
+        if (frame) {
+            mpp_frame_set_width(frame, sps->output_width);
+            mpp_frame_set_height(frame, sps->output_height);
+            mpp_frame_set_hor_stride(frame, (sps->width * sps->bit_depth) >> 3);
+            mpp_frame_set_ver_stride(frame, sps->height);
+            mpp_frame_set_fmt(frame, sps->pix_fmt);
+            /* one more buffer for the frame on output */
+            mpp_buf_slot_set_hint(s->slots, frame,
+                                  sps->temporal_layer[sps->max_sub_layers - 1].max_dec_pic_buffering + 1);
+            mpp_frame_deinit(&frame);
+        }
+    }
+
     if (sps->vui.video_signal_type_present_flag)
         s->h265dctx->color_range = sps->vui.video_full_range_flag ? MPPCOL_RANGE_JPEG
                                    : MPPCOL_RANGE_MPEG;
@@ -1342,6 +1360,25 @@ static RK_S32 parser_nal_unit(HEVCContext *s, const RK_U8 *nal, int length)
                 s->max_ra = INT_MIN;
         }
 
+        if (s->sh.first_slice_in_pic_flag) {
+            RK_U32 ref_lost = s->skip.ref_lost;
+            /* sub-layer non-reference picture in the highest sub-layer is never referenced */
+            RK_U32 is_ref = !(s->nal_unit_type <= NAL_RASL_R &&
+                              !(s->nal_unit_type & 1) &&
+                              s->temporal_id == s->sps->max_sub_layers - 1);
+
+            s->skip_pic = mpp_dec_skip_check(&s->skip, IS_IRAP(s), is_ref,
+                                             s->temporal_id);
+            /* leading pictures of the CRA may refer to skipped pictures */
+            if (!s->skip_pic && ref_lost && s->nal_unit_type == NAL_CRA_NUT)
+                s->max_ra = s->poc;
+        }
+
+        if (s->skip_pic) {
+            s->is_decoded = 0;
+            break;
+        }
+
         if (s->sh.first_slice_in_pic_flag) {
             ret = hevc_frame_start(s);
             if (ret < 0)
@@ -1779,6 +1816,7 @@ MPP_RET h265d_parse(void *ctx, HalDecTask *task)
     s->got_frame = 0;
     s->task = task;
     s->ref = NULL;
+    mpp_dec_sei_clear(&s->sei);
     ret    = parser_nal_units(s);
     if (ret < 0) {
         if (ret ==  MPP_ERR_STREAM) {
@@ -1789,6 +1827,12 @@ MPP_RET h265d_parse(void *ctx, HalDecTask *task)
     }
     h265d_dbg(H265D_DBG_GLOBAL, "decode poc = %d", s->poc);
     if (s->ref) {
+        if (s->sei.length) {
+            MppFrame frame = NULL;
+
+            mpp_buf_slot_get_prop(s->slots, s->ref->slot_index, SLOT_FRAME_PTR, &frame);
+            mpp_dec_sei_attach(&s->sei, frame, 0);
+        }
         h265d_parser2_syntax(h265dctx);
         s->task->syntax.data = s->hal_pic_private;
         s->task->syntax.number = 1;
@@ -1823,6 +1867,7 @@ MPP_RET h265d_deinit(void *ctx)
         mpp_hevc_unref_frame(s, &s->DPB[i], ~0);
         mpp_frame_deinit(&s->DPB[i].frame);
     }
+    mpp_dec_sei_deinit(&s->sei);
 
     for (i = 0; i < MAX_VPS_COUNT; i++)
         mpp_free(s->vps_list[i]);
@@ -1884,7 +1929,9 @@ static RK_S32 hevc_init_context(H265dContext_t *h265dctx)
     }
 
     s->max_ra = INT_MAX;
-
+    mpp_dec_skip_init(&s->skip);
+    s->skip_pic = 0;
+    mpp_dec_sei_init(&s->sei);
 
     s->temporal_layer_id   = 8;
     s->context_initialized = 1;
@@ -1987,15 +2034,30 @@ MPP_RET h265d_reset(void *ctx)
     h265d_split_reset(h265dctx->split_cxt);
     s->max_ra = INT_MAX;
     s->eos = 0;
+    mpp_dec_skip_reset(&s->skip);
+    s->skip_pic = 0;
+    mpp_dec_sei_clear(&s->sei);
     return MPP_OK;
 }
 
 MPP_RET h265d_control(void *ctx, RK_S32 cmd, void *param)
 {
-    (void)ctx;
-    (void)cmd;
-    (void)param;
-    return MPP_OK;
+    H265dContext_t *h265dctx = (H265dContext_t *)ctx;
+    HEVCContext *s = (HEVCContext *)h265dctx->priv_data;
+    MPP_RET ret = MPP_OK;
+
+    switch (cmd) {
+    case MPP_DEC_SET_SKIP_MODE : {
+        ret = mpp_dec_skip_set(&s->skip, (MppDecSkipCfg *)param);
+    } break;
+    case MPP_DEC_SET_SEI_MASK : {
+        ret = mpp_dec_sei_set(&s->sei, *((RK_U32 *)param));
+    } break;
+    default : {
+    } break;
+    }
+
+    return ret;
 }
 
 MPP_RET h265d_callback(void *ctx, void *err_info)
@@ -37,6 +37,8 @@
 #include <string.h>
 #include <mpp_mem.h>
 #include "mpp_dec.h"
+#include "mpp_dec_skip.h"
+#include "mpp_dec_sei.h"
 
 extern RK_U32 h265d_debug;
 #define H265D_DBG_FUNCTION          (0x00000001)
@@ -56,6 +58,14 @@ extern RK_U32 h265d_debug;
 #define MAX_DPB_SIZE 16 // A.4.1
 #define MAX_REFS 16
 
+/*
+ * DPB index by poc, each bucket is a bit mask of DPB entries with the same
+ * low poc bits. The max poc lsb is at least 16 so that both full poc and
+ * poc lsb used by long term rps fall into the same bucket.
+ */
+#define HEVC_POC_MAP_SIZE   16
+#define HEVC_POC_MAP_KEY(poc)   ((poc) & (HEVC_POC_MAP_SIZE - 1))
+
 /**
  * 7.4.2.1
  */
@@ -598,6 +608,7 @@ typedef struct HEVCContext {
     RK_S32 temporal_id;  ///< temporal_id_plus1 - 1
     HEVCFrame *ref;
     HEVCFrame DPB[MAX_DPB_SIZE];
+    RK_U32 poc_map[HEVC_POC_MAP_SIZE];
     RK_S32 poc;
     RK_S32 pocTid0;
     RK_S32 slice_idx; ///< number of the slice being currently decoded
@@ -690,6 +701,13 @@ typedef struct HEVCContext {
     RK_U8  has_get_eos;
     RK_U8  miss_ref_flag;
     IOInterruptCB notify_cb;
+
+    /* picture skip mode, all slices follow the first slice */
+    MppDecSkip skip;
+    RK_U32 skip_pic;
+
+    /* subscribed sei payload of current picture */
+    MppDecSei sei;
 } HEVCContext;
 
 RK_S32 mpp_hevc_decode_short_term_rps(HEVCContext *s, ShortTermRPS *rps,
@@ -31,6 +31,16 @@
 
 #define HEVC_ALIGN(value, x)   ((value + (x-1)) & (~(x-1)))
 
+static void poc_map_add(HEVCContext *s, HEVCFrame *frame)
+{
+    s->poc_map[HEVC_POC_MAP_KEY(frame->poc)] |= 1 << (frame - s->DPB);
+}
+
+static void poc_map_del(HEVCContext *s, HEVCFrame *frame)
+{
+    s->poc_map[HEVC_POC_MAP_KEY(frame->poc)] &= ~(1 << (frame - s->DPB));
+}
+
 void mpp_hevc_unref_frame(HEVCContext *s, HEVCFrame *frame, int flags)
 {
     /* frame->frame can be NULL if context init failed */
@@ -49,6 +59,7 @@ void mpp_hevc_unref_frame(HEVCContext *s, HEVCFrame *frame, int flags)
             mpp_buf_slot_clr_flag(s->slots, frame->slot_index, SLOT_CODEC_USE);
         }
         h265d_dbg(H265D_DBG_REF, "unref_frame poc %d frame->slot_index %d \n", frame->poc, frame->slot_index);
+        poc_map_del(s, frame);
         frame->poc = INT_MAX;
         frame->slot_index = 0xff;
         frame->error_flag = 0;
@@ -137,13 +148,16 @@ int mpp_hevc_set_new_ref(HEVCContext *s, MppFrame *mframe, int poc)
 {
 
     HEVCFrame *ref = NULL;
+    RK_U32 mask = s->poc_map[HEVC_POC_MAP_KEY(poc)];
     RK_U32 i;
 
     /* check that this POC doesn't already exist */
-    for (i = 0; i < MPP_ARRAY_ELEMS(s->DPB); i++) {
+    for (i = 0; mask; i++, mask >>= 1) {
         HEVCFrame *frame = &s->DPB[i];
 
-        if ((frame->slot_index != 0xff) && frame->sequence == s->seq_decode &&
+        if (!(mask & 1))
+            continue;
+        if (frame->sequence == s->seq_decode &&
             frame->poc == poc && !s->nuh_layer_id) {
             mpp_err( "Duplicate POC in a sequence: %d.\n",
                      poc);
@@ -160,6 +174,7 @@ int mpp_hevc_set_new_ref(HEVCContext *s, MppFrame *mframe, int poc)
     s->ref = ref;
 
     ref->poc      = poc;
+    poc_map_add(s, ref);
     h265d_dbg(H265D_DBG_REF, "alloc frame poc %d slot_index %d", poc, ref->slot_index);
     ref->flags    = HEVC_FRAME_FLAG_OUTPUT | HEVC_FRAME_FLAG_SHORT_REF;
 
@@ -174,21 +189,24 @@ int mpp_hevc_set_new_ref(HEVCContext *s, MppFrame *mframe, int poc)
 
 static HEVCFrame *find_ref_idx(HEVCContext *s, int poc)
 {
-    RK_U32 i;
     RK_S32 LtMask = (1 << s->sps->log2_max_poc_lsb) - 1;
+    RK_U32 map = s->poc_map[HEVC_POC_MAP_KEY(poc)];
+    RK_U32 mask;
+    RK_U32 i;
 
-    for (i = 0; i < MPP_ARRAY_ELEMS(s->DPB); i++) {
+    /* only frames in the bucket of poc can match either full poc or poc lsb */
+    for (i = 0, mask = map; mask; i++, mask >>= 1) {
         HEVCFrame *ref = &s->DPB[i];
-        if ((ref->slot_index != 0xff) && (ref->sequence == s->seq_decode)) {
+        if ((mask & 1) && ref->sequence == s->seq_decode) {
             if ((ref->poc & LtMask) == poc)
                 return ref;
         }
     }
 
-    for (i = 0; i < MPP_ARRAY_ELEMS(s->DPB); i++) {
+    for (i = 0, mask = map; mask; i++, mask >>= 1) {
         HEVCFrame *ref = &s->DPB[i];
-        if ((ref->slot_index != 0xff) && ref->sequence == s->seq_decode) {
-            if (ref->poc == poc || (ref->poc & LtMask) == poc)
+        if ((mask & 1) && ref->sequence == s->seq_decode) {
+            if (ref->poc == poc)
                 return ref;
         }
     }
@@ -228,6 +246,7 @@ static HEVCFrame *generate_missing_ref(HEVCContext *s, int poc)
     }
 #endif
     frame->poc      = poc;
+    poc_map_add(s, frame);
 
     mpp_buf_slot_set_flag(s->slots, frame->slot_index, SLOT_CODEC_READY);
     mpp_buf_slot_set_flag(s->slots, frame->slot_index, SLOT_CODEC_USE);
@@ -240,7 +259,7 @@ static HEVCFrame *generate_missing_ref(HEVCContext *s, int poc)
 
 /* add a reference with the given poc to the list and mark it as used in DPB */
 static int add_candidate_ref(HEVCContext *s, RefPicList *list,
-                             int poc, int ref_flag)
+                             int poc, int ref_flag, RK_U32 *used)
 {
     HEVCFrame *ref = find_ref_idx(s, poc);
 
@@ -262,6 +281,7 @@ static int add_candidate_ref(HEVCContext *s, RefPicList *list,
         mpp_buf_slot_set_flag(s->slots, ref->slot_index, SLOT_CODEC_USE);
     }
     mark_ref(ref, ref_flag);
+    *used |= 1 << (ref - s->DPB);
     if (ref->error_flag) {
         s->miss_ref_flag = 1;
     }
@@ -274,6 +294,7 @@ RK_S32 mpp_hevc_frame_rps(HEVCContext *s)
     const ShortTermRPS *short_rps = s->sh.short_term_rps;
     const LongTermRPS  *long_rps  = &s->sh.long_term_rps;
     RefPicList               *rps = s->rps;
+    RK_U32  used = 0;
     RK_S32  ret;
     RK_U32  i;
 
@@ -283,14 +304,6 @@ RK_S32 mpp_hevc_frame_rps(HEVCContext *s)
             return 0;
     }
 
-    /* clear the reference flags on all frames except the current one */
-    for (i = 0; i < MPP_ARRAY_ELEMS(s->DPB); i++) {
-        HEVCFrame *frame = &s->DPB[i];
-        if (frame == s->ref)
-            continue;
-        mark_ref(frame, 0);
-    }
-
     for (i = 0; i < NB_RPS_TYPE; i++)
         rps[i].nb_refs = 0;
 
@@ -306,7 +319,7 @@ RK_S32 mpp_hevc_frame_rps(HEVCContext *s)
         else
             list = ST_CURR_AFT;
 
-        ret = add_candidate_ref(s, &rps[list], poc, HEVC_FRAME_FLAG_SHORT_REF);
+        ret = add_candidate_ref(s, &rps[list], poc, HEVC_FRAME_FLAG_SHORT_REF, &used);
         if (ret < 0)
             return ret;
     }
@@ -316,13 +329,20 @@ RK_S32 mpp_hevc_frame_rps(HEVCContext *s)
         int poc  = long_rps->poc[i];
         int list = long_rps->used[i] ? LT_CURR : LT_FOLL;
 
-        ret = add_candidate_ref(s, &rps[list], poc, HEVC_FRAME_FLAG_LONG_REF);
+        ret = add_candidate_ref(s, &rps[list], poc, HEVC_FRAME_FLAG_LONG_REF, &used);
         if (ret < 0)
             return ret;
     }
-    /* release any frames that are now unused */
+    /*
+     * frames out of the rps lose their reference flags and are released
+     * when they are not waiting for output any more
+     */
     for (i = 0; i < MPP_ARRAY_ELEMS(s->DPB); i++) {
-        mpp_hevc_unref_frame(s, &s->DPB[i], 0);
+        HEVCFrame *frame = &s->DPB[i];
+        if (frame == s->ref || (used & (1 << i)))
+            continue;
+        mark_ref(frame, 0);
+        mpp_hevc_unref_frame(s, frame, 0);
     }
 
     return 0;
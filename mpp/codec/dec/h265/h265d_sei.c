@@ -309,6 +309,26 @@ __BITREAD_ERR:
     return  MPP_ERR_STREAM;
 }
 
+/* copy subscribed payload for output frame, bit reader drops emulation prevention bytes */
+static RK_S32 export_sei_payload(HEVCContext *s, RK_S32 payload_type, RK_S32 payload_size)
+{
+    BitReadCtx_t *gb = &s->HEVClc->gb;
+    RK_U8 *data = mpp_dec_sei_add(&s->sei, payload_type, payload_size);
+    RK_S32 i;
+
+    if (NULL == data) {
+        SKIP_BITS(gb, 8 * payload_size);
+        return 1;
+    }
+
+    for (i = 0; i < payload_size; i++)
+        READ_BITS(gb, 8, &data[i]);
+
+    return 1;
+__BITREAD_ERR:
+    return  MPP_ERR_STREAM;
+}
+
 static RK_S32 decode_nal_sei_message(HEVCContext *s)
 {
     BitReadCtx_t *gb = &s->HEVClc->gb;
@@ -316,6 +336,8 @@ static RK_S32 decode_nal_sei_message(HEVCContext *s)
     int payload_type = 0;
     int payload_size = 0;
     int byte = 0xFF;
+    /* payloads only printed in sei log are skipped when the log is off */
+    RK_U32 sei_log = h265d_debug & H265D_DBG_SEI;
     h265d_dbg(H265D_DBG_SEI, "Decoding SEI\n");
 
     while (byte == 0xFF) {
@@ -330,8 +352,11 @@ static RK_S32 decode_nal_sei_message(HEVCContext *s)
 
     h265d_dbg(H265D_DBG_SEI, "s->nal_unit_type %d payload_type %d payload_size %d\n", s->nal_unit_type, payload_type, payload_size);
 
+    if (mpp_dec_sei_check(&s->sei, payload_type))
+        return export_sei_payload(s, payload_type, payload_size);
+
     if (s->nal_unit_type == NAL_SEI_PREFIX) {
-        if (payload_type == 256 /*&& s->decode_checksum_sei*/) {
+        if (payload_type == 256 && sei_log /*&& s->decode_checksum_sei*/) {
             decode_nal_sei_decoded_picture_hash(s);
             return 1;
         } else if (payload_type == 45) {
@@ -346,15 +371,15 @@ static RK_S32 decode_nal_sei_message(HEVCContext *s)
             active_parameter_sets(s);
             h265d_dbg(H265D_DBG_SEI, "Skipped PREFIX SEI %d\n", payload_type);
             return 1;
-        } else if (payload_type == 137) {
+        } else if (payload_type == 137 && sei_log) {
             h265d_dbg(H265D_DBG_SEI, "mastering_display_colour_volume in\n");
             mastering_display_colour_volume(s);
             return 1;
-        } else if (payload_type == 143) {
+        } else if (payload_type == 143 && sei_log) {
             h265d_dbg(H265D_DBG_SEI, "colour_remapping_info in\n");
             colour_remapping_info(s);
             return 1;
-        } else if (payload_type == 23) {
+        } else if (payload_type == 23 && sei_log) {
             h265d_dbg(H265D_DBG_SEI, "tone_mapping_info in\n");
             tone_mapping_info(s);
             return 1;
@@ -364,7 +389,7 @@ static RK_S32 decode_nal_sei_message(HEVCContext *s)
             return 1;
         }
     } else { /* nal_unit_type == NAL_SEI_SUFFIX */
-        if (payload_type == 132 /* && s->decode_checksum_sei */)
+        if (payload_type == 132 && sei_log /* && s->decode_checksum_sei */)
             decode_nal_sei_decoded_picture_hash(s);
         else {
             h265d_dbg(H265D_DBG_SEI, "Skipped SUFFIX SEI %d\n", payload_type);
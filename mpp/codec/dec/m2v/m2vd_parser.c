@@ -225,6 +225,7 @@ MPP_RET m2vd_parser_init(void *ctx, ParserCfg *parser_cfg)
     }
 
     CHK_F(m2vd_parser_init_ctx(p, parser_cfg));
+    mpp_dec_skip_init(&p->skip);
 
     mpp_env_get_u32("m2vd_debug", &m2vd_debug, 0);
 
@@ -322,6 +323,8 @@ MPP_RET m2vd_parser_reset(void *ctx)
     p->ref_frame_cnt = 0;
     p->resetFlag = 1;
     p->eos = 0;
+    mpp_dec_skip_reset(&p->skip);
+    p->skip_pic = 0;
     FUN_T("FUN_O");
     return ret;
 }
@@ -368,10 +371,16 @@ exit:
 MPP_RET  m2vd_parser_control(void *ctx, RK_S32 cmd_type, void *param)
 {
     MPP_RET ret = MPP_OK;
+    M2VDContext *c = (M2VDContext *)ctx;
+    M2VDParserContext *p = (M2VDParserContext *)c->parse_ctx;
     FUN_T("FUN_I");
-    (void)ctx;
-    (void)cmd_type;
-    (void)param;
+    switch (cmd_type) {
+    case MPP_DEC_SET_SKIP_MODE : {
+        ret = mpp_dec_skip_set(&p->skip, (MppDecSkipCfg *)param);
+    } break;
+    default : {
+    } break;
+    }
     FUN_T("FUN_O");
     return ret;
 }
@@ -1290,6 +1299,23 @@ MPP_RET m2vd_convert_to_dxva(M2VDParserContext *p)
     return ret;
 }
 
+static RK_U32 m2vd_check_skip(M2VDParserContext *p)
+{
+    RK_U32 type = p->pic_head.picture_coding_type;
+    RK_U32 structure = p->pic_code_ext_head.picture_structure;
+    RK_U32 tff = p->pic_code_ext_head.top_field_first;
+
+    /* the second field follows the decision of the first field */
+    if ((structure == M2VD_PIC_STRUCT_BOTTOM_FIELD && tff) ||
+        (structure == M2VD_PIC_STRUCT_TOP_FIELD && !tff))
+        return p->skip_pic;
+
+    /* B picture is never referenced and taken as temporal layer 1 */
+    p->skip_pic = mpp_dec_skip_check(&p->skip, type == M2VD_CODING_TYPE_I,
+                                     type != M2VD_CODING_TYPE_B,
+                                     type == M2VD_CODING_TYPE_B);
+    return p->skip_pic;
+}
 
 MPP_RET m2vd_parser_parse(void *ctx, HalDecTask *in_task)
 {
@@ -1327,6 +1353,12 @@ MPP_RET m2vd_parser_parse(void *ctx, HalDecTask *in_task)
     }
 
     if (rev == M2VD_DEC_PICHEAD_OK) {
+        if (m2vd_check_skip(p)) {
+            if (M2VD_DBG_SEC_HEADER & m2vd_debug) {
+                mpp_log("skip picture type %d", p->pic_head.picture_coding_type);
+            }
+            goto __FAILED;
+        }
         if (MPP_OK != m2vd_alloc_frame(p)) {
             mpp_err("m2vd_alloc_frame not OK");
             goto __FAILED;
@@ -35,6 +35,7 @@
 #include "mpp_packet.h"
 
 #include "mpp_dec.h"
+#include "mpp_dec_skip.h"
 #include "m2vd_syntax.h"
 #include "m2vd_com.h"
 
@@ -291,6 +292,10 @@ typedef struct M2VDParserContext_t {
 
     FILE *fp_dbg_file[M2VD_DBG_FILE_NUM];
     FILE *fp_dbg_yuv;
+
+    /* picture skip mode, second field follows the first field */
+    MppDecSkip  skip;
+    RK_U32      skip_pic;
 } M2VDParserContext;
 
 MPP_RET  m2vd_parser_init   (void *ctx, ParserCfg *cfg);
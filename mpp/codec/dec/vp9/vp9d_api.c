@@ -136,11 +136,10 @@ MPP_RET  vp9d_control(void *ctx, RK_S32 cmd_type, void *param)
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
 
-    (void)ctx;
-    (void)cmd_type;
-    (void)param;
+    Vp9CodecContext *vp9_ctx = (Vp9CodecContext *)ctx;
+    ret = vp9d_paser_control(vp9_ctx, cmd_type, param);
 
-    return ret = MPP_OK;
+    return ret;
 }
 
 
@@ -357,6 +357,7 @@ MPP_RET vp9d_parser_init(Vp9CodecContext *vp9_ctx, ParserCfg *init)
         return MPP_ERR_NOMEM;
     }
     vp9_frame_init(s);
+    mpp_dec_skip_init(&s->skip);
     s->last_bpp = 0;
     s->filter.sharpness = -1;
 
@@ -1567,6 +1568,10 @@ RK_S32 vp9_parser_frame(Vp9CodecContext *ctx, HalDecTask *task)
     if ((res = decode_parser_header(ctx, data, size, &ref)) < 0) {
         return res;
     } else if (res == 0) {
+        /* the frame to show may have been refreshed by a skipped frame */
+        if (s->skip.ref_lost)
+            return size;
+
         if (!s->refs[ref].ref) {
             //mpp_err("Requested reference %d not available\n", ref);
             return -1;//AVERROR_INVALIDDATA;
@@ -1589,6 +1594,17 @@ RK_S32 vp9_parser_frame(Vp9CodecContext *ctx, HalDecTask *task)
     size -= res;
 	(void) size;
 
+    /*
+     * Inter frame is always taken as reference frame and key frame resets
+     * all probability contexts, so skipped frame keeps no state here.
+     */
+    if (mpp_dec_skip_check(&s->skip, s->keyframe, 1, 0)) {
+        vp9d_dbg(VP9D_DBG_HEADER, "skip frame keyframe %d", s->keyframe);
+        if (s->eos)
+            task->flags.eos = 1;
+        return 0;
+    }
+
     if (s->frames[REF_FRAME_MVPAIR].ref)
         vp9_unref_frame(s, &s->frames[REF_FRAME_MVPAIR]);
 
@@ -1690,8 +1706,25 @@ MPP_RET vp9d_paser_reset(Vp9CodecContext *ctx)
     if (ps) {
         ps->eos = 0;
     }
+    mpp_dec_skip_reset(&s->skip);
     return MPP_OK;
 }
+
+MPP_RET vp9d_paser_control(Vp9CodecContext *ctx, RK_S32 cmd, void *param)
+{
+    VP9Context *s = ctx->priv_data;
+    MPP_RET ret = MPP_OK;
+
+    switch (cmd) {
+    case MPP_DEC_SET_SKIP_MODE : {
+        ret = mpp_dec_skip_set(&s->skip, (MppDecSkipCfg *)param);
+    } break;
+    default : {
+    } break;
+    }
+
+    return ret;
+}
 static void inv_count_data(VP9Context *s)
 {
     RK_U32 partition_probs[4][4][4];
@@ -27,6 +27,7 @@
 #include "mpp_frame.h"
 #include "mpp_mem.h"
 #include "mpp_dec.h"
+#include "mpp_dec_skip.h"
 
 extern RK_U32 vp9d_debug;
 
@@ -267,6 +268,7 @@ typedef struct VP9Context {
     RK_S64 pts;
     RK_S32 upprobe_num;
     RK_S32 outframe_num;
+    MppDecSkip skip;
 } VP9Context;
 
 #ifdef  __cplusplus
@@ -281,6 +283,8 @@ RK_S32 vp9_parser_frame(Vp9CodecContext *ctx, HalDecTask *in_task);
 
 void vp9_parser_update(Vp9CodecContext *ctx, void *count_info);
 MPP_RET vp9d_paser_reset(Vp9CodecContext *ctx);
+
+MPP_RET vp9d_paser_control(Vp9CodecContext *ctx, RK_S32 cmd, void *param);
 RK_S32 vp9d_split_frame(SplitContext_t *ctx,
                         RK_U8 **out_data, RK_S32 *out_size,
                         RK_U8 *data, RK_S32 size);
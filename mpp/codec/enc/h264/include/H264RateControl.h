@@ -134,6 +134,12 @@ typedef struct {
     RK_S32 windowLen;          /* Bitrate window which tries to match target */
     RK_S32 intraInterval;      /* Distance between two previous I-frames */
     RK_S32 intraIntervalCtr;
+
+    /* lookahead info of current picture, only used on inter pictures */
+    true_e lkhRc;              /* lookahead info is valid */
+    RK_S32 lkhCplx;            /* complexity to lookahead window average, Q8 */
+    RK_S32 lkhBits;            /* bit budget weight to average picture, Q8 */
+    RK_S32 lkhQpDelta;         /* qp offset for fixed qp */
 } h264RateControl_s;
 
 /*------------------------------------------------------------------------------
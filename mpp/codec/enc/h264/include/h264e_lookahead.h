@@ -0,0 +1,83 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __H264E_LOOKAHEAD_H__
+#define __H264E_LOOKAHEAD_H__
+
+#include "mpp_buffer.h"
+#include "mpp_thread.h"
+
+/*
+ * h264 encoder software lookahead
+ *
+ * Input frames are queued to the lookahead as soon as they arrive and a
+ * worker thread estimates the complexity of each frame on a 1/4 x 1/4
+ * downscaled luma plane. Per 8x8 lowres block (32x32 source pixels) the
+ * intra cost is the SAD of the best DC / H / V prediction and the inter cost
+ * is the best SAD of a small full search on the previous lowres frame.
+ *
+ * When the encoder takes the oldest frame out of the lookahead it also gets
+ * its complexity relative to the frames behind it:
+ *
+ * cplx_q8  - frame cost to the window average cost, Q8
+ * bits_q8  - bit budget weight to the average frame, Q8
+ *            complex frames get more bits but less than proportional
+ *            (cost ^ 0.6) and the weights are normalized over the window so
+ *            the window keeps the same total bit budget
+ * qp_delta - qp offset for constant qp mode to the long term average cost
+ */
+#define H264E_LKH_MAX_DEPTH         32
+#define H264E_LKH_QP_DELTA_MAX      6
+
+typedef void* H264eLkh;
+
+typedef struct H264eLkhCfg_t {
+    RK_S32      width;
+    RK_S32      height;
+    RK_S32      hor_stride;
+    RK_S32      depth;
+    /* worker thread policy and name, NULL name for default */
+    MppThreadPolicy policy;
+    const char  *name;
+} H264eLkhCfg;
+
+typedef struct H264eLkhRet_t {
+    RK_S32      intra_cost;
+    RK_S32      inter_cost;
+    RK_S32      cost;
+    RK_S32      cplx_q8;
+    RK_S32      bits_q8;
+    RK_S32      qp_delta;
+    RK_S32      frames;
+} H264eLkhRet;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET h264e_lkh_init(H264eLkh *ctx, H264eLkhCfg *cfg);
+MPP_RET h264e_lkh_deinit(H264eLkh ctx);
+
+/* queue a frame for analysis, buffer is referenced until analysis is done */
+MPP_RET h264e_lkh_put(H264eLkh ctx, MppBuffer buf);
+/* take the oldest frame result, window is the frames analyzed so far */
+MPP_RET h264e_lkh_get(H264eLkh ctx, H264eLkhRet *ret);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __H264E_LOOKAHEAD_H__ */
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __H264E_SCENE_H__
+#define __H264E_SCENE_H__
+
+#include "rk_mpi.h"
+
+/*
+ * h264 encoder scene change detection
+ *
+ * Each input luma plane is downscaled by 8 x 8 and compared with the previous
+ * one. The analysis works on three measures:
+ *
+ * hist_diff - distance of the 64 bin lowres luma histograms, 0 ~ 256
+ * sad       - mean absolute difference per lowres pixel in Q4 after global
+ *             luma compensation, the smaller one of offset (mean difference)
+ *             and gain (mean ratio) compensation is taken
+ * luma_mean - mean of lowres luma in Q4
+ *
+ * A scene cut is a histogram jump together with a compensated sad jump over
+ * its running average. A fade is a luma mean drift in the same direction for
+ * several frames while the compensated sad stays low, so fade frames are not
+ * taken as scene cuts.
+ *
+ * The frame type policy is also decided here from MppEncSceneCfg:
+ * a scene cut frame becomes idr when it is gop_min frames or more after the
+ * last intra frame and no p frame chain gets longer than gop_max.
+ */
+typedef void* H264eScene;
+
+typedef struct H264eSceneCfg_t {
+    RK_S32      width;
+    RK_S32      height;
+    RK_S32      hor_stride;
+} H264eSceneCfg;
+
+typedef struct H264eSceneRet_t {
+    RK_S32      scene;          /* MppEncSceneType */
+    RK_S32      idr;            /* frame should be encoded as idr */
+    RK_S32      hist_diff;
+    RK_S32      sad;
+    RK_S32      luma_mean;
+} H264eSceneRet;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET h264e_scene_init(H264eScene *ctx, H264eSceneCfg *cfg);
+MPP_RET h264e_scene_deinit(H264eScene ctx);
+MPP_RET h264e_scene_set_cfg(H264eScene ctx, MppEncSceneCfg *cfg);
+
+/*
+ * analyze one input luma plane in encoding order
+ * dist - frame count since last intra frame
+ */
+MPP_RET h264e_scene_proc(H264eScene ctx, RK_U8 *luma, RK_S32 dist, H264eSceneRet *ret);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __H264E_SCENE_H__ */
@@ -20,6 +20,9 @@
 #include "h264_syntax.h"
 #include "h264e_syntax.h"
 #include "mpp_frame.h"
+#include "h264e_lookahead.h"
+#include "h264e_scene.h"
+#include "mpp_enc_nal.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -301,11 +304,30 @@ typedef struct {
     H264EncConfig   enc_cfg;
     H264EncRateCtrl enc_rc_cfg;
 
+    // software lookahead for rate control, NULL when disabled
+    RK_S32          lkh_depth;
+    H264eLkh        lkh;
+    MppThreadCfg    lkh_thread;
+
+    // scene change detection, NULL when disabled
+    H264eSceneCfg   scene_size;
+    MppEncSceneCfg  scene_cfg;
+    MppEncSceneInfo scene_info;
+    H264eScene      scene;
+
+    // nal units of the last encoded frame
+    MppEncNal       nal;
+
+    // macroblock rows per slice, 0 for one slice per frame
+    RK_U32          slice_mb_rows;
+
     // data for hal
     h264e_syntax    syntax;
 } H264ECtx;
 
 #define H264E_DBG_FUNCTION          (0x00000001)
+#define H264E_DBG_LOOKAHEAD         (0x00000010)
+#define H264E_DBG_SCENE             (0x00000020)
 
 extern RK_U32 h264e_debug;
 
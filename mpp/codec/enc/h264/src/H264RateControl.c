@@ -59,6 +59,8 @@ FILE *fpRcTrc = NULL;
 #define INTRA_QP_DELTA    (0)
 #define WORD_CNT_MAX      65535
 #define CLIP3(v, min, max)  ((v) < (min) ? (min) : ((v) > (max) ? (max) : (v)))  // add by lance 2016.05.12
+#define LKH_INTER(rc)       ((rc)->lkhRc == ENCHW_YES && \
+                             (rc)->sliceTypeCur != ISLICE && (rc)->sliceTypeCur != ISLICES)
 /*------------------------------------------------------------------------------
   Local structures
 ------------------------------------------------------------------------------*/
@@ -466,8 +468,10 @@ RK_S32 H264AfterPicRc(h264RateControl_s * rc, RK_U32 nonZeroCnt, RK_U32 byteCnt,
 
     /* Update number of bits used for residual, inter or intra */
     if (rc->sliceTypeCur != ISLICE && rc->sliceTypeCur != ISLICES) {
-        update_tables_new(&rc->linReg, rc->qpHdrPrev,
-                          H264Calculate(bitCnt, 256, rc->mbPerPic));
+        tmp = H264Calculate(bitCnt, 256, rc->mbPerPic);
+        if (LKH_INTER(rc))
+            tmp = H264Calculate(tmp, 256, rc->lkhCplx);
+        update_tables_new(&rc->linReg, rc->qpHdrPrev, tmp);
         update_model_new(&rc->linReg);
     } else {
         update_tables_new(&rc->intra, rc->qpHdrPrev,
@@ -606,6 +610,11 @@ void H264BeforePicRc(h264RateControl_s * rc, RK_U32 timeInc, RK_U32 sliceType)
      * and it will confuse RC because it can never be reached. */
     rc->targetPicSize = MAX(0, rc->targetPicSize);
 
+    /* Lookahead moves bits from simple to complex inter pictures inside
+     * the lookahead window. The weights are normalized over the window. */
+    if (LKH_INTER(rc))
+        rc->targetPicSize = H264Calculate(rc->targetPicSize, rc->lkhBits, 256);
+
     DBG(1, (DBGOUTPUT, "intraBits: %7i\tintraRatio: %3i%%\n",
             intraBits, get_avg_bits_new(&rc->gop, 10)));
     DBG(1, (DBGOUTPUT, "WndRem: %4i  ", vb->windowRem));
@@ -895,6 +904,8 @@ void PicQuant_new(h264RateControl_s * rc)
 
     if (rc->picRc != ENCHW_YES) {
         rc->qpHdr = rc->fixedQp;
+        if (LKH_INTER(rc))
+            rc->qpHdr += rc->lkhQpDelta;
         DBG(1, (DBGOUTPUT, "R/cx:  xxxx  QP: xx xx D:  xxxx newQP: xx\n"));
         return;
     }
@@ -928,6 +939,9 @@ void PicQuant_new(h264RateControl_s * rc)
 
         targetBits = rc->targetPicSize - avg_rc_error_new(&rc->rError);
         normBits = H264Calculate(targetBits, 256, rc->mbPerPic);
+        /* R-Q model is kept on average complexity with lookahead */
+        if (LKH_INTER(rc))
+            normBits = H264Calculate(normBits, 256, rc->lkhCplx);
         rc->qpHdr = new_pic_quant_new(&rc->linReg, normBits, useQpDeltaLimit);
         //printf("rc->targetBits=%d,useQpDeltaLimit=%d\n", rc->targetPicSize, useQpDeltaLimit);
         //printf("targetBits=%d,normBits=%d,rc->qpHdr=%d\n", targetBits, normBits, rc->qpHdr);
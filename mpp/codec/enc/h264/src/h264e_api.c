@@ -16,6 +16,8 @@
 
 #define MODULE_TAG "h264e_api"
 
+#include <string.h>
+
 #include "mpp_env.h"
 #include "mpp_log.h"
 #include "mpp_common.h"
@@ -66,6 +68,16 @@ MPP_RET h264e_deinit(void *ctx)
         mpp_err("H264EncStrmEnd() failed, ret %d.", ret);
     }
 
+    if (pEncInst->lkh) {
+        h264e_lkh_deinit(pEncInst->lkh);
+        pEncInst->lkh = NULL;
+    }
+
+    if (pEncInst->scene) {
+        h264e_scene_deinit(pEncInst->scene);
+        pEncInst->scene = NULL;
+    }
+
     if ((ret = H264EncRelease(pEncInst)) != H264ENC_OK) {
         mpp_err("H264EncRelease() failed, ret %d.", ret);
         return MPP_NOK;
@@ -82,6 +94,8 @@ MPP_RET h264e_encode(void *ctx, HalEncTask *task)
     H264EncOut *encOut = &(p->encOut);
     RK_U32 srcLumaWidth = p->lumWidthSrc;
     RK_U32 srcLumaHeight = p->lumHeightSrc;
+    RK_S32 first = (p->encStatus == H264ENCSTAT_INIT);
+    RK_S32 intra = 0;
 
     encIn->pOutBuf = (RK_U32*)mpp_buffer_get_ptr(task->output);
     encIn->busOutBuf = mpp_buffer_get_fd(task->output);
@@ -112,7 +126,35 @@ MPP_RET h264e_encode(void *ctx, HalEncTask *task)
     }
 
     /* Select frame type */
-    if (p->intraPicRate != 0 && (p->intraPeriodCnt >= p->intraPicRate)) {
+    task->scene = MPP_ENC_SCENE_NORMAL;
+    if (p->scene) {
+        RK_U8 *luma = (RK_U8 *)mpp_buffer_get_ptr(task->input);
+        MppEncSceneInfo *info = &p->scene_info;
+        H264eSceneRet scene_ret;
+
+        if (luma && MPP_OK == h264e_scene_proc(p->scene, luma, p->intraPeriodCnt, &scene_ret)) {
+            task->scene = scene_ret.scene;
+            info->idr_by_scene  = scene_ret.idr && scene_ret.scene == MPP_ENC_SCENE_CUT;
+            info->hist_diff     = scene_ret.hist_diff;
+            info->sad           = scene_ret.sad;
+            info->luma_mean     = scene_ret.luma_mean;
+            intra = scene_ret.idr;
+        }
+
+        info->frame_count++;
+        info->scene = task->scene;
+        if (task->scene == MPP_ENC_SCENE_CUT)
+            info->cut_count++;
+        if (task->scene == MPP_ENC_SCENE_FADE)
+            info->fade_count++;
+    }
+
+    /* gop_max of scene detection replaces the fixed intra period */
+    if (!(p->scene && p->scene_cfg.gop_max) &&
+        p->intraPicRate != 0 && (p->intraPeriodCnt >= p->intraPicRate))
+        intra = 1;
+
+    if (intra || first) {
         encIn->codingType   = H264ENC_INTRA_FRAME;
         task->is_intra      = 1;
     } else {
@@ -123,6 +165,22 @@ MPP_RET h264e_encode(void *ctx, HalEncTask *task)
     if (encIn->codingType == H264ENC_INTRA_FRAME)
         p->intraPeriodCnt = 0;
 
+    p->scene_info.is_intra = task->is_intra;
+
+    /* Take lookahead result of this frame */
+    if (p->lkh) {
+        h264RateControl_s *rc = &p->rateControl;
+        H264eLkhRet lkh_ret;
+
+        rc->lkhRc = ENCHW_NO;
+        if (MPP_OK == h264e_lkh_get(p->lkh, &lkh_ret)) {
+            rc->lkhRc       = ENCHW_YES;
+            rc->lkhCplx     = MPP_MAX(lkh_ret.cplx_q8, 1);
+            rc->lkhBits     = lkh_ret.bits_q8;
+            rc->lkhQpDelta  = lkh_ret.qp_delta;
+        }
+    }
+
     memset(&p->syntax, 0, sizeof(p->syntax));
     ret = H264EncStrmEncode(p, encIn, encOut, &p->syntax);
     if (ret != H264ENC_FRAME_READY) {
@@ -172,6 +230,58 @@ static const H264Level h264e_supported_level[] = {
     H264_LEVEL_4_2,
 };
 
+static void h264e_lkh_setup(H264ECtx *enc, MppEncConfig *mpp_cfg)
+{
+    H264eLkhCfg cfg;
+
+    /* lookahead only reads the luma plane at the start of the buffer */
+    switch (mpp_cfg->format) {
+    case MPP_FMT_YUV420P:
+    case MPP_FMT_YUV420SP:
+    case MPP_FMT_YUV420SP_VU:
+    case MPP_FMT_YUV422P:
+    case MPP_FMT_YUV422SP:
+    case MPP_FMT_YUV422SP_VU: {
+    } break;
+    default : {
+        mpp_log_f("lookahead is disabled on input format %d\n", mpp_cfg->format);
+        return;
+    } break;
+    }
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.width       = mpp_cfg->width;
+    cfg.height      = mpp_cfg->height;
+    cfg.hor_stride  = mpp_cfg->hor_stride;
+    cfg.depth       = enc->lkh_depth;
+    /* MppThreadSched has the same value as THREAD_SCHED_XXX */
+    cfg.policy.cpu_mask = enc->lkh_thread.cpu_mask;
+    cfg.policy.sched    = enc->lkh_thread.sched;
+    cfg.policy.priority = enc->lkh_thread.priority;
+    cfg.name        = (enc->lkh_thread.name[0]) ? (enc->lkh_thread.name) : (NULL);
+
+    if (h264e_lkh_init(&enc->lkh, &cfg))
+        mpp_err_f("failed to init lookahead depth %d\n", enc->lkh_depth);
+}
+
+static void h264e_scene_setup(H264ECtx *enc)
+{
+    if (enc->scene) {
+        h264e_scene_deinit(enc->scene);
+        enc->scene = NULL;
+    }
+
+    if (!enc->scene_cfg.enable || !enc->scene_size.width)
+        return;
+
+    if (h264e_scene_init(&enc->scene, &enc->scene_size)) {
+        mpp_err_f("failed to init scene detection\n");
+        return;
+    }
+
+    h264e_scene_set_cfg(enc->scene, &enc->scene_cfg);
+}
+
 static MPP_RET h264e_check_mpp_cfg(MppEncConfig *mpp_cfg)
 {
     MPP_RET ret = MPP_NOK;
@@ -290,6 +400,27 @@ MPP_RET h264e_config(void *ctx, RK_S32 cmd, void *param)
         ret = H264EncCfg(enc, enc_cfg);
 		(void) ret;
 
+        if (enc->lkh_depth && NULL == enc->lkh)
+            h264e_lkh_setup(enc, mpp_cfg);
+
+        /* scene detection reads the luma plane like lookahead */
+        memset(&enc->scene_size, 0, sizeof(enc->scene_size));
+        switch (mpp_cfg->format) {
+        case MPP_FMT_YUV420P:
+        case MPP_FMT_YUV420SP:
+        case MPP_FMT_YUV420SP_VU:
+        case MPP_FMT_YUV422P:
+        case MPP_FMT_YUV422SP:
+        case MPP_FMT_YUV422SP_VU: {
+            enc->scene_size.width       = mpp_cfg->width;
+            enc->scene_size.height      = mpp_cfg->height;
+            enc->scene_size.hor_stride  = mpp_cfg->hor_stride;
+        } break;
+        default : {
+        } break;
+        }
+        h264e_scene_setup(enc);
+
         /* Encoder setup: coding control */
         ret = H264EncGetCodingCtrl(enc, &oriCodingCfg);
         if (ret) {
@@ -297,7 +428,9 @@ MPP_RET h264e_config(void *ctx, RK_S32 cmd, void *param)
             h264e_deinit((void*)enc);
             break;
         } else {
-            oriCodingCfg.sliceSize = 0;
+            /* slice larger than frame is one slice per frame */
+            oriCodingCfg.sliceSize = (enc->slice_mb_rows < enc->mbPerCol) ?
+                                     enc->slice_mb_rows : 0;
             oriCodingCfg.constrainedIntraPrediction = 0;
             oriCodingCfg.disableDeblockingFilter = 0;
             oriCodingCfg.enableCabac = enc_cfg->enable_cabac;
@@ -341,6 +474,12 @@ MPP_RET h264e_config(void *ctx, RK_S32 cmd, void *param)
             enc_rc_cfg->qpMin           = mpp_cfg->qp;
             enc_rc_cfg->hrd             = 0;
             enc_rc_cfg->intraQpDelta    = 0;
+
+            if (enc->lkh) {
+                /* constant quality mode, lookahead offsets the qp */
+                enc_rc_cfg->qpMax = MPP_MIN(mpp_cfg->qp + H264E_LKH_QP_DELTA_MAX, 51);
+                enc_rc_cfg->qpMin = MPP_MAX(mpp_cfg->qp - H264E_LKH_QP_DELTA_MAX, 1);
+            }
         }
         enc_rc_cfg->pictureSkip = mpp_cfg->skip_cnt;
 
@@ -424,6 +563,50 @@ MPP_RET h264e_config(void *ctx, RK_S32 cmd, void *param)
     case GET_OUTPUT_STREAM_SIZE : {
         *((RK_U32*)param) = getOutputStreamSize(enc);
     } break;
+    case SET_ENC_LOOKAHEAD : {
+        RK_S32 depth = *((RK_S32 *)param);
+
+        enc->lkh_depth = MPP_MIN(MPP_MAX(depth, 0), H264E_LKH_MAX_DEPTH);
+        ret = MPP_OK;
+    } break;
+    case SET_ENC_THREAD_CFG : {
+        MppThreadCfg *cfg = (MppThreadCfg *)param;
+
+        if (cfg->id == MPP_THREAD_LOOKAHEAD)
+            enc->lkh_thread = *cfg;
+        ret = MPP_OK;
+    } break;
+    case PUT_ENC_LOOKAHEAD_FRM : {
+        if (enc->lkh)
+            ret = h264e_lkh_put(enc->lkh, (MppBuffer)param);
+    } break;
+    case SET_ENC_SCENE_CFG : {
+        MppEncSceneCfg *cfg = (MppEncSceneCfg *)param;
+
+        enc->scene_cfg = *cfg;
+        if (cfg->enable && enc->scene)
+            h264e_scene_set_cfg(enc->scene, cfg);
+        else
+            h264e_scene_setup(enc);
+
+        if (cfg->enable && NULL == enc->scene && enc->scene_size.width)
+            mpp_log_f("scene detection is disabled on current input format\n");
+        ret = MPP_OK;
+    } break;
+    case GET_ENC_SCENE_INFO : {
+        *((MppEncSceneInfo *)param) = enc->scene_info;
+        ret = MPP_OK;
+    } break;
+    case GET_OUTPUT_NAL_INFO : {
+        *((MppEncNal **)param) = &enc->nal;
+        ret = MPP_OK;
+    } break;
+    case SET_ENC_SLICE_CFG : {
+        MppEncSliceCfg *cfg = (MppEncSliceCfg *)param;
+
+        enc->slice_mb_rows = cfg->mb_rows;
+        ret = MPP_OK;
+    } break;
     default:
         mpp_err("No correspond cmd found, and can not config!");
         break;
@@ -434,6 +617,41 @@ MPP_RET h264e_config(void *ctx, RK_S32 cmd, void *param)
     return ret;
 }
 
+/*
+ * software sei is written at stream start, hw slices follow it. The slice
+ * sizes come from hw nal size table when it matches the stream size,
+ * otherwise the slices are found by start code scan of the rest stream.
+ */
+static void h264e_update_nal(H264ECtx *enc, h264e_feedback *fb)
+{
+    MppEncNal *nal = &enc->nal;
+    sei_s *sei = &enc->rateControl.sei;
+    RK_U32 total = getOutputStreamSize(enc);
+    RK_U32 pos = 0;
+    RK_U32 sum = 0;
+    RK_U32 i;
+
+    if (sei->enabled == ENCHW_YES || sei->userDataEnabled == ENCHW_YES) {
+        if (sei->nalUnitSize >= total)
+            return ;
+
+        mpp_enc_nal_add(nal, 0, sei->nalUnitSize);
+        pos = sei->nalUnitSize;
+    }
+
+    for (i = 0; i < fb->nal_size_count; i++)
+        sum += fb->nal_size_table[i];
+
+    if (fb->nal_size_table && sum == total - pos) {
+        for (i = 0; i < fb->nal_size_count; i++) {
+            mpp_enc_nal_add(nal, pos, fb->nal_size_table[i]);
+            pos += fb->nal_size_table[i];
+        }
+    } else if (total > pos) {
+        mpp_enc_nal_add_rest(nal, pos, total - pos);
+    }
+}
+
 MPP_RET h264e_callback(void *ctx, void *feedback)
 {
     H264ECtx *enc = (H264ECtx *)ctx;
@@ -467,6 +685,8 @@ MPP_RET h264e_callback(void *ctx, void *feedback)
     /*hw status*/
     val->hw_status = fb->hw_status;
 
+    mpp_enc_nal_reset(&enc->nal, MPP_VIDEO_CodingAVC);
+
     // vpuWaitResult should be given from hal part, and here assume it is OK  // TODO  modify by lance 2016.06.01
     ret = H264EncStrmEncodeAfter(enc, encOut, vpuWaitResult);    // add by lance 2016.05.07
     switch (ret) {
@@ -474,6 +694,7 @@ MPP_RET h264e_callback(void *ctx, void *feedback)
         if (encOut->codingType != H264ENC_NOTCODED_FRAME) {
             enc->intraPeriodCnt++;
         }
+        h264e_update_nal(enc, fb);
         break;
 
     case H264ENC_OUTPUT_BUFFER_OVERFLOW:
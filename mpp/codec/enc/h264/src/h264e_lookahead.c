@@ -0,0 +1,451 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "h264e_lkh"
+
+#include <string.h>
+
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+
+#include "H264Instance.h"
+#include "h264e_lookahead.h"
+
+#define LKH_SCALE_SHIFT         2
+#define LKH_BLK_SIZE            8
+#define LKH_SEARCH_RANGE        2
+/* per block noise floor so static frames still get a sane cost */
+#define LKH_BLK_BIAS            64
+/* rate to complexity exponent 0.6 and qp scale 6 * (1 - 0.6) in Q8 */
+#define LKH_BITS_POW_Q8         154
+#define LKH_QP_SCALE_Q8         614
+
+typedef struct H264eLkhFrm_t {
+    MppBuffer       buf;
+    RK_S32          intra_cost;
+    RK_S32          inter_cost;
+    RK_S32          cost;
+} H264eLkhFrm;
+
+typedef struct H264eLkhImpl_t {
+    H264eLkhCfg     cfg;
+
+    /* lowres planes for current and previous frame */
+    RK_S32          lw;
+    RK_S32          lh;
+    RK_U8           *lowres[2];
+    RK_S32          cur;
+    RK_S32          has_prev;
+
+    /*
+     * frame ring: frames in [rd, done) are analyzed and frames in [done, wr)
+     * are waiting for the worker thread
+     */
+    H264eLkhFrm     frms[H264E_LKH_MAX_DEPTH + 1];
+    RK_U32          rd;
+    RK_U32          wr;
+    RK_U32          done;
+
+    /* long term average cost for constant qp mode */
+    RK_S64          cost_avg;
+
+    /* ring and lowres planes are protected by the thread lock */
+    MppThread       *thd;
+} H264eLkhImpl;
+
+#define LKH_RING_SIZE           (H264E_LKH_MAX_DEPTH + 1)
+
+/* log2 in Q8 with linear mantissa, x must be positive */
+static RK_S32 lkh_log2_q8(RK_S64 x)
+{
+    RK_S32 n = 0;
+
+    while ((x >> n) > 1)
+        n++;
+
+    return (n << 8) + (RK_S32)(((x << 8) >> n) - 256);
+}
+
+/* 2 ^ (y / 256) in Q8 with linear mantissa */
+static RK_S32 lkh_exp2_q8(RK_S32 y)
+{
+    RK_S32 n = y >> 8;
+    RK_S32 m = 256 + (y & 0xff);
+
+    if (n >= 0)
+        return m << MPP_MIN(n, 20);
+
+    return m >> MPP_MIN(-n, 31);
+}
+
+static void lkh_downscale(H264eLkhImpl *p, RK_U8 *src, RK_U8 *dst)
+{
+    RK_S32 stride = p->cfg.hor_stride;
+    RK_S32 x, y, i;
+
+    for (y = 0; y < p->lh; y++) {
+        RK_U8 *s = src + (y << LKH_SCALE_SHIFT) * stride;
+        RK_U8 *d = dst + y * p->lw;
+
+        for (x = 0; x < p->lw; x++) {
+            RK_U32 sum = 0;
+
+            for (i = 0; i < 4; i++) {
+                RK_U8 *r = s + i * stride + (x << LKH_SCALE_SHIFT);
+
+                sum += r[0] + r[1] + r[2] + r[3];
+            }
+            d[x] = (RK_U8)((sum + 8) >> 4);
+        }
+    }
+}
+
+static RK_S32 lkh_sad_blk(RK_U8 *a, RK_U8 *b, RK_S32 stride)
+{
+    RK_S32 sad = 0;
+    RK_S32 x, y;
+
+    for (y = 0; y < LKH_BLK_SIZE; y++) {
+        for (x = 0; x < LKH_BLK_SIZE; x++)
+            sad += MPP_ABS(a[x] - b[x]);
+
+        a += stride;
+        b += stride;
+    }
+
+    return sad;
+}
+
+static RK_S32 lkh_intra_blk(RK_U8 *blk, RK_S32 stride, RK_S32 has_top, RK_S32 has_left)
+{
+    RK_U8 *top = blk - stride;
+    RK_S32 sad_dc = 0;
+    RK_S32 sad_h = 0;
+    RK_S32 sad_v = 0;
+    RK_S32 dc = 0;
+    RK_S32 cnt = 0;
+    RK_S32 x, y;
+
+    if (has_top) {
+        for (x = 0; x < LKH_BLK_SIZE; x++)
+            dc += top[x];
+        cnt += LKH_BLK_SIZE;
+    }
+    if (has_left) {
+        for (y = 0; y < LKH_BLK_SIZE; y++)
+            dc += blk[y * stride - 1];
+        cnt += LKH_BLK_SIZE;
+    }
+    dc = (cnt) ? ((dc + cnt / 2) / cnt) : (128);
+
+    for (y = 0; y < LKH_BLK_SIZE; y++) {
+        RK_U8 *r = blk + y * stride;
+        RK_S32 left = (has_left) ? (r[-1]) : (0);
+
+        for (x = 0; x < LKH_BLK_SIZE; x++) {
+            sad_dc += MPP_ABS(r[x] - dc);
+            if (has_top)
+                sad_v += MPP_ABS(r[x] - top[x]);
+            if (has_left)
+                sad_h += MPP_ABS(r[x] - left);
+        }
+    }
+
+    if (has_top)
+        sad_dc = MPP_MIN(sad_dc, sad_v);
+    if (has_left)
+        sad_dc = MPP_MIN(sad_dc, sad_h);
+
+    return sad_dc;
+}
+
+static RK_S32 lkh_inter_blk(H264eLkhImpl *p, RK_U8 *cur, RK_U8 *ref, RK_S32 bx, RK_S32 by)
+{
+    RK_S32 lw = p->lw;
+    RK_S32 x0 = MPP_MAX(bx - LKH_SEARCH_RANGE, 0);
+    RK_S32 y0 = MPP_MAX(by - LKH_SEARCH_RANGE, 0);
+    RK_S32 x1 = MPP_MIN(bx + LKH_SEARCH_RANGE, lw - LKH_BLK_SIZE);
+    RK_S32 y1 = MPP_MIN(by + LKH_SEARCH_RANGE, p->lh - LKH_BLK_SIZE);
+    RK_U8 *blk = cur + by * lw + bx;
+    RK_S32 best = lkh_sad_blk(blk, ref + by * lw + bx, lw);
+    RK_S32 x, y;
+
+    for (y = y0; y <= y1; y++) {
+        for (x = x0; x <= x1; x++) {
+            RK_S32 sad;
+
+            if (x == bx && y == by)
+                continue;
+
+            sad = lkh_sad_blk(blk, ref + y * lw + x, lw);
+            if (sad < best)
+                best = sad;
+        }
+    }
+
+    return best;
+}
+
+static void lkh_analyze(H264eLkhImpl *p, H264eLkhFrm *frm)
+{
+    RK_U8 *src = (RK_U8 *)mpp_buffer_get_ptr(frm->buf);
+    RK_U8 *cur = p->lowres[p->cur];
+    RK_U8 *ref = p->lowres[!p->cur];
+    RK_S32 lw = p->lw;
+    RK_S32 intra_cost = 0;
+    RK_S32 inter_cost = 0;
+    RK_S32 cost = 0;
+    RK_S32 bx, by;
+
+    if (NULL == src) {
+        mpp_err_f("failed to get input buffer address\n");
+        frm->intra_cost = frm->inter_cost = frm->cost = 1;
+        return;
+    }
+
+    lkh_downscale(p, src, cur);
+
+    for (by = 0; by + LKH_BLK_SIZE <= p->lh; by += LKH_BLK_SIZE) {
+        for (bx = 0; bx + LKH_BLK_SIZE <= lw; bx += LKH_BLK_SIZE) {
+            RK_S32 intra = lkh_intra_blk(cur + by * lw + bx, lw, by > 0, bx > 0);
+            RK_S32 inter = (p->has_prev) ? lkh_inter_blk(p, cur, ref, bx, by) : intra;
+
+            intra_cost += intra;
+            inter_cost += inter;
+            cost += MPP_MIN(intra, inter) + LKH_BLK_BIAS;
+        }
+    }
+
+    frm->intra_cost = intra_cost;
+    frm->inter_cost = inter_cost;
+    frm->cost = cost;
+
+    p->cur = !p->cur;
+    p->has_prev = 1;
+
+    h264e_dbg(H264E_DBG_LOOKAHEAD, "analyze intra %d inter %d cost %d\n",
+              intra_cost, inter_cost, cost);
+}
+
+static void *lkh_thread(void *arg)
+{
+    H264eLkhImpl *p = (H264eLkhImpl *)arg;
+    MppThread *thd = p->thd;
+
+    mpp_thread_lock(thd);
+    while (1) {
+        H264eLkhFrm *frm;
+
+        while (MPP_THREAD_RUNNING == mpp_thread_get_status(thd) && p->done == p->wr)
+            mpp_thread_wait(thd);
+
+        if (MPP_THREAD_RUNNING != mpp_thread_get_status(thd))
+            break;
+
+        frm = &p->frms[p->done % LKH_RING_SIZE];
+        mpp_thread_unlock(thd);
+
+        lkh_analyze(p, frm);
+
+        mpp_thread_lock(thd);
+        mpp_buffer_put(frm->buf);
+        frm->buf = NULL;
+        p->done++;
+        // encoder may wait for the result while the thread waits for input
+        mpp_thread_broadcast(thd);
+    }
+    mpp_thread_unlock(thd);
+
+    return NULL;
+}
+
+MPP_RET h264e_lkh_init(H264eLkh *ctx, H264eLkhCfg *cfg)
+{
+    H264eLkhImpl *p = NULL;
+    RK_S32 size;
+
+    if (NULL == ctx || NULL == cfg) {
+        mpp_err_f("found NULL input ctx %p cfg %p\n", ctx, cfg);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *ctx = NULL;
+
+    if (cfg->width < LKH_BLK_SIZE << LKH_SCALE_SHIFT ||
+        cfg->height < LKH_BLK_SIZE << LKH_SCALE_SHIFT ||
+        cfg->hor_stride < cfg->width || cfg->depth <= 0) {
+        mpp_err_f("invalid size %dx%d stride %d depth %d\n",
+                  cfg->width, cfg->height, cfg->hor_stride, cfg->depth);
+        return MPP_ERR_VALUE;
+    }
+
+    p = mpp_calloc(H264eLkhImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->cfg = *cfg;
+    p->cfg.depth = MPP_MIN(cfg->depth, H264E_LKH_MAX_DEPTH);
+    p->lw = cfg->width >> LKH_SCALE_SHIFT;
+    p->lh = cfg->height >> LKH_SCALE_SHIFT;
+    size = p->lw * p->lh;
+    p->lowres[0] = mpp_malloc(RK_U8, size * 2);
+    if (NULL == p->lowres[0]) {
+        mpp_err_f("failed to malloc lowres buffer\n");
+        mpp_free(p);
+        return MPP_ERR_MALLOC;
+    }
+    p->lowres[1] = p->lowres[0] + size;
+
+    p->thd = mpp_thread_create(lkh_thread, p, cfg->name ? cfg->name : "h264e_lkh");
+    if (p->thd) {
+        mpp_thread_set_policy(p->thd, &cfg->policy);
+        mpp_thread_start(p->thd);
+    }
+
+    if (NULL == p->thd || MPP_THREAD_RUNNING != mpp_thread_get_status(p->thd)) {
+        mpp_err_f("failed to create lookahead thread\n");
+        mpp_thread_destroy(p->thd);
+        mpp_free(p->lowres[0]);
+        mpp_free(p);
+        return MPP_NOK;
+    }
+
+    *ctx = p;
+    return MPP_OK;
+}
+
+MPP_RET h264e_lkh_deinit(H264eLkh ctx)
+{
+    H264eLkhImpl *p = (H264eLkhImpl *)ctx;
+    RK_U32 i;
+
+    if (NULL == p)
+        return MPP_OK;
+
+    mpp_thread_destroy(p->thd);
+
+    /* release the frames the thread did not get to */
+    for (i = p->done; i != p->wr; i++) {
+        H264eLkhFrm *frm = &p->frms[i % LKH_RING_SIZE];
+
+        if (frm->buf) {
+            mpp_buffer_put(frm->buf);
+            frm->buf = NULL;
+        }
+    }
+
+    mpp_free(p->lowres[0]);
+    mpp_free(p);
+    return MPP_OK;
+}
+
+MPP_RET h264e_lkh_put(H264eLkh ctx, MppBuffer buf)
+{
+    H264eLkhImpl *p = (H264eLkhImpl *)ctx;
+    MPP_RET ret = MPP_NOK;
+
+    if (NULL == p || NULL == buf) {
+        mpp_err_f("found NULL input ctx %p buf %p\n", p, buf);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_thread_lock(p->thd);
+    if (p->wr - p->rd < LKH_RING_SIZE) {
+        H264eLkhFrm *frm = &p->frms[p->wr % LKH_RING_SIZE];
+
+        mpp_buffer_inc_ref(buf);
+        frm->buf = buf;
+        frm->intra_cost = 0;
+        frm->inter_cost = 0;
+        frm->cost = 0;
+        p->wr++;
+        mpp_thread_broadcast(p->thd);
+        ret = MPP_OK;
+    } else {
+        mpp_err_f("lookahead queue full\n");
+    }
+    mpp_thread_unlock(p->thd);
+
+    return ret;
+}
+
+MPP_RET h264e_lkh_get(H264eLkh ctx, H264eLkhRet *ret)
+{
+    H264eLkhImpl *p = (H264eLkhImpl *)ctx;
+    RK_S32 weights[LKH_RING_SIZE];
+    H264eLkhFrm *frm;
+    RK_S64 sum = 0;
+    RK_S32 log_avg, log_cur;
+    RK_S32 count, i;
+
+    if (NULL == p || NULL == ret) {
+        mpp_err_f("found NULL input ctx %p ret %p\n", p, ret);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_thread_lock(p->thd);
+    if (p->rd == p->wr) {
+        mpp_thread_unlock(p->thd);
+        return MPP_NOK;
+    }
+
+    /* window is the frames already analyzed, only wait for the oldest one */
+    while (p->done == p->rd)
+        mpp_thread_wait(p->thd);
+
+    count = (RK_S32)(p->done - p->rd);
+    for (i = 0; i < count; i++)
+        sum += p->frms[(p->rd + i) % LKH_RING_SIZE].cost;
+
+    log_avg = lkh_log2_q8(MPP_MAX(sum / count, 1));
+
+    /* bit weight of each frame in window is (cost / avg) ^ 0.6 */
+    sum = 0;
+    for (i = 0; i < count; i++) {
+        RK_S32 cost = p->frms[(p->rd + i) % LKH_RING_SIZE].cost;
+        RK_S32 log_diff = lkh_log2_q8(MPP_MAX(cost, 1)) - log_avg;
+
+        weights[i] = lkh_exp2_q8(log_diff * LKH_BITS_POW_Q8 / 256);
+        sum += weights[i];
+    }
+
+    frm = &p->frms[p->rd % LKH_RING_SIZE];
+    log_cur = lkh_log2_q8(MPP_MAX(frm->cost, 1));
+
+    if (!p->cost_avg)
+        p->cost_avg = MPP_MAX(frm->cost, 1);
+
+    ret->intra_cost = frm->intra_cost;
+    ret->inter_cost = frm->inter_cost;
+    ret->cost       = frm->cost;
+    ret->frames     = count;
+    ret->cplx_q8    = lkh_exp2_q8(log_cur - log_avg);
+    ret->bits_q8    = (RK_S32)((RK_S64)weights[0] * 256 * count / MPP_MAX(sum, 1));
+    ret->qp_delta   = ((log_cur - lkh_log2_q8(p->cost_avg)) * LKH_QP_SCALE_Q8 + (1 << 15)) >> 16;
+    ret->qp_delta   = MPP_CLIP3(-H264E_LKH_QP_DELTA_MAX, H264E_LKH_QP_DELTA_MAX, ret->qp_delta);
+
+    p->cost_avg = (p->cost_avg * 7 + MPP_MAX(frm->cost, 1) + 4) >> 3;
+    p->rd++;
+    mpp_thread_unlock(p->thd);
+
+    h264e_dbg(H264E_DBG_LOOKAHEAD, "frame cost %d cplx %d bits %d qp delta %d window %d\n",
+              ret->cost, ret->cplx_q8, ret->bits_q8, ret->qp_delta, ret->frames);
+
+    return MPP_OK;
+}
@@ -0,0 +1,313 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "h264e_scene"
+
+#include <string.h>
+
+#include "mpp_mem.h"
+#include "mpp_common.h"
+
+#include "H264Instance.h"
+#include "h264e_scene.h"
+
+#define SCENE_SCALE_SHIFT       3
+#define SCENE_SCALE             (1 << SCENE_SCALE_SHIFT)
+#define SCENE_HIST_BITS         6
+#define SCENE_HIST_SIZE         (1 << SCENE_HIST_BITS)
+/* min compensated sad in Q4 for a scene cut, 4 luma levels */
+#define SCENE_SAD_FLOOR         64
+/* min luma mean drift per frame in Q4 and frame count for a fade */
+#define SCENE_FADE_STEP         8
+#define SCENE_FADE_FRAMES       2
+#define SCENE_DEFAULT_SENS      50
+
+typedef struct H264eSceneImpl_t {
+    H264eSceneCfg   cfg;
+    MppEncSceneCfg  scene_cfg;
+
+    /* thresholds derived from sensitivity */
+    RK_S32          hist_thr;
+    RK_S32          sad_ratio_q4;
+
+    RK_S32          lw;
+    RK_S32          lh;
+    RK_U8           *lowres[2];
+    RK_S32          hist[2][SCENE_HIST_SIZE];
+    RK_S32          mean[2];
+    RK_S32          cur;
+    RK_S32          has_prev;
+
+    /* running average of compensated sad, negative when not known yet */
+    RK_S32          sad_avg;
+    RK_S32          fade_run;
+    RK_S32          fade_dir;
+} H264eSceneImpl;
+
+/*
+ * 8 x 8 box downscale with luma histogram and sum. Rows are accumulated in a
+ * line buffer first so the inner loops are plain byte adds the compiler can
+ * vectorize.
+ */
+static RK_S32 scene_downscale(H264eSceneImpl *p, RK_U8 *src, RK_U8 *dst, RK_S32 *hist)
+{
+    RK_S32 stride = p->cfg.hor_stride;
+    RK_S32 lw = p->lw;
+    RK_U16 line[SCENE_SCALE * 1024];
+    RK_U16 *acc = line;
+    RK_S32 sum = 0;
+    RK_S32 x, y, i;
+
+    /* fall back to a heap line when width is over 8K */
+    if (p->cfg.width > (RK_S32)MPP_ARRAY_ELEMS(line)) {
+        acc = mpp_malloc(RK_U16, p->cfg.width);
+        if (NULL == acc)
+            return -1;
+    }
+
+    memset(hist, 0, sizeof(RK_S32) * SCENE_HIST_SIZE);
+
+    for (y = 0; y < p->lh; y++) {
+        RK_U8 *s = src + (y << SCENE_SCALE_SHIFT) * stride;
+        RK_U8 *d = dst + y * lw;
+        RK_S32 w = lw << SCENE_SCALE_SHIFT;
+
+        for (x = 0; x < w; x++)
+            acc[x] = s[x];
+
+        for (i = 1; i < SCENE_SCALE; i++) {
+            RK_U8 *r = s + i * stride;
+
+            for (x = 0; x < w; x++)
+                acc[x] += r[x];
+        }
+
+        for (x = 0; x < lw; x++) {
+            RK_U16 *a = acc + (x << SCENE_SCALE_SHIFT);
+            RK_U32 v = a[0] + a[1] + a[2] + a[3] + a[4] + a[5] + a[6] + a[7];
+
+            v = (v + 32) >> 6;
+            d[x] = (RK_U8)v;
+            hist[v >> (8 - SCENE_HIST_BITS)]++;
+            sum += v;
+        }
+    }
+
+    if (acc != line)
+        mpp_free(acc);
+
+    return sum;
+}
+
+static void scene_update_thr(H264eSceneImpl *p)
+{
+    RK_S32 sens = p->scene_cfg.sensitivity;
+
+    sens = (sens) ? MPP_CLIP3(1, 100, sens) : SCENE_DEFAULT_SENS;
+
+    /* sensitivity 50: histogram distance 25% and 5x of average sad */
+    p->hist_thr = 16 + (100 - sens) * 96 / 100;
+    p->sad_ratio_q4 = 32 + (100 - sens) * 96 / 100;
+}
+
+MPP_RET h264e_scene_init(H264eScene *ctx, H264eSceneCfg *cfg)
+{
+    H264eSceneImpl *p = NULL;
+    RK_S32 size;
+
+    if (NULL == ctx || NULL == cfg) {
+        mpp_err_f("found NULL input ctx %p cfg %p\n", ctx, cfg);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *ctx = NULL;
+
+    if (cfg->width < SCENE_SCALE * 8 || cfg->height < SCENE_SCALE * 8 ||
+        cfg->hor_stride < cfg->width) {
+        mpp_err_f("invalid size %dx%d stride %d\n",
+                  cfg->width, cfg->height, cfg->hor_stride);
+        return MPP_ERR_VALUE;
+    }
+
+    p = mpp_calloc(H264eSceneImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->cfg = *cfg;
+    p->lw = cfg->width >> SCENE_SCALE_SHIFT;
+    p->lh = cfg->height >> SCENE_SCALE_SHIFT;
+    size = p->lw * p->lh;
+    p->lowres[0] = mpp_malloc(RK_U8, size * 2);
+    if (NULL == p->lowres[0]) {
+        mpp_err_f("failed to malloc lowres buffer\n");
+        mpp_free(p);
+        return MPP_ERR_MALLOC;
+    }
+    p->lowres[1] = p->lowres[0] + size;
+    p->sad_avg = -1;
+    p->scene_cfg.enable = 1;
+    scene_update_thr(p);
+
+    *ctx = p;
+    return MPP_OK;
+}
+
+MPP_RET h264e_scene_deinit(H264eScene ctx)
+{
+    H264eSceneImpl *p = (H264eSceneImpl *)ctx;
+
+    if (NULL == p)
+        return MPP_OK;
+
+    mpp_free(p->lowres[0]);
+    mpp_free(p);
+    return MPP_OK;
+}
+
+MPP_RET h264e_scene_set_cfg(H264eScene ctx, MppEncSceneCfg *cfg)
+{
+    H264eSceneImpl *p = (H264eSceneImpl *)ctx;
+
+    if (NULL == p || NULL == cfg) {
+        mpp_err_f("found NULL input ctx %p cfg %p\n", p, cfg);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p->scene_cfg = *cfg;
+    p->scene_cfg.gop_min = MPP_MAX(cfg->gop_min, 0);
+    p->scene_cfg.gop_max = MPP_MAX(cfg->gop_max, 0);
+    scene_update_thr(p);
+
+    return MPP_OK;
+}
+
+MPP_RET h264e_scene_proc(H264eScene ctx, RK_U8 *luma, RK_S32 dist, H264eSceneRet *ret)
+{
+    H264eSceneImpl *p = (H264eSceneImpl *)ctx;
+    RK_S32 npix;
+    RK_S32 cur, prv;
+    RK_S32 *hist_c, *hist_p;
+    RK_U8 *lc, *lp;
+    RK_S32 sum;
+
+    if (NULL == p || NULL == luma || NULL == ret) {
+        mpp_err_f("found NULL input ctx %p luma %p ret %p\n", p, luma, ret);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    memset(ret, 0, sizeof(*ret));
+    ret->scene = MPP_ENC_SCENE_NORMAL;
+
+    npix = p->lw * p->lh;
+    cur = p->cur;
+    prv = !cur;
+    lc = p->lowres[cur];
+    lp = p->lowres[prv];
+    hist_c = p->hist[cur];
+    hist_p = p->hist[prv];
+
+    sum = scene_downscale(p, luma, lc, hist_c);
+    if (sum < 0) {
+        mpp_err_f("failed to malloc line buffer\n");
+        return MPP_ERR_MALLOC;
+    }
+    p->mean[cur] = (RK_S32)(((RK_S64)sum << 4) / npix);
+    ret->luma_mean = p->mean[cur];
+
+    if (p->has_prev) {
+        RK_S32 dm = p->mean[cur] - p->mean[prv];
+        RK_S32 gain_q8 = (p->mean[cur] << 8) / MPP_MAX(p->mean[prv], 1);
+        RK_S64 sad_off = 0;
+        RK_S64 sad_gain = 0;
+        RK_S32 hist_sum = 0;
+        RK_S32 sad_thr;
+        RK_S32 i;
+
+        for (i = 0; i < SCENE_HIST_SIZE; i++)
+            hist_sum += MPP_ABS(hist_c[i] - hist_p[i]);
+
+        for (i = 0; i < npix; i++) {
+            RK_S32 c = lc[i] << 4;
+            RK_S32 d0 = c - (lp[i] << 4) - dm;
+            RK_S32 d1 = c - ((lp[i] * gain_q8 + 8) >> 4);
+
+            sad_off  += MPP_ABS(d0);
+            sad_gain += MPP_ABS(d1);
+        }
+
+        ret->hist_diff = (RK_S32)((RK_S64)hist_sum * 128 / npix);
+        ret->sad = (RK_S32)(MPP_MIN(sad_off, sad_gain) / npix);
+
+        /* fade is a steady luma drift in one direction */
+        if (MPP_ABS(dm) >= SCENE_FADE_STEP) {
+            RK_S32 dir = (dm > 0) ? 1 : -1;
+
+            p->fade_run = (dir == p->fade_dir) ? p->fade_run + 1 : 1;
+            p->fade_dir = dir;
+        } else {
+            p->fade_run = 0;
+            p->fade_dir = 0;
+        }
+
+        /*
+         * a larger histogram jump needs less sad jump and the other way
+         * round, so cuts between scenes of similar luma or during fast
+         * motion are still caught
+         */
+        if (p->sad_avg >= 0) {
+            RK_S32 hist = ret->hist_diff;
+            RK_S32 sad = ret->sad;
+
+            sad_thr = p->sad_avg * p->sad_ratio_q4 >> 4;
+
+            if ((sad >= MPP_MAX(sad_thr, SCENE_SAD_FLOOR) && hist >= p->hist_thr) ||
+                (sad >= MPP_MAX(sad_thr * 2, SCENE_SAD_FLOOR) && hist >= p->hist_thr / 4) ||
+                (sad >= MPP_MAX(sad_thr / 2, SCENE_SAD_FLOOR) && hist >= p->hist_thr * 2))
+                ret->scene = MPP_ENC_SCENE_CUT;
+        }
+
+        if (ret->scene == MPP_ENC_SCENE_CUT) {
+            /* restart sad statistic on the new scene */
+            p->sad_avg = -1;
+            p->fade_run = 0;
+            p->fade_dir = 0;
+        } else {
+            if (p->fade_run >= SCENE_FADE_FRAMES)
+                ret->scene = MPP_ENC_SCENE_FADE;
+
+            p->sad_avg = (p->sad_avg < 0) ? ret->sad :
+                         ((p->sad_avg * 3 + ret->sad + 2) >> 2);
+        }
+    }
+
+    p->cur = prv;
+    p->has_prev = 1;
+
+    if (p->scene_cfg.enable) {
+        if (ret->scene == MPP_ENC_SCENE_CUT && dist >= p->scene_cfg.gop_min)
+            ret->idr = 1;
+        if (p->scene_cfg.gop_max && dist >= p->scene_cfg.gop_max)
+            ret->idr = 1;
+    }
+
+    h264e_dbg(H264E_DBG_SCENE, "scene %d idr %d dist %d hist %3d sad %4d avg %4d mean %4d\n",
+              ret->scene, ret->idr, dist, ret->hist_diff, ret->sad, p->sad_avg,
+              ret->luma_mean);
+
+    return MPP_OK;
+}
@@ -31,6 +31,13 @@ typedef enum EncCfgCmd_t {
     SET_ENC_RC_CFG,
     GET_ENC_EXTRA_INFO,
     GET_OUTPUT_STREAM_SIZE,
+    SET_ENC_LOOKAHEAD,          /* RK_S32 lookahead depth, before SET_ENC_CFG */
+    PUT_ENC_LOOKAHEAD_FRM,      /* MppBuffer of input frame in encoding order */
+    SET_ENC_SCENE_CFG,          /* MppEncSceneCfg */
+    GET_ENC_SCENE_INFO,         /* MppEncSceneInfo */
+    GET_OUTPUT_NAL_INFO,        /* MppEncNal * of the last encoded frame */
+    SET_ENC_SLICE_CFG,          /* MppEncSliceCfg, before SET_ENC_CFG */
+    SET_ENC_THREAD_CFG,         /* MppThreadCfg of encoder worker thread, before SET_ENC_CFG */
 } EncCfgCmd;
 
 /*
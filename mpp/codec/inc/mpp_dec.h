@@ -41,6 +41,14 @@ struct MppDec_t {
     RK_U32              parser_fast_mode;
     RK_U32              parser_internal_pts;
 
+    // frame buffer pre-allocation status
+    // prealloc_mode    - MppDecPreAlloc
+    // prealloc_seq     - last slot hint sequence notified to alloc thread
+    // prealloc_size    - buffer size of current and previous hint
+    RK_U32              prealloc_mode;
+    RK_U32              prealloc_seq;
+    size_t              prealloc_size[2];
+
     // dec parser thread runtime resource context
     MppPacket           mpp_pkt_in;
     void                *mpp;
@@ -51,6 +59,7 @@ typedef struct {
     RK_U32              fast_mode;
     RK_U32              need_split;
     RK_U32              internal_pts;
+    RK_U32              prealloc;
     void                *mpp;
 } MppDecCfg;
 
@@ -63,6 +72,7 @@ extern "C" {
  */
 void *mpp_dec_parser_thread(void *data);
 void *mpp_dec_hal_thread(void *data);
+void *mpp_dec_alloc_thread(void *data);
 
 /*
  *
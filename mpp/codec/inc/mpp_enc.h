@@ -21,6 +21,11 @@
 #include "mpp_controller.h"
 #include "mpp_hal.h"
 
+/* max frame count held in encoder for rate control lookahead */
+#define MPP_ENC_LOOKAHEAD_MAX   32
+/* output tasks added for slice packets in flight */
+#define MPP_ENC_SLICE_TASK_COUNT    8
+
 typedef struct MppEnc_t MppEnc;
 
 struct MppEnc_t {
@@ -36,6 +41,15 @@ struct MppEnc_t {
     RK_U32              reset_flag;
     void                *mpp;
 
+    /* frame count encoding is behind input for lookahead, 0 - disabled */
+    RK_S32              lookahead;
+    /* scene change detection config set to controller */
+    MppEncSceneCfg      scene_cfg;
+    /* nal unit index and format of output packet */
+    MppEncNalCfg        nal_cfg;
+    /* slice size and slice output mode */
+    MppEncSliceCfg      slice_cfg;
+
     /*
      * configuration parameter to controller and hal
      */
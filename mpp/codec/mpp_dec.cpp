@@ -31,6 +31,10 @@
 
 #include "vpu_api.h"
 
+/* frame buffer pre-allocation count when parser does not know the dpb size */
+#define MPP_DEC_PREALLOC_COUNT_DEFAULT  4
+
+/* NOTE: wait flag bit order is the same as MppStallReason */
 typedef union PaserTaskWait_u {
     RK_U32          val;
     struct {
@@ -141,6 +145,49 @@ static MPP_RET check_task_wait(MppDec *dec, DecTask *task)
     return MPP_OK;
 }
 
+/*
+ * wake up pre-allocation thread when parser gives a new frame buffer size
+ * NOTE: signal under thread lock so that the wake up can not be lost
+ */
+static void mpp_dec_check_prealloc(Mpp *mpp)
+{
+    MppThread *alloc = mpp->mThreadAlloc;
+    MppDec    *dec   = mpp->mDec;
+    RK_U32 seq;
+
+    if (NULL == alloc)
+        return;
+
+    seq = mpp_buf_slot_get_hint(dec->frame_slots, NULL, NULL);
+    if (seq != dec->prealloc_seq) {
+        dec->prealloc_seq = seq;
+        alloc->lock();
+        alloc->signal();
+        alloc->unlock();
+    }
+}
+
+/*
+ * record parser wait flags for runtime statistic
+ * stall count increases once when parser starts waiting for a reason
+ */
+static void mpp_dec_update_stall(Mpp *mpp, DecTask *task)
+{
+    RK_U32 prev = mpp->mStallCurrent;
+    RK_U32 curr = task->wait.val;
+    RK_U32 start = curr & ~prev;
+    RK_U32 i;
+
+    if (curr == prev)
+        return;
+
+    for (i = 0; i < MPP_STALL_BUTT; i++) {
+        if (start & (1 << i))
+            __atomic_fetch_add(&mpp->mStallCount[i], 1, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&mpp->mStallCurrent, curr, __ATOMIC_RELAXED);
+}
+
 static RK_U32 reset_dec_task(Mpp *mpp, DecTask *task)
 {
     MppThread *parser   = mpp->mThreadCodec;
@@ -233,6 +280,15 @@ static void mpp_put_frame(Mpp *mpp, MppFrame frame)
     if (mpp_debug & MPP_DBG_PTS)
         mpp_log("output frame pts %lld\n", mpp_frame_get_pts(frame));
 
+    if (mpp_frame_get_info_change(frame)) {
+        __atomic_fetch_add(&mpp->mInfoChangeCount, 1, __ATOMIC_RELAXED);
+    } else {
+        if (mpp_frame_get_errinfo(frame))
+            __atomic_fetch_add(&mpp->mErrorCount, 1, __ATOMIC_RELAXED);
+        if (mpp_frame_get_discard(frame))
+            __atomic_fetch_add(&mpp->mDiscardCount, 1, __ATOMIC_RELAXED);
+    }
+
     mpp->mFramePutCount++;
     list->signal();
     list->unlock();
@@ -256,7 +312,11 @@ static void mpp_dec_push_display(Mpp *mpp)
     mpp->mThreadHal->lock(THREAD_QUE_DISPLAY);
     while (MPP_OK == mpp_buf_slot_dequeue(frame_slots, &index, QUEUE_DISPLAY)) {
         MppFrame frame = NULL;
+        MppFrame slot_frame = NULL;
         mpp_buf_slot_get_prop(frame_slots, index, SLOT_FRAME, &frame);
+        /* meta data like sei goes with the output frame, slot frame is reused */
+        mpp_buf_slot_get_prop(frame_slots, index, SLOT_FRAME_PTR, &slot_frame);
+        mpp_frame_move_meta(frame, slot_frame);
         if (!dec->reset_flag) {
             mpp_put_frame(mpp, frame);
         } else {
@@ -264,6 +324,7 @@ static void mpp_dec_push_display(Mpp *mpp)
             MppBuffer buffer = mpp_frame_get_buffer(frame);
             if (buffer)
                 mpp_buffer_put(buffer);
+            mpp_frame_set_meta(frame, NULL);
         }
         mpp_buf_slot_clr_flag(frame_slots, index, SLOT_QUEUE_USE);
     }
@@ -349,6 +410,7 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
      */
     if (!task->status.curr_task_rdy) {
         RK_S64 p_e, p_s, diff;
+        size_t length = mpp_packet_get_length(dec->mpp_pkt_in);
         p_s = mpp_time();
 
         if (mpp_debug & MPP_DBG_PTS)
@@ -362,6 +424,8 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
                 mpp_log("waring mpp prepare stream consume %lld big than 15ms ", diff);
             }
         }
+        length -= mpp_packet_get_length(dec->mpp_pkt_in);
+        __atomic_fetch_add(&mpp->mStreamBytes, (RK_U64)length, __ATOMIC_RELAXED);
         if (0 == mpp_packet_get_length(dec->mpp_pkt_in)) {
             mpp_packet_deinit(&dec->mpp_pkt_in);
             dec->mpp_pkt_in = NULL;
@@ -425,10 +489,10 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
      * 6. copy prepared stream to hardware buffer
      */
     if (!task->status.dec_pkt_copy_rdy) {
-        MppBufferImpl *buf = (MppBufferImpl *)task->hal_pkt_buf_in;
+        MppBuffer buf = task->hal_pkt_buf_in;
         void *src = mpp_packet_get_data(task_dec->input_packet);
         size_t length = mpp_packet_get_length(task_dec->input_packet);
-        memcpy(buf->info.ptr, src, length);
+        memcpy(mpp_buffer_get_ptr(buf), src, length);
         mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_CODEC_READY);
         mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
         task->status.dec_pkt_copy_rdy = 1;
@@ -486,6 +550,7 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     if (!task->status.task_parsed_rdy) {
         parser_parse(dec->parser, task_dec);
         task->status.task_parsed_rdy = 1;
+        mpp_dec_check_prealloc(mpp);
     }
 
     /*
@@ -647,6 +712,15 @@ void *mpp_dec_parser_thread(void *data)
         }
 
         parser->lock();
+        /* skip mode is only changed on parser thread between two pictures */
+        if (mpp->mDecSkipUpdate) {
+            parser_control(dec->parser, MPP_DEC_SET_SKIP_MODE, &mpp->mDecSkip);
+            mpp->mDecSkipUpdate = 0;
+        }
+        if (mpp->mDecSeiUpdate) {
+            parser_control(dec->parser, MPP_DEC_SET_SEI_MASK, &mpp->mDecSeiMask);
+            mpp->mDecSeiUpdate = 0;
+        }
         if (MPP_THREAD_RUNNING == parser->get_status()) {
             if (check_task_wait(dec, &task))
                 parser->wait();
@@ -654,7 +728,9 @@ void *mpp_dec_parser_thread(void *data)
         parser->unlock();
 
 
-        if (try_proc_dec_task(mpp, &task))
+        MPP_RET ret = try_proc_dec_task(mpp, &task);
+        mpp_dec_update_stall(mpp, &task);
+        if (ret)
             continue;
 
     }
@@ -791,6 +867,83 @@ void *mpp_dec_hal_thread(void *data)
     return NULL;
 }
 
+/*
+ * create frame buffers of the hinted size in internal frame group
+ * buffers are created to unused list and taken by mpp_buffer_get on decoding
+ * return early when a newer hint comes so that the latest size goes first
+ */
+static void mpp_dec_prealloc(Mpp *mpp, RK_U32 seq, size_t size, RK_S32 count)
+{
+    MppThread *alloc = mpp->mThreadAlloc;
+    MppDec    *dec   = mpp->mDec;
+    MppBufferGroupImpl *group = (MppBufferGroupImpl *)mpp->mFrameGroup;
+    RK_S32 i;
+
+    if (NULL == group || mpp->mExternalFrameGroup || !size)
+        return;
+
+    if (size != dec->prealloc_size[0]) {
+        dec->prealloc_size[1] = dec->prealloc_size[0];
+        dec->prealloc_size[0] = size;
+    }
+
+    mpp_buffer_group_trim(group, size, (dec->prealloc_mode == MPP_DEC_PREALLOC_KEEP) ?
+                          dec->prealloc_size[1] : 0);
+
+    if (!count)
+        count = MPP_DEC_PREALLOC_COUNT_DEFAULT;
+
+    count -= mpp_buffer_group_size_count(group, size);
+    mpp_dbg_f(MPP_DBG_NORMAL, "pre-allocate %d buffer size %d\n", count, size);
+
+    for (i = 0; i < count; i++) {
+        MppBufferInfo info = {
+            group->type,
+            size,
+            NULL,
+            NULL,
+            -1,
+            -1,
+        };
+
+        if (MPP_THREAD_RUNNING != alloc->get_status() ||
+            seq != mpp_buf_slot_get_hint(dec->frame_slots, NULL, NULL))
+            break;
+
+        if (mpp_buffer_create(MODULE_TAG, __FUNCTION__, group, &info, NULL))
+            break;
+    }
+}
+
+void *mpp_dec_alloc_thread(void *data)
+{
+    Mpp *mpp = (Mpp*)data;
+    MppThread *alloc    = mpp->mThreadAlloc;
+    MppDec    *dec      = mpp->mDec;
+    RK_U32 seq_done = 0;
+
+    while (MPP_THREAD_RUNNING == alloc->get_status()) {
+        size_t size = 0;
+        RK_S32 count = 0;
+        RK_U32 seq;
+
+        alloc->lock();
+        seq = mpp_buf_slot_get_hint(dec->frame_slots, &size, &count);
+        if (MPP_THREAD_RUNNING == alloc->get_status() && seq == seq_done)
+            alloc->wait();
+        alloc->unlock();
+
+        if (seq == seq_done)
+            continue;
+
+        seq_done = seq;
+        mpp_dec_prealloc(mpp, seq, size, count);
+    }
+
+    mpp_dbg_f(MPP_DBG_NORMAL, "mpp_dec_alloc_thread exit ok");
+    return NULL;
+}
+
 MPP_RET mpp_dec_init(MppDec **dec, MppDecCfg *cfg)
 {
     MPP_RET ret;
@@ -883,6 +1036,7 @@ MPP_RET mpp_dec_init(MppDec **dec, MppDecCfg *cfg)
         p->parser_need_split    = cfg->need_split;
         p->parser_fast_mode     = cfg->fast_mode;
         p->parser_internal_pts  = cfg->internal_pts;
+        p->prealloc_mode        = cfg->prealloc;
         *dec = p;
         return MPP_OK;
     } while (0);
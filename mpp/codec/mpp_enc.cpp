@@ -26,6 +26,8 @@
 #include "mpp_frame_impl.h"
 #include "mpp_packet.h"
 #include "mpp_packet_impl.h"
+#include "mpp_enc_nal.h"
+#include "mpp_enc_slice.h"
 #include "hal_h264e_api.h"
 
 static void reset_hal_enc_task(HalEncTask *task)
@@ -70,19 +72,191 @@ static MPP_RET release_task_in_port(MppPort port)
     return ret;
 }
 
+/* index and reformat output nal units with the layout known by controller */
+static void mpp_enc_proc_nal(MppEnc *enc, MppPacket packet)
+{
+    MppEncNalCfg *cfg = &enc->nal_cfg;
+    MppBuffer buffer = mpp_packet_get_buffer(packet);
+    MppEncNal *nal = NULL;
+    MppMeta meta = NULL;
+    RK_U8 *data = (RK_U8 *)mpp_packet_get_data(packet);
+    RK_U32 length = (RK_U32)mpp_packet_get_length(packet);
+    RK_S32 format = MPP_ENC_NAL_FORMAT_ANNEXB;
+
+    if (!cfg->index_en && cfg->format == MPP_ENC_NAL_FORMAT_ANNEXB)
+        return ;
+
+    if (controller_config(enc->controller, GET_OUTPUT_NAL_INFO, (void *)&nal) || NULL == nal)
+        return ;
+
+    if (buffer)
+        mpp_buffer_sync_begin(buffer);
+
+    if (mpp_enc_nal_finish(nal, data, length) &&
+        cfg->format == MPP_ENC_NAL_FORMAT_AVCC)
+        mpp_enc_nal_scan(nal, data, length);
+
+    if (cfg->format == MPP_ENC_NAL_FORMAT_AVCC) {
+        if (mpp_enc_nal_to_avcc(nal, data, &length, (RK_U32)mpp_packet_get_size(packet))) {
+            mpp_err_f("failed to convert %d bytes packet to avcc, keep annexb\n", length);
+        } else {
+            mpp_packet_set_length(packet, length);
+            format = MPP_ENC_NAL_FORMAT_AVCC;
+        }
+    }
+
+    if (buffer)
+        mpp_buffer_sync_end(buffer);
+
+    if (cfg->index_en)
+        mpp_enc_nal_attach(nal, packet);
+
+    if (cfg->format != MPP_ENC_NAL_FORMAT_AVCC)
+        return ;
+
+    // user checks the actual format as the conversion may fail
+    meta = mpp_packet_get_meta(packet);
+    if (NULL == meta && MPP_OK == mpp_meta_get(&meta))
+        mpp_packet_set_meta(packet, meta);
+
+    if (meta)
+        mpp_meta_set_s32(meta, MPP_META_KEY_OUTPUT_NAL_FMT, format);
+}
+
+/* hal reports a finished slice in slice output mode */
+static MPP_RET mpp_enc_slice_cb(void *opaque, void *param)
+{
+    MppEncSliceOut *out = (MppEncSliceOut *)opaque;
+    HalEncSlice *slice = (HalEncSlice *)param;
+
+    return mpp_enc_slice_put(out, slice->offset + slice->length, slice->last);
+}
+
+static void mpp_enc_proc_task(Mpp *mpp, HalTaskInfo *task_info, MppTask mpp_task)
+{
+    MppEnc *enc = mpp->mEnc;
+    HalEncTask *enc_task = &task_info->enc;
+    MppPort input  = mpp_task_queue_get_port(mpp->mInputTaskQueue,  MPP_PORT_OUTPUT);
+    MppPort output = mpp_task_queue_get_port(mpp->mOutputTaskQueue, MPP_PORT_INPUT);
+    MppFrame frame = NULL;
+    MppPacket packet = NULL;
+    MppEncSliceOut slice_out;
+    RK_U32 split_out = 0;
+
+    mpp_task_meta_get_frame (mpp_task, MPP_META_KEY_INPUT_FRM,  &frame);
+    mpp_task_meta_get_packet(mpp_task, MPP_META_KEY_OUTPUT_PKT, &packet);
+
+    reset_hal_enc_task(enc_task);
+
+    if (mpp_frame_get_buffer(frame)) {
+        /*
+         * if there is available buffer in the input frame do encoding
+         */
+        if (NULL == packet) {
+            RK_U32 width  = enc->mpp_cfg.width;
+            RK_U32 height = enc->mpp_cfg.height;
+            RK_U32 size = width * height;
+            MppBuffer buffer = NULL;
+
+            mpp_buffer_get(mpp->mPacketGroup, &buffer, size);
+            mpp_log("create buffer size %d fd %d\n", size, mpp_buffer_get_fd(buffer));
+            mpp_packet_init_with_buffer(&packet, buffer);
+            mpp_buffer_put(buffer);
+        }
+        mpp_assert(packet);
+
+        mpp_packet_set_pts(packet, mpp_frame_get_pts(frame));
+
+        enc_task->input  = mpp_frame_get_buffer(frame);
+        enc_task->output = mpp_packet_get_buffer(packet);
+        mpp_task_meta_get_ptr(mpp_task, MPP_META_KEY_INPUT_ROI, (void **)&enc_task->roi, NULL);
+        controller_encode(enc->controller, enc_task);
+
+        /* slices are sent to output port from hal wait */
+        split_out = enc->slice_cfg.split_out;
+        if (split_out) {
+            mpp_enc_slice_start(&slice_out, output, packet);
+            slice_out.intra = enc_task->is_intra;
+            slice_out.scene = enc_task->scene;
+            enc_task->slice_cb.callBack = mpp_enc_slice_cb;
+            enc_task->slice_cb.opaque = &slice_out;
+
+            if (mpp_frame_get_eos(frame))
+                mpp_packet_set_eos(packet);
+        }
+
+        mpp_hal_reg_gen(enc->hal, task_info);
+        mpp_hal_hw_start(enc->hal, task_info);
+        mpp_hal_hw_wait(enc->hal, task_info);
+
+        RK_U32 outputStreamSize = 0;
+        controller_config(enc->controller, GET_OUTPUT_STREAM_SIZE, (void*)&outputStreamSize);
+
+        if (split_out) {
+            /* hal without slice report sends the whole frame here */
+            if (!slice_out.done &&
+                mpp_enc_slice_put(&slice_out, outputStreamSize, 1))
+                mpp_err_f("failed to output last slice\n");
+
+            mpp_task_meta_set_frame(mpp_task, MPP_META_KEY_INPUT_FRM, frame);
+            mpp_port_enqueue(input, mpp_task);
+            return ;
+        }
+
+        mpp_packet_set_length(packet, outputStreamSize);
+        mpp_enc_proc_nal(enc, packet);
+    } else {
+        /*
+         * else init a empty packet for output
+         */
+        mpp_packet_new(&packet);
+    }
+
+    if (mpp_frame_get_eos(frame))
+        mpp_packet_set_eos(packet);
+
+    /*
+     * first clear output packet
+     * then enqueue task back to input port
+     * final user will release the mpp_frame they had input
+     */
+    mpp_task_meta_set_frame(mpp_task, MPP_META_KEY_INPUT_FRM, frame);
+    mpp_port_enqueue(input, mpp_task);
+    mpp_task = NULL;
+
+    // send finished task to output port
+    mpp_port_dequeue(output, &mpp_task);
+    mpp_task_meta_set_packet(mpp_task, MPP_META_KEY_OUTPUT_PKT, packet);
+
+    {
+        RK_S32 is_intra = enc_task->is_intra;
+        RK_U32 flag = mpp_packet_get_flag(packet);
+
+        mpp_task_meta_set_s32(mpp_task, MPP_META_KEY_OUTPUT_INTRA, is_intra);
+        mpp_task_meta_set_s32(mpp_task, MPP_META_KEY_OUTPUT_SCENE, enc_task->scene);
+        if (is_intra) {
+            mpp_packet_set_flag(packet, flag | MPP_PACKET_FLAG_INTRA);
+        }
+    }
+
+    // setup output task here
+    mpp_port_enqueue(output, mpp_task);
+}
+
 void *mpp_enc_control_thread(void *data)
 {
     Mpp *mpp = (Mpp*)data;
     MppEnc *enc = mpp->mEnc;
     MppThread *thd_enc  = mpp->mThreadCodec;
     HalTaskInfo task_info;
-    HalEncTask *enc_task = &task_info.enc;
     MppPort input  = mpp_task_queue_get_port(mpp->mInputTaskQueue,  MPP_PORT_OUTPUT);
-    MppPort output = mpp_task_queue_get_port(mpp->mOutputTaskQueue, MPP_PORT_INPUT);
     MppTask mpp_task = NULL;
     MPP_RET ret = MPP_OK;
     MppFrame frame = NULL;
-    MppPacket packet = NULL;
+    /* tasks held for lookahead in encoding order */
+    MppTask pending[MPP_ENC_LOOKAHEAD_MAX + 1];
+    RK_S32 pending_cnt = 0;
+    RK_S32 i;
 
     memset(&task_info, 0, sizeof(HalTaskInfo));
 
@@ -95,88 +269,46 @@ void *mpp_enc_control_thread(void *data)
         thd_enc->unlock();
 
         if (mpp_task != NULL) {
-            mpp_task_meta_get_frame (mpp_task, MPP_META_KEY_INPUT_FRM,  &frame);
-            mpp_task_meta_get_packet(mpp_task, MPP_META_KEY_OUTPUT_PKT, &packet);
+            mpp_task_meta_get_frame(mpp_task, MPP_META_KEY_INPUT_FRM, &frame);
 
             if (NULL == frame) {
                 mpp_port_enqueue(input, mpp_task);
+                mpp_task = NULL;
                 continue;
             }
 
-            reset_hal_enc_task(enc_task);
+            if (enc->lookahead) {
+                RK_U32 eos = mpp_frame_get_eos(frame);
+                MppBuffer buffer = mpp_frame_get_buffer(frame);
 
-            if (mpp_frame_get_buffer(frame)) {
                 /*
-                 * if there is available buffer in the input frame do encoding
+                 * frames are sent to lookahead analysis on arrival and
+                 * encoded when lookahead depth frames are queued behind
+                 * them. On eos all held frames are flushed.
                  */
-                if (NULL == packet) {
-                    RK_U32 width  = enc->mpp_cfg.width;
-                    RK_U32 height = enc->mpp_cfg.height;
-                    RK_U32 size = width * height;
-                    MppBuffer buffer = NULL;
-
-                    mpp_buffer_get(mpp->mPacketGroup, &buffer, size);
-                    mpp_log("create buffer size %d fd %d\n", size, mpp_buffer_get_fd(buffer));
-                    mpp_packet_init_with_buffer(&packet, buffer);
-                    mpp_buffer_put(buffer);
+                if (buffer)
+                    controller_config(enc->controller, PUT_ENC_LOOKAHEAD_FRM, buffer);
+
+                pending[pending_cnt++] = mpp_task;
+                while (pending_cnt > enc->lookahead || (eos && pending_cnt)) {
+                    mpp_enc_proc_task(mpp, &task_info, pending[0]);
+                    pending_cnt--;
+                    for (i = 0; i < pending_cnt; i++)
+                        pending[i] = pending[i + 1];
                 }
-                mpp_assert(packet);
-
-                mpp_packet_set_pts(packet, mpp_frame_get_pts(frame));
-
-                enc_task->input  = mpp_frame_get_buffer(frame);
-                enc_task->output = mpp_packet_get_buffer(packet);
-                controller_encode(mpp->mEnc->controller, enc_task);
-
-                mpp_hal_reg_gen((mpp->mEnc->hal), &task_info);
-                mpp_hal_hw_start((mpp->mEnc->hal), &task_info);
-                mpp_hal_hw_wait((mpp->mEnc->hal), &task_info);
-
-                RK_U32 outputStreamSize = 0;
-                controller_config(mpp->mEnc->controller, GET_OUTPUT_STREAM_SIZE, (void*)&outputStreamSize);
-
-                mpp_packet_set_length(packet, outputStreamSize);
             } else {
-                /*
-                 * else init a empty packet for output
-                 */
-                mpp_packet_new(&packet);
+                mpp_enc_proc_task(mpp, &task_info, mpp_task);
             }
 
-            if (mpp_frame_get_eos(frame))
-                mpp_packet_set_eos(packet);
-
-            /*
-             * first clear output packet
-             * then enqueue task back to input port
-             * final user will release the mpp_frame they had input
-             */
-            mpp_task_meta_set_frame(mpp_task, MPP_META_KEY_INPUT_FRM, frame);
-            mpp_port_enqueue(input, mpp_task);
             mpp_task = NULL;
-
-            // send finished task to output port
-            mpp_port_dequeue(output, &mpp_task);
-            mpp_task_meta_set_packet(mpp_task, MPP_META_KEY_OUTPUT_PKT, packet);
-
-            {
-                RK_S32 is_intra = enc_task->is_intra;
-                RK_U32 flag = mpp_packet_get_flag(packet);
-
-                mpp_task_meta_set_s32(mpp_task, MPP_META_KEY_OUTPUT_INTRA, is_intra);
-                if (is_intra) {
-                    mpp_packet_set_flag(packet, flag | MPP_PACKET_FLAG_INTRA);
-                }
-            }
-
-            // setup output task here
-            mpp_port_enqueue(output, mpp_task);
-            mpp_task = NULL;
-            packet = NULL;
             frame = NULL;
         }
     }
 
+    // return frames held for lookahead to user
+    for (i = 0; i < pending_cnt; i++)
+        mpp_port_enqueue(input, pending[i]);
+
     // clear remain task in output port
     release_task_in_port(input);
     release_task_in_port(mpp->mOutputPort);
@@ -422,6 +554,49 @@ MPP_RET mpp_enc_control(MppEnc *enc, MpiCmd cmd, void *param)
     case MPP_ENC_GET_EXTRA_INFO : {
         ret = mpp_hal_control(enc->hal, cmd, param);
     } break;
+    case MPP_ENC_SET_RC_LOOKAHEAD : {
+        RK_S32 depth = *((RK_S32 *)param);
+
+        depth = MPP_MIN(MPP_MAX(depth, 0), MPP_ENC_LOOKAHEAD_MAX);
+        ret = controller_config(enc->controller, SET_ENC_LOOKAHEAD, (void *)&depth);
+        if (MPP_OK == ret)
+            enc->lookahead = depth;
+    } break;
+    case MPP_SET_THREAD_CFG : {
+        ret = controller_config(enc->controller, SET_ENC_THREAD_CFG, param);
+    } break;
+    case MPP_ENC_SET_SCENE_CFG : {
+        ret = controller_config(enc->controller, SET_ENC_SCENE_CFG, param);
+        if (MPP_OK == ret)
+            enc->scene_cfg = *((MppEncSceneCfg *)param);
+    } break;
+    case MPP_ENC_GET_SCENE_CFG : {
+        *((MppEncSceneCfg *)param) = enc->scene_cfg;
+        ret = MPP_OK;
+    } break;
+    case MPP_ENC_GET_SCENE_INFO : {
+        ret = controller_config(enc->controller, GET_ENC_SCENE_INFO, param);
+    } break;
+    case MPP_ENC_SET_NAL_CFG : {
+        MppEncNalCfg *cfg = (MppEncNalCfg *)param;
+
+        if (cfg->format >= MPP_ENC_NAL_FORMAT_BUTT) {
+            mpp_err_f("invalid nal format %d\n", cfg->format);
+            ret = MPP_ERR_VALUE;
+            break;
+        }
+        enc->nal_cfg = *cfg;
+        ret = MPP_OK;
+    } break;
+    case MPP_ENC_GET_NAL_CFG : {
+        *((MppEncNalCfg *)param) = enc->nal_cfg;
+        ret = MPP_OK;
+    } break;
+    case MPP_ENC_SET_SLICE_CFG : {
+        ret = controller_config(enc->controller, SET_ENC_SLICE_CFG, param);
+        if (MPP_OK == ret)
+            enc->slice_cfg = *((MppEncSliceCfg *)param);
+    } break;
     default : {
     } break;
     }
@@ -80,7 +80,9 @@ typedef struct h264e_feedback_t {
     RK_U32 out_strm_size;
 
     /* for VEPU future extansion */
-    //TODO: add nal size table feedback
+    /* hw slice nal size table in bytes, NULL when not supported */
+    RK_U32 *nal_size_table;
+    RK_U32 nal_size_count;
 }h264e_feedback;
 
 
@@ -71,11 +71,13 @@ public:
     MPP_RET put_frame(MppFrame frame);
     MPP_RET get_packet(MppPacket *packet);
 
+    MPP_RET poll(MppPortType type, MppPollType timeout);
     MPP_RET dequeue(MppPortType type, MppTask *task);
     MPP_RET enqueue(MppPortType type, MppTask task);
 
     MPP_RET reset();
     MPP_RET control(MpiCmd cmd, MppParam param);
+    MPP_RET get_stats(MppStats *stats);
 
     mpp_list        *mPackets;
     mpp_list        *mFrames;
@@ -89,6 +91,14 @@ public:
     RK_U32          mTaskPutCount;
     RK_U32          mTaskGetCount;
 
+    /* runtime statistic updated by atomic operation */
+    RK_U64          mStreamBytes;
+    RK_U32          mInfoChangeCount;
+    RK_U32          mErrorCount;
+    RK_U32          mDiscardCount;
+    RK_U32          mStallCurrent;
+    RK_U64          mStallCount[MPP_STALL_BUTT];
+
     /*
      * packet buffer group
      *      - packets in I/O, can be ion buffer or normal buffer
@@ -120,10 +130,19 @@ public:
      */
     MppThread       *mThreadCodec;
     MppThread       *mThreadHal;
+    /* decoder frame buffer pre-allocation thread, only on pre-allocation mode */
+    MppThread       *mThreadAlloc;
 
     MppDec          *mDec;
     MppEnc          *mEnc;
 
+    /* decoder skip mode protected by codec thread lock, applied by parser thread */
+    MppDecSkipCfg   mDecSkip;
+    RK_U32          mDecSkipUpdate;
+    /* decoder sei subscription, applied by parser thread like skip mode */
+    RK_U32          mDecSeiMask;
+    RK_U32          mDecSeiUpdate;
+
 private:
     void clear();
 
@@ -145,10 +164,18 @@ private:
     RK_U32          mParserFastMode;
     RK_U32          mParserNeedSplit;
     RK_U32          mParserInternalPts;     /* for MPEG2/MPEG4 */
+    RK_U32          mDecPreAlloc;           /* MppDecPreAlloc */
+
+    /* worker thread configure before init */
+    MppThreadCfg    mThreadCfg[MPP_THREAD_BUTT];
 
     /* encoder paramter before init */
     MppEncConfig    mControlCfg;
     RK_U32          mControlCfgReady;
+    RK_S32          mEncLookahead;
+    MppEncSliceCfg  mEncSliceCfg;
+
+    void    setup_thread(MppThread *thread, MppThreadId id);
 
     MPP_RET control_mpp(MpiCmd cmd, MppParam param);
     MPP_RET control_osal(MpiCmd cmd, MppParam param);
@@ -22,6 +22,7 @@
 
 #include "mpp_log.h"
 #include "mpp_mem.h"
+#include "mpp_common.h"
 #include "hal_regdrv.h"
 
 
@@ -37,6 +38,34 @@ static const RK_U32 reg_mask[33] = { 0x00000000,
                                      0x1FFFFFFF, 0x3FFFFFFF, 0x7FFFFFFF, 0xFFFFFFFF
                                    };
 
+/* one field inside a register word */
+typedef struct hal_regop_t {
+    RK_U32 syn_id;
+    RK_U32 bitpos;
+    RK_U32 mask;
+} HalRegOp_t;
+
+/* all fields of one register word */
+typedef struct hal_regword_t {
+    RK_U32 op_start;
+    RK_U32 op_count;
+    RK_U32 word_mask;
+} HalRegWord_t;
+
+typedef struct hal_regprog_t {
+    RK_U32          reg_size;
+    RK_U32          emt_size;
+    HalRegWord_t    *words;
+    HalRegOp_t      *ops;
+    RK_U32          *syn_val;   //!< staged syntax values
+    RK_U32          *syn_reg;   //!< syntax to register word index
+    RK_U32          *pending;   //!< bitmap of words need to rebuild
+    RK_U32          *dirty;     //!< bitmap of words changed since last clear
+} HalRegProg_t;
+
+#define REGDRV_BIT_SET(map, i)  ((map)[(i) >> 5] |= (1u << ((i) & 31)))
+#define REGDRV_BIT_GET(map, i)  (((map)[(i) >> 5] >> ((i) & 31)) & 1)
+
 
 /*!
 ***********************************************************************
@@ -193,4 +222,290 @@ RK_U32 *hal_get_regptr(HalRegDrvCtx_t *ctx)
     }
 
     return ctx->p_reg;
-}
\ No newline at end of file
+}
+
+/*!
+***********************************************************************
+* \brief
+*   compile syntax table into register word program
+***********************************************************************
+*/
+MPP_RET hal_regdrv_prog_init(HalRegDrvCtx_t *ctx)
+{
+    RK_U32 i = 0;
+    RK_U32 pos = 0;
+    RK_U32 map_size = 0;
+    MPP_RET ret = MPP_ERR_MALLOC;
+    HalRegProg_t *prog = NULL;
+
+    if (NULL == ctx || NULL == ctx->p_emt || NULL == ctx->p_reg) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+    if (ctx->prog)
+        hal_regdrv_prog_deinit(ctx);
+
+    map_size = (ctx->reg_size + 31) / 32;
+    prog = mpp_calloc(HalRegProg_t, 1);
+    if (NULL == prog)
+        goto __FAILED;
+
+    prog->reg_size = ctx->reg_size;
+    prog->emt_size = ctx->emt_size;
+    prog->words    = mpp_calloc(HalRegWord_t, ctx->reg_size);
+    prog->ops      = mpp_calloc(HalRegOp_t, ctx->emt_size);
+    prog->syn_val  = mpp_calloc(RK_U32, ctx->emt_size);
+    prog->syn_reg  = mpp_calloc(RK_U32, ctx->emt_size);
+    prog->pending  = mpp_calloc(RK_U32, map_size);
+    prog->dirty    = mpp_calloc(RK_U32, map_size);
+    if (NULL == prog->words || NULL == prog->ops || NULL == prog->syn_val ||
+        NULL == prog->syn_reg || NULL == prog->pending || NULL == prog->dirty)
+        goto __FAILED;
+
+    /* count fields per word then lay the ops out grouped by word */
+    for (i = 0; i < ctx->emt_size; i++) {
+        HalRegDrv_t *emt = &ctx->p_emt[i];
+
+        if (emt->reg_id >= ctx->reg_size || emt->bitlen > 32 ||
+            emt->bitpos + emt->bitlen > 32) {
+            mpp_err_f("invalid syntax %d reg %d pos %d len %d\n",
+                      i, emt->reg_id, emt->bitpos, emt->bitlen);
+            ret = MPP_ERR_VALUE;
+            goto __FAILED;
+        }
+        prog->words[emt->reg_id].op_count++;
+    }
+    for (i = 0; i < ctx->reg_size; i++) {
+        prog->words[i].op_start = pos;
+        pos += prog->words[i].op_count;
+        prog->words[i].op_count = 0;
+    }
+    for (i = 0; i < ctx->emt_size; i++) {
+        HalRegDrv_t *emt = &ctx->p_emt[i];
+        HalRegWord_t *word = &prog->words[emt->reg_id];
+        HalRegOp_t *op = &prog->ops[word->op_start + word->op_count++];
+
+        op->syn_id = i;
+        op->bitpos = emt->bitpos;
+        op->mask   = reg_mask[emt->bitlen];
+        word->word_mask |= op->mask << op->bitpos;
+        prog->syn_reg[i] = emt->reg_id;
+        prog->syn_val[i] = (ctx->p_reg[emt->reg_id] >> emt->bitpos) & op->mask;
+    }
+
+    ctx->prog = prog;
+    return MPP_OK;
+__FAILED:
+    if (prog) {
+        MPP_FREE(prog->words);
+        MPP_FREE(prog->ops);
+        MPP_FREE(prog->syn_val);
+        MPP_FREE(prog->syn_reg);
+        MPP_FREE(prog->pending);
+        MPP_FREE(prog->dirty);
+        mpp_free(prog);
+    }
+    return ret;
+}
+/*!
+***********************************************************************
+* \brief
+*   release register word program
+***********************************************************************
+*/
+MPP_RET hal_regdrv_prog_deinit(HalRegDrvCtx_t *ctx)
+{
+    HalRegProg_t *prog = NULL;
+
+    if (NULL == ctx) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+    prog = (HalRegProg_t *)ctx->prog;
+    if (prog) {
+        MPP_FREE(prog->words);
+        MPP_FREE(prog->ops);
+        MPP_FREE(prog->syn_val);
+        MPP_FREE(prog->syn_reg);
+        MPP_FREE(prog->pending);
+        MPP_FREE(prog->dirty);
+        mpp_free(prog);
+        ctx->prog = NULL;
+    }
+
+    return MPP_OK;
+}
+/*!
+***********************************************************************
+* \brief
+*   stage one syntax element, mark its word when value changes
+***********************************************************************
+*/
+MPP_RET hal_regdrv_prog_set(HalRegDrvCtx_t *ctx, RK_U32 syn_id, RK_U32 val)
+{
+    HalRegProg_t *prog = NULL;
+
+    if (NULL == ctx || NULL == ctx->prog) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+    prog = (HalRegProg_t *)ctx->prog;
+    mpp_assert(syn_id < prog->emt_size);
+    if (prog->syn_val[syn_id] != val) {
+        prog->syn_val[syn_id] = val;
+        REGDRV_BIT_SET(prog->pending, prog->syn_reg[syn_id]);
+    }
+
+    return MPP_OK;
+}
+/*!
+***********************************************************************
+* \brief
+*   stage syntax elements 0 ~ count - 1 from an array
+***********************************************************************
+*/
+MPP_RET hal_regdrv_prog_load(HalRegDrvCtx_t *ctx, RK_U32 *vals, RK_U32 count)
+{
+    RK_U32 i = 0;
+    HalRegProg_t *prog = NULL;
+
+    if (NULL == ctx || NULL == ctx->prog || NULL == vals) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+    prog = (HalRegProg_t *)ctx->prog;
+    count = MPP_MIN(count, prog->emt_size);
+    for (i = 0; i < count; i++) {
+        if (prog->syn_val[i] != vals[i]) {
+            prog->syn_val[i] = vals[i];
+            REGDRV_BIT_SET(prog->pending, prog->syn_reg[i]);
+        }
+    }
+
+    return MPP_OK;
+}
+/*!
+***********************************************************************
+* \brief
+*   rebuild pending register words with one store per word
+***********************************************************************
+*/
+MPP_RET hal_regdrv_prog_gen(HalRegDrvCtx_t *ctx)
+{
+    RK_U32 i = 0;
+    RK_U32 map_size = 0;
+    HalRegProg_t *prog = NULL;
+
+    if (NULL == ctx || NULL == ctx->prog) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+    prog = (HalRegProg_t *)ctx->prog;
+    map_size = (prog->reg_size + 31) / 32;
+    for (i = 0; i < map_size; i++) {
+        RK_U32 bits = prog->pending[i];
+        RK_U32 reg_id = i * 32;
+
+        prog->pending[i] = 0;
+        for (; bits; bits >>= 1, reg_id++) {
+            HalRegWord_t *word = NULL;
+            HalRegOp_t *op = NULL;
+            HalRegOp_t *end = NULL;
+            RK_U32 old = 0;
+            RK_U32 val = 0;
+
+            if (!(bits & 1))
+                continue;
+
+            word = &prog->words[reg_id];
+            op   = &prog->ops[word->op_start];
+            end  = op + word->op_count;
+            old  = ctx->p_reg[reg_id];
+            val  = old & ~word->word_mask;
+            for (; op < end; op++)
+                val |= (prog->syn_val[op->syn_id] & op->mask) << op->bitpos;
+
+            if (val != old) {
+                ctx->p_reg[reg_id] = val;
+                REGDRV_BIT_SET(prog->dirty, reg_id);
+            }
+        }
+    }
+
+    return MPP_OK;
+}
+/*!
+***********************************************************************
+* \brief
+*   reload staged syntax values from registers written by others
+***********************************************************************
+*/
+MPP_RET hal_regdrv_prog_sync(HalRegDrvCtx_t *ctx)
+{
+    RK_U32 i = 0;
+    HalRegProg_t *prog = NULL;
+
+    if (NULL == ctx || NULL == ctx->prog) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+    prog = (HalRegProg_t *)ctx->prog;
+    for (i = 0; i < prog->reg_size; i++) {
+        HalRegWord_t *word = &prog->words[i];
+        HalRegOp_t *op = &prog->ops[word->op_start];
+        HalRegOp_t *end = op + word->op_count;
+        RK_U32 val = ctx->p_reg[i];
+
+        for (; op < end; op++)
+            prog->syn_val[op->syn_id] = (val >> op->bitpos) & op->mask;
+    }
+    memset(prog->pending, 0, sizeof(RK_U32) * ((prog->reg_size + 31) / 32));
+
+    return MPP_OK;
+}
+/*!
+***********************************************************************
+* \brief
+*   get register words changed since last clear
+***********************************************************************
+*/
+RK_U32 hal_regdrv_get_dirty(HalRegDrvCtx_t *ctx, RK_U32 *list, RK_U32 max)
+{
+    RK_U32 i = 0;
+    RK_U32 count = 0;
+    HalRegProg_t *prog = NULL;
+
+    if (NULL == ctx || NULL == ctx->prog) {
+        mpp_err_f("found NULL input\n");
+        return 0;
+    }
+    prog = (HalRegProg_t *)ctx->prog;
+    for (i = 0; i < prog->reg_size; i++) {
+        if (REGDRV_BIT_GET(prog->dirty, i)) {
+            if (list && count < max)
+                list[count] = i;
+            count++;
+        }
+    }
+
+    return count;
+}
+/*!
+***********************************************************************
+* \brief
+*   clear dirty list after register upload
+***********************************************************************
+*/
+MPP_RET hal_regdrv_clr_dirty(HalRegDrvCtx_t *ctx)
+{
+    HalRegProg_t *prog = NULL;
+
+    if (NULL == ctx || NULL == ctx->prog) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+    prog = (HalRegProg_t *)ctx->prog;
+    memset(prog->dirty, 0, sizeof(RK_U32) * ((prog->reg_size + 31) / 32));
+
+    return MPP_OK;
+}
@@ -162,9 +162,9 @@ MPP_RET hal_task_get_count(HalTaskGroup group, HalTaskStatus status, RK_U32 *cou
         return MPP_ERR_UNKNOW;
     }
 
+    // count is updated by atomic operation so that status query needs no lock
     HalTaskGroupImpl *p = (HalTaskGroupImpl *)group;
-    AutoMutex auto_lock(p->lock);
-    *count = p->count[status];
+    *count = __atomic_load_n(&p->count[status], __ATOMIC_RELAXED);
     return MPP_OK;
 }
 
@@ -183,8 +183,8 @@ MPP_RET hal_task_hnd_set_status(HalTaskHnd hnd, HalTaskStatus status)
     AutoMutex auto_lock(group->lock);
     list_del_init(&impl->list);
     list_add_tail(&impl->list, &group->list[status]);
-    group->count[impl->status]--;
-    group->count[status]++;
+    __atomic_fetch_sub(&group->count[impl->status], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&group->count[status], 1, __ATOMIC_RELAXED);
     impl->status = status;
     return MPP_OK;
 }
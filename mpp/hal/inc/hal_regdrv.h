@@ -42,6 +42,7 @@ typedef struct hal_regctx_t {
     RK_U32          emt_size;  //!< last reg syntax
     HalRegDrv_t     *p_emt;
     void            *log;       //!< for debug
+    void            *prog;      //!< compiled syntax to register program
 } HalRegDrvCtx_t;
 
 
@@ -59,6 +60,34 @@ MPP_RET hal_get_regdrv    (HalRegDrvCtx_t *ctx, RK_U32 syn_id, RK_U32 *pval);
 RK_U32  hal_get_regsize   (HalRegDrvCtx_t *ctx);
 RK_U32 *hal_get_regptr    (HalRegDrvCtx_t *ctx);
 
+/*
+ * batched register generation
+ *
+ * hal_regdrv_prog_init compiles the p_emt table into a per register word
+ * mask/shift program. Syntax values are then staged with hal_regdrv_prog_set
+ * or hal_regdrv_prog_load and only the words whose syntax changed since the
+ * last hal_regdrv_prog_gen are rebuilt, each with a single store.
+ *
+ * Words whose final value differs from the previous generation are recorded
+ * in a dirty list which can be read by hal_regdrv_get_dirty for hardware that
+ * supports partial register upload, and cleared after the upload is done.
+ *
+ * When registers are overwritten outside of the program, for example by the
+ * hardware readback after a decode, hal_regdrv_prog_sync reloads the staged
+ * values from the register words.
+ *
+ * The context must be zero initialized before the first hal_regdrv_prog_init
+ * as a non-NULL prog is taken as a program to be released.
+ */
+MPP_RET hal_regdrv_prog_init  (HalRegDrvCtx_t *ctx);
+MPP_RET hal_regdrv_prog_deinit(HalRegDrvCtx_t *ctx);
+MPP_RET hal_regdrv_prog_set   (HalRegDrvCtx_t *ctx, RK_U32 syn_id, RK_U32 val);
+MPP_RET hal_regdrv_prog_load  (HalRegDrvCtx_t *ctx, RK_U32 *vals, RK_U32 count);
+MPP_RET hal_regdrv_prog_gen   (HalRegDrvCtx_t *ctx);
+MPP_RET hal_regdrv_prog_sync  (HalRegDrvCtx_t *ctx);
+RK_U32  hal_regdrv_get_dirty  (HalRegDrvCtx_t *ctx, RK_U32 *list, RK_U32 max);
+MPP_RET hal_regdrv_clr_dirty  (HalRegDrvCtx_t *ctx);
+
 #ifdef  __cplusplus
 }
 #endif
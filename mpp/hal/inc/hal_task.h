@@ -122,6 +122,19 @@ typedef struct HalDecTask_t {
     RK_S32          refer[MAX_DEC_REF_NUM];
 } HalDecTask;
 
+/*
+ * finished slice reported by encoder hal in slice output mode
+ *
+ * offset   - slice start in output buffer
+ * length   - slice size in bytes
+ * last     - last slice of the frame
+ */
+typedef struct HalEncSlice_t {
+    RK_U32          offset;
+    RK_U32          length;
+    RK_U32          last;
+} HalEncSlice;
+
 typedef struct HalEncTask_t {
     RK_U32          valid;
 
@@ -135,6 +148,15 @@ typedef struct HalEncTask_t {
     MppBuffer       input;
 
     RK_U32          is_intra;
+
+    // MppEncSceneType of input frame
+    RK_S32          scene;
+
+    // region of interest config of input frame, NULL for none
+    MppEncROICfg    *roi;
+
+    // slice output, hal calls it with HalEncSlice in bitstream order
+    IOInterruptCB   slice_cb;
 } HalEncTask;
 
 
@@ -112,6 +112,47 @@ void  fifo_write_bits(FifoCtx_t *pkt, RK_U64 invalue, RK_U8 lbits, const char *n
 /*!
 ***********************************************************************
 * \brief
+*    write a static field layout to fifo, bit exact to fifo_write_bits
+***********************************************************************
+*/
+//extern "C"
+void fifo_write_fields(FifoCtx_t *pkt, const FifoField_t *fields, const RK_U64 *vals, RK_U32 count)
+{
+    RK_U32 i = 0;
+    RK_U32 index  = pkt->index;
+    RK_U32 bitpos = pkt->bitpos;
+    RK_U64 bvalue = pkt->bvalue;
+    RK_U64 *pbuf  = pkt->pbuf;
+    RK_U32 log_en = LogEnable(pkt->logctx, LOG_LEVEL_INFO);
+
+    for (i = 0; i < count; i++) {
+        RK_U32 lbits = fields[i].bits;
+        RK_U64 invalue = 0;
+
+        if (!lbits)
+            continue;
+
+        invalue = vals[i] & ((1ULL << lbits) - 1);
+        if (log_en)
+            LogInfo(pkt->logctx, "%48s = %10d  (bits=%d)", fields[i].name, invalue, lbits);
+        bvalue |= invalue << bitpos;
+        if ((bitpos + lbits) >= 64) {
+            pbuf[index++] = bvalue;
+            bvalue = invalue >> (64 - bitpos);
+            ASSERT(index <= pkt->buflen);
+        }
+        bitpos = (bitpos + lbits) & 63;
+    }
+    if (count)
+        pbuf[index] = bvalue;
+
+    pkt->index  = index;
+    pkt->bitpos = bitpos;
+    pkt->bvalue = bvalue;
+}
+/*!
+***********************************************************************
+* \brief
 *    align fifo bits
 ***********************************************************************
 */
@@ -18,6 +18,12 @@ typedef struct {
     FILE            *fp_data;       //!< for fpga
 } FifoCtx_t;
 
+//!< static packet layout entry, width 1 ~ 63 bits
+typedef struct {
+    RK_U8           bits;
+    const char      *name;
+} FifoField_t;
+
 
 #ifdef  __cplusplus
 extern "C" {
@@ -27,6 +33,7 @@ void    fifo_packet_reset (FifoCtx_t *pkt);
 void    fifo_fwrite_header(FifoCtx_t *pkt, RK_S32 pkt_size);
 void    fifo_fwrite_data  (FifoCtx_t *pkt);
 void    fifo_write_bits   (FifoCtx_t *pkt, RK_U64 invalue, RK_U8 lbits, const char *name);
+void    fifo_write_fields (FifoCtx_t *pkt, const FifoField_t *fields, const RK_U64 *vals, RK_U32 count);
 void    fifo_flush_bits   (FifoCtx_t *pkt);
 void    fifo_align_bits   (FifoCtx_t *pkt, RK_U8 align_bits);
 void    fifo_write_bytes  (FifoCtx_t *pkt, void *psrc, RK_U32 size);
@@ -21,6 +21,7 @@
 
 #include "vpu.h"
 #include "mpp_mem.h"
+#include "mpp_common.h"
 #include "mpp_buffer.h"
 #include "hal_task.h"
 
@@ -53,99 +54,152 @@ const enum
 
 
 
-static void rkv_write_sps_to_fifo(H264dHalCtx_t *p_hal, FifoCtx_t *pkt)
-{
-    FunctionIn(p_hal->logctx.parr[RUN_HAL]);
-
-    fifo_write_bits(pkt,  -1,                                           4, "seq_parameter_set_id");   //!< not used in hard
-    fifo_write_bits(pkt,  -1,                                           8, "profile_idc");            //!< not used in hard
-    fifo_write_bits(pkt,  -1,                                           1, "constraint_set3_flag");   //!< not used in hard
-    fifo_write_bits(pkt,  p_hal->pp->chroma_format_idc,                 2, "chroma_format_idc");
-    fifo_write_bits(pkt, (p_hal->pp->bit_depth_luma_minus8 + 8),        3, "bit_depth_luma");
-    fifo_write_bits(pkt, (p_hal->pp->bit_depth_chroma_minus8 + 8),      3, "bit_depth_chroma");
-    fifo_write_bits(pkt,   0,                                           1, "qpprime_y_zero_transform_bypass_flag"); //!< not supported in hard
-    fifo_write_bits(pkt,  p_hal->pp->log2_max_frame_num_minus4,         4, "log2_max_frame_num_minus4");
-    fifo_write_bits(pkt,  p_hal->pp->num_ref_frames,                    5, "max_num_ref_frames");
-    fifo_write_bits(pkt,  p_hal->pp->pic_order_cnt_type,                2, "pic_order_cnt_type");
-    fifo_write_bits(pkt,  p_hal->pp->log2_max_pic_order_cnt_lsb_minus4, 4, "log2_max_pic_order_cnt_lsb_minus4");
-    fifo_write_bits(pkt,  p_hal->pp->delta_pic_order_always_zero_flag,  1, "delta_pic_order_always_zero_flag");
-    fifo_write_bits(pkt, (p_hal->pp->wFrameWidthInMbsMinus1 + 1),       9, "pic_width_in_mbs");
-    fifo_write_bits(pkt, (p_hal->pp->wFrameHeightInMbsMinus1 + 1),      9, "pic_height_in_mbs");
-    fifo_write_bits(pkt,  p_hal->pp->frame_mbs_only_flag,               1, "frame_mbs_only_flag");
-    fifo_write_bits(pkt,  p_hal->pp->MbaffFrameFlag,                    1, "mb_adaptive_frame_field_flag");
-    fifo_write_bits(pkt,  p_hal->pp->direct_8x8_inference_flag,         1, "direct_8x8_inference_flag");
-
-    fifo_write_bits(pkt,  1,                                   1, "mvc_extension_enable");
-    fifo_write_bits(pkt, (p_hal->pp->num_views_minus1 + 1),    2, "num_views");
-    fifo_write_bits(pkt,  p_hal->pp->view_id[0],              10, "view_id[2]");
-    fifo_write_bits(pkt,  p_hal->pp->view_id[1],              10, "view_id[2]");
-    fifo_write_bits(pkt,  p_hal->pp->num_anchor_refs_l0[0],    1, "num_anchor_refs_l0");
-    if (p_hal->pp->num_anchor_refs_l0[0]) {
-        fifo_write_bits(pkt, p_hal->pp->anchor_ref_l0[0][0],  10, "anchor_ref_l0");
-    } else {
-        fifo_write_bits(pkt, 0, 10, "anchor_ref_l0");
-    }
-    fifo_write_bits(pkt, p_hal->pp->num_anchor_refs_l1[0],     1, "num_anchor_refs_l1");
-    if (p_hal->pp->num_anchor_refs_l1[0]) {
-        fifo_write_bits(pkt, p_hal->pp->anchor_ref_l1[0][0],  10, "anchor_ref_l1");
-    } else {
-        fifo_write_bits(pkt, 0, 10, "anchor_ref_l1");
-    }
-    fifo_write_bits(pkt, p_hal->pp->num_non_anchor_refs_l0[0],    1, "num_non_anchor_refs_l0");
-    if (p_hal->pp->num_non_anchor_refs_l0[0]) {
-        fifo_write_bits(pkt, p_hal->pp->non_anchor_ref_l0[0][0], 10, "non_anchor_ref_l0");
-    } else {
-        fifo_write_bits(pkt, 0, 10, "non_anchor_ref_l0");
-    }
-    fifo_write_bits(pkt, p_hal->pp->num_non_anchor_refs_l1[0],    1, "num_non_anchor_refs_l1");
-    if (p_hal->pp->num_non_anchor_refs_l1[0]) {
-        fifo_write_bits(pkt, p_hal->pp->non_anchor_ref_l1[0][0], 10, "non_anchor_ref_l1");
-    } else {
-        fifo_write_bits(pkt, 0, 10, "non_anchor_ref_l1");
-    }
-    fifo_align_bits(pkt, 32);
-    FunctionOut(p_hal->logctx.parr[RUN_HAL]);
-}
-
-static void rkv_write_pps_to_fifo(H264dHalCtx_t *p_hal, FifoCtx_t *pkt)
+//!< sps/pps packet layout, one entry per hardware field
+static const FifoField_t rkv_sps_fields[] = {
+    {  4, "seq_parameter_set_id"                 },  //!< not used in hard
+    {  8, "profile_idc"                          },  //!< not used in hard
+    {  1, "constraint_set3_flag"                 },  //!< not used in hard
+    {  2, "chroma_format_idc"                    },
+    {  3, "bit_depth_luma"                       },
+    {  3, "bit_depth_chroma"                     },
+    {  1, "qpprime_y_zero_transform_bypass_flag" },  //!< not supported in hard
+    {  4, "log2_max_frame_num_minus4"            },
+    {  5, "max_num_ref_frames"                   },
+    {  2, "pic_order_cnt_type"                   },
+    {  4, "log2_max_pic_order_cnt_lsb_minus4"    },
+    {  1, "delta_pic_order_always_zero_flag"     },
+    {  9, "pic_width_in_mbs"                     },
+    {  9, "pic_height_in_mbs"                    },
+    {  1, "frame_mbs_only_flag"                  },
+    {  1, "mb_adaptive_frame_field_flag"         },
+    {  1, "direct_8x8_inference_flag"            },
+    {  1, "mvc_extension_enable"                 },
+    {  2, "num_views"                            },
+    { 10, "view_id[2]"                           },
+    { 10, "view_id[2]"                           },
+    {  1, "num_anchor_refs_l0"                   },
+    { 10, "anchor_ref_l0"                        },
+    {  1, "num_anchor_refs_l1"                   },
+    { 10, "anchor_ref_l1"                        },
+    {  1, "num_non_anchor_refs_l0"               },
+    { 10, "non_anchor_ref_l0"                    },
+    {  1, "num_non_anchor_refs_l1"               },
+    { 10, "non_anchor_ref_l1"                    },
+};
+
+static const FifoField_t rkv_pps_fields[] = {
+    {  8, "pps_pic_parameter_set_id"                    },
+    {  5, "pps_seq_parameter_set_id"                    },
+    {  1, "entropy_coding_mode_flag"                    },
+    {  1, "bottom_field_pic_order_in_frame_present_flag"},
+    {  5, "num_ref_idx_l0_default_active_minus1"        },
+    {  5, "num_ref_idx_l1_default_active_minus1"        },
+    {  1, "weighted_pred_flag"                          },
+    {  2, "weighted_bipred_idc"                         },
+    {  7, "pic_init_qp_minus26"                         },
+    {  6, "pic_init_qs_minus26"                         },
+    {  5, "chroma_qp_index_offset"                      },
+    {  1, "deblocking_filter_control_present_flag"      },
+    {  1, "constrained_intra_pred_flag"                 },
+    {  1, "redundant_pic_cnt_present_flag"              },
+    {  1, "transform_8x8_mode_flag"                     },
+    {  5, "second_chroma_qp_index_offset"               },
+    {  1, "scaleing_list_enable_flag"                   },
+    { 32, "Scaleing_list_address"                       },
+};
+
+static const FifoField_t rkv_ref_fields[] = {
+    {  1, "is_long_term" }, {  1, "is_long_term" }, {  1, "is_long_term" }, {  1, "is_long_term" },
+    {  1, "is_long_term" }, {  1, "is_long_term" }, {  1, "is_long_term" }, {  1, "is_long_term" },
+    {  1, "is_long_term" }, {  1, "is_long_term" }, {  1, "is_long_term" }, {  1, "is_long_term" },
+    {  1, "is_long_term" }, {  1, "is_long_term" }, {  1, "is_long_term" }, {  1, "is_long_term" },
+    {  1, "voidx"        }, {  1, "voidx"        }, {  1, "voidx"        }, {  1, "voidx"        },
+    {  1, "voidx"        }, {  1, "voidx"        }, {  1, "voidx"        }, {  1, "voidx"        },
+    {  1, "voidx"        }, {  1, "voidx"        }, {  1, "voidx"        }, {  1, "voidx"        },
+    {  1, "voidx"        }, {  1, "voidx"        }, {  1, "voidx"        }, {  1, "voidx"        },
+};
+
+#define RKV_SPS_FIELDS      MPP_ARRAY_ELEMS(rkv_sps_fields)
+#define RKV_PPS_FIELDS      MPP_ARRAY_ELEMS(rkv_pps_fields)
+#define RKV_REF_FIELDS      MPP_ARRAY_ELEMS(rkv_ref_fields)
+
+static void rkv_get_spspps_vals(H264dHalCtx_t *p_hal, RK_U64 *vals)
 {
+    RK_S32 i = 0;
     RK_U32 Scaleing_list_address = 0;
     RK_U32 offset = RKV_CABAC_TAB_SIZE + RKV_SPSPPS_SIZE + RKV_RPS_SIZE;
-    FunctionIn(p_hal->logctx.parr[RUN_HAL]);
-    fifo_write_bits(pkt, -1,                                                    8, "pps_pic_parameter_set_id");
-    fifo_write_bits(pkt, -1,                                                    5, "pps_seq_parameter_set_id");
-    fifo_write_bits(pkt, p_hal->pp->entropy_coding_mode_flag,                   1, "entropy_coding_mode_flag");
-    fifo_write_bits(pkt, p_hal->pp->pic_order_present_flag,                     1, "bottom_field_pic_order_in_frame_present_flag");
-    fifo_write_bits(pkt, p_hal->pp->num_ref_idx_l0_active_minus1,               5, "num_ref_idx_l0_default_active_minus1");
-    fifo_write_bits(pkt, p_hal->pp->num_ref_idx_l1_active_minus1,               5, "num_ref_idx_l1_default_active_minus1");
-    fifo_write_bits(pkt, p_hal->pp->weighted_pred_flag,                         1, "weighted_pred_flag");
-    fifo_write_bits(pkt, p_hal->pp->weighted_bipred_idc,                        2, "weighted_bipred_idc");
-    fifo_write_bits(pkt, p_hal->pp->pic_init_qp_minus26,                        7, "pic_init_qp_minus26");
-    fifo_write_bits(pkt, p_hal->pp->pic_init_qs_minus26,                        6, "pic_init_qs_minus26");
-    fifo_write_bits(pkt, p_hal->pp->chroma_qp_index_offset,                     5, "chroma_qp_index_offset");
-    fifo_write_bits(pkt, p_hal->pp->deblocking_filter_control_present_flag,     1, "deblocking_filter_control_present_flag");
-    fifo_write_bits(pkt, p_hal->pp->constrained_intra_pred_flag,                1, "constrained_intra_pred_flag");
-    fifo_write_bits(pkt, p_hal->pp->redundant_pic_cnt_present_flag,             1, "redundant_pic_cnt_present_flag");
-    fifo_write_bits(pkt, p_hal->pp->transform_8x8_mode_flag,                    1, "transform_8x8_mode_flag");
-    fifo_write_bits(pkt, p_hal->pp->second_chroma_qp_index_offset,              5, "second_chroma_qp_index_offset");
-    fifo_write_bits(pkt, p_hal->pp->scaleing_list_enable_flag,                  1, "scaleing_list_enable_flag");
+    DXVA_PicParams_H264_MVC *pp = p_hal->pp;
+    RK_U64 *sps = vals;
+    RK_U64 *pps = sps + RKV_SPS_FIELDS;
+    RK_U64 *ref = pps + RKV_PPS_FIELDS;
+
+    //!< sps
+    *sps++ = -1;
+    *sps++ = -1;
+    *sps++ = -1;
+    *sps++ = pp->chroma_format_idc;
+    *sps++ = pp->bit_depth_luma_minus8 + 8;
+    *sps++ = pp->bit_depth_chroma_minus8 + 8;
+    *sps++ = 0;
+    *sps++ = pp->log2_max_frame_num_minus4;
+    *sps++ = pp->num_ref_frames;
+    *sps++ = pp->pic_order_cnt_type;
+    *sps++ = pp->log2_max_pic_order_cnt_lsb_minus4;
+    *sps++ = pp->delta_pic_order_always_zero_flag;
+    *sps++ = pp->wFrameWidthInMbsMinus1 + 1;
+    *sps++ = pp->wFrameHeightInMbsMinus1 + 1;
+    *sps++ = pp->frame_mbs_only_flag;
+    *sps++ = pp->MbaffFrameFlag;
+    *sps++ = pp->direct_8x8_inference_flag;
+    *sps++ = 1;
+    *sps++ = pp->num_views_minus1 + 1;
+    *sps++ = pp->view_id[0];
+    *sps++ = pp->view_id[1];
+    *sps++ = pp->num_anchor_refs_l0[0];
+    *sps++ = pp->num_anchor_refs_l0[0] ? pp->anchor_ref_l0[0][0] : 0;
+    *sps++ = pp->num_anchor_refs_l1[0];
+    *sps++ = pp->num_anchor_refs_l1[0] ? pp->anchor_ref_l1[0][0] : 0;
+    *sps++ = pp->num_non_anchor_refs_l0[0];
+    *sps++ = pp->num_non_anchor_refs_l0[0] ? pp->non_anchor_ref_l0[0][0] : 0;
+    *sps++ = pp->num_non_anchor_refs_l1[0];
+    *sps++ = pp->num_non_anchor_refs_l1[0] ? pp->non_anchor_ref_l1[0][0] : 0;
+    //!< pps
+    *pps++ = -1;
+    *pps++ = -1;
+    *pps++ = pp->entropy_coding_mode_flag;
+    *pps++ = pp->pic_order_present_flag;
+    *pps++ = pp->num_ref_idx_l0_active_minus1;
+    *pps++ = pp->num_ref_idx_l1_active_minus1;
+    *pps++ = pp->weighted_pred_flag;
+    *pps++ = pp->weighted_bipred_idc;
+    *pps++ = pp->pic_init_qp_minus26;
+    *pps++ = pp->pic_init_qs_minus26;
+    *pps++ = pp->chroma_qp_index_offset;
+    *pps++ = pp->deblocking_filter_control_present_flag;
+    *pps++ = pp->constrained_intra_pred_flag;
+    *pps++ = pp->redundant_pic_cnt_present_flag;
+    *pps++ = pp->transform_8x8_mode_flag;
+    *pps++ = pp->second_chroma_qp_index_offset;
+    *pps++ = pp->scaleing_list_enable_flag;
 
     Scaleing_list_address = mpp_buffer_get_fd(p_hal->cabac_buf);
-    //mpp_log("fd=%08x, offset=%d", Scaleing_list_address, offset);
     if (VPUClientGetIOMMUStatus() > 0) {
         Scaleing_list_address |= offset << 10;
     } else {
         Scaleing_list_address += offset;
     }
 #if FPGA_TEST
-    fifo_write_bits(pkt, 0, 32, "Scaleing_list_address");
+    *pps++ = 0;
 #else
-    fifo_write_bits(pkt, Scaleing_list_address, 32, "Scaleing_list_address");
+    *pps++ = Scaleing_list_address;
 #endif
-    FunctionOut(p_hal->logctx.parr[RUN_HAL]);
+    //!< reference flags
+    for (i = 0; i < 16; i++) {
+        ref[i] = (pp->RefFrameList[i].bPicEntry != 0xff) ? pp->RefFrameList[i].AssociatedFlag : 0;
+        ref[i + 16] = (pp->RefFrameList[i].bPicEntry != 0xff) ? pp->RefPicLayerIdList[i] : 0;
+    }
 }
 
-
 /*!
 ***********************************************************************
 * \brief
@@ -156,6 +210,7 @@ static void rkv_write_pps_to_fifo(H264dHalCtx_t *p_hal, FifoCtx_t *pkt)
 void rkv_reset_fifo_packet(H264dRkvPkt_t *pkt)
 {
     if (pkt) {
+        pkt->spspps_valid = 0;
         fifo_packet_reset(&pkt->spspps);
         fifo_packet_reset(&pkt->rps);
         fifo_packet_reset(&pkt->scanlist);
@@ -173,6 +228,7 @@ void rkv_reset_fifo_packet(H264dRkvPkt_t *pkt)
 void rkv_free_fifo_packet(H264dRkvPkt_t *pkt)
 {
     if (pkt) {
+        pkt->spspps_valid = 0;
         MPP_FREE(pkt->spspps.pbuf);
         MPP_FREE(pkt->rps.pbuf);
         MPP_FREE(pkt->scanlist.pbuf);
@@ -238,26 +294,32 @@ __FAILED:
 //extern "C"
 void rkv_prepare_spspps_packet(void *hal, FifoCtx_t *pkt)
 {
-    RK_S32 i = 0;
-    RK_S32 is_long_term = 0, voidx = 0;
     H264dHalCtx_t *p_hal = (H264dHalCtx_t *)hal;
+    H264dRkvPkt_t *pkts  = (H264dRkvPkt_t *)p_hal->pkts;
+    RK_U64 vals[RKV_SPSPPS_FIELDS];
 
     FunctionIn(p_hal->logctx.parr[RUN_HAL]);
+    mpp_assert(RKV_SPSPPS_FIELDS == RKV_SPS_FIELDS + RKV_PPS_FIELDS + RKV_REF_FIELDS);
+    rkv_get_spspps_vals(p_hal, vals);
+    //!< keep last packet while sps / pps / reference flags do not change
+    if (pkts->spspps_valid && !pkt->fp_data &&
+        !memcmp(pkts->spspps_vals, vals, sizeof(vals))) {
+        pkts->spspps_update = 0;
+        goto __RETURN;
+    }
+    memcpy(pkts->spspps_vals, vals, sizeof(vals));
+    pkts->spspps_valid  = 1;
+    pkts->spspps_update = 1;
+
     fifo_packet_reset(pkt);
     LogInfo(pkt->logctx, "------------------ Frame SPS_PPS begin ------------------------");
-    rkv_write_sps_to_fifo(p_hal, pkt);
-    rkv_write_pps_to_fifo(p_hal, pkt);
-
-    for (i = 0; i < 16; i++) {
-        is_long_term = (p_hal->pp->RefFrameList[i].bPicEntry != 0xff) ? p_hal->pp->RefFrameList[i].AssociatedFlag : 0;
-        fifo_write_bits(pkt, is_long_term, 1, "is_long_term");
-    }
-    for (i = 0; i < 16; i++) {
-        voidx = (p_hal->pp->RefFrameList[i].bPicEntry != 0xff) ? p_hal->pp->RefPicLayerIdList[i] : 0;
-        fifo_write_bits(pkt, voidx, 1, "voidx");
-    }
+    fifo_write_fields(pkt, rkv_sps_fields, vals, RKV_SPS_FIELDS);
+    fifo_align_bits(pkt, 32);
+    fifo_write_fields(pkt, rkv_pps_fields, vals + RKV_SPS_FIELDS, RKV_PPS_FIELDS);
+    fifo_write_fields(pkt, rkv_ref_fields, vals + RKV_SPS_FIELDS + RKV_PPS_FIELDS, RKV_REF_FIELDS);
     fifo_align_bits(pkt, 64);
     fifo_fwrite_data(pkt);  //!< "PPSH" header 32 bit
+__RETURN:
     FunctionOut(p_hal->logctx.parr[RUN_HAL]);
 }
 /*!
@@ -31,11 +31,18 @@
 #define RKV_RPS_SIZE              (128 + 128)         /* bytes */
 #define RKV_SCALING_LIST_SIZE     (6*16+2*64 + 128)   /* bytes */
 #define RKV_ERROR_INFO_SIZE       (256*144*4)         /* bytes */
+#define RKV_SPSPPS_ENTRY_SIZE     (32)                /* bytes */
+#define RKV_SPSPPS_FIELDS         (29 + 18 + 32)      /* sps + pps + ref flags */
+
 typedef struct h264d_rkv_packet_t {
     FifoCtx_t   spspps;
     FifoCtx_t   rps;
     FifoCtx_t   scanlist;
     FifoCtx_t   reg;
+    //!< memorized sps / pps packet input
+    RK_U64      spspps_vals[RKV_SPSPPS_FIELDS];
+    RK_U32      spspps_valid;
+    RK_U32      spspps_update;
 } H264dRkvPkt_t;
 
 
@@ -339,8 +339,15 @@ MPP_RET rkv_h264d_gen_regs(void *hal, HalTaskInfo *task)
     hw_base = mpp_buffer_get_fd(p_hal->cabac_buf);
     //!< copy datas
     strm_offset = RKV_CABAC_TAB_SIZE;
-    for (i = 0; i < 256; i++)   {
-        mpp_buffer_write(p_hal->cabac_buf, (strm_offset + 32 * i), (void *)pkts->spspps.pbuf, RKV_SPSPPS_SIZE);
+    //!< replicate one sps / pps entry for all 256 pps id only when it changes
+    if (pkts->spspps_update) {
+        RK_U8 *pps_ptr = (RK_U8 *)mpp_buffer_get_ptr(p_hal->cabac_buf) + strm_offset;
+
+        for (i = 0; i < 256; i++) {
+            memcpy(pps_ptr + RKV_SPSPPS_ENTRY_SIZE * i, pkts->spspps.pbuf, RKV_SPSPPS_ENTRY_SIZE);
+        }
+        memset(pps_ptr + RKV_SPSPPS_ENTRY_SIZE * 256, 0,
+               RKV_SPSPPS_SIZE - RKV_SPSPPS_ENTRY_SIZE * 256);
     }
     p_regs->swreg42_pps_base.sw_pps_base = hw_base + (strm_offset << 10);
     strm_offset += RKV_SPSPPS_SIZE;
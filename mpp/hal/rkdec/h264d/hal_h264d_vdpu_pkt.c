@@ -197,6 +197,61 @@ const RK_U32 g_ValueList[34] = {
     17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33
 };
 
+/*
+ * reference list fields of listP / listB0 / listB1, syntax id is
+ * list * 16 + index, register id is the word index in H264dVdpuRegs_t
+ */
+static HalRegDrv_t vdpu_ref_list_emt[] = {
+    {  0, 106, 5,  0, "init_reflist_pf0" },
+    {  1, 106, 5,  5, "init_reflist_pf1" },
+    {  2, 106, 5, 10, "init_reflist_pf2" },
+    {  3, 106, 5, 15, "init_reflist_pf3" },
+    {  4,  74, 5,  0, "init_reflist_pf4" },
+    {  5,  74, 5,  5, "init_reflist_pf5" },
+    {  6,  74, 5, 10, "init_reflist_pf6" },
+    {  7,  74, 5, 15, "init_reflist_pf7" },
+    {  8,  74, 5, 20, "init_reflist_pf8" },
+    {  9,  74, 5, 25, "init_reflist_pf9" },
+    { 10,  75, 5,  0, "init_reflist_pf10" },
+    { 11,  75, 5,  5, "init_reflist_pf11" },
+    { 12,  75, 5, 10, "init_reflist_pf12" },
+    { 13,  75, 5, 15, "init_reflist_pf13" },
+    { 14,  75, 5, 20, "init_reflist_pf14" },
+    { 15,  75, 5, 25, "init_reflist_pf15" },
+    { 16, 100, 5,  0, "init_reflist_df0" },
+    { 17, 100, 5,  5, "init_reflist_df1" },
+    { 18, 100, 5, 10, "init_reflist_df2" },
+    { 19, 100, 5, 15, "init_reflist_df3" },
+    { 20, 100, 5, 20, "init_reflist_df4" },
+    { 21, 100, 5, 25, "init_reflist_df5" },
+    { 22, 101, 5,  0, "init_reflist_df6" },
+    { 23, 101, 5,  5, "init_reflist_df7" },
+    { 24, 101, 5, 10, "init_reflist_df8" },
+    { 25, 101, 5, 15, "init_reflist_df9" },
+    { 26, 101, 5, 20, "init_reflist_df10" },
+    { 27, 101, 5, 25, "init_reflist_df11" },
+    { 28, 102, 5,  0, "init_reflist_df12" },
+    { 29, 102, 5,  5, "init_reflist_df13" },
+    { 30, 102, 5, 10, "init_reflist_df14" },
+    { 31, 102, 5, 15, "init_reflist_df15" },
+    { 32, 103, 5,  0, "init_reflist_db0" },
+    { 33, 103, 5,  5, "init_reflist_db1" },
+    { 34, 103, 5, 10, "init_reflist_db2" },
+    { 35, 103, 5, 15, "init_reflist_db3" },
+    { 36, 103, 5, 20, "init_reflist_db4" },
+    { 37, 103, 5, 25, "init_reflist_db5" },
+    { 38, 104, 5,  0, "init_reflist_db6" },
+    { 39, 104, 5,  5, "init_reflist_db7" },
+    { 40, 104, 5, 10, "init_reflist_db8" },
+    { 41, 104, 5, 15, "init_reflist_db9" },
+    { 42, 104, 5, 20, "init_reflist_db10" },
+    { 43, 104, 5, 25, "init_reflist_db11" },
+    { 44, 105, 5,  0, "init_reflist_db12" },
+    { 45, 105, 5,  5, "init_reflist_db13" },
+    { 46, 105, 5, 10, "init_reflist_db14" },
+    { 47, 105, 5, 15, "init_reflist_db15" },
+};
+
 
 static RK_U32 check_dpb_buffer_is_valid(H264dHalCtx_t *p_hal, RK_U32 dpb_idx)
 {
@@ -263,178 +318,6 @@ static MPP_RET vdpu_set_refer_pic_idx(H264dVdpuRegs_t *p_regs, RK_U32 i, RK_U16
 
     return MPP_OK;
 }
-static MPP_RET vdpu_set_refer_pic_list_p(H264dVdpuRegs_t *p_regs, RK_U32 i, RK_U16 val)
-{
-    switch (i) {
-    case 0:
-        p_regs->sw106.init_reflist_pf0 = val;
-        break;
-    case 1:
-        p_regs->sw106.init_reflist_pf1 = val;
-        break;
-    case 2:
-        p_regs->sw106.init_reflist_pf2 = val;
-        break;
-    case 3:
-        p_regs->sw106.init_reflist_pf3 = val;
-        break;
-    case 4:
-        p_regs->sw74.init_reflist_pf4 = val;
-        break;
-    case 5:
-        p_regs->sw74.init_reflist_pf5 = val;
-        break;
-    case 6:
-        p_regs->sw74.init_reflist_pf6 = val;
-        break;
-    case 7:
-        p_regs->sw74.init_reflist_pf7 = val;
-        break;
-    case 8:
-        p_regs->sw74.init_reflist_pf8 = val;
-        break;
-    case 9:
-        p_regs->sw74.init_reflist_pf9 = val;
-        break;
-    case 10:
-        p_regs->sw75.init_reflist_pf10 = val;
-        break;
-    case 11:
-        p_regs->sw75.init_reflist_pf11 = val;
-        break;
-    case 12:
-        p_regs->sw75.init_reflist_pf12 = val;
-        break;
-    case 13:
-        p_regs->sw75.init_reflist_pf13 = val;
-        break;
-    case 14:
-        p_regs->sw75.init_reflist_pf14 = val;
-        break;
-    case 15:
-        p_regs->sw75.init_reflist_pf15 = val;
-        break;
-    default:
-        break;
-    }
-
-    return MPP_OK;
-}
-static MPP_RET vdpu_set_refer_pic_list_b0(H264dVdpuRegs_t *p_regs, RK_U32 i, RK_U16 val)
-{
-    switch (i) {
-    case 0:
-        p_regs->sw100.init_reflist_df0 = val;
-        break;
-    case 1:
-        p_regs->sw100.init_reflist_df1 = val;
-        break;
-    case 2:
-        p_regs->sw100.init_reflist_df2 = val;
-        break;
-    case 3:
-        p_regs->sw100.init_reflist_df3 = val;
-        break;
-    case 4:
-        p_regs->sw100.init_reflist_df4 = val;
-        break;
-    case 5:
-        p_regs->sw100.init_reflist_df5 = val;
-        break;
-    case 6:
-        p_regs->sw101.init_reflist_df6 = val;
-        break;
-    case 7:
-        p_regs->sw101.init_reflist_df7 = val;
-        break;
-    case 8:
-        p_regs->sw101.init_reflist_df8 = val;
-        break;
-    case 9:
-        p_regs->sw101.init_reflist_df9 = val;
-        break;
-    case 10:
-        p_regs->sw101.init_reflist_df10 = val;
-        break;
-    case 11:
-        p_regs->sw101.init_reflist_df11 = val;
-        break;
-    case 12:
-        p_regs->sw102.init_reflist_df12 = val;
-        break;
-    case 13:
-        p_regs->sw102.init_reflist_df13 = val;
-        break;
-    case 14:
-        p_regs->sw102.init_reflist_df14 = val;
-        break;
-    case 15:
-        p_regs->sw102.init_reflist_df15 = val;
-        break;
-    default:
-        break;
-    }
-
-    return MPP_OK;
-}
-static MPP_RET vdpu_set_refer_pic_list_b1(H264dVdpuRegs_t *p_regs, RK_U32 i, RK_U16 val)
-{
-    switch (i) {
-    case 0:
-        p_regs->sw103.init_reflist_db0 = val;
-        break;
-    case 1:
-        p_regs->sw103.init_reflist_db1 = val;
-        break;
-    case 2:
-        p_regs->sw103.init_reflist_db2 = val;
-        break;
-    case 3:
-        p_regs->sw103.init_reflist_db3 = val;
-        break;
-    case 4:
-        p_regs->sw103.init_reflist_db4 = val;
-        break;
-    case 5:
-        p_regs->sw103.init_reflist_db5 = val;
-        break;
-    case 6:
-        p_regs->sw104.init_reflist_db6 = val;
-        break;
-    case 7:
-        p_regs->sw104.init_reflist_db7 = val;
-        break;
-    case 8:
-        p_regs->sw104.init_reflist_db8 = val;
-        break;
-    case 9:
-        p_regs->sw104.init_reflist_db9 = val;
-        break;
-    case 10:
-        p_regs->sw104.init_reflist_db10 = val;
-        break;
-    case 11:
-        p_regs->sw104.init_reflist_db11 = val;
-        break;
-    case 12:
-        p_regs->sw105.init_reflist_db12 = val;
-        break;
-    case 13:
-        p_regs->sw105.init_reflist_db13 = val;
-        break;
-    case 14:
-        p_regs->sw105.init_reflist_db14 = val;
-        break;
-    case 15:
-        p_regs->sw105.init_reflist_db15 = val;
-        break;
-    default:
-        break;
-    }
-
-    return MPP_OK;
-}
-
 static MPP_RET vdpu_set_refer_pic_base_addr(H264dVdpuRegs_t *p_regs, RK_U32 i, RK_U32 val)
 {
     switch (i) {
@@ -632,10 +515,13 @@ MPP_RET vdpu_set_vlc_regs(H264dHalCtx_t *p_hal, H264dVdpuRegs_t *p_regs)
 MPP_RET vdpu_set_ref_regs(H264dHalCtx_t *p_hal, H264dVdpuRegs_t *p_regs)
 {
     RK_U32 i = 0, j = 0;
+    RK_U32 vals[3 * 16];
     MPP_RET ret = MPP_ERR_UNKNOW;
     DXVA_Slice_H264_Long *p_long = &p_hal->slice_long[0];
+    HalRegDrvCtx_t *regdrv = &((H264dVdpuPriv_t *)p_hal->priv)->ref_regdrv;
 
     FunctionIn(p_hal->logctx.parr[RUN_HAL]);
+    mpp_assert(regdrv->p_reg == (RK_U32 *)p_regs);
     //!< list0 list1 listP
     for (j = 0; j < 3; j++) {
         for (i = 0; i < 16; i++) {
@@ -655,23 +541,12 @@ MPP_RET vdpu_set_ref_regs(H264dHalCtx_t *p_hal, H264dVdpuRegs_t *p_regs)
                     val = p_long->RefPicList[j][i].Index7Bits;
                 }
             }
-            switch (j) {
-            case 0:
-                vdpu_set_refer_pic_list_p(p_regs, i, val);
-                break;
-            case 1:
-                vdpu_set_refer_pic_list_b0(p_regs, i, val);
-
-                break;
-            case 2:
-                vdpu_set_refer_pic_list_b1(p_regs, i, val);
-
-                break;
-            default:
-                break;
-            }
+            vals[j * 16 + i] = val;
         }
     }
+    //!< only the words whose list entries changed are rebuilt
+    hal_regdrv_prog_load(regdrv, vals, MPP_ARRAY_ELEMS(vals));
+    hal_regdrv_prog_gen(regdrv);
     FunctionOut(p_hal->logctx.parr[RUN_HAL]);
 
     return ret = MPP_OK;
@@ -679,6 +554,42 @@ MPP_RET vdpu_set_ref_regs(H264dHalCtx_t *p_hal, H264dVdpuRegs_t *p_regs)
 /*!
 ***********************************************************************
 * \brief
+*    init reference list register program
+***********************************************************************
+*/
+//extern "C"
+MPP_RET vdpu_init_ref_regs(H264dHalCtx_t *p_hal, H264dVdpuRegs_t *p_regs)
+{
+    HalRegDrvCtx_t *regdrv = &((H264dVdpuPriv_t *)p_hal->priv)->ref_regdrv;
+
+    regdrv->type     = MPP_CTX_DEC;
+    regdrv->coding   = MPP_VIDEO_CodingAVC;
+    regdrv->reg_size = DEC_VDPU_REGISTERS;
+    regdrv->p_reg    = (RK_U32 *)p_regs;
+    regdrv->emt_size = MPP_ARRAY_ELEMS(vdpu_ref_list_emt);
+    regdrv->p_emt    = vdpu_ref_list_emt;
+
+    return hal_regdrv_prog_init(regdrv);
+}
+/*!
+***********************************************************************
+* \brief
+*    deinit reference list register program
+***********************************************************************
+*/
+//extern "C"
+MPP_RET vdpu_deinit_ref_regs(H264dHalCtx_t *p_hal)
+{
+    H264dVdpuPriv_t *priv = (H264dVdpuPriv_t *)p_hal->priv;
+
+    if (priv)
+        hal_regdrv_prog_deinit(&priv->ref_regdrv);
+
+    return MPP_OK;
+}
+/*!
+***********************************************************************
+* \brief
 *    run Asic
 ***********************************************************************
 */
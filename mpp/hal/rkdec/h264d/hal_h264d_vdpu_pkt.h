@@ -22,6 +22,7 @@
 #include "mpp_err.h"
 #include "hal_task.h"
 #include "h264d_log.h"
+#include "hal_regdrv.h"
 #include "hal_h264d_fifo.h"
 #include "hal_h264d_global.h"
 
@@ -511,6 +512,7 @@ typedef struct h264d_vdpu_priv_t {
     H264dVdpuDpbInfo_t     new_dpb[16];
     H264dVdpuDpbInfo_t     *ilt_dpb;
     H264dVdpuRefPicInfo_t  refinfo[3][32]; //!< listP listB0 list1
+    HalRegDrvCtx_t         ref_regdrv;     //!< reference list register program
 } H264dVdpuPriv_t;
 
 
@@ -524,6 +526,8 @@ extern const RK_U32 H264_VDPU_Cabac_table[VDPU_CABAC_TAB_SIZE / 4];
 MPP_RET vdpu_set_pic_regs(H264dHalCtx_t *p_hal, H264dVdpuRegs_t  *p_regs);
 MPP_RET vdpu_set_vlc_regs(H264dHalCtx_t *p_hal, H264dVdpuRegs_t  *p_regs);
 MPP_RET vdpu_set_ref_regs(H264dHalCtx_t *p_hal, H264dVdpuRegs_t  *p_regs);
+MPP_RET vdpu_init_ref_regs(H264dHalCtx_t *p_hal, H264dVdpuRegs_t *p_regs);
+MPP_RET vdpu_deinit_ref_regs(H264dHalCtx_t *p_hal);
 MPP_RET vdpu_set_asic_regs(H264dHalCtx_t *p_hal, H264dVdpuRegs_t *p_regs);
 
 
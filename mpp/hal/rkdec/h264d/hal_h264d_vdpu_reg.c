@@ -324,6 +324,7 @@ MPP_RET vdpu_h264d_init(void *hal, MppHalCfg *cfg)
     //!< copy cabac table bytes
     FUN_CHECK(ret = mpp_buffer_write(p_hal->cabac_buf, 0, (void *)H264_VDPU_Cabac_table, sizeof(H264_VDPU_Cabac_table)));
     FUN_CHECK(ret = vdpu_set_device_regs(p_hal, (H264dVdpuRegs_t *)p_hal->regs));
+    FUN_CHECK(ret = vdpu_init_ref_regs(p_hal, (H264dVdpuRegs_t *)p_hal->regs));
     mpp_slots_set_prop(p_hal->frame_slots, SLOTS_HOR_ALIGN, vdpu_hor_align);
     mpp_slots_set_prop(p_hal->frame_slots, SLOTS_VER_ALIGN, vdpu_ver_align);
     mpp_slots_set_prop(p_hal->frame_slots, SLOTS_LEN_ALIGN, NULL);
@@ -355,6 +356,7 @@ MPP_RET vdpu_h264d_deinit(void *hal)
 
     FunctionIn(p_hal->logctx.parr[RUN_HAL]);
 
+    vdpu_deinit_ref_regs(p_hal);
     MPP_FREE(p_hal->regs);
     MPP_FREE(p_hal->priv);
     if (p_hal->cabac_buf) {
@@ -465,6 +467,8 @@ MPP_RET vdpu_h264d_wait(void *hal, HalTaskInfo *task)
         cur_deat = (p_e - p_s) / 1000;
         p_hal->total_time += cur_deat;
         p_hal->iDecodedNum++;
+        //!< registers are read back from hardware, resync staged values
+        hal_regdrv_prog_sync(&((H264dVdpuPriv_t *)p_hal->priv)->ref_regdrv);
         (void)wait_ret;
     }
 #endif
@@ -497,11 +501,17 @@ MPP_RET vdpu_h264d_reset(void *hal)
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
     H264dHalCtx_t *p_hal = (H264dHalCtx_t *)hal;
+    H264dVdpuPriv_t *priv = NULL;
+    HalRegDrvCtx_t regdrv;
 
     INP_CHECK(ret, NULL == p_hal);
     FunctionIn(p_hal->logctx.parr[RUN_HAL]);
 
-    memset(p_hal->priv, 0, sizeof(H264dVdpuPriv_t));
+    //!< keep the register program across reset
+    priv = (H264dVdpuPriv_t *)p_hal->priv;
+    regdrv = priv->ref_regdrv;
+    memset(priv, 0, sizeof(H264dVdpuPriv_t));
+    priv->ref_regdrv = regdrv;
 
     FunctionOut(p_hal->logctx.parr[RUN_HAL]);
 __RETURN:
@@ -50,12 +50,16 @@ FILE *fp = NULL;
 
 #define MAX_GEN_REG 3
 RK_U32 h265h_debug = 0;
+#define PPS_PACKET_LEN      10
+#define H265D_PPS_FIELDS    35
+
 typedef struct h265d_reg_buf {
     RK_S32    use_flag;
     MppBuffer scaling_list_data;
     MppBuffer pps_data;
     MppBuffer rps_data;
     void*     hw_regs;
+    RK_U64    pps_cache[PPS_PACKET_LEN];
 } h265d_reg_buf_t;
 typedef struct h265d_reg_context {
     RK_S32 vpu_socket;
@@ -73,6 +77,8 @@ typedef struct h265d_reg_context {
     RK_U32 fast_mode_err_found;
     void *scaling_rk;
     void *scaling_qm;
+    RK_U64 *pps_cache;          /* last packet written into pps_data */
+    RK_U64 pps_cache_buf[PPS_PACKET_LEN];
 } h265d_reg_context_t;
 
 typedef struct ScalingList {
@@ -302,6 +308,7 @@ MPP_RET hal_h265d_alloc_res(void *hal)
             }
         }
     } else {
+        reg_cxt->pps_cache = reg_cxt->pps_cache_buf;
         reg_cxt->hw_regs = mpp_calloc_size(void, sizeof(H265d_REGS_t));
         ret = mpp_buffer_get(reg_cxt->group, &reg_cxt->scaling_list_data, SCALING_LIST_SIZE);
         if (MPP_OK != ret) {
@@ -1087,18 +1094,116 @@ static void hal_h265d_output_scalinglist_packet(void *hal, void *ptr, void *dxva
 }
 
 
+/* sps / pps part of the pps packet, field widths in hardware order */
+static const RK_U8 h265d_sps_bits[] = {
+    4, 4, 2, 13, 13, 4, 4, 5, 2, 3, 3,
+    2, 3, 3, 1, 1, 1,
+    1, 4, 4, 1, 3, 3,
+    7, 1, 6, 1, 1,
+    7,
+};
+
+static const RK_U8 h265d_pps_bits[] = {
+    6, 4, 1, 1, 13, 1, 1, 4, 4, 7, 1, 1, 1, 3,
+    5, 5, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 4, 4, 1, 3, 1, 3, 5, 5, 2,
+};
+
+static void hal_h265d_get_sps_vals(DXVA_PicParams_HEVC *pp, RK_U64 *vals)
+{
+    RK_U32 log2_min_cb_size = pp->log2_min_luma_coding_block_size_minus3 + 3;
+
+    *vals++ = pp->vps_id;
+    *vals++ = pp->sps_id;
+    *vals++ = pp->chroma_format_idc;
+    *vals++ = pp->PicWidthInMinCbsY << log2_min_cb_size;
+    *vals++ = pp->PicHeightInMinCbsY << log2_min_cb_size;
+    *vals++ = pp->bit_depth_luma_minus8 + 8;
+    *vals++ = pp->bit_depth_chroma_minus8 + 8;
+    *vals++ = pp->log2_max_pic_order_cnt_lsb_minus4 + 4;
+    *vals++ = pp->log2_diff_max_min_luma_coding_block_size; //log2_maxa_coding_block_depth
+    *vals++ = pp->log2_min_luma_coding_block_size_minus3 + 3;
+    *vals++ = pp->log2_min_transform_block_size_minus2 + 2;
+    ///<-zrh comment ^  57 bit above
+    *vals++ = pp->log2_diff_max_min_transform_block_size;
+    *vals++ = pp->max_transform_hierarchy_depth_inter;
+    *vals++ = pp->max_transform_hierarchy_depth_intra;
+    *vals++ = pp->scaling_list_enabled_flag;
+    *vals++ = pp->amp_enabled_flag;
+    *vals++ = pp->sample_adaptive_offset_enabled_flag;
+    ///<-zrh comment ^  68 bit above
+    *vals++ = pp->pcm_enabled_flag;
+    *vals++ = pp->pcm_enabled_flag ? (pp->pcm_sample_bit_depth_luma_minus1 + 1) : 0;
+    *vals++ = pp->pcm_enabled_flag ? (pp->pcm_sample_bit_depth_chroma_minus1 + 1) : 0;
+    *vals++ = pp->pcm_loop_filter_disabled_flag;
+    *vals++ = pp->log2_diff_max_min_pcm_luma_coding_block_size;
+    *vals++ = pp->pcm_enabled_flag ? (pp->log2_min_pcm_luma_coding_block_size_minus3 + 3) : 0;
+
+    *vals++ = pp->num_short_term_ref_pic_sets;
+    *vals++ = pp->long_term_ref_pics_present_flag;
+    *vals++ = pp->num_long_term_ref_pics_sps;
+    *vals++ = pp->sps_temporal_mvp_enabled_flag;
+    *vals++ = pp->strong_intra_smoothing_enabled_flag;
+    ///<-zrh comment ^ 100 bit above
+    *vals++ = 0;
+}
+
+static void hal_h265d_get_pps_vals(DXVA_PicParams_HEVC *pp, RK_U64 *vals)
+{
+    RK_U32 log2_min_cb_size = pp->log2_min_luma_coding_block_size_minus3 + 3;
+
+    *vals++ = pp->pps_id;
+    *vals++ = pp->sps_id;
+    *vals++ = pp->dependent_slice_segments_enabled_flag;
+    *vals++ = pp->output_flag_present_flag;
+    *vals++ = pp->num_extra_slice_header_bits;
+    *vals++ = pp->sign_data_hiding_enabled_flag;
+    *vals++ = pp->cabac_init_present_flag;
+    *vals++ = pp->num_ref_idx_l0_default_active_minus1 + 1;
+    *vals++ = pp->num_ref_idx_l1_default_active_minus1 + 1;
+    *vals++ = pp->init_qp_minus26;
+    *vals++ = pp->constrained_intra_pred_flag;
+    *vals++ = pp->transform_skip_enabled_flag;
+    *vals++ = pp->cu_qp_delta_enabled_flag;
+    *vals++ = log2_min_cb_size + pp->log2_diff_max_min_luma_coding_block_size -
+              pp->diff_cu_qp_delta_depth;
+
+    *vals++ = pp->pps_cb_qp_offset;
+    *vals++ = pp->pps_cr_qp_offset;
+    *vals++ = pp->pps_slice_chroma_qp_offsets_present_flag;
+    *vals++ = pp->weighted_pred_flag;
+    *vals++ = pp->weighted_bipred_flag;
+    *vals++ = pp->transquant_bypass_enabled_flag;
+    *vals++ = pp->tiles_enabled_flag;
+    *vals++ = pp->entropy_coding_sync_enabled_flag;
+    *vals++ = pp->pps_loop_filter_across_slices_enabled_flag;
+    *vals++ = pp->loop_filter_across_tiles_enabled_flag;
+
+    *vals++ = pp->deblocking_filter_override_enabled_flag;
+    *vals++ = pp->pps_deblocking_filter_disabled_flag;
+    *vals++ = pp->pps_beta_offset_div2;
+    *vals++ = pp->pps_tc_offset_div2;
+    *vals++ = pp->lists_modification_present_flag;
+    *vals++ = pp->log2_parallel_merge_level_minus2 + 2;
+    *vals++ = pp->slice_segment_header_extension_present_flag;
+    *vals++ = 0;
+    *vals++ = pp->num_tile_columns_minus1 + 1;
+    *vals++ = pp->num_tile_rows_minus1 + 1;
+    *vals++ = 3; //mSps_Pps[i]->mMode
+}
+
 RK_S32 hal_h265d_output_pps_packet(void *hal, void *dxva)
 {
-    RK_S32 fifo_len = 10;
+    RK_S32 fifo_len = PPS_PACKET_LEN;
     RK_S32 i, j;
     RK_U32 addr;
-    RK_U64 *pps_packet = NULL;
+    RK_U64 pps_packet[PPS_PACKET_LEN + 1];
+    RK_U64 vals[H265D_PPS_FIELDS];
     RK_U32 log2_min_cb_size;
     RK_S32 width, height;
     h265d_reg_context_t *reg_cxt = ( h265d_reg_context_t *)hal;
     h265d_dxva2_picture_context_t *dxva_cxt = (h265d_dxva2_picture_context_t*)dxva;
     BitputCtx_t bp;
-    pps_packet = mpp_calloc(RK_U64, fifo_len + 1);
 
     if (NULL == reg_cxt || dxva_cxt == NULL) {
 
@@ -1112,101 +1217,28 @@ RK_S32 hal_h265d_output_pps_packet(void *hal, void *dxva)
         mpp_err("pps_data get ptr error");
         return MPP_ERR_NOMEM;
     }
-    memset(pps_ptr, 0, 80 * 64);
     // pps_packet = (RK_U64 *)(pps_ptr + dxva_cxt->pp.pps_id * 80);
 #endif
 
-
-    for (i = 0; i < 10; i++) pps_packet[i] = 0;
+    memset(pps_packet, 0, sizeof(pps_packet));
 
     mpp_set_bitput_ctx(&bp, pps_packet, fifo_len);
 
-    // SPS
-    mpp_put_bits(&bp, dxva_cxt->pp.vps_id                            , 4);
-    mpp_put_bits(&bp, dxva_cxt->pp.sps_id                            , 4);
-    mpp_put_bits(&bp, dxva_cxt->pp.chroma_format_idc                 , 2);
-
     log2_min_cb_size = dxva_cxt->pp.log2_min_luma_coding_block_size_minus3 + 3;
     width = (dxva_cxt->pp.PicWidthInMinCbsY << log2_min_cb_size);
     height = (dxva_cxt->pp.PicHeightInMinCbsY << log2_min_cb_size);
 
-    mpp_put_bits(&bp, width                                          , 13);
-    mpp_put_bits(&bp, height                                         , 13);
-    mpp_put_bits(&bp, dxva_cxt->pp.bit_depth_luma_minus8 + 8         , 4);
-    mpp_put_bits(&bp, dxva_cxt->pp.bit_depth_chroma_minus8 + 8       , 4);
-    mpp_put_bits(&bp, dxva_cxt->pp.log2_max_pic_order_cnt_lsb_minus4 + 4      , 5);
-    mpp_put_bits(&bp, dxva_cxt->pp.log2_diff_max_min_luma_coding_block_size   , 2); //log2_maxa_coding_block_depth
-    mpp_put_bits(&bp, dxva_cxt->pp.log2_min_luma_coding_block_size_minus3 + 3 , 3);
-    mpp_put_bits(&bp, dxva_cxt->pp.log2_min_transform_block_size_minus2 + 2   , 3);
-    ///<-zrh comment ^  57 bit above
-    mpp_put_bits(&bp, dxva_cxt->pp.log2_diff_max_min_transform_block_size     , 2);
-    mpp_put_bits(&bp, dxva_cxt->pp.max_transform_hierarchy_depth_inter        , 3);
-    mpp_put_bits(&bp, dxva_cxt->pp.max_transform_hierarchy_depth_intra        , 3);
-    mpp_put_bits(&bp, dxva_cxt->pp.scaling_list_enabled_flag                  , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.amp_enabled_flag                           , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.sample_adaptive_offset_enabled_flag        , 1);
-    ///<-zrh comment ^  68 bit above
-    mpp_put_bits(&bp, dxva_cxt->pp.pcm_enabled_flag                           , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.pcm_enabled_flag ? (dxva_cxt->pp.pcm_sample_bit_depth_luma_minus1 + 1) : 0  , 4);
-    mpp_put_bits(&bp, dxva_cxt->pp.pcm_enabled_flag ? (dxva_cxt->pp.pcm_sample_bit_depth_chroma_minus1 + 1) : 0 , 4);
-    mpp_put_bits(&bp, dxva_cxt->pp.pcm_loop_filter_disabled_flag                                               , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.log2_diff_max_min_pcm_luma_coding_block_size                                , 3);
-    mpp_put_bits(&bp, dxva_cxt->pp.pcm_enabled_flag ? (dxva_cxt->pp.log2_min_pcm_luma_coding_block_size_minus3 + 3) : 0, 3);
-
-    mpp_put_bits(&bp, dxva_cxt->pp.num_short_term_ref_pic_sets             , 7);
-    mpp_put_bits(&bp, dxva_cxt->pp.long_term_ref_pics_present_flag         , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.num_long_term_ref_pics_sps              , 6);
-    mpp_put_bits(&bp, dxva_cxt->pp.sps_temporal_mvp_enabled_flag           , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.strong_intra_smoothing_enabled_flag     , 1);
-    ///<-zrh comment ^ 100 bit above
+    h265h_dbg(H265H_DBG_PPS, "log2_min_cb_size %d %d %d \n", log2_min_cb_size,
+              dxva_cxt->pp.log2_diff_max_min_luma_coding_block_size, dxva_cxt->pp.diff_cu_qp_delta_depth );
 
-    mpp_put_bits(&bp, 0                                                    , 7 );
+    // SPS
+    hal_h265d_get_sps_vals(&dxva_cxt->pp, vals);
+    mpp_put_fields(&bp, h265d_sps_bits, vals, MPP_ARRAY_ELEMS(h265d_sps_bits));
     mpp_put_align(&bp                                                         , 32, 0xf);
 
     // PPS
-    mpp_put_bits(&bp, dxva_cxt->pp.pps_id                                    , 6 );
-    mpp_put_bits(&bp, dxva_cxt->pp.sps_id                                    , 4 );
-    mpp_put_bits(&bp, dxva_cxt->pp.dependent_slice_segments_enabled_flag     , 1 );
-    mpp_put_bits(&bp, dxva_cxt->pp.output_flag_present_flag                  , 1 );
-    mpp_put_bits(&bp, dxva_cxt->pp.num_extra_slice_header_bits               , 13);
-    mpp_put_bits(&bp, dxva_cxt->pp.sign_data_hiding_enabled_flag , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.cabac_init_present_flag                   , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.num_ref_idx_l0_default_active_minus1 + 1  , 4);
-    mpp_put_bits(&bp, dxva_cxt->pp.num_ref_idx_l1_default_active_minus1 + 1  , 4);
-    mpp_put_bits(&bp, dxva_cxt->pp.init_qp_minus26                           , 7);
-    mpp_put_bits(&bp, dxva_cxt->pp.constrained_intra_pred_flag               , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.transform_skip_enabled_flag               , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.cu_qp_delta_enabled_flag                  , 1);
-
-    mpp_put_bits(&bp, log2_min_cb_size +
-                 dxva_cxt->pp.log2_diff_max_min_luma_coding_block_size -
-                 dxva_cxt->pp.diff_cu_qp_delta_depth                             , 3);
-
-    h265h_dbg(H265H_DBG_PPS, "log2_min_cb_size %d %d %d \n", log2_min_cb_size,
-              dxva_cxt->pp.log2_diff_max_min_luma_coding_block_size, dxva_cxt->pp.diff_cu_qp_delta_depth );
-
-    mpp_put_bits(&bp, dxva_cxt->pp.pps_cb_qp_offset                            , 5);
-    mpp_put_bits(&bp, dxva_cxt->pp.pps_cr_qp_offset                            , 5);
-    mpp_put_bits(&bp, dxva_cxt->pp.pps_slice_chroma_qp_offsets_present_flag    , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.weighted_pred_flag                          , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.weighted_bipred_flag                        , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.transquant_bypass_enabled_flag              , 1 );
-    mpp_put_bits(&bp, dxva_cxt->pp.tiles_enabled_flag                          , 1 );
-    mpp_put_bits(&bp, dxva_cxt->pp.entropy_coding_sync_enabled_flag            , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.pps_loop_filter_across_slices_enabled_flag  , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.loop_filter_across_tiles_enabled_flag       , 1);
-
-    mpp_put_bits(&bp, dxva_cxt->pp.deblocking_filter_override_enabled_flag     , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.pps_deblocking_filter_disabled_flag         , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.pps_beta_offset_div2                        , 4);
-    mpp_put_bits(&bp, dxva_cxt->pp.pps_tc_offset_div2                          , 4);
-    mpp_put_bits(&bp, dxva_cxt->pp.lists_modification_present_flag             , 1);
-    mpp_put_bits(&bp, dxva_cxt->pp.log2_parallel_merge_level_minus2 + 2        , 3);
-    mpp_put_bits(&bp, dxva_cxt->pp.slice_segment_header_extension_present_flag , 1);
-    mpp_put_bits(&bp, 0                                                        , 3);
-    mpp_put_bits(&bp, dxva_cxt->pp.num_tile_columns_minus1 + 1, 5);
-    mpp_put_bits(&bp, dxva_cxt->pp.num_tile_rows_minus1 + 1 , 5 );
-    mpp_put_bits(&bp, 3, 2); //mSps_Pps[i]->mMode
+    hal_h265d_get_pps_vals(&dxva_cxt->pp, vals);
+    mpp_put_fields(&bp, h265d_pps_bits, vals, MPP_ARRAY_ELEMS(h265d_pps_bits));
     mpp_put_align(&bp, 64, 0xf);
 
     {
@@ -1305,17 +1337,18 @@ RK_S32 hal_h265d_output_pps_packet(void *hal, void *dxva)
     }
 
 #ifdef RKPLATFORM
-    for (i = 0; i < 64; i++) {
-        memcpy(pps_ptr + i * 80, pps_packet, 80);
+    /* the 64 copies in pps buffer stay valid until the packet changes */
+    if (memcmp(reg_cxt->pps_cache, pps_packet, PPS_PACKET_LEN * sizeof(RK_U64))) {
+        memcpy(reg_cxt->pps_cache, pps_packet, PPS_PACKET_LEN * sizeof(RK_U64));
+        for (i = 0; i < 64; i++) {
+            memcpy(pps_ptr + i * 80, pps_packet, 80);
+        }
     }
 #ifdef dump
     fwrite(pps_ptr, 1, 80 * 64, fp);
     fflush(fp);
 #endif
 #endif
-    if (pps_packet != NULL) {
-        mpp_free(pps_packet);
-    }
     return 0;
 }
 
@@ -1348,6 +1381,7 @@ MPP_RET hal_h265d_gen_regs(void *hal,  HalTaskInfo *syn)
                 reg_cxt->rps_data = reg_cxt->g_buf[i].rps_data;
                 reg_cxt->scaling_list_data = reg_cxt->g_buf[i].scaling_list_data;
                 reg_cxt->pps_data = reg_cxt->g_buf[i].pps_data;
+                reg_cxt->pps_cache = reg_cxt->g_buf[i].pps_cache;
                 reg_cxt->hw_regs = reg_cxt->g_buf[i].hw_regs;
                 reg_cxt->g_buf[i].use_flag = 1;
                 break;
@@ -2662,6 +2662,67 @@ static MPP_RET hal_h264e_rkv_validate_syntax(h264e_syntax *syn, h264e_hal_csp_in
     return MPP_OK;
 }
 
+/*
+ * convert roi config of input frame to hardware per macroblock config
+ * qp_map is applied first and regions over it in order. Delta qp is applied
+ * on the frame qp as hardware only takes absolute macroblock qp.
+ * return MPP_OK when any macroblock config is set
+ */
+MPP_RET hal_h264e_rkv_set_roi(h264e_hal_rkv_roi_cfg *cfg, RK_S32 mb_w, RK_S32 mb_h,
+                              RK_S32 pic_qp, MppEncROICfg *roi)
+{
+    RK_S32 mb_count = mb_w * mb_h;
+    RK_S32 used = 0;
+    RK_S32 i, x, y;
+
+    if (NULL == cfg || NULL == roi) {
+        mpp_err_f("found NULL input cfg %p roi %p\n", cfg, roi);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    memset(cfg, 0, sizeof(*cfg) * mb_count);
+
+    if (roi->qp_map) {
+        for (i = 0; i < mb_count; i++) {
+            if (roi->qp_map[i]) {
+                cfg[i].qp_y = MPP_CLIP3(1, 51, pic_qp + roi->qp_map[i]);
+                cfg[i].set_qp_y_en = 1;
+                used = 1;
+            }
+        }
+    }
+
+    for (i = 0; i < (RK_S32)roi->number; i++) {
+        MppEncROIRegion *region = &roi->regions[i];
+        RK_S32 x0 = region->x / 16;
+        RK_S32 y0 = region->y / 16;
+        RK_S32 x1 = MPP_MIN((region->x + region->w + 15) / 16, mb_w);
+        RK_S32 y1 = MPP_MIN((region->y + region->h + 15) / 16, mb_h);
+        RK_S32 set_qp = region->abs_qp_en || region->qp;
+        RK_S32 qp = (region->abs_qp_en) ? region->qp : pic_qp + region->qp;
+
+        qp = MPP_CLIP3(1, 51, qp);
+
+        for (y = y0; y < y1; y++) {
+            h264e_hal_rkv_roi_cfg *row = cfg + y * mb_w;
+
+            for (x = x0; x < x1; x++) {
+                if (region->intra)
+                    row[x].forbid_inter = 1;
+                if (set_qp) {
+                    row[x].qp_y = qp;
+                    row[x].set_qp_y_en = 1;
+                }
+            }
+        }
+
+        if (x0 < x1 && y0 < y1 && (region->intra || set_qp))
+            used = 1;
+    }
+
+    return (used) ? MPP_OK : MPP_NOK;
+}
+
 MPP_RET hal_h264e_rkv_gen_regs(void *hal, HalTaskInfo *task)
 {
     RK_S32 k = 0;
@@ -2777,6 +2838,17 @@ MPP_RET hal_h264e_rkv_gen_regs(void *hal, HalTaskInfo *task)
     regs->swreg10.slice_int      = 0; //syn->swreg10.slice_int;
     regs->swreg10.node_int       = 0; //syn->swreg10.node_int;//node_int_frame_pos
 
+    if (task->enc.roi) {
+        MppBuffer roi_buf = bufs->hw_roi_buf[mul_buf_idx];
+        h264e_hal_rkv_roi_cfg *roi_cfg = (h264e_hal_rkv_roi_cfg *)mpp_buffer_get_ptr(roi_buf);
+        RK_S32 mb_w = pic_width_align16 / 16;
+        RK_S32 mb_h = pic_height_align16 / 16;
+
+        if (roi_cfg && mpp_buffer_get_size(roi_buf) >= sizeof(*roi_cfg) * mb_w * mb_h)
+            regs->swreg10.roi_enc = (MPP_OK == hal_h264e_rkv_set_roi(roi_cfg, mb_w, mb_h,
+                                                                     syn->qp, task->enc.roi));
+    }
+
     regs->swreg11.ppln_enc_lmt     = 2; //syn->swreg11.ppln_enc_lmt;
     regs->swreg11.rfp_load_thrd    = 0; //syn->swreg11.rfp_load_thrd;
 
@@ -129,6 +129,22 @@ typedef struct h264e_hal_rkv_buffers_t {
     MppBuffer hw_rec_buf[RKV_H264E_NUM_REFS + 1]; //extra 1 frame for current recon
 } h264e_hal_rkv_buffers;
 
+/*
+ * per macroblock roi config in raster order, read from ctuc_addr when
+ * swreg10.roi_enc is set
+ * forbid_inter - force intra macroblock
+ * qp_area_idx  - qp adjust index when area_map is set
+ * qp_y         - absolute macroblock qp when set_qp_y_en is set
+ */
+typedef struct h264e_hal_rkv_roi_cfg_t {
+    RK_U16 forbid_inter : 1;
+    RK_U16 reserve      : 3;
+    RK_U16 qp_area_idx  : 3;
+    RK_U16 area_map     : 1;
+    RK_U16 qp_y         : 7;
+    RK_U16 set_qp_y_en  : 1;
+} h264e_hal_rkv_roi_cfg;
+
 typedef struct h264e_hal_rkv_nal_t {
     RK_S32 i_ref_idc;  /* nal_priority_e */
     RK_S32 i_type;     /* nal_unit_type_e */
@@ -1533,4 +1549,7 @@ MPP_RET hal_h264e_rkv_reset   (void *hal);
 MPP_RET hal_h264e_rkv_flush   (void *hal);
 MPP_RET hal_h264e_rkv_control (void *hal, RK_S32 cmd_type, void *param);
 
+MPP_RET hal_h264e_rkv_set_roi(h264e_hal_rkv_roi_cfg *cfg, RK_S32 mb_w, RK_S32 mb_h,
+                              RK_S32 pic_qp, MppEncROICfg *roi);
+
 #endif
@@ -2121,13 +2121,73 @@ hal_h264e_vepu1_set_feedback(h264e_feedback *fb, h264e_vepu1_reg_set *reg)
     return MPP_OK;
 }
 
+/* slice sizes written by hw, the table ends with a zero entry */
+static void
+hal_h264e_vepu1_set_nal_feedback(h264e_feedback *fb,
+                                 h264e_hal_vpu_buffers *bufs)
+{
+    MppBuffer buf = bufs->hw_nal_size_table_buf;
+    RK_U32 *table = NULL;
+    RK_U32 max = 0;
+    RK_U32 i = 0;
+
+    fb->nal_size_table = NULL;
+    fb->nal_size_count = 0;
+
+    if (NULL == buf)
+        return ;
+
+    table = (RK_U32 *)mpp_buffer_get_ptr(buf);
+    max = mpp_buffer_get_size(buf) / sizeof(RK_U32);
+    if (NULL == table)
+        return ;
+
+    mpp_buffer_sync_ro_begin(buf);
+    while (i < max && table[i])
+        i++;
+    mpp_buffer_sync_ro_end(buf);
+
+    fb->nal_size_table = table;
+    fb->nal_size_count = i;
+}
+
+/*
+ * report finished slices for slice output. The driver returns on frame done
+ * so all slices are reported after wait. The table is skipped when it does
+ * not match the stream size and mpp_enc outputs the frame as one piece.
+ */
+static void
+hal_h264e_vepu1_report_slices(HalEncTask *task, h264e_feedback *fb)
+{
+    IOInterruptCB *cb = &task->slice_cb;
+    HalEncSlice slice;
+    RK_U32 sum = 0;
+    RK_U32 i;
+
+    if (NULL == cb->callBack || NULL == fb->nal_size_table)
+        return ;
+
+    for (i = 0; i < fb->nal_size_count; i++)
+        sum += fb->nal_size_table[i];
+
+    if (!sum || sum != fb->out_strm_size)
+        return ;
+
+    slice.offset = 0;
+    for (i = 0; i < fb->nal_size_count; i++) {
+        slice.length = fb->nal_size_table[i];
+        slice.last = (i + 1 == fb->nal_size_count);
+        cb->callBack(cb->opaque, &slice);
+        slice.offset += slice.length;
+    }
+}
+
 MPP_RET hal_h264e_vepu1_wait(void *hal, HalTaskInfo *task)
 {
     h264e_hal_context *ctx = (h264e_hal_context *)hal;
     h264e_vepu1_reg_set *reg_out = (h264e_vepu1_reg_set *)ctx->regs;
     IOInterruptCB int_cb = ctx->int_cb;
     h264e_feedback *fb = &ctx->feedback;
-    (void)task;
     h264e_hal_debug_enter();
 
 #ifdef RKPLATFORM
@@ -2157,12 +2217,16 @@ MPP_RET hal_h264e_vepu1_wait(void *hal, HalTaskInfo *task)
 
     if (int_cb.callBack) {
         hal_h264e_vepu1_set_feedback(fb, reg_out);
+        hal_h264e_vepu1_set_nal_feedback(fb,
+                                         (h264e_hal_vpu_buffers *)ctx->buffers);
 #ifdef H264E_DUMP_DATA_TO_FILE
         hal_h264e_vpu_dump_mpp_feedback(ctx);
 #endif
         int_cb.callBack(int_cb.opaque, fb);
     }
 
+    hal_h264e_vepu1_report_slices(&task->enc, fb);
+
 #ifdef H264E_DUMP_DATA_TO_FILE
     hal_h264e_vpu_dump_mpp_reg_out(ctx);
 #endif
@@ -26,6 +26,7 @@
 #include "mpp_log.h"
 
 #include "vpu.h"
+#include "vpu_record.h"
 
 #define VPU_IOC_MAGIC                       'l'
 #define VPU_IOC_SET_CLIENT_TYPE             _IOW(VPU_IOC_MAGIC, 1, unsigned long)
@@ -60,6 +61,11 @@ int VPUClientInit(VPU_CLIENT_TYPE type)
     int ret;
     int fd;
     const char *name = NULL;
+    VPU_CLIENT_TYPE client_type = type;
+    VpuRecMode rec = vpu_rec_mode();
+
+    if (rec == VPU_REC_REPLAY)
+        return vpu_rec_init(type, -1);
 
     switch (type) {
     case VPU_DEC_RKV: {
@@ -102,6 +108,9 @@ int VPUClientInit(VPU_CLIENT_TYPE type)
         mpp_err_f("ioctl VPU_IOC_SET_CLIENT_TYPE failed ret %d errno %d\n", ret, errno);
         return -2;
     }
+    if (rec == VPU_REC_RECORD)
+        vpu_rec_init(client_type, fd);
+
     return fd;
 }
 
@@ -109,6 +118,13 @@ RK_S32 VPUClientRelease(int socket)
 {
     VPU_SERVICE_TEST;
     int fd = socket;
+    VpuRecMode rec = vpu_rec_mode();
+
+    if (rec != VPU_REC_OFF)
+        vpu_rec_release(socket);
+    if (rec == VPU_REC_REPLAY)
+        return VPU_SUCCESS;
+
     if (fd > 0) {
         close(fd);
     }
@@ -121,6 +137,7 @@ RK_S32 VPUClientSendReg(int socket, RK_U32 *regs, RK_U32 nregs)
     int fd = socket;
     RK_S32 ret;
     VPUReq_t req;
+    VpuRecMode rec = vpu_rec_mode();
 
     if (vpu_debug) {
         RK_U32 i;
@@ -130,6 +147,9 @@ RK_S32 VPUClientSendReg(int socket, RK_U32 *regs, RK_U32 nregs)
         }
     }
 
+    if (rec == VPU_REC_REPLAY)
+        return vpu_rec_send(socket, regs, nregs, VPU_SUCCESS);
+
     nregs *= sizeof(RK_U32);
     req.req     = regs;
     req.size    = nregs;
@@ -137,6 +157,9 @@ RK_S32 VPUClientSendReg(int socket, RK_U32 *regs, RK_U32 nregs)
     if (ret)
         mpp_err_f("ioctl VPU_IOC_SET_REG failed ret %d errno %d %s\n", ret, errno, strerror(errno));
 
+    if (rec == VPU_REC_RECORD)
+        vpu_rec_send(socket, regs, nregs / sizeof(RK_U32), ret);
+
     return ret;
 }
 
@@ -146,8 +169,15 @@ RK_S32 VPUClientWaitResult(int socket, RK_U32 *regs, RK_U32 nregs, VPU_CMD_TYPE
     int fd = socket;
     RK_S32 ret;
     VPUReq_t req;
+    VpuRecMode rec = vpu_rec_mode();
     (void)len;
 
+    if (rec == VPU_REC_REPLAY) {
+        ret = vpu_rec_wait(socket, regs, nregs, VPU_SUCCESS, cmd);
+        nregs *= sizeof(RK_U32);
+        goto __DEBUG;
+    }
+
     nregs *= sizeof(RK_U32);
     req.req     = regs;
     req.size    = nregs;
@@ -159,6 +189,10 @@ RK_S32 VPUClientWaitResult(int socket, RK_U32 *regs, RK_U32 nregs, VPU_CMD_TYPE
     } else
         *cmd = VPU_SEND_CONFIG_ACK_OK;
 
+    if (rec == VPU_REC_RECORD)
+        vpu_rec_wait(socket, regs, nregs / sizeof(RK_U32), ret, cmd);
+
+__DEBUG:
     if (vpu_debug) {
         RK_U32 i;
         nregs >>= 2;
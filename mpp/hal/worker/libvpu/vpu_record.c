@@ -0,0 +1,634 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "vpu_record"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_common.h"
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_mem.h"
+#include "mpp_thread.h"
+
+#include "vpu_record.h"
+
+#if _WIN32
+#include <windows.h>
+#include <sys/types.h>
+#endif
+
+#ifdef RKPLATFORM
+#include <sys/mman.h>
+#endif
+
+typedef struct VpuRecClient_t {
+    RK_S32          socket;
+    RK_U32          type;
+    RK_U32          used;
+    RK_S64          send_time;
+
+    /* replay record offsets of this client */
+    RK_U32          *records;
+    RK_U32          count;
+    RK_U32          pos;
+} VpuRecClient;
+
+typedef struct VpuRecCtx_t {
+    RK_U32          probed;
+    VpuRecMode      mode;
+    FILE            *fp;
+    RK_S64          start;
+
+    RK_U8           *data;
+    RK_U32          size;
+
+    VpuRecClient    clients[VPU_REC_MAX_CLIENT];
+    RK_U32          client_count;
+    VpuRecStat      stat;
+} VpuRecCtx;
+
+static pthread_mutex_t rec_lock = PTHREAD_MUTEX_INITIALIZER;
+static VpuRecCtx rec_ctx;
+
+static void vpu_rec_sleep(RK_S64 us)
+{
+#if _WIN32
+    Sleep((DWORD)((us + 999) / 1000));
+#else
+    usleep((useconds_t)us);
+#endif
+}
+
+RK_U32 vpu_rec_digest(const void *data, RK_U32 size)
+{
+    const RK_U8 *p = (const RK_U8 *)data;
+    RK_U32 hash = 2166136261u;
+    RK_U32 i;
+
+    // fnv-1a on words, buffers are large
+    for (i = 0; i + 4 <= size; i += 4) {
+        RK_U32 word;
+
+        memcpy(&word, p + i, 4);
+        hash = (hash ^ word) * 16777619u;
+    }
+    for (; i < size; i++)
+        hash = (hash ^ p[i]) * 16777619u;
+
+    return hash;
+}
+
+static VpuRecClient *vpu_rec_get_client(VpuRecCtx *ctx, RK_S32 socket)
+{
+    RK_U32 i;
+
+    for (i = 0; i < ctx->client_count; i++) {
+        VpuRecClient *client = &ctx->clients[i];
+
+        if (client->used && client->socket == socket)
+            return client;
+    }
+
+    mpp_err_f("socket %d is not a recorded client\n", socket);
+    return NULL;
+}
+
+#define VPU_REC_REGS_SIZE(n)    MPP_ALIGN((n) * sizeof(RK_U32), 8)
+
+static void vpu_rec_write(VpuRecCtx *ctx, VpuRecHdr *hdr, RK_U32 *regs,
+                          VpuRecBuf *bufs)
+{
+    RK_U32 pad = 0;
+
+    // keep next record 8 bytes aligned for the replay reading it in place
+    if (fwrite(hdr, sizeof(*hdr), 1, ctx->fp) != 1 ||
+        (hdr->nregs && fwrite(regs, sizeof(RK_U32), hdr->nregs, ctx->fp) != hdr->nregs) ||
+        ((hdr->nregs & 1) && fwrite(&pad, sizeof(pad), 1, ctx->fp) != 1) ||
+        (hdr->nbufs && fwrite(bufs, sizeof(VpuRecBuf), hdr->nbufs, ctx->fp) != hdr->nbufs)) {
+        mpp_err_f("failed to write record, recording stops\n");
+        fclose(ctx->fp);
+        ctx->fp = NULL;
+        ctx->mode = VPU_REC_OFF;
+    }
+}
+
+#ifdef RKPLATFORM
+/*
+ * With iommu the address registers hold the dma-buf fd in low 10 bits and the
+ * offset in the rest. Any register on an open dma-buf fd is taken as a buffer.
+ */
+static RK_U32 vpu_rec_get_bufs(RK_U32 *regs, RK_U32 nregs, VpuRecBuf *bufs)
+{
+    RK_U32 count = 0;
+    RK_U32 i, j;
+
+    for (i = 0; i < nregs && count < VPU_REC_MAX_BUF; i++) {
+        RK_U32 fd = regs[i] & 0x3ff;
+        VpuRecBuf *buf = &bufs[count];
+        char path[32];
+        char link[64];
+        ssize_t len;
+        off_t size;
+        void *ptr;
+
+        if (fd <= 2)
+            continue;
+
+        buf->reg = i;
+        buf->fd = fd;
+        buf->offset = regs[i] >> 10;
+
+        for (j = 0; j < count; j++) {
+            if (bufs[j].fd == fd)
+                break;
+        }
+        if (j < count) {
+            buf->size = bufs[j].size;
+            buf->digest = bufs[j].digest;
+            count++;
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+        len = readlink(path, link, sizeof(link) - 1);
+        if (len <= 0)
+            continue;
+        link[len] = '\0';
+        if (NULL == strstr(link, "dmabuf"))
+            continue;
+
+        size = lseek(fd, 0, SEEK_END);
+        if (size <= 0)
+            continue;
+
+        ptr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED)
+            continue;
+
+        buf->size = (RK_U32)size;
+        buf->digest = vpu_rec_digest(ptr, (RK_U32)size);
+        munmap(ptr, size);
+        count++;
+    }
+
+    return count;
+}
+#endif
+
+static MPP_RET vpu_rec_load(VpuRecCtx *ctx)
+{
+    VpuRecFile *head = (VpuRecFile *)ctx->data;
+    RK_U32 pass, i;
+
+    if (ctx->size < sizeof(*head) || head->magic != VPU_REC_MAGIC ||
+        head->version != VPU_REC_VERSION) {
+        mpp_err_f("not a version %d vpu record\n", VPU_REC_VERSION);
+        return MPP_NOK;
+    }
+
+    // count records per client then store their offsets
+    for (pass = 0; pass < 2; pass++) {
+        RK_U32 pos = sizeof(*head);
+
+        while (pos < ctx->size) {
+            VpuRecHdr *hdr = (VpuRecHdr *)(ctx->data + pos);
+            VpuRecClient *client = NULL;
+            RK_U32 len = sizeof(*hdr);
+
+            if (pos + len <= ctx->size)
+                len += VPU_REC_REGS_SIZE(hdr->nregs) + hdr->nbufs * sizeof(VpuRecBuf);
+
+            if (pos + len > ctx->size || hdr->client >= VPU_REC_MAX_CLIENT ||
+                hdr->nbufs > VPU_REC_MAX_BUF) {
+                mpp_err_f("broken record at %d\n", pos);
+                return MPP_NOK;
+            }
+
+            client = &ctx->clients[hdr->client];
+            if (hdr->type == VPU_REC_INIT) {
+                client->type = hdr->cmd;
+                if (hdr->client >= ctx->client_count)
+                    ctx->client_count = hdr->client + 1;
+            } else if (pass) {
+                client->records[client->pos++] = pos;
+            } else {
+                client->count++;
+            }
+
+            pos += len;
+        }
+
+        if (pass)
+            break;
+
+        for (i = 0; i < VPU_REC_MAX_CLIENT; i++) {
+            VpuRecClient *client = &ctx->clients[i];
+
+            if (i >= ctx->client_count && !client->count)
+                continue;
+
+            client->records = mpp_calloc(RK_U32, client->count + 1);
+            if (NULL == client->records)
+                return MPP_ERR_MALLOC;
+        }
+    }
+
+    for (i = 0; i < VPU_REC_MAX_CLIENT; i++)
+        ctx->clients[i].pos = 0;
+
+    return MPP_OK;
+}
+
+static void vpu_rec_close_l(VpuRecCtx *ctx)
+{
+    RK_U32 i;
+
+    if (ctx->mode == VPU_REC_REPLAY)
+        mpp_log("replay %d send %d wait %d mismatch %d missing\n",
+                ctx->stat.send, ctx->stat.wait, ctx->stat.mismatch,
+                ctx->stat.missing);
+
+    if (ctx->fp) {
+        fclose(ctx->fp);
+        ctx->fp = NULL;
+    }
+    for (i = 0; i < VPU_REC_MAX_CLIENT; i++)
+        MPP_FREE(ctx->clients[i].records);
+    MPP_FREE(ctx->data);
+
+    memset(ctx->clients, 0, sizeof(ctx->clients));
+    memset(&ctx->stat, 0, sizeof(ctx->stat));
+    ctx->client_count = 0;
+    ctx->size = 0;
+    ctx->mode = VPU_REC_OFF;
+}
+
+static MPP_RET vpu_rec_open_l(VpuRecCtx *ctx, const char *path, VpuRecMode mode)
+{
+    MPP_RET ret = MPP_NOK;
+    long size;
+
+    vpu_rec_close_l(ctx);
+    ctx->probed = 1;
+
+    if (mode == VPU_REC_OFF)
+        return MPP_OK;
+
+    ctx->fp = fopen(path, (mode == VPU_REC_RECORD) ? "wb" : "rb");
+    if (NULL == ctx->fp) {
+        mpp_err_f("failed to open %s\n", path);
+        return MPP_ERR_OPEN_FILE;
+    }
+
+    ctx->start = mpp_time_us();
+
+    if (mode == VPU_REC_RECORD) {
+        VpuRecFile head;
+
+        memset(&head, 0, sizeof(head));
+        head.magic = VPU_REC_MAGIC;
+        head.version = VPU_REC_VERSION;
+        if (fwrite(&head, sizeof(head), 1, ctx->fp) != 1)
+            goto __RETURN;
+
+        ctx->mode = mode;
+        mpp_log("recording vpu clients to %s\n", path);
+        return MPP_OK;
+    }
+
+    fseek(ctx->fp, 0, SEEK_END);
+    size = ftell(ctx->fp);
+    fseek(ctx->fp, 0, SEEK_SET);
+    if (size <= 0)
+        goto __RETURN;
+
+    ctx->size = (RK_U32)size;
+    ctx->data = mpp_malloc(RK_U8, ctx->size);
+    if (NULL == ctx->data || fread(ctx->data, 1, ctx->size, ctx->fp) != ctx->size)
+        goto __RETURN;
+
+    fclose(ctx->fp);
+    ctx->fp = NULL;
+
+    ret = vpu_rec_load(ctx);
+    if (ret)
+        goto __RETURN;
+
+    ctx->mode = mode;
+    mpp_log("replaying %d vpu clients from %s\n", ctx->client_count, path);
+    return MPP_OK;
+
+__RETURN:
+    mpp_err_f("failed to setup %s\n", path);
+    vpu_rec_close_l(ctx);
+    return ret;
+}
+
+VpuRecMode vpu_rec_mode(void)
+{
+    VpuRecCtx *ctx = &rec_ctx;
+    VpuRecMode mode;
+
+    pthread_mutex_lock(&rec_lock);
+    if (!ctx->probed) {
+        char *path = NULL;
+
+        mpp_env_get_str("vpu_replay", &path, NULL);
+        if (path) {
+            vpu_rec_open_l(ctx, path, VPU_REC_REPLAY);
+        } else {
+            mpp_env_get_str("vpu_record", &path, NULL);
+            if (path)
+                vpu_rec_open_l(ctx, path, VPU_REC_RECORD);
+        }
+        ctx->probed = 1;
+    }
+    mode = ctx->mode;
+    pthread_mutex_unlock(&rec_lock);
+
+    return mode;
+}
+
+MPP_RET vpu_rec_open(const char *path, VpuRecMode mode)
+{
+    MPP_RET ret;
+
+    pthread_mutex_lock(&rec_lock);
+    ret = vpu_rec_open_l(&rec_ctx, path, mode);
+    pthread_mutex_unlock(&rec_lock);
+
+    return ret;
+}
+
+void vpu_rec_close(void)
+{
+    pthread_mutex_lock(&rec_lock);
+    vpu_rec_close_l(&rec_ctx);
+    pthread_mutex_unlock(&rec_lock);
+}
+
+void vpu_rec_get_stat(VpuRecStat *stat)
+{
+    pthread_mutex_lock(&rec_lock);
+    *stat = rec_ctx.stat;
+    pthread_mutex_unlock(&rec_lock);
+}
+
+RK_S32 vpu_rec_init(VPU_CLIENT_TYPE type, RK_S32 fd)
+{
+    VpuRecCtx *ctx = &rec_ctx;
+    VpuRecClient *client = NULL;
+    RK_S32 socket = fd;
+    RK_U32 i;
+
+    pthread_mutex_lock(&rec_lock);
+
+    if (ctx->mode == VPU_REC_RECORD && fd >= 0) {
+        if (ctx->client_count < VPU_REC_MAX_CLIENT) {
+            VpuRecHdr hdr;
+
+            client = &ctx->clients[ctx->client_count];
+            client->socket = fd;
+            client->type = type;
+            client->used = 1;
+
+            memset(&hdr, 0, sizeof(hdr));
+            hdr.type = VPU_REC_INIT;
+            hdr.client = ctx->client_count;
+            hdr.cmd = type;
+            hdr.time = mpp_time_us() - ctx->start;
+            vpu_rec_write(ctx, &hdr, NULL, NULL);
+            ctx->client_count++;
+        } else {
+            mpp_err_f("too many clients, client %d is not recorded\n", fd);
+        }
+    } else if (ctx->mode == VPU_REC_REPLAY) {
+        socket = -1;
+        for (i = 0; i < ctx->client_count; i++) {
+            client = &ctx->clients[i];
+            if (!client->used && client->type == (RK_U32)type && client->records) {
+                client->used = 1;
+                client->socket = VPU_REC_SOCKET_BASE + i;
+                socket = client->socket;
+                break;
+            }
+        }
+        if (socket < 0) {
+            mpp_err_f("no recorded client of type %d left\n", type);
+            ctx->stat.missing++;
+        }
+    }
+
+    pthread_mutex_unlock(&rec_lock);
+
+    return socket;
+}
+
+void vpu_rec_release(RK_S32 socket)
+{
+    VpuRecCtx *ctx = &rec_ctx;
+    VpuRecClient *client = NULL;
+
+    pthread_mutex_lock(&rec_lock);
+
+    if (ctx->mode == VPU_REC_OFF)
+        goto __RETURN;
+
+    client = vpu_rec_get_client(ctx, socket);
+    if (NULL == client)
+        goto __RETURN;
+
+    if (ctx->mode == VPU_REC_RECORD) {
+        VpuRecHdr hdr;
+
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.type = VPU_REC_RELEASE;
+        hdr.client = (RK_U32)(client - ctx->clients);
+        hdr.time = mpp_time_us() - ctx->start;
+        vpu_rec_write(ctx, &hdr, NULL, NULL);
+    }
+
+    // socket may be reused by next client, replay client is not reused
+    client->socket = -1;
+
+__RETURN:
+    pthread_mutex_unlock(&rec_lock);
+}
+
+/* next replay record of the client which must be of the type */
+static VpuRecHdr *vpu_rec_next(VpuRecCtx *ctx, VpuRecClient *client, VpuRecType type)
+{
+    VpuRecHdr *hdr = NULL;
+
+    if (client->pos < client->count) {
+        hdr = (VpuRecHdr *)(ctx->data + client->records[client->pos]);
+        if (hdr->type == (RK_U32)type) {
+            client->pos++;
+            return hdr;
+        }
+    }
+
+    if (client->pos < client->count)
+        mpp_err_f("client %d record %d is not a %s\n", (RK_S32)(client - ctx->clients),
+                  client->pos, (type == VPU_REC_SEND) ? "send" : "wait");
+    else
+        mpp_err_f("client %d has no record left\n", (RK_S32)(client - ctx->clients));
+    ctx->stat.missing++;
+    return NULL;
+}
+
+RK_S32 vpu_rec_send(RK_S32 socket, RK_U32 *regs, RK_U32 nregs, RK_S32 ret)
+{
+    VpuRecCtx *ctx = &rec_ctx;
+    VpuRecClient *client = NULL;
+    VpuRecHdr *hdr = NULL;
+    RK_U32 i;
+
+    pthread_mutex_lock(&rec_lock);
+
+    if (ctx->mode == VPU_REC_OFF)
+        goto __RETURN;
+
+    client = vpu_rec_get_client(ctx, socket);
+    if (NULL == client) {
+        if (ctx->mode == VPU_REC_REPLAY)
+            ret = VPU_FAILURE;
+        goto __RETURN;
+    }
+
+    client->send_time = mpp_time_us();
+    ctx->stat.send++;
+
+    if (ctx->mode == VPU_REC_RECORD) {
+        VpuRecBuf bufs[VPU_REC_MAX_BUF];
+        VpuRecHdr rec;
+
+        memset(&rec, 0, sizeof(rec));
+        rec.type = VPU_REC_SEND;
+        rec.client = (RK_U32)(client - ctx->clients);
+        rec.nregs = nregs;
+        rec.ret = ret;
+        rec.time = client->send_time - ctx->start;
+#ifdef RKPLATFORM
+        rec.nbufs = vpu_rec_get_bufs(regs, nregs, bufs);
+#endif
+        vpu_rec_write(ctx, &rec, regs, bufs);
+        goto __RETURN;
+    }
+
+    hdr = vpu_rec_next(ctx, client, VPU_REC_SEND);
+    if (NULL == hdr) {
+        ret = VPU_FAILURE;
+        goto __RETURN;
+    }
+
+    ret = hdr->ret;
+
+    // buffer addresses of this session are not the recorded ones
+    if (hdr->nregs != nregs) {
+        ctx->stat.mismatch++;
+    } else {
+        RK_U32 *rec_regs = (RK_U32 *)(hdr + 1);
+        VpuRecBuf *bufs = (VpuRecBuf *)((RK_U8 *)rec_regs + VPU_REC_REGS_SIZE(nregs));
+
+        for (i = 0; i < nregs; i++) {
+            RK_U32 j;
+
+            if (regs[i] == rec_regs[i])
+                continue;
+
+            for (j = 0; j < hdr->nbufs; j++) {
+                if (bufs[j].reg == i)
+                    break;
+            }
+            if (j < hdr->nbufs)
+                continue;
+
+            mpp_log_f("client %d record %d reg %d %08x recorded %08x\n",
+                      (RK_S32)(client - ctx->clients), client->pos - 1,
+                      i, regs[i], rec_regs[i]);
+            ctx->stat.mismatch++;
+            break;
+        }
+    }
+
+__RETURN:
+    pthread_mutex_unlock(&rec_lock);
+    return ret;
+}
+
+RK_S32 vpu_rec_wait(RK_S32 socket, RK_U32 *regs, RK_U32 nregs, RK_S32 ret,
+                    VPU_CMD_TYPE *cmd)
+{
+    VpuRecCtx *ctx = &rec_ctx;
+    VpuRecClient *client = NULL;
+    VpuRecHdr *hdr = NULL;
+    RK_S64 wait = 0;
+
+    pthread_mutex_lock(&rec_lock);
+
+    if (ctx->mode == VPU_REC_OFF)
+        goto __RETURN;
+
+    client = vpu_rec_get_client(ctx, socket);
+    if (NULL == client) {
+        if (ctx->mode == VPU_REC_REPLAY) {
+            *cmd = VPU_SEND_CONFIG_ACK_FAIL;
+            ret = VPU_FAILURE;
+        }
+        goto __RETURN;
+    }
+
+    ctx->stat.wait++;
+
+    if (ctx->mode == VPU_REC_RECORD) {
+        VpuRecHdr rec;
+
+        memset(&rec, 0, sizeof(rec));
+        rec.type = VPU_REC_WAIT;
+        rec.client = (RK_U32)(client - ctx->clients);
+        rec.nregs = nregs;
+        rec.ret = ret;
+        rec.cmd = *cmd;
+        rec.time = mpp_time_us() - client->send_time;
+        vpu_rec_write(ctx, &rec, regs, NULL);
+        goto __RETURN;
+    }
+
+    hdr = vpu_rec_next(ctx, client, VPU_REC_WAIT);
+    if (NULL == hdr) {
+        *cmd = VPU_SEND_CONFIG_ACK_FAIL;
+        ret = VPU_FAILURE;
+        goto __RETURN;
+    }
+
+    memcpy(regs, hdr + 1, MPP_MIN(nregs, hdr->nregs) * sizeof(RK_U32));
+    *cmd = (VPU_CMD_TYPE)hdr->cmd;
+    ret = hdr->ret;
+    wait = client->send_time + hdr->time - mpp_time_us();
+
+__RETURN:
+    pthread_mutex_unlock(&rec_lock);
+
+    // hardware time of the recording, other clients go on meanwhile
+    if (wait > 0)
+        vpu_rec_sleep(wait);
+
+    return ret;
+}
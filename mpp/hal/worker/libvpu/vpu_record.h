@@ -0,0 +1,123 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __VPU_RECORD_H__
+#define __VPU_RECORD_H__
+
+#include "mpp_err.h"
+#include "vpu.h"
+
+/*
+ * vpu client record and replay
+ *
+ * Record mode (env vpu_record=<file>) writes every client init, register set
+ * sent, register set read back on completion with its status and release to
+ * the file. A register set sent also carries the digests of the dma-buf
+ * buffers its registers refer to.
+ *
+ * Replay mode (env vpu_replay=<file>) opens no device. A client gets the next
+ * recorded client of the same type. Its register sets are compared with the
+ * recording and its waits return the recorded registers and status after the
+ * recorded hardware time, so the hal threads run against the recorded
+ * completions on a host without the hardware.
+ *
+ * File layout is a VpuRecFile head followed by records. Each record is a
+ * VpuRecHdr followed by nregs register values padded to 8 bytes and nbufs
+ * VpuRecBuf.
+ */
+#define VPU_REC_MAGIC           0x63657276  /* "vrec" */
+#define VPU_REC_VERSION         1
+#define VPU_REC_MAX_CLIENT      16
+#define VPU_REC_MAX_BUF         32
+/* replay socket is not a file descriptor */
+#define VPU_REC_SOCKET_BASE     0x10000
+
+typedef enum VpuRecMode_e {
+    VPU_REC_OFF,
+    VPU_REC_RECORD,
+    VPU_REC_REPLAY,
+} VpuRecMode;
+
+typedef enum VpuRecType_e {
+    VPU_REC_INIT,
+    VPU_REC_SEND,
+    VPU_REC_WAIT,
+    VPU_REC_RELEASE,
+} VpuRecType;
+
+typedef struct VpuRecFile_t {
+    RK_U32  magic;
+    RK_U32  version;
+    RK_U32  reserved[2];
+} VpuRecFile;
+
+typedef struct VpuRecHdr_t {
+    RK_U32  type;
+    RK_U32  client;
+    RK_U32  nregs;
+    RK_U32  nbufs;
+    RK_S32  ret;
+    /* client type on init, VPU_CMD_TYPE on wait */
+    RK_U32  cmd;
+    /* us from send to wait done on wait, from record start on others */
+    RK_S64  time;
+} VpuRecHdr;
+
+typedef struct VpuRecBuf_t {
+    RK_U32  reg;
+    RK_U32  fd;
+    RK_U32  offset;
+    RK_U32  size;
+    RK_U32  digest;
+    RK_U32  reserved;
+} VpuRecBuf;
+
+typedef struct VpuRecStat_t {
+    RK_U32  send;
+    RK_U32  wait;
+    /* replay register sets which differ from the recording */
+    RK_U32  mismatch;
+    /* replay calls beyond the recording or in another order */
+    RK_U32  missing;
+} VpuRecStat;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* mode from env on first call unless opened before */
+VpuRecMode vpu_rec_mode(void);
+MPP_RET vpu_rec_open(const char *path, VpuRecMode mode);
+void vpu_rec_close(void);
+void vpu_rec_get_stat(VpuRecStat *stat);
+
+/*
+ * On record these log the call done on the device and return its result.
+ * On replay these stand for the device call and return the recorded result.
+ */
+RK_S32 vpu_rec_init(VPU_CLIENT_TYPE type, RK_S32 fd);
+void vpu_rec_release(RK_S32 socket);
+RK_S32 vpu_rec_send(RK_S32 socket, RK_U32 *regs, RK_U32 nregs, RK_S32 ret);
+RK_S32 vpu_rec_wait(RK_S32 socket, RK_U32 *regs, RK_U32 nregs, RK_S32 ret,
+                    VPU_CMD_TYPE *cmd);
+
+RK_U32 vpu_rec_digest(const void *data, RK_U32 size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__VPU_RECORD_H__*/
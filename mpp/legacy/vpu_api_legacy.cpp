@@ -65,6 +65,10 @@ VpuApiLegacy::VpuApiLegacy() :
     outbufMem(NULL),
     outData(NULL),
     enc_in_fmt(ENC_INPUT_YUV420_PLANAR),
+    enc_in_mode(VPU_API_ENC_INPUT_COPY),
+    enc_out_mode(VPU_API_ENC_OUTPUT_COPY),
+    borrowMem(NULL),
+    borrowPacket(NULL),
     mEosSet(0)
 {
     mpp_env_get_u32("vpu_api_debug", &vpu_api_debug, 0);
@@ -96,6 +100,7 @@ VpuApiLegacy::~VpuApiLegacy()
         mpp_free(outData);
         outData = NULL;
     }
+    releaseBorrowed();
     if (memGroup) {
         mpp_buffer_group_put(memGroup);
         memGroup = NULL;
@@ -451,6 +456,65 @@ RK_S32 VpuApiLegacy:: decode_getoutframe(DecoderOut_t *aDecOut)
     return ret;
 }
 
+void VpuApiLegacy::releaseBorrowed()
+{
+    if (borrowMem) {
+        mpp_buffer_put(borrowMem);
+        borrowMem = NULL;
+    }
+    if (borrowPacket)
+        mpp_packet_deinit(&borrowPacket);
+}
+
+/*
+ * get input frame buffer according to the input mode
+ * fd import is cached by allocator so the same fd is not imported again
+ */
+MPP_RET VpuApiLegacy::getEncoderInput(EncInputStream_t *aEncInStrm,
+                                      VPU_API_ENC_INPUT_MODE mode, MppBuffer *buffer)
+{
+    MPP_RET ret = MPP_OK;
+
+    *buffer = NULL;
+
+    switch (mode) {
+    case VPU_API_ENC_INPUT_FD : {
+        MppBufferInfo info;
+
+        memset(&info, 0, sizeof(info));
+        info.type = MPP_BUFFER_TYPE_ION;
+        info.size = aEncInStrm->size;
+        info.fd   = aEncInStrm->bufPhyAddr;
+        ret = mpp_buffer_import(buffer, &info);
+    } break;
+    case VPU_API_ENC_INPUT_MPP_BUFFER : {
+        if (NULL == aEncInStrm->buf) {
+            ret = MPP_ERR_NULL_PTR;
+            break;
+        }
+        ret = mpp_buffer_inc_ref((MppBuffer)aEncInStrm->buf);
+        if (MPP_OK == ret)
+            *buffer = (MppBuffer)aEncInStrm->buf;
+    } break;
+    default : {
+        ret = mpp_buffer_get(memGroup, buffer, aEncInStrm->size);
+        if (MPP_OK == ret)
+            ret = mpp_buffer_write(*buffer, 0, aEncInStrm->buf, aEncInStrm->size);
+    } break;
+    }
+
+    if (ret) {
+        mpp_err_f("failed to get input buffer mode %d size %d ret %d\n",
+                  mode, aEncInStrm->size, ret);
+        if (*buffer) {
+            mpp_buffer_put(*buffer);
+            *buffer = NULL;
+        }
+    }
+
+    return ret;
+}
+
 RK_S32 VpuApiLegacy::encode(VpuCodecContext *ctx, EncInputStream_t *aEncInStrm, EncoderOut_t *aEncOut)
 {
     MPP_RET ret = MPP_OK;
@@ -460,12 +524,13 @@ RK_S32 VpuApiLegacy::encode(VpuCodecContext *ctx, EncInputStream_t *aEncInStrm,
     if (!init_ok)
         return VPU_API_ERR_VPU_CODEC_INIT;
 
+    /* stream lent to caller on last call is returned now */
+    releaseBorrowed();
+
     /* try import input buffer and output buffer */
-    MppBufferInfo   inputCommit;
     MppBufferInfo   outputCommit;
     RK_U32          use_fd_flag = 0;
 
-    memset(&inputCommit, 0, sizeof(inputCommit));
     memset(&outputCommit, 0, sizeof(outputCommit));
 
     RK_U32 width        = ctx->width;
@@ -491,31 +556,25 @@ RK_S32 VpuApiLegacy::encode(VpuCodecContext *ctx, EncInputStream_t *aEncInStrm,
 
     if (!use_fd_flag) {
         RK_U32 outputBufferSize = hor_stride * ver_stride;
-        ret = mpp_buffer_get(memGroup, &pictureMem, aEncInStrm->size);
+        ret = getEncoderInput(aEncInStrm, enc_in_mode, &pictureMem);
         if (ret != MPP_OK) {
-            mpp_err( "Failed to allocate pictureMem buffer!\n");
-            pictureMem = NULL;
-            return ret;
+            mpp_err( "Failed to get pictureMem buffer!\n");
+            goto ENCODE_FAIL;
         }
-        memcpy((RK_U8*) mpp_buffer_get_ptr(pictureMem), aEncInStrm->buf, aEncInStrm->size);
         ret = mpp_buffer_get(memGroup, &outbufMem, outputBufferSize);
         if (ret != MPP_OK) {
             mpp_err( "Failed to allocate output buffer!\n");
             outbufMem = NULL;
-            return 1;
+            goto ENCODE_FAIL;
         }
     } else {
-        inputCommit.type = MPP_BUFFER_TYPE_ION;
-        inputCommit.size = aEncInStrm->size;
-        inputCommit.fd = aEncInStrm->bufPhyAddr;
-
         outputCommit.type = MPP_BUFFER_TYPE_ION;
         RK_S32 *tmp = (RK_S32*)(&aEncOut->timeUs);
         memcpy(&outputCommit.fd, tmp, sizeof(RK_S32));
         memcpy(&outputCommit.size, (tmp + 1), sizeof(RK_S32));
         outputCommit.ptr = (void*)aEncOut->data;
 
-        ret = mpp_buffer_import(&pictureMem, &inputCommit);
+        ret = getEncoderInput(aEncInStrm, VPU_API_ENC_INPUT_FD, &pictureMem);
         if (MPP_OK != ret) {
             mpp_err("mpp_buffer_test mpp_buffer_commit failed\n");
         }
@@ -531,18 +590,19 @@ RK_S32 VpuApiLegacy::encode(VpuCodecContext *ctx, EncInputStream_t *aEncInStrm,
     mpp_frame_set_buffer(frame, pictureMem);
     mpp_packet_init_with_buffer(&packet, outbufMem);
 
-    do {
-        ret = mpi->dequeue(mpp_ctx, MPP_PORT_INPUT, &task);
-        if (ret) {
-            mpp_err("mpp task input dequeue failed\n");
-            goto ENCODE_FAIL;
-        }
-        if (task == NULL) {
-            mpp_dbg_f(MPP_DBG_NORMAL, "mpi dequeue from MPP_PORT_INPUT fail, task equal with NULL!");
-            usleep(3000);
-        } else
-            break;
-    } while (1);
+    /* wait for task instead of polling with sleep */
+    ret = mpi->poll(mpp_ctx, MPP_PORT_INPUT, MPP_POLL_BLOCK);
+    if (ret) {
+        mpp_err("mpp input poll failed\n");
+        goto ENCODE_FAIL;
+    }
+
+    ret = mpi->dequeue(mpp_ctx, MPP_PORT_INPUT, &task);
+    if (ret || NULL == task) {
+        mpp_err("mpp task input dequeue failed\n");
+        ret = MPP_NOK;
+        goto ENCODE_FAIL;
+    }
 
     mpp_task_meta_set_frame (task, MPP_META_KEY_INPUT_FRM,  frame);
     mpp_task_meta_set_packet(task, MPP_META_KEY_OUTPUT_PKT, packet);
@@ -556,6 +616,12 @@ RK_S32 VpuApiLegacy::encode(VpuCodecContext *ctx, EncInputStream_t *aEncInStrm,
         task = NULL;
 
         do {
+            ret = mpi->poll(mpp_ctx, MPP_PORT_OUTPUT, MPP_POLL_BLOCK);
+            if (ret) {
+                mpp_err("mpp output poll failed\n");
+                goto ENCODE_FAIL;
+            }
+
             ret = mpi->dequeue(mpp_ctx, MPP_PORT_OUTPUT, &task);
             if (ret) {
                 mpp_err("ret %d mpp task output dequeue failed\n", ret);
@@ -580,6 +646,7 @@ RK_S32 VpuApiLegacy::encode(VpuCodecContext *ctx, EncInputStream_t *aEncInStrm,
                 task = NULL;
 
                 // dequeue task from MPP_PORT_INPUT
+                mpi->poll(mpp_ctx, MPP_PORT_INPUT, MPP_POLL_BLOCK);
                 ret = mpi->dequeue(mpp_ctx, MPP_PORT_INPUT, &task);
                 if (ret) {
                     mpp_log_f("failed to dequeue from input port ret %d\n", ret);
@@ -598,7 +665,6 @@ RK_S32 VpuApiLegacy::encode(VpuCodecContext *ctx, EncInputStream_t *aEncInStrm,
 
                 break;
             }
-            usleep(3000);
         } while (1);
     } else {
         mpp_err("mpi pointer is NULL, failed!");
@@ -613,17 +679,29 @@ RK_S32 VpuApiLegacy::encode(VpuCodecContext *ctx, EncInputStream_t *aEncInStrm,
         aEncOut->timeUs = pts;
         aEncOut->keyFrame = (flag & MPP_PACKET_FLAG_INTRA) ? (1) : (0);
         if (!use_fd_flag) {
-            mpp_assert(aEncOut->data != NULL);
-            memcpy(aEncOut->data, (RK_U8*) mpp_buffer_get_ptr(outbufMem), aEncOut->size);
+            if (enc_out_mode == VPU_API_ENC_OUTPUT_BORROW) {
+                /* lend the stream buffer to caller until next call */
+                aEncOut->data = (RK_U8*) mpp_buffer_get_ptr(outbufMem);
+                borrowMem = outbufMem;
+                outbufMem = NULL;
+            } else {
+                mpp_assert(aEncOut->data != NULL);
+                mpp_buffer_read(outbufMem, 0, aEncOut->data, aEncOut->size);
+            }
+        }
+        if (outbufMem) {
+            mpp_buffer_put(outbufMem);
+            outbufMem = NULL;
         }
-        mpp_buffer_put(outbufMem);
         mpp_packet_deinit(&packet);
     } else {
         mpp_log("outputPacket is NULL!");
     }
 
-    if (pictureMem)
+    if (pictureMem) {
         mpp_buffer_put(pictureMem);
+        pictureMem = NULL;
+    }
     if (frame) {
         mpp_frame_deinit(&frame);
         frame = NULL;
@@ -640,6 +718,15 @@ ENCODE_FAIL:
     if (packet != NULL)
         mpp_packet_deinit(&packet);
 
+    if (pictureMem) {
+        mpp_buffer_put(pictureMem);
+        pictureMem = NULL;
+    }
+    if (outbufMem) {
+        mpp_buffer_put(outbufMem);
+        outbufMem = NULL;
+    }
+
     return ret;
 }
 
@@ -659,15 +746,10 @@ RK_S32 VpuApiLegacy::encoder_sendframe(VpuCodecContext *ctx, EncInputStream_t *a
     /* try import input buffer and output buffer */
     MppFrame frame = NULL;
     MppBuffer buffer = NULL;
-    MppBufferInfo info;
-    memset(&info, 0, sizeof(info));
-
-    info.type = MPP_BUFFER_TYPE_ION;
-    info.size = aEncInStrm->size;
-    info.fd   = aEncInStrm->bufPhyAddr;
 
     vpu_api_dbg_input("input fd %d size %d flag %d pts %lld\n",
-                      info.fd, info.size, aEncInStrm->timeUs, aEncInStrm->nFlags);
+                      aEncInStrm->bufPhyAddr, aEncInStrm->size,
+                      aEncInStrm->timeUs, aEncInStrm->nFlags);
 
     ret = mpp_frame_init(&frame);
     if (MPP_OK != ret) {
@@ -682,7 +764,11 @@ RK_S32 VpuApiLegacy::encoder_sendframe(VpuCodecContext *ctx, EncInputStream_t *a
     mpp_frame_set_pts(frame, pts);
 
     if (aEncInStrm->size) {
-        ret = mpp_buffer_import(&buffer, &info);
+        /* async path always takes fd input unless MppBuffer is given */
+        ret = getEncoderInput(aEncInStrm,
+                              (enc_in_mode == VPU_API_ENC_INPUT_MPP_BUFFER) ?
+                              (VPU_API_ENC_INPUT_MPP_BUFFER) : (VPU_API_ENC_INPUT_FD),
+                              &buffer);
         if (MPP_OK != ret) {
             mpp_err_f("mpp_buffer_commit fd %d size %d failed\n",
                       aEncInStrm->bufPhyAddr, aEncInStrm->size);
@@ -748,6 +834,9 @@ RK_S32 VpuApiLegacy::encoder_getstream(VpuCodecContext *ctx, EncoderOut_t *aEncO
     vpu_api_dbg_func("enter\n");
     (void) ctx;
 
+    /* stream lent to caller on last call is returned now */
+    releaseBorrowed();
+
     ret = mpi->encode_get_packet(mpp_ctx, &packet);
     if (ret) {
         mpp_err_f("encode_get_packet failed ret %d\n", ret);
@@ -764,16 +853,22 @@ RK_S32 VpuApiLegacy::encoder_getstream(VpuCodecContext *ctx, EncoderOut_t *aEncO
         mpp_assert(length);
         // remove first 00 00 00 01
         length -= 4;
-        aEncOut->data = outData;
         aEncOut->size = (RK_S32)length;
         aEncOut->timeUs = pts;
         aEncOut->keyFrame = (flag & MPP_PACKET_FLAG_INTRA) ? (1) : (0);
-        memcpy(outData, src + 4, length);
         vpu_api_dbg_output("get packet %p size %d pts %lld keyframe %d eos %d\n",
                            packet, length, pts, aEncOut->keyFrame, eos);
 
         mEosSet = eos;
-        mpp_packet_deinit(&packet);
+        if (enc_out_mode == VPU_API_ENC_OUTPUT_BORROW) {
+            /* keep the packet until next call */
+            aEncOut->data = src + 4;
+            borrowPacket = packet;
+        } else {
+            aEncOut->data = outData;
+            memcpy(outData, src + 4, length);
+            mpp_packet_deinit(&packet);
+        }
     } else {
         aEncOut->size = 0;
         vpu_api_dbg_output("encode_get_packet get NULL packet\n");
@@ -925,6 +1020,24 @@ RK_S32 VpuApiLegacy::control(VpuCodecContext *ctx, VPU_API_CMD cmd, void *param)
         enc_in_fmt = *((EncInputPictureType *)param);
         return 0;
     } break;
+    case VPU_API_ENC_SET_INPUT_MODE : {
+        VPU_API_ENC_INPUT_MODE mode = *((VPU_API_ENC_INPUT_MODE *)param);
+        if (mode >= VPU_API_ENC_INPUT_BUTT) {
+            mpp_err_f("invalid encoder input mode %d\n", mode);
+            return MPP_ERR_VALUE;
+        }
+        enc_in_mode = mode;
+        return 0;
+    } break;
+    case VPU_API_ENC_SET_OUTPUT_MODE : {
+        VPU_API_ENC_OUTPUT_MODE mode = *((VPU_API_ENC_OUTPUT_MODE *)param);
+        if (mode >= VPU_API_ENC_OUTPUT_BUTT) {
+            mpp_err_f("invalid encoder output mode %d\n", mode);
+            return MPP_ERR_VALUE;
+        }
+        enc_out_mode = mode;
+        return 0;
+    } break;
     case VPU_API_SET_VPUMEM_CONTEXT: {
         mpicmd = MPP_DEC_SET_EXT_BUF_GROUP;
         break;
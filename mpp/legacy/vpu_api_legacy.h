@@ -66,6 +66,9 @@ public:
 
 private:
     RK_S32 getDecoderFormat(VpuCodecContext *ctx, DecoderFormat_t *decoder_format);
+    MPP_RET getEncoderInput(EncInputStream_t *aEncInStrm, VPU_API_ENC_INPUT_MODE mode,
+                            MppBuffer *buffer);
+    void    releaseBorrowed();
 
 private:
     MppCtx mpp_ctx;
@@ -82,6 +85,11 @@ private:
     MppBuffer           outbufMem;
     RK_U8*              outData;
     EncInputPictureType enc_in_fmt;
+    VPU_API_ENC_INPUT_MODE  enc_in_mode;
+    VPU_API_ENC_OUTPUT_MODE enc_out_mode;
+    /* stream buffer / packet lent to caller in VPU_API_ENC_OUTPUT_BORROW mode */
+    MppBuffer           borrowMem;
+    MppPacket           borrowPacket;
 
     RK_U32 mEosSet;
 };
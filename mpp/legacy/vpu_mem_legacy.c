@@ -280,23 +280,29 @@ RK_S32 VPUMemLink(VPUMemLinear_t *p)
     return 0;
 }
 
+/*
+ * cache maintenance maps to mpp_buffer sync which is no-op on uncached buffer
+ * flush      - cpu read / write is done, hand over the buffer to hardware
+ * clean      - cpu write is done, write back cpu cache
+ * invalidate - hardware write is done, drop stale cpu cache before cpu read
+ */
 RK_S32 VPUMemFlush(VPUMemLinear_t *p)
 {
-    (void)p;
-    return 0;
+    MppBuffer buffer = (MppBuffer)p->offset;
+    return mpp_buffer_sync_end(buffer);
 }
 
 RK_S32 VPUMemClean(VPUMemLinear_t *p)
 {
-    (void)p;
-    return 0;
+    MppBuffer buffer = (MppBuffer)p->offset;
+    return mpp_buffer_sync_end(buffer);
 }
 
 
 RK_S32 VPUMemInvalidate(VPUMemLinear_t *p)
 {
-    (void)p;
-    return 0;
+    MppBuffer buffer = (MppBuffer)p->offset;
+    return mpp_buffer_sync_ro_begin(buffer);
 }
 
 RK_S32 VPUMemGetFD(VPUMemLinear_t *p)
@@ -234,6 +234,30 @@ static MPP_RET mpi_isp_get_frame(MppCtx ctx, MppFrame *frame)
     return ret;
 }
 
+static MPP_RET mpi_poll(MppCtx ctx, MppPortType type, MppPollType timeout)
+{
+    MPP_RET ret = MPP_NOK;
+    MpiImpl *p = (MpiImpl *)ctx;
+
+    mpi_dbg_func("enter ctx %p type %d timeout %d\n", ctx, type, timeout);
+    do {
+        ret = check_mpp_ctx(p);
+        if (ret)
+            break;;
+
+        if (type >= MPP_PORT_BUTT) {
+            mpp_err_f("invalid input type %d\n", type);
+            ret = MPP_ERR_UNKNOW;
+            break;
+        }
+
+        ret = p->ctx->poll(type, timeout);
+    } while (0);
+
+    mpi_dbg_func("leave ret %d\n", ret);
+    return ret;
+}
+
 static MPP_RET mpi_dequeue(MppCtx ctx, MppPortType type, MppTask *task)
 {
     MPP_RET ret = MPP_NOK;
@@ -318,6 +342,30 @@ static MPP_RET mpi_control(MppCtx ctx, MpiCmd cmd, MppParam param)
     return ret;
 }
 
+static MPP_RET mpi_stats(MppCtx ctx, MppStats *stats)
+{
+    MPP_RET ret = MPP_NOK;
+    MpiImpl *p = (MpiImpl *)ctx;
+
+    mpi_dbg_func("enter ctx %p stats %p\n", ctx, stats);
+    do {
+        ret = check_mpp_ctx(p);
+        if (ret)
+            break;;
+
+        if (NULL == stats) {
+            mpp_err_f("found NULL input stats\n");
+            ret = MPP_ERR_NULL_PTR;
+            break;
+        }
+
+        ret = p->ctx->get_stats(stats);
+    } while (0);
+
+    mpi_dbg_func("leave ret %d\n", ret);
+    return ret;
+}
+
 static MppApi mpp_api = {
     sizeof(mpp_api),
     0,
@@ -334,6 +382,8 @@ static MppApi mpp_api = {
     mpi_enqueue,
     mpi_reset,
     mpi_control,
+    mpi_stats,
+    mpi_poll,
     {0},
 };
 
@@ -16,6 +16,8 @@
 
 #define  MODULE_TAG "mpp"
 
+#include <string.h>
+
 #include "mpp_log.h"
 #include "mpp_mem.h"
 #include "mpp_env.h"
@@ -43,6 +45,11 @@ Mpp::Mpp()
       mFrameGetCount(0),
       mTaskPutCount(0),
       mTaskGetCount(0),
+      mStreamBytes(0),
+      mInfoChangeCount(0),
+      mErrorCount(0),
+      mDiscardCount(0),
+      mStallCurrent(0),
       mPacketGroup(NULL),
       mFrameGroup(NULL),
       mExternalFrameGroup(0),
@@ -52,6 +59,7 @@ Mpp::Mpp()
       mOutputTaskQueue(NULL),
       mThreadCodec(NULL),
       mThreadHal(NULL),
+      mThreadAlloc(NULL),
       mDec(NULL),
       mEnc(NULL),
       mType(MPP_CTX_BUTT),
@@ -65,8 +73,17 @@ Mpp::Mpp()
       mStatus(0),
       mParserFastMode(0),
       mParserNeedSplit(0),
-      mParserInternalPts(0)
+      mParserInternalPts(0),
+      mDecPreAlloc(0),
+      mEncLookahead(0)
 {
+    memset(&mDecSkip, 0, sizeof(mDecSkip));
+    memset(&mEncSliceCfg, 0, sizeof(mEncSliceCfg));
+    mDecSkipUpdate = 0;
+    mDecSeiMask = 0;
+    mDecSeiUpdate = 0;
+    memset(mThreadCfg, 0, sizeof(mThreadCfg));
+    memset(mStallCount, 0, sizeof(mStallCount));
 }
 
 MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
@@ -84,11 +101,17 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         mFrames     = new mpp_list((node_destructor)mpp_frame_deinit);
         mTasks      = new mpp_list((node_destructor)NULL);
 
+        if (!mDecPreAlloc)
+            mpp_env_get_u32("mpp_dec_prealloc", &mDecPreAlloc, MPP_DEC_PREALLOC_DISABLE);
+        if (mDecPreAlloc >= MPP_DEC_PREALLOC_BUTT)
+            mDecPreAlloc = MPP_DEC_PREALLOC_DISABLE;
+
         MppDecCfg cfg = {
             coding,
             mParserFastMode,
             mParserNeedSplit,
             mParserInternalPts,
+            mDecPreAlloc,
             this,
         };
         mpp_dec_init(&mDec, &cfg);
@@ -96,6 +119,18 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         mThreadCodec = new MppThread(mpp_dec_parser_thread, this, "mpp_dec_parser");
         mThreadHal  = new MppThread(mpp_dec_hal_thread, this, "mpp_dec_hal");
 
+        if (mDecPreAlloc) {
+            /* pre-allocation needs the internal group before the first frame */
+            mpp_buffer_group_get_internal(&mFrameGroup, MPP_BUFFER_TYPE_ION);
+            mpp_buffer_group_set_best_fit((MppBufferGroupImpl *)mFrameGroup,
+                                          mDecPreAlloc == MPP_DEC_PREALLOC_KEEP);
+            mThreadAlloc = new MppThread(mpp_dec_alloc_thread, this, "mpp_dec_alloc");
+        }
+
+        setup_thread(mThreadCodec, MPP_THREAD_CODEC);
+        setup_thread(mThreadHal, MPP_THREAD_HAL);
+        setup_thread(mThreadAlloc, MPP_THREAD_ALLOC);
+
         mpp_buffer_group_get_internal(&mPacketGroup, MPP_BUFFER_TYPE_ION);
         mpp_buffer_group_limit_config(mPacketGroup, 0, 3);
 
@@ -110,16 +145,30 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         mTasks      = new mpp_list((node_destructor)NULL);
 
         mpp_enc_init(&mEnc, coding);
+        if (mEnc && mEncLookahead) {
+            mpp_enc_control(mEnc, MPP_ENC_SET_RC_LOOKAHEAD, &mEncLookahead);
+            mpp_enc_control(mEnc, MPP_SET_THREAD_CFG, &mThreadCfg[MPP_THREAD_LOOKAHEAD]);
+        }
+        if (mEnc)
+            mpp_enc_control(mEnc, MPP_ENC_SET_SLICE_CFG, &mEncSliceCfg);
+
         mThreadCodec = new MppThread(mpp_enc_control_thread, this, "mpp_enc_ctrl");
         //mThreadHal  = new MppThread(mpp_enc_hal_thread, this, "mpp_enc_hal");
 
+        setup_thread(mThreadCodec, MPP_THREAD_CODEC);
+
         mpp_buffer_group_get_internal(&mPacketGroup, MPP_BUFFER_TYPE_ION);
         mpp_buffer_group_get_internal(&mFrameGroup, MPP_BUFFER_TYPE_ION);
 
         mpp_task_queue_init(&mInputTaskQueue);
         mpp_task_queue_init(&mOutputTaskQueue);
-        mpp_task_queue_setup(mInputTaskQueue, 1);
-        mpp_task_queue_setup(mOutputTaskQueue, 1);
+        /*
+         * lookahead holds input task until enough frames are queued
+         * slice output takes one output task for each slice packet
+         */
+        mpp_task_queue_setup(mInputTaskQueue, 1 + mEncLookahead);
+        mpp_task_queue_setup(mOutputTaskQueue, 1 + mEncLookahead +
+                             (mEncSliceCfg.split_out ? MPP_ENC_SLICE_TASK_COUNT : 0));
     } break;
     default : {
         mpp_err("Mpp error type %d\n", mType);
@@ -135,6 +184,8 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         mPacketGroup) {
         mThreadCodec->start();
         mThreadHal->start();
+        if (mThreadAlloc)
+            mThreadAlloc->start();
         mInitDone = 1;
     } else if (mFrames && mPackets &&
                (mEnc) &&
@@ -163,11 +214,18 @@ void Mpp::clear()
     if (mFrameGroup)
         mpp_buffer_group_set_listener((MppBufferGroupImpl *)mFrameGroup, NULL);
 
+    if (mThreadAlloc)
+        mThreadAlloc->stop();
     if (mThreadCodec)
         mThreadCodec->stop();
     if (mThreadHal)
         mThreadHal->stop();
 
+    if (mThreadAlloc) {
+        delete mThreadAlloc;
+        mThreadAlloc = NULL;
+    }
+
     if (mThreadCodec) {
         delete mThreadCodec;
         mThreadCodec = NULL;
@@ -393,6 +451,22 @@ MPP_RET Mpp::get_packet(MppPacket *packet)
     return ret;
 }
 
+/*
+ * NOTE: port lock is not taken on poll. Otherwise a blocking poll on one port
+ * will stall dequeue / enqueue on the other port from another thread.
+ */
+MPP_RET Mpp::poll(MppPortType type, MppPollType timeout)
+{
+    if (!mInitDone)
+        return MPP_NOK;
+
+    MppPort port = (type == MPP_PORT_INPUT) ? (mInputPort) : (mOutputPort);
+    if (NULL == port)
+        return MPP_NOK;
+
+    return mpp_port_poll(port, timeout);
+}
+
 MPP_RET Mpp::dequeue(MppPortType type, MppTask *task)
 {
     if (!mInitDone)
@@ -474,7 +548,7 @@ MPP_RET Mpp::control(MpiCmd cmd, MppParam param)
             ret = control_dec(cmd, param);
         } break;
         case CMD_CTX_ID_ENC : {
-            mpp_assert(mType == MPP_CTX_ENC);
+            mpp_assert(mType == MPP_CTX_ENC || mType == MPP_CTX_BUTT);
             mpp_assert(cmd > MPP_ENC_CMD_BASE);
             mpp_assert(cmd < MPP_ENC_CMD_END);
 
@@ -502,6 +576,69 @@ MPP_RET Mpp::control(MpiCmd cmd, MppParam param)
     return ret;
 }
 
+MPP_RET Mpp::get_stats(MppStats *stats)
+{
+    RK_U32 i;
+
+    if (!mInitDone)
+        return MPP_NOK;
+
+    memset(stats, 0, sizeof(*stats));
+
+    stats->packet_put   = __atomic_load_n(&mPacketPutCount, __ATOMIC_RELAXED);
+    stats->packet_get   = __atomic_load_n(&mPacketGetCount, __ATOMIC_RELAXED);
+    stats->frame_put    = __atomic_load_n(&mFramePutCount, __ATOMIC_RELAXED);
+    stats->frame_get    = __atomic_load_n(&mFrameGetCount, __ATOMIC_RELAXED);
+    stats->stream_bytes = __atomic_load_n(&mStreamBytes, __ATOMIC_RELAXED);
+    stats->task_put     = __atomic_load_n(&mTaskPutCount, __ATOMIC_RELAXED);
+    stats->task_get     = __atomic_load_n(&mTaskGetCount, __ATOMIC_RELAXED);
+
+    stats->packet_depth      = mPackets->list_size();
+    stats->packet_depth_peak = mPackets->list_peak();
+    stats->frame_depth       = mFrames->list_size();
+    stats->frame_depth_peak  = mFrames->list_peak();
+
+    if (mFrameGroup) {
+        size_t size = 0;
+
+        mpp_buffer_group_get_usage((MppBufferGroupImpl *)mFrameGroup,
+                                   &stats->buffer_count, &stats->buffer_used, &size);
+        stats->buffer_size = size;
+    }
+
+    stats->info_change_count = __atomic_load_n(&mInfoChangeCount, __ATOMIC_RELAXED);
+    stats->error_count       = __atomic_load_n(&mErrorCount, __ATOMIC_RELAXED);
+    stats->discard_count     = __atomic_load_n(&mDiscardCount, __ATOMIC_RELAXED);
+
+    if (mDec) {
+        MppBufSlotStats slot;
+        RK_U32 count = 0;
+
+        hal_task_get_count(mDec->tasks, TASK_IDLE, &count);
+        stats->task_idle = count;
+        hal_task_get_count(mDec->tasks, TASK_PROCESSING, &count);
+        stats->task_processing = count;
+        hal_task_get_count(mDec->tasks, TASK_PROC_DONE, &count);
+        stats->task_done = count;
+
+        mpp_buf_slot_get_stats(mDec->frame_slots, &slot);
+        stats->slot_count       = slot.count;
+        stats->slot_on_used     = slot.on_used;
+        stats->slot_not_ready   = slot.not_ready;
+        stats->slot_codec_use   = slot.codec_use;
+        stats->slot_hal_output  = slot.hal_output;
+        stats->slot_hal_input   = slot.hal_use;
+        stats->slot_queue_use   = slot.queue_use;
+        stats->slot_has_buffer  = slot.has_buffer;
+
+        stats->stall_current = __atomic_load_n(&mStallCurrent, __ATOMIC_RELAXED);
+        for (i = 0; i < MPP_STALL_BUTT; i++)
+            stats->stall_count[i] = __atomic_load_n(&mStallCount[i], __ATOMIC_RELAXED);
+    }
+
+    return MPP_OK;
+}
+
 MPP_RET Mpp::reset()
 {
     if (!mInitDone)
@@ -554,6 +691,25 @@ MPP_RET Mpp::reset()
 }
 
 
+void Mpp::setup_thread(MppThread *thread, MppThreadId id)
+{
+    MppThreadCfg *cfg = &mThreadCfg[id];
+    MppThreadPolicy policy;
+
+    if (NULL == thread)
+        return;
+
+    /* MppThreadSched has the same value as THREAD_SCHED_XXX */
+    policy.cpu_mask = cfg->cpu_mask;
+    policy.sched    = cfg->sched;
+    policy.priority = cfg->priority;
+
+    if (cfg->name[0])
+        thread->set_name(cfg->name);
+
+    thread->set_policy(&policy);
+}
+
 MPP_RET Mpp::control_mpp(MpiCmd cmd, MppParam param)
 {
     MPP_RET ret = MPP_OK;
@@ -567,6 +723,30 @@ MPP_RET Mpp::control_mpp(MpiCmd cmd, MppParam param)
         RK_U32 block = *((RK_U32 *)param);
         mOutputBlock = block;
     } break;
+    case MPP_SET_THREAD_CFG: {
+        MppThreadCfg *cfg = (MppThreadCfg *)param;
+        RK_U32 i;
+
+        if (NULL == cfg || cfg->id > MPP_THREAD_BUTT || cfg->sched >= MPP_THREAD_SCHED_BUTT) {
+            mpp_err("invalid thread config %p\n", cfg);
+            ret = MPP_ERR_VALUE;
+            break;
+        }
+        if (mInitDone) {
+            mpp_err("thread config should be set before init\n");
+            ret = MPP_NOK;
+            break;
+        }
+
+        for (i = 0; i < MPP_THREAD_BUTT; i++) {
+            if (cfg->id != MPP_THREAD_BUTT && cfg->id != i)
+                continue;
+
+            mThreadCfg[i] = *cfg;
+            mThreadCfg[i].id = i;
+            mThreadCfg[i].name[sizeof(cfg->name) - 1] = '\0';
+        }
+    } break;
     default : {
         ret = MPP_NOK;
     } break;
@@ -604,6 +784,11 @@ MPP_RET Mpp::control_dec(MpiCmd cmd, MppParam param)
         ret = mpp_dec_control(mDec, cmd, param);
     } break;
     case MPP_DEC_SET_EXT_BUF_GROUP: {
+        // internal group created for pre-allocation is replaced
+        if (mThreadAlloc && mFrameGroup && !mExternalFrameGroup) {
+            mThreadAlloc->stop();
+            mpp_buffer_group_put(mFrameGroup);
+        }
         mFrameGroup = (MppBufferGroup)param;
 	if (param) {
 	    mExternalFrameGroup = 1;
@@ -636,6 +821,57 @@ MPP_RET Mpp::control_dec(MpiCmd cmd, MppParam param)
         mParserFastMode = flag;
         ret = MPP_OK;
     } break;
+    case MPP_DEC_SET_FRAME_PREALLOC: {
+        if (mInitDone) {
+            mpp_err("frame pre-allocation mode need to be set before init\n");
+            break;
+        }
+        mDecPreAlloc = *((RK_U32 *)param);
+        ret = MPP_OK;
+    } break;
+    case MPP_DEC_SET_SKIP_MODE: {
+        MppDecSkipCfg *cfg = (MppDecSkipCfg *)param;
+        if (NULL == cfg || cfg->mode >= MPP_DEC_SKIP_BUTT) {
+            mpp_err("invalid decoder skip mode config %p\n", cfg);
+            ret = MPP_ERR_VALUE;
+            break;
+        }
+        if (mInitDone && mCoding != MPP_VIDEO_CodingAVC && mCoding != MPP_VIDEO_CodingHEVC &&
+            mCoding != MPP_VIDEO_CodingVP9 && mCoding != MPP_VIDEO_CodingMPEG2) {
+            mpp_err("coding %x does not support skip mode control\n", mCoding);
+            break;
+        }
+        if (mThreadCodec)
+            mThreadCodec->lock();
+        mDecSkip = *cfg;
+        mDecSkipUpdate = 1;
+        if (mThreadCodec) {
+            mThreadCodec->signal();
+            mThreadCodec->unlock();
+        }
+        ret = MPP_OK;
+    } break;
+    case MPP_DEC_SET_SEI_MASK: {
+        RK_U32 mask = (param) ? (*((RK_U32 *)param)) : (0);
+        if (NULL == param || (mask & ~MPP_DEC_SEI_ALL)) {
+            mpp_err("invalid decoder sei mask %p\n", param);
+            ret = MPP_ERR_VALUE;
+            break;
+        }
+        if (mInitDone && mCoding != MPP_VIDEO_CodingAVC && mCoding != MPP_VIDEO_CodingHEVC) {
+            mpp_err("coding %x does not support sei export\n", mCoding);
+            break;
+        }
+        if (mThreadCodec)
+            mThreadCodec->lock();
+        mDecSeiMask = mask;
+        mDecSeiUpdate = 1;
+        if (mThreadCodec) {
+            mThreadCodec->signal();
+            mThreadCodec->unlock();
+        }
+        ret = MPP_OK;
+    } break;
     case MPP_DEC_GET_STREAM_COUNT: {
         AutoMutex autoLock(mPackets->mutex());
         *((RK_S32 *)param) = mPackets->list_size();
@@ -660,10 +896,35 @@ MPP_RET Mpp::control_enc(MpiCmd cmd, MppParam param)
     switch (cmd) {
     case MPP_ENC_SET_CFG :
     case MPP_ENC_GET_CFG :
-    case MPP_ENC_GET_EXTRA_INFO : {
+    case MPP_ENC_GET_EXTRA_INFO :
+    case MPP_ENC_SET_SCENE_CFG :
+    case MPP_ENC_GET_SCENE_CFG :
+    case MPP_ENC_GET_SCENE_INFO :
+    case MPP_ENC_SET_NAL_CFG :
+    case MPP_ENC_GET_NAL_CFG : {
         mpp_assert(mEnc);
         ret = mpp_enc_control(mEnc, cmd, param);
     } break;
+    case MPP_ENC_SET_RC_LOOKAHEAD : {
+        if (mInitDone) {
+            mpp_err("lookahead depth need to be set before init\n");
+            break;
+        }
+        mEncLookahead = MPP_MIN(MPP_MAX(*((RK_S32 *)param), 0), MPP_ENC_LOOKAHEAD_MAX);
+        ret = MPP_OK;
+    } break;
+    case MPP_ENC_SET_SLICE_CFG : {
+        if (mInitDone) {
+            mpp_err("slice config need to be set before init\n");
+            break;
+        }
+        mEncSliceCfg = *((MppEncSliceCfg *)param);
+        ret = MPP_OK;
+    } break;
+    case MPP_ENC_GET_SLICE_CFG : {
+        *((MppEncSliceCfg *)param) = mEncSliceCfg;
+        ret = MPP_OK;
+    } break;
     default : {
     } break;
     }
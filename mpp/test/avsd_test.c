@@ -364,7 +364,7 @@ static MPP_RET decoder_single_test(AvsdTestCtx_t *pctx)
                     mpp_buf_slot_set_prop(pApi->packet_slots, task->dec.input, SLOT_BUFFER, pctx->m_dec_pkt_buf);
             }
             buf = (MppBufferImpl *)pctx->m_dec_pkt_buf;
-            memcpy(buf->info.ptr, mpp_packet_get_data(task->dec.input_packet), mpp_packet_get_length(task->dec.input_packet));
+            memcpy(mpp_buffer_get_ptr(buf), mpp_packet_get_data(task->dec.input_packet), mpp_packet_get_length(task->dec.input_packet));
 
             mpp_buf_slot_set_flag(pApi->packet_slots, task->dec.input, SLOT_CODEC_READY);
             mpp_buf_slot_set_flag(pApi->packet_slots, task->dec.input, SLOT_HAL_INPUT);
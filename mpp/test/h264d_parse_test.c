@@ -0,0 +1,415 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "h264d_parse_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_packet_impl.h"
+#include "mpp_buf_slot.h"
+#include "mpp_parser.h"
+#include "hal_task.h"
+
+/*
+ * h264 parser only benchmark on multi-slice stream
+ *
+ * The stream is generated here in avcC format as demuxers feed it, so every
+ * slice header goes through the parser. Only sps / pps / slice headers are
+ * valid, the slice data is filler as the parser never reads beyond it.
+ * The gop is IDR followed by P B B mini-gops with four reference frames and
+ * a small max_frame_num to cover frame_num wrapping. No hardware is touched,
+ * slots are released right after parse as hal would do.
+ */
+#define PARSE_WIDTH_MBS         80
+#define PARSE_HEIGHT_MBS        45
+#define PARSE_MINI_GOP_COUNT    10
+#define PARSE_GOP_SIZE          (PARSE_MINI_GOP_COUNT * 3 + 1)
+#define PARSE_FRAME_COUNT       (PARSE_GOP_SIZE * 100)
+#define PARSE_MAX_SLICES        68
+#define PARSE_SLICE_DATA_SIZE   32
+#define PARSE_STRM_SIZE         (PARSE_MAX_SLICES * (PARSE_SLICE_DATA_SIZE + 64) + 256)
+
+#define NAL_SLICE               1
+#define NAL_IDR                 5
+#define NAL_SPS                 7
+#define NAL_PPS                 8
+
+typedef struct BitWriter_t {
+    RK_U8   buf[256];
+    RK_S32  bits;
+} BitWriter;
+
+typedef struct ParseStrm_t {
+    RK_U8   buf[PARSE_STRM_SIZE];
+    RK_S32  len;
+} ParseStrm;
+
+static void put_bits(BitWriter *bw, RK_U32 val, RK_S32 n)
+{
+    while (n--) {
+        if (!(bw->bits & 7))
+            bw->buf[bw->bits >> 3] = 0;
+        if ((val >> n) & 1)
+            bw->buf[bw->bits >> 3] |= 0x80 >> (bw->bits & 7);
+        bw->bits++;
+    }
+}
+
+static void put_ue(BitWriter *bw, RK_U32 val)
+{
+    RK_U32 code = val + 1;
+    RK_S32 len = 0;
+
+    while ((code >> len) > 1)
+        len++;
+
+    put_bits(bw, 0, len);
+    put_bits(bw, code, len + 1);
+}
+
+static void put_se(BitWriter *bw, RK_S32 val)
+{
+    put_ue(bw, val <= 0 ? -2 * val : 2 * val - 1);
+}
+
+static void put_trailing(BitWriter *bw)
+{
+    put_bits(bw, 1, 1);
+    while (bw->bits & 7)
+        put_bits(bw, 0, 1);
+}
+
+/* 4 bytes nal size, nal header and rbsp with emulation prevention */
+static void write_nal(ParseStrm *strm, RK_S32 ref_idc, RK_S32 type, BitWriter *bw)
+{
+    RK_U8 *size = strm->buf + strm->len;
+    RK_U8 *p = size + 4;
+    RK_S32 zeros = 0;
+    RK_S32 nal_len;
+    RK_S32 i;
+
+    *p++ = (RK_U8)((ref_idc << 5) | type);
+
+    for (i = 0; i < (bw->bits >> 3); i++) {
+        if (zeros == 2 && bw->buf[i] <= 3) {
+            *p++ = 3;
+            zeros = 0;
+        }
+        zeros = bw->buf[i] ? 0 : zeros + 1;
+        *p++ = bw->buf[i];
+    }
+
+    nal_len = (RK_S32)(p - size) - 4;
+    size[0] = (RK_U8)(nal_len >> 24);
+    size[1] = (RK_U8)(nal_len >> 16);
+    size[2] = (RK_U8)(nal_len >> 8);
+    size[3] = (RK_U8)(nal_len);
+    strm->len = (RK_S32)(p - strm->buf);
+}
+
+static void write_sps(ParseStrm *strm)
+{
+    BitWriter bw;
+
+    memset(&bw, 0, sizeof(bw));
+    put_bits(&bw, 77, 8);               /* profile_idc main */
+    put_bits(&bw, 0, 8);                /* constraint flags */
+    put_bits(&bw, 40, 8);               /* level_idc */
+    put_ue(&bw, 0);                     /* seq_parameter_set_id */
+    put_ue(&bw, 0);                     /* log2_max_frame_num_minus4 */
+    put_ue(&bw, 0);                     /* pic_order_cnt_type */
+    put_ue(&bw, 4);                     /* log2_max_pic_order_cnt_lsb_minus4 */
+    put_ue(&bw, 4);                     /* max_num_ref_frames */
+    put_bits(&bw, 0, 1);                /* gaps_in_frame_num_value_allowed_flag */
+    put_ue(&bw, PARSE_WIDTH_MBS - 1);
+    put_ue(&bw, PARSE_HEIGHT_MBS - 1);
+    put_bits(&bw, 1, 1);                /* frame_mbs_only_flag */
+    put_bits(&bw, 1, 1);                /* direct_8x8_inference_flag */
+    put_bits(&bw, 0, 1);                /* frame_cropping_flag */
+    put_bits(&bw, 0, 1);                /* vui_parameters_present_flag */
+    put_trailing(&bw);
+    write_nal(strm, 3, NAL_SPS, &bw);
+}
+
+static void write_pps(ParseStrm *strm)
+{
+    BitWriter bw;
+
+    memset(&bw, 0, sizeof(bw));
+    put_ue(&bw, 0);                     /* pic_parameter_set_id */
+    put_ue(&bw, 0);                     /* seq_parameter_set_id */
+    put_bits(&bw, 0, 1);                /* entropy_coding_mode_flag */
+    put_bits(&bw, 0, 1);                /* bottom_field_pic_order_in_frame_present_flag */
+    put_ue(&bw, 0);                     /* num_slice_groups_minus1 */
+    put_ue(&bw, 2);                     /* num_ref_idx_l0_default_active_minus1 */
+    put_ue(&bw, 0);                     /* num_ref_idx_l1_default_active_minus1 */
+    put_bits(&bw, 0, 1);                /* weighted_pred_flag */
+    put_bits(&bw, 0, 2);                /* weighted_bipred_idc */
+    put_se(&bw, 0);                     /* pic_init_qp_minus26 */
+    put_se(&bw, 0);                     /* pic_init_qs_minus26 */
+    put_se(&bw, 0);                     /* chroma_qp_index_offset */
+    put_bits(&bw, 1, 1);                /* deblocking_filter_control_present_flag */
+    put_bits(&bw, 0, 1);                /* constrained_intra_pred_flag */
+    put_bits(&bw, 0, 1);                /* redundant_pic_cnt_present_flag */
+    put_trailing(&bw);
+    write_nal(strm, 3, NAL_PPS, &bw);
+}
+
+/* avcC with one sps and one pps, nal size length is 4 */
+static void write_extra_data(ParseStrm *strm)
+{
+    ParseStrm *nal = mpp_calloc(ParseStrm, 1);
+    RK_U8 *p = strm->buf;
+    RK_S32 len;
+
+    *p++ = 1;
+    *p++ = 77;
+    *p++ = 0;
+    *p++ = 40;
+    *p++ = 0xff;
+    *p++ = 0xe1;
+
+    write_sps(nal);
+    len = nal->len - 4;
+    *p++ = (RK_U8)(len >> 8);
+    *p++ = (RK_U8)(len);
+    memcpy(p, nal->buf + 4, len);
+    p += len;
+
+    nal->len = 0;
+    write_pps(nal);
+    len = nal->len - 4;
+    *p++ = 1;
+    *p++ = (RK_U8)(len >> 8);
+    *p++ = (RK_U8)(len);
+    memcpy(p, nal->buf + 4, len);
+    p += len;
+
+    strm->len = (RK_S32)(p - strm->buf);
+    MPP_FREE(nal);
+}
+
+/* slice_type 2 / 0 / 1 for I / P / B, nal_ref_idc 0 for B */
+static void write_slice(ParseStrm *strm, RK_S32 first_mb, RK_S32 slice_type,
+                        RK_S32 frame_num, RK_S32 poc_lsb, RK_S32 idr_id)
+{
+    RK_S32 is_idr = idr_id >= 0;
+    RK_S32 ref_idc = (slice_type == 1) ? 0 : 2;
+    BitWriter bw;
+    RK_S32 i;
+
+    memset(&bw, 0, sizeof(bw));
+    put_ue(&bw, first_mb);
+    put_ue(&bw, slice_type + 5);
+    put_ue(&bw, 0);                     /* pic_parameter_set_id */
+    put_bits(&bw, frame_num, 4);
+    if (is_idr)
+        put_ue(&bw, idr_id);
+    put_bits(&bw, poc_lsb, 8);
+    if (slice_type == 1)
+        put_bits(&bw, 1, 1);            /* direct_spatial_mv_pred_flag */
+    if (slice_type != 2) {
+        put_bits(&bw, 0, 1);            /* num_ref_idx_active_override_flag */
+        put_bits(&bw, 0, 1);            /* ref_pic_list_modification_flag_l0 */
+        if (slice_type == 1)
+            put_bits(&bw, 0, 1);        /* ref_pic_list_modification_flag_l1 */
+    }
+    if (ref_idc) {
+        if (is_idr) {
+            put_bits(&bw, 0, 1);        /* no_output_of_prior_pics_flag */
+            put_bits(&bw, 0, 1);        /* long_term_reference_flag */
+        } else {
+            put_bits(&bw, 0, 1);        /* adaptive_ref_pic_marking_mode_flag */
+        }
+    }
+    put_se(&bw, 0);                     /* slice_qp_delta */
+    put_ue(&bw, 1);                     /* disable_deblocking_filter_idc */
+
+    /* filler slice data never parsed */
+    for (i = 0; i < PARSE_SLICE_DATA_SIZE; i++)
+        put_bits(&bw, 0xa5, 8);
+    put_trailing(&bw);
+
+    write_nal(strm, ref_idc, is_idr ? NAL_IDR : NAL_SLICE, &bw);
+}
+
+/* picture in decode order: IDR, then P at 3k + 3 followed by B at 3k + 1, 3k + 2 */
+static void write_picture(ParseStrm *strm, RK_S32 idx, RK_S32 slice_count)
+{
+    RK_S32 gop_idx = idx / PARSE_GOP_SIZE;
+    RK_S32 pos = idx % PARSE_GOP_SIZE;
+    RK_S32 slice_type = 2;
+    RK_S32 frame_num = 0;
+    RK_S32 display = 0;
+    RK_S32 i;
+
+    strm->len = 0;
+    if (pos) {
+        RK_S32 mini = (pos - 1) / 3;
+        RK_S32 sub = (pos - 1) % 3;
+
+        /* frame_num of B follows the P decoded just before it */
+        frame_num = (mini + 1 + (sub ? 1 : 0)) & 15;
+        slice_type = sub ? 1 : 0;
+        display = sub ? mini * 3 + sub : mini * 3 + 3;
+    }
+
+    for (i = 0; i < slice_count; i++) {
+        RK_S32 first_mb = i * PARSE_WIDTH_MBS * PARSE_HEIGHT_MBS / slice_count;
+
+        write_slice(strm, first_mb, slice_type, frame_num, display * 2,
+                    pos ? -1 : (gop_idx & 1));
+    }
+}
+
+static void flush_display(MppBufSlots frame_slots)
+{
+    RK_S32 index = -1;
+    MppFrame frame = NULL;
+
+    while (MPP_OK == mpp_buf_slot_dequeue(frame_slots, &index, QUEUE_DISPLAY)) {
+        mpp_buf_slot_get_prop(frame_slots, index, SLOT_FRAME, &frame);
+        if (frame)
+            mpp_frame_deinit(&frame);
+        mpp_buf_slot_clr_flag(frame_slots, index, SLOT_QUEUE_USE);
+    }
+}
+
+static MPP_RET run_parse(RK_S32 slice_count)
+{
+    MPP_RET ret = MPP_NOK;
+    MppBufSlots frame_slots = NULL;
+    MppBufSlots packet_slots = NULL;
+    Parser parser = NULL;
+    ParserCfg cfg;
+    ParseStrm *strm = NULL;
+    MppPacket pkt = NULL;
+    HalTaskInfo task;
+    RK_S64 time_us = 0;
+    RK_S32 parsed = 0;
+    RK_S32 i;
+    RK_U32 k;
+
+    strm = mpp_calloc(ParseStrm, 1);
+    if (NULL == strm)
+        return MPP_ERR_MALLOC;
+
+    if (mpp_buf_slot_init(&frame_slots) || mpp_buf_slot_init(&packet_slots))
+        goto __RETURN;
+
+    mpp_buf_slot_setup(packet_slots, 2);
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.coding = MPP_VIDEO_CodingAVC;
+    cfg.frame_slots = frame_slots;
+    cfg.packet_slots = packet_slots;
+    cfg.task_count = 2;
+    if (parser_init(&parser, &cfg))
+        goto __RETURN;
+
+    memset(&task, 0, sizeof(task));
+    memset(task.dec.refer, -1, sizeof(task.dec.refer));
+    task.dec.input = -1;
+
+    write_extra_data(strm);
+    mpp_packet_init(&pkt, strm->buf, strm->len);
+    mpp_packet_set_flag(pkt, MPP_PACKET_FLAG_EXTRA_DATA);
+    parser_prepare(parser, pkt, &task.dec);
+    mpp_packet_deinit(&pkt);
+
+    for (i = 0; i <= PARSE_FRAME_COUNT; i++) {
+        RK_S64 start;
+
+        if (i < PARSE_FRAME_COUNT) {
+            write_picture(strm, i, slice_count);
+            mpp_packet_init(&pkt, strm->buf, strm->len);
+        } else {
+            mpp_packet_init(&pkt, NULL, 0);
+            mpp_packet_set_eos(pkt);
+        }
+
+        start = mpp_time_us();
+        parser_prepare(parser, pkt, &task.dec);
+        if (task.dec.valid) {
+            if (task.dec.input < 0)
+                mpp_buf_slot_get_unused(packet_slots, &task.dec.input);
+            mpp_buf_slot_set_flag(packet_slots, task.dec.input, SLOT_CODEC_READY);
+            mpp_buf_slot_set_flag(packet_slots, task.dec.input, SLOT_HAL_INPUT);
+            parser_parse(parser, &task.dec);
+        }
+        time_us += mpp_time_us() - start;
+
+        mpp_packet_deinit(&pkt);
+
+        if (task.dec.valid) {
+            parsed++;
+            if (mpp_buf_slot_is_changed(frame_slots))
+                mpp_buf_slot_ready(frame_slots);
+
+            /* release slots as hal does after hardware done */
+            mpp_buf_slot_clr_flag(packet_slots, task.dec.input, SLOT_HAL_INPUT);
+            mpp_buf_slot_clr_flag(frame_slots, task.dec.output, SLOT_HAL_OUTPUT);
+            for (k = 0; k < MPP_ARRAY_ELEMS(task.dec.refer); k++) {
+                if (task.dec.refer[k] >= 0)
+                    mpp_buf_slot_clr_flag(frame_slots, task.dec.refer[k], SLOT_HAL_INPUT);
+            }
+            memset(&task, 0, sizeof(task));
+            memset(task.dec.refer, -1, sizeof(task.dec.refer));
+            task.dec.input = -1;
+        }
+        flush_display(frame_slots);
+    }
+
+    mpp_log("slices %2d pictures %4d parse %8.2f us per picture %6.2f us per slice\n",
+            slice_count, parsed, (float)time_us / PARSE_FRAME_COUNT,
+            (float)time_us / PARSE_FRAME_COUNT / slice_count);
+
+    if (parsed < PARSE_FRAME_COUNT - 1) {
+        mpp_err("only %d of %d pictures parsed\n", parsed, PARSE_FRAME_COUNT);
+        goto __RETURN;
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    if (parser)
+        parser_deinit(parser);
+    if (packet_slots)
+        mpp_buf_slot_deinit(packet_slots);
+    if (frame_slots)
+        mpp_buf_slot_deinit(frame_slots);
+    MPP_FREE(strm);
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret;
+
+    mpp_log("h264d_parse_test start\n");
+
+    ret = run_parse(1);
+    if (MPP_OK == ret)
+        ret = run_parse(16);
+    if (MPP_OK == ret)
+        ret = run_parse(PARSE_MAX_SLICES);
+
+    mpp_log("h264d_parse_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
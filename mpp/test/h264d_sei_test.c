@@ -0,0 +1,454 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "h264d_sei_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_meta.h"
+#include "mpp_frame_impl.h"
+#include "mpp_packet_impl.h"
+#include "mpp_buf_slot.h"
+#include "mpp_parser.h"
+#include "hal_task.h"
+
+/*
+ * h264 decoder sei export test on the whole parser
+ *
+ * Each IDR picture carries one user_data_unregistered sei with its picture
+ * index, every fourth picture has none. The stream is fed in avcC format with
+ * the sei either before the slice of its picture or, as a split input does,
+ * at the end of the packet of previous picture. Each displayed frame must
+ * export the sei of its own picture only. No hardware is touched, slots are
+ * released right after parse as hal would do.
+ */
+#define SEI_WIDTH_MBS           4
+#define SEI_HEIGHT_MBS          4
+#define SEI_FRAME_COUNT         32
+#define SEI_SLICE_DATA_SIZE     16
+#define SEI_UUID_SIZE           16
+#define SEI_STRM_SIZE           256
+
+#define NAL_IDR                 5
+#define NAL_SEI                 6
+#define NAL_SPS                 7
+#define NAL_PPS                 8
+
+typedef enum SeiPlace_e {
+    SEI_LEADING,                /* sei before the slice of its picture */
+    SEI_TRAILING,               /* sei after the slice of previous picture */
+} SeiPlace;
+
+typedef struct BitWriter_t {
+    RK_U8   buf[128];
+    RK_S32  bits;
+} BitWriter;
+
+typedef struct SeiStrm_t {
+    RK_U8   buf[SEI_STRM_SIZE];
+    RK_S32  len;
+} SeiStrm;
+
+static const RK_U8 sei_uuid[SEI_UUID_SIZE] = {
+    0x5a, 0x1e, 0x9c, 0x3b, 0x70, 0x42, 0x4d, 0x11,
+    0x8e, 0x26, 0xc4, 0x0f, 0x93, 0xb7, 0x61, 0xd8,
+};
+
+static void put_bits(BitWriter *bw, RK_U32 val, RK_S32 n)
+{
+    while (n--) {
+        if (!(bw->bits & 7))
+            bw->buf[bw->bits >> 3] = 0;
+        if ((val >> n) & 1)
+            bw->buf[bw->bits >> 3] |= 0x80 >> (bw->bits & 7);
+        bw->bits++;
+    }
+}
+
+static void put_ue(BitWriter *bw, RK_U32 val)
+{
+    RK_U32 code = val + 1;
+    RK_S32 len = 0;
+
+    while ((code >> len) > 1)
+        len++;
+
+    put_bits(bw, 0, len);
+    put_bits(bw, code, len + 1);
+}
+
+static void put_se(BitWriter *bw, RK_S32 val)
+{
+    put_ue(bw, val <= 0 ? -2 * val : 2 * val - 1);
+}
+
+static void put_trailing(BitWriter *bw)
+{
+    put_bits(bw, 1, 1);
+    while (bw->bits & 7)
+        put_bits(bw, 0, 1);
+}
+
+/* 4 bytes nal size, nal header and rbsp with emulation prevention */
+static void write_nal(SeiStrm *strm, RK_S32 ref_idc, RK_S32 type, BitWriter *bw)
+{
+    RK_U8 *size = strm->buf + strm->len;
+    RK_U8 *p = size + 4;
+    RK_S32 zeros = 0;
+    RK_S32 nal_len;
+    RK_S32 i;
+
+    *p++ = (RK_U8)((ref_idc << 5) | type);
+
+    for (i = 0; i < (bw->bits >> 3); i++) {
+        if (zeros == 2 && bw->buf[i] <= 3) {
+            *p++ = 3;
+            zeros = 0;
+        }
+        zeros = bw->buf[i] ? 0 : zeros + 1;
+        *p++ = bw->buf[i];
+    }
+
+    nal_len = (RK_S32)(p - size) - 4;
+    size[0] = (RK_U8)(nal_len >> 24);
+    size[1] = (RK_U8)(nal_len >> 16);
+    size[2] = (RK_U8)(nal_len >> 8);
+    size[3] = (RK_U8)(nal_len);
+    strm->len = (RK_S32)(p - strm->buf);
+}
+
+static void write_sps(SeiStrm *strm)
+{
+    BitWriter bw;
+
+    memset(&bw, 0, sizeof(bw));
+    put_bits(&bw, 77, 8);               /* profile_idc main */
+    put_bits(&bw, 0, 8);                /* constraint flags */
+    put_bits(&bw, 40, 8);               /* level_idc */
+    put_ue(&bw, 0);                     /* seq_parameter_set_id */
+    put_ue(&bw, 0);                     /* log2_max_frame_num_minus4 */
+    put_ue(&bw, 0);                     /* pic_order_cnt_type */
+    put_ue(&bw, 4);                     /* log2_max_pic_order_cnt_lsb_minus4 */
+    put_ue(&bw, 1);                     /* max_num_ref_frames */
+    put_bits(&bw, 0, 1);                /* gaps_in_frame_num_value_allowed_flag */
+    put_ue(&bw, SEI_WIDTH_MBS - 1);
+    put_ue(&bw, SEI_HEIGHT_MBS - 1);
+    put_bits(&bw, 1, 1);                /* frame_mbs_only_flag */
+    put_bits(&bw, 1, 1);                /* direct_8x8_inference_flag */
+    put_bits(&bw, 0, 1);                /* frame_cropping_flag */
+    put_bits(&bw, 0, 1);                /* vui_parameters_present_flag */
+    put_trailing(&bw);
+    write_nal(strm, 3, NAL_SPS, &bw);
+}
+
+static void write_pps(SeiStrm *strm)
+{
+    BitWriter bw;
+
+    memset(&bw, 0, sizeof(bw));
+    put_ue(&bw, 0);                     /* pic_parameter_set_id */
+    put_ue(&bw, 0);                     /* seq_parameter_set_id */
+    put_bits(&bw, 0, 1);                /* entropy_coding_mode_flag */
+    put_bits(&bw, 0, 1);                /* bottom_field_pic_order_in_frame_present_flag */
+    put_ue(&bw, 0);                     /* num_slice_groups_minus1 */
+    put_ue(&bw, 0);                     /* num_ref_idx_l0_default_active_minus1 */
+    put_ue(&bw, 0);                     /* num_ref_idx_l1_default_active_minus1 */
+    put_bits(&bw, 0, 1);                /* weighted_pred_flag */
+    put_bits(&bw, 0, 2);                /* weighted_bipred_idc */
+    put_se(&bw, 0);                     /* pic_init_qp_minus26 */
+    put_se(&bw, 0);                     /* pic_init_qs_minus26 */
+    put_se(&bw, 0);                     /* chroma_qp_index_offset */
+    put_bits(&bw, 1, 1);                /* deblocking_filter_control_present_flag */
+    put_bits(&bw, 0, 1);                /* constrained_intra_pred_flag */
+    put_bits(&bw, 0, 1);                /* redundant_pic_cnt_present_flag */
+    put_trailing(&bw);
+    write_nal(strm, 3, NAL_PPS, &bw);
+}
+
+/* avcC with one sps and one pps, nal size length is 4 */
+static void write_extra_data(SeiStrm *strm)
+{
+    SeiStrm nal;
+    RK_U8 *p = strm->buf;
+    RK_S32 len;
+
+    *p++ = 1;
+    *p++ = 77;
+    *p++ = 0;
+    *p++ = 40;
+    *p++ = 0xff;
+    *p++ = 0xe1;
+
+    nal.len = 0;
+    write_sps(&nal);
+    len = nal.len - 4;
+    *p++ = (RK_U8)(len >> 8);
+    *p++ = (RK_U8)(len);
+    memcpy(p, nal.buf + 4, len);
+    p += len;
+
+    nal.len = 0;
+    write_pps(&nal);
+    len = nal.len - 4;
+    *p++ = 1;
+    *p++ = (RK_U8)(len >> 8);
+    *p++ = (RK_U8)(len);
+    memcpy(p, nal.buf + 4, len);
+    p += len;
+
+    strm->len = (RK_S32)(p - strm->buf);
+}
+
+static RK_S32 has_sei(RK_S32 idx)
+{
+    return (idx % 4) != 3;
+}
+
+/* user_data_unregistered with uuid and one byte of picture index */
+static void write_sei(SeiStrm *strm, RK_S32 idx)
+{
+    BitWriter bw;
+    RK_S32 i;
+
+    memset(&bw, 0, sizeof(bw));
+    put_bits(&bw, 5, 8);                /* payloadType */
+    put_bits(&bw, SEI_UUID_SIZE + 1, 8);
+    for (i = 0; i < SEI_UUID_SIZE; i++)
+        put_bits(&bw, sei_uuid[i], 8);
+    put_bits(&bw, idx, 8);
+    put_trailing(&bw);
+    write_nal(strm, 0, NAL_SEI, &bw);
+}
+
+static void write_idr(SeiStrm *strm, RK_S32 idx)
+{
+    BitWriter bw;
+    RK_S32 i;
+
+    memset(&bw, 0, sizeof(bw));
+    put_ue(&bw, 0);                     /* first_mb_in_slice */
+    put_ue(&bw, 7);                     /* slice_type I */
+    put_ue(&bw, 0);                     /* pic_parameter_set_id */
+    put_bits(&bw, 0, 4);                /* frame_num */
+    put_ue(&bw, idx & 1);               /* idr_pic_id */
+    put_bits(&bw, 0, 8);                /* pic_order_cnt_lsb */
+    put_bits(&bw, 0, 1);                /* no_output_of_prior_pics_flag */
+    put_bits(&bw, 0, 1);                /* long_term_reference_flag */
+    put_se(&bw, 0);                     /* slice_qp_delta */
+    put_ue(&bw, 1);                     /* disable_deblocking_filter_idc */
+
+    /* filler slice data never parsed */
+    for (i = 0; i < SEI_SLICE_DATA_SIZE; i++)
+        put_bits(&bw, 0xa5, 8);
+    put_trailing(&bw);
+
+    write_nal(strm, 3, NAL_IDR, &bw);
+}
+
+static void write_packet(SeiStrm *strm, RK_S32 idx, SeiPlace place)
+{
+    strm->len = 0;
+
+    if ((place == SEI_LEADING || !idx) && has_sei(idx))
+        write_sei(strm, idx);
+
+    write_idr(strm, idx);
+
+    if (place == SEI_TRAILING && idx + 1 < SEI_FRAME_COUNT && has_sei(idx + 1))
+        write_sei(strm, idx + 1);
+}
+
+static MPP_RET check_frame(MppFrame frame, RK_S32 idx)
+{
+    MppMeta meta = mpp_frame_get_meta(frame);
+    MppPacket packet = NULL;
+    MppDecSeiHead *head = NULL;
+    RK_U8 *data = NULL;
+    MPP_RET ret = MPP_NOK;
+
+    if (meta)
+        mpp_meta_get_packet(meta, MPP_META_KEY_OUTPUT_SEI, &packet);
+
+    if (!has_sei(idx)) {
+        if (packet) {
+            mpp_err("frame %d exports sei without sei in stream\n", idx);
+            goto __RETURN;
+        }
+        return MPP_OK;
+    }
+
+    if (NULL == packet) {
+        mpp_err("frame %d exports no sei\n", idx);
+        return MPP_NOK;
+    }
+
+    head = (MppDecSeiHead *)mpp_packet_get_data(packet);
+    data = (RK_U8 *)(head + 1);
+    if (mpp_packet_get_length(packet) != sizeof(*head) + MPP_ALIGN(SEI_UUID_SIZE + 1, 4) ||
+        head->payload_type != 5 || head->payload_size != SEI_UUID_SIZE + 1 ||
+        memcmp(data, sei_uuid, SEI_UUID_SIZE)) {
+        mpp_err("frame %d sei records mismatch length %d\n", idx,
+                (RK_S32)mpp_packet_get_length(packet));
+        goto __RETURN;
+    }
+
+    if (data[SEI_UUID_SIZE] != idx) {
+        mpp_err("frame %d exports sei of picture %d\n", idx, data[SEI_UUID_SIZE]);
+        goto __RETURN;
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    if (packet)
+        mpp_packet_deinit(&packet);
+    return ret;
+}
+
+/* take sei with the frame as mpp_dec_push_display does */
+static MPP_RET flush_display(MppBufSlots frame_slots, RK_S32 *displayed)
+{
+    MPP_RET ret = MPP_OK;
+    RK_S32 index = -1;
+
+    while (MPP_OK == mpp_buf_slot_dequeue(frame_slots, &index, QUEUE_DISPLAY)) {
+        MppFrame frame = NULL;
+        MppFrame slot_frame = NULL;
+
+        mpp_buf_slot_get_prop(frame_slots, index, SLOT_FRAME, &frame);
+        mpp_buf_slot_get_prop(frame_slots, index, SLOT_FRAME_PTR, &slot_frame);
+        mpp_frame_move_meta(frame, slot_frame);
+        if (check_frame(frame, *displayed))
+            ret = MPP_NOK;
+        (*displayed)++;
+        mpp_frame_deinit(&frame);
+        mpp_buf_slot_clr_flag(frame_slots, index, SLOT_QUEUE_USE);
+    }
+
+    return ret;
+}
+
+static MPP_RET run_sei(SeiPlace place)
+{
+    MPP_RET ret = MPP_NOK;
+    MppBufSlots frame_slots = NULL;
+    MppBufSlots packet_slots = NULL;
+    Parser parser = NULL;
+    ParserCfg cfg;
+    SeiStrm strm;
+    MppPacket pkt = NULL;
+    HalTaskInfo task;
+    RK_U32 mask = MPP_DEC_SEI_USER_DATA_UNREG;
+    RK_S32 displayed = 0;
+    RK_S32 i;
+    RK_U32 k;
+
+    if (mpp_buf_slot_init(&frame_slots) || mpp_buf_slot_init(&packet_slots))
+        goto __RETURN;
+
+    mpp_buf_slot_setup(packet_slots, 2);
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.coding = MPP_VIDEO_CodingAVC;
+    cfg.frame_slots = frame_slots;
+    cfg.packet_slots = packet_slots;
+    cfg.task_count = 2;
+    if (parser_init(&parser, &cfg))
+        goto __RETURN;
+
+    parser_control(parser, MPP_DEC_SET_SEI_MASK, &mask);
+
+    memset(&task, 0, sizeof(task));
+    memset(task.dec.refer, -1, sizeof(task.dec.refer));
+    task.dec.input = -1;
+
+    write_extra_data(&strm);
+    mpp_packet_init(&pkt, strm.buf, strm.len);
+    mpp_packet_set_flag(pkt, MPP_PACKET_FLAG_EXTRA_DATA);
+    parser_prepare(parser, pkt, &task.dec);
+    mpp_packet_deinit(&pkt);
+
+    for (i = 0; i <= SEI_FRAME_COUNT; i++) {
+        if (i < SEI_FRAME_COUNT) {
+            write_packet(&strm, i, place);
+            mpp_packet_init(&pkt, strm.buf, strm.len);
+        } else {
+            mpp_packet_init(&pkt, NULL, 0);
+            mpp_packet_set_eos(pkt);
+        }
+
+        parser_prepare(parser, pkt, &task.dec);
+        if (task.dec.valid) {
+            if (task.dec.input < 0)
+                mpp_buf_slot_get_unused(packet_slots, &task.dec.input);
+            mpp_buf_slot_set_flag(packet_slots, task.dec.input, SLOT_CODEC_READY);
+            mpp_buf_slot_set_flag(packet_slots, task.dec.input, SLOT_HAL_INPUT);
+            parser_parse(parser, &task.dec);
+        }
+        mpp_packet_deinit(&pkt);
+
+        if (task.dec.valid) {
+            if (mpp_buf_slot_is_changed(frame_slots))
+                mpp_buf_slot_ready(frame_slots);
+
+            /* release slots as hal does after hardware done */
+            mpp_buf_slot_clr_flag(packet_slots, task.dec.input, SLOT_HAL_INPUT);
+            mpp_buf_slot_clr_flag(frame_slots, task.dec.output, SLOT_HAL_OUTPUT);
+            for (k = 0; k < MPP_ARRAY_ELEMS(task.dec.refer); k++) {
+                if (task.dec.refer[k] >= 0)
+                    mpp_buf_slot_clr_flag(frame_slots, task.dec.refer[k], SLOT_HAL_INPUT);
+            }
+            memset(&task, 0, sizeof(task));
+            memset(task.dec.refer, -1, sizeof(task.dec.refer));
+            task.dec.input = -1;
+        }
+        if (flush_display(frame_slots, &displayed))
+            goto __RETURN;
+    }
+
+    if (displayed != SEI_FRAME_COUNT) {
+        mpp_err("only %d of %d frames displayed\n", displayed, SEI_FRAME_COUNT);
+        goto __RETURN;
+    }
+
+    mpp_log("sei %s slice frames %d exported on its own picture\n",
+            place == SEI_LEADING ? "before" : "after", displayed);
+    ret = MPP_OK;
+__RETURN:
+    if (parser)
+        parser_deinit(parser);
+    if (packet_slots)
+        mpp_buf_slot_deinit(packet_slots);
+    if (frame_slots)
+        mpp_buf_slot_deinit(frame_slots);
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret;
+
+    mpp_log("h264d_sei_test start\n");
+
+    ret = run_sei(SEI_LEADING);
+    if (MPP_OK == ret)
+        ret = run_sei(SEI_TRAILING);
+
+    mpp_log("h264d_sei_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,374 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "h264e_lookahead_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_time.h"
+#include "mpp_buffer.h"
+
+#include "H264Slice.h"
+#include "H264RateControl.h"
+#include "h264e_lookahead.h"
+
+/*
+ * The test generates a synthetic clip with panning scenes of different
+ * detail, hard scene cuts and flashes. Frames go through the threaded
+ * lookahead the same way mpp_enc feeds it and the h264 rate control is run
+ * with and without lookahead info on a simple encoder model:
+ *
+ * bits = K * cost / qstep(qp)
+ *
+ * where cost is measured on full resolution 16x16 blocks with the true
+ * motion vector, independent of the lookahead estimation.
+ */
+#define LKH_TEST_WIDTH          640
+#define LKH_TEST_HEIGHT         352
+#define LKH_TEST_FRAMES         600
+#define LKH_TEST_FPS            30
+#define LKH_TEST_BPS            1000000
+#define LKH_TEST_GOP            60
+#define LKH_TEST_DEPTH          16
+#define LKH_TEST_PAN_MAX        3
+#define LKH_TEST_CANVAS_W       (LKH_TEST_WIDTH + LKH_TEST_PAN_MAX * 80)
+#define LKH_TEST_MODEL_K        384
+
+typedef struct LkhTestStat_t {
+    const char  *name;
+    RK_S64      bits_total;
+    RK_S32      bits_max;
+    RK_S64      qp_sum;
+    RK_S64      qp_sqr;
+    RK_S32      vbv_max;
+    RK_S32      vbv_overflow;
+    RK_S32      vbv;
+} LkhTestStat;
+
+static RK_U32 test_rand_seed = 1;
+
+static RK_U32 test_rand(void)
+{
+    test_rand_seed = test_rand_seed * 1103515245 + 12345;
+    return (test_rand_seed >> 16) & 0x7fff;
+}
+
+/* qstep in Q8, qstep(qp) = 0.625 * 2 ^ (qp / 6) */
+static RK_S32 test_qstep_q8(RK_S32 qp)
+{
+    static const RK_S32 qstep_base[6] = { 160, 180, 202, 226, 254, 285 };
+
+    return qstep_base[qp % 6] << (qp / 6);
+}
+
+static void gen_canvas(RK_U8 *canvas, RK_S32 detail)
+{
+    RK_S32 x, y;
+
+    for (y = 0; y < LKH_TEST_HEIGHT; y++) {
+        for (x = 0; x < LKH_TEST_CANVAS_W; x++) {
+            RK_S32 v = 64 + (x * 96 / LKH_TEST_CANVAS_W) + (y * 64 / LKH_TEST_HEIGHT);
+
+            /* blocky texture with random detail level */
+            if (((x >> 3) + (y >> 3)) & 1)
+                v += detail;
+            v += (RK_S32)(test_rand() % (detail + 1)) - detail / 2;
+            canvas[y * LKH_TEST_CANVAS_W + x] = (RK_U8)MPP_CLIP3(0, 255, v);
+        }
+    }
+}
+
+static RK_S32 frame_cost(RK_U8 *cur, RK_U8 *prev, RK_S32 dx)
+{
+    RK_S32 cost = 0;
+    RK_S32 mbx, mby, x, y;
+
+    for (mby = 0; mby < LKH_TEST_HEIGHT; mby += 16) {
+        for (mbx = 0; mbx < LKH_TEST_WIDTH; mbx += 16) {
+            RK_S32 intra = 0;
+            RK_S32 inter = 0;
+            RK_S32 mean = 0;
+
+            for (y = 0; y < 16; y++)
+                for (x = 0; x < 16; x++)
+                    mean += cur[(mby + y) * LKH_TEST_WIDTH + mbx + x];
+            mean = (mean + 128) >> 8;
+
+            for (y = 0; y < 16; y++) {
+                for (x = 0; x < 16; x++) {
+                    RK_S32 pos = (mby + y) * LKH_TEST_WIDTH + mbx + x;
+                    RK_S32 ref_x = MPP_CLIP3(0, LKH_TEST_WIDTH - 1, mbx + x + dx);
+
+                    intra += MPP_ABS(cur[pos] - mean);
+                    if (prev)
+                        inter += MPP_ABS(cur[pos] - prev[(mby + y) * LKH_TEST_WIDTH + ref_x]);
+                }
+            }
+
+            cost += ((prev) ? MPP_MIN(intra, inter) : intra) + 256;
+        }
+    }
+
+    return cost;
+}
+
+static void rc_setup(h264RateControl_s *rc)
+{
+    h264VirtualBuffer_s *vb = &rc->virtualBuffer;
+
+    memset(rc, 0, sizeof(*rc));
+    rc->outRateNum      = LKH_TEST_FPS;
+    rc->outRateDenom    = 1;
+    rc->mbPerPic        = (LKH_TEST_WIDTH / 16) * (LKH_TEST_HEIGHT / 16);
+    rc->mbRows          = LKH_TEST_HEIGHT / 16;
+    rc->picRc           = ENCHW_YES;
+    rc->mbRc            = ENCHW_NO;
+    rc->picSkip         = ENCHW_NO;
+    rc->hrd             = ENCHW_NO;
+    rc->qpHdr           = 30;
+    rc->qpMin           = 10;
+    rc->qpMax           = 51;
+    rc->gopLen          = LKH_TEST_GOP;
+    rc->intraQpDelta    = -3;
+    rc->lkhRc           = ENCHW_NO;
+    vb->bitRate         = LKH_TEST_BPS;
+    vb->timeScale       = LKH_TEST_FPS;
+    vb->unitsInTic      = 1;
+    vb->bufferSize      = LKH_TEST_BPS;
+    H264InitRc(rc);
+}
+
+static void rc_frame(h264RateControl_s *rc, LkhTestStat *stat, RK_S32 cost,
+                     RK_U32 slice_type)
+{
+    RK_S32 bit_per_pic = LKH_TEST_BPS / LKH_TEST_FPS;
+    RK_S32 bits;
+    RK_S32 qp;
+
+    H264BeforePicRc(rc, 1, slice_type);
+    qp = rc->qpHdr;
+
+    /* encoder model with +-6% noise */
+    bits = (RK_S32)((RK_S64)cost * LKH_TEST_MODEL_K / test_qstep_q8(qp));
+    bits += bits * ((RK_S32)(test_rand() % 13) - 6) / 100;
+    bits = MPP_MAX(bits, 64);
+
+    H264AfterPicRc(rc, bits / 4, bits / 8, qp * rc->mbPerPic);
+
+    stat->bits_total += bits;
+    stat->bits_max = MPP_MAX(stat->bits_max, bits);
+    stat->qp_sum += qp;
+    stat->qp_sqr += qp * qp;
+
+    /* decoder buffer of one second starting half full */
+    stat->vbv += bits - bit_per_pic;
+    stat->vbv = MPP_MAX(stat->vbv, -LKH_TEST_BPS / 2);
+    if (stat->vbv > LKH_TEST_BPS / 2)
+        stat->vbv_overflow++;
+    stat->vbv_max = MPP_MAX(stat->vbv_max, stat->vbv);
+}
+
+static void stat_show(LkhTestStat *stat)
+{
+    RK_S64 target = (RK_S64)LKH_TEST_BPS * LKH_TEST_FRAMES / LKH_TEST_FPS;
+    float qp_avg = (float)stat->qp_sum / LKH_TEST_FRAMES;
+    float qp_var = (float)stat->qp_sqr / LKH_TEST_FRAMES - qp_avg * qp_avg;
+
+    mpp_log("%-10s bitrate err %+6.2f%% peak frame %5.2fx avg qp %5.2f qp var %6.2f vbv peak %3d%% overflow %d\n",
+            stat->name, (float)(stat->bits_total - target) * 100 / target,
+            (float)stat->bits_max * LKH_TEST_FRAMES / stat->bits_total,
+            qp_avg, qp_var, (RK_S32)((RK_S64)stat->vbv_max * 100 / (LKH_TEST_BPS / 2)),
+            stat->vbv_overflow);
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    MppBufferGroup group = NULL;
+    MppBuffer bufs[LKH_TEST_DEPTH + 1];
+    RK_S32 costs[LKH_TEST_DEPTH + 1];
+    RK_U32 types[LKH_TEST_DEPTH + 1];
+    RK_U8 *canvas = mpp_malloc(RK_U8, LKH_TEST_CANVAS_W * LKH_TEST_HEIGHT);
+    RK_U8 *prev = mpp_malloc(RK_U8, LKH_TEST_WIDTH * LKH_TEST_HEIGHT);
+    H264eLkh lkh = NULL;
+    H264eLkhCfg cfg;
+    h264RateControl_s *rc_base = mpp_calloc(h264RateControl_s, 1);
+    h264RateControl_s *rc_lkh = mpp_calloc(h264RateControl_s, 1);
+    LkhTestStat stat_base;
+    LkhTestStat stat_lkh;
+    RK_S32 scene_len = 0;
+    RK_S32 scene_pos = 0;
+    RK_S32 dx = 0;
+    RK_S32 qp_delta_min = 0;
+    RK_S32 qp_delta_max = 0;
+    RK_S32 queued = 0;
+    RK_S32 frame, i;
+    RK_S64 time_wait = 0;
+
+    mpp_log("h264e_lookahead_test start\n");
+    mpp_debug |= MPP_DBG_TIMING;
+
+    memset(bufs, 0, sizeof(bufs));
+    memset(&stat_base, 0, sizeof(stat_base));
+    memset(&stat_lkh, 0, sizeof(stat_lkh));
+    stat_base.name = "past only";
+    stat_lkh.name  = "lookahead";
+
+    if (NULL == canvas || NULL == prev || NULL == rc_base || NULL == rc_lkh)
+        goto __RETURN;
+
+    if (mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL))
+        goto __RETURN;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.width       = LKH_TEST_WIDTH;
+    cfg.height      = LKH_TEST_HEIGHT;
+    cfg.hor_stride  = LKH_TEST_WIDTH;
+    cfg.depth       = LKH_TEST_DEPTH;
+    if (h264e_lkh_init(&lkh, &cfg))
+        goto __RETURN;
+
+    rc_setup(rc_base);
+    rc_setup(rc_lkh);
+
+    for (frame = 0; frame < LKH_TEST_FRAMES + LKH_TEST_DEPTH; frame++) {
+        if (frame < LKH_TEST_FRAMES) {
+            MppBuffer buf = NULL;
+            RK_U8 *dst;
+            RK_S32 flash = (test_rand() % 40) == 0;
+
+            /* new scene with random detail and pan speed */
+            if (scene_pos >= scene_len) {
+                gen_canvas(canvas, 4 + test_rand() % 60);
+                scene_len = 20 + test_rand() % 60;
+                scene_pos = 0;
+                dx = test_rand() % (LKH_TEST_PAN_MAX + 1);
+            }
+
+            if (mpp_buffer_get(group, &buf, LKH_TEST_WIDTH * LKH_TEST_HEIGHT * 3 / 2))
+                goto __RETURN;
+
+            dst = (RK_U8 *)mpp_buffer_get_ptr(buf);
+            for (i = 0; i < LKH_TEST_HEIGHT; i++) {
+                RK_U8 *src = canvas + i * LKH_TEST_CANVAS_W + scene_pos * dx;
+                RK_S32 x;
+
+                for (x = 0; x < LKH_TEST_WIDTH; x++) {
+                    RK_S32 v = src[x] + (RK_S32)(test_rand() & 3) - 1;
+
+                    if (flash)
+                        v += 80;
+                    dst[i * LKH_TEST_WIDTH + x] = (RK_U8)MPP_CLIP3(0, 255, v);
+                }
+            }
+
+            types[queued] = (frame % LKH_TEST_GOP) ? PSLICE : ISLICE;
+            costs[queued] = frame_cost(dst, (frame % LKH_TEST_GOP && scene_pos) ? prev : NULL, dx);
+            memcpy(prev, dst, LKH_TEST_WIDTH * LKH_TEST_HEIGHT);
+            scene_pos++;
+
+            if (h264e_lkh_put(lkh, buf)) {
+                mpp_buffer_put(buf);
+                goto __RETURN;
+            }
+            bufs[queued++] = buf;
+
+            /* encode the oldest frame when lookahead window is full */
+            if (queued <= LKH_TEST_DEPTH)
+                continue;
+        }
+
+        if (!queued)
+            break;
+
+        {
+            H264eLkhRet lkh_ret;
+            RK_S64 start = mpp_time();
+
+            if (h264e_lkh_get(lkh, &lkh_ret)) {
+                mpp_err("failed to get lookahead result at frame %d\n", frame);
+                goto __RETURN;
+            }
+            time_wait += mpp_time() - start;
+
+            if (lkh_ret.frames <= 0 || lkh_ret.frames > queued) {
+                mpp_err("lookahead window %d mismatch queued %d\n", lkh_ret.frames, queued);
+                goto __RETURN;
+            }
+
+            qp_delta_min = MPP_MIN(qp_delta_min, lkh_ret.qp_delta);
+            qp_delta_max = MPP_MAX(qp_delta_max, lkh_ret.qp_delta);
+
+            rc_lkh->lkhRc       = ENCHW_YES;
+            rc_lkh->lkhCplx     = MPP_MAX(lkh_ret.cplx_q8, 1);
+            rc_lkh->lkhBits     = lkh_ret.bits_q8;
+            rc_lkh->lkhQpDelta  = lkh_ret.qp_delta;
+        }
+
+        rc_frame(rc_base, &stat_base, costs[0], types[0]);
+        rc_frame(rc_lkh, &stat_lkh, costs[0], types[0]);
+
+        mpp_buffer_put(bufs[0]);
+        queued--;
+        for (i = 0; i < queued; i++) {
+            bufs[i] = bufs[i + 1];
+            costs[i] = costs[i + 1];
+            types[i] = types[i + 1];
+        }
+        bufs[queued] = NULL;
+    }
+
+    if (qp_delta_min < -H264E_LKH_QP_DELTA_MAX || qp_delta_max > H264E_LKH_QP_DELTA_MAX) {
+        mpp_err("qp delta out of range [%d, %d]\n", qp_delta_min, qp_delta_max);
+        goto __RETURN;
+    }
+
+    mpp_log("%dx%d frames %d depth %d bps %d gop %d, wait on lookahead %.3f us/frame\n",
+            LKH_TEST_WIDTH, LKH_TEST_HEIGHT, LKH_TEST_FRAMES, LKH_TEST_DEPTH,
+            LKH_TEST_BPS, LKH_TEST_GOP, (float)time_wait / LKH_TEST_FRAMES);
+    stat_show(&stat_base);
+    stat_show(&stat_lkh);
+
+    {
+        RK_S64 target = (RK_S64)LKH_TEST_BPS * LKH_TEST_FRAMES / LKH_TEST_FPS;
+        RK_S64 diff = stat_lkh.bits_total - target;
+
+        /* lookahead must keep the long term bitrate */
+        if (MPP_ABS(diff) * 10 > target) {
+            mpp_err("lookahead bitrate error too large\n");
+            goto __RETURN;
+        }
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    for (i = 0; i < LKH_TEST_DEPTH + 1; i++) {
+        if (bufs[i])
+            mpp_buffer_put(bufs[i]);
+    }
+    h264e_lkh_deinit(lkh);
+    if (group)
+        mpp_buffer_group_put(group);
+    MPP_FREE(canvas);
+    MPP_FREE(prev);
+    MPP_FREE(rc_base);
+    MPP_FREE(rc_lkh);
+    mpp_log("h264e_lookahead_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "h264e_roi_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+
+#include "mpp_enc_roi_utils.h"
+#include "h264_syntax.h"
+#include "hal_h264e.h"
+#include "hal_h264e_rkv.h"
+
+/*
+ * A static noisy background with a moving object goes through the motion
+ * map helper. The map and two regions are then converted to the rkv encoder
+ * macroblock config and checked.
+ */
+#define ROI_TEST_WIDTH          640
+#define ROI_TEST_HEIGHT         360
+#define ROI_TEST_MB_W           ((ROI_TEST_WIDTH + 15) / 16)
+#define ROI_TEST_MB_H           ((ROI_TEST_HEIGHT + 15) / 16)
+#define ROI_TEST_FRAMES         30
+#define ROI_TEST_OBJ_SIZE       48
+#define ROI_TEST_OBJ_STEP       4
+#define ROI_TEST_FG_DELTA       -2
+#define ROI_TEST_BG_DELTA       6
+#define ROI_TEST_PIC_QP         30
+
+static RK_U32 test_rand_seed = 1;
+
+static RK_U32 test_rand(void)
+{
+    test_rand_seed = test_rand_seed * 1103515245 + 12345;
+    return (test_rand_seed >> 16) & 0x7fff;
+}
+
+static void gen_frame(RK_U8 *dst, RK_U8 *bg, RK_S32 obj_x, RK_S32 obj_y)
+{
+    RK_S32 x, y;
+
+    for (y = 0; y < ROI_TEST_HEIGHT; y++) {
+        for (x = 0; x < ROI_TEST_WIDTH; x++) {
+            RK_S32 v = bg[y * ROI_TEST_WIDTH + x] + (RK_S32)(test_rand() % 5) - 2;
+
+            if (x >= obj_x && x < obj_x + ROI_TEST_OBJ_SIZE &&
+                y >= obj_y && y < obj_y + ROI_TEST_OBJ_SIZE)
+                v = 220 - ((x - obj_x) ^ (y - obj_y)) % 32;
+
+            dst[y * ROI_TEST_WIDTH + x] = (RK_U8)MPP_CLIP3(0, 255, v);
+        }
+    }
+}
+
+static MPP_RET test_motion_map(RK_S8 *qp_map)
+{
+    MPP_RET ret = MPP_NOK;
+    RK_U8 *bg = mpp_malloc(RK_U8, ROI_TEST_WIDTH * ROI_TEST_HEIGHT);
+    RK_U8 *frame = mpp_malloc(RK_U8, ROI_TEST_WIDTH * ROI_TEST_HEIGHT);
+    MppEncRoiMotion motion = NULL;
+    MppEncRoiMotionCfg cfg;
+    RK_S32 obj_x = 64;
+    RK_S32 obj_y = 128;
+    RK_S32 fg_cnt = 0;
+    RK_S32 frame_idx, x, y;
+
+    if (NULL == bg || NULL == frame)
+        goto __RETURN;
+
+    for (y = 0; y < ROI_TEST_HEIGHT; y++)
+        for (x = 0; x < ROI_TEST_WIDTH; x++)
+            bg[y * ROI_TEST_WIDTH + x] = (RK_U8)(40 + (x * 7 + y * 3) % 90);
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.width       = ROI_TEST_WIDTH;
+    cfg.height      = ROI_TEST_HEIGHT;
+    cfg.hor_stride  = ROI_TEST_WIDTH;
+    cfg.fg_qp_delta = ROI_TEST_FG_DELTA;
+    cfg.bg_qp_delta = ROI_TEST_BG_DELTA;
+    if (mpp_enc_roi_motion_init(&motion, &cfg))
+        goto __RETURN;
+
+    for (frame_idx = 0; frame_idx < ROI_TEST_FRAMES; frame_idx++) {
+        gen_frame(frame, bg, obj_x, obj_y);
+        mpp_enc_roi_motion_proc(motion, frame, qp_map);
+        obj_x += ROI_TEST_OBJ_STEP;
+    }
+    obj_x -= ROI_TEST_OBJ_STEP;
+
+    for (y = 0; y < ROI_TEST_MB_H; y++) {
+        for (x = 0; x < ROI_TEST_MB_W; x++) {
+            RK_S32 delta = qp_map[y * ROI_TEST_MB_W + x];
+            /* macroblock overlapped by the object on the last frame */
+            RK_S32 in_obj = (x * 16 + 16 > obj_x && x * 16 < obj_x + ROI_TEST_OBJ_SIZE &&
+                             y * 16 + 16 > obj_y && y * 16 < obj_y + ROI_TEST_OBJ_SIZE);
+            /* far from the object path, include the neighbour extension */
+            RK_S32 far = (y * 16 + 32 <= obj_y || y * 16 >= obj_y + ROI_TEST_OBJ_SIZE + 16 ||
+                          x * 16 >= obj_x + ROI_TEST_OBJ_SIZE + 16);
+
+            if (in_obj && delta != ROI_TEST_FG_DELTA) {
+                mpp_err("object mb (%d, %d) delta %d\n", x, y, delta);
+                goto __RETURN;
+            }
+            if (far && delta != ROI_TEST_BG_DELTA) {
+                mpp_err("background mb (%d, %d) delta %d\n", x, y, delta);
+                goto __RETURN;
+            }
+            fg_cnt += (delta == ROI_TEST_FG_DELTA);
+        }
+    }
+
+    mpp_log("motion map foreground %d of %d macroblocks\n",
+            fg_cnt, ROI_TEST_MB_W * ROI_TEST_MB_H);
+    ret = MPP_OK;
+__RETURN:
+    mpp_enc_roi_motion_deinit(motion);
+    MPP_FREE(bg);
+    MPP_FREE(frame);
+    return ret;
+}
+
+static MPP_RET test_hw_cfg(RK_S8 *qp_map)
+{
+    MPP_RET ret = MPP_NOK;
+    h264e_hal_rkv_roi_cfg *hw = mpp_calloc(h264e_hal_rkv_roi_cfg, ROI_TEST_MB_W * ROI_TEST_MB_H);
+    MppEncROIRegion regions[2];
+    MppEncROICfg roi;
+    RK_S32 x, y;
+
+    if (NULL == hw)
+        goto __RETURN;
+
+    /* absolute qp region over map and intra region keeping map qp */
+    memset(regions, 0, sizeof(regions));
+    regions[0].x = 8;
+    regions[0].y = 8;
+    regions[0].w = 32;
+    regions[0].h = 16;
+    regions[0].abs_qp_en = 1;
+    regions[0].qp = 20;
+    regions[1].x = 320;
+    regions[1].y = 160;
+    regions[1].w = 16;
+    regions[1].h = 16;
+    regions[1].intra = 1;
+
+    roi.qp_map  = qp_map;
+    roi.number  = MPP_ARRAY_ELEMS(regions);
+    roi.regions = regions;
+
+    if (hal_h264e_rkv_set_roi(hw, ROI_TEST_MB_W, ROI_TEST_MB_H, ROI_TEST_PIC_QP, &roi)) {
+        mpp_err("roi config is not converted\n");
+        goto __RETURN;
+    }
+
+    for (y = 0; y < ROI_TEST_MB_H; y++) {
+        for (x = 0; x < ROI_TEST_MB_W; x++) {
+            h264e_hal_rkv_roi_cfg *cfg = &hw[y * ROI_TEST_MB_W + x];
+            RK_S32 qp = ROI_TEST_PIC_QP + qp_map[y * ROI_TEST_MB_W + x];
+            RK_S32 intra = (x == 20 && y == 10);
+
+            /* 8 + 32 pixel spans macroblock 0 ~ 2, 8 + 16 spans 0 ~ 1 */
+            if (x <= 2 && y <= 1)
+                qp = 20;
+
+            if (!cfg->set_qp_y_en || cfg->qp_y != qp || cfg->forbid_inter != intra) {
+                mpp_err("mb (%d, %d) qp %d en %d intra %d expect qp %d intra %d\n",
+                        x, y, cfg->qp_y, cfg->set_qp_y_en, cfg->forbid_inter, qp, intra);
+                goto __RETURN;
+            }
+        }
+    }
+
+    /* empty config does not enable roi */
+    memset(qp_map, 0, ROI_TEST_MB_W * ROI_TEST_MB_H);
+    roi.number = 0;
+    if (MPP_OK == hal_h264e_rkv_set_roi(hw, ROI_TEST_MB_W, ROI_TEST_MB_H, ROI_TEST_PIC_QP, &roi)) {
+        mpp_err("empty roi config enables roi\n");
+        goto __RETURN;
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    MPP_FREE(hw);
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    RK_S8 *qp_map = mpp_calloc(RK_S8, ROI_TEST_MB_W * ROI_TEST_MB_H);
+
+    mpp_log("h264e_roi_test start\n");
+
+    if (qp_map) {
+        ret = test_motion_map(qp_map);
+        if (MPP_OK == ret)
+            ret = test_hw_cfg(qp_map);
+    }
+
+    MPP_FREE(qp_map);
+    mpp_log("h264e_roi_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
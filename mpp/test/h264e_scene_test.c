@@ -0,0 +1,337 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "h264e_scene_test"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_time.h"
+
+#include "H264Instance.h"
+#include "h264e_scene.h"
+
+/*
+ * usage: h264e_scene_test [input.yuv width height [gop_min gop_max]]
+ *
+ * With a yuv420p / yuv420sp input file the decision of each frame is printed.
+ * Without input a synthetic clip is generated with known scene cuts, fades,
+ * flashes and panning and the detection result is checked against it.
+ * Set h264e_debug=0x20 to log the measures of every frame.
+ */
+#define SCENE_TEST_WIDTH        640
+#define SCENE_TEST_HEIGHT       352
+#define SCENE_TEST_PAN_MAX      4
+#define SCENE_TEST_CANVAS_W     (SCENE_TEST_WIDTH + SCENE_TEST_PAN_MAX * 100)
+#define SCENE_TEST_GOP_MIN      10
+#define SCENE_TEST_GOP_MAX      90
+#define SCENE_TEST_FADE_LEN     16
+
+typedef enum SceneTestTrans_e {
+    TRANS_CUT,
+    TRANS_FADE,         /* fade out to black and fade in the next scene */
+} SceneTestTrans;
+
+typedef struct SceneTestShot_t {
+    RK_S32          len;
+    SceneTestTrans  trans;  /* how this shot starts */
+    RK_S32          flash;  /* frame index of a flash in shot, 0 for none */
+} SceneTestShot;
+
+static SceneTestShot test_shots[] = {
+    {  60, TRANS_CUT,   0,  },
+    {  45, TRANS_CUT,  20,  },
+    {  80, TRANS_FADE,  0,  },
+    {   5, TRANS_CUT,   0,  },  /* short shot, cut in it is under gop_min */
+    {  70, TRANS_CUT,   0,  },
+    { 120, TRANS_CUT,  50,  },  /* long shot, gop_max idr inside */
+    {  50, TRANS_FADE, 30,  },
+    {  40, TRANS_CUT,   0,  },
+};
+
+static RK_U32 test_rand_seed = 1;
+
+static RK_U32 test_rand(void)
+{
+    test_rand_seed = test_rand_seed * 1103515245 + 12345;
+    return (test_rand_seed >> 16) & 0x7fff;
+}
+
+static void gen_canvas(RK_U8 *canvas)
+{
+    RK_S32 base = 40 + test_rand() % 140;
+    RK_S32 grad_x = (RK_S32)(test_rand() % 81) - 40;
+    RK_S32 grad_y = (RK_S32)(test_rand() % 81) - 40;
+    RK_S32 detail = 4 + test_rand() % 50;
+    RK_S32 cell = 4 << (test_rand() % 3);
+    RK_S32 x, y;
+
+    for (y = 0; y < SCENE_TEST_HEIGHT; y++) {
+        for (x = 0; x < SCENE_TEST_CANVAS_W; x++) {
+            RK_S32 v = base + x * grad_x / SCENE_TEST_CANVAS_W + y * grad_y / SCENE_TEST_HEIGHT;
+
+            if (((x / cell) + (y / cell)) & 1)
+                v += detail;
+            v += (RK_S32)(test_rand() % (detail + 1)) - detail / 2;
+            canvas[y * SCENE_TEST_CANVAS_W + x] = (RK_U8)MPP_CLIP3(0, 255, v);
+        }
+    }
+}
+
+static void gen_frame(RK_U8 *dst, RK_U8 *canvas, RK_S32 pos, RK_S32 gain_q8, RK_S32 offset)
+{
+    RK_S32 x, y;
+
+    for (y = 0; y < SCENE_TEST_HEIGHT; y++) {
+        RK_U8 *src = canvas + y * SCENE_TEST_CANVAS_W + pos;
+
+        for (x = 0; x < SCENE_TEST_WIDTH; x++) {
+            RK_S32 v = src[x] + (RK_S32)(test_rand() & 3) - 1;
+
+            v = ((v * gain_q8) >> 8) + offset;
+            dst[y * SCENE_TEST_WIDTH + x] = (RK_U8)MPP_CLIP3(0, 255, v);
+        }
+    }
+}
+
+static MPP_RET test_synthetic(void)
+{
+    MPP_RET ret = MPP_NOK;
+    RK_U8 *canvas = mpp_malloc(RK_U8, SCENE_TEST_CANVAS_W * SCENE_TEST_HEIGHT);
+    RK_U8 *frame = mpp_malloc(RK_U8, SCENE_TEST_WIDTH * SCENE_TEST_HEIGHT);
+    H264eScene scene = NULL;
+    H264eSceneCfg cfg;
+    MppEncSceneCfg scene_cfg;
+    RK_S32 frame_cnt = 0;
+    RK_S32 dist = 0;
+    RK_S32 cut_expect = 0;
+    RK_S32 cut_hit = 0;
+    RK_S32 cut_false = 0;
+    RK_S32 fade_hit = 0;
+    RK_S32 fade_false = 0;
+    RK_S32 idr_cnt = 0;
+    RK_S32 gop_err = 0;
+    RK_S64 time_proc = 0;
+    RK_U32 i;
+
+    if (NULL == canvas || NULL == frame)
+        goto __RETURN;
+
+    cfg.width       = SCENE_TEST_WIDTH;
+    cfg.height      = SCENE_TEST_HEIGHT;
+    cfg.hor_stride  = SCENE_TEST_WIDTH;
+    if (h264e_scene_init(&scene, &cfg))
+        goto __RETURN;
+
+    scene_cfg.enable        = 1;
+    scene_cfg.gop_min       = SCENE_TEST_GOP_MIN;
+    scene_cfg.gop_max       = SCENE_TEST_GOP_MAX;
+    scene_cfg.sensitivity   = 0;
+    h264e_scene_set_cfg(scene, &scene_cfg);
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(test_shots); i++) {
+        SceneTestShot *shot = &test_shots[i];
+        RK_S32 dx = test_rand() % (SCENE_TEST_PAN_MAX + 1);
+        RK_S32 fade = (i && shot->trans == TRANS_FADE) ? SCENE_TEST_FADE_LEN : 0;
+        RK_S32 pos;
+
+        /* fade out the previous shot on the last canvas */
+        for (pos = 0; pos < fade; pos++) {
+            H264eSceneRet scene_ret;
+            RK_S32 gain = 256 * (fade - 1 - pos) / fade;
+            RK_S64 start;
+
+            gen_frame(frame, canvas, 0, gain, 0);
+            start = mpp_time();
+            h264e_scene_proc(scene, frame, dist, &scene_ret);
+            time_proc += mpp_time() - start;
+
+            cut_false += scene_ret.scene == MPP_ENC_SCENE_CUT;
+            fade_hit += scene_ret.scene == MPP_ENC_SCENE_FADE;
+            if (scene_ret.idr) {
+                if (dist > SCENE_TEST_GOP_MAX)
+                    gop_err++;
+                idr_cnt++;
+                dist = 0;
+            }
+            dist++;
+            frame_cnt++;
+        }
+
+        gen_canvas(canvas);
+
+        for (pos = 0; pos < shot->len; pos++) {
+            H264eSceneRet scene_ret;
+            RK_S32 gain = 256;
+            RK_S32 offset = 0;
+            RK_S32 is_cut = (i && pos == 0 && shot->trans == TRANS_CUT);
+            RK_S32 in_fade = (pos < fade);
+            RK_S64 start;
+
+            if (in_fade)
+                gain = 256 * (pos + 1) / fade;
+            if (shot->flash && pos == shot->flash)
+                offset = 80;
+
+            gen_frame(frame, canvas, pos * dx, gain, offset);
+            start = mpp_time();
+            h264e_scene_proc(scene, frame, dist, &scene_ret);
+            time_proc += mpp_time() - start;
+
+            if (is_cut) {
+                cut_expect++;
+                cut_hit += scene_ret.scene == MPP_ENC_SCENE_CUT;
+            } else {
+                cut_false += scene_ret.scene == MPP_ENC_SCENE_CUT;
+                if (in_fade)
+                    fade_hit += scene_ret.scene == MPP_ENC_SCENE_FADE;
+                else
+                    fade_false += scene_ret.scene == MPP_ENC_SCENE_FADE;
+            }
+
+            if (scene_ret.scene == MPP_ENC_SCENE_CUT)
+                mpp_log("frame %4d scene cut dist %3d idr %d hist %3d sad %4d\n",
+                        frame_cnt, dist, scene_ret.idr, scene_ret.hist_diff, scene_ret.sad);
+
+            /* first frame is always idr in encoder */
+            if (scene_ret.idr || frame_cnt == 0) {
+                if (frame_cnt && dist > SCENE_TEST_GOP_MAX)
+                    gop_err++;
+                if (frame_cnt && scene_ret.scene == MPP_ENC_SCENE_CUT &&
+                    dist < SCENE_TEST_GOP_MIN)
+                    gop_err++;
+                idr_cnt++;
+                dist = 0;
+            }
+            dist++;
+            frame_cnt++;
+        }
+    }
+
+    mpp_log("frames %d cut %d/%d false cut %d fade frames %d false fade %d idr %d\n",
+            frame_cnt, cut_hit, cut_expect, cut_false, fade_hit, fade_false, idr_cnt);
+    mpp_log("analysis %.3f ms/frame at %dx%d\n",
+            (float)time_proc / 1000 / frame_cnt, SCENE_TEST_WIDTH, SCENE_TEST_HEIGHT);
+
+    if (cut_hit != cut_expect || cut_false || gop_err ||
+        fade_hit < SCENE_TEST_FADE_LEN || fade_false > 2) {
+        mpp_err("scene detection mismatch gop error %d\n", gop_err);
+        goto __RETURN;
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    h264e_scene_deinit(scene);
+    MPP_FREE(canvas);
+    MPP_FREE(frame);
+    return ret;
+}
+
+static MPP_RET test_file(const char *name, RK_S32 width, RK_S32 height,
+                         RK_S32 gop_min, RK_S32 gop_max)
+{
+    MPP_RET ret = MPP_NOK;
+    FILE *fp = fopen(name, "rb");
+    RK_S32 size = width * height * 3 / 2;
+    RK_U8 *frame = mpp_malloc(RK_U8, size);
+    H264eScene scene = NULL;
+    H264eSceneCfg cfg;
+    MppEncSceneCfg scene_cfg;
+    RK_S32 frame_cnt = 0;
+    RK_S32 cut_cnt = 0;
+    RK_S32 fade_cnt = 0;
+    RK_S32 idr_cnt = 0;
+    RK_S32 dist = 0;
+
+    if (NULL == fp || NULL == frame) {
+        mpp_err("failed to open input file %s\n", name);
+        goto __RETURN;
+    }
+
+    cfg.width       = width;
+    cfg.height      = height;
+    cfg.hor_stride  = width;
+    if (h264e_scene_init(&scene, &cfg))
+        goto __RETURN;
+
+    scene_cfg.enable        = 1;
+    scene_cfg.gop_min       = gop_min;
+    scene_cfg.gop_max       = gop_max;
+    scene_cfg.sensitivity   = 0;
+    h264e_scene_set_cfg(scene, &scene_cfg);
+
+    while (fread(frame, 1, size, fp) == (size_t)size) {
+        H264eSceneRet scene_ret;
+
+        h264e_scene_proc(scene, frame, dist, &scene_ret);
+
+        if (scene_ret.idr || frame_cnt == 0) {
+            idr_cnt++;
+            dist = 0;
+        }
+        if (scene_ret.scene == MPP_ENC_SCENE_CUT)
+            cut_cnt++;
+        if (scene_ret.scene == MPP_ENC_SCENE_FADE)
+            fade_cnt++;
+
+        if (scene_ret.scene != MPP_ENC_SCENE_NORMAL || scene_ret.idr)
+            mpp_log("frame %5d %s idr %d hist %3d sad %4d mean %4d\n", frame_cnt,
+                    (scene_ret.scene == MPP_ENC_SCENE_CUT) ? "cut " :
+                    (scene_ret.scene == MPP_ENC_SCENE_FADE) ? "fade" : "    ",
+                    scene_ret.idr, scene_ret.hist_diff, scene_ret.sad,
+                    scene_ret.luma_mean);
+        dist++;
+        frame_cnt++;
+    }
+
+    mpp_log("frames %d scene cut %d fade frames %d idr %d\n",
+            frame_cnt, cut_cnt, fade_cnt, idr_cnt);
+    ret = MPP_OK;
+__RETURN:
+    h264e_scene_deinit(scene);
+    MPP_FREE(frame);
+    if (fp)
+        fclose(fp);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    MPP_RET ret = MPP_NOK;
+
+    mpp_log("h264e_scene_test start\n");
+    mpp_debug |= MPP_DBG_TIMING;
+    mpp_env_get_u32("h264e_debug", &h264e_debug, 0);
+
+    if (argc >= 4) {
+        RK_S32 gop_min = (argc > 4) ? atoi(argv[4]) : SCENE_TEST_GOP_MIN;
+        RK_S32 gop_max = (argc > 5) ? atoi(argv[5]) : SCENE_TEST_GOP_MAX;
+
+        ret = test_file(argv[1], atoi(argv[2]), atoi(argv[3]), gop_min, gop_max);
+    } else if (argc == 1) {
+        ret = test_synthetic();
+    } else {
+        mpp_log("usage: %s [input.yuv width height [gop_min gop_max]]\n", argv[0]);
+    }
+
+    mpp_log("h264e_scene_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
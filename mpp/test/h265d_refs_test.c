@@ -0,0 +1,176 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "h265d_refs_test"
+
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "h265d_parser.h"
+
+/*
+ * h265 decoder dpb / rps benchmark
+ *
+ * Runs the parser reference handling of each picture, new reference
+ * allocation and rps application, on a low delay stream with four short
+ * term references and one long term reference kept from the first picture.
+ * The output and hal release are done right after rps as mpp_dec does.
+ */
+#define REFS_PIC_COUNT          20000
+#define REFS_SHORT_COUNT        4
+#define REFS_SLOT_COUNT         (MAX_DPB_SIZE + 2)
+
+static MPP_RET check_rps(HEVCContext *s, RK_S32 short_count)
+{
+    RefPicList *bef = &s->rps[ST_CURR_BEF];
+    RefPicList *lt = &s->rps[LT_CURR];
+    RK_S32 i;
+
+    if (bef->nb_refs != short_count) {
+        mpp_err("poc %d short term refs %d expect %d\n", s->poc, bef->nb_refs, short_count);
+        return MPP_NOK;
+    }
+
+    for (i = 0; i < short_count; i++) {
+        if (bef->list[i] != s->poc - i - 1 || bef->ref[i]->poc != s->poc - i - 1) {
+            mpp_err("poc %d ref %d poc %d\n", s->poc, i, bef->list[i]);
+            return MPP_NOK;
+        }
+        if (!(bef->ref[i]->flags & HEVC_FRAME_FLAG_SHORT_REF))
+            return MPP_NOK;
+    }
+
+    if (s->poc > REFS_SHORT_COUNT) {
+        if (lt->nb_refs != 1 || lt->ref[0]->poc != 0 ||
+            !(lt->ref[0]->flags & HEVC_FRAME_FLAG_LONG_REF)) {
+            mpp_err("poc %d long term ref missing\n", s->poc);
+            return MPP_NOK;
+        }
+    }
+
+    return MPP_OK;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    HEVCContext *s = NULL;
+    H265dContext_t *ctx = NULL;
+    HEVCSPS *sps = NULL;
+    HalDecTask task;
+    ShortTermRPS short_rps[REFS_SHORT_COUNT + 1];
+    RK_S64 time_ns = 0;
+    RK_S32 used = 0;
+    RK_S32 i, j;
+
+    mpp_log("h265d_refs_test start\n");
+
+    s = mpp_calloc(HEVCContext, 1);
+    ctx = mpp_calloc(H265dContext_t, 1);
+    sps = mpp_calloc(HEVCSPS, 1);
+    if (!s || !ctx || !sps)
+        goto __RETURN;
+
+    ctx->width = ctx->coded_width = 1920;
+    ctx->height = ctx->coded_height = 1088;
+    ctx->nBitDepth = 8;
+    ctx->pix_fmt = MPP_FMT_YUV420SP;
+    sps->log2_max_poc_lsb = 16;
+    sps->ctb_width = 30;
+    sps->ctb_height = 17;
+
+    s->h265dctx = ctx;
+    s->sps = sps;
+    s->nb_nals = 1;
+    s->task = &task;
+    for (i = 0; i < MAX_DPB_SIZE; i++) {
+        s->DPB[i].slot_index = 0xff;
+        s->DPB[i].poc = INT_MAX;
+        mpp_frame_init(&s->DPB[i].frame);
+    }
+
+    if (mpp_buf_slot_init(&s->slots))
+        goto __RETURN;
+    mpp_buf_slot_setup(s->slots, REFS_SLOT_COUNT);
+
+    memset(short_rps, 0, sizeof(short_rps));
+    for (i = 0; i <= REFS_SHORT_COUNT; i++) {
+        short_rps[i].num_negative_pics = i;
+        short_rps[i].num_delta_pocs = i;
+        for (j = 0; j < i; j++) {
+            short_rps[i].delta_poc[j] = -j - 1;
+            short_rps[i].used[j] = 1;
+        }
+    }
+
+    for (i = 0; i < REFS_PIC_COUNT; i++) {
+        RK_S32 short_count = MPP_MIN(i, REFS_SHORT_COUNT);
+        RK_S64 start;
+
+        s->poc = i;
+        s->sh.short_term_rps = &short_rps[short_count];
+        /* the first picture is kept as long term once out of short term window */
+        s->sh.long_term_rps.nb_refs = (i > REFS_SHORT_COUNT) ? 1 : 0;
+        s->sh.long_term_rps.poc[0] = 0;
+        s->sh.long_term_rps.used[0] = 1;
+
+        memset(&task, 0, sizeof(task));
+        start = mpp_time_ns();
+        if (mpp_hevc_set_new_ref(s, &s->frame, s->poc) ||
+            mpp_hevc_frame_rps(s)) {
+            mpp_err("poc %d reference handling failed\n", s->poc);
+            goto __RETURN;
+        }
+        time_ns += mpp_time_ns() - start;
+
+        if (check_rps(s, short_count))
+            goto __RETURN;
+
+        /* hal done and the picture is output at once */
+        mpp_buf_slot_clr_flag(s->slots, s->ref->slot_index, SLOT_HAL_OUTPUT);
+        mpp_hevc_unref_frame(s, s->ref, HEVC_FRAME_FLAG_OUTPUT);
+    }
+
+    for (i = 0; i < MAX_DPB_SIZE; i++) {
+        if (s->DPB[i].slot_index != 0xff)
+            used++;
+    }
+    /* current picture, short term window and the long term picture */
+    if (used != REFS_SHORT_COUNT + 2) {
+        mpp_err("dpb holds %d pictures expect %d\n", used, REFS_SHORT_COUNT + 2);
+        goto __RETURN;
+    }
+
+    mpp_log("pictures %d dpb %d refs %d rps %.1f ns per picture\n", REFS_PIC_COUNT,
+            MAX_DPB_SIZE, REFS_SHORT_COUNT + 1, (float)time_ns / REFS_PIC_COUNT);
+
+    ret = MPP_OK;
+__RETURN:
+    if (s) {
+        for (i = 0; i < MAX_DPB_SIZE; i++) {
+            mpp_hevc_unref_frame(s, &s->DPB[i], ~0);
+            mpp_frame_deinit(&s->DPB[i].frame);
+        }
+        if (s->slots)
+            mpp_buf_slot_deinit(s->slots);
+    }
+    MPP_FREE(sps);
+    MPP_FREE(ctx);
+    MPP_FREE(s);
+
+    mpp_log("h265d_refs_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,310 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "h265d_sei_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_meta.h"
+#include "mpp_frame_impl.h"
+#include "h265d_parser.h"
+
+/*
+ * h265 decoder selective sei parsing test and benchmark
+ *
+ * Each picture carries a broadcast like prefix sei with closed caption user
+ * data, unregistered user data, hdr mastering display and content light
+ * level plus a recovery point, and a suffix sei with md5 picture hash. The
+ * sei rbsp goes through the parser with different subscription masks. The
+ * exported records are checked against the payloads before emulation
+ * prevention and read back from the frame meta.
+ */
+#define SEI_PIC_COUNT           20000
+#define SEI_NAL_MAX_SIZE        512
+#define SEI_MSG_COUNT           5
+
+typedef struct SeiMsg_t {
+    RK_U32  type;
+    RK_U32  size;
+    RK_U8   data[128];
+} SeiMsg;
+
+typedef struct SeiNal_t {
+    RK_U8   buf[SEI_NAL_MAX_SIZE];
+    RK_S32  len;
+} SeiNal;
+
+static SeiMsg prefix_msgs[SEI_MSG_COUNT];
+static SeiMsg suffix_msg;
+
+static void init_msgs(void)
+{
+    SeiMsg *msg = prefix_msgs;
+    RK_U32 i;
+
+    /* ATSC A/53 closed caption, cc_data with zero runs needs escaping */
+    msg->type = 4;
+    msg->size = 96;
+    msg->data[0] = 0xb5;
+    msg->data[1] = 0x00;
+    msg->data[2] = 0x31;
+    memcpy(&msg->data[3], "GA94", 4);
+    msg->data[7] = 0x03;
+    for (i = 8; i < msg->size; i++)
+        msg->data[i] = (i % 3) ? 0x00 : (RK_U8)i;
+    msg++;
+
+    /* x265 style unregistered user data */
+    msg->type = 5;
+    msg->size = 40;
+    for (i = 0; i < msg->size; i++)
+        msg->data[i] = (RK_U8)(0x30 + i);
+    msg++;
+
+    /* mastering display colour volume */
+    msg->type = 137;
+    msg->size = 24;
+    for (i = 0; i < msg->size; i++)
+        msg->data[i] = (RK_U8)(i * 11);
+    msg++;
+
+    /* content light level */
+    msg->type = 144;
+    msg->size = 4;
+    msg->data[0] = 0x03;
+    msg->data[1] = 0xe8;
+    msg->data[2] = 0x01;
+    msg->data[3] = 0x90;
+    msg++;
+
+    /* recovery point */
+    msg->type = 6;
+    msg->size = 1;
+    msg->data[0] = 0x84;
+
+    /* decoded picture md5 hash of three planes */
+    suffix_msg.type = 132;
+    suffix_msg.size = 49;
+    for (i = 1; i < suffix_msg.size; i++)
+        suffix_msg.data[i] = (RK_U8)(i * 37);
+}
+
+/* sei rbsp after nal header with emulation prevention */
+static void write_sei(SeiNal *nal, SeiMsg *msgs, RK_S32 count)
+{
+    RK_U8 rbsp[SEI_NAL_MAX_SIZE];
+    RK_S32 len = 0;
+    RK_S32 zeros = 0;
+    RK_S32 i;
+
+    for (i = 0; i < count; i++) {
+        rbsp[len++] = (RK_U8)msgs[i].type;
+        if (msgs[i].type >= 255) {
+            rbsp[len - 1] = 0xff;
+            rbsp[len++] = (RK_U8)(msgs[i].type - 255);
+        }
+        rbsp[len++] = (RK_U8)msgs[i].size;
+        memcpy(&rbsp[len], msgs[i].data, msgs[i].size);
+        len += msgs[i].size;
+    }
+    rbsp[len++] = 0x80;
+
+    nal->len = 0;
+    for (i = 0; i < len; i++) {
+        if (zeros == 2 && rbsp[i] <= 3) {
+            nal->buf[nal->len++] = 3;
+            zeros = 0;
+        }
+        zeros = rbsp[i] ? 0 : zeros + 1;
+        nal->buf[nal->len++] = rbsp[i];
+    }
+}
+
+static RK_S32 decode_sei(HEVCContext *s, SeiNal *nal, RK_S32 nal_type)
+{
+    s->nal_unit_type = nal_type;
+    mpp_set_bitread_ctx(&s->HEVClc->gb, nal->buf, nal->len);
+    mpp_set_pre_detection(&s->HEVClc->gb);
+
+    return mpp_hevc_decode_nal_sei(s);
+}
+
+/* walk MppDecSeiHead records and compare with the subscribed messages */
+static MPP_RET check_records(RK_U8 *buf, RK_U32 len, RK_U32 mask)
+{
+    RK_U32 pos = 0;
+    RK_S32 i;
+
+    for (i = 0; i < SEI_MSG_COUNT; i++) {
+        SeiMsg *msg = &prefix_msgs[i];
+        MppDecSeiHead *head = (MppDecSeiHead *)(buf + pos);
+        RK_U32 bit = 0;
+
+        switch (msg->type) {
+        case 4 : bit = MPP_DEC_SEI_USER_DATA_REG; break;
+        case 5 : bit = MPP_DEC_SEI_USER_DATA_UNREG; break;
+        case 137 : bit = MPP_DEC_SEI_MASTERING_DISPLAY; break;
+        case 144 : bit = MPP_DEC_SEI_CONTENT_LIGHT; break;
+        default : break;
+        }
+        if (!(mask & bit))
+            continue;
+
+        if (pos + sizeof(*head) > len || head->payload_type != msg->type ||
+            head->payload_size != msg->size ||
+            memcmp(head + 1, msg->data, msg->size)) {
+            mpp_err("sei type %d record mismatch at %d\n", msg->type, pos);
+            return MPP_NOK;
+        }
+        pos += sizeof(*head) + MPP_ALIGN(msg->size, 4);
+    }
+
+    if (pos != len) {
+        mpp_err("sei records length %d expect %d\n", len, pos);
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET check_frame(HEVCContext *s, SeiNal *prefix, RK_U32 mask)
+{
+    MPP_RET ret = MPP_NOK;
+    MppFrame frame = NULL;
+    MppMeta meta = NULL;
+    MppPacket packet = NULL;
+
+    mpp_frame_init(&frame);
+    mpp_dec_sei_set(&s->sei, mask);
+    mpp_dec_sei_clear(&s->sei);
+
+    if (decode_sei(s, prefix, NAL_SEI_PREFIX) < 0)
+        goto __RETURN;
+
+    mpp_dec_sei_attach(&s->sei, frame, 0);
+    meta = mpp_frame_get_meta(frame);
+
+    if (!mask) {
+        ret = meta ? MPP_NOK : MPP_OK;
+        goto __RETURN;
+    }
+
+    if (NULL == meta || mpp_meta_get_packet(meta, MPP_META_KEY_OUTPUT_SEI, &packet)) {
+        mpp_err("mask %x no sei on frame\n", mask);
+        goto __RETURN;
+    }
+
+    ret = check_records((RK_U8 *)mpp_packet_get_data(packet),
+                        (RK_U32)mpp_packet_get_length(packet), mask);
+__RETURN:
+    mpp_frame_deinit(&frame);
+    return ret;
+}
+
+static float run_sei(HEVCContext *s, SeiNal *prefix, SeiNal *suffix, RK_U32 mask)
+{
+    MppFrame frame = NULL;
+    RK_S64 time_ns = 0;
+    RK_S32 i;
+
+    mpp_dec_sei_set(&s->sei, mask);
+
+    for (i = 0; i < SEI_PIC_COUNT; i++) {
+        RK_S64 start;
+
+        mpp_frame_init(&frame);
+        start = mpp_time_ns();
+        mpp_dec_sei_clear(&s->sei);
+        decode_sei(s, prefix, NAL_SEI_PREFIX);
+        decode_sei(s, suffix, NAL_SEI_SUFFIX);
+        mpp_dec_sei_attach(&s->sei, frame, 0);
+        time_ns += mpp_time_ns() - start;
+        mpp_frame_deinit(&frame);
+    }
+
+    return (float)time_ns / SEI_PIC_COUNT;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    HEVCContext *s = NULL;
+    H265dContext_t *ctx = NULL;
+    SeiNal *prefix = NULL;
+    SeiNal *suffix = NULL;
+    RK_U32 masks[] = {
+        0,
+        MPP_DEC_SEI_USER_DATA_REG,
+        MPP_DEC_SEI_MASTERING_DISPLAY | MPP_DEC_SEI_CONTENT_LIGHT,
+        MPP_DEC_SEI_ALL,
+    };
+    RK_U32 i;
+
+    mpp_log("h265d_sei_test start\n");
+
+    s = mpp_calloc(HEVCContext, 1);
+    ctx = mpp_calloc(H265dContext_t, 1);
+    prefix = mpp_calloc(SeiNal, 1);
+    suffix = mpp_calloc(SeiNal, 1);
+    if (!s || !ctx || !prefix || !suffix)
+        goto __RETURN;
+
+    s->HEVClc = mpp_calloc(HEVCLocalContext, 1);
+    if (NULL == s->HEVClc)
+        goto __RETURN;
+
+    s->h265dctx = ctx;
+    mpp_dec_sei_init(&s->sei);
+
+    init_msgs();
+    write_sei(prefix, prefix_msgs, SEI_MSG_COUNT);
+    write_sei(suffix, &suffix_msg, 1);
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(masks); i++) {
+        if (check_frame(s, prefix, masks[i])) {
+            mpp_err("sei mask %x check failed\n", masks[i]);
+            goto __RETURN;
+        }
+    }
+
+    if (MPP_OK == mpp_dec_sei_set(&s->sei, MPP_DEC_SEI_ALL + 1)) {
+        mpp_err("invalid sei mask accepted\n");
+        goto __RETURN;
+    }
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(masks); i++) {
+        float ns = run_sei(s, prefix, suffix, masks[i]);
+
+        mpp_log("sei mask %x prefix %d bytes suffix %d bytes %.1f ns per picture\n",
+                masks[i], prefix->len, suffix->len, ns);
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    if (s) {
+        mpp_dec_sei_deinit(&s->sei);
+        MPP_FREE(s->HEVClc);
+    }
+    MPP_FREE(suffix);
+    MPP_FREE(prefix);
+    MPP_FREE(ctx);
+    MPP_FREE(s);
+
+    mpp_log("h265d_sei_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
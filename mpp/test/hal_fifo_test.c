@@ -0,0 +1,147 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_fifo_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_bitput.h"
+#include "hal_h264d_fifo.h"
+
+#define FIFO_TEST_LOOP          1000
+#define FIFO_TEST_FIELDS        256
+#define FIFO_TEST_WORDS         (FIFO_TEST_FIELDS + 8)
+
+static RK_U32 test_rand_seed = 1;
+
+static RK_U32 test_rand(void)
+{
+    test_rand_seed = test_rand_seed * 1103515245 + 12345;
+    return (test_rand_seed >> 16) & 0x7fff;
+}
+
+static RK_U64 test_rand64(void)
+{
+    return ((RK_U64)test_rand() << 60) | ((RK_U64)test_rand() << 45) |
+           ((RK_U64)test_rand() << 30) | ((RK_U64)test_rand() << 15) |
+           test_rand();
+}
+
+/*
+ * pack the same random layout with the per field writer and the table
+ * writer and compare. The layout is split in sections with the align calls
+ * used between the sps / pps / rps sections in the hal.
+ */
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    FifoField_t fields[FIFO_TEST_FIELDS];
+    RK_U8 bits[FIFO_TEST_FIELDS];
+    RK_U64 vals[FIFO_TEST_FIELDS];
+    RK_U64 *buf0 = mpp_calloc(RK_U64, FIFO_TEST_WORDS);
+    RK_U64 *buf1 = mpp_calloc(RK_U64, FIFO_TEST_WORDS);
+    RK_S64 time_bits = 0;
+    RK_S64 time_fields = 0;
+    RK_U32 loop, i;
+
+    mpp_log("hal_fifo_test start\n");
+    mpp_debug |= MPP_DBG_TIMING;
+    if (NULL == buf0 || NULL == buf1)
+        goto __RETURN;
+
+    for (loop = 0; loop < FIFO_TEST_LOOP; loop++) {
+        RK_U32 count = 1 + test_rand() % FIFO_TEST_FIELDS;
+        RK_U32 split = test_rand() % count;
+        RK_U8 align = (test_rand() & 1) ? 32 : 64;
+        FifoCtx_t pkt0;
+        FifoCtx_t pkt1;
+        BitputCtx_t bp0;
+        BitputCtx_t bp1;
+        RK_S64 start;
+
+        for (i = 0; i < count; i++) {
+            bits[i] = 1 + test_rand() % 32;
+            vals[i] = test_rand64();
+            fields[i].bits = bits[i];
+            fields[i].name = "test";
+        }
+
+        /* h264d fifo writer */
+        memset(&pkt0, 0, sizeof(pkt0));
+        memset(&pkt1, 0, sizeof(pkt1));
+        memset(buf0, 0, sizeof(RK_U64) * FIFO_TEST_WORDS);
+        memset(buf1, 0, sizeof(RK_U64) * FIFO_TEST_WORDS);
+        fifo_packet_init(&pkt0, buf0, FIFO_TEST_WORDS * 8);
+        fifo_packet_init(&pkt1, buf1, FIFO_TEST_WORDS * 8);
+
+        start = mpp_time();
+        for (i = 0; i < split; i++)
+            fifo_write_bits(&pkt0, vals[i], bits[i], fields[i].name);
+        fifo_align_bits(&pkt0, align);
+        for (; i < count; i++)
+            fifo_write_bits(&pkt0, vals[i], bits[i], fields[i].name);
+        fifo_align_bits(&pkt0, 64);
+        time_bits += mpp_time() - start;
+
+        start = mpp_time();
+        fifo_write_fields(&pkt1, fields, vals, split);
+        fifo_align_bits(&pkt1, align);
+        fifo_write_fields(&pkt1, fields + split, vals + split, count - split);
+        fifo_align_bits(&pkt1, 64);
+        time_fields += mpp_time() - start;
+
+        if (pkt0.index != pkt1.index || pkt0.bitpos != pkt1.bitpos ||
+            memcmp(buf0, buf1, sizeof(RK_U64) * FIFO_TEST_WORDS)) {
+            mpp_err("fifo mismatch at loop %d count %d split %d\n", loop, count, split);
+            goto __RETURN;
+        }
+
+        /* mpp bitput writer used by h265d */
+        memset(buf0, 0, sizeof(RK_U64) * FIFO_TEST_WORDS);
+        memset(buf1, 0, sizeof(RK_U64) * FIFO_TEST_WORDS);
+        mpp_set_bitput_ctx(&bp0, buf0, FIFO_TEST_WORDS - 1);
+        mpp_set_bitput_ctx(&bp1, buf1, FIFO_TEST_WORDS - 1);
+        for (i = 0; i < split; i++)
+            mpp_put_bits(&bp0, vals[i], bits[i]);
+        mpp_put_align(&bp0, align, 0xf);
+        for (; i < count; i++)
+            mpp_put_bits(&bp0, vals[i], bits[i]);
+        mpp_put_align(&bp0, 64, 0xf);
+
+        mpp_put_fields(&bp1, bits, vals, split);
+        mpp_put_align(&bp1, align, 0xf);
+        mpp_put_fields(&bp1, bits + split, vals + split, count - split);
+        mpp_put_align(&bp1, 64, 0xf);
+
+        if (bp0.index != bp1.index || bp0.bitpos != bp1.bitpos ||
+            memcmp(buf0, buf1, sizeof(RK_U64) * FIFO_TEST_WORDS)) {
+            mpp_err("bitput mismatch at loop %d count %d split %d\n", loop, count, split);
+            goto __RETURN;
+        }
+    }
+
+    mpp_log("fifo write bits %.3f us/loop write fields %.3f us/loop\n",
+            (float)time_bits / FIFO_TEST_LOOP, (float)time_fields / FIFO_TEST_LOOP);
+    ret = MPP_OK;
+__RETURN:
+    MPP_FREE(buf0);
+    MPP_FREE(buf1);
+    mpp_log("hal_fifo_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,298 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_regdrv_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_time.h"
+#include "hal_regdrv.h"
+#include "hal_h264d_vdpu_pkt.h"
+
+#define REGDRV_TEST_FRAMES      2000
+#define REGDRV_VDPU_FRAMES      200000
+#define REGDRV_VDPU_PATTERNS    64
+#define REGDRV_VDPU_REFS        4
+
+/*
+ * register word count follows the hardware register set size sent by each
+ * hal, fields are laid out pseudo randomly with 1 ~ 16 bit width. Like the
+ * real hal most words are stream level config and only every fourth word
+ * carries per frame info like address / poc / ref list which changes on half
+ * of its fields
+ */
+typedef struct RegDrvTestCfg_t {
+    const char  *name;
+    RK_U32      reg_size;
+} RegDrvTestCfg;
+
+static RegDrvTestCfg test_cfgs[] = {
+    { "h264d vdpu", 159, },
+    { "h265d rkv",   78, },
+    { "vp9d rkv",    78, },
+};
+
+static RK_U32 test_rand_seed = 1;
+
+static RK_U32 test_rand(void)
+{
+    test_rand_seed = test_rand_seed * 1103515245 + 12345;
+    return (test_rand_seed >> 16) & 0x7fff;
+}
+
+static RK_U32 build_table(HalRegDrv_t *emt, RK_U32 reg_size)
+{
+    RK_U32 count = 0;
+    RK_U32 i;
+
+    for (i = 0; i < reg_size; i++) {
+        RK_U32 pos = 0;
+
+        while (pos < 32) {
+            RK_U32 len = 1 + test_rand() % 16;
+
+            len = MPP_MIN(len, 32 - pos);
+
+            emt[count].syn_id = count;
+            emt[count].reg_id = i;
+            emt[count].bitpos = pos;
+            emt[count].bitlen = len;
+            emt[count].name   = NULL;
+            count++;
+            pos += len;
+        }
+    }
+
+    return count;
+}
+
+static MPP_RET test_one(RegDrvTestCfg *cfg)
+{
+    MPP_RET ret = MPP_NOK;
+    HalRegDrv_t *emt = mpp_calloc(HalRegDrv_t, cfg->reg_size * 32);
+    RK_U32 *vals = mpp_calloc(RK_U32, cfg->reg_size * 32);
+    RK_U32 *reg0 = mpp_calloc(RK_U32, cfg->reg_size);
+    RK_U32 *reg1 = mpp_calloc(RK_U32, cfg->reg_size);
+    HalRegDrvCtx_t ctx0;
+    HalRegDrvCtx_t ctx1;
+    RK_S64 time_field = 0;
+    RK_S64 time_prog = 0;
+    RK_U32 dirty_total = 0;
+    RK_U32 emt_size = 0;
+    RK_U32 frame, i;
+
+    memset(&ctx0, 0, sizeof(ctx0));
+    memset(&ctx1, 0, sizeof(ctx1));
+    if (NULL == emt || NULL == vals || NULL == reg0 || NULL == reg1)
+        goto __RETURN;
+
+    emt_size = build_table(emt, cfg->reg_size);
+    ctx0.reg_size = cfg->reg_size;
+    ctx0.p_reg    = reg0;
+    ctx0.emt_size = emt_size;
+    ctx0.p_emt    = emt;
+    ctx1 = ctx0;
+    ctx1.p_reg    = reg1;
+
+    if (hal_regdrv_prog_init(&ctx1))
+        goto __RETURN;
+
+    for (i = 0; i < emt_size; i++)
+        vals[i] = test_rand();
+
+    for (frame = 0; frame < REGDRV_TEST_FRAMES; frame++) {
+        RK_S64 start, end;
+
+        for (i = 0; i < emt_size; i++) {
+            if ((emt[i].reg_id & 3) == 0 && (test_rand() & 1))
+                vals[i] = test_rand() | (test_rand() << 15);
+        }
+
+        start = mpp_time_us();
+        for (i = 0; i < emt_size; i++)
+            hal_set_regdrv(&ctx0, i, vals[i]);
+        end = mpp_time_us();
+        time_field += end - start;
+
+        start = mpp_time_us();
+        hal_regdrv_prog_load(&ctx1, vals, emt_size);
+        hal_regdrv_prog_gen(&ctx1);
+        end = mpp_time_us();
+        time_prog += end - start;
+
+        dirty_total += hal_regdrv_get_dirty(&ctx1, NULL, 0);
+        hal_regdrv_clr_dirty(&ctx1);
+
+        if (memcmp(reg0, reg1, sizeof(RK_U32) * cfg->reg_size)) {
+            mpp_err("%s register mismatch at frame %d\n", cfg->name, frame);
+            goto __RETURN;
+        }
+    }
+
+    mpp_log("%-10s regs %3d fields %4d field write %6.3f us/frame batched %6.3f us/frame dirty %5.1f regs/frame\n",
+            cfg->name, cfg->reg_size, emt_size,
+            (float)time_field / REGDRV_TEST_FRAMES,
+            (float)time_prog / REGDRV_TEST_FRAMES,
+            (float)dirty_total / REGDRV_TEST_FRAMES);
+    ret = MPP_OK;
+__RETURN:
+    hal_regdrv_prog_deinit(&ctx1);
+    MPP_FREE(emt);
+    MPP_FREE(vals);
+    MPP_FREE(reg0);
+    MPP_FREE(reg1);
+    return ret;
+}
+
+/* read the reference list fields back through the register struct */
+static RK_U32 vdpu_ref_list_val(H264dVdpuRegs_t *r, RK_U32 list, RK_U32 i)
+{
+    RK_U32 val[3][16] = {
+        {
+            r->sw106.init_reflist_pf0,  r->sw106.init_reflist_pf1,
+            r->sw106.init_reflist_pf2,  r->sw106.init_reflist_pf3,
+            r->sw74.init_reflist_pf4,   r->sw74.init_reflist_pf5,
+            r->sw74.init_reflist_pf6,   r->sw74.init_reflist_pf7,
+            r->sw74.init_reflist_pf8,   r->sw74.init_reflist_pf9,
+            r->sw75.init_reflist_pf10,  r->sw75.init_reflist_pf11,
+            r->sw75.init_reflist_pf12,  r->sw75.init_reflist_pf13,
+            r->sw75.init_reflist_pf14,  r->sw75.init_reflist_pf15,
+        }, {
+            r->sw100.init_reflist_df0,  r->sw100.init_reflist_df1,
+            r->sw100.init_reflist_df2,  r->sw100.init_reflist_df3,
+            r->sw100.init_reflist_df4,  r->sw100.init_reflist_df5,
+            r->sw101.init_reflist_df6,  r->sw101.init_reflist_df7,
+            r->sw101.init_reflist_df8,  r->sw101.init_reflist_df9,
+            r->sw101.init_reflist_df10, r->sw101.init_reflist_df11,
+            r->sw102.init_reflist_df12, r->sw102.init_reflist_df13,
+            r->sw102.init_reflist_df14, r->sw102.init_reflist_df15,
+        }, {
+            r->sw103.init_reflist_db0,  r->sw103.init_reflist_db1,
+            r->sw103.init_reflist_db2,  r->sw103.init_reflist_db3,
+            r->sw103.init_reflist_db4,  r->sw103.init_reflist_db5,
+            r->sw104.init_reflist_db6,  r->sw104.init_reflist_db7,
+            r->sw104.init_reflist_db8,  r->sw104.init_reflist_db9,
+            r->sw104.init_reflist_db10, r->sw104.init_reflist_db11,
+            r->sw105.init_reflist_db12, r->sw105.init_reflist_db13,
+            r->sw105.init_reflist_db14, r->sw105.init_reflist_db15,
+        },
+    };
+
+    return val[list][i];
+}
+
+/*
+ * run the vdpu h264d reference list registers of a frame sequence with a
+ * sliding window of REGDRV_VDPU_REFS references, B lists are the P list
+ * with the first two entries swapped
+ */
+static MPP_RET test_vdpu_ref(void)
+{
+    MPP_RET ret = MPP_NOK;
+    DXVA_Slice_H264_Long *slices = mpp_calloc(DXVA_Slice_H264_Long, REGDRV_VDPU_PATTERNS);
+    H264dVdpuRegs_t *regs = mpp_calloc(H264dVdpuRegs_t, 1);
+    H264dVdpuPriv_t *priv = mpp_calloc(H264dVdpuPriv_t, 1);
+    DXVA_PicParams_H264_MVC pp;
+    H264dHalCtx_t hal;
+    RK_S64 start;
+    RK_U32 frame, list, i;
+
+    memset(&pp, 0, sizeof(pp));
+    memset(&hal, 0, sizeof(hal));
+    if (NULL == slices || NULL == regs || NULL == priv)
+        goto __RETURN;
+
+    for (frame = 0; frame < REGDRV_VDPU_PATTERNS; frame++) {
+        DXVA_Slice_H264_Long *p_long = &slices[frame];
+
+        for (list = 0; list < 3; list++) {
+            for (i = 0; i < 32; i++) {
+                RK_U32 idx = (i < 2 && list) ? (1 - i) : i;
+
+                if (idx < REGDRV_VDPU_REFS)
+                    p_long->RefPicList[list][i].Index7Bits = (frame + 15 - idx) % 16;
+                else
+                    p_long->RefPicList[list][i].bPicEntry = 0xff;
+            }
+        }
+    }
+
+    hal.pp    = &pp;
+    hal.regs  = regs;
+    hal.priv  = priv;
+    hal.slice_long = &slices[0];
+    if (vdpu_init_ref_regs(&hal, regs))
+        goto __RETURN;
+
+    start = mpp_time_ns();
+    for (frame = 0; frame < REGDRV_VDPU_FRAMES; frame++) {
+        hal.slice_long = &slices[frame % REGDRV_VDPU_PATTERNS];
+        vdpu_set_ref_regs(&hal, regs);
+    }
+    start = mpp_time_ns() - start;
+
+    for (frame = 0; frame < REGDRV_VDPU_PATTERNS; frame++) {
+        DXVA_Slice_H264_Long *p_long = &slices[frame];
+
+        hal.slice_long = p_long;
+        vdpu_set_ref_regs(&hal, regs);
+        for (list = 0; list < 3; list++) {
+            for (i = 0; i < 16; i++) {
+                RK_U32 val = (p_long->RefPicList[list][i].bPicEntry == 0xff) ?
+                             i : p_long->RefPicList[list][i].Index7Bits;
+
+                if (vdpu_ref_list_val(regs, list, i) != val) {
+                    mpp_err("vdpu list %d ref %d mismatch %d vs %d at frame %d\n",
+                            list, i, vdpu_ref_list_val(regs, list, i), val, frame);
+                    goto __RETURN;
+                }
+            }
+        }
+    }
+
+    mpp_log("%-10s ref list regs %lld ns/frame\n", "h264d vdpu",
+            start / REGDRV_VDPU_FRAMES);
+    ret = MPP_OK;
+__RETURN:
+    vdpu_deinit_ref_regs(&hal);
+    MPP_FREE(slices);
+    MPP_FREE(regs);
+    MPP_FREE(priv);
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_OK;
+    RK_U32 i;
+
+    mpp_log("hal_regdrv_test start\n");
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(test_cfgs); i++) {
+        ret = test_one(&test_cfgs[i]);
+        if (ret)
+            break;
+    }
+
+    if (MPP_OK == ret)
+        ret = test_vdpu_ref();
+
+    mpp_log("hal_regdrv_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
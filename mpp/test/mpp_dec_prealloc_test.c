@@ -0,0 +1,189 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dec_prealloc_test"
+
+#include "mpp_log.h"
+#include "mpp_buf_slot.h"
+#include "mpp_buffer_impl.h"
+
+#define PREALLOC_SMALL          (SZ_64K)
+#define PREALLOC_LARGE          (SZ_256K)
+
+static MppFrame new_frame(RK_U32 width, RK_U32 height)
+{
+    MppFrame frame = NULL;
+
+    mpp_frame_init(&frame);
+    if (frame) {
+        mpp_frame_set_width(frame, width);
+        mpp_frame_set_height(frame, height);
+        mpp_frame_set_hor_stride(frame, width);
+        mpp_frame_set_ver_stride(frame, height);
+        mpp_frame_set_fmt(frame, MPP_FMT_YUV420SP);
+    }
+    return frame;
+}
+
+static MPP_RET test_slot_hint(void)
+{
+    MPP_RET ret = MPP_NOK;
+    MppBufSlots slots = NULL;
+    MppFrame frame0 = new_frame(1280, 720);
+    MppFrame frame1 = new_frame(1920, 1080);
+    size_t size0 = 0;
+    size_t size1 = 0;
+    RK_S32 count = 0;
+    RK_S32 index = -1;
+    RK_U32 seq0, seq1;
+
+    if (NULL == frame0 || NULL == frame1 || mpp_buf_slot_init(&slots))
+        goto __RETURN;
+
+    mpp_buf_slot_setup(slots, 4);
+
+    /* sequence header hint gives size and count */
+    mpp_buf_slot_set_hint(slots, frame0, 6);
+    seq0 = mpp_buf_slot_get_hint(slots, &size0, &count);
+    if (!size0 || count != 6) {
+        mpp_err("hint size %d count %d mismatch\n", size0, count);
+        goto __RETURN;
+    }
+
+    /* same size is not a new hint and unknown count keeps the last one */
+    mpp_buf_slot_set_hint(slots, frame0, 0);
+    if (seq0 != mpp_buf_slot_get_hint(slots, NULL, &count) || count != 6) {
+        mpp_err("same size hint changes sequence\n");
+        goto __RETURN;
+    }
+
+    /* frame with a new size updates the hint without count */
+    mpp_buf_slot_get_unused(slots, &index);
+    mpp_buf_slot_set_prop(slots, index, SLOT_FRAME, frame1);
+    seq1 = mpp_buf_slot_get_hint(slots, &size1, &count);
+    if (seq1 == seq0 || size1 <= size0 || size1 != mpp_buf_slot_get_size(slots) || count != 6) {
+        mpp_err("frame size %d does not update hint %d\n",
+                mpp_buf_slot_get_size(slots), size1);
+        goto __RETURN;
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    /* release the slot as codec does when the frame is no longer referenced */
+    if (index >= 0) {
+        mpp_buf_slot_set_flag(slots, index, SLOT_CODEC_READY);
+        mpp_buf_slot_set_flag(slots, index, SLOT_CODEC_USE);
+        mpp_buf_slot_clr_flag(slots, index, SLOT_CODEC_USE);
+    }
+    if (slots)
+        mpp_buf_slot_deinit(slots);
+    if (frame0)
+        mpp_frame_deinit(&frame0);
+    if (frame1)
+        mpp_frame_deinit(&frame1);
+    return ret;
+}
+
+/* create a unused buffer in group as pre-allocation does */
+static MPP_RET prealloc(MppBufferGroupImpl *group, size_t size)
+{
+    MppBufferInfo info = {
+        group->type,
+        size,
+        NULL,
+        NULL,
+        -1,
+        -1,
+    };
+
+    return mpp_buffer_create(MODULE_TAG, __FUNCTION__, group, &info, NULL);
+}
+
+static MPP_RET test_group_keep(void)
+{
+    MPP_RET ret = MPP_NOK;
+    MppBufferGroup group = NULL;
+    MppBufferGroupImpl *p = NULL;
+    MppBuffer buffer = NULL;
+
+    if (mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL))
+        return MPP_NOK;
+
+    p = (MppBufferGroupImpl *)group;
+    mpp_buffer_group_set_best_fit(p, 1);
+
+    /* pools of two sizes with the large one first on unused list */
+    if (prealloc(p, PREALLOC_LARGE) || prealloc(p, PREALLOC_SMALL) ||
+        prealloc(p, PREALLOC_SMALL))
+        goto __RETURN;
+
+    if (mpp_buffer_group_size_count(p, PREALLOC_SMALL) != 2 ||
+        mpp_buffer_group_size_count(p, PREALLOC_LARGE) != 1) {
+        mpp_err("pre-allocated buffer count mismatch\n");
+        goto __RETURN;
+    }
+
+    /* small request does not take the large buffer */
+    mpp_buffer_get(group, &buffer, PREALLOC_SMALL);
+    if (NULL == buffer || mpp_buffer_get_size(buffer) != PREALLOC_SMALL) {
+        mpp_err("best fit takes size %d\n", buffer ? mpp_buffer_get_size(buffer) : 0);
+        goto __RETURN;
+    }
+
+    /* used buffer is counted, trim keeps the given sizes only */
+    mpp_buffer_group_trim(p, PREALLOC_SMALL, 0);
+    if (mpp_buffer_group_size_count(p, PREALLOC_SMALL) != 2 ||
+        mpp_buffer_group_size_count(p, PREALLOC_LARGE) != 0) {
+        mpp_err("trim keeps wrong buffers\n");
+        goto __RETURN;
+    }
+
+    /* larger request still gets a new buffer with small ones kept */
+    mpp_buffer_put(buffer);
+    buffer = NULL;
+    mpp_buffer_get(group, &buffer, PREALLOC_LARGE);
+    if (NULL == buffer || mpp_buffer_group_size_count(p, PREALLOC_SMALL) != 2) {
+        mpp_err("small buffers are released on large request\n");
+        goto __RETURN;
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    if (buffer)
+        mpp_buffer_put(buffer);
+    mpp_buffer_group_put(group);
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret;
+
+    mpp_log("mpp_dec_prealloc_test start\n");
+
+    ret = test_slot_hint();
+    if (ret)
+        mpp_err("slot hint check failed\n");
+
+    if (MPP_OK == ret) {
+        ret = test_group_keep();
+        if (ret)
+            mpp_err("buffer group keep check failed\n");
+    }
+
+    mpp_log("mpp_dec_prealloc_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
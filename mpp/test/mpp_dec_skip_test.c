@@ -0,0 +1,230 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dec_skip_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_dec_skip.h"
+
+/* broadcast like stream: IDR P B B P B B ... with non-reference B */
+#define LONG_GOP_SIZE       250
+#define LONG_GOP_COUNT      8
+
+/* dyadic hierarchical gop of 8 pictures, 4 temporal layers */
+#define DYADIC_GOP_SIZE     8
+#define DYADIC_GOP_COUNT    16
+
+typedef struct SkipPic_t {
+    RK_U32  is_key;
+    RK_U32  is_ref;
+    RK_U32  tid;
+} SkipPic;
+
+static void long_gop_pic(RK_S32 idx, SkipPic *pic)
+{
+    RK_S32 pos = idx % LONG_GOP_SIZE;
+
+    pic->is_key = (pos == 0);
+    pic->is_ref = (pos % 3) == 0;
+    pic->tid = !pic->is_ref;
+}
+
+static void dyadic_gop_pic(RK_S32 idx, SkipPic *pic)
+{
+    RK_S32 pos = idx % DYADIC_GOP_SIZE;
+
+    pic->is_key = (idx == 0);
+    if (pos == 0)
+        pic->tid = 0;
+    else if (pos == 4)
+        pic->tid = 1;
+    else if (pos == 2 || pos == 6)
+        pic->tid = 2;
+    else
+        pic->tid = 3;
+    pic->is_ref = pic->tid < 3;
+}
+
+static RK_S32 run_long_gop(MppDecSkipCfg *cfg)
+{
+    MppDecSkip skip;
+    SkipPic pic;
+    RK_S32 decoded = 0;
+    RK_S32 i;
+
+    mpp_dec_skip_init(&skip);
+    mpp_dec_skip_set(&skip, cfg);
+
+    for (i = 0; i < LONG_GOP_SIZE * LONG_GOP_COUNT; i++) {
+        long_gop_pic(i, &pic);
+        if (!mpp_dec_skip_check(&skip, pic.is_key, pic.is_ref, pic.tid))
+            decoded++;
+    }
+
+    return decoded;
+}
+
+/* ratio of pictures sent to hardware, the decoding time scales with it */
+static MPP_RET test_long_gop(void)
+{
+    static const char *names[] = { "none", "non-ref", "non-key", "temporal" };
+    static const RK_S32 expect[] = {
+        LONG_GOP_SIZE * LONG_GOP_COUNT,
+        (LONG_GOP_SIZE + 2) / 3 * LONG_GOP_COUNT,
+        LONG_GOP_COUNT,
+        (LONG_GOP_SIZE + 2) / 3 * LONG_GOP_COUNT,
+    };
+    RK_S32 total = LONG_GOP_SIZE * LONG_GOP_COUNT;
+    MppDecSkipCfg cfg;
+    RK_U32 mode;
+
+    for (mode = MPP_DEC_SKIP_NONE; mode < MPP_DEC_SKIP_BUTT; mode++) {
+        RK_S32 decoded;
+
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.mode = mode;
+        decoded = run_long_gop(&cfg);
+
+        mpp_log("gop %d mode %-8s decoded %4d / %4d speedup %6.1fx\n",
+                LONG_GOP_SIZE, names[mode], decoded, total,
+                (float)total / decoded);
+
+        if (decoded != expect[mode]) {
+            mpp_err("mode %s decoded %d expect %d\n", names[mode],
+                    decoded, expect[mode]);
+            return MPP_NOK;
+        }
+    }
+
+    /* one key picture out of four */
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mode = MPP_DEC_SKIP_NON_KEY;
+    cfg.key_interval = 4;
+    if (run_long_gop(&cfg) != LONG_GOP_COUNT / 4) {
+        mpp_err("key interval 4 failed\n");
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET test_temporal(void)
+{
+    MppDecSkip skip;
+    MppDecSkipCfg cfg;
+    SkipPic pic;
+    RK_U32 max_tid;
+    RK_S32 i;
+
+    for (max_tid = 0; max_tid < 4; max_tid++) {
+        RK_S32 decoded = 0;
+        RK_S32 expect = DYADIC_GOP_COUNT * (1 << max_tid);
+
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.mode = MPP_DEC_SKIP_TEMPORAL;
+        cfg.max_tid = max_tid;
+        mpp_dec_skip_init(&skip);
+        mpp_dec_skip_set(&skip, &cfg);
+
+        for (i = 0; i < DYADIC_GOP_SIZE * DYADIC_GOP_COUNT; i++) {
+            dyadic_gop_pic(i, &pic);
+            if (!mpp_dec_skip_check(&skip, pic.is_key, pic.is_ref, pic.tid))
+                decoded++;
+        }
+
+        mpp_log("dyadic gop max tid %d decoded %3d / %3d\n", max_tid,
+                decoded, DYADIC_GOP_SIZE * DYADIC_GOP_COUNT);
+
+        if (decoded != expect) {
+            mpp_err("max tid %d decoded %d expect %d\n", max_tid, decoded, expect);
+            return MPP_NOK;
+        }
+    }
+
+    return MPP_OK;
+}
+
+/* mode changed in gop must not decode pictures referring skipped pictures */
+static MPP_RET test_switch(void)
+{
+    MppDecSkip skip;
+    MppDecSkipCfg cfg;
+    SkipPic pic;
+    RK_S32 i;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mode = MPP_DEC_SKIP_NON_KEY;
+    mpp_dec_skip_init(&skip);
+    mpp_dec_skip_set(&skip, &cfg);
+
+    for (i = 0; i < 10; i++) {
+        long_gop_pic(i, &pic);
+        mpp_dec_skip_check(&skip, pic.is_key, pic.is_ref, pic.tid);
+    }
+
+    /* back to normal decoding in the middle of gop */
+    cfg.mode = MPP_DEC_SKIP_NONE;
+    mpp_dec_skip_set(&skip, &cfg);
+    for (; i < LONG_GOP_SIZE; i++) {
+        long_gop_pic(i, &pic);
+        if (!mpp_dec_skip_check(&skip, pic.is_key, pic.is_ref, pic.tid)) {
+            mpp_err("picture %d decoded before next key picture\n", i);
+            return MPP_NOK;
+        }
+    }
+
+    long_gop_pic(i, &pic);
+    if (mpp_dec_skip_check(&skip, pic.is_key, pic.is_ref, pic.tid)) {
+        mpp_err("key picture %d is not decoded\n", i);
+        return MPP_NOK;
+    }
+
+    /* dropping more pictures takes effect immediately */
+    cfg.mode = MPP_DEC_SKIP_NON_REF;
+    mpp_dec_skip_set(&skip, &cfg);
+    cfg.mode = MPP_DEC_SKIP_NON_KEY;
+    mpp_dec_skip_set(&skip, &cfg);
+    if (skip.wait_key) {
+        mpp_err("switch to non-key mode should not wait key picture\n");
+        return MPP_NOK;
+    }
+
+    cfg.mode = MPP_DEC_SKIP_BUTT;
+    if (MPP_OK == mpp_dec_skip_set(&skip, &cfg)) {
+        mpp_err("invalid mode is accepted\n");
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+int main()
+{
+    MPP_RET ret;
+
+    mpp_log("mpp_dec_skip_test start\n");
+
+    ret = test_long_gop();
+    if (MPP_OK == ret)
+        ret = test_temporal();
+    if (MPP_OK == ret)
+        ret = test_switch();
+
+    mpp_log("mpp_dec_skip_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
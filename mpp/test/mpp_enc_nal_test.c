@@ -0,0 +1,314 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_enc_nal_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_mem.h"
+#include "mpp_meta.h"
+#include "mpp_enc_nal.h"
+
+/*
+ * encoder nal unit index and avcc conversion test
+ *
+ * A synthetic packet of one sei and one slice per macroblock row of 1080p
+ * is indexed from the nal unit sizes as the controller does. The index is
+ * checked against the stream, attached to the packet meta and then used to
+ * convert the packet to avcc in place. The slices added as one rest range
+ * and the whole packet scan must give the same index. The index cost is
+ * compared with a start code scan of the whole packet.
+ */
+#define NAL_PKT_COUNT           2000
+#define NAL_SLICE_COUNT         68
+#define NAL_SLICE_SIZE          1500
+#define NAL_PKT_SIZE            ((NAL_SLICE_COUNT + 1) * (NAL_SLICE_SIZE + 8))
+
+typedef struct NalDesc_t {
+    RK_U32  offset;
+    RK_U32  length;
+    RK_U32  header;
+    RK_U32  type;
+    RK_U32  temporal_id;
+} NalDesc;
+
+/* nal units with mixed 3 and 4 bytes start codes and no zero payload byte */
+static RK_U32 build_packet(RK_U8 *buf, NalDesc *descs, MppCodingType coding)
+{
+    RK_U32 seed = 1;
+    RK_U32 pos = 0;
+    RK_U32 i, j;
+
+    for (i = 0; i <= NAL_SLICE_COUNT; i++) {
+        NalDesc *desc = &descs[i];
+        RK_U32 header = (i % 3) ? 4 : 3;
+        RK_U32 size = (i == 0) ? 24 : NAL_SLICE_SIZE - (i * 7) % 300;
+        RK_U8 *p = buf + pos;
+
+        memset(p, 0, header - 1);
+        p[header - 1] = 1;
+
+        if (coding == MPP_VIDEO_CodingHEVC) {
+            desc->type = i ? 1 : 39;
+            desc->temporal_id = i & 1;
+            p[header] = (RK_U8)(desc->type << 1);
+            p[header + 1] = (RK_U8)(desc->temporal_id + 1);
+            j = 2;
+        } else {
+            desc->type = i ? 1 : 6;
+            desc->temporal_id = 0;
+            p[header] = (RK_U8)(0x60 | desc->type);
+            j = 1;
+        }
+
+        for (; j < size; j++) {
+            seed = seed * 1103515245 + 12345;
+            p[header + j] = (RK_U8)(1 + (seed >> 16) % 255);
+        }
+
+        desc->offset = pos;
+        desc->length = header + size;
+        desc->header = header;
+        pos += desc->length;
+    }
+
+    return pos;
+}
+
+static void add_nals(MppEncNal *nal, NalDesc *descs, MppCodingType coding)
+{
+    RK_U32 i;
+
+    mpp_enc_nal_reset(nal, coding);
+    for (i = 0; i <= NAL_SLICE_COUNT; i++)
+        mpp_enc_nal_add(nal, descs[i].offset, descs[i].length);
+}
+
+static MPP_RET check_index(MppEncNalInfo *nals, RK_U32 count, NalDesc *descs)
+{
+    RK_U32 i;
+
+    if (count != NAL_SLICE_COUNT + 1) {
+        mpp_err("nal count %d expect %d\n", count, NAL_SLICE_COUNT + 1);
+        return MPP_NOK;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (nals[i].offset != descs[i].offset || nals[i].length != descs[i].length ||
+            nals[i].header != descs[i].header || nals[i].type != descs[i].type ||
+            nals[i].temporal_id != descs[i].temporal_id) {
+            mpp_err("nal %d offset %d length %d type %d tid %d mismatch\n", i,
+                    nals[i].offset, nals[i].length, nals[i].type, nals[i].temporal_id);
+            return MPP_NOK;
+        }
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET check_avcc(RK_U8 *avcc, RK_U32 length, RK_U8 *annexb, NalDesc *descs)
+{
+    RK_U32 pos = 0;
+    RK_U32 i;
+
+    for (i = 0; i <= NAL_SLICE_COUNT; i++) {
+        RK_U32 size = descs[i].length - descs[i].header;
+        RK_U8 *p = avcc + pos;
+
+        if (pos + 4 + size > length ||
+            (RK_U32)((p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]) != size ||
+            memcmp(p + 4, annexb + descs[i].offset + descs[i].header, size)) {
+            mpp_err("avcc nal %d at %d mismatch\n", i, pos);
+            return MPP_NOK;
+        }
+        pos += 4 + size;
+    }
+
+    if (pos != length) {
+        mpp_err("avcc length %d expect %d\n", length, pos);
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET test_coding(MppCodingType coding, RK_U8 *buf, RK_U8 *ref,
+                           MppEncNal *nal, NalDesc *descs)
+{
+    MPP_RET ret = MPP_NOK;
+    MppPacket packet = NULL;
+    MppPacket index = NULL;
+    MppMeta meta = NULL;
+    RK_U32 length = build_packet(buf, descs, coding);
+    RK_U32 avcc_len = length;
+
+    memcpy(ref, buf, length);
+    add_nals(nal, descs, coding);
+
+    if (mpp_enc_nal_finish(nal, buf, length) ||
+        check_index(nal->nals, nal->count, descs))
+        goto __RETURN;
+
+    /* controller without slice sizes adds the slices as one range */
+    mpp_enc_nal_reset(nal, coding);
+    mpp_enc_nal_add(nal, descs[0].offset, descs[0].length);
+    mpp_enc_nal_add_rest(nal, descs[1].offset, length - descs[1].offset);
+    if (mpp_enc_nal_finish(nal, buf, length) ||
+        check_index(nal->nals, nal->count, descs)) {
+        mpp_err("rest range split failed\n");
+        goto __RETURN;
+    }
+
+    if (mpp_enc_nal_scan(nal, buf, length) ||
+        check_index(nal->nals, nal->count, descs)) {
+        mpp_err("packet scan failed\n");
+        goto __RETURN;
+    }
+
+    /* index attached on packet is released with packet */
+    mpp_packet_init(&packet, buf, NAL_PKT_SIZE);
+    mpp_packet_set_length(packet, length);
+    if (mpp_enc_nal_attach(nal, packet))
+        goto __RETURN;
+
+    meta = mpp_packet_get_meta(packet);
+    if (NULL == meta || mpp_meta_get_packet(meta, MPP_META_KEY_OUTPUT_NAL, &index)) {
+        mpp_err("no nal index on packet\n");
+        goto __RETURN;
+    }
+    if (check_index((MppEncNalInfo *)mpp_packet_get_data(index),
+                    (RK_U32)(mpp_packet_get_length(index) / sizeof(MppEncNalInfo)), descs))
+        goto __RETURN;
+    mpp_meta_set_packet(meta, MPP_META_KEY_OUTPUT_NAL, index);
+
+    /* not enough space for the grown start codes */
+    if (MPP_OK == mpp_enc_nal_to_avcc(nal, buf, &avcc_len, length)) {
+        mpp_err("avcc conversion overflow not detected\n");
+        goto __RETURN;
+    }
+
+    if (mpp_enc_nal_to_avcc(nal, buf, &avcc_len, NAL_PKT_SIZE) ||
+        check_avcc(buf, avcc_len, ref, descs))
+        goto __RETURN;
+
+    /* a broken start code drops the whole index */
+    memcpy(buf, ref, length);
+    add_nals(nal, descs, coding);
+    buf[descs[NAL_SLICE_COUNT / 2].offset + 1] = 0xff;
+    if (MPP_OK == mpp_enc_nal_finish(nal, buf, length) || nal->count) {
+        mpp_err("invalid nal index accepted\n");
+        goto __RETURN;
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    if (packet)
+        mpp_packet_deinit(&packet);
+    return ret;
+}
+
+/* what a user without the index has to do to find nal units */
+static RK_U32 scan_start_code(RK_U8 *buf, RK_U32 length, MppEncNalInfo *nals)
+{
+    RK_U32 count = 0;
+    RK_U32 i;
+
+    for (i = 0; i + 3 < length; i++) {
+        if (!buf[i] && !buf[i + 1] && buf[i + 2] == 1) {
+            nals[count].offset = i;
+            nals[count].type = buf[i + 3] & 0x1f;
+            if (count)
+                nals[count - 1].length = i - nals[count - 1].offset;
+            count++;
+            i += 2;
+        }
+    }
+    if (count)
+        nals[count - 1].length = length - nals[count - 1].offset;
+
+    return count;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    RK_U8 *buf = NULL;
+    RK_U8 *ref = NULL;
+    MppEncNal *nal = NULL;
+    NalDesc *descs = NULL;
+    MppEncNalInfo *scan = NULL;
+    RK_S64 index_ns = 0;
+    RK_S64 scan_ns = 0;
+    RK_U32 length = 0;
+    RK_U32 count = 0;
+    RK_U32 i;
+
+    mpp_log("mpp_enc_nal_test start\n");
+
+    buf = mpp_malloc(RK_U8, NAL_PKT_SIZE);
+    ref = mpp_malloc(RK_U8, NAL_PKT_SIZE);
+    nal = mpp_calloc(MppEncNal, 1);
+    descs = mpp_calloc(NalDesc, NAL_SLICE_COUNT + 1);
+    scan = mpp_calloc(MppEncNalInfo, MPP_ENC_NAL_MAX_COUNT);
+    if (!buf || !ref || !nal || !descs || !scan)
+        goto __RETURN;
+
+    if (test_coding(MPP_VIDEO_CodingAVC, buf, ref, nal, descs)) {
+        mpp_err("h264 nal index check failed\n");
+        goto __RETURN;
+    }
+
+    if (test_coding(MPP_VIDEO_CodingHEVC, buf, ref, nal, descs)) {
+        mpp_err("h265 nal index check failed\n");
+        goto __RETURN;
+    }
+
+    length = build_packet(buf, descs, MPP_VIDEO_CodingAVC);
+
+    for (i = 0; i < NAL_PKT_COUNT; i++) {
+        RK_S64 start = mpp_time_ns();
+
+        add_nals(nal, descs, MPP_VIDEO_CodingAVC);
+        mpp_enc_nal_finish(nal, buf, length);
+        index_ns += mpp_time_ns() - start;
+
+        start = mpp_time_ns();
+        count = scan_start_code(buf, length, scan);
+        scan_ns += mpp_time_ns() - start;
+    }
+
+    if (count != nal->count) {
+        mpp_err("scan found %d nal units expect %d\n", count, nal->count);
+        goto __RETURN;
+    }
+
+    mpp_log("packet %d bytes %d nal units index %.1f us scan %.1f us per packet\n",
+            length, count, (float)index_ns / NAL_PKT_COUNT / 1000,
+            (float)scan_ns / NAL_PKT_COUNT / 1000);
+
+    ret = MPP_OK;
+__RETURN:
+    MPP_FREE(scan);
+    MPP_FREE(descs);
+    MPP_FREE(nal);
+    MPP_FREE(ref);
+    MPP_FREE(buf);
+
+    mpp_log("mpp_enc_nal_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,228 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_enc_slice_test"
+
+#include <time.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_mem.h"
+#include "mpp_packet.h"
+#include "mpp_enc_slice.h"
+
+/*
+ * encoder slice output latency benchmark
+ *
+ * A simulated hardware encodes a 1080p frame as one slice per macroblock
+ * row with fixed time per slice, as the encoder hal reports slice progress.
+ * The cpu sleeps while the hardware works so the user thread can run.
+ * The stream goes through the output task queue to a user thread either as
+ * one packet on frame done or as one packet per finished slice. The user
+ * thread checks the stream pieces and measures the time from encoding start
+ * to its first and last byte of each frame.
+ */
+#define SLICE_FRAME_COUNT       100
+#define SLICE_COUNT             68
+#define SLICE_SIZE              1024
+#define SLICE_HW_US             30
+#define SLICE_TASK_COUNT        9
+
+typedef struct SliceCtx_t {
+    MppPort             enc;
+    MppPort             user;
+    MppPacket           frame;
+    RK_U8               *buf;
+
+    volatile RK_S64     start;
+    volatile RK_U32     frame_done;
+    volatile RK_S32     stop;
+
+    RK_U32              recv_pos;
+    RK_U32              recv_count;
+    RK_S64              first_us;
+    RK_S64              last_us;
+    RK_U32              error;
+} SliceCtx;
+
+/* hardware finishes slice idx at fixed time from frame start */
+static void encode_slice(RK_U8 *dst, RK_U32 idx, RK_S64 start)
+{
+    RK_S64 end = start + (idx + 1) * SLICE_HW_US;
+    struct timespec ts;
+
+    memset(dst, (RK_U8)idx, SLICE_SIZE);
+
+    ts.tv_sec = end / 1000000;
+    ts.tv_nsec = (end % 1000000) * 1000;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+static void *user_thread(void *arg)
+{
+    SliceCtx *ctx = (SliceCtx *)arg;
+    MppTask task = NULL;
+    MppPacket packet = NULL;
+
+    while (!ctx->stop) {
+        RK_S64 now;
+        RK_U8 *pos;
+        RK_U32 len;
+
+        if (mpp_port_poll(ctx->user, (MppPollType)10))
+            continue;
+
+        mpp_port_dequeue(ctx->user, &task);
+        if (NULL == task)
+            continue;
+
+        now = mpp_time_us();
+        mpp_task_meta_get_packet(task, MPP_META_KEY_OUTPUT_PKT, &packet);
+        mpp_port_enqueue(ctx->user, task);
+
+        pos = (RK_U8 *)mpp_packet_get_pos(packet);
+        len = (RK_U32)mpp_packet_get_length(packet);
+
+        if (!ctx->recv_count)
+            ctx->first_us += now - ctx->start;
+
+        if (!mpp_packet_is_partition(packet) || pos != ctx->buf + ctx->recv_pos) {
+            mpp_err("frame %d piece %d at %d is not in order\n",
+                    ctx->frame_done, ctx->recv_count, ctx->recv_pos);
+            ctx->error = 1;
+        }
+        ctx->recv_pos += len;
+        ctx->recv_count++;
+
+        if (mpp_packet_is_eoi(packet)) {
+            if (packet != ctx->frame || ctx->recv_pos != SLICE_COUNT * SLICE_SIZE) {
+                mpp_err("frame %d ends at %d\n", ctx->frame_done, ctx->recv_pos);
+                ctx->error = 1;
+            }
+            ctx->last_us += now - ctx->start;
+            ctx->recv_pos = 0;
+            ctx->recv_count = 0;
+            ctx->frame_done++;
+        } else {
+            mpp_packet_deinit(&packet);
+        }
+    }
+
+    return NULL;
+}
+
+static MPP_RET run_frames(SliceCtx *ctx, RK_U32 split_out)
+{
+    MppEncSliceOut out;
+    RK_U32 i, j;
+
+    ctx->first_us = 0;
+    ctx->last_us = 0;
+    ctx->frame_done = 0;
+
+    for (i = 0; i < SLICE_FRAME_COUNT; i++) {
+        mpp_enc_slice_start(&out, ctx->enc, ctx->frame);
+        out.intra = !i;
+        ctx->start = mpp_time_us();
+
+        for (j = 0; j < SLICE_COUNT; j++) {
+            RK_U32 end = (j + 1) * SLICE_SIZE;
+
+            encode_slice(ctx->buf + j * SLICE_SIZE, j, ctx->start);
+            if (split_out && mpp_enc_slice_put(&out, end, j + 1 == SLICE_COUNT))
+                return MPP_NOK;
+        }
+
+        if (!split_out && mpp_enc_slice_put(&out, SLICE_COUNT * SLICE_SIZE, 1))
+            return MPP_NOK;
+
+        // the frame packet comes back on eoi before the next frame reuses it
+        while (ctx->frame_done != i + 1 && !ctx->error)
+            usleep(100);
+        if (ctx->error)
+            return MPP_NOK;
+
+        if (out.count != (split_out ? SLICE_COUNT : 1)) {
+            mpp_err("frame %d sent %d packets\n", i, out.count);
+            return MPP_NOK;
+        }
+    }
+
+    mpp_log("%-12s first byte %6.1f us last byte %6.1f us\n",
+            split_out ? "slice output" : "frame output",
+            (float)ctx->first_us / SLICE_FRAME_COUNT,
+            (float)ctx->last_us / SLICE_FRAME_COUNT);
+
+    return MPP_OK;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    MppTaskQueue queue = NULL;
+    SliceCtx ctx;
+    MppEncSliceOut out;
+    pthread_t thd;
+    RK_S32 thd_ok = 0;
+
+    mpp_log("mpp_enc_slice_test start\n");
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.buf = mpp_malloc(RK_U8, SLICE_COUNT * SLICE_SIZE);
+    if (NULL == ctx.buf)
+        goto __RETURN;
+
+    mpp_packet_init(&ctx.frame, ctx.buf, SLICE_COUNT * SLICE_SIZE);
+
+    if (mpp_task_queue_init(&queue) ||
+        mpp_task_queue_setup(queue, SLICE_TASK_COUNT))
+        goto __RETURN;
+
+    ctx.enc  = mpp_task_queue_get_port(queue, MPP_PORT_INPUT);
+    ctx.user = mpp_task_queue_get_port(queue, MPP_PORT_OUTPUT);
+
+    /* stream beyond packet size is rejected */
+    mpp_enc_slice_start(&out, ctx.enc, ctx.frame);
+    if (MPP_OK == mpp_enc_slice_put(&out, SLICE_COUNT * SLICE_SIZE + 1, 0)) {
+        mpp_err("invalid slice end accepted\n");
+        goto __RETURN;
+    }
+
+    if (pthread_create(&thd, NULL, user_thread, &ctx))
+        goto __RETURN;
+    thd_ok = 1;
+
+    if (run_frames(&ctx, 0) || run_frames(&ctx, 1))
+        goto __RETURN;
+
+    ret = MPP_OK;
+__RETURN:
+    if (thd_ok) {
+        ctx.stop = 1;
+        pthread_join(thd, NULL);
+    }
+    if (queue)
+        mpp_task_queue_deinit(queue);
+    if (ctx.frame)
+        mpp_packet_deinit(&ctx.frame);
+    MPP_FREE(ctx.buf);
+
+    mpp_log("mpp_enc_slice_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
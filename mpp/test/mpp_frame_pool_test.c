@@ -0,0 +1,176 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_frame_pool_test"
+
+#include <pthread.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_frame_impl.h"
+#include "mpp_packet.h"
+#include "mpp_packet_impl.h"
+
+#define CHURN_LOOP          100000
+#define CHURN_DEPTH         8
+#define XTHREAD_COUNT       1000
+
+/* get and put descriptors with a small in-flight depth as decoder does */
+static MPP_RET test_churn(void)
+{
+    MppFrame frames[CHURN_DEPTH];
+    MppPacket packets[CHURN_DEPTH];
+    MppMemPoolInfo info0;
+    MppMemPoolInfo info1;
+    RK_S64 start, end;
+    RK_S32 i, j;
+
+    mpp_frame_pool_info(&info0);
+    start = mpp_time_us();
+    for (i = 0; i < CHURN_LOOP; i++) {
+        for (j = 0; j < CHURN_DEPTH; j++) {
+            if (mpp_frame_init(&frames[j]))
+                return MPP_NOK;
+            mpp_frame_set_width(frames[j], i);
+        }
+        for (j = 0; j < CHURN_DEPTH; j++)
+            mpp_frame_deinit(&frames[j]);
+    }
+    end = mpp_time_us();
+    mpp_frame_pool_info(&info1);
+
+    mpp_log("frame  churn %d x %d cost %lld us total %d slab %d fill %lld\n",
+            CHURN_LOOP, CHURN_DEPTH, end - start, info1.total,
+            info1.slab_count, info1.fill_count - info0.fill_count);
+
+    /* in-flight depth is covered by one slab and no refill after warm up */
+    if (info1.used != info0.used || info1.total > info0.total + 32 ||
+        info1.fill_count - info0.fill_count > 1 ||
+        info1.get_count - info0.get_count != CHURN_LOOP * CHURN_DEPTH) {
+        mpp_err("frame pool counter mismatch\n");
+        return MPP_NOK;
+    }
+
+    mpp_packet_pool_info(&info0);
+    start = mpp_time_us();
+    for (i = 0; i < CHURN_LOOP; i++) {
+        for (j = 0; j < CHURN_DEPTH; j++) {
+            if (mpp_packet_new(&packets[j]))
+                return MPP_NOK;
+        }
+        for (j = 0; j < CHURN_DEPTH; j++)
+            mpp_packet_deinit(&packets[j]);
+    }
+    end = mpp_time_us();
+    mpp_packet_pool_info(&info1);
+
+    mpp_log("packet churn %d x %d cost %lld us total %d slab %d fill %lld\n",
+            CHURN_LOOP, CHURN_DEPTH, end - start, info1.total,
+            info1.slab_count, info1.fill_count - info0.fill_count);
+
+    if (info1.used != info0.used || info1.total > info0.total + 32) {
+        mpp_err("packet pool counter mismatch\n");
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+/* recycled frame must be zeroed as a newly allocated one */
+static MPP_RET test_reset(void)
+{
+    MppFrame frame = NULL;
+
+    mpp_frame_init(&frame);
+    mpp_frame_set_width(frame, 1920);
+    mpp_frame_set_pts(frame, 1234);
+    mpp_frame_deinit(&frame);
+
+    mpp_frame_init(&frame);
+    if (mpp_frame_get_width(frame) || mpp_frame_get_pts(frame)) {
+        mpp_err("recycled frame is not cleared\n");
+        mpp_frame_deinit(&frame);
+        return MPP_NOK;
+    }
+    mpp_frame_deinit(&frame);
+    return MPP_OK;
+}
+
+static MppFrame xframes[XTHREAD_COUNT];
+
+static void *put_thread(void *arg)
+{
+    RK_S32 i;
+
+    (void)arg;
+    for (i = 0; i < XTHREAD_COUNT; i++)
+        mpp_frame_deinit(&xframes[i]);
+
+    return NULL;
+}
+
+/* frames got in one thread and put in another thread as output queue does */
+static MPP_RET test_cross_thread(void)
+{
+    MppMemPoolInfo info0;
+    MppMemPoolInfo info1;
+    pthread_t thd;
+    RK_S32 i;
+
+    mpp_frame_pool_info(&info0);
+    for (i = 0; i < XTHREAD_COUNT; i++) {
+        if (mpp_frame_init(&xframes[i]))
+            return MPP_NOK;
+    }
+
+    if (pthread_create(&thd, NULL, put_thread, NULL))
+        return MPP_NOK;
+    pthread_join(thd, NULL);
+
+    /* frames put by exited thread are back to shared list and reused */
+    for (i = 0; i < XTHREAD_COUNT; i++)
+        mpp_frame_init(&xframes[i]);
+    for (i = 0; i < XTHREAD_COUNT; i++)
+        mpp_frame_deinit(&xframes[i]);
+    mpp_frame_pool_info(&info1);
+
+    mpp_log("frame  cross thread total %d -> %d\n", info0.total, info1.total);
+
+    if (info1.used != info0.used ||
+        info1.total > MPP_MAX(info0.total, XTHREAD_COUNT + 2 * 64 + 32)) {
+        mpp_err("cross thread put does not recycle frames\n");
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+int main()
+{
+    MPP_RET ret;
+
+    mpp_log("mpp_frame_pool_test start\n");
+
+    ret = test_reset();
+    if (MPP_OK == ret)
+        ret = test_churn();
+    if (MPP_OK == ret)
+        ret = test_cross_thread();
+
+    mpp_log("mpp_frame_pool_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
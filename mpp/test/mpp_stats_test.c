@@ -0,0 +1,199 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_stats_test"
+
+#include "rk_mpi.h"
+
+#include "mpp_log.h"
+#include "hal_task.h"
+#include "mpp_buf_slot.h"
+#include "mpp_buffer_impl.h"
+
+#define STATS_SLOT_COUNT        6
+#define STATS_TASK_COUNT        4
+
+static MPP_RET test_slot_stats(void)
+{
+    MPP_RET ret = MPP_NOK;
+    MppBufSlots slots = NULL;
+    MppBufSlotStats stats;
+    RK_S32 index0 = -1;
+    RK_S32 index1 = -1;
+
+    if (mpp_buf_slot_init(&slots))
+        return MPP_NOK;
+
+    mpp_buf_slot_setup(slots, STATS_SLOT_COUNT);
+    mpp_buf_slot_get_stats(slots, &stats);
+    if (stats.count != STATS_SLOT_COUNT || stats.on_used) {
+        mpp_err("initial slot count %d used %d\n", stats.count, stats.on_used);
+        goto __RETURN;
+    }
+
+    /* decoding one frame referring another one as codec and hal do */
+    mpp_buf_slot_get_unused(slots, &index0);
+    mpp_buf_slot_set_flag(slots, index0, SLOT_CODEC_USE);
+    mpp_buf_slot_set_flag(slots, index0, SLOT_HAL_OUTPUT);
+    mpp_buf_slot_get_unused(slots, &index1);
+    mpp_buf_slot_set_flag(slots, index1, SLOT_HAL_INPUT);
+    mpp_buf_slot_set_flag(slots, index1, SLOT_HAL_INPUT);
+
+    mpp_buf_slot_get_stats(slots, &stats);
+    if (stats.on_used != 2 || stats.codec_use != 1 || stats.hal_output != 1 ||
+        stats.hal_use != 1 || stats.not_ready != 2) {
+        mpp_err("slot stats used %d codec %d hal out %d hal in %d not ready %d\n",
+                stats.on_used, stats.codec_use, stats.hal_output, stats.hal_use,
+                stats.not_ready);
+        goto __RETURN;
+    }
+
+    /* hal done and the reference is released */
+    mpp_buf_slot_clr_flag(slots, index0, SLOT_HAL_OUTPUT);
+    mpp_buf_slot_clr_flag(slots, index1, SLOT_HAL_INPUT);
+    mpp_buf_slot_get_stats(slots, &stats);
+    if (stats.hal_output || stats.hal_use != 1 || stats.not_ready != 1) {
+        mpp_err("slot stats after hal done hal out %d hal in %d not ready %d\n",
+                stats.hal_output, stats.hal_use, stats.not_ready);
+        goto __RETURN;
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    if (index1 >= 0) {
+        mpp_buf_slot_clr_flag(slots, index1, SLOT_HAL_INPUT);
+        mpp_buf_slot_set_flag(slots, index1, SLOT_CODEC_READY);
+        mpp_buf_slot_set_flag(slots, index1, SLOT_CODEC_USE);
+        mpp_buf_slot_clr_flag(slots, index1, SLOT_CODEC_USE);
+    }
+    if (index0 >= 0) {
+        mpp_buf_slot_set_flag(slots, index0, SLOT_CODEC_READY);
+        mpp_buf_slot_clr_flag(slots, index0, SLOT_CODEC_USE);
+    }
+    if (MPP_OK == ret) {
+        mpp_buf_slot_get_stats(slots, &stats);
+        if (stats.on_used || stats.codec_use || stats.hal_use) {
+            mpp_err("slot stats not back to zero used %d\n", stats.on_used);
+            ret = MPP_NOK;
+        }
+    }
+    mpp_buf_slot_deinit(slots);
+    return ret;
+}
+
+static MPP_RET test_task_count(void)
+{
+    MPP_RET ret = MPP_NOK;
+    HalTaskGroup tasks = NULL;
+    HalTaskHnd hnd = NULL;
+    RK_U32 idle = 0;
+    RK_U32 proc = 0;
+
+    if (hal_task_group_init(&tasks, MPP_CTX_DEC, STATS_TASK_COUNT))
+        return MPP_NOK;
+
+    hal_task_get_hnd(tasks, TASK_IDLE, &hnd);
+    if (NULL == hnd)
+        goto __RETURN;
+
+    hal_task_hnd_set_status(hnd, TASK_PROCESSING);
+    hal_task_get_count(tasks, TASK_IDLE, &idle);
+    hal_task_get_count(tasks, TASK_PROCESSING, &proc);
+    if (idle != STATS_TASK_COUNT - 1 || proc != 1) {
+        mpp_err("task count idle %d processing %d\n", idle, proc);
+        goto __RETURN;
+    }
+
+    hal_task_hnd_set_status(hnd, TASK_IDLE);
+    hal_task_get_count(tasks, TASK_IDLE, &idle);
+    if (idle != STATS_TASK_COUNT)
+        goto __RETURN;
+
+    ret = MPP_OK;
+__RETURN:
+    hal_task_group_deinit(tasks);
+    return ret;
+}
+
+static MPP_RET test_group_usage(void)
+{
+    MPP_RET ret = MPP_NOK;
+    MppBufferGroup group = NULL;
+    MppBuffer buffer = NULL;
+    RK_S32 count = 0;
+    RK_S32 used = 0;
+    size_t size = 0;
+
+    if (mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL))
+        return MPP_NOK;
+
+    mpp_buffer_get(group, &buffer, SZ_4K);
+    if (NULL == buffer)
+        goto __RETURN;
+
+    mpp_buffer_group_get_usage((MppBufferGroupImpl *)group, &count, &used, &size);
+    if (count != 1 || used != 1 || size != SZ_4K) {
+        mpp_err("group usage count %d used %d size %d\n", count, used, (RK_S32)size);
+        goto __RETURN;
+    }
+
+    mpp_buffer_put(buffer);
+    buffer = NULL;
+    mpp_buffer_group_get_usage((MppBufferGroupImpl *)group, &count, &used, &size);
+    if (count != 1 || used != 0)
+        goto __RETURN;
+
+    ret = MPP_OK;
+__RETURN:
+    if (buffer)
+        mpp_buffer_put(buffer);
+    mpp_buffer_group_put(group);
+    return ret;
+}
+
+/* stats snapshot is not available before init */
+static MPP_RET test_mpi_stats(void)
+{
+    MppCtx ctx = NULL;
+    MppApi *mpi = NULL;
+    MppStats stats;
+    MPP_RET ret;
+
+    if (mpp_create(&ctx, &mpi))
+        return MPP_NOK;
+
+    ret = (mpi->stats && mpi->stats(ctx, &stats)) ? MPP_OK : MPP_NOK;
+    mpp_destroy(ctx);
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret;
+
+    mpp_log("mpp_stats_test start\n");
+
+    ret = test_slot_stats();
+    if (MPP_OK == ret)
+        ret = test_task_count();
+    if (MPP_OK == ret)
+        ret = test_group_usage();
+    if (MPP_OK == ret)
+        ret = test_mpi_stats();
+
+    mpp_log("mpp_stats_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
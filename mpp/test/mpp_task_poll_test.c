@@ -0,0 +1,228 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_task_poll_test"
+
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_task.h"
+
+/*
+ * task completion latency benchmark
+ *
+ * The worker thread takes task from the internal side of the queue and returns
+ * it after a fixed work time as the encoder thread does. The user side waits
+ * the task back by sleep polling as the legacy vpu_api encoder did, and then by
+ * port poll.
+ *
+ * Both ports wait on one condition of the queue. A task moved to one port
+ * must wake its waiter while the other port has a waiter too.
+ */
+#define POLL_TASK_COUNT     200
+#define POLL_WORK_US        1000
+#define POLL_SLEEP_US       3000
+
+typedef struct PollCtx_t {
+    MppPort         user;
+    MppPort         worker;
+    volatile RK_S32 stop;
+} PollCtx;
+
+typedef struct WaitCtx_t {
+    MppPort         port;
+    MPP_RET         ret;
+} WaitCtx;
+
+static void *worker_thread(void *arg)
+{
+    PollCtx *ctx = (PollCtx *)arg;
+    MppTask task = NULL;
+
+    while (!ctx->stop) {
+        if (mpp_port_poll(ctx->worker, (MppPollType)10))
+            continue;
+
+        mpp_port_dequeue(ctx->worker, &task);
+        if (NULL == task)
+            continue;
+
+        usleep(POLL_WORK_US);
+        mpp_port_enqueue(ctx->worker, task);
+    }
+
+    return NULL;
+}
+
+static void *wait_thread(void *arg)
+{
+    WaitCtx *wait = (WaitCtx *)arg;
+
+    wait->ret = mpp_port_poll(wait->port, (MppPollType)500);
+    return NULL;
+}
+
+static MPP_RET test_two_waiters(PollCtx *ctx)
+{
+    MPP_RET ret = MPP_NOK;
+    MppTask task = NULL;
+    WaitCtx waits[2];
+    pthread_t thds[2];
+    RK_S32 i;
+
+    /* user holds the only task so both ports are empty */
+    mpp_port_dequeue(ctx->user, &task);
+    if (NULL == task) {
+        mpp_err("no idle task on user port\n");
+        return MPP_NOK;
+    }
+
+    waits[0].port = ctx->user;
+    waits[1].port = ctx->worker;
+    /* user side waiter is queued first */
+    for (i = 0; i < 2; i++) {
+        waits[i].ret = MPP_NOK;
+        pthread_create(&thds[i], NULL, wait_thread, &waits[i]);
+        usleep(10000);
+    }
+
+    mpp_port_enqueue(ctx->user, task);
+    pthread_join(thds[1], NULL);
+    if (waits[1].ret) {
+        mpp_err("worker side waiter not woken by enqueue\n");
+        goto __RETURN;
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    /* return the task to wake the user side waiter */
+    task = NULL;
+    mpp_port_dequeue(ctx->worker, &task);
+    if (task)
+        mpp_port_enqueue(ctx->worker, task);
+
+    pthread_join(thds[0], NULL);
+    if (waits[0].ret) {
+        mpp_err("user side waiter not woken by enqueue\n");
+        ret = MPP_NOK;
+    }
+
+    return ret;
+}
+
+static MPP_RET run_tasks(const char *title, PollCtx *ctx, RK_S32 use_poll)
+{
+    MppTask task = NULL;
+    RK_S64 start = mpp_time_us();
+    RK_S64 time;
+    RK_S32 i;
+
+    for (i = 0; i < POLL_TASK_COUNT; i++) {
+        mpp_port_dequeue(ctx->user, &task);
+        if (NULL == task) {
+            mpp_err("no idle task on user port\n");
+            return MPP_NOK;
+        }
+        mpp_port_enqueue(ctx->user, task);
+
+        task = NULL;
+        if (use_poll) {
+            if (mpp_port_poll(ctx->user, MPP_POLL_BLOCK))
+                return MPP_NOK;
+        } else {
+            while (mpp_port_can_dequeue(ctx->user))
+                usleep(POLL_SLEEP_US);
+        }
+    }
+
+    time = mpp_time_us() - start;
+    mpp_log("%-12s %d tasks work %d us average completion %6.1f us\n", title,
+            POLL_TASK_COUNT, POLL_WORK_US, (double)time / POLL_TASK_COUNT);
+
+    return MPP_OK;
+}
+
+static MPP_RET test_timeout(PollCtx *ctx)
+{
+    RK_S64 start;
+    RK_S64 time;
+
+    /* worker side is empty when user holds nothing */
+    if (MPP_OK == mpp_port_poll(ctx->worker, MPP_POLL_NON_BLOCK)) {
+        mpp_err("non-block poll on empty port returns ok\n");
+        return MPP_NOK;
+    }
+
+    start = mpp_time_us();
+    if (MPP_OK == mpp_port_poll(ctx->worker, (MppPollType)20)) {
+        mpp_err("timeout poll on empty port returns ok\n");
+        return MPP_NOK;
+    }
+    time = mpp_time_us() - start;
+    if (time < 15000) {
+        mpp_err("poll returns after %lld us before timeout\n", time);
+        return MPP_NOK;
+    }
+
+    if (mpp_port_poll(ctx->user, MPP_POLL_NON_BLOCK)) {
+        mpp_err("non-block poll on idle user port failed\n");
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    MppTaskQueue queue = NULL;
+    PollCtx ctx;
+    pthread_t thd;
+
+    mpp_log("mpp_task_poll_test start\n");
+
+    if (mpp_task_queue_init(&queue) || mpp_task_queue_setup(queue, 1))
+        goto __RETURN;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.user   = mpp_task_queue_get_port(queue, MPP_PORT_INPUT);
+    ctx.worker = mpp_task_queue_get_port(queue, MPP_PORT_OUTPUT);
+
+    ret = test_timeout(&ctx);
+    if (MPP_OK == ret)
+        ret = test_two_waiters(&ctx);
+    if (ret)
+        goto __RETURN;
+
+    pthread_create(&thd, NULL, worker_thread, &ctx);
+
+    ret = run_tasks("sleep poll", &ctx, 0);
+    if (MPP_OK == ret)
+        ret = run_tasks("port poll", &ctx, 1);
+
+    ctx.stop = 1;
+    pthread_join(thd, NULL);
+
+__RETURN:
+    if (queue)
+        mpp_task_queue_deinit(queue);
+
+    mpp_log("mpp_task_poll_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "vpu_record_test"
+
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "vpu_record.h"
+
+/*
+ * vpu client record and replay test
+ *
+ * A decoder and an encoder thread send register sets to a simulated device
+ * and wait for the read back registers while the session is recorded. The
+ * same threads then run against the replay without the device. Read back
+ * registers, status and hardware time must match the recording, a changed
+ * register set and a call beyond the recording must be reported.
+ */
+#define REC_FILE                "/tmp/vpu_record_test.bin"
+#define REC_FRAME_COUNT         30
+#define REC_FAIL_FRAME          7
+
+typedef struct RecClient_t {
+    VPU_CLIENT_TYPE     type;
+    RK_U32              nregs;
+    RK_U32              hw_us;
+    RK_S32              fd;
+    VpuRecMode          mode;
+    /* replay changes the register set of this frame */
+    RK_S32              diff_frame;
+    /* replay sends one more frame than recorded */
+    RK_U32              extra;
+
+    RK_S64              time;
+    RK_U32              error;
+} RecClient;
+
+static void gen_regs(RecClient *client, RK_U32 frame, RK_U32 *regs)
+{
+    RK_U32 i;
+
+    for (i = 0; i < client->nregs; i++)
+        regs[i] = (client->type << 24) | (frame << 8) | i;
+
+    regs[1] = 0;
+    if ((RK_S32)frame == client->diff_frame)
+        regs[client->nregs / 2] ^= 0x100000;
+}
+
+/* device done registers, one frame fails with timeout */
+static RK_S32 hw_done(RK_U32 frame, RK_U32 *regs, VPU_CMD_TYPE *cmd)
+{
+    regs[1] = (frame == REC_FAIL_FRAME) ? 0x800 : 0x1;
+    *cmd = (frame == REC_FAIL_FRAME) ? VPU_SEND_CONFIG_ACK_FAIL : VPU_SEND_CONFIG_ACK_OK;
+    return (frame == REC_FAIL_FRAME) ? VPU_FAILURE : VPU_SUCCESS;
+}
+
+static void *client_thread(void *arg)
+{
+    RecClient *client = (RecClient *)arg;
+    RK_U32 regs[VPU_REG_NUM_ENC];
+    RK_U32 expect[VPU_REG_NUM_ENC];
+    RK_U32 count = REC_FRAME_COUNT + client->extra;
+    RK_S64 start = mpp_time_us();
+    RK_S32 socket = client->fd;
+    RK_U32 i;
+
+    if (client->mode == VPU_REC_RECORD) {
+        vpu_rec_init(client->type, client->fd);
+    } else {
+        socket = vpu_rec_init(client->type, -1);
+        if (socket < 0) {
+            client->error = 1;
+            return NULL;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        VPU_CMD_TYPE cmd = VPU_CMD_BUTT;
+        VPU_CMD_TYPE expect_cmd;
+        RK_S32 expect_ret;
+        RK_S32 ret;
+
+        gen_regs(client, i, regs);
+
+        if (client->mode == VPU_REC_RECORD) {
+            vpu_rec_send(socket, regs, client->nregs, VPU_SUCCESS);
+            usleep(client->hw_us);
+            ret = hw_done(i, regs, &cmd);
+            vpu_rec_wait(socket, regs, client->nregs, ret, &cmd);
+            continue;
+        }
+
+        ret = vpu_rec_send(socket, regs, client->nregs, VPU_SUCCESS);
+        if (i >= REC_FRAME_COUNT) {
+            if (ret != VPU_FAILURE) {
+                mpp_err("send beyond the recording accepted\n");
+                client->error = 1;
+            }
+            break;
+        }
+
+        memcpy(expect, regs, sizeof(regs));
+        expect_ret = hw_done(i, expect, &expect_cmd);
+        memset(regs, 0, sizeof(regs));
+
+        ret = vpu_rec_wait(socket, regs, client->nregs, VPU_SUCCESS, &cmd);
+        if (i != (RK_U32)client->diff_frame &&
+            (ret != expect_ret || cmd != expect_cmd ||
+             memcmp(regs, expect, client->nregs * sizeof(RK_U32)))) {
+            mpp_err("client %d frame %d replay result mismatch\n", client->type, i);
+            client->error = 1;
+        }
+    }
+
+    vpu_rec_release(socket);
+    client->time = mpp_time_us() - start;
+
+    return NULL;
+}
+
+static MPP_RET run_session(RecClient *clients, VpuRecMode mode, RK_S32 diff_frame,
+                           RK_U32 extra, VpuRecStat *stat)
+{
+    MPP_RET ret = MPP_NOK;
+    pthread_t thds[2];
+    RK_U32 i;
+
+    if (vpu_rec_open(REC_FILE, mode))
+        return MPP_NOK;
+
+    for (i = 0; i < 2; i++) {
+        clients[i].mode = mode;
+        clients[i].diff_frame = (mode == VPU_REC_REPLAY && i == 1) ? diff_frame : -1;
+        clients[i].extra = (mode == VPU_REC_REPLAY && i == 0) ? extra : 0;
+        clients[i].error = 0;
+    }
+
+    // replay clients start in another order than recorded
+    for (i = 0; i < 2; i++) {
+        RecClient *client = (mode == VPU_REC_REPLAY) ? &clients[1 - i] : &clients[i];
+
+        pthread_create(&thds[i], NULL, client_thread, client);
+        if (mode == VPU_REC_RECORD)
+            usleep(1000);
+    }
+    for (i = 0; i < 2; i++)
+        pthread_join(thds[i], NULL);
+
+    vpu_rec_get_stat(stat);
+    vpu_rec_close();
+
+    if (clients[0].error || clients[1].error)
+        goto __RETURN;
+
+    ret = MPP_OK;
+__RETURN:
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    RecClient clients[2];
+    VpuRecStat stat;
+    RK_S64 rec_time[2];
+    RK_U32 i;
+
+    mpp_log("vpu_record_test start\n");
+
+    memset(clients, 0, sizeof(clients));
+    clients[0].type = VPU_DEC;
+    clients[0].nregs = VPU_REG_NUM_DEC;
+    clients[0].hw_us = 3000;
+    clients[0].fd = 10;
+    clients[1].type = VPU_ENC;
+    clients[1].nregs = VPU_REG_NUM_ENC;
+    clients[1].hw_us = 5000;
+    clients[1].fd = 11;
+
+    if (run_session(clients, VPU_REC_RECORD, -1, 0, &stat)) {
+        mpp_err("record failed\n");
+        goto __RETURN;
+    }
+    for (i = 0; i < 2; i++)
+        rec_time[i] = clients[i].time;
+
+    if (run_session(clients, VPU_REC_REPLAY, -1, 0, &stat) ||
+        stat.mismatch || stat.missing || stat.wait != 2 * REC_FRAME_COUNT) {
+        mpp_err("replay failed wait %d mismatch %d missing %d\n",
+                stat.wait, stat.mismatch, stat.missing);
+        goto __RETURN;
+    }
+
+    for (i = 0; i < 2; i++) {
+        RecClient *client = &clients[i];
+
+        mpp_log("client %d %d frames record %.2f ms replay %.2f ms per frame\n",
+                client->type, REC_FRAME_COUNT,
+                (float)rec_time[i] / REC_FRAME_COUNT / 1000,
+                (float)client->time / REC_FRAME_COUNT / 1000);
+
+        // replay completes after the recorded hardware time
+        if (client->time < (RK_S64)client->hw_us * REC_FRAME_COUNT) {
+            mpp_err("client %d replay faster than recorded hardware\n", client->type);
+            goto __RETURN;
+        }
+    }
+
+    if (run_session(clients, VPU_REC_REPLAY, 12, 1, &stat) ||
+        stat.mismatch != 1 || stat.missing != 1) {
+        mpp_err("replay divergence not reported mismatch %d missing %d\n",
+                stat.mismatch, stat.missing);
+        goto __RETURN;
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    unlink(REC_FILE);
+
+    mpp_log("vpu_record_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dma_buf"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <linux/types.h>
+
+#include "mpp_log.h"
+#include "allocator_dma_buf.h"
+
+/* copy from linux/dma-buf.h which is missing in old kernel header */
+#ifndef DMA_BUF_IOCTL_SYNC
+struct dma_buf_sync {
+    __u64 flags;
+};
+
+#define DMA_BUF_SYNC_READ           (1 << 0)
+#define DMA_BUF_SYNC_WRITE          (2 << 0)
+#define DMA_BUF_SYNC_RW             (DMA_BUF_SYNC_READ | DMA_BUF_SYNC_WRITE)
+#define DMA_BUF_SYNC_START          (0 << 2)
+#define DMA_BUF_SYNC_END            (1 << 2)
+
+#define DMA_BUF_BASE                'b'
+#define DMA_BUF_IOCTL_SYNC          _IOW(DMA_BUF_BASE, 0, struct dma_buf_sync)
+#endif
+
+/* rockchip kernel extension for syncing part of the buffer */
+struct dma_buf_sync_partial {
+    __u64 flags;
+    __u32 offset;
+    __u32 len;
+};
+
+#define DMA_BUF_IOCTL_SYNC_PARTIAL  _IOW(DMA_BUF_BASE, 2, struct dma_buf_sync_partial)
+
+static RK_U32 partial_unsupported = 0;
+
+static int dma_buf_ioctl(int fd, unsigned long req, void *arg)
+{
+    int ret;
+
+    do {
+        ret = ioctl(fd, req, arg);
+    } while (ret == -1 && (errno == EINTR || errno == EAGAIN));
+
+    return ret;
+}
+
+MPP_RET dma_buf_sync(RK_S32 fd, RK_U32 flags, size_t offset, size_t size)
+{
+    __u64 sync_flags = 0;
+    int ret;
+
+    if (fd < 0)
+        return MPP_ERR_VALUE;
+
+    if (flags & MPP_ALLOCATOR_SYNC_READ)
+        sync_flags |= DMA_BUF_SYNC_READ;
+    if (flags & MPP_ALLOCATOR_SYNC_WRITE)
+        sync_flags |= DMA_BUF_SYNC_WRITE;
+    sync_flags |= (flags & MPP_ALLOCATOR_SYNC_END) ?
+                  DMA_BUF_SYNC_END : DMA_BUF_SYNC_START;
+
+    if (size && !partial_unsupported) {
+        struct dma_buf_sync_partial partial;
+
+        partial.flags = sync_flags;
+        partial.offset = (__u32)offset;
+        partial.len = (__u32)size;
+
+        ret = dma_buf_ioctl(fd, DMA_BUF_IOCTL_SYNC_PARTIAL, &partial);
+        if (!ret)
+            return MPP_OK;
+
+        if (errno != ENOTTY && errno != EINVAL) {
+            mpp_err_f("fd %d partial sync failed %s\n", fd, strerror(errno));
+            return MPP_NOK;
+        }
+
+        mpp_log_f("partial sync is not supported, sync whole buffer\n");
+        partial_unsupported = 1;
+    }
+
+    {
+        struct dma_buf_sync sync;
+
+        sync.flags = sync_flags;
+        ret = dma_buf_ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync);
+        if (ret) {
+            mpp_err_f("fd %d sync failed %s\n", fd, strerror(errno));
+            return MPP_NOK;
+        }
+    }
+
+    return MPP_OK;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ALLOCATOR_DMA_BUF_H__
+#define __ALLOCATOR_DMA_BUF_H__
+
+#include "mpp_allocator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * cpu cache maintenance on dma-buf fd shared by ion and drm allocator
+ *
+ * flags is MPP_ALLOCATOR_SYNC_XXX. Range with offset 0 and size 0 syncs the
+ * whole buffer. Partial range is only synced on kernel with partial sync
+ * ioctl, otherwise the whole buffer is synced.
+ */
+MPP_RET dma_buf_sync(RK_S32 fd, RK_U32 flags, size_t offset, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__ALLOCATOR_DMA_BUF_H__*/
@@ -28,6 +28,7 @@
 
 #include "os_mem.h"
 #include "allocator_drm.h"
+#include "allocator_dma_buf.h"
 
 #include "mpp_env.h"
 #include "mpp_mem.h"
@@ -43,6 +44,11 @@ static RK_U32 drm_debug = 0;
 
 #define drm_dbg(flag, fmt, ...) _mpp_dbg_f(drm_debug, flag, fmt, ## __VA_ARGS__)
 
+/* rockchip drm gem flag for cachable buffer */
+#ifndef ROCKCHIP_BO_CACHABLE
+#define ROCKCHIP_BO_CACHABLE        (1 << 1)
+#endif
+
 static int drm_ioctl(int fd, int req, void *arg)
 {
     int ret;
@@ -114,35 +120,25 @@ static int drm_fd_to_handle(int fd, int map_fd, RK_U32 *handle, RK_U32 flags)
 }
 
 static int drm_map(int fd, RK_U32 handle, size_t length, int prot,
-                   int flags, unsigned char **ptr, int *map_fd)
+                   int flags, unsigned char **ptr)
 {
     int ret;
     struct drm_mode_map_dumb dmmd;
     memset(&dmmd, 0, sizeof(dmmd));
     dmmd.handle = handle;
 
-    if (map_fd == NULL)
-        return -EINVAL;
     if (ptr == NULL)
         return -EINVAL;
 
-    ret = drm_handle_to_fd(fd, handle, map_fd, 0);
-    drm_dbg(DRM_FUNCTION, "drm_map fd %d", *map_fd);
-    if (ret < 0)
-        return ret;
-
     ret = drm_ioctl(fd, DRM_IOCTL_MODE_MAP_DUMB, &dmmd);
-    if (ret < 0) {
-        close(*map_fd);
+    if (ret < 0)
         return ret;
-    }
 
     drm_dbg(DRM_FUNCTION, "dev fd %d length %d", fd, length);
 
     *ptr = drm_mmap(fd, length, prot, flags, dmmd.offset);
     if (*ptr == MAP_FAILED) {
-        close(*map_fd);
-        *map_fd = -1;
+        *ptr = NULL;
         mpp_err("mmap failed: %s\n", strerror(errno));
         return -errno;
     }
@@ -150,7 +146,7 @@ static int drm_map(int fd, RK_U32 handle, size_t length, int prot,
     return ret;
 }
 
-static int drm_alloc(int fd, size_t len, size_t align, RK_U32 *handle)
+static int drm_alloc(int fd, size_t len, size_t align, RK_U32 *handle, RK_U32 flags)
 {
     int ret;
     struct drm_mode_create_dumb dmcb;
@@ -162,6 +158,7 @@ static int drm_alloc(int fd, size_t len, size_t align, RK_U32 *handle)
     dmcb.width = (len + align - 1) & (~(align - 1));
     dmcb.height = 1;
     dmcb.size = dmcb.width * dmcb.bpp;
+    dmcb.flags = flags;
 
     drm_dbg(DRM_FUNCTION, "fd %d aligned %d size %lld\n", fd, align, dmcb.size);
 
@@ -189,11 +186,12 @@ static int drm_free(int fd, RK_U32 handle)
 typedef struct {
     RK_U32  alignment;
     RK_S32  drm_device;
+    RK_U32  flags;
 } allocator_ctx_drm;
 
 const char *dev_drm = "/dev/dri/card0";
 
-MPP_RET os_allocator_drm_open(void **ctx, size_t alignment)
+MPP_RET os_allocator_drm_open(void **ctx, size_t alignment, RK_U32 flags)
 {
     RK_S32 fd;
     allocator_ctx_drm *p;
@@ -226,6 +224,7 @@ MPP_RET os_allocator_drm_open(void **ctx, size_t alignment)
          */
         p->alignment    = alignment;
         p->drm_device   = fd;
+        p->flags        = (flags & MPP_BUFFER_FLAGS_CACHABLE) ? ROCKCHIP_BO_CACHABLE : 0;
         *ctx = p;
     }
 
@@ -247,21 +246,59 @@ MPP_RET os_allocator_drm_alloc(void *ctx, MppBufferInfo *info)
     p = (allocator_ctx_drm *)ctx;
     drm_dbg(DRM_FUNCTION, "alignment %d size %d", p->alignment, info->size);
     ret = drm_alloc(p->drm_device, info->size, p->alignment,
-                    (RK_U32 *)&info->hnd);
+                    (RK_U32 *)&info->hnd, p->flags);
     if (ret) {
         mpp_err("os_allocator_drm_alloc drm_alloc failed ret %d\n", ret);
         return ret;
     }
     drm_dbg(DRM_FUNCTION, "handle %d", (RK_U32)((intptr_t)info->hnd));
-    ret = drm_map(p->drm_device, (RK_U32)((intptr_t)info->hnd), info->size,
-                  PROT_READ | PROT_WRITE, MAP_SHARED, (unsigned char **)&info->ptr, &info->fd);
+    /* hardware only needs the fd, cpu mapping is created on first access */
+    info->ptr = NULL;
+    ret = drm_handle_to_fd(p->drm_device, (RK_U32)((intptr_t)info->hnd), &info->fd, 0);
     if (ret) {
-        mpp_err("os_allocator_drm_alloc drm_map failed ret %d\n", ret);
+        mpp_err("os_allocator_drm_alloc drm_handle_to_fd failed ret %d\n", ret);
+        drm_free(p->drm_device, (RK_U32)((intptr_t)info->hnd));
         return ret;
     }
     return ret;
 }
 
+MPP_RET os_allocator_drm_mmap(void *ctx, MppBufferInfo *info)
+{
+    MPP_RET ret = MPP_OK;
+    allocator_ctx_drm *p = NULL;
+
+    if (NULL == ctx) {
+        mpp_err("os_allocator_drm_mmap do not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p = (allocator_ctx_drm *)ctx;
+    ret = drm_map(p->drm_device, (RK_U32)((intptr_t)info->hnd), info->size,
+                  PROT_READ | PROT_WRITE, MAP_SHARED, (unsigned char **)&info->ptr);
+    if (ret)
+        mpp_err("os_allocator_drm_mmap drm_map failed ret %d\n", ret);
+
+    return ret;
+}
+
+MPP_RET os_allocator_drm_munmap(void *ctx, MppBufferInfo *info)
+{
+    (void)ctx;
+    if (info->ptr) {
+        munmap(info->ptr, info->size);
+        info->ptr = NULL;
+    }
+    return MPP_OK;
+}
+
+MPP_RET os_allocator_drm_sync(void *ctx, MppBufferInfo *info, RK_U32 flags,
+                              size_t offset, size_t size)
+{
+    (void)ctx;
+    return dma_buf_sync(info->fd, flags, offset, size);
+}
+
 MPP_RET os_allocator_drm_import(void *ctx, MppBufferInfo *data)
 {
     MPP_RET ret = MPP_OK;
@@ -315,7 +352,8 @@ MPP_RET os_allocator_drm_free(void *ctx, MppBufferInfo *data)
     }
 
     p = (allocator_ctx_drm *)ctx;
-    munmap(data->ptr, data->size);
+    if (data->ptr)
+        munmap(data->ptr, data->size);
     close(data->fd);
     drm_free(p->drm_device, (RK_U32)((intptr_t)data->hnd));
     return MPP_OK;
@@ -347,4 +385,7 @@ os_allocator allocator_drm = {
     os_allocator_drm_import,
     os_allocator_drm_release,
     os_allocator_drm_close,
+    os_allocator_drm_mmap,
+    os_allocator_drm_munmap,
+    os_allocator_drm_sync,
 };
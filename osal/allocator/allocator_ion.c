@@ -33,6 +33,7 @@
 
 #include "os_mem.h"
 #include "allocator_ion.h"
+#include "allocator_dma_buf.h"
 
 #include "mpp_mem.h"
 #include "mpp_log.h"
@@ -51,6 +52,10 @@ static RK_U32 ion_debug = 0;
 
 #define ion_dbg(flag, fmt, ...) _mpp_dbg(ion_debug, flag, fmt, ## __VA_ARGS__)
 
+#ifndef ION_FLAG_CACHED
+#define ION_FLAG_CACHED             (1)
+#endif
+
 static int ion_ioctl(int fd, int req, void *arg)
 {
     int ret = ioctl(fd, req, arg);
@@ -92,8 +97,7 @@ static int ion_free(int fd, ion_user_handle_t handle)
     return ion_ioctl(fd, ION_IOC_FREE, &data);
 }
 
-static int ion_map(int fd, ion_user_handle_t handle, size_t length, int prot,
-                   int flags, off_t offset, unsigned char **ptr, int *map_fd)
+static int ion_map(int fd, ion_user_handle_t handle, int *map_fd)
 {
     int ret;
     struct ion_fd_data data = {
@@ -102,8 +106,6 @@ static int ion_map(int fd, ion_user_handle_t handle, size_t length, int prot,
 
     if (map_fd == NULL)
         return -EINVAL;
-    if (ptr == NULL)
-        return -EINVAL;
 
     ret = ion_ioctl(fd, ION_IOC_MAP, &data);
     if (ret < 0)
@@ -113,11 +115,6 @@ static int ion_map(int fd, ion_user_handle_t handle, size_t length, int prot,
         mpp_err("map ioctl returned negative fd\n");
         return -EINVAL;
     }
-    *ptr = mmap(NULL, length, prot, flags, *map_fd, offset);
-    if (*ptr == MAP_FAILED) {
-        mpp_err("mmap failed: %s\n", strerror(errno));
-        return -errno;
-    }
     return ret;
 }
 
@@ -229,6 +226,7 @@ RK_S32 check_sysfs_iommu()
 typedef struct {
     RK_U32  alignment;
     RK_S32  ion_device;
+    RK_U32  flags;
 } allocator_ctx_ion;
 
 #define VPU_IOC_MAGIC                       'l'
@@ -238,7 +236,7 @@ const char *dev_ion = "/dev/ion";
 static RK_S32 ion_heap_id = -1;
 static RK_U32 ion_heap_mask = ION_HEAP_SYSTEM_MASK;
 
-MPP_RET os_allocator_ion_open(void **ctx, size_t alignment)
+MPP_RET os_allocator_ion_open(void **ctx, size_t alignment, RK_U32 flags)
 {
     RK_S32 fd;
     allocator_ctx_ion *p;
@@ -300,6 +298,7 @@ MPP_RET os_allocator_ion_open(void **ctx, size_t alignment)
         }
         p->alignment    = alignment;
         p->ion_device   = fd;
+        p->flags        = (flags & MPP_BUFFER_FLAGS_CACHABLE) ? ION_FLAG_CACHED : 0;
         *ctx = p;
     }
 
@@ -318,15 +317,15 @@ MPP_RET os_allocator_ion_alloc(void *ctx, MppBufferInfo *info)
 
     p = (allocator_ctx_ion *)ctx;
     ret = ion_alloc(p->ion_device, info->size, p->alignment,
-                    ion_heap_mask, 0,
+                    ion_heap_mask, p->flags,
                     (ion_user_handle_t *)&info->hnd);
     if (ret) {
         mpp_err("os_allocator_ion_alloc ion_alloc failed ret %d\n", ret);
         return ret;
     }
-    ret = ion_map(p->ion_device, (ion_user_handle_t)((intptr_t)info->hnd), info->size,
-                  PROT_READ | PROT_WRITE, MAP_SHARED, (off_t)0,
-                  (unsigned char**)&info->ptr, &info->fd);
+    /* hardware only needs the fd, cpu mapping is created on first access */
+    info->ptr = NULL;
+    ret = ion_map(p->ion_device, (ion_user_handle_t)((intptr_t)info->hnd), &info->fd);
     if (ret) {
         mpp_err("os_allocator_ion_alloc ion_map failed ret %d\n", ret);
         return ret;
@@ -334,6 +333,35 @@ MPP_RET os_allocator_ion_alloc(void *ctx, MppBufferInfo *info)
     return ret;
 }
 
+MPP_RET os_allocator_ion_mmap(void *ctx, MppBufferInfo *info)
+{
+    (void)ctx;
+    info->ptr = mmap(NULL, info->size, PROT_READ | PROT_WRITE, MAP_SHARED, info->fd, 0);
+    if (info->ptr == MAP_FAILED) {
+        mpp_err_f("map error %s\n", strerror(errno));
+        info->ptr = NULL;
+        return MPP_NOK;
+    }
+    return MPP_OK;
+}
+
+MPP_RET os_allocator_ion_munmap(void *ctx, MppBufferInfo *info)
+{
+    (void)ctx;
+    if (info->ptr) {
+        munmap(info->ptr, info->size);
+        info->ptr = NULL;
+    }
+    return MPP_OK;
+}
+
+MPP_RET os_allocator_ion_sync(void *ctx, MppBufferInfo *info, RK_U32 flags,
+                              size_t offset, size_t size)
+{
+    (void)ctx;
+    return dma_buf_sync(info->fd, flags, offset, size);
+}
+
 MPP_RET os_allocator_ion_import(void *ctx, MppBufferInfo *data)
 {
     MPP_RET ret = MPP_OK;
@@ -369,7 +397,8 @@ MPP_RET os_allocator_ion_free(void *ctx, MppBufferInfo *data)
     }
 
     p = (allocator_ctx_ion *)ctx;
-    munmap(data->ptr, data->size);
+    if (data->ptr)
+        munmap(data->ptr, data->size);
     close(data->fd);
     ion_free(p->ion_device, (ion_user_handle_t)((intptr_t)data->hnd));
     return MPP_OK;
@@ -400,5 +429,8 @@ os_allocator allocator_ion = {
     os_allocator_ion_import,
     os_allocator_ion_release,
     os_allocator_ion_close,
+    os_allocator_ion_mmap,
+    os_allocator_ion_munmap,
+    os_allocator_ion_sync,
 };
 
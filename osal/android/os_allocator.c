@@ -32,11 +32,12 @@ typedef struct {
     RK_S32  fd_count;
 } allocator_ctx_normal;
 
-MPP_RET os_allocator_normal_open(void **ctx, size_t alignment)
+MPP_RET os_allocator_normal_open(void **ctx, size_t alignment, RK_U32 flags)
 {
     MPP_RET ret = MPP_OK;
     allocator_ctx_normal *p = NULL;
 
+    (void) flags;
     if (NULL == ctx) {
         mpp_err("os_allocator_open Android do not accept NULL input\n");
         return MPP_ERR_NULL_PTR;
@@ -110,6 +111,33 @@ MPP_RET os_allocator_normal_close(void *ctx)
     return MPP_NOK;
 }
 
+/* normal buffer is malloc memory so it is always mapped */
+MPP_RET os_allocator_normal_mmap(void *ctx, MppBufferInfo *info)
+{
+    (void) ctx;
+    mpp_assert(info->ptr);
+    return MPP_OK;
+}
+
+MPP_RET os_allocator_normal_munmap(void *ctx, MppBufferInfo *info)
+{
+    (void) ctx;
+    (void) info;
+    return MPP_OK;
+}
+
+/* normal buffer is cpu only memory and always coherent */
+MPP_RET os_allocator_normal_sync(void *ctx, MppBufferInfo *info, RK_U32 flags,
+                                 size_t offset, size_t size)
+{
+    (void) ctx;
+    (void) info;
+    (void) flags;
+    (void) offset;
+    (void) size;
+    return MPP_OK;
+}
+
 static os_allocator allocator_normal = {
     os_allocator_normal_open,
     os_allocator_normal_alloc,
@@ -117,6 +145,9 @@ static os_allocator allocator_normal = {
     os_allocator_normal_import,
     os_allocator_normal_release,
     os_allocator_normal_close,
+    os_allocator_normal_mmap,
+    os_allocator_normal_munmap,
+    os_allocator_normal_sync,
 };
 
 MPP_RET os_allocator_get(os_allocator *api, MppBufferType type)
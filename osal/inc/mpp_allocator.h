@@ -22,6 +22,12 @@
 
 typedef void *MppAllocator;
 
+/* cpu access flags for sync, same value as dma-buf sync flags */
+#define MPP_ALLOCATOR_SYNC_READ         (0x00000001)
+#define MPP_ALLOCATOR_SYNC_WRITE        (0x00000002)
+#define MPP_ALLOCATOR_SYNC_RW           (MPP_ALLOCATOR_SYNC_READ | MPP_ALLOCATOR_SYNC_WRITE)
+#define MPP_ALLOCATOR_SYNC_END          (0x00000004)
+
 typedef struct MppAllocatorApi_t {
     RK_U32  size;
     RK_U32  version;
@@ -30,12 +36,18 @@ typedef struct MppAllocatorApi_t {
     MPP_RET (*free)(MppAllocator allocator, MppBufferInfo *data);
     MPP_RET (*import)(MppAllocator allocator, MppBufferInfo *data);
     MPP_RET (*release)(MppAllocator allocator, MppBufferInfo *data);
+    MPP_RET (*mmap)(MppAllocator allocator, MppBufferInfo *data);
+    MPP_RET (*munmap)(MppAllocator allocator, MppBufferInfo *data);
+    /* cpu cache maintenance on [offset, offset + size) of a shared buffer */
+    MPP_RET (*sync)(MppAllocator allocator, MppBufferInfo *data, RK_U32 flags,
+                    size_t offset, size_t size);
 } MppAllocatorApi;
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* type can be ORed with MPP_BUFFER_FLAGS_XXX */
 MPP_RET mpp_allocator_get(MppAllocator *allocator, MppAllocatorApi **api, MppBufferType type);
 MPP_RET mpp_allocator_put(MppAllocator *allocator);
 
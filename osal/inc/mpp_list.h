@@ -50,6 +50,8 @@ public:
     // for status check
     RK_S32 list_is_empty();
     RK_S32 list_size();
+    // max node count ever reached
+    RK_S32 list_peak();
 
     // for vector implement - not implemented yet
     // adding function will return a key
@@ -77,6 +79,7 @@ private:
     node_destructor         destroy;
     struct mpp_list_node    *head;
     RK_S32                  count;
+    RK_S32                  peak;
     static RK_U32           keys;
     static RK_U32           get_key();
 
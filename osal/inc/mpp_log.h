@@ -91,6 +91,7 @@
 
 #define mpp_abort() do {                \
 	if (mpp_debug & MPP_ABORT) {	\
+		mpp_log_async_flush();	\
 		abort();		\
 	}				\
 } while (0)
@@ -107,6 +108,23 @@
 } while (0)
 
 
+/*
+ * asynchronous log mode:
+ * mpp_log / mpp_err only copy the format string and its arguments into a
+ * lock-free ring buffer of the calling thread. A background thread formats
+ * them with time stamp and thread id and writes them to the sink. Messages are
+ * dropped when the ring is full so the calling thread never blocks.
+ *
+ * The mode can also be enabled by environment on the first log:
+ * mpp_log_async=1 for os log, 2 for stdout, 3 for file set by mpp_log_file
+ */
+typedef enum MppLogSink_e {
+    MPP_LOG_SINK_OS         = 1,
+    MPP_LOG_SINK_STDOUT,
+    MPP_LOG_SINK_FILE,
+    MPP_LOG_SINK_BUTT,
+} MppLogSink;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -116,6 +134,12 @@ extern RK_U32 mpp_debug;
 void mpp_log_set_flag(RK_U32 flag);
 RK_U32 mpp_log_get_flag();
 
+RK_S32 mpp_log_async_start(MppLogSink sink, const char *path);
+void mpp_log_async_stop();
+/* output all queued messages before return */
+void mpp_log_async_flush();
+RK_U32 mpp_log_async_get_dropped();
+
 void _mpp_log(const char *tag, const char *fmt, const char *func, ...);
 void _mpp_err(const char *tag, const char *fmt, const char *func, ...);
 
@@ -23,22 +23,22 @@
 #include "mpp_err.h"
 
 #define mpp_malloc_tagged(type, count, tag)  \
-    (type*)mpp_osal_malloc(tag, sizeof(type) * (count))
+    (type*)mpp_osal_malloc(tag, __FUNCTION__, sizeof(type) * (count))
 
 #define mpp_malloc(type, count)  \
-    (type*)mpp_osal_malloc(MODULE_TAG, sizeof(type) * (count))
+    (type*)mpp_osal_malloc(MODULE_TAG, __FUNCTION__, sizeof(type) * (count))
 
 #define mpp_malloc_size(type, size)  \
-    (type*)mpp_osal_malloc(MODULE_TAG, size)
+    (type*)mpp_osal_malloc(MODULE_TAG, __FUNCTION__, size)
 
 #define mpp_calloc_size(type, size)  \
-    (type*)mpp_osal_calloc(MODULE_TAG, size)
+    (type*)mpp_osal_calloc(MODULE_TAG, __FUNCTION__, size)
 
 #define mpp_calloc(type, count)  \
-    (type*)mpp_osal_calloc(MODULE_TAG, sizeof(type) * (count))
+    (type*)mpp_osal_calloc(MODULE_TAG, __FUNCTION__, sizeof(type) * (count))
 
 #define mpp_realloc(ptr, type, count) \
-    (type*)mpp_osal_realloc(MODULE_TAG, ptr, sizeof(type) * (count))
+    (type*)mpp_osal_realloc(MODULE_TAG, __FUNCTION__, ptr, sizeof(type) * (count))
 
 #define mpp_free(ptr) mpp_osal_free(ptr)
 
@@ -49,12 +49,18 @@
 extern "C" {
 #endif
 
-void *mpp_osal_malloc(const char *tag, size_t size);
-void *mpp_osal_calloc(const char *tag, size_t size);
-void *mpp_osal_realloc(const char *tag, void *ptr, size_t size);
+/*
+ * tag is the module name and caller is the function name of the allocation.
+ * When mpp_mem_flag bit 0 is set all memory is tracked and the live count
+ * and size of each caller is recorded.
+ */
+void *mpp_osal_malloc(const char *tag, const char *caller, size_t size);
+void *mpp_osal_calloc(const char *tag, const char *caller, size_t size);
+void *mpp_osal_realloc(const char *tag, const char *caller, void *ptr, size_t size);
 void mpp_osal_free(void *ptr);
 
 void mpp_show_mem_status();
+void mpp_show_mem_caller_status();
 
 /*
  * mpp memory usage snapshot tool
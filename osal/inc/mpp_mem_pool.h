@@ -0,0 +1,68 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_MEM_POOL_H__
+#define __MPP_MEM_POOL_H__
+
+#include "rk_type.h"
+
+/*
+ * fixed size object pool
+ *
+ * Objects are allocated from system in slabs and recycled on put. Each thread
+ * keeps a small free object cache so that get / put of one thread normally
+ * runs without lock. Objects put by a thread other than the getter thread go
+ * back to the shared free list when the thread cache is full.
+ */
+typedef void* MppMemPool;
+
+/*
+ * pool statistic
+ *
+ * size         - object size
+ * total        - object count allocated from system
+ * used         - object count in use
+ * slab_count   - slab count allocated from system
+ * get_count    - total get count
+ * fill_count   - get count refilling thread cache from the shared list
+ */
+typedef struct MppMemPoolInfo_t {
+    size_t      size;
+    RK_S32      total;
+    RK_S32      used;
+    RK_S32      slab_count;
+    RK_S64      get_count;
+    RK_S64      fill_count;
+} MppMemPoolInfo;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MppMemPool mpp_mem_pool_init(const char *name, size_t size);
+void    mpp_mem_pool_deinit(MppMemPool pool);
+
+/* get a zeroed object */
+void   *mpp_mem_pool_get(MppMemPool pool);
+void    mpp_mem_pool_put(MppMemPool pool, void *p);
+
+MPP_RET mpp_mem_pool_info(MppMemPool pool, MppMemPoolInfo *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_MEM_POOL_H__*/
@@ -51,10 +51,42 @@ int pthread_setname_np(pthread_t thread, const char *name);
 
 #endif
 
+#include "rk_type.h"
+#include "mpp_err.h"
+
 #define THREAD_NAME_LEN 16
 
 typedef void *(*MppThreadFunc)(void *);
 
+/*
+ * thread scheduling policy
+ *
+ * cpu_mask     - bit n for cpu n, 0 keeps the inherited affinity
+ * sched        - THREAD_SCHED_DEFAULT keeps the inherited policy
+ *                THREAD_SCHED_NORMAL uses priority as nice value -20 ~ 19
+ *                THREAD_SCHED_FIFO uses priority as realtime priority 1 ~ 99
+ */
+#define THREAD_SCHED_DEFAULT    0
+#define THREAD_SCHED_NORMAL     1
+#define THREAD_SCHED_FIFO       2
+
+typedef struct MppThreadPolicy_t {
+    RK_U32      cpu_mask;
+    RK_S32      sched;
+    RK_S32      priority;
+} MppThreadPolicy;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* apply policy to the calling thread, only supported on linux */
+MPP_RET mpp_thread_apply_policy(const MppThreadPolicy *policy);
+
+#ifdef __cplusplus
+}
+#endif
+
 typedef enum {
     MPP_THREAD_UNINITED,
     MPP_THREAD_RUNNING,
@@ -62,6 +94,38 @@ typedef enum {
     MPP_THREAD_STOPPING,
 } MppThreadStatus;
 
+/*
+ * MppThread interface for C modules
+ *
+ * The thread loop runs while status is MPP_THREAD_RUNNING and waits on the
+ * THREAD_WORK mutex and condition. Stop sets MPP_THREAD_STOPPING under the
+ * lock, wakes the thread and joins it.
+ */
+#ifdef __cplusplus
+class MppThread;
+#else
+typedef struct MppThread MppThread;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MppThread *mpp_thread_create(MppThreadFunc func, void *ctx, const char *name);
+void mpp_thread_destroy(MppThread *thread);
+void mpp_thread_set_policy(MppThread *thread, const MppThreadPolicy *policy);
+void mpp_thread_start(MppThread *thread);
+void mpp_thread_stop(MppThread *thread);
+MppThreadStatus mpp_thread_get_status(MppThread *thread);
+void mpp_thread_lock(MppThread *thread);
+void mpp_thread_unlock(MppThread *thread);
+void mpp_thread_wait(MppThread *thread);
+void mpp_thread_broadcast(MppThread *thread);
+
+#ifdef __cplusplus
+}
+#endif
+
 #ifdef __cplusplus
 
 #include "mpp_log.h"
@@ -141,6 +205,7 @@ public:
     void wait(Mutex& mutex);
     void timedwait(Mutex& mutex, RK_S64 timeout);
     void signal();
+    void broadcast();
 
 private:
     pthread_cond_t mCond;
@@ -162,13 +227,17 @@ inline void Condition::timedwait(Mutex& mutex, RK_S64 timeout)
 {
     struct timespec time;
     time.tv_sec  = (time_t)(timeout >> 32);
-    time.tv_nsec = (long)timeout;
+    time.tv_nsec = (long)(timeout & 0xffffffff);
     pthread_cond_timedwait(&mCond, &mutex.mMutex, &time);
 }
 inline void Condition::signal()
 {
     pthread_cond_signal(&mCond);
 }
+inline void Condition::broadcast()
+{
+    pthread_cond_broadcast(&mCond);
+}
 
 class MppMutexCond
 {
@@ -180,6 +249,7 @@ public:
     void unlock()   { mLock.unlock(); }
     void wait()     { mCondition.wait(mLock); }
     void signal()   { mCondition.signal(); }
+    void broadcast() { mCondition.broadcast(); }
 private:
     Mutex           mLock;
     Condition       mCondition;
@@ -204,6 +274,10 @@ public:
     MppThreadStatus get_status();
     void set_status(MppThreadStatus status);
 
+    /* name and policy are applied on start */
+    void set_name(const char *name);
+    void set_policy(const MppThreadPolicy *policy);
+
     void start();
     void stop();
 
@@ -227,6 +301,11 @@ public:
         mMutexCond[id].signal();
     }
 
+    void broadcast(MppThreadSignal id = THREAD_WORK) {
+        mpp_assert(id < THREAD_SIGNAL_BUTT);
+        mMutexCond[id].broadcast();
+    }
+
 private:
     pthread_t       mThread;
     MppMutexCond    mMutexCond[THREAD_SIGNAL_BUTT];
@@ -235,6 +314,9 @@ private:
     MppThreadFunc   mFunction;
     char            mName[THREAD_NAME_LEN];
     void            *mContext;
+    MppThreadPolicy mPolicy;
+
+    static void *thread_entry(void *thread);
 
     MppThread();
     MppThread(const MppThread &);
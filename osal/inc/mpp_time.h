@@ -37,6 +37,13 @@ extern "C" {
 RK_S64 mpp_time();
 void mpp_time_diff(RK_S64 start, RK_S64 end, RK_S64 limit, char *fmt);
 
+/*
+ * monotonic clock which does not depend on MPP_DBG_TIMING, for measurement
+ * in tools and tests
+ */
+RK_S64 mpp_time_ns(void);
+RK_S64 mpp_time_us(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,16 +16,238 @@
 
 #define MODULE_TAG "mpp_allocator"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "mpp_log.h"
 #include "mpp_mem.h"
+#include "mpp_env.h"
 #include "mpp_allocator.h"
 #include "mpp_allocator_impl.h"
 
 #include "os_allocator.h"
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#define MPP_ALLOCATOR_CACHE_SUPPORT     1
+#else
+#define MPP_ALLOCATOR_CACHE_SUPPORT     0
+#endif
+
+#define MPP_ALLOCATOR_DBG_CACHE         (0x00000001)
+
+#define MPP_ALLOCATOR_CACHE_DEFAULT     32
+
 #define MPP_ALLOCATOR_LOCK(p)   pthread_mutex_lock(&(p)->lock);
 #define MPP_ALLOCATOR_UNLOCK(p) pthread_mutex_unlock(&(p)->lock);
 
+#define allocator_dbg(flag, fmt, ...)   _mpp_dbg_f(mpp_allocator_debug, flag, fmt, ## __VA_ARGS__)
+
+static RK_U32 mpp_allocator_debug = 0;
+
+#if MPP_ALLOCATOR_CACHE_SUPPORT
+/* file reference count reported by dma-buf fdinfo, -1 for unknown */
+static RK_S32 allocator_fd_count(RK_S32 fd)
+{
+    char path[64];
+    char buf[512];
+    RK_S32 count = -1;
+    ssize_t len;
+    char *pos;
+    int proc;
+
+    snprintf(path, sizeof(path), "/proc/self/fdinfo/%d", fd);
+    proc = open(path, O_RDONLY);
+    if (proc < 0)
+        return -1;
+
+    len = read(proc, buf, sizeof(buf) - 1);
+    close(proc);
+    if (len <= 0)
+        return -1;
+
+    buf[len] = '\0';
+    pos = strstr(buf, "count:");
+    if (pos)
+        count = atoi(pos + 6);
+
+    return count;
+}
+
+static void allocator_cache_free(MppAllocatorImpl *p, MppAllocatorCache *cache)
+{
+    list_del_init(&cache->list);
+    if (p->os_api.release && p->ctx)
+        p->os_api.release(p->ctx, &cache->info);
+    close(cache->key_fd);
+    mpp_free(cache);
+    p->cache_count--;
+}
+
+/*
+ * The file of an entry is only referenced by mpp itself when the exporter
+ * has freed the buffer.
+ */
+static RK_S32 allocator_cache_orphan(MppAllocatorCache *cache)
+{
+    return cache->own_count > 0 &&
+           allocator_fd_count(cache->key_fd) <= cache->own_count;
+}
+
+/*
+ * Release idle entries which are out of the most recently used cache_max
+ * entries, or whose buffer has been freed by the exporter.
+ */
+static void allocator_cache_shrink(MppAllocatorImpl *p)
+{
+    MppAllocatorCache *pos, *n;
+    RK_S32 keep = 0;
+
+    list_for_each_entry_safe(pos, n, &p->cache_list, MppAllocatorCache, list) {
+        if (pos->ref_count) {
+            keep++;
+            continue;
+        }
+
+        if (keep >= p->cache_max || allocator_cache_orphan(pos)) {
+            allocator_dbg(MPP_ALLOCATOR_DBG_CACHE, "evict fd %d ino %llu\n",
+                          pos->info.fd, pos->ino);
+            allocator_cache_free(p, pos);
+        } else
+            keep++;
+    }
+}
+
+static MPP_RET allocator_cache_import(MppAllocatorImpl *p, MppBufferInfo *info)
+{
+    MppAllocatorCache *pos, *n;
+    MppAllocatorCache *cache = NULL;
+    RK_S32 count;
+    struct stat st;
+    MPP_RET ret;
+
+    if (!p->cache_max || info->fd < 0 || fstat(info->fd, &st))
+        return p->os_api.import(p->ctx, info);
+
+    list_for_each_entry_safe(pos, n, &p->cache_list, MppAllocatorCache, list) {
+        if (pos->ino == (RK_U64)st.st_ino && pos->dev == (RK_U64)st.st_dev &&
+            pos->key_ptr == info->ptr && pos->key_size == info->size) {
+            list_del_init(&pos->list);
+            list_add(&pos->list, &p->cache_list);
+            pos->ref_count++;
+            p->cache_hit++;
+
+            info->ptr = pos->info.ptr;
+            info->hnd = pos->info.hnd;
+            info->fd  = pos->info.fd;
+            return MPP_OK;
+        }
+    }
+
+    cache = mpp_calloc(MppAllocatorCache, 1);
+    if (NULL == cache)
+        return p->os_api.import(p->ctx, info);
+
+    count = allocator_fd_count(info->fd);
+
+    // hold the file to keep its inode unique while cached
+    cache->key_fd = dup(info->fd);
+    if (cache->key_fd < 0) {
+        mpp_free(cache);
+        return p->os_api.import(p->ctx, info);
+    }
+
+    cache->dev      = (RK_U64)st.st_dev;
+    cache->ino      = (RK_U64)st.st_ino;
+    cache->key_ptr  = info->ptr;
+    cache->key_size = info->size;
+
+    ret = p->os_api.import(p->ctx, info);
+    if (ret) {
+        close(cache->key_fd);
+        mpp_free(cache);
+        return ret;
+    }
+
+    cache->info = *info;
+    cache->ref_count = 1;
+    cache->own_count = -1;
+    if (count > 0) {
+        count = allocator_fd_count(cache->key_fd) - count;
+        if (count > 0)
+            cache->own_count = count;
+    }
+
+    list_add(&cache->list, &p->cache_list);
+    p->cache_count++;
+    p->cache_miss++;
+
+    allocator_dbg(MPP_ALLOCATOR_DBG_CACHE, "import fd %d ino %llu own %d count %d\n",
+                  info->fd, cache->ino, cache->own_count, p->cache_count);
+
+    allocator_cache_shrink(p);
+    return MPP_OK;
+}
+
+static MPP_RET allocator_cache_release(MppAllocatorImpl *p, MppBufferInfo *info)
+{
+    MppAllocatorCache *pos, *n;
+
+    list_for_each_entry_safe(pos, n, &p->cache_list, MppAllocatorCache, list) {
+        if (pos->ref_count && pos->info.fd == info->fd && pos->info.ptr == info->ptr) {
+            pos->ref_count--;
+            if (pos->ref_count)
+                return MPP_OK;
+
+            /* do not pin a buffer the exporter has already freed */
+            if (allocator_cache_orphan(pos)) {
+                allocator_dbg(MPP_ALLOCATOR_DBG_CACHE, "drop fd %d ino %llu\n",
+                              pos->info.fd, pos->ino);
+                allocator_cache_free(p, pos);
+                return MPP_OK;
+            }
+
+            list_del_init(&pos->list);
+            list_add(&pos->list, &p->cache_list);
+            return MPP_OK;
+        }
+    }
+
+    return p->os_api.release(p->ctx, info);
+}
+
+static void allocator_cache_clear(MppAllocatorImpl *p)
+{
+    MppAllocatorCache *pos, *n;
+
+    if (p->cache_hit || p->cache_miss)
+        allocator_dbg(MPP_ALLOCATOR_DBG_CACHE, "import cache hit %u miss %u\n",
+                      p->cache_hit, p->cache_miss);
+
+    list_for_each_entry_safe(pos, n, &p->cache_list, MppAllocatorCache, list) {
+        allocator_cache_free(p, pos);
+    }
+}
+#else
+static MPP_RET allocator_cache_import(MppAllocatorImpl *p, MppBufferInfo *info)
+{
+    return p->os_api.import(p->ctx, info);
+}
+
+static MPP_RET allocator_cache_release(MppAllocatorImpl *p, MppBufferInfo *info)
+{
+    return p->os_api.release(p->ctx, info);
+}
+
+static void allocator_cache_clear(MppAllocatorImpl *p)
+{
+    (void)p;
+}
+#endif
+
 MPP_RET mpp_allocator_alloc(MppAllocator allocator, MppBufferInfo *info)
 {
     if (NULL == allocator || NULL == info) {
@@ -73,7 +295,7 @@ MPP_RET mpp_allocator_import(MppAllocator allocator, MppBufferInfo *info)
     MppAllocatorImpl *p = (MppAllocatorImpl *)allocator;
     MPP_ALLOCATOR_LOCK(p);
     if (p->os_api.import && p->ctx) {
-        ret = p->os_api.import(p->ctx, info);
+        ret = allocator_cache_import(p, info);
     }
     MPP_ALLOCATOR_UNLOCK(p);
 
@@ -93,24 +315,90 @@ MPP_RET mpp_allocator_release(MppAllocator allocator, MppBufferInfo *info)
     MppAllocatorImpl *p = (MppAllocatorImpl *)allocator;
     MPP_ALLOCATOR_LOCK(p);
     if (p->os_api.release && p->ctx) {
-        ret = p->os_api.release(p->ctx, info);
+        ret = allocator_cache_release(p, info);
     }
     MPP_ALLOCATOR_UNLOCK(p);
 
     return ret;
 }
 
+/*
+ * allocated buffer may have no cpu mapping, it is mapped on the first cpu
+ * access. allocator without mmap function always keeps its buffer mapped.
+ */
+static MPP_RET mpp_allocator_mmap(MppAllocator allocator, MppBufferInfo *info)
+{
+    if (NULL == allocator || NULL == info) {
+        mpp_err_f("invalid input: allocator %p info %p\n",
+                  allocator, info);
+        return MPP_ERR_UNKNOW;
+    }
+
+    MPP_RET ret = MPP_OK;
+    MppAllocatorImpl *p = (MppAllocatorImpl *)allocator;
+    MPP_ALLOCATOR_LOCK(p);
+    if (NULL == info->ptr && p->os_api.mmap && p->ctx)
+        ret = p->os_api.mmap(p->ctx, info);
+    MPP_ALLOCATOR_UNLOCK(p);
+
+    return ret;
+}
+
+static MPP_RET mpp_allocator_munmap(MppAllocator allocator, MppBufferInfo *info)
+{
+    if (NULL == allocator || NULL == info) {
+        mpp_err_f("invalid input: allocator %p info %p\n",
+                  allocator, info);
+        return MPP_ERR_UNKNOW;
+    }
+
+    MPP_RET ret = MPP_OK;
+    MppAllocatorImpl *p = (MppAllocatorImpl *)allocator;
+    MPP_ALLOCATOR_LOCK(p);
+    if (info->ptr && p->os_api.munmap && p->ctx)
+        ret = p->os_api.munmap(p->ctx, info);
+    MPP_ALLOCATOR_UNLOCK(p);
+
+    return ret;
+}
+
+/*
+ * sync only touches the buffer itself, allocator lock is not taken to avoid
+ * serializing cpu access of all buffers in one group
+ */
+static MPP_RET mpp_allocator_sync(MppAllocator allocator, MppBufferInfo *info, RK_U32 flags,
+                                  size_t offset, size_t size)
+{
+    if (NULL == allocator || NULL == info) {
+        mpp_err_f("invalid input: allocator %p info %p\n",
+                  allocator, info);
+        return MPP_ERR_UNKNOW;
+    }
+
+    MppAllocatorImpl *p = (MppAllocatorImpl *)allocator;
+    if (p->os_api.sync && p->ctx)
+        return p->os_api.sync(p->ctx, info, flags, offset, size);
+
+    return MPP_OK;
+}
+
 static MppAllocatorApi mpp_allocator_api = {
     sizeof(mpp_allocator_api),
-    1,
+    3,
     mpp_allocator_alloc,
     mpp_allocator_free,
     mpp_allocator_import,
     mpp_allocator_release,
+    mpp_allocator_mmap,
+    mpp_allocator_munmap,
+    mpp_allocator_sync,
 };
 
 MPP_RET mpp_allocator_get(MppAllocator *allocator, MppAllocatorApi **api, MppBufferType type)
 {
+    RK_U32 flags = (RK_U32)type & MPP_BUFFER_FLAGS_MASK;
+
+    type = (MppBufferType)(type & MPP_BUFFER_TYPE_MASK);
     if (NULL == allocator || NULL == api || type >= MPP_BUFFER_TYPE_BUTT) {
         mpp_err_f("invalid input: allocator %p api %p type %d\n",
                   allocator, api, type);
@@ -121,14 +409,30 @@ MPP_RET mpp_allocator_get(MppAllocator *allocator, MppAllocatorApi **api, MppBuf
     if (NULL == p) {
         mpp_err("mpp_allocator_get failed to malloc allocator context\n");
         return MPP_ERR_NULL_PTR;
-    } else
-        p->type = type;
+    } else {
+        p->type  = type;
+        p->flags = flags;
+    }
+
+    mpp_env_get_u32("mpp_allocator_debug", &mpp_allocator_debug, 0);
 
+    /*
+     * max number of imported external buffer kept mapped, 0 to disable
+     * normal buffer import has nothing to save so it is off by default
+     */
+    RK_U32 cache_max = (type == MPP_BUFFER_TYPE_ION || type == MPP_BUFFER_TYPE_DRM) ?
+                       (MPP_ALLOCATOR_CACHE_DEFAULT) : (0);
+    mpp_env_get_u32("mpp_buffer_import_cache", &cache_max, cache_max);
+    INIT_LIST_HEAD(&p->cache_list);
+    p->cache_count  = 0;
+    p->cache_max    = cache_max;
+    p->cache_hit    = 0;
+    p->cache_miss   = 0;
 
     MPP_RET ret = os_allocator_get(&p->os_api, type);
     if (MPP_OK == ret) {
         p->alignment = SZ_4K;
-        ret = p->os_api.open(&p->ctx, p->alignment);
+        ret = p->os_api.open(&p->ctx, p->alignment, p->flags);
     }
     if (MPP_OK == ret) {
         pthread_mutexattr_t attr;
@@ -157,7 +461,13 @@ MPP_RET mpp_allocator_put(MppAllocator *allocator)
     }
 
     MppAllocatorImpl *p = (MppAllocatorImpl *)*allocator;
+    if (NULL == p)
+        return MPP_OK;
+
     *allocator = NULL;
+    MPP_ALLOCATOR_LOCK(p);
+    allocator_cache_clear(p);
+    MPP_ALLOCATOR_UNLOCK(p);
     if (p->os_api.close && p->ctx)
         p->os_api.close(p->ctx);
     pthread_mutex_destroy(&p->lock);
@@ -17,15 +17,43 @@
 #ifndef __MPP_ALLOCATOR_IMPL_H__
 #define __MPP_ALLOCATOR_IMPL_H__
 
+#include "mpp_list.h"
 #include "mpp_thread.h"
 #include "os_allocator.h"
 
+/*
+ * import cache entry
+ * An external buffer is identified by the device and inode of its fd. The
+ * entry keeps a dup of the fd so the inode can not be reused by another
+ * buffer while it is cached, and keeps the imported handle and mapping.
+ */
+typedef struct MppAllocatorCache_t {
+    struct list_head    list;
+    RK_U64              dev;
+    RK_U64              ino;
+    void                *key_ptr;
+    size_t              key_size;
+    RK_S32              key_fd;
+    // file count added by mpp itself, -1 for unknown
+    RK_S32              own_count;
+    RK_S32              ref_count;
+    MppBufferInfo       info;
+} MppAllocatorCache;
+
 typedef struct MppAllocatorImpl_t {
     pthread_mutex_t lock;
     MppBufferType   type;
+    RK_U32          flags;
     size_t          alignment;
     os_allocator    os_api;
     void            *ctx;
+
+    // import cache in most recently used order
+    struct list_head    cache_list;
+    RK_S32              cache_count;
+    RK_S32              cache_max;
+    RK_U32              cache_hit;
+    RK_U32              cache_miss;
 } MppAllocatorImpl;
 
 #endif /*__MPP_ALLOCATOR_IMPL_H__*/
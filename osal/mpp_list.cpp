@@ -88,6 +88,8 @@ RK_S32 mpp_list::add_at_head(void *data, RK_S32 size)
         if (node) {
             mpp_list_add(node, head);
             count++;
+            if (count > peak)
+                peak = count;
             ret = 0;
         } else {
             ret = -ENOMEM;
@@ -104,6 +106,8 @@ RK_S32 mpp_list::add_at_tail(void *data, RK_S32 size)
         if (node) {
             mpp_list_add_tail(node, head);
             count++;
+            if (count > peak)
+                peak = count;
             ret = 0;
         } else {
             ret = -ENOMEM;
@@ -184,6 +188,12 @@ RK_S32 mpp_list::list_size()
     return ret;
 }
 
+RK_S32 mpp_list::list_peak()
+{
+    RK_S32 ret = peak;
+    return ret;
+}
+
 RK_S32 mpp_list::add_by_key(void *data, RK_S32 size, RK_U32 *key)
 {
     RK_S32 ret = 0;
@@ -194,6 +204,8 @@ RK_S32 mpp_list::add_by_key(void *data, RK_S32 size, RK_U32 *key)
         if (node) {
             mpp_list_add_tail(node, head);
             count++;
+            if (count > peak)
+                peak = count;
             ret = 0;
         } else {
             ret = -ENOMEM;
@@ -292,7 +304,8 @@ void mpp_list::signal()
 mpp_list::mpp_list(node_destructor func)
     : destroy(NULL),
       head(NULL),
-      count(0)
+      count(0),
+      peak(0)
 {
     destroy = func;
     head = (mpp_list_node*)malloc(sizeof(mpp_list_node));
@@ -25,6 +25,7 @@
 #include "mpp_common.h"
 
 #include "os_log.h"
+#include "mpp_log_async.h"
 
 #define MPP_LOG_MAX_LEN     256
 
@@ -84,7 +85,9 @@ void _mpp_log(const char *tag, const char *fmt, const char *fname, ...)
 {
     va_list args;
     va_start(args, fname);
-    __mpp_log(os_log, tag, fmt, fname, args);
+    mpp_log_async_env_init();
+    if (mpp_log_async_write(0, tag, fmt, fname, args))
+        __mpp_log(os_log, tag, fmt, fname, args);
     va_end(args);
 }
 
@@ -92,7 +95,9 @@ void _mpp_err(const char *tag, const char *fmt, const char *fname, ...)
 {
     va_list args;
     va_start(args, fname);
-    __mpp_log(os_err, tag, fmt, fname, args);
+    mpp_log_async_env_init();
+    if (mpp_log_async_write(1, tag, fmt, fname, args))
+        __mpp_log(os_err, tag, fmt, fname, args);
     va_end(args);
 }
 
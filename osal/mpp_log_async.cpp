@@ -0,0 +1,906 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_log"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_env.h"
+#include "mpp_time.h"
+#include "mpp_thread.h"
+
+#include "os_log.h"
+#include "mpp_log_async.h"
+
+/*
+ * Asynchronous log backend
+ *
+ * Each logging thread owns a single producer / single consumer ring buffer.
+ * A log call only copies tag, function name, format string and the raw
+ * arguments into a compact record on its own ring without any lock or stdio
+ * call. The drainer thread merges all rings by time stamp, formats records
+ * and writes them to the selected sink.
+ *
+ * The log path must not log itself, so all memory here comes from libc
+ * instead of mpp_malloc which may report through mpp_log.
+ */
+#if defined(__linux__) && defined(__GNUC__)
+#define LOG_ASYNC_SUPPORT       1
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/syscall.h>
+#else
+#define LOG_ASYNC_SUPPORT       0
+#endif
+
+#if LOG_ASYNC_SUPPORT
+
+#define LOG_RING_SIZE           (64 * 1024)
+#define LOG_RING_MASK           (LOG_RING_SIZE - 1)
+#define LOG_RECORD_MAX          1024
+#define LOG_LINE_MAX            1024
+#define LOG_TAG_MAX             32
+#define LOG_FNAME_MAX           64
+/* same as MPP_LOG_MAX_LEN, longer format goes to the synchronous warning */
+#define LOG_FMT_MAX             256
+#define LOG_SPEC_MAX            32
+#define LOG_DRAIN_INTERVAL_MS   5
+
+#define LOG_ALIGN(x)            (((x) + 7) & (~7))
+
+#define LOG_LOAD(p)             __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define LOG_STORE(p, v)         __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+typedef enum LogRecType_e {
+    LOG_REC_PAD,
+    LOG_REC_LOG,
+    LOG_REC_ERR,
+} LogRecType;
+
+/* record header, followed by tag, function name, format and argument slots */
+typedef struct LogRecord_t {
+    RK_U32          size;
+    RK_U32          type;
+    RK_S64          time;
+    RK_U16          tag_len;
+    RK_U16          fname_len;
+    RK_U16          fmt_len;
+    RK_U16          arg_size;
+} LogRecord;
+
+typedef enum LogArgType_e {
+    LOG_ARG_NONE,
+    LOG_ARG_INT,
+    LOG_ARG_LONG,
+    LOG_ARG_LLONG,
+    LOG_ARG_SIZE,
+    LOG_ARG_INTMAX,
+    LOG_ARG_PTRDIFF,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_LDOUBLE,
+    LOG_ARG_STR,
+    LOG_ARG_PTR,
+    LOG_ARG_COUNT,
+} LogArgType;
+
+typedef struct LogSpec_t {
+    LogArgType      type;
+    RK_S32          star_w;
+    RK_S32          star_p;
+    RK_S32          len;
+} LogSpec;
+
+typedef struct LogRing_t {
+    struct LogRing_t *next;
+    RK_U8           *buf;
+    /* read position written by drainer, write position written by owner */
+    RK_U32          head;
+    RK_U32          tail;
+    RK_S32          tid;
+    RK_S32          dead;
+} LogRing;
+
+typedef union LogRecordBuf_u {
+    LogRecord       hdr;
+    long double     align;
+    RK_U8           buf[LOG_RECORD_MAX];
+} LogRecordBuf;
+
+/* ring list, sink and drain are protected by log_lock */
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t log_key_once = PTHREAD_ONCE_INIT;
+static pthread_once_t log_env_once = PTHREAD_ONCE_INIT;
+static pthread_key_t log_key;
+static MppThread *log_thread = NULL;
+static LogRing *log_rings = NULL;
+static MppLogSink log_sink = MPP_LOG_SINK_OS;
+static FILE *log_fp = NULL;
+static RK_S32 log_running = 0;
+static RK_S32 log_atexit = 0;
+static RK_S32 log_on = 0;
+static RK_U32 log_dropped = 0;
+static RK_U32 log_dropped_reported = 0;
+
+static void log_os_write(void (*func)(const char*, const char*, va_list),
+                         const char *tag, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    func(tag, fmt, args);
+    va_end(args);
+}
+
+/*
+ * parse one conversion specification starting from '%'
+ * only the argument type is needed, flags / width / precision are kept in
+ * the specification string and handled by snprintf on drain
+ */
+static RK_S32 log_parse_spec(const char *p, LogSpec *spec)
+{
+    const char *q = p + 1;
+    RK_S32 lmod = 0;
+
+    memset(spec, 0, sizeof(*spec));
+
+    while (*q && strchr("-+ #0'", *q))
+        q++;
+
+    if (*q == '*') {
+        spec->star_w = 1;
+        q++;
+    } else {
+        while (*q >= '0' && *q <= '9')
+            q++;
+    }
+
+    if (*q == '.') {
+        q++;
+        if (*q == '*') {
+            spec->star_p = 1;
+            q++;
+        } else {
+            while (*q >= '0' && *q <= '9')
+                q++;
+        }
+    }
+
+    switch (*q) {
+    case 'h' : {
+        q++;
+        if (*q == 'h')
+            q++;
+    } break;
+    case 'l' : {
+        q++;
+        if (*q == 'l') {
+            q++;
+            lmod = 'q';
+        } else
+            lmod = 'l';
+    } break;
+    case 'q' :
+    case 'L' :
+    case 'z' :
+    case 'j' :
+    case 't' : {
+        lmod = *q++;
+    } break;
+    default : {
+    } break;
+    }
+
+    switch (*q) {
+    case 'd' :
+    case 'i' :
+    case 'u' :
+    case 'o' :
+    case 'x' :
+    case 'X' :
+    case 'c' : {
+        if (*q == 'c' && lmod)
+            return -1;
+
+        switch (lmod) {
+        case 'l' : spec->type = LOG_ARG_LONG; break;
+        case 'q' :
+        case 'L' : spec->type = LOG_ARG_LLONG; break;
+        case 'z' : spec->type = LOG_ARG_SIZE; break;
+        case 'j' : spec->type = LOG_ARG_INTMAX; break;
+        case 't' : spec->type = LOG_ARG_PTRDIFF; break;
+        default  : spec->type = LOG_ARG_INT; break;
+        }
+    } break;
+    case 'e' :
+    case 'E' :
+    case 'f' :
+    case 'F' :
+    case 'g' :
+    case 'G' :
+    case 'a' :
+    case 'A' : {
+        spec->type = (lmod == 'L') ? LOG_ARG_LDOUBLE : LOG_ARG_DOUBLE;
+    } break;
+    case 's' : {
+        if (lmod)
+            return -1;
+        spec->type = LOG_ARG_STR;
+    } break;
+    case 'p' : {
+        spec->type = LOG_ARG_PTR;
+    } break;
+    case 'n' : {
+        spec->type = LOG_ARG_COUNT;
+    } break;
+    case '%' : {
+        if (q != p + 1)
+            return -1;
+        spec->type = LOG_ARG_NONE;
+    } break;
+    default : {
+        return -1;
+    } break;
+    }
+
+    spec->len = (RK_S32)(q + 1 - p);
+    return (spec->len < LOG_SPEC_MAX) ? 0 : -1;
+}
+
+static RK_S32 log_slot_size(LogArgType type)
+{
+    return (type == LOG_ARG_LDOUBLE) ? LOG_ALIGN(sizeof(long double)) : 8;
+}
+
+/* copy the arguments of fmt into slots, return the used size */
+static RK_S32 log_capture_args(const char *fmt, va_list args, RK_U8 *dst, RK_S32 size)
+{
+    RK_S32 pos = 0;
+    const char *p;
+    va_list ap;
+
+    va_copy(ap, args);
+
+    for (p = fmt; *p; p++) {
+        LogSpec spec;
+        RK_S64 val = 0;
+
+        if (*p != '%')
+            continue;
+
+        if (log_parse_spec(p, &spec))
+            break;
+
+        p += spec.len - 1;
+
+        if (spec.type == LOG_ARG_NONE)
+            continue;
+
+        if (spec.type == LOG_ARG_COUNT) {
+            /* writing back to caller memory is not possible when deferred */
+            (void)va_arg(ap, void *);
+            continue;
+        }
+
+        if (pos + (spec.star_w + spec.star_p) * 8 + log_slot_size(spec.type) > size)
+            break;
+
+        if (spec.star_w) {
+            val = va_arg(ap, int);
+            memcpy(dst + pos, &val, 8);
+            pos += 8;
+        }
+        if (spec.star_p) {
+            val = va_arg(ap, int);
+            memcpy(dst + pos, &val, 8);
+            pos += 8;
+        }
+
+        switch (spec.type) {
+        case LOG_ARG_INT :      val = va_arg(ap, int); break;
+        case LOG_ARG_LONG :     val = va_arg(ap, long); break;
+        case LOG_ARG_LLONG :    val = va_arg(ap, long long); break;
+        case LOG_ARG_SIZE :     val = (RK_S64)va_arg(ap, size_t); break;
+        case LOG_ARG_INTMAX :   val = (RK_S64)va_arg(ap, intmax_t); break;
+        case LOG_ARG_PTRDIFF :  val = (RK_S64)va_arg(ap, ptrdiff_t); break;
+        case LOG_ARG_PTR :      val = (RK_S64)(intptr_t)va_arg(ap, void *); break;
+        case LOG_ARG_DOUBLE : {
+            double d = va_arg(ap, double);
+            memcpy(&val, &d, 8);
+        } break;
+        case LOG_ARG_LDOUBLE : {
+            long double d = va_arg(ap, long double);
+            memcpy(dst + pos, &d, sizeof(d));
+            pos += log_slot_size(spec.type);
+        } continue;
+        case LOG_ARG_STR : {
+            const char *str = va_arg(ap, const char *);
+            RK_U32 len;
+
+            if (NULL == str)
+                str = "(null)";
+
+            /* string is truncated to the space left in the record */
+            len = (RK_U32)strnlen(str, size - pos - 8 - 1);
+            memcpy(dst + pos, &len, sizeof(len));
+            memcpy(dst + pos + 8, str, len);
+            dst[pos + 8 + len] = '\0';
+            pos += LOG_ALIGN(8 + len + 1);
+        } continue;
+        default : {
+        } break;
+        }
+
+        memcpy(dst + pos, &val, 8);
+        pos += 8;
+    }
+
+    va_end(ap);
+    return pos;
+}
+
+#define LOG_SNPRINTF(dst, size, spec, s, w, pr, val) \
+    (((s) == 3) ? snprintf(dst, size, spec, w, pr, val) : \
+     ((s) == 1) ? snprintf(dst, size, spec, w, val) : \
+     ((s) == 2) ? snprintf(dst, size, spec, pr, val) : \
+     snprintf(dst, size, spec, val))
+
+/* format captured arguments, a specification without argument is kept as text */
+static RK_S32 log_format(const char *fmt, const RK_U8 *arg, RK_S32 arg_size,
+                         char *dst, RK_S32 size)
+{
+    RK_S32 pos = 0;
+    RK_S32 rd = 0;
+    const char *p = fmt;
+
+    while (*p && pos < size - 1) {
+        char spec_str[LOG_SPEC_MAX];
+        LogSpec spec;
+        RK_S64 val = 0;
+        RK_S32 w = 0;
+        RK_S32 pr = 0;
+        RK_S32 stars;
+        RK_S32 left = size - pos;
+        RK_S32 ret = 0;
+
+        if (*p != '%') {
+            dst[pos++] = *p++;
+            continue;
+        }
+
+        if (log_parse_spec(p, &spec))
+            goto __LITERAL;
+
+        if (spec.type == LOG_ARG_NONE) {
+            dst[pos++] = '%';
+            p += spec.len;
+            continue;
+        }
+
+        if (spec.type == LOG_ARG_COUNT) {
+            p += spec.len;
+            continue;
+        }
+
+        if (rd + (spec.star_w + spec.star_p) * 8 + log_slot_size(spec.type) > arg_size)
+            goto __LITERAL;
+
+        if (spec.star_w) {
+            memcpy(&val, arg + rd, 8);
+            w = (RK_S32)val;
+            rd += 8;
+        }
+        if (spec.star_p) {
+            memcpy(&val, arg + rd, 8);
+            pr = (RK_S32)val;
+            rd += 8;
+        }
+        stars = spec.star_w | (spec.star_p << 1);
+
+        memcpy(spec_str, p, spec.len);
+        spec_str[spec.len] = '\0';
+
+        if (spec.type == LOG_ARG_LDOUBLE) {
+            long double d;
+
+            memcpy(&d, arg + rd, sizeof(d));
+            rd += log_slot_size(spec.type);
+            ret = LOG_SNPRINTF(dst + pos, left, spec_str, stars, w, pr, d);
+        } else if (spec.type == LOG_ARG_STR) {
+            RK_U32 len;
+
+            memcpy(&len, arg + rd, sizeof(len));
+            ret = LOG_SNPRINTF(dst + pos, left, spec_str, stars, w, pr,
+                               (const char *)(arg + rd + 8));
+            rd += LOG_ALIGN(8 + len + 1);
+        } else {
+            memcpy(&val, arg + rd, 8);
+            rd += 8;
+
+            switch (spec.type) {
+            case LOG_ARG_INT :
+                ret = LOG_SNPRINTF(dst + pos, left, spec_str, stars, w, pr, (int)val);
+                break;
+            case LOG_ARG_LONG :
+                ret = LOG_SNPRINTF(dst + pos, left, spec_str, stars, w, pr, (long)val);
+                break;
+            case LOG_ARG_LLONG :
+                ret = LOG_SNPRINTF(dst + pos, left, spec_str, stars, w, pr, (long long)val);
+                break;
+            case LOG_ARG_SIZE :
+                ret = LOG_SNPRINTF(dst + pos, left, spec_str, stars, w, pr, (size_t)val);
+                break;
+            case LOG_ARG_INTMAX :
+                ret = LOG_SNPRINTF(dst + pos, left, spec_str, stars, w, pr, (intmax_t)val);
+                break;
+            case LOG_ARG_PTRDIFF :
+                ret = LOG_SNPRINTF(dst + pos, left, spec_str, stars, w, pr, (ptrdiff_t)val);
+                break;
+            case LOG_ARG_PTR :
+                ret = LOG_SNPRINTF(dst + pos, left, spec_str, stars, w, pr, (void *)(intptr_t)val);
+                break;
+            case LOG_ARG_DOUBLE : {
+                double d;
+
+                memcpy(&d, &val, 8);
+                ret = LOG_SNPRINTF(dst + pos, left, spec_str, stars, w, pr, d);
+            } break;
+            default : {
+            } break;
+            }
+        }
+
+        if (ret > 0)
+            pos += (ret < left) ? ret : (left - 1);
+
+        p += spec.len;
+        continue;
+
+    __LITERAL:
+        /* unsupported or truncated argument, keep the rest as text */
+        while (*p && pos < size - 1)
+            dst[pos++] = *p++;
+    }
+
+    dst[pos] = '\0';
+    return pos;
+}
+
+static void log_output(LogRing *ring, LogRecord *rec)
+{
+    char line[LOG_LINE_MAX];
+    const char *tag = (const char *)(rec + 1);
+    const char *fname = tag + rec->tag_len;
+    const char *fmt = fname + rec->fname_len;
+    RK_U8 *arg = (RK_U8 *)rec + LOG_ALIGN(sizeof(LogRecord) + rec->tag_len +
+                                          rec->fname_len + rec->fmt_len);
+    time_t sec = (time_t)(rec->time / 1000000);
+    struct tm tm;
+    RK_S32 pos;
+
+    localtime_r(&sec, &tm);
+    pos = snprintf(line, sizeof(line), "%02d:%02d:%02d.%06d %5d ",
+                   tm.tm_hour, tm.tm_min, tm.tm_sec,
+                   (RK_S32)(rec->time % 1000000), ring->tid);
+
+    if (log_sink != MPP_LOG_SINK_OS)
+        pos += snprintf(line + pos, sizeof(line) - pos, "%s: ", tag);
+
+    if (rec->fname_len > 1)
+        pos += snprintf(line + pos, sizeof(line) - pos, "%s ", fname);
+
+    pos += log_format(fmt, arg, rec->arg_size, line + pos, sizeof(line) - pos);
+
+    if (line[pos - 1] != '\n') {
+        if (pos >= (RK_S32)sizeof(line) - 1)
+            pos = sizeof(line) - 2;
+        line[pos++] = '\n';
+        line[pos] = '\0';
+    }
+
+    switch (log_sink) {
+    case MPP_LOG_SINK_STDOUT : {
+        fputs(line, stdout);
+    } break;
+    case MPP_LOG_SINK_FILE : {
+        fputs(line, log_fp);
+    } break;
+    default : {
+        log_os_write((rec->type == LOG_REC_ERR) ? os_err : os_log, tag, "%s", line);
+    } break;
+    }
+}
+
+/* return the first record on ring, padding at the ring end is skipped */
+static LogRecord *log_ring_peek(LogRing *ring)
+{
+    RK_U32 tail = LOG_LOAD(&ring->tail);
+
+    while (ring->head != tail) {
+        LogRecord *rec = (LogRecord *)(ring->buf + (ring->head & LOG_RING_MASK));
+
+        if (rec->type != LOG_REC_PAD)
+            return rec;
+
+        LOG_STORE(&ring->head, ring->head + rec->size);
+    }
+
+    return NULL;
+}
+
+static RK_S32 log_ring_push(LogRing *ring, const void *rec, RK_U32 size)
+{
+    RK_U32 tail = ring->tail;
+    RK_U32 head = LOG_LOAD(&ring->head);
+    RK_U32 off = tail & LOG_RING_MASK;
+    RK_U32 contig = LOG_RING_SIZE - off;
+    RK_U32 need = (contig < size) ? (contig + size) : size;
+
+    if (LOG_RING_SIZE - (tail - head) < need)
+        return -1;
+
+    /* record never wraps, fill the ring end with a padding record */
+    if (contig < size) {
+        LogRecord *pad = (LogRecord *)(ring->buf + off);
+
+        pad->size = contig;
+        pad->type = LOG_REC_PAD;
+        tail += contig;
+        off = 0;
+    }
+
+    memcpy(ring->buf + off, rec, size);
+    LOG_STORE(&ring->tail, tail + size);
+    return 0;
+}
+
+static void log_ring_free(LogRing *ring)
+{
+    LogRing **pp = &log_rings;
+
+    while (*pp && *pp != ring)
+        pp = &(*pp)->next;
+
+    if (*pp)
+        *pp = ring->next;
+
+    free(ring->buf);
+    free(ring);
+}
+
+static RK_S32 log_drain_l()
+{
+    RK_S32 count = 0;
+    RK_U32 dropped;
+    LogRing *ring;
+
+    for (;;) {
+        LogRing *sel = NULL;
+        LogRecord *sel_rec = NULL;
+
+        /* output in time order across all threads */
+        for (ring = log_rings; ring; ring = ring->next) {
+            LogRecord *rec = log_ring_peek(ring);
+
+            if (rec && (NULL == sel_rec || rec->time < sel_rec->time)) {
+                sel = ring;
+                sel_rec = rec;
+            }
+        }
+
+        if (NULL == sel)
+            break;
+
+        log_output(sel, sel_rec);
+        LOG_STORE(&sel->head, sel->head + sel_rec->size);
+        count++;
+    }
+
+    dropped = LOG_LOAD(&log_dropped);
+    if (dropped != log_dropped_reported) {
+        log_os_write(os_err, MODULE_TAG, "%u messages dropped on full ring\n",
+                     dropped - log_dropped_reported);
+        log_dropped_reported = dropped;
+    }
+
+    /* release rings of exited threads */
+    ring = log_rings;
+    while (ring) {
+        LogRing *next = ring->next;
+
+        if (LOG_LOAD(&ring->dead) && NULL == log_ring_peek(ring))
+            log_ring_free(ring);
+
+        ring = next;
+    }
+
+    if (count) {
+        if (log_sink == MPP_LOG_SINK_FILE)
+            fflush(log_fp);
+        else if (log_sink == MPP_LOG_SINK_STDOUT)
+            fflush(stdout);
+    }
+
+    return count;
+}
+
+static void log_ring_release(void *ctx)
+{
+    LogRing *ring = (LogRing *)ctx;
+
+    pthread_mutex_lock(&log_lock);
+    if (!log_running && NULL == log_ring_peek(ring))
+        log_ring_free(ring);
+    else
+        LOG_STORE(&ring->dead, 1);
+    pthread_mutex_unlock(&log_lock);
+}
+
+static void log_key_init()
+{
+    pthread_key_create(&log_key, log_ring_release);
+}
+
+static LogRing *log_ring_get()
+{
+    LogRing *ring = (LogRing *)pthread_getspecific(log_key);
+
+    if (ring)
+        return ring;
+
+    ring = (LogRing *)calloc(1, sizeof(LogRing));
+    if (NULL == ring)
+        return NULL;
+
+    ring->buf = (RK_U8 *)malloc(LOG_RING_SIZE);
+    if (NULL == ring->buf) {
+        free(ring);
+        return NULL;
+    }
+    ring->tid = (RK_S32)syscall(SYS_gettid);
+
+    pthread_mutex_lock(&log_lock);
+    ring->next = log_rings;
+    log_rings = ring;
+    pthread_mutex_unlock(&log_lock);
+
+    pthread_setspecific(log_key, ring);
+    return ring;
+}
+
+static void *log_async_thread(void *ctx)
+{
+    (void)ctx;
+
+    while (MPP_THREAD_RUNNING == log_thread->get_status()) {
+        RK_S32 count;
+
+        pthread_mutex_lock(&log_lock);
+        count = log_drain_l();
+        pthread_mutex_unlock(&log_lock);
+
+        if (!count)
+            msleep(LOG_DRAIN_INTERVAL_MS);
+    }
+
+    return NULL;
+}
+
+static void log_env_read()
+{
+    RK_U32 sink = 0;
+    char *path = NULL;
+
+    mpp_env_get_u32("mpp_log_async", &sink, 0);
+    if (!sink)
+        return;
+
+    mpp_env_get_str("mpp_log_file", &path, NULL);
+    if (mpp_log_async_start((MppLogSink)sink, path))
+        log_os_write(os_err, MODULE_TAG, "failed to start async log sink %d file %s\n",
+                     sink, path);
+}
+
+RK_S32 mpp_log_async_write(RK_S32 is_err, const char *tag, const char *fmt,
+                           const char *fname, va_list args)
+{
+    LogRecordBuf rec;
+    LogRing *ring;
+    struct timeval tv;
+    RK_S32 tag_len, fname_len, fmt_len;
+    RK_S32 pos, arg_size;
+
+    if (!__atomic_load_n(&log_on, __ATOMIC_RELAXED))
+        return -1;
+
+    fmt_len = (RK_S32)strnlen(fmt, LOG_FMT_MAX);
+    if (fmt_len >= LOG_FMT_MAX)
+        return -1;
+
+    ring = log_ring_get();
+    if (NULL == ring)
+        return -1;
+
+    if (NULL == tag)
+        tag = MODULE_TAG;
+
+    tag_len = (RK_S32)strnlen(tag, LOG_TAG_MAX - 1);
+    fname_len = (fname) ? (RK_S32)strnlen(fname, LOG_FNAME_MAX - 1) : 0;
+
+    pos = sizeof(LogRecord);
+    memcpy(rec.buf + pos, tag, tag_len);
+    rec.buf[pos + tag_len] = '\0';
+    pos += tag_len + 1;
+    if (fname_len)
+        memcpy(rec.buf + pos, fname, fname_len);
+    rec.buf[pos + fname_len] = '\0';
+    pos += fname_len + 1;
+    memcpy(rec.buf + pos, fmt, fmt_len + 1);
+    pos = LOG_ALIGN(pos + fmt_len + 1);
+
+    arg_size = log_capture_args(fmt, args, rec.buf + pos, LOG_RECORD_MAX - pos);
+
+    gettimeofday(&tv, NULL);
+    rec.hdr.size = pos + arg_size;
+    rec.hdr.type = (is_err) ? LOG_REC_ERR : LOG_REC_LOG;
+    rec.hdr.time = (RK_S64)tv.tv_sec * 1000000 + tv.tv_usec;
+    rec.hdr.tag_len = tag_len + 1;
+    rec.hdr.fname_len = fname_len + 1;
+    rec.hdr.fmt_len = fmt_len + 1;
+    rec.hdr.arg_size = arg_size;
+
+    if (log_ring_push(ring, &rec, rec.hdr.size))
+        __atomic_add_fetch(&log_dropped, 1, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+void mpp_log_async_env_init()
+{
+    pthread_once(&log_env_once, log_env_read);
+}
+
+RK_S32 mpp_log_async_start(MppLogSink sink, const char *path)
+{
+    FILE *fp = NULL;
+
+    if (sink < MPP_LOG_SINK_OS || sink >= MPP_LOG_SINK_BUTT)
+        return -1;
+
+    if (sink == MPP_LOG_SINK_FILE) {
+        if (NULL == path)
+            return -1;
+
+        fp = fopen(path, "w");
+        if (NULL == fp)
+            return -1;
+    }
+
+    pthread_once(&log_key_once, log_key_init);
+
+    pthread_mutex_lock(&log_lock);
+    if (log_running) {
+        pthread_mutex_unlock(&log_lock);
+        if (fp)
+            fclose(fp);
+        return -1;
+    }
+
+    log_sink = sink;
+    log_fp = fp;
+    /* MppThread applies the thread policy env as other mpp threads */
+    if (NULL == log_thread)
+        log_thread = new MppThread(log_async_thread, NULL, "mpp_log");
+    if (log_thread)
+        log_thread->start();
+    if (NULL == log_thread || MPP_THREAD_RUNNING != log_thread->get_status()) {
+        log_fp = NULL;
+        pthread_mutex_unlock(&log_lock);
+        if (fp)
+            fclose(fp);
+        return -1;
+    }
+
+    log_running = 1;
+    LOG_STORE(&log_on, 1);
+
+    if (!log_atexit) {
+        log_atexit = 1;
+        atexit(mpp_log_async_stop);
+    }
+    pthread_mutex_unlock(&log_lock);
+
+    return 0;
+}
+
+void mpp_log_async_stop()
+{
+    pthread_mutex_lock(&log_lock);
+    if (!log_running) {
+        pthread_mutex_unlock(&log_lock);
+        return;
+    }
+    LOG_STORE(&log_on, 0);
+    pthread_mutex_unlock(&log_lock);
+
+    log_thread->stop();
+
+    pthread_mutex_lock(&log_lock);
+    log_drain_l();
+    if (log_fp) {
+        fclose(log_fp);
+        log_fp = NULL;
+    }
+    log_running = 0;
+    pthread_mutex_unlock(&log_lock);
+}
+
+void mpp_log_async_flush()
+{
+    pthread_mutex_lock(&log_lock);
+    if (log_running)
+        log_drain_l();
+    pthread_mutex_unlock(&log_lock);
+}
+
+RK_U32 mpp_log_async_get_dropped()
+{
+    return LOG_LOAD(&log_dropped);
+}
+
+#else
+
+RK_S32 mpp_log_async_write(RK_S32 is_err, const char *tag, const char *fmt,
+                           const char *fname, va_list args)
+{
+    (void)is_err;
+    (void)tag;
+    (void)fmt;
+    (void)fname;
+    (void)args;
+    return -1;
+}
+
+void mpp_log_async_env_init()
+{
+}
+
+RK_S32 mpp_log_async_start(MppLogSink sink, const char *path)
+{
+    (void)sink;
+    (void)path;
+    return -1;
+}
+
+void mpp_log_async_stop()
+{
+}
+
+void mpp_log_async_flush()
+{
+}
+
+RK_U32 mpp_log_async_get_dropped()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_LOG_ASYNC_H__
+#define __MPP_LOG_ASYNC_H__
+
+#include <stdarg.h>
+
+#include "rk_type.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Queue one message to the calling thread ring buffer.
+ * Return 0 when the message is queued or dropped on full ring, otherwise the
+ * caller should print it synchronously.
+ */
+RK_S32 mpp_log_async_write(RK_S32 is_err, const char *tag, const char *fmt,
+                           const char *fname, va_list args);
+
+/* read mpp_log_async / mpp_log_file environment once */
+void mpp_log_async_env_init();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_LOG_ASYNC_H__*/
@@ -16,6 +16,7 @@
 
 #define MODULE_TAG "mpp_mem"
 
+#include <stdint.h>
 #include <string.h>
 
 #include "rk_type.h"
@@ -36,39 +37,264 @@
 // default memory align size is set to 32
 #define RK_OSAL_MEM_ALIGN       32
 
-static RK_U32 mpp_mem_flag  = 0;
-static RK_U64 osal_mem_index = 0;
-static struct list_head mem_list;
-static pthread_mutex_t mem_list_lock;
+/*
+ * memory tracking table
+ * Tracked memory is recorded in open addressing hash tables keyed by pointer.
+ * The pointer hash selects one of the shards first so threads working on
+ * different memory rarely wait on the same lock. Each shard also keeps the
+ * allocation statistic of the callers of memory in the shard.
+ */
+#define MEM_SHARD_BITS          4
+#define MEM_SHARD_COUNT         (1 << MEM_SHARD_BITS)
+#define MEM_NODE_INIT_SIZE      256
+#define MEM_SITE_INIT_SIZE      64
+// removed node keeps a tombstone for the probe chain
+#define MEM_NODE_DELETED        ((void *)(intptr_t)-1)
+
+struct mem_site;
 
 struct mem_node {
-    struct list_head list;
-    void *ptr;
-    size_t size;
-    RK_U64 index;
+    void        *ptr;
+    size_t      size;
+    RK_U64      index;
 
     /* memory node extra information */
-    char tag[MPP_TAG_SIZE];
+    const char  *tag;
+    const char  *caller;
+    struct mem_site *site;
+};
+
+/* caller statistic is never freed so memory node can keep its pointer */
+struct mem_site {
+    const char  *caller;
+    const char  *tag;
+    // live memory count and size
+    RK_S32      count;
+    size_t      size;
+    // total allocation count and size
+    RK_U64      total_count;
+    RK_U64      total_size;
 };
 
+struct mem_shard {
+    pthread_mutex_t     lock;
+
+    struct mem_node     *nodes;
+    RK_U32              node_max;
+    RK_U32              node_count;
+    RK_U32              node_deleted;
+
+    struct mem_site     **sites;
+    RK_U32              site_max;
+    RK_U32              site_count;
+};
+
+static RK_U32 mpp_mem_flag  = 0;
+static RK_U64 osal_mem_index = 0;
+static struct mem_shard mem_shards[MEM_SHARD_COUNT];
+
 static void get_osal_mem_flag()
 {
     static RK_U32 once = 1;
     if (once) {
-        mpp_env_get_u32("mpp_mem_flag", &mpp_mem_flag, 0);
+        RK_U32 i;
 
-        INIT_LIST_HEAD(&mem_list);
+        mpp_env_get_u32("mpp_mem_flag", &mpp_mem_flag, 0);
 
         pthread_mutexattr_t attr;
         pthread_mutexattr_init(&attr);
         pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
-        pthread_mutex_init(&mem_list_lock, &attr);
+        for (i = 0; i < MEM_SHARD_COUNT; i++)
+            pthread_mutex_init(&mem_shards[i].lock, &attr);
         pthread_mutexattr_destroy(&attr);
         once = 0;
     }
 }
 
-void *mpp_osal_malloc(const char *tag, size_t size)
+static RK_U64 mem_hash(const void *ptr)
+{
+    RK_U64 h = (RK_U64)(uintptr_t)ptr;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static struct mem_shard *mem_shard_get(const void *ptr)
+{
+    return &mem_shards[mem_hash(ptr) & (MEM_SHARD_COUNT - 1)];
+}
+
+/* find node slot of ptr, return NULL when not found */
+static struct mem_node *mem_node_find(struct mem_shard *shard, const void *ptr)
+{
+    RK_U32 mask = shard->node_max - 1;
+    RK_U32 pos;
+
+    if (NULL == shard->nodes)
+        return NULL;
+
+    pos = (RK_U32)(mem_hash(ptr) >> MEM_SHARD_BITS) & mask;
+    while (shard->nodes[pos].ptr) {
+        if (shard->nodes[pos].ptr == ptr)
+            return &shard->nodes[pos];
+        pos = (pos + 1) & mask;
+    }
+    return NULL;
+}
+
+static void mem_node_insert(struct mem_node *nodes, RK_U32 max, struct mem_node *node)
+{
+    RK_U32 mask = max - 1;
+    RK_U32 pos = (RK_U32)(mem_hash(node->ptr) >> MEM_SHARD_BITS) & mask;
+
+    while (nodes[pos].ptr && nodes[pos].ptr != MEM_NODE_DELETED)
+        pos = (pos + 1) & mask;
+
+    nodes[pos] = *node;
+}
+
+/* grow or clean tombstone of node table before insert */
+static MPP_RET mem_node_reserve(struct mem_shard *shard)
+{
+    RK_U32 max = shard->node_max;
+    struct mem_node *nodes;
+    RK_U32 i;
+
+    if ((shard->node_count + shard->node_deleted + 1) * 4 < max * 3)
+        return MPP_OK;
+
+    if (0 == max)
+        max = MEM_NODE_INIT_SIZE;
+    else if ((shard->node_count + 1) * 2 >= max)
+        max *= 2;
+
+    nodes = (struct mem_node *)calloc(max, sizeof(struct mem_node));
+    if (NULL == nodes)
+        return MPP_ERR_MALLOC;
+
+    for (i = 0; i < shard->node_max; i++) {
+        struct mem_node *node = &shard->nodes[i];
+
+        if (node->ptr && node->ptr != MEM_NODE_DELETED)
+            mem_node_insert(nodes, max, node);
+    }
+
+    free(shard->nodes);
+    shard->nodes = nodes;
+    shard->node_max = max;
+    shard->node_deleted = 0;
+    return MPP_OK;
+}
+
+static struct mem_site *mem_site_get(struct mem_shard *shard, const char *caller, const char *tag)
+{
+    RK_U32 mask;
+    RK_U32 pos;
+
+    if ((shard->site_count + 1) * 2 > shard->site_max) {
+        RK_U32 max = (shard->site_max) ? (shard->site_max * 2) : (MEM_SITE_INIT_SIZE);
+        struct mem_site **sites = (struct mem_site **)calloc(max, sizeof(struct mem_site *));
+        RK_U32 i;
+
+        if (NULL == sites)
+            return NULL;
+
+        for (i = 0; i < shard->site_max; i++) {
+            struct mem_site *site = shard->sites[i];
+
+            if (NULL == site)
+                continue;
+
+            pos = (RK_U32)(mem_hash(site->caller) >> MEM_SHARD_BITS) & (max - 1);
+            while (sites[pos])
+                pos = (pos + 1) & (max - 1);
+            sites[pos] = site;
+        }
+
+        free(shard->sites);
+        shard->sites = sites;
+        shard->site_max = max;
+    }
+
+    mask = shard->site_max - 1;
+    pos = (RK_U32)(mem_hash(caller) >> MEM_SHARD_BITS) & mask;
+    while (shard->sites[pos]) {
+        if (shard->sites[pos]->caller == caller)
+            return shard->sites[pos];
+        pos = (pos + 1) & mask;
+    }
+
+    shard->sites[pos] = (struct mem_site *)calloc(1, sizeof(struct mem_site));
+    if (shard->sites[pos]) {
+        shard->sites[pos]->caller = caller;
+        shard->sites[pos]->tag = tag;
+        shard->site_count++;
+    }
+    return shard->sites[pos];
+}
+
+static void mem_node_add(void *ptr, size_t size, const char *tag, const char *caller)
+{
+    struct mem_shard *shard = mem_shard_get(ptr);
+    struct mem_site *site;
+    struct mem_node node;
+
+    node.ptr    = ptr;
+    node.size   = size;
+    node.index  = __sync_fetch_and_add(&osal_mem_index, 1);
+    node.tag    = tag;
+    node.caller = (caller) ? (caller) : (tag);
+
+    pthread_mutex_lock(&shard->lock);
+    if (MPP_OK == mem_node_reserve(shard)) {
+        site = mem_site_get(shard, node.caller, tag);
+        if (site) {
+            site->count++;
+            site->size += size;
+            site->total_count++;
+            site->total_size += size;
+        }
+
+        node.site = site;
+        mem_node_insert(shard->nodes, shard->node_max, &node);
+        shard->node_count++;
+    } else {
+        mpp_err_f("failed to track memory %p size %d\n", ptr, size);
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/* remove ptr from tracking table, return 0 if ptr is not tracked */
+static RK_U32 mem_node_del(void *ptr)
+{
+    struct mem_shard *shard = mem_shard_get(ptr);
+    struct mem_node *node;
+    RK_U32 found = 0;
+
+    pthread_mutex_lock(&shard->lock);
+    node = mem_node_find(shard, ptr);
+    if (node) {
+        struct mem_site *site = node->site;
+
+        if (site) {
+            site->count--;
+            site->size -= node->size;
+        }
+        node->ptr = MEM_NODE_DELETED;
+        shard->node_count--;
+        shard->node_deleted++;
+        found = 1;
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    return found;
+}
+
+void *mpp_osal_malloc(const char *tag, const char *caller, size_t size)
 {
     void *ptr;
 
@@ -79,37 +305,26 @@ void *mpp_osal_malloc(const char *tag, size_t size)
     if (mpp_mem_flag & OSAL_MEM_RUNTIME_LOG)
         mpp_log("mpp_malloc  tag %-16s size %-8u ret %p\n", tag, size, ptr);
 
-    if ((mpp_mem_flag & OSAL_MEM_LIST_EN) && ptr) {
-        struct mem_node *node = (struct mem_node *)malloc(sizeof(struct mem_node));
-        mpp_assert(node);
-        INIT_LIST_HEAD(&node->list);
-        node->ptr   = ptr;
-        node->size  = size;
-        snprintf(node->tag, sizeof(node->tag), "%s", tag);
-
-        pthread_mutex_lock(&mem_list_lock);
-        node->index = osal_mem_index++;
-        list_add_tail(&node->list, &mem_list);
-        pthread_mutex_unlock(&mem_list_lock);
-    }
+    if ((mpp_mem_flag & OSAL_MEM_LIST_EN) && ptr)
+        mem_node_add(ptr, size, tag, caller);
 
     return ptr;
 }
 
-void *mpp_osal_calloc(const char *tag, size_t size)
+void *mpp_osal_calloc(const char *tag, const char *caller, size_t size)
 {
-    void *ptr = mpp_osal_malloc(tag, size);
+    void *ptr = mpp_osal_malloc(tag, caller, size);
     if (ptr)
         memset(ptr, 0, size);
     return ptr;
 }
 
-void *mpp_osal_realloc(const char *tag, void *ptr, size_t size)
+void *mpp_osal_realloc(const char *tag, const char *caller, void *ptr, size_t size)
 {
-    void *ret;
+    void *ret = NULL;
 
     if (NULL == ptr)
-        return mpp_osal_malloc(tag, size);
+        return mpp_osal_malloc(tag, caller, size);
 
     if (0 == size)
         return NULL;
@@ -117,24 +332,12 @@ void *mpp_osal_realloc(const char *tag, void *ptr, size_t size)
     get_osal_mem_flag();
 
     if (mpp_mem_flag & OSAL_MEM_LIST_EN) {
-        struct mem_node *pos, *n;
-
-        ret = NULL;
-        pthread_mutex_lock(&mem_list_lock);
-        list_for_each_entry_safe(pos, n, &mem_list, struct mem_node, list) {
-            if (ptr == pos->ptr) {
-                if (MPP_OK == os_realloc(ptr, &pos->ptr, RK_OSAL_MEM_ALIGN, size)) {
-                    pos->size   = size;
-                    strncpy(pos->tag, tag, sizeof(pos->tag));
-                    ret = pos->ptr;
-                } else {
-                    list_del_init(&pos->list);
-                    free(pos);
-                }
-                break;
-            }
+        if (mem_node_del(ptr)) {
+            if (MPP_OK == os_realloc(ptr, &ret, RK_OSAL_MEM_ALIGN, size))
+                mem_node_add(ret, size, tag, caller);
+        } else {
+            mpp_err_f("can not found match on realloc %p\n", ptr);
         }
-        pthread_mutex_unlock(&mem_list_lock);
     } else {
         os_realloc(ptr, &ret, RK_OSAL_MEM_ALIGN, size);
     }
@@ -156,21 +359,7 @@ void mpp_osal_free(void *ptr)
     get_osal_mem_flag();
 
     if (mpp_mem_flag & OSAL_MEM_LIST_EN) {
-        struct mem_node *pos, *n;
-        RK_U32 found_match = 0;
-
-        pthread_mutex_lock(&mem_list_lock);
-        list_for_each_entry_safe(pos, n, &mem_list, struct mem_node, list) {
-            if (ptr == pos->ptr) {
-                list_del_init(&pos->list);
-                free(pos);
-                found_match = 1;
-                break;
-            }
-        }
-        pthread_mutex_unlock(&mem_list_lock);
-
-        if (!found_match)
+        if (!mem_node_del(ptr))
             mpp_err_f("can not found match on free %p\n", ptr);
     }
 
@@ -186,49 +375,135 @@ void mpp_osal_free(void *ptr)
  */
 void mpp_show_mem_status()
 {
-    struct mem_node *pos, *n;
+    RK_U32 i, j;
+
+    for (i = 0; i < MEM_SHARD_COUNT; i++) {
+        struct mem_shard *shard = &mem_shards[i];
 
-    pthread_mutex_lock(&mem_list_lock);
-    list_for_each_entry_safe(pos, n, &mem_list, struct mem_node, list) {
-        mpp_log("unfree memory %p size %d tag %s index %llu",
-                pos->ptr, pos->size, pos->tag, pos->index);
+        pthread_mutex_lock(&shard->lock);
+        for (j = 0; j < shard->node_max; j++) {
+            struct mem_node *pos = &shard->nodes[j];
+
+            if (NULL == pos->ptr || pos->ptr == MEM_NODE_DELETED)
+                continue;
+
+            mpp_log("unfree memory %p size %d tag %s caller %s index %llu",
+                    pos->ptr, pos->size, pos->tag, pos->caller, pos->index);
+        }
+        pthread_mutex_unlock(&shard->lock);
     }
-    pthread_mutex_unlock(&mem_list_lock);
+}
+
+/*
+ * dump memory statistic of each caller
+ * the same caller found in different shards is merged here
+ */
+void mpp_show_mem_caller_status()
+{
+    struct mem_site *sites = NULL;
+    RK_U32 count = 0;
+    RK_U32 max = 0;
+    RK_U32 i, j, k;
+
+    for (i = 0; i < MEM_SHARD_COUNT; i++) {
+        struct mem_shard *shard = &mem_shards[i];
+
+        pthread_mutex_lock(&shard->lock);
+        for (j = 0; j < shard->site_max; j++) {
+            struct mem_site *site = shard->sites[j];
+
+            if (NULL == site)
+                continue;
+
+            for (k = 0; k < count; k++) {
+                if (sites[k].caller == site->caller)
+                    break;
+            }
+
+            if (k == count) {
+                if (count >= max) {
+                    RK_U32 new_max = (max) ? (max * 2) : (MEM_SITE_INIT_SIZE);
+                    struct mem_site *tmp = (struct mem_site *)realloc(sites, new_max * sizeof(*sites));
+
+                    if (NULL == tmp)
+                        continue;
+
+                    sites = tmp;
+                    max = new_max;
+                }
+                memset(&sites[count], 0, sizeof(sites[count]));
+                sites[count].caller = site->caller;
+                sites[count].tag = site->tag;
+                count++;
+            }
+
+            sites[k].count          += site->count;
+            sites[k].size           += site->size;
+            sites[k].total_count    += site->total_count;
+            sites[k].total_size     += site->total_size;
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+
+    for (k = 0; k < count; k++) {
+        mpp_log("tag %-16s caller %-32s live %6d size %10llu total %8llu size %12llu\n",
+                sites[k].tag, sites[k].caller, sites[k].count, (RK_U64)sites[k].size,
+                sites[k].total_count, sites[k].total_size);
+    }
+
+    free(sites);
 }
 
 typedef struct MppMemSnapshotImpl {
-    struct list_head    list;
+    struct mem_node     *nodes;
     RK_U64              total_size;
     RK_U32              total_count;
 } MppMemSnapshotImpl;
 
 MPP_RET mpp_mem_get_snapshot(MppMemSnapshot *hnd)
 {
-    struct mem_node *pos, *n;
     MppMemSnapshotImpl *p = (MppMemSnapshotImpl *)malloc(sizeof(MppMemSnapshotImpl));
+    RK_U32 max = 0;
+    RK_U32 i, j;
+
     if (!p) {
         mpp_err_f("failed to alloc");
         *hnd = NULL;
         return MPP_NOK;
     }
 
-    INIT_LIST_HEAD(&p->list);
+    p->nodes       = NULL;
     p->total_size  = 0;
     p->total_count = 0;
 
-    pthread_mutex_lock(&mem_list_lock);
-    list_for_each_entry_safe(pos, n, &mem_list, struct mem_node, list) {
-        struct mem_node *node = (struct mem_node *)malloc(sizeof(struct mem_node));
-        mpp_assert(node);
+    /* shards are copied one by one so the snapshot is not one atomic view */
+    for (i = 0; i < MEM_SHARD_COUNT; i++) {
+        struct mem_shard *shard = &mem_shards[i];
+
+        pthread_mutex_lock(&shard->lock);
+        if (p->total_count + shard->node_count > max) {
+            RK_U32 new_max = p->total_count + shard->node_count;
+            struct mem_node *nodes = (struct mem_node *)realloc(p->nodes, new_max * sizeof(*nodes));
+
+            mpp_assert(nodes);
+            if (nodes) {
+                p->nodes = nodes;
+                max = new_max;
+            }
+        }
+
+        for (j = 0; j < shard->node_max && p->total_count < max; j++) {
+            struct mem_node *pos = &shard->nodes[j];
 
-        memcpy(node, pos, sizeof(*pos));
-        INIT_LIST_HEAD(&node->list);
-        list_add_tail(&node->list, &p->list);
-        p->total_size += pos->size;
-        p->total_count++;
+            if (NULL == pos->ptr || pos->ptr == MEM_NODE_DELETED)
+                continue;
+
+            p->nodes[p->total_count++] = *pos;
+            p->total_size += pos->size;
+        }
+        pthread_mutex_unlock(&shard->lock);
     }
     *hnd = p;
-    pthread_mutex_unlock(&mem_list_lock);
 
     return MPP_OK;
 }
@@ -237,16 +512,10 @@ MPP_RET mpp_mem_put_snapshot(MppMemSnapshot *hnd)
 {
     if (hnd && *hnd) {
         MppMemSnapshotImpl *p = (MppMemSnapshotImpl *)*hnd;
-        struct mem_node *pos, *n;
 
-        pthread_mutex_lock(&mem_list_lock);
-        list_for_each_entry_safe(pos, n, &p->list, struct mem_node, list) {
-            list_del_init(&pos->list);
-            free(pos);
-        }
+        free(p->nodes);
         free(p);
         *hnd = NULL;
-        pthread_mutex_unlock(&mem_list_lock);
     }
 
     return MPP_OK;
@@ -261,23 +530,21 @@ MPP_RET mpp_mem_squash_snapshot(MppMemSnapshot hnd0, MppMemSnapshot hnd1)
     }
     MppMemSnapshotImpl *p0 = (MppMemSnapshotImpl *)hnd0;
     MppMemSnapshotImpl *p1 = (MppMemSnapshotImpl *)hnd1;
-    struct mem_node *pos0, *n0;
-    struct mem_node *pos1, *n1;
+    RK_U32 i, j;
 
     mpp_log_f("snapshot0 total count %6d size %d\n", p0->total_count, p0->total_size);
     mpp_log_f("snapshot1 total count %6d size %d\n", p1->total_count, p1->total_size);
 
-    pthread_mutex_lock(&mem_list_lock);
     /* handle 0 search */
-    list_for_each_entry_safe(pos0, n0, &p0->list, struct mem_node, list) {
+    for (i = 0; i < p0->total_count; i++) {
+        struct mem_node *pos0 = &p0->nodes[i];
         RK_U32 found_match = 0;
 
-        list_for_each_entry_safe(pos1, n1, &p1->list, struct mem_node, list) {
-            if (pos0->index == pos1->index) {
-                list_del_init(&pos0->list);
-                list_del_init(&pos1->list);
-                free(pos0);
-                free(pos1);
+        for (j = 0; j < p1->total_count; j++) {
+            struct mem_node *pos1 = &p1->nodes[j];
+
+            if (pos1->ptr && pos0->index == pos1->index) {
+                pos1->ptr = NULL;
                 found_match = 1;
                 break;
             }
@@ -290,13 +557,15 @@ MPP_RET mpp_mem_squash_snapshot(MppMemSnapshot hnd0, MppMemSnapshot hnd1)
     }
 
     /* handle 1 search */
-    list_for_each_entry_safe(pos1, n1, &p1->list, struct mem_node, list) {
-        mpp_log_f("snapshot1 %p found mismatch memory %p size %d tag %s index %llu",
-                  p1, pos1->ptr, pos1->size, pos1->tag, pos1->index);
+    for (j = 0; j < p1->total_count; j++) {
+        struct mem_node *pos1 = &p1->nodes[j];
+
+        if (pos1->ptr) {
+            mpp_log_f("snapshot1 %p found mismatch memory %p size %d tag %s index %llu",
+                      p1, pos1->ptr, pos1->size, pos1->tag, pos1->index);
+        }
     }
-    pthread_mutex_unlock(&mem_list_lock);
 
     return MPP_OK;
 }
 #endif
-
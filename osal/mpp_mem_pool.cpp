@@ -0,0 +1,297 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_mem_pool"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+
+#include "mpp_mem_pool.h"
+
+/* object count of one slab and max free object count kept by one thread */
+#define POOL_SLAB_SIZE          32
+#define POOL_CACHE_MAX          64
+#define POOL_SLAB_HEAD          16
+
+typedef struct MppMemPoolImpl_t MppMemPoolImpl;
+
+/* free object is linked by its first pointer */
+typedef struct MppMemPoolNode_t {
+    struct MppMemPoolNode_t *next;
+} MppMemPoolNode;
+
+typedef struct MppMemPoolSlab_t {
+    struct MppMemPoolSlab_t *next;
+} MppMemPoolSlab;
+
+/* free object cache of one thread */
+typedef struct MppMemPoolCache_t {
+    MppMemPoolImpl      *pool;
+    MppMemPoolNode      *list;
+    RK_S32              count;
+} MppMemPoolCache;
+
+struct MppMemPoolImpl_t {
+    const char          *name;
+    size_t              size;
+    size_t              obj_size;
+
+    // all slabs and the shared free list protected by lock
+    Mutex               *lock;
+    MppMemPoolSlab      *slabs;
+    MppMemPoolNode      *free_list;
+    RK_S32              total;
+    RK_S32              slab_count;
+
+    pthread_key_t       cache_key;
+    RK_S32              cache_valid;
+
+    // statistic accessed by atomic operation
+    RK_S32              used;
+    RK_S64              get_count;
+    RK_S64              fill_count;
+};
+
+/* return count free object from cache to shared list, called with lock */
+static void cache_flush(MppMemPoolCache *cache, RK_S32 count)
+{
+    MppMemPoolImpl *pool = cache->pool;
+
+    while (count-- > 0 && cache->list) {
+        MppMemPoolNode *node = cache->list;
+        cache->list = node->next;
+        cache->count--;
+        node->next = pool->free_list;
+        pool->free_list = node;
+    }
+}
+
+/* move half cache size of free object to cache, called with lock */
+static void cache_fill(MppMemPoolCache *cache)
+{
+    MppMemPoolImpl *pool = cache->pool;
+    RK_S32 i;
+
+    if (NULL == pool->free_list) {
+        MppMemPoolSlab *slab = (MppMemPoolSlab *)
+                               mpp_malloc_size(RK_U8, POOL_SLAB_HEAD + pool->obj_size * POOL_SLAB_SIZE);
+        RK_U8 *obj = (RK_U8 *)slab + POOL_SLAB_HEAD;
+
+        if (NULL == slab) {
+            mpp_err_f("pool %s failed to malloc slab\n", pool->name);
+            return;
+        }
+
+        for (i = 0; i < POOL_SLAB_SIZE; i++, obj += pool->obj_size) {
+            MppMemPoolNode *node = (MppMemPoolNode *)obj;
+            node->next = pool->free_list;
+            pool->free_list = node;
+        }
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        pool->slab_count++;
+        pool->total += POOL_SLAB_SIZE;
+    }
+
+    for (i = 0; i < POOL_CACHE_MAX / 2 && pool->free_list; i++) {
+        MppMemPoolNode *node = pool->free_list;
+        pool->free_list = node->next;
+        node->next = cache->list;
+        cache->list = node;
+        cache->count++;
+    }
+}
+
+static void cache_destroy(void *data)
+{
+    MppMemPoolCache *cache = (MppMemPoolCache *)data;
+
+    {
+        AutoMutex auto_lock(cache->pool->lock);
+        cache_flush(cache, cache->count);
+    }
+    mpp_free(cache);
+}
+
+static MppMemPoolCache *get_cache(MppMemPoolImpl *pool)
+{
+    MppMemPoolCache *cache = NULL;
+
+    if (!pool->cache_valid)
+        return NULL;
+
+    cache = (MppMemPoolCache *)pthread_getspecific(pool->cache_key);
+    if (NULL == cache) {
+        cache = mpp_calloc(MppMemPoolCache, 1);
+        if (NULL == cache)
+            return NULL;
+
+        cache->pool = pool;
+        if (pthread_setspecific(pool->cache_key, cache)) {
+            mpp_free(cache);
+            cache = NULL;
+        }
+    }
+    return cache;
+}
+
+MppMemPool mpp_mem_pool_init(const char *name, size_t size)
+{
+    MppMemPoolImpl *pool = NULL;
+
+    if (!size) {
+        mpp_err_f("invalid zero object size\n");
+        return NULL;
+    }
+
+    pool = mpp_calloc(MppMemPoolImpl, 1);
+    if (NULL == pool) {
+        mpp_err_f("failed to malloc pool\n");
+        return NULL;
+    }
+
+    pool->name = (name) ? (name) : (MODULE_TAG);
+    pool->size = size;
+    pool->obj_size = MPP_ALIGN(MPP_MAX(size, sizeof(MppMemPoolNode)), sizeof(RK_S64));
+    pool->lock = new Mutex();
+    pool->cache_valid = !pthread_key_create(&pool->cache_key, cache_destroy);
+    if (!pool->cache_valid)
+        mpp_err_f("pool %s failed to create cache key\n", pool->name);
+
+    return pool;
+}
+
+void mpp_mem_pool_deinit(MppMemPool pool)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+
+    if (NULL == impl)
+        return;
+
+    if (impl->cache_valid) {
+        // only the calling thread cache can be found here
+        MppMemPoolCache *cache = (MppMemPoolCache *)pthread_getspecific(impl->cache_key);
+        if (cache) {
+            pthread_setspecific(impl->cache_key, NULL);
+            mpp_free(cache);
+        }
+        pthread_key_delete(impl->cache_key);
+        impl->cache_valid = 0;
+    }
+
+    // object in use still points to slab so leave the slabs on leakage
+    if (impl->used) {
+        mpp_err_f("pool %s found %d object not released\n", impl->name, impl->used);
+    } else {
+        while (impl->slabs) {
+            MppMemPoolSlab *slab = impl->slabs;
+            impl->slabs = slab->next;
+            mpp_free(slab);
+        }
+    }
+
+    delete impl->lock;
+    mpp_free(impl);
+}
+
+void *mpp_mem_pool_get(MppMemPool pool)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+    MppMemPoolCache *cache = NULL;
+    MppMemPoolNode *node = NULL;
+
+    if (NULL == impl) {
+        mpp_err_f("found NULL pool\n");
+        return NULL;
+    }
+
+    cache = get_cache(impl);
+    if (NULL == cache) {
+        mpp_err_f("pool %s failed to get cache\n", impl->name);
+        return NULL;
+    }
+
+    if (NULL == cache->list) {
+        AutoMutex auto_lock(impl->lock);
+        cache_fill(cache);
+        __atomic_fetch_add(&impl->fill_count, 1, __ATOMIC_RELAXED);
+    }
+
+    node = cache->list;
+    if (NULL == node)
+        return NULL;
+
+    cache->list = node->next;
+    cache->count--;
+    __atomic_fetch_add(&impl->used, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&impl->get_count, 1, __ATOMIC_RELAXED);
+
+    memset(node, 0, impl->size);
+    return node;
+}
+
+void mpp_mem_pool_put(MppMemPool pool, void *p)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+    MppMemPoolCache *cache = NULL;
+    MppMemPoolNode *node = (MppMemPoolNode *)p;
+
+    if (NULL == impl || NULL == p)
+        return;
+
+    __atomic_fetch_sub(&impl->used, 1, __ATOMIC_RELAXED);
+
+    cache = get_cache(impl);
+    if (NULL == cache) {
+        AutoMutex auto_lock(impl->lock);
+        node->next = impl->free_list;
+        impl->free_list = node;
+        return;
+    }
+
+    node->next = cache->list;
+    cache->list = node;
+    cache->count++;
+
+    // thread only putting object returns half of its cache at one time
+    if (cache->count > POOL_CACHE_MAX) {
+        AutoMutex auto_lock(impl->lock);
+        cache_flush(cache, POOL_CACHE_MAX / 2);
+    }
+}
+
+MPP_RET mpp_mem_pool_info(MppMemPool pool, MppMemPoolInfo *info)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+
+    if (NULL == impl || NULL == info) {
+        mpp_err_f("invalid input pool %p info %p\n", pool, info);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    AutoMutex auto_lock(impl->lock);
+    info->size = impl->size;
+    info->total = impl->total;
+    info->used = __atomic_load_n(&impl->used, __ATOMIC_RELAXED);
+    info->slab_count = impl->slab_count;
+    info->get_count = __atomic_load_n(&impl->get_count, __ATOMIC_RELAXED);
+    info->fill_count = __atomic_load_n(&impl->fill_count, __ATOMIC_RELAXED);
+    return MPP_OK;
+}
@@ -17,7 +17,15 @@
 #define MODULE_TAG "mpp_thread"
 
 #include <string.h>
+#include <errno.h>
 
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+#include "mpp_env.h"
 #include "mpp_log.h"
 #include "mpp_common.h"
 #include "mpp_thread.h"
@@ -33,12 +41,42 @@ MppThread::MppThread(MppThreadFunc func, void *ctx, const char *name)
       mFunction(func),
       mContext(ctx)
 {
-    if (name)
-        strncpy(mName, name, sizeof(mName));
+    memset(&mPolicy, 0, sizeof(mPolicy));
+    set_name(name);
+}
+
+void MppThread::set_name(const char *name)
+{
+    if (name && name[0])
+        snprintf(mName, sizeof(mName), "%s", name);
     else
         snprintf(mName, sizeof(mName), "mpp_thread");
 }
 
+void MppThread::set_policy(const MppThreadPolicy *policy)
+{
+    if (policy)
+        mPolicy = *policy;
+    else
+        memset(&mPolicy, 0, sizeof(mPolicy));
+}
+
+void *MppThread::thread_entry(void *thread)
+{
+    MppThread *p = (MppThread *)thread;
+
+    // failure on policy only affects latency so the thread still goes on
+    if (p->mPolicy.cpu_mask || p->mPolicy.sched != THREAD_SCHED_DEFAULT) {
+        if (mpp_thread_apply_policy(&p->mPolicy))
+            mpp_err("thread %s apply policy failed\n", p->mName);
+        else
+            thread_dbg(MPP_THREAD_DBG_FUNCTION, "thread %s cpu mask %x sched %d priority %d\n",
+                       p->mName, p->mPolicy.cpu_mask, p->mPolicy.sched, p->mPolicy.priority);
+    }
+
+    return p->mFunction(p->mContext);
+}
+
 MppThreadStatus MppThread::get_status()
 {
     return mStatus;
@@ -55,9 +93,17 @@ void MppThread::start()
     pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
 
     if (MPP_THREAD_UNINITED == mStatus) {
+        RK_U32 priority = 0;
+
+        /* env override applies to all mpp threads, negative nice in two's complement */
+        mpp_env_get_u32("mpp_thread_cpu_mask", &mPolicy.cpu_mask, mPolicy.cpu_mask);
+        mpp_env_get_u32("mpp_thread_sched", (RK_U32 *)&mPolicy.sched, mPolicy.sched);
+        mpp_env_get_u32("mpp_thread_prio", &priority, (RK_U32)mPolicy.priority);
+        mPolicy.priority = (RK_S32)priority;
+
         // NOTE: set status here first to avoid unexpected loop quit racing condition
         mStatus = MPP_THREAD_RUNNING;
-        if (0 == pthread_create(&mThread, &attr, mFunction, mContext)) {
+        if (0 == pthread_create(&mThread, &attr, thread_entry, this)) {
 #ifndef ARMLINUX
             RK_S32 ret = pthread_setname_np(mThread, mName);
             if (ret)
@@ -89,6 +135,132 @@ void MppThread::stop()
     }
 }
 
+MppThread *mpp_thread_create(MppThreadFunc func, void *ctx, const char *name)
+{
+    MppThread *thread = new MppThread(func, ctx, name);
+
+    if (NULL == thread)
+        mpp_err_f("failed to create thread %s\n", name);
+
+    return thread;
+}
+
+void mpp_thread_destroy(MppThread *thread)
+{
+    if (thread) {
+        thread->stop();
+        delete thread;
+    }
+}
+
+void mpp_thread_set_policy(MppThread *thread, const MppThreadPolicy *policy)
+{
+    thread->set_policy(policy);
+}
+
+void mpp_thread_start(MppThread *thread)
+{
+    thread->start();
+}
+
+void mpp_thread_stop(MppThread *thread)
+{
+    thread->stop();
+}
+
+MppThreadStatus mpp_thread_get_status(MppThread *thread)
+{
+    return thread->get_status();
+}
+
+void mpp_thread_lock(MppThread *thread)
+{
+    thread->lock();
+}
+
+void mpp_thread_unlock(MppThread *thread)
+{
+    thread->unlock();
+}
+
+void mpp_thread_wait(MppThread *thread)
+{
+    thread->wait();
+}
+
+void mpp_thread_broadcast(MppThread *thread)
+{
+    thread->broadcast();
+}
+
+MPP_RET mpp_thread_apply_policy(const MppThreadPolicy *policy)
+{
+    MPP_RET ret = MPP_OK;
+
+    if (NULL == policy) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+#if defined(__linux__)
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    struct sched_param param;
+
+    if (policy->cpu_mask) {
+        cpu_set_t set;
+        RK_U32 i;
+
+        CPU_ZERO(&set);
+        for (i = 0; i < 32; i++) {
+            if (policy->cpu_mask & (1u << i))
+                CPU_SET(i, &set);
+        }
+
+        if (sched_setaffinity(tid, sizeof(set), &set)) {
+            mpp_err_f("set cpu mask %x failed errno %d\n", policy->cpu_mask, errno);
+            ret = MPP_NOK;
+        }
+    }
+
+    memset(&param, 0, sizeof(param));
+    switch (policy->sched) {
+    case THREAD_SCHED_DEFAULT : {
+    } break;
+    case THREAD_SCHED_NORMAL : {
+        // nice value is per-thread on linux
+        if (pthread_setschedparam(pthread_self(), SCHED_OTHER, &param) ||
+            setpriority(PRIO_PROCESS, tid, policy->priority)) {
+            mpp_err_f("set nice %d failed errno %d\n", policy->priority, errno);
+            ret = MPP_NOK;
+        }
+    } break;
+    case THREAD_SCHED_FIFO : {
+        RK_S32 max = sched_get_priority_max(SCHED_FIFO);
+        RK_S32 min = sched_get_priority_min(SCHED_FIFO);
+        RK_S32 err;
+
+        param.sched_priority = MPP_CLIP3(min, max, policy->priority);
+        err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err) {
+            mpp_err_f("set fifo priority %d failed errno %d\n", param.sched_priority, err);
+            ret = MPP_NOK;
+        }
+    } break;
+    default : {
+        mpp_err_f("invalid sched %d\n", policy->sched);
+        ret = MPP_NOK;
+    } break;
+    }
+#else
+    if (policy->cpu_mask || policy->sched != THREAD_SCHED_DEFAULT) {
+        mpp_err_f("thread policy is not supported\n");
+        ret = MPP_NOK;
+    }
+#endif
+
+    return ret;
+}
+
 #if defined(_WIN32) && !defined(__MINGW32CE__)
 //
 // Usage: SetThreadName ((DWORD)-1, "MainThread");
@@ -31,7 +31,21 @@ RK_S64 mpp_time()
     return ((RK_S64)tb.time * 1000 + (RK_S64)tb.millitm) * 1000;
 }
 
+RK_S64 mpp_time_ns(void)
+{
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+
+    QueryPerformanceCounter(&count);
+    return (RK_S64)(count.QuadPart / freq.QuadPart) * 1000000000 +
+           (RK_S64)(count.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+}
+
 #else
+#include <time.h>
 #include <sys/time.h>
 
 RK_S64 mpp_time()
@@ -44,8 +58,20 @@ RK_S64 mpp_time()
     return (RK_S64)tv_date.tv_sec * 1000000 + (RK_S64)tv_date.tv_usec;
 }
 
+RK_S64 mpp_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (RK_S64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
 #endif
 
+RK_S64 mpp_time_us(void)
+{
+    return mpp_time_ns() / 1000;
+}
+
 void mpp_time_diff(RK_S64 start, RK_S64 end, RK_S64 limit, char *fmt)
 {
     if (!(mpp_debug & MPP_DBG_TIMING))
@@ -20,12 +20,18 @@
 #include "mpp_allocator.h"
 
 typedef struct os_allocator_t {
-    MPP_RET (*open)(void **ctx, size_t alignment);
+    /* flags is MPP_BUFFER_FLAGS_XXX for the buffer allocated */
+    MPP_RET (*open)(void **ctx, size_t alignment, RK_U32 flags);
     MPP_RET (*alloc)(void *ctx, MppBufferInfo *info);
     MPP_RET (*free)(void *ctx, MppBufferInfo *info);
     MPP_RET (*import)(void *ctx, MppBufferInfo *info);
     MPP_RET (*release)(void *ctx, MppBufferInfo *info);
     MPP_RET (*close)(void *ctx);
+    /* create / remove cpu mapping of an allocated buffer on info->ptr */
+    MPP_RET (*mmap)(void *ctx, MppBufferInfo *info);
+    MPP_RET (*munmap)(void *ctx, MppBufferInfo *info);
+    /* cpu cache maintenance with MPP_ALLOCATOR_SYNC_XXX flags, size 0 for whole buffer */
+    MPP_RET (*sync)(void *ctx, MppBufferInfo *info, RK_U32 flags, size_t offset, size_t size);
 } os_allocator;
 
 #ifdef __cplusplus
@@ -16,9 +16,120 @@
 
 #define MODULE_TAG "mpp_log_test"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_thread.h"
+
+#define LOG_TEST_FILE       "/tmp/mpp_log_test.txt"
+#define LOG_BENCH_THREADS   4
+#define LOG_BENCH_COUNT     1000
+
+typedef struct LogBenchCtx_t {
+    RK_S32  idx;
+    RK_S32  count;
+} LogBenchCtx;
+
+static void *log_bench_thread(void *arg)
+{
+    LogBenchCtx *ctx = (LogBenchCtx *)arg;
+    RK_S32 i;
+
+    for (i = 0; i < ctx->count; i++)
+        mpp_log_f("bench thread %d count %d value %.2f name %s\n",
+                  ctx->idx, i, i * 0.5, "log_bench");
 
-int main()
+    return NULL;
+}
+
+/* average time of one log call in ns while all threads are logging */
+static RK_S64 log_bench(RK_S32 count)
+{
+    LogBenchCtx ctx[LOG_BENCH_THREADS];
+    pthread_t thd[LOG_BENCH_THREADS];
+    RK_S64 start = mpp_time_us();
+    RK_S32 i;
+
+    for (i = 0; i < LOG_BENCH_THREADS; i++) {
+        ctx[i].idx = i;
+        ctx[i].count = count;
+        pthread_create(&thd[i], NULL, log_bench_thread, &ctx[i]);
+    }
+
+    for (i = 0; i < LOG_BENCH_THREADS; i++)
+        pthread_join(thd[i], NULL);
+
+    return (mpp_time_us() - start) * 1000 / (LOG_BENCH_THREADS * count);
+}
+
+static RK_S32 log_async_test()
+{
+    char expect[8][128];
+    char line[256];
+    RK_S32 count = 0;
+    RK_S32 ret = 0;
+    void *ptr = (void *)expect;
+    FILE *fp;
+    RK_S32 i;
+
+    snprintf(expect[0], 128, "int %d %5d %-3d| %x %08X %u\n", -7, 42, 1, 0xbeef, 0xcafe, 3000000000u);
+    snprintf(expect[1], 128, "long %ld %lld %zu %lu\n", -123456789L, 1234567890123LL, (size_t)77, 99UL);
+    snprintf(expect[2], 128, "float %f %.2f %e %g\n", 3.25, -1.005, 12345.678, 0.0001);
+    snprintf(expect[3], 128, "str %s [%8s] [%-6s] %.3s %s\n", "abc", "right", "left", "truncate", "");
+    snprintf(expect[4], 128, "star [%*d] [%.*f] [%*.*s] 100%%\n", 6, 12, 3, 2.5, 5, 2, "xyz");
+    snprintf(expect[5], 128, "char %c ptr %p\n", 'm', ptr);
+    snprintf(expect[6], 128, "no newline 1\n");
+    snprintf(expect[7], 128, "log_async_test with function name\n");
+
+    if (mpp_log_async_start(MPP_LOG_SINK_FILE, LOG_TEST_FILE)) {
+        mpp_err("failed to start async log\n");
+        return -1;
+    }
+
+    mpp_log("int %d %5d %-3d| %x %08X %u\n", -7, 42, 1, 0xbeef, 0xcafe, 3000000000u);
+    mpp_log("long %ld %lld %zu %lu\n", -123456789L, 1234567890123LL, (size_t)77, 99UL);
+    mpp_log("float %f %.2f %e %g\n", 3.25, -1.005, 12345.678, 0.0001);
+    mpp_log("str %s [%8s] [%-6s] %.3s %s\n", "abc", "right", "left", "truncate", "");
+    mpp_log("star [%*d] [%.*f] [%*.*s] 100%%\n", 6, 12, 3, 2.5, 5, 2, "xyz");
+    mpp_err("char %c ptr %p\n", 'm', ptr);
+    mpp_log("no newline %d", 1);
+    mpp_log_f("with function name\n");
+
+    mpp_log_async_flush();
+    mpp_log_async_stop();
+
+    fp = fopen(LOG_TEST_FILE, "r");
+    if (NULL == fp)
+        return -1;
+
+    while (fgets(line, sizeof(line), fp)) {
+        char *msg = strstr(line, MODULE_TAG ": ");
+
+        if (count >= 8 || NULL == msg ||
+            strcmp(msg + strlen(MODULE_TAG ": "), expect[count])) {
+            mpp_err("mismatch line %d: %s", count, line);
+            ret = -1;
+        }
+        count++;
+    }
+    fclose(fp);
+    remove(LOG_TEST_FILE);
+
+    if (count != 8) {
+        mpp_err("async log line count %d expect 8\n", count);
+        ret = -1;
+    }
+
+    for (i = 0; i < count && !ret; i++)
+        mpp_log("async log line %d checked\n", i);
+
+    return ret;
+}
+
+int main(int argc, char **argv)
 {
     RK_U32 flag_dbg = 0x02;
     RK_U32 flag_set = 0xffff;
@@ -48,6 +159,28 @@ int main()
     mpp_log("try _mpp_dbg test 0 debug %x, flag %x", flag_get, flag_dbg);
     _mpp_dbg(flag_get, flag_dbg, "mpp_dbg printing debug %x, flag %x", flag_get, flag_dbg);
 
+    if (log_async_test()) {
+        mpp_err("mpp log async test failed\n");
+        return -1;
+    }
+
+    {
+        RK_S32 count = (argc > 1) ? atoi(argv[1]) : LOG_BENCH_COUNT;
+        RK_S64 sync_ns, async_ns;
+
+        if (count <= 0)
+            count = LOG_BENCH_COUNT;
+
+        sync_ns = log_bench(count);
+
+        mpp_log_async_start(MPP_LOG_SINK_STDOUT, NULL);
+        async_ns = log_bench(count);
+        mpp_log_async_stop();
+
+        mpp_err("log bench %d threads x %d calls: sync %lld ns async %lld ns per call, %u dropped\n",
+                LOG_BENCH_THREADS, count, sync_ns, async_ns, mpp_log_async_get_dropped());
+    }
+
     mpp_err("mpp log log test done\n");
 
     return 0;
@@ -16,16 +16,83 @@
 
 #define MODULE_TAG "mpp_mem_test"
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "mpp_log.h"
 #include "mpp_env.h"
 #include "mpp_mem.h"
+#include "mpp_time.h"
+
+#define MEM_BENCH_LIVE          20000
+#define MEM_BENCH_LOOP          200000
+
+static RK_U32 bench_rand_seed = 1;
+
+static RK_U32 bench_rand(void)
+{
+    bench_rand_seed = bench_rand_seed * 1103515245 + 12345;
+    return (bench_rand_seed >> 8) & 0xffffff;
+}
+
+/*
+ * pressure test: keep many live allocation and replace random ones like a
+ * decoder running real stream, report average time of one free and malloc
+ */
+static void mem_bench(RK_S32 live, RK_S32 loop)
+{
+    void **ptrs = (void **)calloc(live, sizeof(void *));
+    RK_S64 start;
+    RK_S32 i;
+
+    if (NULL == ptrs)
+        return;
 
-// TODO: need to add pressure test case and parameter scan case
+    for (i = 0; i < live; i++)
+        ptrs[i] = mpp_malloc(RK_U8, 16 + bench_rand() % 4096);
 
-int main()
+    start = mpp_time_us();
+    for (i = 0; i < loop; i++) {
+        RK_S32 idx = bench_rand() % live;
+
+        if (i & 1) {
+            mpp_free(ptrs[idx]);
+            ptrs[idx] = mpp_malloc(RK_U8, 16 + bench_rand() % 4096);
+        } else {
+            ptrs[idx] = mpp_realloc(ptrs[idx], RK_U8, 16 + bench_rand() % 4096);
+        }
+    }
+    start = mpp_time_us() - start;
+
+    mpp_log("%d live memory %d ops: %lld ns per op\n", live, loop, start * 1000 / loop);
+    mpp_show_mem_caller_status();
+
+    for (i = 0; i < live; i++)
+        mpp_free(ptrs[i]);
+    free(ptrs);
+}
+
+int main(int argc, char **argv)
 {
     void *tmp = NULL;
 
+    /*
+     * mpp_mem_test bench [live] : run pressure test with mpp_mem_flag from
+     * environment, default is tracking without runtime log.
+     */
+    if (argc > 1 && !strcmp(argv[1], "bench")) {
+        RK_U32 flag = 0;
+        RK_S32 live = (argc > 2) ? atoi(argv[2]) : MEM_BENCH_LIVE;
+
+        mpp_env_get_u32("mpp_mem_flag", &flag, 0x1);
+        mpp_env_set_u32("mpp_mem_flag", flag);
+        mpp_log("mpp_mem_flag 0x%x\n", flag);
+        mem_bench(live, MEM_BENCH_LOOP);
+        mpp_show_mem_status();
+        mpp_log("mpp_mem_test done\n");
+        return 0;
+    }
+
     mpp_env_set_u32("mpp_mem_flag", 0x3);
     tmp = mpp_calloc(int, 100);
     if (tmp) {
@@ -41,7 +108,9 @@ int main()
             mpp_log("realloc failed\n");
         }
     }
+    mpp_show_mem_caller_status();
     mpp_free(tmp);
+    mpp_show_mem_status();
     mpp_log("mpp_mem_test done\n");
 
     return 0;
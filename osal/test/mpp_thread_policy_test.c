@@ -0,0 +1,228 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_thread_policy_test"
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_thread.h"
+
+/*
+ * parser to hal hand-off latency benchmark
+ *
+ * The sender thread wakes up every 1ms and signals the waiter thread as
+ * mpp_dec_parser does to mpp_dec_hal. Busy load threads compete for cpu.
+ * The waiter records the latency from signal to wake up with default policy
+ * and then with the policy below applied.
+ */
+#define HANDOFF_COUNT       1000
+#define LOAD_THREAD_COUNT   4
+
+typedef struct HandOffCtx_t {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    RK_S64          signal_ns;
+    RK_S32          pending;
+    RK_S32          done;
+
+    RK_S64          latency[HANDOFF_COUNT];
+    RK_S32          count;
+
+    /* policy for hand-off threads and load threads */
+    MppThreadPolicy work_policy;
+    MppThreadPolicy load_policy;
+    volatile RK_S32 load_stop;
+} HandOffCtx;
+
+static void apply_policy(MppThreadPolicy *policy)
+{
+    if (policy->cpu_mask || policy->sched != THREAD_SCHED_DEFAULT)
+        mpp_thread_apply_policy(policy);
+}
+
+static void *load_thread(void *arg)
+{
+    HandOffCtx *ctx = (HandOffCtx *)arg;
+    volatile RK_U32 val = 0;
+
+    apply_policy(&ctx->load_policy);
+    while (!ctx->load_stop)
+        val++;
+
+    return NULL;
+}
+
+static void *waiter_thread(void *arg)
+{
+    HandOffCtx *ctx = (HandOffCtx *)arg;
+
+    apply_policy(&ctx->work_policy);
+
+    pthread_mutex_lock(&ctx->lock);
+    while (!ctx->done) {
+        if (!ctx->pending) {
+            pthread_cond_wait(&ctx->cond, &ctx->lock);
+            continue;
+        }
+
+        ctx->pending = 0;
+        if (ctx->count < HANDOFF_COUNT)
+            ctx->latency[ctx->count++] = mpp_time_ns() - ctx->signal_ns;
+    }
+    pthread_mutex_unlock(&ctx->lock);
+
+    return NULL;
+}
+
+static void *sender_thread(void *arg)
+{
+    HandOffCtx *ctx = (HandOffCtx *)arg;
+    struct timespec period = { 0, 1000000 };
+    RK_S32 i;
+
+    apply_policy(&ctx->work_policy);
+
+    for (i = 0; i < HANDOFF_COUNT; i++) {
+        nanosleep(&period, NULL);
+
+        pthread_mutex_lock(&ctx->lock);
+        ctx->signal_ns = mpp_time_ns();
+        ctx->pending = 1;
+        pthread_cond_signal(&ctx->cond);
+        pthread_mutex_unlock(&ctx->lock);
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+    ctx->done = 1;
+    pthread_cond_signal(&ctx->cond);
+    pthread_mutex_unlock(&ctx->lock);
+
+    return NULL;
+}
+
+static int cmp_s64(const void *a, const void *b)
+{
+    RK_S64 va = *(const RK_S64 *)a;
+    RK_S64 vb = *(const RK_S64 *)b;
+
+    return (va > vb) - (va < vb);
+}
+
+static MPP_RET run_handoff(const char *title, MppThreadPolicy *work, MppThreadPolicy *load)
+{
+    HandOffCtx ctx;
+    pthread_t loads[LOAD_THREAD_COUNT];
+    pthread_t sender, waiter;
+    RK_S64 sum = 0;
+    RK_S32 i;
+
+    memset(&ctx, 0, sizeof(ctx));
+    pthread_mutex_init(&ctx.lock, NULL);
+    pthread_cond_init(&ctx.cond, NULL);
+    ctx.work_policy = *work;
+    ctx.load_policy = *load;
+
+    for (i = 0; i < LOAD_THREAD_COUNT; i++)
+        pthread_create(&loads[i], NULL, load_thread, &ctx);
+
+    pthread_create(&waiter, NULL, waiter_thread, &ctx);
+    pthread_create(&sender, NULL, sender_thread, &ctx);
+    pthread_join(sender, NULL);
+    pthread_join(waiter, NULL);
+
+    ctx.load_stop = 1;
+    for (i = 0; i < LOAD_THREAD_COUNT; i++)
+        pthread_join(loads[i], NULL);
+
+    pthread_cond_destroy(&ctx.cond);
+    pthread_mutex_destroy(&ctx.lock);
+
+    if (!ctx.count) {
+        mpp_err("%s no hand-off recorded\n", title);
+        return MPP_NOK;
+    }
+
+    for (i = 0; i < ctx.count; i++)
+        sum += ctx.latency[i];
+    qsort(ctx.latency, ctx.count, sizeof(ctx.latency[0]), cmp_s64);
+
+    /* jitter is taken as the distance from median to p99 */
+    mpp_log("%-8s count %4d avg %8.1f us p50 %8.1f us p99 %8.1f us max %8.1f us jitter %8.1f us\n",
+            title, ctx.count, sum / 1000.0 / ctx.count,
+            ctx.latency[ctx.count / 2] / 1000.0,
+            ctx.latency[ctx.count * 99 / 100] / 1000.0,
+            ctx.latency[ctx.count - 1] / 1000.0,
+            (ctx.latency[ctx.count * 99 / 100] - ctx.latency[ctx.count / 2]) / 1000.0);
+
+    return MPP_OK;
+}
+
+/* policy is checked on a temporary thread to keep the main thread default */
+static void *check_thread(void *arg)
+{
+    MppThreadPolicy *policy = (MppThreadPolicy *)arg;
+
+    return (void *)(intptr_t)mpp_thread_apply_policy(policy);
+}
+
+static MPP_RET check_policy(MppThreadPolicy *policy)
+{
+    pthread_t thd;
+    void *ret = NULL;
+
+    if (pthread_create(&thd, NULL, check_thread, policy))
+        return MPP_NOK;
+
+    pthread_join(thd, &ret);
+    return (MPP_RET)(intptr_t)ret;
+}
+
+int main()
+{
+    MppThreadPolicy none = { 0, THREAD_SCHED_DEFAULT, 0 };
+    MppThreadPolicy work = { 0, THREAD_SCHED_FIFO, 10 };
+    MppThreadPolicy load = { 0, THREAD_SCHED_NORMAL, 19 };
+    MppThreadPolicy check = { 1, THREAD_SCHED_NORMAL, 0 };
+    MppThreadPolicy *work_policy = &work;
+    MPP_RET ret;
+
+    mpp_log("mpp_thread_policy_test start\n");
+
+    /* affinity to cpu 0 and default nice value should always be accepted */
+    ret = check_policy(&check);
+    if (ret) {
+        mpp_err("apply cpu mask and nice failed\n");
+        goto __RETURN;
+    }
+
+    /* realtime policy needs privilege, lowering the load only is the fallback */
+    if (check_policy(&work)) {
+        mpp_log("realtime policy is not permitted, only lower load priority\n");
+        work_policy = &none;
+    }
+
+    ret = run_handoff("default", &none, &none);
+    if (MPP_OK == ret)
+        ret = run_handoff("policy", work_policy, &load);
+
+__RETURN:
+    mpp_log("mpp_thread_policy_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -29,6 +29,8 @@
 #include "mpp_time.h"
 
 #include "utils.h"
+#include "mpp_frame_writer.h"
+#include "mpp_stream_reader.h"
 
 #define MPI_DEC_LOOP_COUNT          4
 #define MPI_DEC_STREAM_SIZE         (SZ_64K)
@@ -41,6 +43,10 @@ typedef struct {
     RK_U32          width;
     RK_U32          height;
     RK_U32          debug;
+    RK_U32          skip_mode;
+    RK_U32          checksum;
+    RK_U32          pkt_mode;
+    RK_U32          seed;
 
     RK_U32          have_input;
     RK_U32          have_output;
@@ -53,6 +59,10 @@ static OptionInfo mpi_dec_cmd[] = {
     {"h",               "height",               "the height of input bitstream"},
     {"t",               "type",                 "input stream coding type"},
     {"d",               "debug",                "debug flag"},
+    {"s",               "skip_mode",            "skip mode 0 - none 1 - non-ref 2 - non-key 3 - temporal layer 0"},
+    {"c",               "checksum",             "output 0 - raw frames 1 - md5 per frame 2 - crc32 per frame"},
+    {"m",               "packet_mode",          "input 0 - 64K chunks 1 - whole frames 2 - random chunks"},
+    {"r",               "seed",                 "random chunk seed"},
 };
 
 int mpi_dec_test(MpiDecTestCmd *cmd)
@@ -60,8 +70,13 @@ int mpi_dec_test(MpiDecTestCmd *cmd)
     MPP_RET ret         = MPP_OK;
     RK_U32 pkt_eos      = 0;
     RK_U32 frm_eos      = 0;
-    FILE *fp_input      = NULL;
     FILE *fp_output     = NULL;
+    MppStreamReader reader = NULL;
+    MppStreamReaderCfg reader_cfg;
+    MppStreamReaderStat reader_stat;
+    MppFrameWriter writer = NULL;
+    MppFrameWriterCfg writer_cfg;
+    MppFrameWriterStat writer_stat;
 
     // base flow context
     MppCtx ctx          = NULL;
@@ -81,16 +96,20 @@ int mpi_dec_test(MpiDecTestCmd *cmd)
     MppCodingType type  = cmd->type;
 
     // resources
-    char *buf           = NULL;
     size_t packet_size  = MPI_DEC_STREAM_SIZE;
-    size_t read_size    = 0;
     RK_U32 frame_count  = 0;
 
     mpp_log("mpi_dec_test start\n");
 
+    // packets point into the mapped input file
     if (cmd->have_input) {
-        fp_input = fopen(cmd->file_input, "rb");
-        if (NULL == fp_input) {
+        memset(&reader_cfg, 0, sizeof(reader_cfg));
+        reader_cfg.mode = (MppStreamReaderMode)cmd->pkt_mode;
+        reader_cfg.coding = type;
+        reader_cfg.chunk_size = packet_size;
+        reader_cfg.seed = cmd->seed;
+        ret = mpp_stream_reader_init(&reader, cmd->file_input, &reader_cfg);
+        if (ret) {
             mpp_err("failed to open input file %s\n", cmd->file_input);
             goto MPP_TEST_OUT;
         }
@@ -104,16 +123,17 @@ int mpi_dec_test(MpiDecTestCmd *cmd)
         }
     }
 
-    buf = mpp_malloc(char, packet_size);
-    if (NULL == buf) {
-        mpp_err("mpi_dec_test malloc input stream buffer failed\n");
-        goto MPP_TEST_OUT;
-    }
-
-    ret = mpp_packet_init(&packet, buf, packet_size);
-    if (ret) {
-        mpp_err("mpp_packet_init failed\n");
-        goto MPP_TEST_OUT;
+    // frames are written on writer thread while decoding goes on
+    if (fp_output || cmd->checksum) {
+        memset(&writer_cfg, 0, sizeof(writer_cfg));
+        writer_cfg.mode = (MppFrameWriterMode)cmd->checksum;
+        writer_cfg.fp = fp_output;
+        writer_cfg.async = 1;
+        ret = mpp_frame_writer_init(&writer, &writer_cfg);
+        if (ret) {
+            mpp_err("failed to init frame writer\n");
+            goto MPP_TEST_OUT;
+        }
     }
 
     mpp_log("mpi_dec_test decoder test start w %d h %d type %d packate size %d\n", width, height, type, packet_size);
@@ -127,6 +147,10 @@ int mpi_dec_test(MpiDecTestCmd *cmd)
         goto MPP_TEST_OUT;
     }
 
+    // whole frame packets need no split in decoder, reader may fall back to chunks
+    if (reader && mpp_stream_reader_get_mode(reader) == MPP_STREAM_READER_FRAME)
+        need_split = 0;
+
     // NOTE: decoder split mode need to be set before init
     mpi_cmd = MPP_DEC_SET_PARSER_SPLIT_MODE;
     param = &need_split;
@@ -142,22 +166,32 @@ int mpi_dec_test(MpiDecTestCmd *cmd)
         goto MPP_TEST_OUT;
     }
 
+    if (cmd->skip_mode) {
+        MppDecSkipCfg skip_cfg;
+
+        memset(&skip_cfg, 0, sizeof(skip_cfg));
+        skip_cfg.mode = cmd->skip_mode;
+        ret = mpi->control(ctx, MPP_DEC_SET_SKIP_MODE, &skip_cfg);
+        if (MPP_OK != ret) {
+            mpp_err("mpi->control set skip mode %d failed\n", cmd->skip_mode);
+            goto MPP_TEST_OUT;
+        }
+    }
+
     while (!pkt_eos) {
         RK_S32 pkt_done = 0;
-        read_size = fread(buf, 1, packet_size, fp_input);
-        if (read_size != packet_size || feof(fp_input)) {
+
+        ret = mpp_stream_reader_get_packet(reader, &packet);
+        if (ret) {
+            mpp_err("failed to get input packet\n");
+            goto MPP_TEST_OUT;
+        }
+
+        if (mpp_packet_get_eos(packet)) {
             mpp_log("found last packet\n");
             pkt_eos = 1;
         }
 
-        // write data to packet
-        mpp_packet_write(packet, 0, buf, read_size);
-        // reset pos
-        mpp_packet_set_pos(packet, buf);
-        // setup eos flag
-        if (pkt_eos)
-            mpp_packet_set_eos(packet);
-
         frame = NULL;
         do {
             // send the packet first if packet is not done
@@ -182,8 +216,8 @@ int mpi_dec_test(MpiDecTestCmd *cmd)
                         mpi->control(ctx, MPP_DEC_SET_INFO_CHANGE_READY, NULL);
                     } else {
                         mpp_log("decode_get_frame get frame %d\n", frame_count++);
-                        if (fp_output)
-                            dump_mpp_frame_to_file(frame, fp_output);
+                        if (writer)
+                            mpp_frame_writer_put(writer, frame);
                     }
                     frm_eos = mpp_frame_get_eos(frame);
                     mpp_frame_deinit(&frame);
@@ -206,8 +240,23 @@ int mpi_dec_test(MpiDecTestCmd *cmd)
 
             msleep(50);
         } while (1);
+
+        // decoder has taken its own copy
+        mpp_packet_deinit(&packet);
+        packet = NULL;
     }
 
+    mpp_log("mpi_dec_test skip mode %d decoded %d frames\n", cmd->skip_mode, frame_count);
+
+    if (writer && MPP_OK == mpp_frame_writer_get_stat(writer, &writer_stat))
+        mpp_log("mpi_dec_test output %d frames %lld bytes in %.2f ms\n",
+                writer_stat.frames, writer_stat.bytes, (float)writer_stat.time / 1000);
+
+    if (reader && MPP_OK == mpp_stream_reader_get_stat(reader, &reader_stat) &&
+        reader_stat.frames)
+        mpp_log("mpi_dec_test input %d frames indexed in %.2f ms\n",
+                reader_stat.frames, (float)reader_stat.index_time / 1000);
+
     ret = mpi->reset(ctx);
     if (MPP_OK != ret) {
         mpp_err("mpi->reset failed\n");
@@ -215,29 +264,30 @@ int mpi_dec_test(MpiDecTestCmd *cmd)
     }
 
 MPP_TEST_OUT:
+    // packet still held by the decode loop on error exit
     if (packet) {
         mpp_packet_deinit(&packet);
         packet = NULL;
     }
 
+    if (writer) {
+        mpp_frame_writer_deinit(writer);
+        writer = NULL;
+    }
+
     if (ctx) {
         mpp_destroy(ctx);
         ctx = NULL;
     }
 
-    if (buf) {
-        mpp_free(buf);
-        buf = NULL;
-    }
-
     if (fp_output) {
         fclose(fp_output);
         fp_output = NULL;
     }
 
-    if (fp_input) {
-        fclose(fp_input);
-        fp_input = NULL;
+    if (reader) {
+        mpp_stream_reader_deinit(reader);
+        reader = NULL;
     }
 
     if (MPP_OK == ret)
@@ -315,6 +365,42 @@ static RK_S32 mpi_dec_test_parse_options(int argc, char **argv, MpiDecTestCmd* c
                     goto PARSE_OPINIONS_OUT;
                 }
                 break;
+            case 's':
+                if (next) {
+                    cmd->skip_mode = atoi(next);
+                } else {
+                    mpp_err("invalid skip mode\n");
+                    goto PARSE_OPINIONS_OUT;
+                }
+                break;
+            case 'c':
+                if (next) {
+                    cmd->checksum = atoi(next);
+                }
+
+                if (!next || cmd->checksum >= MPP_FRAME_WRITER_BUTT) {
+                    mpp_err("invalid checksum mode\n");
+                    goto PARSE_OPINIONS_OUT;
+                }
+                break;
+            case 'm':
+                if (next) {
+                    cmd->pkt_mode = atoi(next);
+                }
+
+                if (!next || cmd->pkt_mode >= MPP_STREAM_READER_BUTT) {
+                    mpp_err("invalid packet mode\n");
+                    goto PARSE_OPINIONS_OUT;
+                }
+                break;
+            case 'r':
+                if (next) {
+                    cmd->seed = atoi(next);
+                } else {
+                    mpp_err("invalid random seed\n");
+                    goto PARSE_OPINIONS_OUT;
+                }
+                break;
             case 'w':
                 if (next) {
                     cmd->width = atoi(next);
@@ -370,6 +456,10 @@ static void mpi_dec_test_show_options(MpiDecTestCmd* cmd)
     mpp_log("height     : %4d\n", cmd->height);
     mpp_log("type       : %d\n", cmd->type);
     mpp_log("debug flag : %x\n", cmd->debug);
+    mpp_log("skip mode  : %d\n", cmd->skip_mode);
+    mpp_log("checksum   : %d\n", cmd->checksum);
+    mpp_log("packet mode: %d\n", cmd->pkt_mode);
+    mpp_log("seed       : %d\n", cmd->seed);
 }
 
 int main(int argc, char **argv)
@@ -0,0 +1,290 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_buffer_import_test"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "mpp_log.h"
+#include "mpp_env.h"
+#include "mpp_time.h"
+#include "mpp_buffer.h"
+#include "mpp_allocator.h"
+
+/*
+ * Temporary files stand for external dma-buf here. Normal allocator import
+ * returns a new fake fd on each real import, so a cache hit is seen as the
+ * fake fd of the previous import coming back.
+ */
+#define IMPORT_TEST_SIZE        (SZ_1K * 64)
+#define IMPORT_TEST_COUNT       8
+#define IMPORT_TEST_CACHE       4
+#define IMPORT_BENCH_LOOP       2000
+#define IMPORT_DEV_DRM          "/dev/dri/card0"
+
+typedef struct ImportSrc_t {
+    int     fd;
+    void    *ptr;
+} ImportSrc;
+
+static MPP_RET src_open(ImportSrc *src)
+{
+    char path[] = "/tmp/mpp_import_XXXXXX";
+
+    src->fd = mkstemp(path);
+    if (src->fd < 0)
+        return MPP_NOK;
+
+    unlink(path);
+    if (ftruncate(src->fd, IMPORT_TEST_SIZE)) {
+        close(src->fd);
+        return MPP_NOK;
+    }
+
+    src->ptr = mmap(NULL, IMPORT_TEST_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, src->fd, 0);
+    if (src->ptr == MAP_FAILED) {
+        close(src->fd);
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+static void src_close(ImportSrc *src)
+{
+    munmap(src->ptr, IMPORT_TEST_SIZE);
+    close(src->fd);
+}
+
+/* import one buffer into group, release it on group clear, return the imported fd */
+static RK_S32 import_once(MppBufferGroup group, MppBufferType type, int fd, void *ptr)
+{
+    MppBufferInfo info;
+    MppBuffer buffer = NULL;
+    RK_S32 ret_fd;
+
+    memset(&info, 0, sizeof(info));
+    info.type = type;
+    info.size = IMPORT_TEST_SIZE;
+    info.fd = fd;
+    info.ptr = ptr;
+
+    if (mpp_buffer_import_with_tag(group, &info, &buffer, MODULE_TAG, __FUNCTION__))
+        return -1;
+
+    ret_fd = mpp_buffer_get_fd(buffer);
+    mpp_buffer_put(buffer);
+    mpp_buffer_group_clear(group);
+
+    return ret_fd;
+}
+
+static MPP_RET test_cache(void)
+{
+    MPP_RET ret = MPP_NOK;
+    MppBufferGroup group = NULL;
+    ImportSrc src[IMPORT_TEST_COUNT];
+    ImportSrc reuse;
+    RK_S32 fd0, fd1, fd2;
+    int dup_fd;
+    RK_S32 i;
+
+    for (i = 0; i < IMPORT_TEST_COUNT; i++) {
+        if (src_open(&src[i])) {
+            mpp_err("failed to create source buffer\n");
+            while (--i >= 0)
+                src_close(&src[i]);
+            return MPP_NOK;
+        }
+    }
+
+    mpp_env_set_u32("mpp_buffer_import_cache", IMPORT_TEST_CACHE);
+    if (mpp_buffer_group_get_external(&group, MPP_BUFFER_TYPE_NORMAL))
+        goto __RETURN;
+
+    /* same buffer is a hit */
+    fd0 = import_once(group, MPP_BUFFER_TYPE_NORMAL, src[0].fd, src[0].ptr);
+    fd1 = import_once(group, MPP_BUFFER_TYPE_NORMAL, src[0].fd, src[0].ptr);
+    if (fd0 < 0 || fd0 != fd1) {
+        mpp_err("reimport miss: fd %d -> %d\n", fd0, fd1);
+        goto __RETURN;
+    }
+
+    /* another fd of the same buffer is a hit */
+    dup_fd = dup(src[0].fd);
+    fd1 = import_once(group, MPP_BUFFER_TYPE_NORMAL, dup_fd, src[0].ptr);
+    close(dup_fd);
+    if (fd0 != fd1) {
+        mpp_err("dup fd import miss: fd %d -> %d\n", fd0, fd1);
+        goto __RETURN;
+    }
+
+    /* the other buffer on a reused fd number is a miss */
+    fd1 = import_once(group, MPP_BUFFER_TYPE_NORMAL, src[1].fd, src[1].ptr);
+    src_close(&src[1]);
+    if (src_open(&reuse)) {
+        mpp_err("failed to create source buffer\n");
+        src[1].fd = -1;
+        goto __RETURN;
+    }
+    src[1] = reuse;
+    fd2 = import_once(group, MPP_BUFFER_TYPE_NORMAL, src[1].fd, src[1].ptr);
+    if (fd2 == fd1 || fd2 == fd0) {
+        mpp_err("freed buffer hit on fd %d: fd %d\n", src[1].fd, fd2);
+        goto __RETURN;
+    }
+
+    /* fill the cache over its size, the least recently used entry is evicted */
+    fd0 = import_once(group, MPP_BUFFER_TYPE_NORMAL, src[0].fd, src[0].ptr);
+    for (i = 2; i < 2 + IMPORT_TEST_CACHE; i++)
+        import_once(group, MPP_BUFFER_TYPE_NORMAL, src[i].fd, src[i].ptr);
+
+    fd1 = import_once(group, MPP_BUFFER_TYPE_NORMAL, src[0].fd, src[0].ptr);
+    if (fd0 == fd1) {
+        mpp_err("evicted buffer hit: fd %d\n", fd1);
+        goto __RETURN;
+    }
+
+    /* the most recently used entries are still there */
+    fd0 = import_once(group, MPP_BUFFER_TYPE_NORMAL, src[5].fd, src[5].ptr);
+    fd1 = import_once(group, MPP_BUFFER_TYPE_NORMAL, src[5].fd, src[5].ptr);
+    if (fd0 != fd1) {
+        mpp_err("recent buffer miss: fd %d -> %d\n", fd0, fd1);
+        goto __RETURN;
+    }
+
+    mpp_log("import cache check success\n");
+    ret = MPP_OK;
+__RETURN:
+    if (group)
+        mpp_buffer_group_put(group);
+
+    for (i = 0; i < IMPORT_TEST_COUNT; i++) {
+        if (src[i].fd >= 0)
+            src_close(&src[i]);
+    }
+    return ret;
+}
+
+/* average import and release time in us, cycling count buffers */
+static RK_S64 bench_import(MppBufferType type, RK_U32 cache, int *fds, void **ptrs, RK_S32 count)
+{
+    MppBufferGroup group = NULL;
+    RK_S64 start;
+    RK_S32 i;
+
+    mpp_env_set_u32("mpp_buffer_import_cache", cache);
+    if (mpp_buffer_group_get_external(&group, type))
+        return -1;
+
+    /* warm up */
+    for (i = 0; i < count; i++)
+        import_once(group, type, fds[i], ptrs ? ptrs[i] : NULL);
+
+    start = mpp_time_us();
+    for (i = 0; i < IMPORT_BENCH_LOOP; i++)
+        import_once(group, type, fds[i % count], ptrs ? ptrs[i % count] : NULL);
+
+    start = mpp_time_us() - start;
+    mpp_buffer_group_put(group);
+
+    return start * 1000 / IMPORT_BENCH_LOOP;
+}
+
+static void bench_normal(void)
+{
+    ImportSrc src[IMPORT_TEST_COUNT];
+    int fds[IMPORT_TEST_COUNT];
+    void *ptrs[IMPORT_TEST_COUNT];
+    RK_S64 hot, off;
+    RK_S32 i;
+
+    for (i = 0; i < IMPORT_TEST_COUNT; i++) {
+        if (src_open(&src[i])) {
+            while (--i >= 0)
+                src_close(&src[i]);
+            return;
+        }
+        fds[i] = src[i].fd;
+        ptrs[i] = src[i].ptr;
+    }
+
+    off = bench_import(MPP_BUFFER_TYPE_NORMAL, 0, fds, ptrs, IMPORT_TEST_COUNT);
+    hot = bench_import(MPP_BUFFER_TYPE_NORMAL, IMPORT_TEST_COUNT, fds, ptrs, IMPORT_TEST_COUNT);
+    mpp_log("normal import: no cache %lld ns hot cache %lld ns\n", off, hot);
+
+    for (i = 0; i < IMPORT_TEST_COUNT; i++)
+        src_close(&src[i]);
+}
+
+static void bench_drm(void)
+{
+    MppAllocator allocator = NULL;
+    MppAllocatorApi *api = NULL;
+    MppBufferInfo info[IMPORT_TEST_COUNT];
+    int fds[IMPORT_TEST_COUNT];
+    RK_S64 hot, off;
+    RK_S32 i;
+
+    if (access(IMPORT_DEV_DRM, R_OK | W_OK)) {
+        mpp_log("no %s, skip drm import benchmark\n", IMPORT_DEV_DRM);
+        return;
+    }
+
+    if (mpp_allocator_get(&allocator, &api, MPP_BUFFER_TYPE_ION))
+        return;
+
+    for (i = 0; i < IMPORT_TEST_COUNT; i++) {
+        memset(&info[i], 0, sizeof(info[i]));
+        info[i].type = MPP_BUFFER_TYPE_ION;
+        info[i].size = IMPORT_TEST_SIZE;
+        if (api->alloc(allocator, &info[i])) {
+            while (--i >= 0)
+                api->free(allocator, &info[i]);
+            mpp_allocator_put(&allocator);
+            return;
+        }
+        fds[i] = info[i].fd;
+    }
+
+    off = bench_import(MPP_BUFFER_TYPE_ION, 0, fds, NULL, IMPORT_TEST_COUNT);
+    hot = bench_import(MPP_BUFFER_TYPE_ION, IMPORT_TEST_COUNT, fds, NULL, IMPORT_TEST_COUNT);
+    mpp_log("drm import: no cache %lld ns hot cache %lld ns\n", off, hot);
+
+    for (i = 0; i < IMPORT_TEST_COUNT; i++)
+        api->free(allocator, &info[i]);
+    mpp_allocator_put(&allocator);
+}
+
+int main()
+{
+    MPP_RET ret;
+
+    mpp_log("mpp_buffer_import_test start\n");
+
+    ret = test_cache();
+    if (MPP_OK == ret) {
+        bench_normal();
+        bench_drm();
+    }
+
+    mpp_log("mpp_buffer_import_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
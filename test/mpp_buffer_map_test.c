@@ -0,0 +1,154 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_buffer_map_test"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "mpp_log.h"
+#include "mpp_buffer.h"
+
+#define MAP_TEST_SIZE           (SZ_1M)
+#define MAP_TEST_COUNT          4
+#define MAP_DEV_DRM             "/dev/dri/card0"
+
+static MPP_RET check_usage(MppBufferGroup group, size_t mapped, size_t unmapped)
+{
+    size_t cur_mapped = 0;
+    size_t cur_unmapped = 0;
+
+    mpp_buffer_group_usage(group, &cur_mapped, &cur_unmapped);
+    if (cur_mapped != mapped || cur_unmapped != unmapped) {
+        mpp_err("usage mapped %d unmapped %d expect %d %d\n",
+                cur_mapped, cur_unmapped, mapped, unmapped);
+        return MPP_NOK;
+    }
+    return MPP_OK;
+}
+
+/*
+ * lazy: 1 - buffer is allocated without cpu mapping and can be unmapped
+ *       0 - buffer is always mapped
+ */
+static MPP_RET test_group(MppBufferType type, RK_S32 lazy)
+{
+    MPP_RET ret = MPP_NOK;
+    MppBufferGroup group = NULL;
+    MppBuffer buffer[MAP_TEST_COUNT];
+    size_t total = MAP_TEST_SIZE * MAP_TEST_COUNT;
+    RK_U8 data[16];
+    RK_U8 *ptr;
+    RK_S32 i;
+
+    memset(buffer, 0, sizeof(buffer));
+
+    if (mpp_buffer_group_get_internal(&group, type))
+        return MPP_NOK;
+
+    for (i = 0; i < MAP_TEST_COUNT; i++) {
+        if (mpp_buffer_get(group, &buffer[i], MAP_TEST_SIZE)) {
+            mpp_err("failed to get buffer %d\n", i);
+            goto __RETURN;
+        }
+    }
+
+    if (check_usage(group, lazy ? 0 : total, lazy ? total : 0))
+        goto __RETURN;
+
+    /* first cpu access maps only the accessed buffer */
+    ptr = (RK_U8 *)mpp_buffer_get_ptr(buffer[0]);
+    if (NULL == ptr)
+        goto __RETURN;
+    memset(ptr, 0x5a, MAP_TEST_SIZE);
+
+    if (mpp_buffer_write(buffer[1], 0, ptr, sizeof(data)))
+        goto __RETURN;
+
+    if (check_usage(group, lazy ? MAP_TEST_SIZE * 2 : total,
+                    lazy ? total - MAP_TEST_SIZE * 2 : 0))
+        goto __RETURN;
+
+    /* unmapped buffer keeps its content and is mapped again on access */
+    if (mpp_buffer_unmap(buffer[0]) || mpp_buffer_unmap(buffer[1]))
+        goto __RETURN;
+
+    if (check_usage(group, lazy ? 0 : total, lazy ? total : 0))
+        goto __RETURN;
+
+    if (mpp_buffer_read(buffer[1], 0, data, sizeof(data)))
+        goto __RETURN;
+
+    ptr = (RK_U8 *)mpp_buffer_get_ptr(buffer[0]);
+    if (NULL == ptr || ptr[MAP_TEST_SIZE - 1] != 0x5a || data[sizeof(data) - 1] != 0x5a) {
+        mpp_err("buffer content lost after unmap\n");
+        goto __RETURN;
+    }
+
+    /* explicit map on the other buffers */
+    for (i = 2; i < MAP_TEST_COUNT; i++) {
+        if (mpp_buffer_map(buffer[i]))
+            goto __RETURN;
+    }
+
+    if (check_usage(group, total, 0))
+        goto __RETURN;
+
+    /* mapped buffer goes back to unused list with its mapping */
+    mpp_buffer_put(buffer[0]);
+    buffer[0] = NULL;
+    if (check_usage(group, total, 0))
+        goto __RETURN;
+
+    ret = MPP_OK;
+__RETURN:
+    for (i = 0; i < MAP_TEST_COUNT; i++) {
+        if (buffer[i])
+            mpp_buffer_put(buffer[i]);
+    }
+
+    if (MPP_OK == ret) {
+        mpp_buffer_group_clear(group);
+        ret = check_usage(group, 0, 0);
+    }
+
+    mpp_buffer_group_put(group);
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret;
+
+    mpp_log("mpp_buffer_map_test start\n");
+
+    ret = test_group(MPP_BUFFER_TYPE_NORMAL, 0);
+    if (ret)
+        mpp_err("normal buffer map check failed\n");
+
+    if (MPP_OK == ret) {
+        if (access(MAP_DEV_DRM, R_OK | W_OK)) {
+            mpp_log("no %s, skip ion buffer map check\n", MAP_DEV_DRM);
+        } else {
+            ret = test_group(MPP_BUFFER_TYPE_ION, 1);
+            if (ret)
+                mpp_err("ion buffer map check failed\n");
+        }
+    }
+
+    mpp_log("mpp_buffer_map_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_buffer_sync_test"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_mem.h"
+#include "mpp_buffer.h"
+
+/*
+ * cpu readback benchmark
+ *
+ * Read a 1080p nv12 sized buffer as a frame dump or software post process does
+ * after hardware decoding. Uncached mapping is read directly. Cacheable mapping
+ * is read with the whole buffer or only the first line range synced.
+ */
+#define SYNC_TEST_SIZE          (1920 * 1088 * 3 / 2)
+#define SYNC_TEST_PARTIAL       (1920 * 16)
+#define SYNC_TEST_LOOP          50
+#define SYNC_DEV_DRM            "/dev/dri/card0"
+
+static RK_U32 check_sum(RK_U8 *dst, RK_U8 *src, size_t size)
+{
+    RK_U32 sum = 0;
+    size_t i;
+
+    memcpy(dst, src, size);
+    for (i = 0; i < size; i += 64)
+        sum += dst[i];
+
+    return sum;
+}
+
+/*
+ * sync: 0 - no sync
+ *       1 - sync whole buffer
+ *       2 - sync partial range
+ */
+static MPP_RET run_readback(const char *title, MppBuffer buffer, RK_U8 *dst, RK_S32 sync)
+{
+    size_t size = (sync == 2) ? SYNC_TEST_PARTIAL : SYNC_TEST_SIZE;
+    RK_U8 *src = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+    RK_S64 start;
+    RK_S64 time;
+    RK_S32 i;
+
+    if (NULL == src)
+        return MPP_NOK;
+
+    start = mpp_time_us();
+    for (i = 0; i < SYNC_TEST_LOOP; i++) {
+        if (sync && mpp_buffer_sync_partial_begin(buffer, 1, 0, size))
+            return MPP_NOK;
+
+        check_sum(dst, src, size);
+
+        if (sync && mpp_buffer_sync_partial_end(buffer, 1, 0, size))
+            return MPP_NOK;
+    }
+    time = mpp_time_us() - start;
+    if (time <= 0)
+        time = 1;
+
+    mpp_log("%-24s size %8d loop %d readback %8.1f MB/s\n", title, size,
+            SYNC_TEST_LOOP, (double)size * SYNC_TEST_LOOP / time);
+
+    return MPP_OK;
+}
+
+static MPP_RET test_api(MppBuffer buffer)
+{
+    RK_U8 data[16];
+
+    memset(data, 0x3c, sizeof(data));
+
+    if (mpp_buffer_sync_begin(buffer) || mpp_buffer_sync_end(buffer) ||
+        mpp_buffer_sync_ro_begin(buffer) || mpp_buffer_sync_ro_end(buffer)) {
+        mpp_err("sync whole buffer failed\n");
+        return MPP_NOK;
+    }
+
+    /* size 0 syncs to the end of the buffer */
+    if (mpp_buffer_sync_partial_begin(buffer, 0, SYNC_TEST_SIZE - SZ_4K, 0) ||
+        mpp_buffer_sync_partial_end(buffer, 0, SYNC_TEST_SIZE - SZ_4K, 0)) {
+        mpp_err("sync buffer tail failed\n");
+        return MPP_NOK;
+    }
+
+    if (MPP_OK == mpp_buffer_sync_partial_begin(buffer, 0, SYNC_TEST_SIZE, 1) ||
+        MPP_OK == mpp_buffer_sync_partial_end(buffer, 0, SZ_4K, SYNC_TEST_SIZE)) {
+        mpp_err("sync out of buffer range is accepted\n");
+        return MPP_NOK;
+    }
+
+    if (MPP_OK == mpp_buffer_sync_begin(NULL)) {
+        mpp_err("sync NULL buffer is accepted\n");
+        return MPP_NOK;
+    }
+
+    /* read / write maintain cache by themselves */
+    if (mpp_buffer_write(buffer, SZ_4K, data, sizeof(data)))
+        return MPP_NOK;
+
+    memset(data, 0, sizeof(data));
+    if (mpp_buffer_read(buffer, SZ_4K, data, sizeof(data)) ||
+        data[sizeof(data) - 1] != 0x3c) {
+        mpp_err("read back written data failed\n");
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET test_group(MppBufferType type, const char *name)
+{
+    MPP_RET ret = MPP_NOK;
+    MppBufferGroup group = NULL;
+    MppBuffer buffer = NULL;
+    RK_U8 *dst = NULL;
+    char title[32];
+
+    if (mpp_buffer_group_get_internal(&group, type))
+        return MPP_NOK;
+
+    if (mpp_buffer_get(group, &buffer, SYNC_TEST_SIZE))
+        goto __RETURN;
+
+    dst = mpp_malloc(RK_U8, SYNC_TEST_SIZE);
+    if (NULL == dst)
+        goto __RETURN;
+
+    memset(mpp_buffer_get_ptr(buffer), 0x5a, SYNC_TEST_SIZE);
+    if (mpp_buffer_sync_end(buffer))
+        goto __RETURN;
+
+    if (test_api(buffer))
+        goto __RETURN;
+
+    snprintf(title, sizeof(title), "%s no sync", name);
+    if (run_readback(title, buffer, dst, 0))
+        goto __RETURN;
+
+    snprintf(title, sizeof(title), "%s sync", name);
+    if (run_readback(title, buffer, dst, 1))
+        goto __RETURN;
+
+    snprintf(title, sizeof(title), "%s partial sync", name);
+    if (run_readback(title, buffer, dst, 2))
+        goto __RETURN;
+
+    ret = MPP_OK;
+__RETURN:
+    MPP_FREE(dst);
+    if (buffer)
+        mpp_buffer_put(buffer);
+    mpp_buffer_group_put(group);
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret;
+
+    mpp_log("mpp_buffer_sync_test start\n");
+
+    /* normal buffer stands in for device memory and sync does nothing */
+    ret = test_group(MPP_BUFFER_TYPE_NORMAL, "normal");
+    if (ret)
+        mpp_err("normal buffer sync check failed\n");
+
+    if (MPP_OK == ret) {
+        if (access(SYNC_DEV_DRM, R_OK | W_OK)) {
+            mpp_log("no %s, skip ion buffer sync check\n", SYNC_DEV_DRM);
+        } else {
+            ret = test_group(MPP_BUFFER_TYPE_ION, "uncached");
+            if (MPP_OK == ret)
+                ret = test_group((MppBufferType)(MPP_BUFFER_TYPE_ION |
+                                                 MPP_BUFFER_FLAGS_CACHABLE), "cached");
+            if (ret)
+                mpp_err("ion buffer sync check failed\n");
+        }
+    }
+
+    mpp_log("mpp_buffer_sync_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,362 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_frame_writer_test"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_buffer.h"
+#include "mpp_frame_writer.h"
+
+/*
+ * raw frame writer test and output benchmark
+ *
+ * Every format is written from a padded buffer and checked against the
+ * visible pixels. Checksum modes are checked on known vectors. Then 1080p
+ * nv12 frames are written with one fwrite per row as the old frame dump did,
+ * with the writer in caller thread and on writer thread, and hashed only.
+ */
+#define WRITER_FILE             "/tmp/mpp_frame_writer_test.yuv"
+#define WRITER_FRAME_COUNT      60
+#define WRITER_WIDTH            1920
+#define WRITER_HEIGHT           1080
+#define WRITER_HOR_STRIDE       2048
+#define WRITER_VER_STRIDE       1088
+
+typedef struct FormatDesc_t {
+    MppFrameFormat  fmt;
+    /* expected planes as row bytes, rows and offset from h_stride * v_stride */
+    RK_U32          count;
+    RK_U32          row[3];
+    RK_U32          rows[3];
+    RK_U32          stride[3];
+    RK_U32          offset[3];
+} FormatDesc;
+
+/* 64x32 frame in 128x48 stride */
+#define W   64
+#define H   32
+#define HS  128
+#define VS  48
+#define LS  (HS * VS)
+
+static const FormatDesc formats[] = {
+    { MPP_FMT_YUV420SP,       2, { W, W },              { H, H / 2 },         { HS, HS },           { 0, LS } },
+    { MPP_FMT_YUV420SP_10BIT, 2, { 80, 80 },            { H, H / 2 },         { HS, HS },           { 0, LS } },
+    { MPP_FMT_YUV422SP,       2, { W, W },              { H, H },             { HS, HS },           { 0, LS } },
+    { MPP_FMT_YUV422SP_10BIT, 2, { 80, 80 },            { H, H },             { HS, HS },           { 0, LS } },
+    { MPP_FMT_YUV420P,        3, { W, W / 2, W / 2 },   { H, H / 2, H / 2 },  { HS, HS / 2, HS / 2 }, { 0, LS, LS * 5 / 4 } },
+    { MPP_FMT_YUV420SP_VU,    2, { W, W },              { H, H / 2 },         { HS, HS },           { 0, LS } },
+    { MPP_FMT_YUV422P,        3, { W, W / 2, W / 2 },   { H, H, H },          { HS, HS / 2, HS / 2 }, { 0, LS, LS * 3 / 2 } },
+    { MPP_FMT_YUV422SP_VU,    2, { W, W },              { H, H },             { HS, HS },           { 0, LS } },
+    { MPP_FMT_YUV422_YUYV,    1, { W * 2 },             { H },                { HS },               { 0 } },
+    { MPP_FMT_YUV422_UYVY,    1, { W * 2 },             { H },                { HS },               { 0 } },
+    { MPP_FMT_RGB565,         1, { W * 2 },             { H },                { HS },               { 0 } },
+    { MPP_FMT_BGR444,         1, { W * 2 },             { H },                { HS },               { 0 } },
+    { MPP_FMT_RGB888,         1, { W * 3 },             { H },                { HS * 3 },           { 0 } },
+    { MPP_FMT_BGR101010,      1, { W * 4 },             { H },                { HS * 4 },           { 0 } },
+    { MPP_FMT_ARGB8888,       1, { W * 4 },             { H },                { HS * 4 },           { 0 } },
+};
+
+static MppFrame make_frame(MppBuffer buffer, MppFrameFormat fmt, RK_U32 width,
+                           RK_U32 height, RK_U32 h_stride, RK_U32 v_stride)
+{
+    MppFrame frame = NULL;
+
+    mpp_frame_init(&frame);
+    mpp_frame_set_width(frame, width);
+    mpp_frame_set_height(frame, height);
+    mpp_frame_set_hor_stride(frame, h_stride);
+    mpp_frame_set_ver_stride(frame, v_stride);
+    mpp_frame_set_fmt(frame, fmt);
+    mpp_frame_set_buffer(frame, buffer);
+
+    return frame;
+}
+
+static RK_U8 *read_file(size_t *size)
+{
+    FILE *fp = fopen(WRITER_FILE, "rb");
+    RK_U8 *data = NULL;
+    long len;
+
+    if (NULL == fp)
+        return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    data = mpp_malloc(RK_U8, len + 1);
+    if (data)
+        *size = fread(data, 1, len, fp);
+    fclose(fp);
+
+    return data;
+}
+
+static MPP_RET check_formats(MppBufferGroup group)
+{
+    MPP_RET ret = MPP_NOK;
+    MppBuffer buffer = NULL;
+    RK_U8 *base = NULL;
+    RK_U32 i, j, k;
+
+    if (mpp_buffer_get(group, &buffer, LS * 12))
+        return MPP_NOK;
+
+    base = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+    for (i = 0; i < LS * 12; i++)
+        base[i] = (RK_U8)(i * 7 + (i >> 8));
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(formats); i++) {
+        const FormatDesc *desc = &formats[i];
+        /* packed formats take the stride in pixels */
+        MppFrame frame = make_frame(buffer, desc->fmt, W, H, HS, VS);
+        FILE *fp = fopen(WRITER_FILE, "wb");
+        RK_U8 *data = NULL;
+        RK_U8 *pos = NULL;
+        size_t size = 0;
+        size_t expect = 0;
+
+        if (NULL == fp || mpp_frame_writer_dump(frame, fp)) {
+            mpp_err("format %x write failed\n", desc->fmt);
+            if (fp)
+                fclose(fp);
+            mpp_frame_deinit(&frame);
+            goto __RETURN;
+        }
+        fclose(fp);
+        mpp_frame_deinit(&frame);
+
+        data = read_file(&size);
+        pos = data;
+        for (j = 0; j < desc->count; j++)
+            expect += desc->row[j] * desc->rows[j];
+
+        if (NULL == data || size != expect) {
+            mpp_err("format %x size %d expect %d\n", desc->fmt, size, expect);
+            MPP_FREE(data);
+            goto __RETURN;
+        }
+
+        for (j = 0; j < desc->count; j++) {
+            for (k = 0; k < desc->rows[j]; k++, pos += desc->row[j]) {
+                if (memcmp(pos, base + desc->offset[j] + k * desc->stride[j], desc->row[j])) {
+                    mpp_err("format %x plane %d row %d mismatch\n", desc->fmt, j, k);
+                    MPP_FREE(data);
+                    goto __RETURN;
+                }
+            }
+        }
+        MPP_FREE(data);
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    mpp_buffer_put(buffer);
+    return ret;
+}
+
+static MPP_RET check_checksum(MppBufferGroup group, MppFrameWriterMode mode, const char *expect)
+{
+    MPP_RET ret = MPP_NOK;
+    MppFrameWriter writer = NULL;
+    MppFrameWriterCfg cfg;
+    MppBuffer buffer = NULL;
+    MppFrame frame = NULL;
+    RK_U8 *data = NULL;
+    size_t size = 0;
+
+    if (mpp_buffer_get(group, &buffer, 64))
+        return MPP_NOK;
+
+    // "abc" as one rgb888 pixel
+    memcpy(mpp_buffer_get_ptr(buffer), "abc", 3);
+    frame = make_frame(buffer, MPP_FMT_RGB888, 1, 1, 16, 1);
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mode = mode;
+    cfg.fp = fopen(WRITER_FILE, "wb");
+    cfg.async = 1;
+    if (NULL == cfg.fp || mpp_frame_writer_init(&writer, &cfg))
+        goto __RETURN;
+
+    mpp_frame_writer_put(writer, frame);
+    mpp_frame_writer_put(writer, frame);
+    mpp_frame_writer_deinit(writer);
+    fclose(cfg.fp);
+    cfg.fp = NULL;
+
+    data = read_file(&size);
+    if (NULL == data)
+        goto __RETURN;
+    data[size] = '\0';
+
+    if (size != 2 * (strlen(expect) + 1) || strncmp((char *)data, expect, strlen(expect)) ||
+        strncmp((char *)data + size / 2, expect, strlen(expect))) {
+        mpp_err("checksum mode %d got %s expect %s\n", mode, data, expect);
+        goto __RETURN;
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    if (cfg.fp)
+        fclose(cfg.fp);
+    MPP_FREE(data);
+    mpp_frame_deinit(&frame);
+    mpp_buffer_put(buffer);
+    return ret;
+}
+
+/* frame dump before the writer */
+static void dump_by_row(MppFrame frame, FILE *fp)
+{
+    RK_U32 width    = mpp_frame_get_width(frame);
+    RK_U32 height   = mpp_frame_get_height(frame);
+    RK_U32 h_stride = mpp_frame_get_hor_stride(frame);
+    RK_U32 v_stride = mpp_frame_get_ver_stride(frame);
+    RK_U8 *base_y = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(frame));
+    RK_U8 *base_c = base_y + h_stride * v_stride;
+    RK_U32 i;
+
+    for (i = 0; i < height; i++, base_y += h_stride)
+        fwrite(base_y, 1, width, fp);
+    for (i = 0; i < height / 2; i++, base_c += h_stride)
+        fwrite(base_c, 1, width, fp);
+}
+
+/*
+ * mode: 0 - fwrite per row
+ *       1 - writer in caller thread
+ *       2 - writer thread
+ *       3 - writer thread md5 only
+ */
+static MPP_RET run_output(MppFrame *frames, RK_U32 count, RK_S32 mode, RK_U32 h_stride)
+{
+    static const char *names[] = { "fwrite rows", "writer sync", "writer async", "md5 only" };
+    MppFrameWriter writer = NULL;
+    MppFrameWriterCfg cfg;
+    RK_S64 start;
+    RK_S64 time;
+    RK_U32 i;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mode = (mode == 3) ? MPP_FRAME_WRITER_MD5 : MPP_FRAME_WRITER_RAW;
+    cfg.fp = (mode == 3) ? NULL : fopen(WRITER_FILE, "wb");
+    cfg.async = (mode >= 2);
+    if ((mode != 3 && NULL == cfg.fp) ||
+        (mode && mpp_frame_writer_init(&writer, &cfg))) {
+        if (cfg.fp)
+            fclose(cfg.fp);
+        return MPP_NOK;
+    }
+
+    start = mpp_time_us();
+    for (i = 0; i < WRITER_FRAME_COUNT; i++) {
+        MppFrame frame = frames[i % count];
+
+        mpp_frame_set_hor_stride(frame, h_stride);
+        if (mode)
+            mpp_frame_writer_put(writer, frame);
+        else
+            dump_by_row(frame, cfg.fp);
+    }
+    if (writer)
+        mpp_frame_writer_deinit(writer);
+    if (cfg.fp) {
+        fflush(cfg.fp);
+        fsync(fileno(cfg.fp));
+        fclose(cfg.fp);
+    }
+    time = mpp_time_us() - start;
+
+    mpp_log("stride %4d %-12s %d frames %7.2f ms %7.1f MB/s\n", h_stride, names[mode],
+            WRITER_FRAME_COUNT, (float)time / 1000,
+            (float)WRITER_WIDTH * WRITER_HEIGHT * 3 / 2 * WRITER_FRAME_COUNT / time);
+
+    return MPP_OK;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    MppBufferGroup group = NULL;
+    MppBuffer buffers[4];
+    MppFrame frames[4];
+    RK_U32 i;
+    RK_S32 mode;
+
+    mpp_log("mpp_frame_writer_test start\n");
+
+    memset(buffers, 0, sizeof(buffers));
+    memset(frames, 0, sizeof(frames));
+
+    if (mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL))
+        goto __RETURN;
+
+    if (check_formats(group)) {
+        mpp_err("format check failed\n");
+        goto __RETURN;
+    }
+
+    if (check_checksum(group, MPP_FRAME_WRITER_MD5, "900150983cd24fb0d6963f7d28e17f72") ||
+        check_checksum(group, MPP_FRAME_WRITER_CRC32, "352441c2")) {
+        mpp_err("checksum check failed\n");
+        goto __RETURN;
+    }
+
+    for (i = 0; i < 4; i++) {
+        size_t size = WRITER_HOR_STRIDE * WRITER_VER_STRIDE * 3 / 2;
+
+        if (mpp_buffer_get(group, &buffers[i], size))
+            goto __RETURN;
+
+        memset(mpp_buffer_get_ptr(buffers[i]), 0x10 * i, size);
+        frames[i] = make_frame(buffers[i], MPP_FMT_YUV420SP, WRITER_WIDTH, WRITER_HEIGHT,
+                               WRITER_HOR_STRIDE, WRITER_VER_STRIDE);
+    }
+
+    // padded stride then stride equal to width
+    for (mode = 0; mode < 4; mode++) {
+        if (run_output(frames, 4, mode, WRITER_HOR_STRIDE))
+            goto __RETURN;
+    }
+    for (mode = 0; mode < 4; mode++) {
+        if (run_output(frames, 4, mode, WRITER_WIDTH))
+            goto __RETURN;
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    for (i = 0; i < 4; i++) {
+        if (frames[i])
+            mpp_frame_deinit(&frames[i]);
+        if (buffers[i])
+            mpp_buffer_put(buffers[i]);
+    }
+    if (group)
+        mpp_buffer_group_put(group);
+    unlink(WRITER_FILE);
+
+    mpp_log("mpp_frame_writer_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_meta_test"
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "mpp_log.h"
+#include "mpp_env.h"
+#include "mpp_time.h"
+#include "mpp_meta.h"
+
+#define META_BENCH_FRAMES       100000
+#define META_BENCH_THREADS      4
+
+static MPP_RET test_meta_val(void)
+{
+    MPP_RET ret = MPP_NOK;
+    MppMeta meta = NULL;
+    MppFrame frame = (MppFrame)&ret;
+    MppFrame frame_out = NULL;
+    RK_S32 val = 0;
+    void *ptr = NULL;
+
+    if (mpp_meta_get(&meta))
+        return MPP_NOK;
+
+    if (mpp_meta_set_s32(meta, MPP_META_KEY_OUTPUT_INTRA, 1) ||
+        mpp_meta_set_s32(meta, MPP_META_KEY_OUTPUT_SCENE, 2) ||
+        mpp_meta_set_ptr(meta, MPP_META_KEY_INPUT_ROI, &val) ||
+        mpp_meta_set_frame(meta, MPP_META_KEY_INPUT_FRM, frame)) {
+        mpp_err("failed to set meta value\n");
+        goto __RETURN;
+    }
+
+    /* the last set value is kept */
+    mpp_meta_set_s32(meta, MPP_META_KEY_OUTPUT_SCENE, 3);
+
+    /* key with wrong type is rejected */
+    if (MPP_OK == mpp_meta_set_s64(meta, MPP_META_KEY_OUTPUT_INTRA, 1) ||
+        MPP_OK == mpp_meta_get_ptr(meta, MPP_META_KEY_OUTPUT_SCENE, &ptr) ||
+        MPP_OK == mpp_meta_set_s32(meta, (MppMetaKey)0, 1)) {
+        mpp_err("invalid key or type is accepted\n");
+        goto __RETURN;
+    }
+
+    if (mpp_meta_get_s32(meta, MPP_META_KEY_OUTPUT_SCENE, &val) || val != 3) {
+        mpp_err("scene value %d mismatch\n", val);
+        goto __RETURN;
+    }
+
+    if (mpp_meta_get_frame(meta, MPP_META_KEY_INPUT_FRM, &frame_out) || frame_out != frame) {
+        mpp_err("frame value %p mismatch\n", frame_out);
+        goto __RETURN;
+    }
+
+    /* get consumes the value */
+    if (MPP_OK == mpp_meta_get_s32(meta, MPP_META_KEY_OUTPUT_SCENE, &val) ||
+        MPP_OK == mpp_meta_get_frame(meta, MPP_META_KEY_INPUT_FRM, &frame_out) ||
+        MPP_OK == mpp_meta_get_s32(meta, MPP_META_KEY_INPUT_BLOCK, &val)) {
+        mpp_err("value is not consumed by get\n");
+        goto __RETURN;
+    }
+
+    ret = MPP_OK;
+__RETURN:
+    mpp_meta_put(meta);
+
+    /* recycled meta does not keep old value */
+    if (MPP_OK == ret && MPP_OK == mpp_meta_get(&meta)) {
+        if (MPP_OK == mpp_meta_get_s32(meta, MPP_META_KEY_OUTPUT_INTRA, &val)) {
+            mpp_err("recycled meta keeps old value\n");
+            ret = MPP_NOK;
+        }
+        mpp_meta_put(meta);
+    }
+
+    return ret;
+}
+
+/* meta usage of one encoder frame: create, attach flow data and flags, consume, destroy */
+static void *meta_churn(void *arg)
+{
+    RK_S32 frames = *(RK_S32 *)arg;
+    RK_S32 i;
+
+    for (i = 0; i < frames; i++) {
+        MppMeta meta = NULL;
+        MppFrame frame = NULL;
+        MppPacket packet = NULL;
+        RK_S32 val = 0;
+
+        mpp_meta_get(&meta);
+        mpp_meta_set_frame(meta, MPP_META_KEY_INPUT_FRM, (MppFrame)&frames);
+        mpp_meta_set_packet(meta, MPP_META_KEY_OUTPUT_PKT, (MppPacket)&i);
+        mpp_meta_set_s32(meta, MPP_META_KEY_OUTPUT_INTRA, i & 1);
+        mpp_meta_set_s32(meta, MPP_META_KEY_OUTPUT_SCENE, 0);
+
+        mpp_meta_get_frame(meta, MPP_META_KEY_INPUT_FRM, &frame);
+        mpp_meta_get_packet(meta, MPP_META_KEY_OUTPUT_PKT, &packet);
+        mpp_meta_get_s32(meta, MPP_META_KEY_OUTPUT_INTRA, &val);
+        mpp_meta_get_s32(meta, MPP_META_KEY_OUTPUT_SCENE, &val);
+        mpp_meta_put(meta);
+    }
+
+    return NULL;
+}
+
+static void bench_meta(RK_S32 frames, RK_S32 thread_count)
+{
+    pthread_t threads[META_BENCH_THREADS];
+    RK_S64 start;
+    RK_S32 i;
+
+    start = mpp_time_us();
+    for (i = 0; i < thread_count; i++)
+        pthread_create(&threads[i], NULL, meta_churn, &frames);
+
+    for (i = 0; i < thread_count; i++)
+        pthread_join(threads[i], NULL);
+
+    start = mpp_time_us() - start;
+    mpp_log("meta churn %d threads x %d frames: %lld ns per frame\n",
+            thread_count, frames, start * 1000 / ((RK_S64)frames * thread_count));
+}
+
+int main(int argc, char **argv)
+{
+    MPP_RET ret;
+    RK_S32 frames = META_BENCH_FRAMES;
+
+    mpp_log("mpp_meta_test start\n");
+
+    if (argc > 1)
+        frames = atoi(argv[1]);
+
+    ret = test_meta_val();
+    if (MPP_OK == ret) {
+        bench_meta(frames, 1);
+        bench_meta(frames / META_BENCH_THREADS, META_BENCH_THREADS);
+    }
+
+    mpp_log("mpp_meta_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -0,0 +1,510 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_stream_reader_test"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+
+#include "mpp_stream_reader.h"
+
+/*
+ * elementary stream reader test
+ *
+ * Generated h.264, h.265 and ivf streams with known frame boundaries are read
+ * in frame mode and each packet must be exactly one frame. Chunk and random
+ * mode must cover the file without gap, random mode must repeat with its
+ * seed. The benchmark compares the fread and copy loop of the test tools
+ * with the mapped reader on the same file.
+ */
+#define TEST_FILE               "/tmp/mpp_stream_reader_test.bin"
+#define TEST_FRAME_COUNT        500
+#define TEST_MAX_UNIT           3000
+#define TEST_BENCH_SIZE         (SZ_1M * 32)
+
+typedef struct TestStream_t {
+    RK_U8           *data;
+    size_t          size;
+    size_t          max;
+    /* frame begin offsets with the file size at the end */
+    size_t          *frames;
+    RK_S64          *pts;
+    RK_U32          count;
+    RK_U32          rand;
+} TestStream;
+
+static RK_U32 test_rand(TestStream *s)
+{
+    s->rand = s->rand * 1103515245 + 12345;
+    return s->rand >> 8;
+}
+
+static void put_bytes(TestStream *s, const RK_U8 *bytes, size_t len)
+{
+    if (s->size + len > s->max) {
+        s->max = (s->size + len) * 2;
+        s->data = mpp_realloc(s->data, RK_U8, s->max);
+    }
+    memcpy(s->data + s->size, bytes, len);
+    s->size += len;
+}
+
+/* start code, header bytes, then payload without zero bytes */
+static void put_unit(TestStream *s, const RK_U8 *hdr, RK_U32 hdr_len)
+{
+    static const RK_U8 sc4[] = { 0, 0, 0, 1 };
+    RK_U32 len = test_rand(s) % TEST_MAX_UNIT + 1;
+    RK_U32 four = s->size && (test_rand(s) & 1);
+    RK_U8 byte;
+    RK_U32 i;
+
+    put_bytes(s, sc4 + !four, 3 + four);
+    put_bytes(s, hdr, hdr_len);
+    for (i = 0; i < len; i++) {
+        byte = test_rand(s) % 255 + 1;
+        put_bytes(s, &byte, 1);
+    }
+}
+
+static void begin_frame(TestStream *s, RK_S64 pts)
+{
+    s->frames[s->count] = s->size;
+    s->pts[s->count] = pts;
+    s->count++;
+}
+
+static void gen_h264(TestStream *s)
+{
+    static const RK_U8 sps[] = { 0x67, 0x42 };
+    static const RK_U8 pps[] = { 0x68, 0xce };
+    static const RK_U8 aud[] = { 0x09, 0xf0 };
+    static const RK_U8 sei[] = { 0x06, 0x05 };
+    static const RK_U8 idr[] = { 0x65, 0x88 };
+    static const RK_U8 idr_next[] = { 0x65, 0x5c };
+    static const RK_U8 p_slice[] = { 0x41, 0x9a };
+    static const RK_U8 p_next[] = { 0x41, 0x22 };
+    static const RK_U8 prefix[] = { 0x6e, 0x81 };
+    static const RK_U8 filler[] = { 0x0c, 0xff };
+    RK_U32 i;
+
+    for (i = 0; i < TEST_FRAME_COUNT; i++) {
+        RK_U32 slices = test_rand(s) % 3;
+        RK_U32 idr_frm = (i % 30) == 0;
+
+        begin_frame(s, 0);
+        if (test_rand(s) % 4 == 0)
+            put_unit(s, aud, sizeof(aud));
+        if (idr_frm) {
+            put_unit(s, sps, sizeof(sps));
+            put_unit(s, pps, sizeof(pps));
+        }
+        if (test_rand(s) % 3 == 0)
+            put_unit(s, sei, sizeof(sei));
+        if (test_rand(s) % 5 == 0)
+            put_unit(s, prefix, sizeof(prefix));
+
+        put_unit(s, idr_frm ? idr : p_slice, 2);
+        while (slices--)
+            put_unit(s, idr_frm ? idr_next : p_next, 2);
+
+        if (test_rand(s) % 8 == 0)
+            put_unit(s, filler, sizeof(filler));
+    }
+    s->frames[s->count] = s->size;
+}
+
+static void gen_h265(TestStream *s)
+{
+    static const RK_U8 vps[] = { 0x40, 0x01, 0x0c };
+    static const RK_U8 sps[] = { 0x42, 0x01, 0x01 };
+    static const RK_U8 pps[] = { 0x44, 0x01, 0xc1 };
+    static const RK_U8 prefix_sei[] = { 0x4e, 0x01, 0x05 };
+    static const RK_U8 suffix_sei[] = { 0x50, 0x01, 0x84 };
+    static const RK_U8 idr[] = { 0x26, 0x01, 0xaf };
+    static const RK_U8 idr_next[] = { 0x26, 0x01, 0x50 };
+    static const RK_U8 trail[] = { 0x02, 0x01, 0xd0 };
+    static const RK_U8 trail_next[] = { 0x02, 0x01, 0x68 };
+    RK_U32 i;
+
+    for (i = 0; i < TEST_FRAME_COUNT; i++) {
+        RK_U32 slices = test_rand(s) % 3;
+        RK_U32 idr_frm = (i % 30) == 0;
+
+        begin_frame(s, 0);
+        if (idr_frm) {
+            put_unit(s, vps, sizeof(vps));
+            put_unit(s, sps, sizeof(sps));
+            put_unit(s, pps, sizeof(pps));
+        }
+        if (test_rand(s) % 3 == 0)
+            put_unit(s, prefix_sei, sizeof(prefix_sei));
+
+        put_unit(s, idr_frm ? idr : trail, 3);
+        while (slices--)
+            put_unit(s, idr_frm ? idr_next : trail_next, 3);
+
+        if (test_rand(s) % 4 == 0)
+            put_unit(s, suffix_sei, sizeof(suffix_sei));
+    }
+    s->frames[s->count] = s->size;
+}
+
+static void gen_ivf(TestStream *s)
+{
+    RK_U8 hdr[32];
+    RK_U32 i;
+
+    memset(hdr, 0, sizeof(hdr));
+    memcpy(hdr, "DKIF", 4);
+    hdr[6] = sizeof(hdr);
+    memcpy(hdr + 8, "VP90", 4);
+    put_bytes(s, hdr, sizeof(hdr));
+
+    for (i = 0; i < TEST_FRAME_COUNT; i++) {
+        RK_U32 len = test_rand(s) % TEST_MAX_UNIT + 1;
+        RK_S64 pts = (RK_S64)i * 3003 + ((RK_S64)1 << 40);
+        RK_U8 frm[12];
+        RK_U32 j;
+
+        for (j = 0; j < 4; j++)
+            frm[j] = (len >> (j * 8)) & 0xff;
+        for (j = 0; j < 8; j++)
+            frm[4 + j] = (pts >> (j * 8)) & 0xff;
+        put_bytes(s, frm, sizeof(frm));
+
+        begin_frame(s, pts);
+        for (j = 0; j < len; j++) {
+            RK_U8 byte = test_rand(s);
+            put_bytes(s, &byte, 1);
+        }
+        /* ivf payload ends at the next frame header */
+        s->frames[s->count] = s->size;
+    }
+}
+
+static MPP_RET write_stream(TestStream *s)
+{
+    FILE *fp = fopen(TEST_FILE, "wb");
+
+    if (NULL == fp)
+        return MPP_NOK;
+
+    if (s->size)
+        fwrite(s->data, 1, s->size, fp);
+    fclose(fp);
+
+    return MPP_OK;
+}
+
+static void reset_stream(TestStream *s)
+{
+    s->size = 0;
+    s->count = 0;
+    s->rand = 0x1234;
+}
+
+static MPP_RET check_frames(TestStream *s, MppCodingType coding, RK_U32 ivf)
+{
+    MppStreamReaderCfg cfg;
+    MppStreamReaderStat stat;
+    MppStreamReader reader = NULL;
+    MPP_RET ret = MPP_NOK;
+    RK_U32 i;
+
+    if (write_stream(s))
+        return MPP_NOK;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mode = MPP_STREAM_READER_FRAME;
+    cfg.coding = coding;
+    if (mpp_stream_reader_init(&reader, TEST_FILE, &cfg))
+        return MPP_NOK;
+
+    for (i = 0; i < s->count; i++) {
+        MppPacket packet = NULL;
+        size_t begin = s->frames[i];
+        /* ivf frame ends before the next frame header */
+        size_t end = (ivf && i + 1 < s->count) ? s->frames[i + 1] - 12 : s->frames[i + 1];
+        RK_U8 *data;
+        size_t len;
+        RK_U32 eos;
+
+        mpp_stream_reader_get_packet(reader, &packet);
+        data = (RK_U8 *)mpp_packet_get_data(packet);
+        len = mpp_packet_get_length(packet);
+        eos = mpp_packet_get_eos(packet);
+
+        if (len != end - begin || memcmp(data, s->data + begin, len) ||
+            eos != (i + 1 == s->count) || mpp_packet_get_pts(packet) != s->pts[i]) {
+            mpp_err("coding %x frame %d offset %d size %d got size %d eos %d\n",
+                    coding, i, (RK_S32)begin, (RK_S32)(end - begin), (RK_S32)len, eos);
+            mpp_packet_deinit(&packet);
+            goto __RETURN;
+        }
+        mpp_packet_deinit(&packet);
+    }
+
+    mpp_stream_reader_get_stat(reader, &stat);
+    if (stat.frames != s->count) {
+        mpp_err("coding %x indexed %d frames expect %d\n", coding, stat.frames, s->count);
+        goto __RETURN;
+    }
+
+    mpp_log("coding %x frame mode %d frames %d bytes index %.2f ms\n",
+            coding, stat.frames, (RK_S32)stat.size, (float)stat.index_time / 1000);
+    ret = MPP_OK;
+__RETURN:
+    mpp_stream_reader_deinit(reader);
+    return ret;
+}
+
+/* packets must cover the file in order, returns the packet count */
+static RK_S32 check_chunks(TestStream *s, MppStreamReader reader, RK_U32 max,
+                           RK_U32 *sizes, RK_U32 size_cnt)
+{
+    size_t pos = 0;
+    RK_S32 count = 0;
+    RK_U32 eos = 0;
+
+    while (!eos) {
+        MppPacket packet = NULL;
+        RK_U8 *data;
+        size_t len;
+
+        mpp_stream_reader_get_packet(reader, &packet);
+        data = (RK_U8 *)mpp_packet_get_data(packet);
+        len = mpp_packet_get_length(packet);
+        eos = mpp_packet_get_eos(packet);
+        mpp_packet_deinit(&packet);
+
+        if (len > max || pos + len > s->size || (len && memcmp(data, s->data + pos, len)) ||
+            (!eos && len != max && !sizes) || (!len && s->size)) {
+            mpp_err("chunk %d at %d size %d mismatch\n", count, (RK_S32)pos, (RK_S32)len);
+            return -1;
+        }
+
+        if (sizes && (RK_U32)count < size_cnt)
+            sizes[count] = len;
+
+        pos += len;
+        count++;
+    }
+
+    if (pos != s->size) {
+        mpp_err("chunks end at %d file size %d\n", (RK_S32)pos, (RK_S32)s->size);
+        return -1;
+    }
+
+    return count;
+}
+
+static MPP_RET check_chunk_modes(TestStream *s)
+{
+    MppStreamReaderCfg cfg;
+    MppStreamReader reader = NULL;
+    RK_U32 sizes[2][64];
+    RK_S32 count[2];
+    RK_S32 i;
+
+    if (write_stream(s))
+        return MPP_NOK;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mode = MPP_STREAM_READER_CHUNK;
+    cfg.chunk_size = 4096;
+    if (mpp_stream_reader_init(&reader, TEST_FILE, &cfg))
+        return MPP_NOK;
+
+    count[0] = check_chunks(s, reader, cfg.chunk_size, NULL, 0);
+    mpp_stream_reader_deinit(reader);
+    if (count[0] != (RK_S32)MPP_MAX(1, (s->size + 4095) / 4096)) {
+        mpp_err("chunk mode %d packets for size %d\n", count[0], (RK_S32)s->size);
+        return MPP_NOK;
+    }
+
+    /* vp8 frame mode without ivf falls back to chunks */
+    cfg.mode = MPP_STREAM_READER_FRAME;
+    cfg.coding = MPP_VIDEO_CodingVP8;
+    if (mpp_stream_reader_init(&reader, TEST_FILE, &cfg))
+        return MPP_NOK;
+
+    if (mpp_stream_reader_get_mode(reader) != MPP_STREAM_READER_CHUNK) {
+        mpp_err("frame mode fallback does not report chunk mode\n");
+        mpp_stream_reader_deinit(reader);
+        return MPP_NOK;
+    }
+
+    count[1] = check_chunks(s, reader, cfg.chunk_size, NULL, 0);
+    mpp_stream_reader_deinit(reader);
+    if (count[1] != count[0]) {
+        mpp_err("frame mode fallback %d packets expect %d\n", count[1], count[0]);
+        return MPP_NOK;
+    }
+
+    cfg.mode = MPP_STREAM_READER_RANDOM;
+    cfg.seed = 77;
+    cfg.chunk_size = 1000;
+    if (mpp_stream_reader_init(&reader, TEST_FILE, &cfg))
+        return MPP_NOK;
+
+    memset(sizes, 0, sizeof(sizes));
+    for (i = 0; i < 2; i++) {
+        count[i] = check_chunks(s, reader, cfg.chunk_size, sizes[i], MPP_ARRAY_ELEMS(sizes[i]));
+        mpp_stream_reader_rewind(reader);
+    }
+    mpp_stream_reader_deinit(reader);
+
+    if (count[0] < 0 || count[0] != count[1] || memcmp(sizes[0], sizes[1], sizeof(sizes[0]))) {
+        mpp_err("random mode does not repeat with its seed\n");
+        return MPP_NOK;
+    }
+
+    if (s->size > 1000 * 64 && sizes[0][0] == sizes[0][1] && sizes[0][1] == sizes[0][2]) {
+        mpp_err("random mode sizes do not vary\n");
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+static void run_bench(TestStream *s)
+{
+    MppStreamReaderCfg cfg;
+    MppStreamReaderStat stat;
+    MppStreamReader reader = NULL;
+    MppPacket packet = NULL;
+    RK_U8 *buf = mpp_malloc(RK_U8, SZ_64K);
+    RK_S64 start;
+    RK_S64 first = 0;
+    RK_S64 time[3];
+    RK_U32 count = 0;
+    FILE *fp;
+
+    while (s->size < TEST_BENCH_SIZE) {
+        s->count = 0;
+        gen_h264(s);
+    }
+    if (write_stream(s))
+        goto __RETURN;
+
+    /* fread and copy loop of the test tools */
+    fp = fopen(TEST_FILE, "rb");
+    mpp_packet_init(&packet, buf, SZ_64K);
+    start = mpp_time_us();
+    while (1) {
+        size_t len = fread(buf, 1, SZ_64K, fp);
+
+        mpp_packet_write(packet, 0, buf, len);
+        mpp_packet_set_pos(packet, buf);
+        if (len != SZ_64K)
+            break;
+    }
+    time[0] = mpp_time_us() - start;
+    mpp_packet_deinit(&packet);
+    fclose(fp);
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mode = MPP_STREAM_READER_CHUNK;
+    start = mpp_time_us();
+    mpp_stream_reader_init(&reader, TEST_FILE, &cfg);
+    do {
+        mpp_stream_reader_get_packet(reader, &packet);
+        count = mpp_packet_get_eos(packet);
+        mpp_packet_deinit(&packet);
+    } while (!count);
+    mpp_stream_reader_deinit(reader);
+    time[1] = mpp_time_us() - start;
+
+    cfg.mode = MPP_STREAM_READER_FRAME;
+    cfg.coding = MPP_VIDEO_CodingAVC;
+    start = mpp_time_us();
+    mpp_stream_reader_init(&reader, TEST_FILE, &cfg);
+    count = 0;
+    while (1) {
+        RK_U32 eos;
+
+        mpp_stream_reader_get_packet(reader, &packet);
+        if (!first)
+            first = mpp_time_us() - start;
+        eos = mpp_packet_get_eos(packet);
+        mpp_packet_deinit(&packet);
+        count++;
+        if (eos)
+            break;
+    }
+    time[2] = mpp_time_us() - start;
+    mpp_stream_reader_get_stat(reader, &stat);
+    mpp_stream_reader_deinit(reader);
+
+    mpp_log("%d MB in 64K chunks fread copy %.2f ms mapped %.2f ms\n",
+            (RK_S32)(s->size / SZ_1M), (float)time[0] / 1000, (float)time[1] / 1000);
+    mpp_log("%d frames first packet after %.2f ms all after %.2f ms index %.2f ms\n",
+            count, (float)first / 1000, (float)time[2] / 1000,
+            (float)stat.index_time / 1000);
+
+__RETURN:
+    MPP_FREE(buf);
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    TestStream s;
+
+    mpp_log("mpp_stream_reader_test start\n");
+
+    memset(&s, 0, sizeof(s));
+    s.frames = mpp_malloc(size_t, TEST_FRAME_COUNT * 256 + 1);
+    s.pts = mpp_malloc(RK_S64, TEST_FRAME_COUNT * 256 + 1);
+
+    reset_stream(&s);
+    gen_h264(&s);
+    if (check_frames(&s, MPP_VIDEO_CodingAVC, 0) || check_chunk_modes(&s))
+        goto __RETURN;
+
+    reset_stream(&s);
+    gen_h265(&s);
+    if (check_frames(&s, MPP_VIDEO_CodingHEVC, 0))
+        goto __RETURN;
+
+    reset_stream(&s);
+    gen_ivf(&s);
+    if (check_frames(&s, MPP_VIDEO_CodingVP9, 1))
+        goto __RETURN;
+
+    reset_stream(&s);
+    if (check_chunk_modes(&s))
+        goto __RETURN;
+
+    reset_stream(&s);
+    run_bench(&s);
+
+    ret = MPP_OK;
+__RETURN:
+    unlink(TEST_FILE);
+    MPP_FREE(s.data);
+    MPP_FREE(s.frames);
+    MPP_FREE(s.pts);
+
+    mpp_log("mpp_stream_reader_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
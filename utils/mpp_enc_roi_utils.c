@@ -0,0 +1,214 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_enc_roi"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+
+#include "mpp_enc_roi_utils.h"
+
+#define ROI_MB_SIZE             16
+/* 2x2 averaged macroblock is 8x8 */
+#define ROI_MB_PIXELS           64
+#define ROI_DEFAULT_THRESHOLD   3
+#define ROI_DEFAULT_HOLD        8
+
+typedef struct MppEncRoiMotionImpl_t {
+    MppEncRoiMotionCfg  cfg;
+    RK_S32              mb_w;
+    RK_S32              mb_h;
+    RK_U8               *prev;
+    RK_U8               *cnt;
+    RK_S32              has_prev;
+} MppEncRoiMotionImpl;
+
+/* 2x2 average of one macroblock, border macroblock repeats the last pixel */
+static void roi_mb_scale(MppEncRoiMotionImpl *p, RK_U8 *luma, RK_S32 mb_x, RK_S32 mb_y, RK_U8 *dst)
+{
+    RK_S32 stride = p->cfg.hor_stride;
+    RK_S32 x_max = p->cfg.width - 1;
+    RK_S32 y_max = p->cfg.height - 1;
+    RK_S32 x, y;
+
+    for (y = 0; y < 8; y++) {
+        RK_S32 y0 = MPP_MIN(mb_y * ROI_MB_SIZE + y * 2, y_max);
+        RK_S32 y1 = MPP_MIN(y0 + 1, y_max);
+        RK_U8 *r0 = luma + y0 * stride;
+        RK_U8 *r1 = luma + y1 * stride;
+
+        for (x = 0; x < 8; x++) {
+            RK_S32 x0 = MPP_MIN(mb_x * ROI_MB_SIZE + x * 2, x_max);
+            RK_S32 x1 = MPP_MIN(x0 + 1, x_max);
+
+            dst[y * 8 + x] = (RK_U8)((r0[x0] + r0[x1] + r1[x0] + r1[x1] + 2) >> 2);
+        }
+    }
+}
+
+MPP_RET mpp_enc_roi_motion_init(MppEncRoiMotion *ctx, MppEncRoiMotionCfg *cfg)
+{
+    MppEncRoiMotionImpl *p = NULL;
+    RK_S32 mb_count;
+
+    if (NULL == ctx || NULL == cfg) {
+        mpp_err_f("found NULL input ctx %p cfg %p\n", ctx, cfg);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *ctx = NULL;
+
+    if (cfg->width <= 0 || cfg->height <= 0 || cfg->hor_stride < cfg->width) {
+        mpp_err_f("invalid size %dx%d stride %d\n", cfg->width, cfg->height, cfg->hor_stride);
+        return MPP_ERR_VALUE;
+    }
+
+    p = mpp_calloc(MppEncRoiMotionImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->cfg = *cfg;
+    if (p->cfg.threshold <= 0)
+        p->cfg.threshold = ROI_DEFAULT_THRESHOLD;
+    if (p->cfg.hold <= 0)
+        p->cfg.hold = ROI_DEFAULT_HOLD;
+    p->cfg.hold = MPP_MIN(p->cfg.hold, 255);
+
+    p->mb_w = (cfg->width + 15) / 16;
+    p->mb_h = (cfg->height + 15) / 16;
+    mb_count = p->mb_w * p->mb_h;
+    p->prev = mpp_malloc(RK_U8, mb_count * ROI_MB_PIXELS);
+    p->cnt = mpp_calloc(RK_U8, mb_count);
+    if (NULL == p->prev || NULL == p->cnt) {
+        mpp_err_f("failed to malloc macroblock buffer\n");
+        MPP_FREE(p->prev);
+        MPP_FREE(p->cnt);
+        mpp_free(p);
+        return MPP_ERR_MALLOC;
+    }
+
+    *ctx = p;
+    return MPP_OK;
+}
+
+MPP_RET mpp_enc_roi_motion_deinit(MppEncRoiMotion ctx)
+{
+    MppEncRoiMotionImpl *p = (MppEncRoiMotionImpl *)ctx;
+
+    if (NULL == p)
+        return MPP_OK;
+
+    MPP_FREE(p->prev);
+    MPP_FREE(p->cnt);
+    mpp_free(p);
+    return MPP_OK;
+}
+
+MPP_RET mpp_enc_roi_motion_proc(MppEncRoiMotion ctx, RK_U8 *luma, RK_S8 *qp_map)
+{
+    MppEncRoiMotionImpl *p = (MppEncRoiMotionImpl *)ctx;
+    RK_S32 mb_w, mb_h;
+    RK_S32 sad_thr;
+    RK_S32 x, y, i;
+
+    if (NULL == p || NULL == luma || NULL == qp_map) {
+        mpp_err_f("found NULL input ctx %p luma %p qp_map %p\n", p, luma, qp_map);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mb_w = p->mb_w;
+    mb_h = p->mb_h;
+    sad_thr = p->cfg.threshold * ROI_MB_PIXELS;
+
+    for (y = 0; y < mb_h; y++) {
+        for (x = 0; x < mb_w; x++) {
+            RK_S32 idx = y * mb_w + x;
+            RK_U8 *prev = p->prev + idx * ROI_MB_PIXELS;
+            RK_U8 cur[ROI_MB_PIXELS];
+            RK_S32 sad = 0;
+
+            roi_mb_scale(p, luma, x, y, cur);
+
+            for (i = 0; i < ROI_MB_PIXELS; i++)
+                sad += MPP_ABS(cur[i] - prev[i]);
+
+            if (p->has_prev && sad >= sad_thr)
+                p->cnt[idx] = (RK_U8)p->cfg.hold;
+            else if (p->cnt[idx])
+                p->cnt[idx]--;
+
+            memcpy(prev, cur, ROI_MB_PIXELS);
+        }
+    }
+    p->has_prev = 1;
+
+    /* active macroblock extends to its neighbours to cover object edges */
+    for (y = 0; y < mb_h; y++) {
+        RK_S32 y0 = MPP_MAX(y - 1, 0);
+        RK_S32 y1 = MPP_MIN(y + 1, mb_h - 1);
+
+        for (x = 0; x < mb_w; x++) {
+            RK_S32 x0 = MPP_MAX(x - 1, 0);
+            RK_S32 x1 = MPP_MIN(x + 1, mb_w - 1);
+            RK_S32 active = 0;
+            RK_S32 j, k;
+
+            for (j = y0; j <= y1 && !active; j++)
+                for (k = x0; k <= x1; k++)
+                    active |= p->cnt[j * mb_w + k];
+
+            qp_map[y * mb_w + x] = (RK_S8)((active) ? p->cfg.fg_qp_delta : p->cfg.bg_qp_delta);
+        }
+    }
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_enc_roi_mask_to_map(RK_U8 *mask, RK_S32 width, RK_S32 height, RK_S32 stride,
+                                RK_S32 fg_qp_delta, RK_S32 bg_qp_delta, RK_S8 *qp_map)
+{
+    RK_S32 mb_w = (width + 15) / 16;
+    RK_S32 mb_h = (height + 15) / 16;
+    RK_S32 mb_x, mb_y, x, y;
+
+    if (NULL == mask || NULL == qp_map) {
+        mpp_err_f("found NULL input mask %p qp_map %p\n", mask, qp_map);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    for (mb_y = 0; mb_y < mb_h; mb_y++) {
+        RK_S32 h = MPP_MIN(ROI_MB_SIZE, height - mb_y * ROI_MB_SIZE);
+
+        for (mb_x = 0; mb_x < mb_w; mb_x++) {
+            RK_S32 w = MPP_MIN(ROI_MB_SIZE, width - mb_x * ROI_MB_SIZE);
+            RK_U8 *src = mask + mb_y * ROI_MB_SIZE * stride + mb_x * ROI_MB_SIZE;
+            RK_S32 count = 0;
+
+            for (y = 0; y < h; y++)
+                for (x = 0; x < w; x++)
+                    count += (src[y * stride + x] != 0);
+
+            qp_map[mb_y * mb_w + mb_x] = (RK_S8)((count * 4 >= w * h) ? fg_qp_delta : bg_qp_delta);
+        }
+    }
+
+    return MPP_OK;
+}
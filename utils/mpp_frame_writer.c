@@ -0,0 +1,653 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_frame_writer"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+
+#include "mpp_frame_writer.h"
+
+#if _WIN32
+#include <sys/types.h>
+#else
+#include <limits.h>
+#include <sys/uio.h>
+#endif
+
+#ifndef IOV_MAX
+#define IOV_MAX                 1024
+#endif
+
+#define WRITER_MAX_PLANE        3
+#define WRITER_DEFAULT_DEPTH    4
+
+typedef struct WriterPlane_t {
+    RK_U8               *ptr;
+    RK_U32              row;
+    RK_U32              stride;
+    RK_U32              rows;
+} WriterPlane;
+
+typedef struct WriterItem_t {
+    MppBuffer           buffer;
+    RK_U8               *base;
+    RK_U32              width;
+    RK_U32              height;
+    RK_U32              h_stride;
+    RK_U32              v_stride;
+    MppFrameFormat      fmt;
+} WriterItem;
+
+typedef struct WriterMd5_t {
+    RK_U32              state[4];
+    RK_U64              size;
+    RK_U8               block[64];
+} WriterMd5;
+
+typedef struct MppFrameWriterImpl_t {
+    MppFrameWriterCfg   cfg;
+    RK_U32              crc_table[256];
+#if !_WIN32
+    struct iovec        iov[IOV_MAX];
+#endif
+
+    MppFrameWriterStat  stat;
+
+    /* async queue */
+    pthread_t           thd;
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    WriterItem          *items;
+    RK_U32              rd;
+    RK_U32              count;
+    RK_U32              stop;
+} MppFrameWriterImpl;
+
+/* rfc 1321 */
+static const RK_U32 md5_k[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+static const RK_U8 md5_r[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+static void md5_init(WriterMd5 *md5)
+{
+    md5->state[0] = 0x67452301;
+    md5->state[1] = 0xefcdab89;
+    md5->state[2] = 0x98badcfe;
+    md5->state[3] = 0x10325476;
+    md5->size = 0;
+}
+
+static void md5_block(WriterMd5 *md5, const RK_U8 *p)
+{
+    RK_U32 a = md5->state[0];
+    RK_U32 b = md5->state[1];
+    RK_U32 c = md5->state[2];
+    RK_U32 d = md5->state[3];
+    RK_U32 w[16];
+    RK_U32 i;
+
+    for (i = 0; i < 16; i++)
+        w[i] = p[i * 4] | (p[i * 4 + 1] << 8) | (p[i * 4 + 2] << 16) | ((RK_U32)p[i * 4 + 3] << 24);
+
+    for (i = 0; i < 64; i++) {
+        RK_U32 f, g, t;
+
+        if (i < 16) {
+            f = (b & c) | (~b & d);
+            g = i;
+        } else if (i < 32) {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) & 15;
+        } else if (i < 48) {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) & 15;
+        } else {
+            f = c ^ (b | ~d);
+            g = (7 * i) & 15;
+        }
+
+        t = d;
+        d = c;
+        c = b;
+        f += a + md5_k[i] + w[g];
+        b += (f << md5_r[i]) | (f >> (32 - md5_r[i]));
+        a = t;
+    }
+
+    md5->state[0] += a;
+    md5->state[1] += b;
+    md5->state[2] += c;
+    md5->state[3] += d;
+}
+
+static void md5_update(WriterMd5 *md5, const RK_U8 *data, RK_U32 size)
+{
+    RK_U32 used = (RK_U32)(md5->size & 63);
+
+    md5->size += size;
+
+    if (used) {
+        RK_U32 fill = MPP_MIN(64 - used, size);
+
+        memcpy(md5->block + used, data, fill);
+        data += fill;
+        size -= fill;
+        if (used + fill < 64)
+            return;
+        md5_block(md5, md5->block);
+    }
+
+    for (; size >= 64; size -= 64, data += 64)
+        md5_block(md5, data);
+
+    memcpy(md5->block, data, size);
+}
+
+static void md5_final(WriterMd5 *md5, RK_U8 *digest)
+{
+    RK_U64 bits = md5->size * 8;
+    RK_U32 used = (RK_U32)(md5->size & 63);
+    RK_U32 i;
+
+    md5->block[used++] = 0x80;
+    if (used > 56) {
+        memset(md5->block + used, 0, 64 - used);
+        md5_block(md5, md5->block);
+        used = 0;
+    }
+    memset(md5->block + used, 0, 56 - used);
+    for (i = 0; i < 8; i++)
+        md5->block[56 + i] = (RK_U8)(bits >> (i * 8));
+    md5_block(md5, md5->block);
+
+    for (i = 0; i < 16; i++)
+        digest[i] = (RK_U8)(md5->state[i / 4] >> ((i % 4) * 8));
+}
+
+static void crc32_init_table(RK_U32 *table)
+{
+    RK_U32 i, j;
+
+    for (i = 0; i < 256; i++) {
+        RK_U32 c = i;
+
+        for (j = 0; j < 8; j++)
+            c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+        table[i] = c;
+    }
+}
+
+static RK_U32 crc32_update(const RK_U32 *table, RK_U32 crc, const RK_U8 *data, RK_U32 size)
+{
+    RK_U32 i;
+
+    for (i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+    return crc;
+}
+
+/* bytes per pixel of packed formats, 0 for planar ones */
+static RK_U32 writer_get_bpp(MppFrameFormat fmt)
+{
+    switch (fmt) {
+    case MPP_FMT_YUV422_YUYV :
+    case MPP_FMT_YUV422_UYVY :
+    case MPP_FMT_RGB565 :
+    case MPP_FMT_BGR565 :
+    case MPP_FMT_RGB555 :
+    case MPP_FMT_BGR555 :
+    case MPP_FMT_RGB444 :
+    case MPP_FMT_BGR444 : {
+        return 2;
+    } break;
+    case MPP_FMT_RGB888 :
+    case MPP_FMT_BGR888 : {
+        return 3;
+    } break;
+    case MPP_FMT_RGB101010 :
+    case MPP_FMT_BGR101010 :
+    case MPP_FMT_ARGB8888 :
+    case MPP_FMT_ABGR8888 : {
+        return 4;
+    } break;
+    default : {
+    } break;
+    }
+
+    return 0;
+}
+
+static RK_S32 writer_get_planes(WriterItem *item, WriterPlane *planes)
+{
+    RK_U32 width = item->width;
+    RK_U32 height = item->height;
+    RK_U32 stride = item->h_stride;
+    RK_U8 *base_c = item->base + item->h_stride * item->v_stride;
+    RK_U32 bpp = writer_get_bpp(item->fmt);
+    RK_U32 row = width;
+
+    if (bpp) {
+        row = width * bpp;
+        planes[0].ptr = item->base;
+        planes[0].row = row;
+        planes[0].stride = (stride >= row) ? stride : stride * bpp;
+        planes[0].rows = height;
+        return 1;
+    }
+
+    switch (item->fmt) {
+    case MPP_FMT_YUV420SP_10BIT :
+    case MPP_FMT_YUV422SP_10BIT : {
+        row = (width * 10 + 7) / 8;
+    } break;
+    case MPP_FMT_YUV420P : {
+        RK_U32 c_stride = stride / 2;
+        RK_U32 c_rows = (height + 1) / 2;
+
+        planes[1].ptr = base_c;
+        planes[2].ptr = base_c + c_stride * (item->v_stride / 2);
+        planes[1].row = planes[2].row = (width + 1) / 2;
+        planes[1].stride = planes[2].stride = c_stride;
+        planes[1].rows = planes[2].rows = c_rows;
+    } break;
+    case MPP_FMT_YUV422P : {
+        RK_U32 c_stride = stride / 2;
+
+        planes[1].ptr = base_c;
+        planes[2].ptr = base_c + c_stride * item->v_stride;
+        planes[1].row = planes[2].row = (width + 1) / 2;
+        planes[1].stride = planes[2].stride = c_stride;
+        planes[1].rows = planes[2].rows = height;
+    } break;
+    case MPP_FMT_YUV420SP :
+    case MPP_FMT_YUV420SP_VU :
+    case MPP_FMT_YUV422SP :
+    case MPP_FMT_YUV422SP_VU : {
+    } break;
+    default : {
+        mpp_err("not supported format %d\n", item->fmt);
+        return -1;
+    } break;
+    }
+
+    planes[0].ptr = item->base;
+    planes[0].row = row;
+    planes[0].stride = stride;
+    planes[0].rows = height;
+
+    if (item->fmt == MPP_FMT_YUV420P || item->fmt == MPP_FMT_YUV422P)
+        return 3;
+
+    planes[1].ptr = base_c;
+    planes[1].row = row;
+    planes[1].stride = stride;
+    planes[1].rows = (item->fmt == MPP_FMT_YUV420SP || item->fmt == MPP_FMT_YUV420SP_VU ||
+                      item->fmt == MPP_FMT_YUV420SP_10BIT) ? (height + 1) / 2 : height;
+    return 2;
+}
+
+#if !_WIN32
+static MPP_RET writer_writev(int fd, struct iovec *iov, RK_S32 count)
+{
+    while (count > 0) {
+        ssize_t len = writev(fd, iov, count);
+
+        if (len < 0) {
+            mpp_err_f("writev failed\n");
+            return MPP_NOK;
+        }
+
+        // skip the written regions and retry the rest
+        while (count > 0 && (size_t)len >= iov->iov_len) {
+            len -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (RK_U8 *)iov->iov_base + len;
+            iov->iov_len -= len;
+        }
+    }
+
+    return MPP_OK;
+}
+#endif
+
+static MPP_RET writer_write_raw(MppFrameWriterImpl *p, WriterPlane *planes, RK_S32 count)
+{
+    FILE *fp = p->cfg.fp;
+    RK_S32 i;
+#if _WIN32
+    for (i = 0; i < count; i++) {
+        WriterPlane *plane = &planes[i];
+        RK_U32 j;
+
+        if (plane->row == plane->stride) {
+            fwrite(plane->ptr, 1, plane->row * plane->rows, fp);
+            continue;
+        }
+        for (j = 0; j < plane->rows; j++)
+            fwrite(plane->ptr + j * plane->stride, 1, plane->row, fp);
+    }
+    return MPP_OK;
+#else
+    int fd = fileno(fp);
+    RK_S32 n = 0;
+
+    // stdio buffer of the caller goes first
+    fflush(fp);
+
+    for (i = 0; i < count; i++) {
+        WriterPlane *plane = &planes[i];
+        RK_U32 rows = (plane->row == plane->stride) ? 1 : plane->rows;
+        RK_U32 len = (plane->row == plane->stride) ? plane->row * plane->rows : plane->row;
+        RK_U32 j;
+
+        for (j = 0; j < rows; j++) {
+            p->iov[n].iov_base = plane->ptr + j * plane->stride;
+            p->iov[n].iov_len = len;
+            if (++n == IOV_MAX) {
+                if (writer_writev(fd, p->iov, n))
+                    return MPP_NOK;
+                n = 0;
+            }
+        }
+    }
+
+    return (n) ? writer_writev(fd, p->iov, n) : MPP_OK;
+#endif
+}
+
+static void writer_checksum(MppFrameWriterImpl *p, WriterPlane *planes, RK_S32 count)
+{
+    WriterMd5 md5;
+    RK_U32 crc = 0xffffffff;
+    RK_S32 i;
+
+    if (p->cfg.mode == MPP_FRAME_WRITER_MD5)
+        md5_init(&md5);
+
+    for (i = 0; i < count; i++) {
+        WriterPlane *plane = &planes[i];
+        RK_U32 rows = (plane->row == plane->stride) ? 1 : plane->rows;
+        RK_U32 len = (plane->row == plane->stride) ? plane->row * plane->rows : plane->row;
+        RK_U32 j;
+
+        for (j = 0; j < rows; j++) {
+            RK_U8 *ptr = plane->ptr + j * plane->stride;
+
+            if (p->cfg.mode == MPP_FRAME_WRITER_MD5)
+                md5_update(&md5, ptr, len);
+            else
+                crc = crc32_update(p->crc_table, crc, ptr, len);
+        }
+    }
+
+    if (NULL == p->cfg.fp)
+        return;
+
+    if (p->cfg.mode == MPP_FRAME_WRITER_MD5) {
+        RK_U8 digest[16];
+
+        md5_final(&md5, digest);
+        for (i = 0; i < 16; i++)
+            fprintf(p->cfg.fp, "%02x", digest[i]);
+        fprintf(p->cfg.fp, "\n");
+    } else {
+        fprintf(p->cfg.fp, "%08x\n", crc ^ 0xffffffff);
+    }
+}
+
+static MPP_RET writer_proc(MppFrameWriterImpl *p, WriterItem *item)
+{
+    WriterPlane planes[WRITER_MAX_PLANE];
+    RK_S64 start = mpp_time_us();
+    RK_S32 count = writer_get_planes(item, planes);
+    MPP_RET ret = MPP_OK;
+    RK_U64 bytes = 0;
+    RK_S32 i;
+
+    if (count < 0)
+        return MPP_NOK;
+
+    for (i = 0; i < count; i++)
+        bytes += (RK_U64)planes[i].row * planes[i].rows;
+
+    if (p->cfg.mode == MPP_FRAME_WRITER_RAW)
+        ret = writer_write_raw(p, planes, count);
+    else
+        writer_checksum(p, planes, count);
+
+    p->stat.frames++;
+    p->stat.bytes += bytes;
+    p->stat.time += mpp_time_us() - start;
+
+    return ret;
+}
+
+static MPP_RET writer_get_item(MppFrame frame, WriterItem *item)
+{
+    MppBuffer buffer = mpp_frame_get_buffer(frame);
+
+    if (NULL == buffer)
+        return MPP_NOK;
+
+    item->buffer   = buffer;
+    item->base     = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+    item->width    = mpp_frame_get_width(frame);
+    item->height   = mpp_frame_get_height(frame);
+    item->h_stride = mpp_frame_get_hor_stride(frame);
+    item->v_stride = mpp_frame_get_ver_stride(frame);
+    item->fmt      = mpp_frame_get_fmt(frame);
+
+    return (item->base) ? MPP_OK : MPP_NOK;
+}
+
+static void *writer_thread(void *arg)
+{
+    MppFrameWriterImpl *p = (MppFrameWriterImpl *)arg;
+    RK_U32 depth = p->cfg.queue_depth;
+
+    pthread_mutex_lock(&p->lock);
+    while (1) {
+        WriterItem *item = NULL;
+
+        while (!p->count && !p->stop)
+            pthread_cond_wait(&p->cond, &p->lock);
+
+        if (!p->count)
+            break;
+
+        // the queue slot stays taken until the buffer is released
+        item = &p->items[p->rd];
+        pthread_mutex_unlock(&p->lock);
+
+        writer_proc(p, item);
+        mpp_buffer_put(item->buffer);
+
+        pthread_mutex_lock(&p->lock);
+        p->rd = (p->rd + 1) % depth;
+        p->count--;
+        pthread_cond_broadcast(&p->cond);
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    return NULL;
+}
+
+MPP_RET mpp_frame_writer_init(MppFrameWriter *writer, MppFrameWriterCfg *cfg)
+{
+    MppFrameWriterImpl *p = NULL;
+
+    if (NULL == writer || NULL == cfg || cfg->mode >= MPP_FRAME_WRITER_BUTT ||
+        (cfg->mode == MPP_FRAME_WRITER_RAW && NULL == cfg->fp)) {
+        mpp_err_f("invalid input writer %p cfg %p\n", writer, cfg);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *writer = NULL;
+
+    p = mpp_calloc(MppFrameWriterImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("malloc context failed\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->cfg = *cfg;
+    if (!p->cfg.queue_depth)
+        p->cfg.queue_depth = WRITER_DEFAULT_DEPTH;
+    if (p->cfg.mode == MPP_FRAME_WRITER_CRC32)
+        crc32_init_table(p->crc_table);
+
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+
+    if (p->cfg.async) {
+        p->items = mpp_calloc(WriterItem, p->cfg.queue_depth);
+        if (NULL == p->items || pthread_create(&p->thd, NULL, writer_thread, p)) {
+            mpp_err_f("failed to setup writer thread\n");
+            MPP_FREE(p->items);
+            pthread_cond_destroy(&p->cond);
+            pthread_mutex_destroy(&p->lock);
+            mpp_free(p);
+            return MPP_NOK;
+        }
+    }
+
+    *writer = p;
+    return MPP_OK;
+}
+
+MPP_RET mpp_frame_writer_deinit(MppFrameWriter writer)
+{
+    MppFrameWriterImpl *p = (MppFrameWriterImpl *)writer;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (p->cfg.async) {
+        pthread_mutex_lock(&p->lock);
+        p->stop = 1;
+        pthread_cond_broadcast(&p->cond);
+        pthread_mutex_unlock(&p->lock);
+        pthread_join(p->thd, NULL);
+    }
+
+    if (p->cfg.fp)
+        fflush(p->cfg.fp);
+
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+    MPP_FREE(p->items);
+    mpp_free(p);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_frame_writer_put(MppFrameWriter writer, MppFrame frame)
+{
+    MppFrameWriterImpl *p = (MppFrameWriterImpl *)writer;
+    WriterItem item;
+    RK_U32 depth;
+
+    if (NULL == p || NULL == frame) {
+        mpp_err_f("invalid input writer %p frame %p\n", writer, frame);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (writer_get_item(frame, &item))
+        return MPP_OK;
+
+    if (!p->cfg.async)
+        return writer_proc(p, &item);
+
+    depth = p->cfg.queue_depth;
+    mpp_buffer_inc_ref(item.buffer);
+
+    pthread_mutex_lock(&p->lock);
+    while (p->count == depth)
+        pthread_cond_wait(&p->cond, &p->lock);
+
+    p->items[(p->rd + p->count) % depth] = item;
+    p->count++;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_frame_writer_get_stat(MppFrameWriter writer, MppFrameWriterStat *stat)
+{
+    MppFrameWriterImpl *p = (MppFrameWriterImpl *)writer;
+
+    if (NULL == p || NULL == stat) {
+        mpp_err_f("invalid input writer %p stat %p\n", writer, stat);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    // wait for the pending frames
+    pthread_mutex_lock(&p->lock);
+    while (p->count)
+        pthread_cond_wait(&p->cond, &p->lock);
+    *stat = p->stat;
+    pthread_mutex_unlock(&p->lock);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_frame_writer_dump(MppFrame frame, FILE *fp)
+{
+    MppFrameWriterImpl *p = NULL;
+    WriterItem item;
+    MPP_RET ret;
+
+    if (NULL == fp || NULL == frame || writer_get_item(frame, &item))
+        return MPP_NOK;
+
+    // iovec array is too large for stack
+    p = mpp_calloc(MppFrameWriterImpl, 1);
+    if (NULL == p)
+        return MPP_ERR_MALLOC;
+
+    p->cfg.fp = fp;
+    ret = writer_proc(p, &item);
+    mpp_free(p);
+
+    return ret;
+}
@@ -0,0 +1,691 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_stream_reader"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+
+#include "mpp_stream_reader.h"
+
+#if _WIN32
+#include <sys/types.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define READER_DEFAULT_CHUNK    (SZ_64K)
+#define READER_FRAME_STEP       256
+#define READER_IVF_HDR_SIZE     32
+#define READER_IVF_FRM_SIZE     12
+
+typedef enum ReaderUnit_e {
+    /* no effect on the frame boundary */
+    READER_UNIT_NONE,
+    /* header starting a new frame after picture data */
+    READER_UNIT_HEAD,
+    /* first unit of a picture */
+    READER_UNIT_PIC,
+    /* picture data continuing the current picture */
+    READER_UNIT_DATA,
+    /* goes with the unit after it */
+    READER_UNIT_PREFIX,
+} ReaderUnit;
+
+typedef struct ReaderFrame_t {
+    size_t              offset;
+    size_t              size;
+    RK_S64              pts;
+} ReaderFrame;
+
+typedef struct MppStreamReaderImpl_t {
+    MppStreamReaderCfg  cfg;
+    RK_U8               *data;
+    size_t              size;
+    RK_U32              mapped;
+
+    /* chunk and random mode position */
+    size_t              pos;
+    RK_U32              rand;
+
+    /* frame index filled by the scan thread */
+    pthread_t           thd;
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    ReaderFrame         *frames;
+    RK_U32              frame_max;
+    RK_U32              frame_cnt;
+    RK_U32              frame_idx;
+    RK_U32              scan_run;
+    RK_U32              scan_done;
+    RK_U32              scan_stop;
+
+    MppStreamReaderStat stat;
+} MppStreamReaderImpl;
+
+static MPP_RET reader_map(MppStreamReaderImpl *p, const char *path)
+{
+#if _WIN32
+    FILE *fp = fopen(path, "rb");
+    long size;
+
+    if (NULL == fp) {
+        mpp_err_f("failed to open %s\n", path);
+        return MPP_ERR_OPEN_FILE;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (size > 0) {
+        p->data = mpp_malloc(RK_U8, size);
+        if (NULL == p->data || fread(p->data, 1, size, fp) != (size_t)size) {
+            mpp_err_f("failed to read %s size %ld\n", path, size);
+            fclose(fp);
+            return MPP_NOK;
+        }
+        p->size = size;
+    }
+    fclose(fp);
+#else
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        mpp_err_f("failed to open %s\n", path);
+        return MPP_ERR_OPEN_FILE;
+    }
+
+    if (fstat(fd, &st)) {
+        mpp_err_f("failed to stat %s\n", path);
+        close(fd);
+        return MPP_NOK;
+    }
+
+    if (st.st_size > 0) {
+        /*
+         * private writable mapping so that a parser patching the stream in
+         * place gets copy on write pages instead of a fault
+         */
+        void *ptr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+        if (ptr == MAP_FAILED) {
+            mpp_err_f("failed to map %s size %lld\n", path, (long long)st.st_size);
+            close(fd);
+            return MPP_NOK;
+        }
+        madvise(ptr, st.st_size, MADV_SEQUENTIAL);
+
+        p->data = (RK_U8 *)ptr;
+        p->size = st.st_size;
+        p->mapped = 1;
+    }
+    close(fd);
+#endif
+    return MPP_OK;
+}
+
+static void reader_unmap(MppStreamReaderImpl *p)
+{
+#if !_WIN32
+    if (p->mapped) {
+        munmap(p->data, p->size);
+        p->data = NULL;
+    }
+#endif
+    MPP_FREE(p->data);
+}
+
+static RK_U32 reader_rand(MppStreamReaderImpl *p)
+{
+    /* xorshift32 */
+    RK_U32 x = p->rand;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    p->rand = x;
+
+    return x;
+}
+
+/* returns MPP_NOK when the scan has to stop */
+static MPP_RET reader_add_frame(MppStreamReaderImpl *p, size_t offset,
+                                size_t size, RK_S64 pts)
+{
+    MPP_RET ret = MPP_OK;
+
+    if (!size)
+        return MPP_OK;
+
+    pthread_mutex_lock(&p->lock);
+
+    if (p->scan_stop) {
+        ret = MPP_NOK;
+        goto __RETURN;
+    }
+
+    if (p->frame_cnt >= p->frame_max) {
+        RK_U32 max = p->frame_max + READER_FRAME_STEP;
+        ReaderFrame *frames = mpp_realloc(p->frames, ReaderFrame, max);
+
+        if (NULL == frames) {
+            mpp_err_f("failed to grow frame index to %d\n", max);
+            ret = MPP_ERR_MALLOC;
+            goto __RETURN;
+        }
+        p->frames = frames;
+        p->frame_max = max;
+    }
+
+    p->frames[p->frame_cnt].offset = offset;
+    p->frames[p->frame_cnt].size = size;
+    p->frames[p->frame_cnt].pts = pts;
+    p->frame_cnt++;
+    pthread_cond_broadcast(&p->cond);
+
+__RETURN:
+    pthread_mutex_unlock(&p->lock);
+    return ret;
+}
+
+/* offset of the next 00 00 01 at or after pos, size when there is none */
+static size_t reader_find_start_code(const RK_U8 *data, size_t size, size_t pos)
+{
+    while (pos + 3 <= size) {
+        const RK_U8 *one = (const RK_U8 *)memchr(data + pos + 2, 1, size - pos - 2);
+        size_t at;
+
+        if (NULL == one)
+            break;
+
+        at = one - data;
+        if (!data[at - 1] && !data[at - 2])
+            return at - 2;
+
+        pos = at - 1;
+    }
+
+    return size;
+}
+
+static ReaderUnit reader_classify(MppCodingType coding, const RK_U8 *p, size_t left)
+{
+    RK_U32 type;
+
+    if (left < 3)
+        return READER_UNIT_NONE;
+
+    switch (coding) {
+    case MPP_VIDEO_CodingAVC : {
+        type = p[0] & 0x1f;
+        /* first_mb_in_slice 0 is the ue(v) code 1 */
+        if (type == 1 || type == 2 || type == 5)
+            return (p[1] & 0x80) ? READER_UNIT_PIC : READER_UNIT_DATA;
+        if (type == 3 || type == 4 || type == 20)
+            return READER_UNIT_DATA;
+        if ((type >= 6 && type <= 9) || (type >= 15 && type <= 18))
+            return READER_UNIT_HEAD;
+        if (type == 14)
+            return READER_UNIT_PREFIX;
+    } break;
+    case MPP_VIDEO_CodingHEVC : {
+        type = (p[0] >> 1) & 0x3f;
+        /* first_slice_segment_in_pic_flag */
+        if (type < 32)
+            return (p[2] & 0x80) ? READER_UNIT_PIC : READER_UNIT_DATA;
+        if (type <= 35 || type == 39 || (type >= 41 && type <= 44) ||
+            (type >= 48 && type <= 55))
+            return READER_UNIT_HEAD;
+    } break;
+    case MPP_VIDEO_CodingMPEG2 : {
+        type = p[0];
+        if (type == 0x00)
+            return READER_UNIT_PIC;
+        if (type <= 0xaf)
+            return READER_UNIT_DATA;
+        /* sequence header and gop */
+        if (type == 0xb3 || type == 0xb8)
+            return READER_UNIT_HEAD;
+    } break;
+    case MPP_VIDEO_CodingMPEG4 : {
+        type = p[0];
+        if (type == 0xb6)
+            return READER_UNIT_PIC;
+        /* vo, vol, vos, gov and visual object */
+        if (type <= 0x2f || type == 0xb0 || type == 0xb3 || type == 0xb5)
+            return READER_UNIT_HEAD;
+    } break;
+    case MPP_VIDEO_CodingAVS : {
+        type = p[0];
+        /* i picture and pb picture */
+        if (type == 0xb3 || type == 0xb6)
+            return READER_UNIT_PIC;
+        if (type <= 0xaf)
+            return READER_UNIT_DATA;
+        if (type == 0xb0)
+            return READER_UNIT_HEAD;
+    } break;
+    default : {
+    } break;
+    }
+
+    return READER_UNIT_NONE;
+}
+
+static void reader_scan_start_code(MppStreamReaderImpl *p)
+{
+    const RK_U8 *data = p->data;
+    size_t size = p->size;
+    size_t frame = 0;
+    size_t pos = 0;
+    size_t prefix = 0;
+    RK_U32 has_pic = 0;
+
+    while (1) {
+        size_t sc = reader_find_start_code(data, size, pos);
+        size_t begin = sc;
+        ReaderUnit unit;
+
+        if (sc >= size)
+            break;
+
+        /* leading zero bytes go with the next frame */
+        while (begin > pos && !data[begin - 1])
+            begin--;
+
+        pos = sc + 3;
+
+        unit = reader_classify(p->cfg.coding, data + sc + 3, size - sc - 3);
+        if (unit == READER_UNIT_PREFIX) {
+            if (!prefix)
+                prefix = begin;
+            continue;
+        }
+
+        if (prefix) {
+            begin = prefix;
+            prefix = 0;
+        }
+
+        if (has_pic && (unit == READER_UNIT_HEAD || unit == READER_UNIT_PIC)) {
+            if (reader_add_frame(p, frame, begin - frame, 0))
+                return;
+
+            frame = begin;
+            has_pic = 0;
+        }
+
+        if (unit == READER_UNIT_PIC || unit == READER_UNIT_DATA)
+            has_pic = 1;
+    }
+
+    reader_add_frame(p, frame, size - frame, 0);
+}
+
+/* each byte aligned 22 bit picture start code begins a frame */
+static void reader_scan_h263(MppStreamReaderImpl *p)
+{
+    const RK_U8 *data = p->data;
+    size_t size = p->size;
+    size_t frame = 0;
+    size_t pos = 0;
+
+    while (pos + 3 <= size) {
+        const RK_U8 *zero = (const RK_U8 *)memchr(data + pos, 0, size - pos - 2);
+        size_t at;
+
+        if (NULL == zero)
+            break;
+
+        at = zero - data;
+        if (!data[at + 1] && (data[at + 2] & 0xfc) == 0x80) {
+            if (at > frame && reader_add_frame(p, frame, at - frame, 0))
+                return;
+
+            frame = at;
+            pos = at + 3;
+        } else {
+            pos = at + 1;
+        }
+    }
+
+    reader_add_frame(p, frame, size - frame, 0);
+}
+
+static void reader_scan_ivf(MppStreamReaderImpl *p)
+{
+    const RK_U8 *data = p->data;
+    size_t size = p->size;
+    size_t pos = data[6] | (data[7] << 8);
+
+    while (pos + READER_IVF_FRM_SIZE <= size) {
+        const RK_U8 *hdr = data + pos;
+        size_t len = hdr[0] | (hdr[1] << 8) | (hdr[2] << 16) | ((RK_U32)hdr[3] << 24);
+        RK_S64 pts = 0;
+        RK_S32 i;
+
+        for (i = 7; i >= 0; i--)
+            pts = (pts << 8) | hdr[4 + i];
+
+        pos += READER_IVF_FRM_SIZE;
+        if (len > size - pos) {
+            mpp_err_f("ivf frame at %lld truncated\n", (long long)pos);
+            len = size - pos;
+        }
+
+        if (reader_add_frame(p, pos, len, pts))
+            return;
+
+        pos += len;
+    }
+}
+
+/* split at each SOI after an EOI so that exif thumbnails stay in their frame */
+static void reader_scan_mjpeg(MppStreamReaderImpl *p)
+{
+    const RK_U8 *data = p->data;
+    size_t size = p->size;
+    size_t frame = 0;
+    size_t pos = 0;
+    RK_U32 eoi = 0;
+
+    while (pos + 2 <= size) {
+        const RK_U8 *ff = (const RK_U8 *)memchr(data + pos, 0xff, size - pos - 1);
+        size_t at;
+
+        if (NULL == ff)
+            break;
+
+        at = ff - data;
+        if (data[at + 1] == 0xd8 && eoi) {
+            if (reader_add_frame(p, frame, at - frame, 0))
+                return;
+
+            frame = at;
+            eoi = 0;
+        } else if (data[at + 1] == 0xd9) {
+            eoi = 1;
+        }
+        pos = at + 2;
+    }
+
+    reader_add_frame(p, frame, size - frame, 0);
+}
+
+static void *reader_scan_thread(void *arg)
+{
+    MppStreamReaderImpl *p = (MppStreamReaderImpl *)arg;
+    RK_S64 start = mpp_time_us();
+
+    switch (p->cfg.coding) {
+    case MPP_VIDEO_CodingH263 : {
+        reader_scan_h263(p);
+    } break;
+    case MPP_VIDEO_CodingVP8 :
+    case MPP_VIDEO_CodingVP9 : {
+        reader_scan_ivf(p);
+    } break;
+    case MPP_VIDEO_CodingMJPEG : {
+        reader_scan_mjpeg(p);
+    } break;
+    default : {
+        reader_scan_start_code(p);
+    } break;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    p->scan_done = 1;
+    p->stat.index_time = mpp_time_us() - start;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+
+    return NULL;
+}
+
+static RK_U32 reader_frame_support(MppStreamReaderImpl *p)
+{
+    switch (p->cfg.coding) {
+    case MPP_VIDEO_CodingAVC :
+    case MPP_VIDEO_CodingHEVC :
+    case MPP_VIDEO_CodingMPEG2 :
+    case MPP_VIDEO_CodingMPEG4 :
+    case MPP_VIDEO_CodingAVS :
+    case MPP_VIDEO_CodingH263 :
+    case MPP_VIDEO_CodingMJPEG : {
+        return 1;
+    } break;
+    case MPP_VIDEO_CodingVP8 :
+    case MPP_VIDEO_CodingVP9 : {
+        if (p->size >= READER_IVF_HDR_SIZE && !memcmp(p->data, "DKIF", 4))
+            return 1;
+
+        mpp_log_f("vp8 / vp9 frame mode needs an ivf file\n");
+    } break;
+    default : {
+    } break;
+    }
+
+    return 0;
+}
+
+MPP_RET mpp_stream_reader_init(MppStreamReader *reader, const char *path,
+                               MppStreamReaderCfg *cfg)
+{
+    MppStreamReaderImpl *p = NULL;
+    MPP_RET ret = MPP_NOK;
+
+    if (NULL == reader || NULL == path || NULL == cfg ||
+        cfg->mode >= MPP_STREAM_READER_BUTT) {
+        mpp_err_f("invalid input reader %p path %p cfg %p\n", reader, path, cfg);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *reader = NULL;
+
+    p = mpp_calloc(MppStreamReaderImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->cfg = *cfg;
+    if (!p->cfg.chunk_size)
+        p->cfg.chunk_size = READER_DEFAULT_CHUNK;
+
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+
+    ret = reader_map(p, path);
+    if (ret)
+        goto __RETURN;
+
+    p->stat.size = p->size;
+
+    if (p->cfg.mode == MPP_STREAM_READER_FRAME && !reader_frame_support(p)) {
+        mpp_log_f("no frame index for coding %x use %d byte chunks\n",
+                  p->cfg.coding, p->cfg.chunk_size);
+        p->cfg.mode = MPP_STREAM_READER_CHUNK;
+    }
+
+    mpp_stream_reader_rewind(p);
+
+    if (p->cfg.mode == MPP_STREAM_READER_FRAME) {
+        if (pthread_create(&p->thd, NULL, reader_scan_thread, p)) {
+            mpp_err_f("failed to create scan thread\n");
+            ret = MPP_NOK;
+            goto __RETURN;
+        }
+        p->scan_run = 1;
+    }
+
+    *reader = p;
+    return MPP_OK;
+
+__RETURN:
+    mpp_stream_reader_deinit(p);
+    return ret;
+}
+
+MPP_RET mpp_stream_reader_deinit(MppStreamReader reader)
+{
+    MppStreamReaderImpl *p = (MppStreamReaderImpl *)reader;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (p->scan_run) {
+        pthread_mutex_lock(&p->lock);
+        p->scan_stop = 1;
+        pthread_mutex_unlock(&p->lock);
+
+        pthread_join(p->thd, NULL);
+        p->scan_run = 0;
+    }
+
+    reader_unmap(p);
+    MPP_FREE(p->frames);
+
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+    mpp_free(p);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_stream_reader_get_packet(MppStreamReader reader, MppPacket *packet)
+{
+    MppStreamReaderImpl *p = (MppStreamReaderImpl *)reader;
+    size_t offset = 0;
+    size_t size = 0;
+    RK_S64 pts = 0;
+    RK_U32 eos = 0;
+    MPP_RET ret;
+
+    if (NULL == p || NULL == packet) {
+        mpp_err_f("invalid input reader %p packet %p\n", reader, packet);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (p->cfg.mode == MPP_STREAM_READER_FRAME) {
+        RK_S64 start = 0;
+
+        pthread_mutex_lock(&p->lock);
+        /* one frame ahead is needed to know the last frame for eos */
+        while (!p->scan_done && p->frame_cnt <= p->frame_idx + 1) {
+            if (!start)
+                start = mpp_time_us();
+            pthread_cond_wait(&p->cond, &p->lock);
+        }
+        if (start)
+            p->stat.wait_time += mpp_time_us() - start;
+
+        if (p->frame_idx < p->frame_cnt) {
+            ReaderFrame *frame = &p->frames[p->frame_idx++];
+
+            offset = frame->offset;
+            size = frame->size;
+            pts = frame->pts;
+        }
+        eos = (p->frame_idx >= p->frame_cnt);
+        pthread_mutex_unlock(&p->lock);
+    } else {
+        size_t left = p->size - p->pos;
+
+        size = p->cfg.chunk_size;
+        if (p->cfg.mode == MPP_STREAM_READER_RANDOM)
+            size = reader_rand(p) % p->cfg.chunk_size + 1;
+
+        if (size > left)
+            size = left;
+
+        offset = p->pos;
+        p->pos += size;
+        eos = (p->pos >= p->size);
+    }
+
+    ret = mpp_packet_init(packet, size ? p->data + offset : NULL, size);
+    if (ret)
+        return ret;
+
+    mpp_packet_set_pts(*packet, pts);
+    if (eos)
+        mpp_packet_set_eos(*packet);
+
+    return MPP_OK;
+}
+
+MppStreamReaderMode mpp_stream_reader_get_mode(MppStreamReader reader)
+{
+    MppStreamReaderImpl *p = (MppStreamReaderImpl *)reader;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL reader\n");
+        return MPP_STREAM_READER_BUTT;
+    }
+
+    return p->cfg.mode;
+}
+
+MPP_RET mpp_stream_reader_rewind(MppStreamReader reader)
+{
+    MppStreamReaderImpl *p = (MppStreamReaderImpl *)reader;
+
+    if (NULL == p) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    p->pos = 0;
+    p->frame_idx = 0;
+    p->rand = p->cfg.seed ? p->cfg.seed : 0x9e3779b9;
+    pthread_mutex_unlock(&p->lock);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_stream_reader_get_stat(MppStreamReader reader, MppStreamReaderStat *stat)
+{
+    MppStreamReaderImpl *p = (MppStreamReaderImpl *)reader;
+
+    if (NULL == p || NULL == stat) {
+        mpp_err_f("invalid input reader %p stat %p\n", reader, stat);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    while (p->scan_run && !p->scan_done)
+        pthread_cond_wait(&p->cond, &p->lock);
+
+    p->stat.frames = p->frame_cnt;
+    *stat = p->stat;
+    pthread_mutex_unlock(&p->lock);
+
+    return MPP_OK;
+}
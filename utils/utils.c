@@ -20,6 +20,7 @@
 
 #include "mpp_log.h"
 #include "utils.h"
+#include "mpp_frame_writer.h"
 
 void _show_options(int count, OptionInfo *options)
 {
@@ -32,45 +33,8 @@ void _show_options(int count, OptionInfo *options)
 
 void dump_mpp_frame_to_file(MppFrame frame, FILE *fp)
 {
-    RK_U32 width    = 0;
-    RK_U32 height   = 0;
-    RK_U32 h_stride = 0;
-    RK_U32 v_stride = 0;
-    MppFrameFormat fmt  = MPP_FMT_YUV420SP;
-    MppBuffer buffer    = NULL;
-    RK_U8 *base = NULL;
-
     if (NULL == fp || NULL == frame)
         return ;
 
-    width    = mpp_frame_get_width(frame);
-    height   = mpp_frame_get_height(frame);
-    h_stride = mpp_frame_get_hor_stride(frame);
-    v_stride = mpp_frame_get_ver_stride(frame);
-    fmt      = mpp_frame_get_fmt(frame);
-    buffer   = mpp_frame_get_buffer(frame);
-
-    if (NULL == buffer)
-        return ;
-
-    base = (RK_U8 *)mpp_buffer_get_ptr(buffer);
-
-    switch (fmt) {
-    case MPP_FMT_YUV420SP : {
-        RK_U32 i;
-        RK_U8 *base_y = base;
-        RK_U8 *base_c = base + h_stride * v_stride;
-
-        for (i = 0; i < height; i++, base_y += h_stride) {
-            fwrite(base_y, 1, width, fp);
-        }
-        for (i = 0; i < height / 2; i++, base_c += h_stride) {
-            fwrite(base_c, 1, width, fp);
-        }
-    } break;
-    default : {
-        mpp_err("not supported format %d\n", fmt);
-    } break;
-    }
+    mpp_frame_writer_dump(frame, fp);
 }
-